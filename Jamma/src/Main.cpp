@@ -13,10 +13,16 @@
 #include "../io/TextReadWriter.h"
 #include "../io/InitFile.h"
 #include "../io/ConsoleTui.h"
+#include "../audio/BankPool.h"
+#include "../audio/CallbackProfiler.h"
+#include "../audio/LoadMonitor.h"
+#include "../midi/MidiLatencyMonitor.h"
 #include "../vst/Vst3Plugin.h"
 #include <objbase.h>
 #include <atomic>
 #include <cctype>
+#include <chrono>
+#include <iomanip>
 #include <iostream>
 #include <memory>
 #include <optional>
@@ -46,6 +52,12 @@ namespace
 		          << "[NINJAM]   /  /?  /help        Show this help and server list\n"
 		          << "[NINJAM]   /c <n>  /connect <n> Connect to server by number\n"
 		          << "[NINJAM]   /d  /q  /quit        Disconnect from current server\n"
+		          << "[NINJAM]   /prof [on|off|reset] Audio callback profile (/prof csv <file> [s])\n"
+		          << "[NINJAM]   /load [reset]        Audio load, xruns and shed work\n"
+		          << "[NINJAM]   /jobs [reset]        Job queue depth and latency\n"
+		          << "[NINJAM]   /mem                 Loop buffer memory by station\n"
+		          << "[NINJAM]   /midilat [on|off|reset] MIDI ingress-to-dispatch latency\n"
+		          << "[NINJAM]   /export              Progress of the last session export\n"
 		          << "[NINJAM] Servers:\n";
 		if (snapshot.RefreshInFlight)
 			std::cout << "[NINJAM]   Refreshing live metadata from autosong.ninjam.com...\n";
@@ -60,6 +72,222 @@ namespace
 		std::cout << std::flush;
 	}
 
+	// /prof              Print per-stage callback timings since the last reset
+	// /prof on|off       Start or stop timing the callback
+	// /prof reset        Restart the timings printed by /prof
+	// /prof csv <file> [s]  Append timings to a CSV every s seconds (default 10)
+	// /prof csv off      Stop writing the CSV
+	void HandleProfileCommand(const std::string& args)
+	{
+		auto& profiler = audio::CallbackProfiler::Instance();
+
+		if (!audio::CallbackProfiler::IsCompiledIn())
+		{
+			std::cout << "[PROF] Profiling is compiled out (build with JAMMA_PROFILE_ENABLED)" << std::endl;
+			return;
+		}
+
+		std::stringstream ss(args);
+		std::string subVerb;
+		ss >> subVerb;
+
+		if (subVerb == "on" || subVerb == "off")
+		{
+			profiler.SetEnabled(subVerb == "on");
+			std::cout << "[PROF] Profiling " << subVerb << std::endl;
+			return;
+		}
+
+		if (subVerb == "reset")
+		{
+			profiler.Reset();
+			std::cout << "[PROF] Timings reset" << std::endl;
+			return;
+		}
+
+		if (subVerb == "csv")
+		{
+			std::string path;
+			ss >> path;
+
+			if (path.empty() || path == "off")
+			{
+				profiler.StopCsv();
+				std::cout << "[PROF] CSV output stopped" << std::endl;
+				return;
+			}
+
+			unsigned int intervalSecs = 10u;
+			ss >> intervalSecs;
+			if (0u == intervalSecs)
+				intervalSecs = 10u;
+
+			if (profiler.StartCsv(path, intervalSecs * 1000u))
+			{
+				profiler.SetEnabled(true);
+				std::cout << "[PROF] Writing timings to " << path << " every " << intervalSecs << "s" << std::endl;
+			}
+			else
+			{
+				std::cout << "[PROF] Could not open " << path << std::endl;
+			}
+			return;
+		}
+
+		if (!subVerb.empty())
+		{
+			std::cout << "[PROF] Usage: /prof [on|off|reset|csv <file> [secs]|csv off]" << std::endl;
+			return;
+		}
+
+		if (!profiler.IsEnabled())
+			std::cout << "[PROF] Profiling is off (/prof on to start)" << std::endl;
+
+		for (const auto& stats : profiler.Report())
+			std::cout << "[PROF] " << audio::CallbackProfiler::FormatStats(stats) << "\n";
+
+		auto counters = profiler.ReportCounters();
+		for (auto counter = 0u; counter < audio::CallbackProfiler::NUM_COUNTERS; counter++)
+		{
+			auto name = audio::CallbackProfiler::CounterName(static_cast<audio::CallbackProfiler::Counter>(counter));
+			std::cout << "[PROF] " << name << ": " << counters[counter] << "\n";
+		}
+
+		if (profiler.NumDropped() > 0u)
+			std::cout << "[PROF] " << profiler.NumDropped() << " samples dropped (too many audio threads)\n";
+
+		std::cout << std::flush;
+	}
+
+	// /load              Print callback load, xruns and any work being shed
+	// /load reset        Stop shedding and restart the counts
+	void HandleLoadCommand(const std::string& args)
+	{
+		auto& monitor = audio::LoadMonitor::Instance();
+
+		if (args == "reset")
+		{
+			monitor.Reset();
+			std::cout << "[LOAD] Counts reset" << std::endl;
+			return;
+		}
+
+		if (!args.empty())
+		{
+			std::cout << "[LOAD] Usage: /load [reset]" << std::endl;
+			return;
+		}
+
+		std::cout << "[LOAD] " << audio::LoadMonitor::FormatStatus(monitor.GetStatus()) << std::endl;
+	}
+
+	// /midilat           Print MIDI ingress-to-dispatch latency percentiles
+	// /midilat on|off    Start or stop measuring
+	// /midilat reset     Restart the measurements
+	void HandleMidiLatencyCommand(const std::string& args)
+	{
+		auto& monitor = midi::MidiLatencyMonitor::Instance();
+
+		if (args == "on" || args == "off")
+		{
+			monitor.SetEnabled(args == "on");
+			std::cout << "[MIDI] Latency measuring " << args << std::endl;
+			return;
+		}
+
+		if (args == "reset")
+		{
+			monitor.Reset();
+			std::cout << "[MIDI] Latency measurements reset" << std::endl;
+			return;
+		}
+
+		if (!args.empty())
+		{
+			std::cout << "[MIDI] Usage: /midilat [on|off|reset]" << std::endl;
+			return;
+		}
+
+		if (!monitor.IsEnabled())
+			std::cout << "[MIDI] Latency measuring is off (/midilat on to start)" << std::endl;
+
+		std::cout << "[MIDI] Dispatch latency " << midi::MidiLatencyMonitor::FormatStats(monitor.Report()) << std::endl;
+	}
+
+	// /jobs              Print job queue depth, coalescing and latency
+	// /jobs reset        Restart the counts
+	void HandleJobsCommand(const std::string& args, Scene* scene)
+	{
+		if (!scene)
+		{
+			std::cout << "[JOBS] Not ready yet" << std::endl;
+			return;
+		}
+
+		if (args == "reset")
+		{
+			scene->ResetJobStats();
+			std::cout << "[JOBS] Counts reset" << std::endl;
+			return;
+		}
+
+		if (!args.empty())
+		{
+			std::cout << "[JOBS] Usage: /jobs [reset]" << std::endl;
+			return;
+		}
+
+		std::cout << "[JOBS] " << JobQueue::FormatStats(scene->GetJobStats()) << std::endl;
+	}
+
+	// /mem               Print slab pool usage and loop buffers by station
+	void HandleMemCommand(const std::string& args, Scene* scene)
+	{
+		if (!args.empty())
+		{
+			std::cout << "[MEM] Usage: /mem" << std::endl;
+			return;
+		}
+
+		std::cout << "[MEM] Pool " << audio::BankPool::FormatUsage(audio::BankPool::Instance().GetUsage()) << "\n";
+
+		if (scene)
+		{
+			for (const auto& [name, bytes] : scene->GetStationBufferBytes())
+			{
+				std::stringstream ss;
+				ss << std::fixed << std::setprecision(1) << (static_cast<double>(bytes) / (1024.0 * 1024.0));
+				std::cout << "[MEM]   " << name << ": " << ss.str() << " MB\n";
+			}
+		}
+
+		std::cout << std::flush;
+	}
+
+	void HandleExportCommand(const std::string& args, Scene* scene)
+	{
+		if (!scene)
+		{
+			std::cout << "[EXPORT] Not ready yet" << std::endl;
+			return;
+		}
+
+		if (!args.empty())
+		{
+			std::cout << "[EXPORT] Usage: /export" << std::endl;
+			return;
+		}
+
+		auto progress = scene->GetExportProgress();
+		if (!progress.IsRunning && (0u == progress.NumLoops))
+		{
+			std::cout << "[EXPORT] No export yet (Ctrl+S to export)" << std::endl;
+			return;
+		}
+
+		std::cout << "[EXPORT] " << io::SessionWriter::FormatProgress(progress) << std::endl;
+	}
+
 	// Returns true when the message was a slash command (consumed; should NOT
 	// be forwarded as chat). Returns false for ordinary chat text.
 	bool HandleSlashCommand(const std::string& msg, Scene* scene)
@@ -126,6 +354,42 @@ namespace
 			return true;
 		}
 
+		if (verb == "prof")
+		{
+			HandleProfileCommand(args);
+			return true;
+		}
+
+		if (verb == "load")
+		{
+			HandleLoadCommand(args);
+			return true;
+		}
+
+		if (verb == "midilat")
+		{
+			HandleMidiLatencyCommand(args);
+			return true;
+		}
+
+		if (verb == "jobs")
+		{
+			HandleJobsCommand(args, scene);
+			return true;
+		}
+
+		if (verb == "mem")
+		{
+			HandleMemCommand(args, scene);
+			return true;
+		}
+
+		if (verb == "export")
+		{
+			HandleExportCommand(args, scene);
+			return true;
+		}
+
 		if (verb == "d" || verb == "q" || verb == "quit"
 			|| verb == "exit" || verb == "disconnect")
 		{
@@ -321,6 +585,7 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmd
 		return -1;
 	}
 
+	const auto startTime = std::chrono::steady_clock::now();
 	const auto initPath = ResolveIniPath();
 	auto defaults = LoadIni(initPath);
 
@@ -359,6 +624,7 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmd
 	const auto jamDirectory = defaults.has_value() ?
 		utils::GetParentDirectory(defaults->Jam) :
 		utils::GetParentDirectory(initPath);
+	const auto configTime = std::chrono::steady_clock::now();
 	auto scene = Scene::FromFile(sceneParams, jam, rig, jamDirectory);
 	if (!scene.has_value())
 	{
@@ -372,6 +638,7 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmd
 	if (defaults.has_value())
 		scene.value()->SetLogging(defaults.value().Logging);
 
+	const auto sceneTime = std::chrono::steady_clock::now();
 	ResourceLib resourceLib;
 	Window window(*(scene.value()), resourceLib);
 
@@ -380,8 +647,22 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmd
 
 	scene.value()->InitGlobalInsertCapture();
 
+	const auto windowTime = std::chrono::steady_clock::now();
 	scene.value()->InitAudio();
 
+	{
+		auto msSince = [](std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+			return std::chrono::duration_cast<std::chrono::milliseconds>(to - from).count();
+		};
+		const auto audioTime = std::chrono::steady_clock::now();
+
+		std::cout << "[Startup] Config " << msSince(startTime, configTime) << "ms"
+			<< ", scene " << msSince(configTime, sceneTime) << "ms"
+			<< ", window " << msSince(sceneTime, windowTime) << "ms"
+			<< ", audio device " << msSince(windowTime, audioTime) << "ms"
+			<< ", total " << msSince(startTime, audioTime) << "ms" << std::endl;
+	}
+
 	MSG msg;
 	bool active = true;
 	while (active)
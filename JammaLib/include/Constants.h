@@ -28,6 +28,23 @@ namespace constants
 	const unsigned int DefaultSeedGrainMinMs = 300u;
 	const unsigned int DefaultSeedGrainTargetMaxMs = 3000u;
 	const unsigned int DefaultSeedBpmMin = 80u;
+	const unsigned int DefaultBankSlabSamps = 131072u;
+	const unsigned int DefaultBankBudgetMb = 4096u;
+	const unsigned long DefaultStreamThresholdSamps = MaxLoopBufferSize;
+	const unsigned int DefaultStreamWindowBanks = 8u;
+	const unsigned long DefaultCompactIdleSamps = 0ul;
 	const unsigned int DefaultSampleRate = 44100u;
 	const unsigned int DefaultBufferSizeSamps = 512u;
+	const unsigned int DefaultShedLoadPercent = 85u;
+	const unsigned int DefaultRecoverLoadPercent = 60u;
+	const unsigned int DefaultShedBlocks = 32u;
+	const unsigned int JobTickMs = 20u;
+	const unsigned int NumJobWorkers = 2u;
+	const unsigned int NumLoadWorkers = 4u;
+	const unsigned int MidiIdleTickMs = 20u;
+	const unsigned int NumExportWorkers = 2u;
+	const unsigned int ExportBudgetMb = 256u;
+	const unsigned int ExportSnapshotAttempts = 4u;
+	const unsigned int JournalRingSize = 1024u;
+	const unsigned int JournalFlushMs = 250u;
 }
@@ -1,35 +1,32 @@
 #include "DelayedAction.h"
+#include <limits>
 
 using namespace actions;
 
-DelayedAction::DelayedAction(unsigned int sampsDelay,
+DelayedAction::DelayedAction(std::uint64_t dueSample,
 	double target) :
-	_sampsDelay(sampsDelay),
-	_sampsDelayLeft(sampsDelay),
+	_dueSample(dueSample),
 	_target(target)
 {
 }
 
-unsigned int DelayedAction::SampsLeft(unsigned int samps)
+std::uint64_t DelayedAction::DueSample() const
 {
-	if (samps >= _sampsDelayLeft)
+	return _dueSample;
+}
+
+unsigned int DelayedAction::SampsLeft(std::uint64_t sampleTime) const
+{
+	if (sampleTime >= _dueSample)
 		return 0u;
 
-	return _sampsDelayLeft - samps;
+	auto sampsLeft = _dueSample - sampleTime;
+	constexpr auto maxSamps = static_cast<std::uint64_t>(std::numeric_limits<unsigned int>::max());
+
+	return static_cast<unsigned int>(sampsLeft < maxSamps ? sampsLeft : maxSamps);
 }
 
 double DelayedAction::GetTarget() const
 {
 	return _target;
 }
-
-void DelayedAction::OnTick(Time curTime,
-	unsigned int samps,
-	std::optional<io::UserConfig> cfg,
-	std::optional<audio::AudioStreamParams> params)
-{
-	if (samps >= _sampsDelayLeft)
-		_sampsDelayLeft = 0u;
-	else
-		_sampsDelayLeft -= samps;
-}
\ No newline at end of file
@@ -1,26 +1,24 @@
 #pragma once
 
-#include "Tickable.h"
+#include <cstdint>
 
 namespace actions
 {
-	class DelayedAction : base::Tickable
+	// A mixer level change that falls due at an absolute engine sample
+	class DelayedAction
 	{
 	public:
-		class DelayedAction(unsigned int sampsDelay, double target);
+		DelayedAction(std::uint64_t dueSample, double target);
 
 	public:
-		virtual void OnTick(Time curTime,
-			unsigned int samps,
-			std::optional<io::UserConfig> cfg,
-			std::optional<audio::AudioStreamParams> params) override;
-
-		unsigned int SampsLeft(unsigned int samp);
+		std::uint64_t DueSample() const;
+		// Samples from sampleTime until the action falls due, or zero if
+		// already due
+		unsigned int SampsLeft(std::uint64_t sampleTime) const;
 		double GetTarget() const;
 
 	protected:
-		unsigned int _sampsDelay;
-		unsigned int _sampsDelayLeft;
+		std::uint64_t _dueSample;
 		double _target;
 	};
 }
@@ -41,7 +41,8 @@ namespace actions
 			JOB_ENDRECORDING,
 			JOB_UPDATEMIDIQUANTISATION,
 			JOB_LOADVST,
-			JOB_UNLOADVST
+			JOB_UNLOADVST,
+			JOB_COMPACTLOOP
 		};
 
 		JobType JobActionType;
@@ -7,6 +7,7 @@ TriggerAction::TriggerAction() :
 	TargetId(""),
 	SourceId(""),
 	SampleCount(0),
+	BlockOffset(0u),
 	InputChannels({}),
 	MidiInputChannels({}),
 	MidiInputDevices({}),
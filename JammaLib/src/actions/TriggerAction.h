@@ -32,6 +32,8 @@ namespace actions
 		std::string TargetId;
 		std::string SourceId;
 		unsigned long SampleCount;
+		// Samples into the next audio block at which the change lands
+		unsigned int BlockOffset;
 		std::vector<unsigned int> InputChannels;
 		std::vector<unsigned int> MidiInputChannels;
 		std::vector<std::string> MidiInputDevices;
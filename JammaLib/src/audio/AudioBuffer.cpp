@@ -1,20 +1,21 @@
 #include "AudioBuffer.h"
+#include "FadeKernels.h"
+#include <bit>
 
 using namespace audio;
 
 AudioBuffer::AudioBuffer() :
-	AudioSource({}),
-	_playIndex(0),
-	_sampsRecorded(0),
-	_buffer(std::vector<float>(constants::MaxBlockSize, 0.0f))
+	AudioBuffer(constants::MaxBlockSize)
 {
 }
 
 AudioBuffer::AudioBuffer(unsigned int size) :
 	AudioSource({}),
+	_size(size),
+	_mask(std::max(1u, _CapacityFor(size)) - 1u),
 	_playIndex(0),
 	_sampsRecorded(0),
-	_buffer(std::vector<float>(size, 0.0f))
+	_buffer(std::vector<float>(_CapacityFor(size), 0.0f))
 {
 }
 
@@ -24,32 +25,20 @@ AudioBuffer::~AudioBuffer()
 
 void AudioBuffer::EndPlay(unsigned int numSamps)
 {
-	auto bufSize = (unsigned int)_buffer.size();
-	_playIndex += numSamps;
-
 	if (0 == _sampsRecorded)
 	{
 		_playIndex = 0;
 		return;
 	}
 
-	/*if (_sampsRecorded < bufSize)
-	{
-		if (_playIndex > _writeIndex)
-			_playIndex = _writeIndex;
-
-		return;
-	}*/
-
-	while (bufSize <= _playIndex)
-		_playIndex -= bufSize;
+	_playIndex = (_playIndex + numSamps) & _mask;
 }
 
 void AudioBuffer::EndWrite(unsigned int numSamps, bool updateIndex)
 {
 	_sampsRecorded += numSamps;
-	if (_sampsRecorded > _buffer.size())
-		_sampsRecorded = (unsigned int)_buffer.size();
+	if (_sampsRecorded > _size)
+		_sampsRecorded = _size;
 
 	if (updateIndex)
 		_SetWriteIndex((unsigned int)(_writeIndex.load(std::memory_order_relaxed) + numSamps));
@@ -57,62 +46,76 @@ void AudioBuffer::EndWrite(unsigned int numSamps, bool updateIndex)
 
 void AudioBuffer::OnBlockWrite(const base::AudioWriteRequest& request, int writeOffset)
 {
-	auto bufSize = (unsigned int)_buffer.size();
-
-	if (0 == bufSize)
+	if (_buffer.empty())
 	{
 		_writeIndex.store(0, std::memory_order_relaxed);
 		return;
 	}
 
-	auto writeIndex = _writeIndex.load(std::memory_order_relaxed);
-	long startIdx = (long)writeIndex + writeOffset;
-	startIdx = ((startIdx % (long)bufSize) + (long)bufSize) % (long)bufSize;
-
-	auto idx = (unsigned int)startIdx;
+	const auto capacity = Capacity();
+	auto idx = (unsigned int)(_writeIndex.load(std::memory_order_relaxed) + (unsigned int)writeOffset) & _mask;
+	auto samples = request.samples;
+	auto ramp = request.fadeRamp;
+	auto remaining = request.numSamps;
 
 	// Fast path: pure copy with contiguous stride-1 data
-	if (request.fadeCurrent == 0.0f && request.fadeNew == 1.0f && request.stride == 1)
-	{
-		auto firstSeg = std::min(request.numSamps, bufSize - idx);
-		std::copy(request.samples, request.samples + firstSeg, _buffer.begin() + idx);
+	auto isCopy = request.fadeCurrent == 0.0f && request.fadeNew == 1.0f && request.stride == 1 && nullptr == ramp;
 
-		if (firstSeg < request.numSamps)
-			std::copy(request.samples + firstSeg, request.samples + request.numSamps, _buffer.begin());
-	}
-	else
+	while (remaining > 0)
 	{
-		for (unsigned int i = 0; i < request.numSamps; i++)
-		{
-			_buffer[idx] = (request.fadeNew * request.samples[i * request.stride]) +
-				(request.fadeCurrent * _buffer[idx]);
+		auto seg = std::min(remaining, capacity - idx);
 
-			idx++;
-			if (idx >= bufSize)
-				idx -= bufSize;
+		if (isCopy)
+			std::copy(samples, samples + seg, _buffer.begin() + idx);
+		else if (nullptr == ramp)
+		{
+			FadeKernels::FadeMix(_buffer.data() + idx,
+				samples,
+				request.stride,
+				seg,
+				request.fadeCurrent,
+				request.fadeNew);
 		}
+		else
+		{
+			FadeKernels::FadeMixRamp(_buffer.data() + idx,
+				samples,
+				request.stride,
+				seg,
+				request.fadeCurrent,
+				request.fadeNew,
+				ramp,
+				request.fadeCurrentRamp);
+			ramp += seg;
+		}
+
+		samples += static_cast<size_t>(seg) * request.stride;
+		remaining -= seg;
+		idx = 0;
 	}
 }
 
 void AudioBuffer::SetSize(unsigned int size)
 {
-	_buffer.resize(size);
+	_size = size;
+	_buffer.resize(_CapacityFor(size));
+	_mask = std::max(1u, Capacity()) - 1u;
+
+	if (_sampsRecorded > _size)
+		_sampsRecorded = _size;
+
+	_playIndex &= _mask;
+	_writeIndex.store(_writeIndex.load(std::memory_order_relaxed) & _mask, std::memory_order_relaxed);
 }
 
 void AudioBuffer::_SetWriteIndex(unsigned int index)
 {
-	auto bufSize = (unsigned int)_buffer.size();
-
-	if (0 == bufSize)
-	{
-		_writeIndex.store(0, std::memory_order_relaxed);
-		return;
-	}
-
-	while (index >= bufSize)
-		index-= bufSize;
+	_writeIndex.store(index & _mask, std::memory_order_relaxed);
+}
 
-	_writeIndex.store(index, std::memory_order_relaxed);
+unsigned int AudioBuffer::_CapacityFor(unsigned int size)
+{
+	return (0u == size) ? 0u : std::bit_ceil(size);
 }
 
 unsigned int AudioBuffer::SampsRecorded() const
@@ -121,13 +124,23 @@ unsigned int AudioBuffer::SampsRecorded() const
 }
 
 unsigned int AudioBuffer::BufSize() const
+{
+	return _size;
+}
+
+unsigned int AudioBuffer::Capacity() const
 {
 	return (unsigned int)_buffer.size();
 }
 
+unsigned int AudioBuffer::Mask() const
+{
+	return _mask;
+}
+
 const float& AudioBuffer::operator[](unsigned int index) const
 {
-	return _buffer[index % _buffer.size()];
+	return _buffer[index & _mask];
 }
 
 std::vector<float>::iterator AudioBuffer::Start()
@@ -146,10 +159,8 @@ unsigned int AudioBuffer::Delay(unsigned int sampsDelay)
 		_playIndex = 0;
 	else
 	{
-		auto bufSize = (unsigned int)_buffer.size();
-		auto sampsBehind = sampsDelay > bufSize ? bufSize : sampsDelay;
-		auto writeIndex = _writeIndex.load(std::memory_order_relaxed);
-		_playIndex = sampsBehind > writeIndex ? (writeIndex + bufSize) - sampsBehind : writeIndex - sampsBehind;
+		auto sampsBehind = sampsDelay > _size ? _size : sampsDelay;
+		_playIndex = (_writeIndex.load(std::memory_order_relaxed) - sampsBehind) & _mask;
 	}
 	
 	return _playIndex;
@@ -160,14 +171,24 @@ unsigned int AudioBuffer::PlayIndex() const
 	return static_cast<unsigned int>(_playIndex);
 }
 
+unsigned int AudioBuffer::WriteIndex() const
+{
+	return static_cast<unsigned int>(_writeIndex.load(std::memory_order_relaxed));
+}
+
 bool AudioBuffer::IsContiguous(unsigned int startIndex, unsigned int numSamps) const
 {
-	return (startIndex + numSamps) <= (unsigned int)_buffer.size();
+	return (startIndex + numSamps) <= Capacity();
 }
 
 const float* AudioBuffer::BlockRead(unsigned int startIndex) const
 {
-	return &_buffer[startIndex];
+	return _buffer.data() + startIndex;
+}
+
+float* AudioBuffer::BlockWrite(unsigned int startIndex)
+{
+	return _buffer.data() + startIndex;
 }
 
 const float* AudioBuffer::PlaybackRead(float* tempBuf, unsigned int numSamps)
@@ -177,9 +198,21 @@ const float* AudioBuffer::PlaybackRead(float* tempBuf, unsigned int numSamps)
 	if (IsContiguous(playIndex, numSamps))
 		return BlockRead(playIndex);
 
+	if (_buffer.empty())
+	{
+		std::fill(tempBuf, tempBuf + numSamps, 0.0f);
+		return tempBuf;
+	}
+
 	// Buffer wraps — copy into contiguous temp buffer
-	for (auto samp = 0u; samp < numSamps; samp++)
-		tempBuf[samp] = (*this)[samp + playIndex];
+	auto done = 0u;
+	while (done < numSamps)
+	{
+		auto seg = std::min(numSamps - done, Capacity() - playIndex);
+		std::copy(BlockRead(playIndex), BlockRead(playIndex) + seg, tempBuf + done);
+		done += seg;
+		playIndex = 0;
+	}
 
 	return tempBuf;
 }
@@ -9,6 +9,9 @@
 
 namespace audio
 {
+	// Planar ring buffer. The ring is allocated at the next power of two
+	// above the requested size so every index wraps with a mask. BufSize()
+	// reports the requested size, Capacity() the allocated ring.
 	class AudioBuffer :
 		public virtual base::AudioSink,
 		public virtual base::AudioSource
@@ -27,12 +30,16 @@ namespace audio
 		void SetSize(unsigned int size);
 		unsigned int SampsRecorded() const;
 		unsigned int BufSize() const;
+		unsigned int Capacity() const;
+		unsigned int Mask() const;
 
 		const float& operator[](unsigned int index) const;
 		unsigned int Delay(unsigned int sampsDelay);
 		unsigned int PlayIndex() const;
+		unsigned int WriteIndex() const;
 		bool IsContiguous(unsigned int startIndex, unsigned int numSamps) const;
 		const float* BlockRead(unsigned int startIndex) const;
+		float* BlockWrite(unsigned int startIndex);
 
 		// Reads numSamps from the current playback position.
 		// Call Delay(...) first to set the playback position when needed.
@@ -48,7 +55,11 @@ namespace audio
 	protected:
 		void _SetWriteIndex(unsigned int index);
 
+		static unsigned int _CapacityFor(unsigned int size);
+
 	protected:
+		unsigned int _size;
+		unsigned int _mask;
 		unsigned int _sampsRecorded;
 		unsigned long _playIndex;
 		std::vector<float> _buffer;
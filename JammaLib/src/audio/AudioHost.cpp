@@ -1,5 +1,7 @@
 #include "stdafx.h"
 #include "AudioHost.h"
+#include "CallbackProfiler.h"
+#include "LoadMonitor.h"
 #include "../utils/Timer.h"
 #include <iostream>
 
@@ -26,6 +28,15 @@ namespace audio
 		_ninjamController = ninjamController;
 		_tickCallback = tickCallback;
 
+		auto shedPolicy = LoadMonitor::ParsePolicy(_userConfig.Audio.ShedPolicy);
+		if (!shedPolicy.has_value())
+			std::cout << "[AUDIO] Unknown shed policy \"" << _userConfig.Audio.ShedPolicy << "\", using the default" << std::endl;
+
+		LoadMonitor::Instance().Configure(_userConfig.Audio.ShedLoadPercent,
+			_userConfig.Audio.RecoverLoadPercent,
+			_userConfig.Audio.ShedBlocks,
+			shedPolicy.value_or(LoadMonitor::DefaultPolicy()));
+
 		auto dev = audio::AudioDevice::Open(AudioHost::AudioCallback,
 			[](RtAudioError::Type type, const std::string& err) { std::cout << "[" << type << " RtAudio Error] " << err << std::endl; },
 			_userConfig.Audio,
@@ -34,49 +45,67 @@ namespace audio
 		if (dev.has_value())
 		{
 			_audioDevice = std::move(dev.value());
-			_audioSampleCounter.store(0u, std::memory_order_release);
+			_ConfigureStream(_audioDevice->GetAudioStreamParams());
 
-			auto audioStreamParams = _audioDevice->GetAudioStreamParams();
+			_audioDevice->Start();
+			_audioDevice->GetAudioStreamParams().PrintParams();
+			return true;
+		}
+		return false;
+	}
 
-			auto inLatency = (0u == audioStreamParams.InputLatency) ?
-				_userConfig.Audio.LatencyIn :
-				audioStreamParams.InputLatency;
+	void AudioHost::InitOffline(const AudioStreamParams& streamParams,
+		TickCallback tickCallback)
+	{
+		std::scoped_lock lock(_audioMutex);
+
+		_tickCallback = tickCallback;
+		_offlineStreamParams = streamParams;
+		_ConfigureStream(streamParams);
+	}
+
+	void AudioHost::_ConfigureStream(const AudioStreamParams& audioStreamParams)
+	{
+		_audioSampleCounter.store(0u, std::memory_order_release);
+		_deviceSampleRate = audioStreamParams.SampleRate;
+		LoadMonitor::Instance().Reset();
 
-			_channelMixer->SetParams(audio::ChannelMixerParams({
-					_userConfig.AdcBufferDelay(inLatency) + audioStreamParams.BufSize,
-					audio::ChannelMixer::DefaultBufferSize,
-					audioStreamParams.NumInputChannels,
-					audioStreamParams.NumOutputChannels }));
+		auto inLatency = (0u == audioStreamParams.InputLatency) ?
+			_userConfig.Audio.LatencyIn :
+			audioStreamParams.InputLatency;
 
-			auto stationsSnapshot = _audioStations.load(std::memory_order_acquire);
-			if (stationsSnapshot)
+		_channelMixer->SetParams(audio::ChannelMixerParams({
+				_userConfig.AdcBufferDelay(inLatency) + audioStreamParams.BufSize,
+				audio::ChannelMixer::DefaultBufferSize,
+				audioStreamParams.NumInputChannels,
+				audioStreamParams.NumOutputChannels }));
+
+		// Also rebuilds the render buses, at the mixer's new channel count
+		SetRenderWorkers(_userConfig.Audio.RenderWorkers);
+
+		auto stationsSnapshot = _audioStations.LoadShared();
+		if (stationsSnapshot)
+		{
+			for (auto& station : *stationsSnapshot)
 			{
-				for (auto& station : *stationsSnapshot)
+				if (station)
 				{
-					if (station)
-					{
-						station->SetupBuffers(audioStreamParams.BufSize);
-						station->SetSampleRate(static_cast<float>(audioStreamParams.SampleRate));
-						station->SetNumAdcChannels(audioStreamParams.NumInputChannels);
-						station->SetNumDacChannels(audioStreamParams.NumOutputChannels);
-					}
+					station->SetupBuffers(audioStreamParams.BufSize);
+					station->SetSampleRate(static_cast<float>(audioStreamParams.SampleRate));
+					station->SetNumAdcChannels(audioStreamParams.NumInputChannels);
+					station->SetNumDacChannels(audioStreamParams.NumOutputChannels);
 				}
 			}
+		}
 
-			if (_ninjamController)
-			{
-				_ninjamController->SetAudioFormat(
-					audioStreamParams.SampleRate,
-					audioStreamParams.BufSize,
-					audioStreamParams.NumInputChannels,
-					audioStreamParams.NumOutputChannels);
-			}
-
-			_audioDevice->Start();
-			_audioDevice->GetAudioStreamParams().PrintParams();
-			return true;
+		if (_ninjamController)
+		{
+			_ninjamController->SetAudioFormat(
+				audioStreamParams.SampleRate,
+				audioStreamParams.BufSize,
+				audioStreamParams.NumInputChannels,
+				audioStreamParams.NumOutputChannels);
 		}
-		return false;
 	}
 
 	void AudioHost::Close()
@@ -91,11 +120,24 @@ namespace audio
 
 		if (_audioDevice)
 			_audioDevice->Stop();
+
+		_workerPool.Stop();
 	}
 
 	void AudioHost::SetStations(std::shared_ptr<const std::vector<std::shared_ptr<Station>>> stations)
 	{
-		_audioStations.store(stations, std::memory_order_release);
+		_audioStations.Publish(stations);
+		_RebuildRenderBuses();
+	}
+
+	void AudioHost::SetRenderWorkers(unsigned int numWorkers)
+	{
+		if (numWorkers > 0u)
+			_workerPool.Start(numWorkers);
+		else
+			_workerPool.Stop();
+
+		_RebuildRenderBuses();
 	}
 
 	int AudioHost::AudioCallback(void* outBuffer,
@@ -106,7 +148,19 @@ namespace audio
 		void* userData)
 	{
 		AudioHost* engine = (AudioHost*)userData;
+		auto start = std::chrono::steady_clock::now();
+
 		engine->_OnAudio((float*)inBuffer, (float*)outBuffer, numSamps, streamTime);
+
+		// Only device blocks have a deadline, so offline renders are never measured
+		auto elapsed = std::chrono::steady_clock::now() - start;
+		LoadMonitor::Instance().RecordBlock(
+			static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()),
+			numSamps,
+			engine->_deviceSampleRate,
+			0u != (status & RTAUDIO_INPUT_OVERFLOW),
+			0u != (status & RTAUDIO_OUTPUT_UNDERFLOW));
+
 		return 0;
 	}
 
@@ -116,11 +170,69 @@ namespace audio
 		double streamTime)
 	{
 		const auto audioStreamParams = nullptr == _audioDevice ?
-			audio::AudioStreamParams() : _audioDevice->GetAudioStreamParams();
+			_offlineStreamParams : _audioDevice->GetAudioStreamParams();
+
+		ProcessBlock(inBuf, outBuf, numSamps, audioStreamParams);
+	}
+
+	void AudioHost::RenderOffline(float* inBuf,
+		float* outBuf,
+		unsigned int numSamps,
+		double streamTime)
+	{
+		_OnAudio(inBuf, outBuf, numSamps, streamTime);
+	}
+
+	void AudioHost::ProcessBlock(float* inBuf,
+		float* outBuf,
+		unsigned int numSamps,
+		const AudioStreamParams& audioStreamParams)
+	{
+		// Covers every snapshot loaded during the block, including those loaded
+		// by pool workers, which only run inside this callback's Run()
+		EpochReadGuard epochGuard;
+		JAMMA_PROFILE_SCOPE(STAGE_CALLBACK);
+		JAMMA_PROFILE_BLOCK(numSamps, audioStreamParams.SampleRate);
+
 		const auto blockStartSample = _audioSampleCounter.load(std::memory_order_relaxed);
-		const auto stationsSnapshot = _audioStations.load(std::memory_order_acquire);
-		static const std::vector<std::shared_ptr<Station>> emptyStations;
+		const auto stationsSnapshot = _audioStations.Load();
+		static const StationList emptyStations;
 		const auto& stations = stationsSnapshot ? *stationsSnapshot : emptyStations;
+		const auto busesSnapshot = _renderBuses.Load();
+
+		// Buses are published after the stations they belong to, so fall back
+		// to serial rendering for any block that sees a stale bus list
+		auto isParallel = (_workerPool.NumWorkers() > 0u) &&
+			(stations.size() > 1u) &&
+			(numSamps <= constants::MaxBlockSize) &&
+			busesSnapshot &&
+			(busesSnapshot->size() >= stations.size());
+
+		if (isParallel)
+			_ProcessParallel(inBuf, outBuf, numSamps, audioStreamParams, stations, *busesSnapshot);
+		else
+			_ProcessSerial(inBuf, outBuf, numSamps, audioStreamParams, stations);
+
+		_channelMixer->Sink()->EndMultiWrite(numSamps, true, Audible::AUDIOSOURCE_LOOPS);
+
+		if (_tickCallback)
+		{
+			JAMMA_PROFILE_SCOPE(STAGE_TICK);
+			_tickCallback(blockStartSample, numSamps, _userConfig, audioStreamParams);
+		}
+
+		_audioSampleCounter.store(blockStartSample + numSamps, std::memory_order_release);
+		_midiAnchorMicros.store(std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count(), std::memory_order_release);
+	}
+
+	void AudioHost::_ProcessSerial(float* inBuf,
+		float* outBuf,
+		unsigned int numSamps,
+		const AudioStreamParams& audioStreamParams,
+		const StationList& stations)
+	{
+		const auto blockStartSample = _audioSampleCounter.load(std::memory_order_relaxed);
 
 		if (nullptr != inBuf)
 		{
@@ -168,24 +280,6 @@ namespace audio
 		if (_ninjamController)
 			_ninjamController->ProcessAudioBlock(inBuf, numSamps, audioStreamParams.SampleRate);
 
-		auto ingestRemoteStation = [&](const std::shared_ptr<Station>& stationBase) {
-			if (!stationBase || !stationBase->IsRemote())
-				return;
-
-			auto station = std::static_pointer_cast<StationRemote>(stationBase);
-			if (!station || !station->IsConnectedRemote())
-				return;
-
-			const float* left = nullptr;
-			const float* right = nullptr;
-			unsigned int frameCount = 0u;
-			if (_ninjamController && _ninjamController->ConsumeStereoPair(station->AssignedOutputChannel(), left, right, frameCount))
-			{
-				auto ingestFrames = frameCount < numSamps ? frameCount : numSamps;
-				station->IngestStereoBlock(left, right, ingestFrames);
-			}
-		};
-
 		if (nullptr != outBuf)
 		{
 			std::fill(outBuf, outBuf + numSamps * audioStreamParams.NumOutputChannels, 0.0f);
@@ -193,7 +287,7 @@ namespace audio
 			for (auto& station : stations)
 			{
 				station->Zero(numSamps, Audible::AUDIOSOURCE_LOOPS);
-				ingestRemoteStation(station);
+				_IngestRemoteStation(station, numSamps);
 				station->WriteBlock(_channelMixer->Sink(), nullptr, 0, numSamps,
 					static_cast<std::uint32_t>(blockStartSample));
 				station->EndMultiPlay(numSamps);
@@ -205,22 +299,153 @@ namespace audio
 		{
 			for (auto& station : stations)
 			{
-				ingestRemoteStation(station);
+				_IngestRemoteStation(station, numSamps);
 				station->WriteBlock(_channelMixer->Sink(), nullptr, 0, numSamps,
 					static_cast<std::uint32_t>(blockStartSample));
 				station->EndMultiPlay(numSamps);
 			}
 		}
+	}
 
-		_channelMixer->Sink()->EndMultiWrite(numSamps, true, Audible::AUDIOSOURCE_LOOPS);
+	void AudioHost::_ProcessParallel(float* inBuf,
+		float* outBuf,
+		unsigned int numSamps,
+		const AudioStreamParams& audioStreamParams,
+		const StationList& stations,
+		const BusList& buses)
+	{
+		// Stations only share the ADC buffers (read-only while a phase runs)
+		// and the DAC mixer, so each phase fans out per station and the
+		// shared state is only touched serially between phases. Station
+		// output goes to a private bus and is summed into the DAC mixer in
+		// station order, keeping the mix deterministic across runs.
+		RenderContext context;
+		context.Host = this;
+		context.Stations = &stations;
+		context.Buses = &buses;
+		context.StreamParams = &audioStreamParams;
+		context.NumSamps = numSamps;
+		context.BlockStartSample = static_cast<std::uint32_t>(_audioSampleCounter.load(std::memory_order_relaxed));
+
+		auto numStations = static_cast<unsigned int>(stations.size());
 
-		if (_tickCallback)
+		if (nullptr != inBuf)
 		{
-			_tickCallback(Timer::GetTime(), numSamps, _userConfig, audioStreamParams);
+			auto inLatency = (0u == audioStreamParams.InputLatency) ?
+				_userConfig.Audio.LatencyIn :
+				audioStreamParams.InputLatency;
+
+			_channelMixer->FromAdc(inBuf, audioStreamParams.NumInputChannels, numSamps);
+
+			_channelMixer->InitPlay(0u, numSamps);
+			_channelMixer->Source()->SetSourceType(Audible::AUDIOSOURCE_MONITOR);
+			_workerPool.Run(&AudioHost::_MonitorTask, &context, numStations);
+
+			_channelMixer->InitPlay(_userConfig.AdcBufferDelay(inLatency), numSamps);
+			_channelMixer->Source()->SetSourceType(Audible::AUDIOSOURCE_ADC);
+			_workerPool.Run(&AudioHost::_AdcTask, &context, numStations);
 		}
 
-		_audioSampleCounter.store(blockStartSample + numSamps, std::memory_order_release);
-		_midiAnchorMicros.store(std::chrono::duration_cast<std::chrono::microseconds>(
-			std::chrono::steady_clock::now().time_since_epoch()).count(), std::memory_order_release);
+		_channelMixer->Source()->EndMultiPlay(numSamps);
+
+		_channelMixer->Sink()->Zero(numSamps, Audible::AUDIOSOURCE_LOOPS);
+
+		if (_ninjamController)
+			_ninjamController->ProcessAudioBlock(inBuf, numSamps, audioStreamParams.SampleRate);
+
+		// Remote stations pull from the shared ninjam controller, so ingest
+		// them here before fanning out
+		for (auto& station : stations)
+			_IngestRemoteStation(station, numSamps);
+
+		_workerPool.Run(&AudioHost::_RenderTask, &context, numStations);
+
+		for (auto i = 0u; i < numStations; i++)
+			_channelMixer->MixBus(*buses[i], numSamps);
+
+		if (nullptr != outBuf)
+		{
+			std::fill(outBuf, outBuf + numSamps * audioStreamParams.NumOutputChannels, 0.0f);
+			_channelMixer->ToDac(outBuf, audioStreamParams.NumOutputChannels, numSamps);
+		}
+	}
+
+	void AudioHost::_IngestRemoteStation(const std::shared_ptr<Station>& stationBase, unsigned int numSamps)
+	{
+		if (!stationBase || !stationBase->IsRemote())
+			return;
+
+		auto station = std::static_pointer_cast<StationRemote>(stationBase);
+		if (!station || !station->IsConnectedRemote())
+			return;
+
+		const float* left = nullptr;
+		const float* right = nullptr;
+		unsigned int frameCount = 0u;
+		if (_ninjamController && _ninjamController->ConsumeStereoPair(station->AssignedOutputChannel(), left, right, frameCount))
+		{
+			auto ingestFrames = frameCount < numSamps ? frameCount : numSamps;
+			station->IngestStereoBlock(left, right, ingestFrames);
+		}
+	}
+
+	void AudioHost::_MonitorTask(void* context, unsigned int index) noexcept
+	{
+		auto ctx = static_cast<RenderContext*>(context);
+		auto& station = (*ctx->Stations)[index];
+
+		if (station->IsRemote())
+			return;
+
+		ctx->Host->_channelMixer->WriteToSink(station, ctx->NumSamps);
+	}
+
+	void AudioHost::_AdcTask(void* context, unsigned int index) noexcept
+	{
+		auto ctx = static_cast<RenderContext*>(context);
+		auto host = ctx->Host;
+		auto& station = (*ctx->Stations)[index];
+
+		if (station->IsRemote())
+			return;
+
+		host->_channelMixer->WriteToSink(station, ctx->NumSamps);
+
+		station->SetSourceType(Audible::AUDIOSOURCE_MONITOR);
+		station->OnBounce(ctx->NumSamps, host->_userConfig, *ctx->StreamParams);
+
+		station->SetSourceType(Audible::AUDIOSOURCE_BOUNCE);
+		station->OnBounce(ctx->NumSamps, host->_userConfig, *ctx->StreamParams);
+
+		station->EndMultiWrite(ctx->NumSamps, true, Audible::AUDIOSOURCE_BOUNCE);
+	}
+
+	void AudioHost::_RenderTask(void* context, unsigned int index) noexcept
+	{
+		auto ctx = static_cast<RenderContext*>(context);
+		auto& station = (*ctx->Stations)[index];
+		auto& bus = (*ctx->Buses)[index];
+
+		bus->Zero(ctx->NumSamps, Audible::AUDIOSOURCE_LOOPS);
+
+		station->Zero(ctx->NumSamps, Audible::AUDIOSOURCE_LOOPS);
+		station->WriteBlock(bus, nullptr, 0, ctx->NumSamps, ctx->BlockStartSample);
+		station->EndMultiPlay(ctx->NumSamps);
+	}
+
+	void AudioHost::_RebuildRenderBuses()
+	{
+		auto stations = _audioStations.LoadShared();
+		auto numStations = stations ? stations->size() : 0u;
+
+		auto buses = std::make_shared<BusList>();
+		if (_workerPool.NumWorkers() > 0u)
+		{
+			buses->reserve(numStations);
+			for (auto i = 0u; i < numStations; i++)
+				buses->push_back(_channelMixer->CreateBus());
+		}
+
+		_renderBuses.Publish(buses);
 	}
 }
@@ -7,29 +7,53 @@
 #include <functional>
 #include "AudioDevice.h"
 #include "ChannelMixer.h"
+#include "AudioWorkerPool.h"
 #include "../io/UserConfig.h"
 #include "../engine/Station.h"
 #include "../engine/StationRemote.h"
 #include "../ninjam/NinjamController.h"
 #include "../utils/Timer.h"
+#include "../utils/Epoch.h"
 
 namespace audio
 {
 	class AudioHost
 	{
 	public:
-		using TickCallback = std::function<void(Time streamTime, unsigned int numSamps, const io::UserConfig& cfg, const AudioStreamParams& params)>;
+		using TickCallback = std::function<void(std::uint64_t sampleTime, unsigned int numSamps, const io::UserConfig& cfg, const AudioStreamParams& params)>;
 
 		AudioHost(io::UserConfig userConfig);
 		~AudioHost();
 
 		bool Init(std::shared_ptr<ninjam::NinjamController> ninjamController, 
 				  TickCallback tickCallback);
+		// Sets up the stream as Init does, but with no device. Blocks are then
+		// driven by RenderOffline instead of the device callback.
+		void InitOffline(const AudioStreamParams& streamParams,
+			TickCallback tickCallback);
 		void Close();
 
 		void SetStations(std::shared_ptr<const std::vector<std::shared_ptr<engine::Station>>> stations);
+		// Non-RT: only call while the stream is stopped. 0 renders every
+		// station on the audio thread.
+		void SetRenderWorkers(unsigned int numWorkers);
+		unsigned int NumRenderWorkers() const noexcept { return _workerPool.NumWorkers(); }
 
-		std::shared_ptr<const std::vector<std::shared_ptr<engine::Station>>> GetStationsSnapshot() const { return _audioStations.load(std::memory_order_acquire); }
+		// Runs one full audio block (ADC in, stations, DAC out). Called by the
+		// device callback, and directly by benchmarks with no device open.
+		void ProcessBlock(float* inBuffer,
+			float* outBuffer,
+			unsigned int numSamps,
+			const AudioStreamParams& audioStreamParams);
+		// Runs one block through the same path as the device callback, using
+		// the stream set up by InitOffline.
+		void RenderOffline(float* inBuffer,
+			float* outBuffer,
+			unsigned int numSamps,
+			double streamTime);
+
+		// Audio thread only, valid until the block's EpochReadGuard closes
+		const std::vector<std::shared_ptr<engine::Station>>* GetStationsSnapshot() const noexcept { return _audioStations.Load(); }
 		std::uint64_t GetAudioSampleCounter() const { return _audioSampleCounter.load(std::memory_order_relaxed); }
 		std::atomic<std::uint64_t>& GetAudioSampleCounter_Ref() { return _audioSampleCounter; }
 		std::int64_t GetMidiAnchorMicros() const { return _midiAnchorMicros.load(std::memory_order_relaxed); }
@@ -38,7 +62,7 @@ namespace audio
 
 		AudioStreamParams GetStreamParams() const 
 		{ 
-			return _audioDevice ? _audioDevice->GetAudioStreamParams() : AudioStreamParams(); 
+			return _audioDevice ? _audioDevice->GetAudioStreamParams() : _offlineStreamParams; 
 		}
 		
 		AudioDevice* GetDevice() const { return _audioDevice.get(); }
@@ -46,6 +70,20 @@ namespace audio
 		std::shared_ptr<ChannelMixer> GetChannelMixer() { return _channelMixer; }
 
 	private:
+		using StationList = std::vector<std::shared_ptr<engine::Station>>;
+		using BusList = std::vector<std::shared_ptr<ChannelMixer::Bus>>;
+
+		// Per-block arguments shared with the render workers.
+		struct RenderContext
+		{
+			AudioHost* Host;
+			const StationList* Stations;
+			const BusList* Buses;
+			const AudioStreamParams* StreamParams;
+			unsigned int NumSamps;
+			std::uint32_t BlockStartSample;
+		};
+
 		static int AudioCallback(void* outBuffer,
 			void* inBuffer,
 			unsigned int numSamps,
@@ -58,16 +96,43 @@ namespace audio
 			unsigned int numSamps,
 			double streamTime);
 
+		void _ProcessSerial(float* inBuf,
+			float* outBuf,
+			unsigned int numSamps,
+			const AudioStreamParams& audioStreamParams,
+			const StationList& stations);
+		void _ProcessParallel(float* inBuf,
+			float* outBuf,
+			unsigned int numSamps,
+			const AudioStreamParams& audioStreamParams,
+			const StationList& stations,
+			const BusList& buses);
+		void _ConfigureStream(const AudioStreamParams& audioStreamParams);
+		void _IngestRemoteStation(const std::shared_ptr<engine::Station>& station, unsigned int numSamps);
+		void _RebuildRenderBuses();
+
+		static void _MonitorTask(void* context, unsigned int index) noexcept;
+		static void _AdcTask(void* context, unsigned int index) noexcept;
+		static void _RenderTask(void* context, unsigned int index) noexcept;
+
 	private:
 		io::UserConfig _userConfig;
 		std::mutex _audioMutex;
 		std::unique_ptr<AudioDevice> _audioDevice;
+		AudioStreamParams _offlineStreamParams{};
+		// Set before the stream starts, for measuring callback load
+		unsigned int _deviceSampleRate = 0u;
 		std::shared_ptr<ChannelMixer> _channelMixer;
 
 		std::atomic<std::uint64_t> _audioSampleCounter{ 0 };
 		std::atomic<std::int64_t> _midiAnchorMicros{ 0 };
 
-		std::atomic<std::shared_ptr<const std::vector<std::shared_ptr<engine::Station>>>> _audioStations;
+		utils::EpochPtr<const StationList> _audioStations;
+		// One private bus per station, rebuilt off the audio thread by
+		// SetStations() and SetRenderWorkers(). Each stream configure calls
+		// the latter once the mixer has its new channel counts.
+		utils::EpochPtr<const BusList> _renderBuses;
+		AudioWorkerPool _workerPool;
 		std::shared_ptr<ninjam::NinjamController> _ninjamController;
 		TickCallback _tickCallback;
 	};
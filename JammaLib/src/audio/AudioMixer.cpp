@@ -1,4 +1,5 @@
 #include "AudioMixer.h"
+#include "LoadMonitor.h"
 
 using namespace audio;
 using namespace actions;
@@ -18,6 +19,7 @@ AudioMixer::AudioMixer(AudioMixerParams params) :
 	_unmutedFadeTarget(DefaultLevel),
 	_behaviour(std::unique_ptr<MixBehaviour>()),
 	_fade(std::make_unique<InterpolatedValueExp>()),
+	_fadeRamp(constants::MaxBlockSize, 0.0f),
 	_vu()
 {
 	_behaviour = std::visit(MixerBehaviourFactory{}, params.Behaviour);
@@ -94,9 +96,7 @@ void AudioMixer::WriteBlock(const std::shared_ptr<MultiAudioSink>& dest,
 	if (!_behaviour)
 		return;
 
-	auto fadeLevel = (float)_fade->Current();
-
-	if (_vu.IsVisible())
+	if (_vu.IsVisible() && !LoadMonitor::Instance().IsShedding(LoadMonitor::SHED_VU))
 	{
 		// Integrate peak tracking into the mixing loop to avoid a second pass.
 		auto peak = 0.0f;
@@ -106,19 +106,37 @@ void AudioMixer::WriteBlock(const std::shared_ptr<MultiAudioSink>& dest,
 			if (absSamp > peak)
 				peak = absSamp;
 		}
-		_vu.SetPeak(peak * fadeLevel, numSamps);
+		_vu.SetPeak(peak * (float)_fade->Current(), numSamps);
 	}
 
-	_behaviour->ApplyBlock(dest, srcBuf, fadeLevel, numSamps, 0);
-	Offset(numSamps);
+	auto sampsDone = 0u;
+	while (sampsDone < numSamps)
+	{
+		auto sampsLeft = numSamps - sampsDone;
+		auto sampsToWrite = sampsLeft < constants::MaxBlockSize ? sampsLeft : constants::MaxBlockSize;
+		auto fadeLevel = (float)_fade->Current();
+		auto fadeRamp = FadeRamp(sampsToWrite);
+
+		_behaviour->ApplyBlock(dest, srcBuf + sampsDone, fadeLevel, fadeRamp, sampsToWrite, sampsDone);
+		sampsDone += sampsToWrite;
+	}
 }
 
 void AudioMixer::Offset(unsigned int numSamps)
 {
-	for (auto samp = 0u; samp < numSamps; samp++)
+	_fade->Advance(numSamps);
+}
+
+const float* AudioMixer::FadeRamp(unsigned int numSamps)
+{
+	if (_fade->IsSettled() || (numSamps > _fadeRamp.size()))
 	{
-		_fade->Next();
+		_fade->Advance(numSamps);
+		return nullptr;
 	}
+
+	_fade->FillRamp(_fadeRamp.data(), numSamps);
+	return _fadeRamp.data();
 }
 
 void AudioMixer::SetChannels(std::vector<unsigned int> channels)
@@ -157,6 +175,9 @@ void AudioMixer::SetVuVisible(bool visible)
 
 void AudioMixer::UpdateVu(float peak, unsigned int numSamps)
 {
+	if (LoadMonitor::Instance().IsShedding(LoadMonitor::SHED_VU))
+		return;
+
 	_vu.SetPeak(peak, numSamps);
 }
 
@@ -199,6 +220,7 @@ void WireMixBehaviour::_ApplyBlockToChannels(const std::shared_ptr<MultiAudioSin
 	const float* srcBuf,
 	float fadeCurrent,
 	float fadeNew,
+	const float* fadeRamp,
 	unsigned int numSamps,
 	unsigned int startIndex) const
 {
@@ -210,7 +232,8 @@ void WireMixBehaviour::_ApplyBlockToChannels(const std::shared_ptr<MultiAudioSin
 	request.numSamps = numSamps;
 	request.stride = 1;
 	request.fadeCurrent = fadeCurrent;
-	request.fadeNew = fadeNew;
+	request.fadeNew = nullptr == fadeRamp ? fadeNew : 1.0f;
+	request.fadeRamp = fadeRamp;
 	request.source = base::Audible::AUDIOSOURCE_MIXER;
 
 	for (auto chan : _mixParams.Channels)
@@ -222,15 +245,17 @@ void WireMixBehaviour::_ApplyBlockToChannels(const std::shared_ptr<MultiAudioSin
 void WireMixBehaviour::ApplyBlock(const std::shared_ptr<MultiAudioSink>& dest,
 	const float* srcBuf,
 	float fadeLevel,
+	const float* fadeRamp,
 	unsigned int numSamps,
 	unsigned int startIndex) const
 {
-	_ApplyBlockToChannels(dest, srcBuf, 0.0f, fadeLevel, numSamps, startIndex);
+	_ApplyBlockToChannels(dest, srcBuf, 0.0f, fadeLevel, fadeRamp, numSamps, startIndex);
 }
 
 void PanMixBehaviour::ApplyBlock(const std::shared_ptr<MultiAudioSink>& dest,
 	const float* srcBuf,
 	float fadeLevel,
+	const float* fadeRamp,
 	unsigned int numSamps,
 	unsigned int startIndex) const
 {
@@ -248,7 +273,8 @@ void PanMixBehaviour::ApplyBlock(const std::shared_ptr<MultiAudioSink>& dest,
 			request.numSamps = numSamps;
 			request.stride = 1;
 			request.fadeCurrent = 1.0f;
-			request.fadeNew = fadeLevel * _mixParams.ChannelLevels.at(chan);
+			request.fadeNew = (nullptr == fadeRamp ? fadeLevel : 1.0f) * _mixParams.ChannelLevels.at(chan);
+			request.fadeRamp = fadeRamp;
 			request.source = base::Audible::AUDIOSOURCE_MIXER;
 
 			dest->OnBlockWriteChannel(chan, request, startIndex);
@@ -259,6 +285,7 @@ void PanMixBehaviour::ApplyBlock(const std::shared_ptr<MultiAudioSink>& dest,
 void BounceMixBehaviour::ApplyBlock(const std::shared_ptr<MultiAudioSink>& dest,
 	const float* srcBuf,
 	float fadeLevel,
+	const float* fadeRamp,
 	unsigned int numSamps,
 	unsigned int startIndex) const
 {
@@ -269,10 +296,22 @@ void BounceMixBehaviour::ApplyBlock(const std::shared_ptr<MultiAudioSink>& dest,
 	request.samples = srcBuf;
 	request.numSamps = numSamps;
 	request.stride = 1;
-	request.fadeCurrent = 1.0f - fadeLevel;
-	request.fadeNew = fadeLevel;
 	request.source = base::Audible::AUDIOSOURCE_BOUNCE;
 
+	if (nullptr == fadeRamp)
+	{
+		request.fadeCurrent = 1.0f - fadeLevel;
+		request.fadeNew = fadeLevel;
+	}
+	else
+	{
+		// Crossfade per sample: fadeCurrent = 1 - ramp, fadeNew = ramp
+		request.fadeCurrent = 1.0f;
+		request.fadeNew = 1.0f;
+		request.fadeRamp = fadeRamp;
+		request.fadeCurrentRamp = -1.0f;
+	}
+
 	for (auto chan : _mixParams.Channels)
 		dest->OnBlockWriteChannel(chan, request, startIndex);
 }
@@ -280,8 +319,9 @@ void BounceMixBehaviour::ApplyBlock(const std::shared_ptr<MultiAudioSink>& dest,
 void MergeMixBehaviour::ApplyBlock(const std::shared_ptr<MultiAudioSink>& dest,
 	const float* srcBuf,
 	float fadeLevel,
+	const float* fadeRamp,
 	unsigned int numSamps,
 	unsigned int startIndex) const
 {
-	_ApplyBlockToChannels(dest, srcBuf, 1.0f, fadeLevel, numSamps, startIndex);
+	_ApplyBlockToChannels(dest, srcBuf, 1.0f, fadeLevel, fadeRamp, numSamps, startIndex);
 }
@@ -11,6 +11,7 @@
 #include "../actions/GuiAction.h"
 #include "../gui/GuiSlider.h"
 #include "../gui/GuiVu.h"
+#include "../include/Constants.h"
 
 namespace audio
 {
@@ -40,12 +41,15 @@ namespace audio
 
 	typedef std::variant<MixBehaviourParams, WireMixBehaviourParams, PanMixBehaviourParams, BounceMixBehaviourParams, MergeMixBehaviourParams> BehaviourParams;
 
+	// fadeRamp, when non-null, holds the mixer fade for each of the
+	// numSamps samples and supersedes fadeLevel.
 	class MixBehaviour
 	{
 	public:
 		virtual void ApplyBlock(const std::shared_ptr<base::MultiAudioSink>& dest,
 			const float* srcBuf,
 			float fadeLevel,
+			const float* fadeRamp,
 			unsigned int numSamps,
 			unsigned int startIndex) const {};
 
@@ -67,6 +71,7 @@ namespace audio
 		virtual void ApplyBlock(const std::shared_ptr<base::MultiAudioSink>& dest,
 			const float* srcBuf,
 			float fadeLevel,
+			const float* fadeRamp,
 			unsigned int numSamps,
 			unsigned int startIndex) const override;
 
@@ -90,6 +95,7 @@ namespace audio
 			const float* srcBuf,
 			float fadeCurrent,
 			float fadeNew,
+			const float* fadeRamp,
 			unsigned int numSamps,
 			unsigned int startIndex) const;
 
@@ -109,6 +115,7 @@ namespace audio
 		virtual void ApplyBlock(const std::shared_ptr<base::MultiAudioSink>& dest,
 			const float* srcBuf,
 			float fadeLevel,
+			const float* fadeRamp,
 			unsigned int numSamps,
 			unsigned int startIndex) const override;
 
@@ -142,6 +149,7 @@ namespace audio
 		virtual void ApplyBlock(const std::shared_ptr<base::MultiAudioSink>& dest,
 			const float* srcBuf,
 			float fadeLevel,
+			const float* fadeRamp,
 			unsigned int numSamps,
 			unsigned int startIndex) const override;
 	};
@@ -159,6 +167,7 @@ namespace audio
 		virtual void ApplyBlock(const std::shared_ptr<base::MultiAudioSink>& dest,
 			const float* srcBuf,
 			float fadeLevel,
+			const float* fadeRamp,
 			unsigned int numSamps,
 			unsigned int startIndex) const override;
 	};
@@ -241,6 +250,10 @@ namespace audio
 			const float* srcBuf,
 			unsigned int numSamps);
 		void Offset(unsigned int numSamps);
+		// Fills the fade for the next numSamps samples and advances past
+		// them. Returns nullptr if the fade has settled (or numSamps exceeds
+		// MaxBlockSize), in which case Level() holds for the whole block.
+		const float* FadeRamp(unsigned int numSamps);
 		void SetChannels(std::vector<unsigned int> channels);
 		void SetMaxChannels(unsigned int channels);
 		void SetBehaviour(std::unique_ptr<MixBehaviour> behaviour);
@@ -266,6 +279,7 @@ namespace audio
 		double _unmutedFadeTarget;
 		std::unique_ptr<MixBehaviour> _behaviour;
 		std::unique_ptr<InterpolatedValue> _fade;
+		std::vector<float> _fadeRamp;
 		gui::GuiVu _vu;
 	};
 }
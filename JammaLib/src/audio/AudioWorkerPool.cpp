@@ -0,0 +1,176 @@
+#include "AudioWorkerPool.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define JAMMA_SPIN_PAUSE() _mm_pause()
+#else
+#define JAMMA_SPIN_PAUSE() std::this_thread::yield()
+#endif
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#endif
+
+using namespace audio;
+
+AudioWorkerPool::AudioWorkerPool() :
+	_workers(),
+	_quit(false),
+	_work(0u),
+	_task(nullptr),
+	_context(nullptr),
+	_doneItems(0u),
+	_sleepers(0u)
+{
+}
+
+AudioWorkerPool::~AudioWorkerPool()
+{
+	Stop();
+}
+
+void AudioWorkerPool::Start(unsigned int numWorkers)
+{
+	Stop();
+
+	_quit.store(false, std::memory_order_release);
+	_workers.reserve(numWorkers);
+
+	for (auto i = 0u; i < numWorkers; i++)
+		_workers.emplace_back([this]() { _WorkerLoop(); });
+}
+
+void AudioWorkerPool::Stop()
+{
+	if (_workers.empty())
+		return;
+
+	_quit.store(true, std::memory_order_release);
+
+	// Bump the generation with an empty job so sleeping workers wake up
+	auto work = _work.load(std::memory_order_relaxed);
+	_work.store(_Pack(_Generation(work) + 1u, 0u, 0u), std::memory_order_seq_cst);
+	_work.notify_all();
+
+	for (auto& worker : _workers)
+	{
+		if (worker.joinable())
+			worker.join();
+	}
+
+	_workers.clear();
+}
+
+void AudioWorkerPool::Run(Task task, void* context, unsigned int numItems) noexcept
+{
+	if ((nullptr == task) || (0u == numItems))
+		return;
+
+	if (numItems > MaxItems)
+		numItems = MaxItems;
+
+	if (_workers.empty() || (1u == numItems))
+	{
+		for (auto i = 0u; i < numItems; i++)
+			task(context, i);
+
+		return;
+	}
+
+	// Previous generation has fully completed (Run only returns once the
+	// done counter is reached), so nobody can be reading these any more
+	_task.store(task, std::memory_order_relaxed);
+	_context.store(context, std::memory_order_relaxed);
+	_doneItems.store(0u, std::memory_order_relaxed);
+
+	auto generation = _Generation(_work.load(std::memory_order_relaxed)) + 1u;
+	_work.store(_Pack(generation, numItems, 0u), std::memory_order_seq_cst);
+
+	if (_sleepers.load(std::memory_order_seq_cst) > 0u)
+		_work.notify_all();
+
+	_Drain(generation);
+
+	while (_doneItems.load(std::memory_order_acquire) < numItems)
+		_Pause();
+}
+
+void AudioWorkerPool::_Pause() noexcept
+{
+	JAMMA_SPIN_PAUSE();
+}
+
+void AudioWorkerPool::_RaiseThreadPriority() noexcept
+{
+#ifdef _WIN32
+	SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
+#endif
+}
+
+void AudioWorkerPool::_WorkerLoop() noexcept
+{
+	_RaiseThreadPriority();
+
+	auto seen = _work.load(std::memory_order_acquire);
+
+	while (!_quit.load(std::memory_order_acquire))
+	{
+		auto work = _work.load(std::memory_order_acquire);
+
+		if (_Generation(work) != _Generation(seen))
+		{
+			seen = work;
+			_Drain(_Generation(work));
+			continue;
+		}
+
+		// Only the generation counts. Claims move the rest of _work on after
+		// seen was taken, so a whole-word compare would never match again.
+		auto spins = 0u;
+		while ((spins < SpinIterations) &&
+			(_Generation(_work.load(std::memory_order_relaxed)) == _Generation(seen)))
+		{
+			_Pause();
+			spins++;
+		}
+
+		if (spins < SpinIterations)
+			continue;
+
+		// Register as a sleeper before re-checking, so Run() either sees us
+		// and notifies, or we see its new generation and skip the wait
+		_sleepers.fetch_add(1u, std::memory_order_seq_cst);
+
+		auto current = _work.load(std::memory_order_seq_cst);
+		if (_Generation(current) == _Generation(seen))
+			_work.wait(current, std::memory_order_acquire);
+
+		_sleepers.fetch_sub(1u, std::memory_order_relaxed);
+	}
+}
+
+void AudioWorkerPool::_Drain(std::uint32_t generation) noexcept
+{
+	auto work = _work.load(std::memory_order_acquire);
+
+	while (_Generation(work) == generation)
+	{
+		auto index = _Index(work);
+		if (index >= _Count(work))
+			return;
+
+		if (_work.compare_exchange_weak(work, work + 1u,
+			std::memory_order_acq_rel,
+			std::memory_order_acquire))
+		{
+			auto task = _task.load(std::memory_order_relaxed);
+			auto context = _context.load(std::memory_order_relaxed);
+
+			task(context, index);
+
+			_doneItems.fetch_add(1u, std::memory_order_release);
+			work = _work.load(std::memory_order_acquire);
+		}
+	}
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace audio
+{
+	// Pool of pre-spawned, real-time priority worker threads that the audio
+	// callback can fan independent work items out to.
+	//
+	// Real-time invariants for Run():
+	//   - No heap allocation and no locks.
+	//   - Work items are claimed with a single CAS on a packed
+	//     (generation, next index) word, so a worker that wakes late for an
+	//     old generation can never claim an item of the next one.
+	//   - The calling thread also drains items and then spins on the done
+	//     counter, which acts as the barrier before the caller continues.
+	//
+	// Start()/Stop() spawn and join threads and must only be called while the
+	// audio stream is stopped (or before the first callback).
+	class AudioWorkerPool
+	{
+	public:
+		using Task = void(*)(void* context, unsigned int index) noexcept;
+
+	public:
+		AudioWorkerPool();
+		~AudioWorkerPool();
+
+		AudioWorkerPool(const AudioWorkerPool&) = delete;
+		AudioWorkerPool& operator=(const AudioWorkerPool&) = delete;
+
+	public:
+		void Start(unsigned int numWorkers);
+		void Stop();
+		unsigned int NumWorkers() const noexcept { return static_cast<unsigned int>(_workers.size()); }
+		// Workers blocked waiting for the next Run(), rather than spinning.
+		unsigned int NumSleeping() const noexcept { return _sleepers.load(std::memory_order_acquire); }
+
+		// Runs task(context, i) for every i in [0, numItems) across the workers
+		// and the calling thread. Returns once every item has completed.
+		// numItems is clamped to MaxItems.
+		void Run(Task task, void* context, unsigned int numItems) noexcept;
+
+	public:
+		static constexpr unsigned int MaxItems = 0xFFFFu;
+		// Iterations a worker spins between jobs before it blocks.
+		static constexpr unsigned int SpinIterations = 4096u;
+
+	private:
+		static std::uint64_t _Pack(std::uint32_t generation, std::uint32_t count, std::uint32_t index) noexcept
+		{
+			return (static_cast<std::uint64_t>(generation) << 32) |
+				(static_cast<std::uint64_t>(count & MaxItems) << 16) |
+				(index & MaxItems);
+		}
+		static std::uint32_t _Generation(std::uint64_t work) noexcept { return static_cast<std::uint32_t>(work >> 32); }
+		static std::uint32_t _Count(std::uint64_t work) noexcept { return static_cast<std::uint32_t>(work >> 16) & MaxItems; }
+		static std::uint32_t _Index(std::uint64_t work) noexcept { return static_cast<std::uint32_t>(work) & MaxItems; }
+		static void _Pause() noexcept;
+		static void _RaiseThreadPriority() noexcept;
+
+		void _WorkerLoop() noexcept;
+		void _Drain(std::uint32_t generation) noexcept;
+
+	private:
+		std::vector<std::thread> _workers;
+		std::atomic<bool> _quit;
+		std::atomic<std::uint64_t> _work;
+		std::atomic<Task> _task;
+		std::atomic<void*> _context;
+		std::atomic<unsigned int> _doneItems;
+		std::atomic<unsigned int> _sleepers;
+	};
+}
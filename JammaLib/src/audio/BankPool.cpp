@@ -0,0 +1,300 @@
+#include "BankPool.h"
+#include "../include/Constants.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <new>
+#include <sstream>
+
+using namespace audio;
+
+BankPool::BankPool() :
+	_mutex(),
+	_slabShift(DefaultSlabShift),
+	_budgetBytes(DefaultBudgetBytes),
+	_numInUse(0),
+	_numBanks(0),
+	_freeSlabs(),
+	_reserve{},
+	_compactIdleSamps(constants::DefaultCompactIdleSamps)
+{
+	_ReserveFreeList();
+}
+
+BankPool::~BankPool()
+{
+	for (auto& reserved : _reserve)
+		delete[] reserved.exchange(nullptr, std::memory_order_acquire);
+}
+
+BankPool& BankPool::Instance()
+{
+	static BankPool pool;
+	return pool;
+}
+
+bool BankPool::Configure(unsigned long slabSamps, std::size_t budgetBytes)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	auto slabShift = SlabShiftFor(slabSamps);
+	auto isApplied = true;
+
+	// Reserved slabs would otherwise pin the slab size
+	_DrainReserve();
+
+	if (slabShift != _slabShift.load(std::memory_order_relaxed))
+	{
+		if ((0 == _numInUse) && (0 == _numBanks))
+		{
+			_freeSlabs.clear();
+			_slabShift.store(slabShift, std::memory_order_relaxed);
+		}
+		else
+			isApplied = false;
+	}
+
+	_budgetBytes = budgetBytes;
+
+	// Drop cached slabs that no longer fit under the budget
+	while (!_freeSlabs.empty() && (_HeldSlabs() * _SlabBytes() > _budgetBytes))
+		_freeSlabs.pop_back();
+
+	_ReserveFreeList();
+
+	return isApplied;
+}
+
+unsigned int BankPool::SlabShift() const noexcept
+{
+	return _slabShift.load(std::memory_order_relaxed);
+}
+
+unsigned long BankPool::SlabSize() const noexcept
+{
+	return 1ul << SlabShift();
+}
+
+unsigned int BankPool::AttachBank() noexcept
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	_numBanks++;
+	return _slabShift.load(std::memory_order_relaxed);
+}
+
+void BankPool::DetachBank() noexcept
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	if (_numBanks > 0)
+		_numBanks--;
+}
+
+std::unique_ptr<float[]> BankPool::Acquire()
+{
+	std::unique_ptr<float[]> slab;
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		if (!_freeSlabs.empty())
+		{
+			slab = std::move(_freeSlabs.back());
+			_freeSlabs.pop_back();
+			std::fill_n(slab.get(), SlabSize(), 0.0f);
+		}
+		else
+		{
+			if ((_HeldSlabs() + 1u) * _SlabBytes() > _budgetBytes)
+				return nullptr;
+
+			slab = _NewSlab();
+			if (!slab)
+				return nullptr;
+		}
+
+		_numInUse++;
+	}
+
+	return slab;
+}
+
+void BankPool::Release(std::unique_ptr<float[]> slab) noexcept
+{
+	if (!slab)
+		return;
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	if (_numInUse > 0)
+		_numInUse--;
+
+	// Capacity for every slab the budget allows is reserved up front, so
+	// this never reallocates. Anything over budget (after the budget was
+	// lowered) is just freed.
+	auto isOverBudget = (_HeldSlabs() + 1u) * _SlabBytes() > _budgetBytes;
+	if (isOverBudget || (_freeSlabs.size() >= _freeSlabs.capacity()))
+		return;
+
+	_freeSlabs.push_back(std::move(slab));
+}
+
+void BankPool::Reserve(unsigned int numSlabs)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	while ((_freeSlabs.size() < numSlabs) &&
+		((_HeldSlabs() + 1u) * _SlabBytes() <= _budgetBytes))
+	{
+		auto slab = _NewSlab();
+		if (!slab)
+			break;
+
+		_freeSlabs.push_back(std::move(slab));
+	}
+}
+
+void BankPool::Trim()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_freeSlabs.clear();
+}
+
+BankPool::Usage BankPool::GetUsage() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	Usage usage;
+	usage.SlabBytes = _SlabBytes();
+	usage.BudgetBytes = _budgetBytes;
+	usage.InUseBytes = _numInUse * _SlabBytes();
+	usage.FreeBytes = _freeSlabs.size() * _SlabBytes();
+
+	return usage;
+}
+
+std::string BankPool::FormatUsage(const Usage& usage)
+{
+	const auto toMegabytes = [](std::size_t bytes) { return static_cast<double>(bytes) / (1024.0 * 1024.0); };
+
+	std::stringstream ss;
+	ss << std::fixed << std::setprecision(1)
+		<< "in use " << toMegabytes(usage.InUseBytes) << " MB"
+		<< ", free " << toMegabytes(usage.FreeBytes) << " MB"
+		<< ", budget " << toMegabytes(usage.BudgetBytes) << " MB"
+		<< " (" << (usage.SlabBytes / 1024u) << " KB slabs)";
+
+	return ss.str();
+}
+
+std::unique_ptr<float[]> BankPool::TakeReserved() noexcept
+{
+	for (auto& reserved : _reserve)
+	{
+		if (nullptr == reserved.load(std::memory_order_relaxed))
+			continue;
+
+		auto* slab = reserved.exchange(nullptr, std::memory_order_acquire);
+		if (nullptr != slab)
+			return std::unique_ptr<float[]>(slab);
+	}
+
+	return nullptr;
+}
+
+void BankPool::RefillReserve()
+{
+	for (auto& reserved : _reserve)
+	{
+		if (nullptr != reserved.load(std::memory_order_relaxed))
+			continue;
+
+		auto slab = Acquire();
+		if (!slab)
+			return;
+
+		float* empty = nullptr;
+		if (reserved.compare_exchange_strong(empty, slab.get(), std::memory_order_release, std::memory_order_relaxed))
+			slab.release();
+		else
+			Release(std::move(slab));
+	}
+}
+
+unsigned int BankPool::NumReserved() const noexcept
+{
+	auto numReserved = 0u;
+
+	for (auto& reserved : _reserve)
+	{
+		if (nullptr != reserved.load(std::memory_order_relaxed))
+			numReserved++;
+	}
+
+	return numReserved;
+}
+
+void BankPool::SetCompactIdleSamps(unsigned long compactIdleSamps) noexcept
+{
+	_compactIdleSamps.store(compactIdleSamps, std::memory_order_relaxed);
+}
+
+unsigned long BankPool::CompactIdleSamps() const noexcept
+{
+	return _compactIdleSamps.load(std::memory_order_relaxed);
+}
+
+unsigned int BankPool::SlabShiftFor(unsigned long slabSamps) noexcept
+{
+	auto shift = MinSlabShift;
+	while ((shift < MaxSlabShift) && ((1ul << shift) < slabSamps))
+		shift++;
+
+	return shift;
+}
+
+std::size_t BankPool::_SlabBytes() const noexcept
+{
+	return sizeof(float) * static_cast<std::size_t>(SlabSize());
+}
+
+std::size_t BankPool::_HeldSlabs() const noexcept
+{
+	return _numInUse + _freeSlabs.size();
+}
+
+std::unique_ptr<float[]> BankPool::_NewSlab() const noexcept
+{
+	try
+	{
+		return std::make_unique<float[]>(SlabSize());
+	}
+	catch (const std::bad_alloc&)
+	{
+		return nullptr;
+	}
+}
+
+void BankPool::_DrainReserve() noexcept
+{
+	for (auto& reserved : _reserve)
+	{
+		std::unique_ptr<float[]> slab(reserved.exchange(nullptr, std::memory_order_acquire));
+		if (!slab)
+			continue;
+
+		if (_numInUse > 0)
+			_numInUse--;
+
+		if (_freeSlabs.size() < _freeSlabs.capacity())
+			_freeSlabs.push_back(std::move(slab));
+	}
+}
+
+void BankPool::_ReserveFreeList()
+{
+	auto maxSlabs = _budgetBytes / _SlabBytes();
+	if (maxSlabs > _freeSlabs.capacity())
+		_freeSlabs.reserve(maxSlabs);
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace audio
+{
+	// Process-wide pool of fixed-size sample slabs backing every BufferBank.
+	//
+	// Slabs handed back by a BufferBank go onto a free list and are reused
+	// before anything new is allocated, so once the pool is warm the
+	// record/ditch cycle no longer touches the heap. The total held (in use
+	// plus free) never exceeds the byte budget; Acquire() returns nullptr
+	// instead and the bank simply stops growing.
+	//
+	// None of this is real-time safe. Acquire/Release run from the same
+	// off-thread paths that used to allocate banks directly. The exception
+	// is a small reserve of slabs, topped up by RefillReserve(), that the
+	// audio thread can take with TakeReserved() when it has to unpack a
+	// packed bank it is about to write to. Reserved slabs count as in use.
+	class BankPool
+	{
+	public:
+		static constexpr unsigned int MinSlabShift = 14u;      // 16384 samples
+		static constexpr unsigned int MaxSlabShift = 20u;      // 1048576 samples
+		static constexpr unsigned int DefaultSlabShift = 17u;  // 131072 samples
+		static constexpr std::size_t DefaultBudgetBytes = std::size_t(4096u) << 20;
+		static constexpr unsigned int NumReserveSlabs = 4u;
+
+		struct Usage
+		{
+			std::size_t SlabBytes;
+			std::size_t BudgetBytes;
+			std::size_t InUseBytes;
+			std::size_t FreeBytes;
+		};
+
+	public:
+		BankPool(const BankPool&) = delete;
+		BankPool& operator=(const BankPool&) = delete;
+		~BankPool();
+
+		static BankPool& Instance();
+
+		// Slab size is rounded up to a power of two and clamped to
+		// [2^MinSlabShift, 2^MaxSlabShift]. It can only change while no slabs
+		// are in use and no banks are attached, so call this before any
+		// loops exist. Returns false if the slab size change was refused
+		// (the budget is still applied).
+		bool Configure(unsigned long slabSamps, std::size_t budgetBytes);
+		unsigned int SlabShift() const noexcept;
+		unsigned long SlabSize() const noexcept;
+
+		// Every BufferBank attaches for its lifetime and indexes with the
+		// slab shift returned. A packed bank holds no slabs, so this is what
+		// keeps the slab size from changing under it.
+		unsigned int AttachBank() noexcept;
+		void DetachBank() noexcept;
+
+		// A zeroed slab, or nullptr if the budget is exhausted.
+		std::unique_ptr<float[]> Acquire();
+		void Release(std::unique_ptr<float[]> slab) noexcept;
+		// Pre-warms the free list to hold at least numSlabs (budget permitting).
+		void Reserve(unsigned int numSlabs);
+		// Frees every slab on the free list.
+		void Trim();
+		Usage GetUsage() const;
+		static std::string FormatUsage(const Usage& usage);
+
+		// Audio-callback safe: a slab from the reserve, or nullptr if the
+		// reserve is empty. Its contents are unspecified.
+		std::unique_ptr<float[]> TakeReserved() noexcept;
+		// Tops the reserve back up to NumReserveSlabs (budget permitting).
+		void RefillReserve();
+		unsigned int NumReserved() const noexcept;
+
+		// Loops that play this many samples without being written to are
+		// packed to save memory (0 disables packing).
+		void SetCompactIdleSamps(unsigned long compactIdleSamps) noexcept;
+		unsigned long CompactIdleSamps() const noexcept;
+
+	protected:
+		BankPool();
+
+		static unsigned int SlabShiftFor(unsigned long slabSamps) noexcept;
+		std::size_t _SlabBytes() const noexcept;
+		std::size_t _HeldSlabs() const noexcept;
+		std::unique_ptr<float[]> _NewSlab() const noexcept;
+		void _ReserveFreeList();
+		void _DrainReserve() noexcept;
+
+	protected:
+		mutable std::mutex _mutex;
+		std::atomic<unsigned int> _slabShift;
+		std::size_t _budgetBytes;
+		std::size_t _numInUse;
+		std::size_t _numBanks;
+		std::vector<std::unique_ptr<float[]>> _freeSlabs;
+		std::array<std::atomic<float*>, NumReserveSlabs> _reserve;
+		std::atomic<unsigned long> _compactIdleSamps;
+	};
+}
@@ -1,26 +1,106 @@
 #include "BufferBank.h"
+#include "FadeKernels.h"
+#include "PackKernels.h"
+#include "../utils/Epoch.h"
 
 #include <algorithm>
+#include <cmath>
+#include <new>
 
 using namespace audio;
+using utils::EpochDomain;
+
+namespace
+{
+	constexpr std::uint64_t DirtyNone = 0xFFFFFFFF00000000ull;
+	constexpr std::uint64_t DirtyAll = 0x00000000FFFFFFFFull;
+
+	constexpr std::uint64_t PackRange(unsigned long start, unsigned long end) noexcept
+	{
+		return (static_cast<std::uint64_t>(start) << 32) | static_cast<std::uint64_t>(end);
+	}
+
+	constexpr unsigned int GrainWordShift = 6u;
+	constexpr unsigned long GrainWordBits = 1ul << GrainWordShift;
+
+	// Only for swaps between threads that are both off the audio path
+	template<typename T>
+	void SwapAtomic(std::atomic<T>& lhs, std::atomic<T>& rhs) noexcept
+	{
+		auto value = lhs.load(std::memory_order_relaxed);
+		lhs.store(rhs.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		rhs.store(value, std::memory_order_relaxed);
+	}
+}
+
+struct BufferBank::PackedBanks
+{
+	std::array<std::atomic<PackedSlab*>, _MaxBanks> Packed;
+	// Encoded by PackBanks(), waiting for CommitPacked()
+	std::array<std::atomic<PackedSlab*>, _MaxBanks> Pending;
+	// Swapped out on the audio thread, waiting for _RetireReplaced()
+	std::array<std::atomic<float*>, _MaxBanks> RetiredSlabs;
+	std::array<std::atomic<PackedSlab*>, _MaxBanks> RetiredPacks;
+
+	PackedBanks() noexcept :
+		Packed{},
+		Pending{},
+		RetiredSlabs{},
+		RetiredPacks{}
+	{
+	}
+};
 
 BufferBank::BufferBank() :
 	_dummy(0.0f),
+	_bankShift(BankPool::Instance().AttachBank()),
+	_bankMask((1ul << _bankShift) - 1ul),
 	_length(0ul),
-	_numBanks(0u)
+	_numBanks(0u),
+	_bufferBank{},
+	_numSummaryLevels(0u),
+	_summaryLevelOffsets{},
+	_summaries{},
+	_audibleGrains{},
+	_dirtyRange(DirtyNone),
+	_writeCount(0u),
+	_packedBanks(nullptr),
+	_numPacked(0u),
+	_numUnpacking(0u),
+	_numPending(0u),
+	_numRetired(0u)
 {
+	_InitSummaryLayout();
 	Init();
 }
 
 BufferBank::~BufferBank()
 {
+	_ReleaseBanks();
+	delete _packedBanks.load(std::memory_order_acquire);
+	BankPool::Instance().DetachBank();
 }
 
 BufferBank::BufferBank(BufferBank&& other) noexcept :
 	_dummy(other._dummy),
+	_bankShift(BankPool::Instance().AttachBank()),
+	_bankMask((1ul << _bankShift) - 1ul),
 	_length(0ul),
-	_numBanks(0u)
+	_numBanks(0u),
+	_bufferBank{},
+	_numSummaryLevels(0u),
+	_summaryLevelOffsets{},
+	_summaries{},
+	_audibleGrains{},
+	_dirtyRange(DirtyNone),
+	_writeCount(0u),
+	_packedBanks(nullptr),
+	_numPacked(0u),
+	_numUnpacking(0u),
+	_numPending(0u),
+	_numRetired(0u)
 {
+	_InitSummaryLayout();
 	swap(other);
 }
 
@@ -35,17 +115,32 @@ BufferBank& BufferBank::operator=(BufferBank&& other) noexcept
 void BufferBank::swap(BufferBank& other) noexcept
 {
 	std::swap(_dummy, other._dummy);
+	std::swap(_bankShift, other._bankShift);
+	std::swap(_bankMask, other._bankMask);
 
-	auto length = _length.load(std::memory_order_relaxed);
-	_length.store(other._length.load(std::memory_order_relaxed), std::memory_order_relaxed);
-	other._length.store(length, std::memory_order_relaxed);
-
-	auto numBanks = _numBanks.load(std::memory_order_relaxed);
-	_numBanks.store(other._numBanks.load(std::memory_order_relaxed), std::memory_order_relaxed);
-	other._numBanks.store(numBanks, std::memory_order_relaxed);
+	SwapAtomic(_length, other._length);
+	SwapAtomic(_numBanks, other._numBanks);
 
 	for (auto i = 0u; i < _MaxBanks; ++i)
-		std::swap(_bufferBank[i], other._bufferBank[i]);
+	{
+		SwapAtomic(_bufferBank[i], other._bufferBank[i]);
+		std::swap(_summaries[i], other._summaries[i]);
+		std::swap(_audibleGrains[i], other._audibleGrains[i]);
+	}
+
+	std::swap(_numSummaryLevels, other._numSummaryLevels);
+	std::swap(_summaryLevelOffsets, other._summaryLevelOffsets);
+	SwapAtomic(_packedBanks, other._packedBanks);
+
+	SwapAtomic(_writeCount, other._writeCount);
+	SwapAtomic(_numPacked, other._numPacked);
+	SwapAtomic(_numUnpacking, other._numUnpacking);
+	SwapAtomic(_numPending, other._numPending);
+	SwapAtomic(_numRetired, other._numRetired);
+
+	// Whoever was watching either bank is now looking at different samples
+	_dirtyRange.store(DirtyAll, std::memory_order_relaxed);
+	other._dirtyRange.store(DirtyAll, std::memory_order_relaxed);
 }
 
 void BufferBank::Init()
@@ -54,14 +149,14 @@ void BufferBank::Init()
 	UpdateCapacity();
 }
 
-const float& audio::BufferBank::operator[](unsigned long index) const
+float audio::BufferBank::operator[](unsigned long index) const
 {
 	if (index < Capacity())
 	{
-		auto bank = index / _BufferBankSize;
-		auto offset = index % _BufferBankSize;
+		auto samp = 0.0f;
+		_ReadBank(index >> _bankShift, index & _bankMask, &samp, 1ul);
 
-		return _bufferBank[bank][offset];
+		return samp;
 	}
 
 	return _dummy;
@@ -71,10 +166,10 @@ float& audio::BufferBank::operator[](unsigned long index)
 {
 	if (index < Capacity())
 	{
-		auto bank = index / _BufferBankSize;
-		auto offset = index % _BufferBankSize;
+		auto* samples = _WritableBank(index >> _bankShift, index & _bankMask, 1ul);
 
-		return _bufferBank[bank][offset];
+		if (nullptr != samples)
+			return samples[index & _bankMask];
 	}
 
 	return _dummy;
@@ -100,13 +195,39 @@ void BufferBank::UpdateCapacity()
 	auto currentBanks = _numBanks.load(std::memory_order_acquire);
 	while (currentBanks < numBanks)
 	{
-		if (!_bufferBank[currentBanks])
-			_bufferBank[currentBanks] = std::make_unique<float[]>(_BufferBankSize);
-
-		std::fill_n(_bufferBank[currentBanks].get(), _BufferBankSize, 0.0f);
+		// Slabs come back zeroed. Out of budget just means no more growth;
+		// writes past Capacity() are dropped.
+		auto slab = BankPool::Instance().Acquire();
+		if (!slab)
+			break;
+
+		// Summary of a zeroed slab is all zeros, and all its grains are
+		// silent, which is what value initialisation gives us
+		std::unique_ptr<SampleSummary[]> summary;
+		std::unique_ptr<std::uint64_t[]> audibleGrains;
+		try
+		{
+			summary = std::make_unique<SampleSummary[]>(_summaryLevelOffsets[_numSummaryLevels]);
+			audibleGrains = std::make_unique<std::uint64_t[]>(_summaryLevelOffsets[1] >> GrainWordShift);
+		}
+		catch (const std::bad_alloc&)
+		{
+			BankPool::Instance().Release(std::move(slab));
+			break;
+		}
+
+		_bufferBank[currentBanks].store(slab.release(), std::memory_order_relaxed);
+		_summaries[currentBanks] = std::move(summary);
+		_audibleGrains[currentBanks] = std::move(audibleGrains);
 		++currentBanks;
 		_numBanks.store(currentBanks, std::memory_order_release);
 	}
+
+	_RetireReplaced();
+
+	// Keep slabs on hand for the audio thread to unpack into
+	if (_numPacked.load(std::memory_order_relaxed) > 0u)
+		BankPool::Instance().RefillReserve();
 }
 
 unsigned long BufferBank::Length() const
@@ -116,70 +237,173 @@ unsigned long BufferBank::Length() const
 
 unsigned long BufferBank::Capacity() const
 {
-	return _BufferBankSize * static_cast<unsigned long>(_numBanks.load(std::memory_order_acquire));
+	return static_cast<unsigned long>(_numBanks.load(std::memory_order_acquire)) << _bankShift;
 }
 
-float BufferBank::SubMin(unsigned long i1, unsigned long i2) const
+std::size_t BufferBank::AllocatedBytes() const
 {
-	auto length = Length();
+	auto numPacked = static_cast<std::size_t>(_numPacked.load(std::memory_order_relaxed));
+	auto numUnpacking = static_cast<std::size_t>(_numUnpacking.load(std::memory_order_relaxed));
+	auto numBanks = static_cast<std::size_t>(_numBanks.load(std::memory_order_acquire));
+	numPacked = std::min(numPacked, numBanks);
 
-	if (0 == length)
-		return 0.0f;
+	// Banks part way through unpacking hold both
+	return (sizeof(float) * BankSize() * (numBanks - numPacked)) + (_PackedBytes() * (numPacked + numUnpacking));
+}
 
-	i1 = i1 > 0 ? i1 : 0;
-	i1 = i1 < length ? i1 : length;
-	i2 = i2 < length ? i2 : length;
+BufferBank::SampleSummary BufferBank::SubSummary(unsigned long i1, unsigned long i2) const
+{
+	SampleSummary summary = { 0.0f, 0.0f, 0.0f };
 
-	if (i2 <= i1)
-		return 0.0f;
+	auto length = std::min(Length(), Capacity());
+	i1 = std::min(i1, length);
+	i2 = std::min(i2, length);
 
-	auto curMin = (*this)[i1];
-	for (auto i = i1; i < i2; i++)
+	auto isFirst = true;
+	while (i1 < i2)
 	{
-		if ((*this)[i] < curMin)
-			curMin = (*this)[i];
+		auto bank = i1 >> _bankShift;
+		auto offset = i1 & _bankMask;
+		auto end = std::min(i2 - (i1 - offset), BankSize());
+		auto bankSummary = _BankSummary(bank, offset, end);
+
+		if (isFirst)
+			summary = bankSummary;
+		else
+			_Accumulate(summary, bankSummary);
+
+		isFirst = false;
+		i1 += end - offset;
 	}
 
-	return curMin;
+	return summary;
 }
 
+float BufferBank::SubMin(unsigned long i1, unsigned long i2) const
+{
+	return SubSummary(i1, i2).Min;
+}
 
 float BufferBank::SubMax(unsigned long i1, unsigned long i2) const
 {
-	auto length = Length();
+	return SubSummary(i1, i2).Max;
+}
 
-	if (0 == length)
+float BufferBank::SubRms(unsigned long i1, unsigned long i2) const
+{
+	i2 = std::min(i2, std::min(Length(), Capacity()));
+	if (i2 <= i1)
 		return 0.0f;
 
-	i1 = i1 > 0 ? i1 : 0;
-	i1 = i1 < length ? i1 : length;
-	i2 = i2 < length ? i2 : length;
+	auto sumSq = SubSummary(i1, i2).SumSq;
+	return std::sqrt(std::max(sumSq, 0.0f) / static_cast<float>(i2 - i1));
+}
 
+bool BufferBank::IsSilent(unsigned long i1, unsigned long i2) const noexcept
+{
+	i2 = std::min(i2, std::min(Length(), Capacity()));
 	if (i2 <= i1)
-		return 0.0f;
+		return true;
 
-	auto curMax = (*this)[i1];
-	for (auto i = i1; i < i2; i++)
+	auto bankGrainShift = _bankShift - SummaryGrainShift;
+	auto grainMask = (1ul << bankGrainShift) - 1ul;
+	auto grain = i1 >> SummaryGrainShift;
+	auto endGrain = ((i2 - 1ul) >> SummaryGrainShift) + 1ul;
+
+	while (grain < endGrain)
 	{
-		if ((*this)[i]> curMax)
-			curMax = (*this)[i];
+		auto bank = grain >> bankGrainShift;
+		auto leaf = grain & grainMask;
+		auto bit = leaf & (GrainWordBits - 1ul);
+		auto numBits = std::min(GrainWordBits - bit, endGrain - grain);
+		auto mask = (numBits < GrainWordBits) ?
+			(((1ull << numBits) - 1ull) << bit) :
+			~0ull;
+
+		if (0ull != (_audibleGrains[bank][leaf >> GrainWordShift] & mask))
+			return false;
+
+		grain += numBits;
 	}
 
-	return curMax;
+	return true;
 }
 
-unsigned int BufferBank::NumBanksToHold(unsigned long length, bool includeCapacityAhead)
+void BufferBank::UpdateSummary(unsigned long index, unsigned long numSamps)
+{
+	auto capacity = Capacity();
+	if (index >= capacity)
+		return;
+
+	auto end = std::min(index + numSamps, capacity);
+	_MarkDirty(index, end);
+
+	_BeginTrackedWrite();
+
+	while (index < end)
+	{
+		auto bank = index >> _bankShift;
+		auto offset = index & _bankMask;
+		auto span = std::min(end - index, BankSize() - offset);
+
+		_UpdateBankSummary(bank, offset, span);
+		index += span;
+	}
+
+	_EndTrackedWrite();
+}
+
+BufferBank::SampleRange BufferBank::TakeDirtyRange() noexcept
+{
+	auto packed = _dirtyRange.exchange(DirtyNone, std::memory_order_acq_rel);
+
+	SampleRange range;
+	range.Start = static_cast<unsigned long>(packed >> 32);
+	range.End = static_cast<unsigned long>(packed & 0xFFFFFFFFull);
+
+	return range;
+}
+
+unsigned int BufferBank::NumBanksToHold(unsigned long length, bool includeCapacityAhead) const
 {
 	if (includeCapacityAhead)
 		length += _BufferCapacityAhead;
 
-	auto numBanks = 1ul + (length / (unsigned long)_BufferBankSize);
-	if ((length % (unsigned long)_BufferBankSize) == 0)
+	auto numBanks = 1ul + (length >> _bankShift);
+	if ((length & _bankMask) == 0)
 		return numBanks > 1 ? numBanks - 1 : 1u;
 
 	return numBanks;
 }
 
+void BufferBank::_ReleaseBanks() noexcept
+{
+	auto numBanks = _numBanks.load(std::memory_order_acquire);
+	_numBanks.store(0u, std::memory_order_release);
+	auto* packedBanks = _packedBanks.load(std::memory_order_acquire);
+
+	for (auto i = 0u; i < numBanks; i++)
+	{
+		BankPool::Instance().Release(std::unique_ptr<float[]>(_bufferBank[i].exchange(nullptr, std::memory_order_acquire)));
+		_summaries[i].reset();
+		_audibleGrains[i].reset();
+
+		if (nullptr == packedBanks)
+			continue;
+
+		// Nothing can be reading by now, so none of this needs retiring
+		BankPool::Instance().Release(std::unique_ptr<float[]>(packedBanks->RetiredSlabs[i].exchange(nullptr, std::memory_order_acquire)));
+		delete packedBanks->Packed[i].exchange(nullptr, std::memory_order_acquire);
+		delete packedBanks->Pending[i].exchange(nullptr, std::memory_order_acquire);
+		delete packedBanks->RetiredPacks[i].exchange(nullptr, std::memory_order_acquire);
+	}
+
+	_numPacked.store(0u, std::memory_order_relaxed);
+	_numUnpacking.store(0u, std::memory_order_relaxed);
+	_numPending.store(0u, std::memory_order_relaxed);
+	_numRetired.store(0u, std::memory_order_relaxed);
+}
+
 bool BufferBank::IsBlockContiguous(unsigned long index, unsigned int numSamps) const
 {
 	if (numSamps == 0)
@@ -188,8 +412,8 @@ bool BufferBank::IsBlockContiguous(unsigned long index, unsigned int numSamps) c
 	if (index + numSamps > Capacity())
 		return false;
 
-	auto startBank = index / _BufferBankSize;
-	auto endBank = (index + numSamps - 1) / _BufferBankSize;
+	auto startBank = index >> _bankShift;
+	auto endBank = (index + numSamps - 1) >> _bankShift;
 
 	return startBank == endBank;
 }
@@ -199,8 +423,595 @@ const float* BufferBank::BlockPtr(unsigned long index) const
 	if (index >= Capacity())
 		return nullptr;
 
-	auto bank = index / _BufferBankSize;
-	auto offset = index % _BufferBankSize;
+	const auto* samples = _WholeSlab(index >> _bankShift);
+
+	return (nullptr != samples) ? samples + (index & _bankMask) : nullptr;
+}
+
+float* BufferBank::BlockPtr(unsigned long index)
+{
+	if (index >= Capacity())
+		return nullptr;
+
+	// Only ever written through while loading, which owns the bank
+	auto* samples = const_cast<float*>(_WholeSlab(index >> _bankShift));
+
+	return (nullptr != samples) ? samples + (index & _bankMask) : nullptr;
+}
+
+void BufferBank::Read(unsigned long index, float* dest, unsigned int numSamps) const noexcept
+{
+	auto length = std::min(Length(), Capacity());
+	auto done = 0ul;
+
+	while (done < numSamps)
+	{
+		auto sampIndex = index + done;
+
+		if (sampIndex >= length)
+		{
+			std::fill(dest + done, dest + numSamps, 0.0f);
+			break;
+		}
+
+		auto offset = sampIndex & _bankMask;
+		auto span = std::min({ numSamps - done, BankSize() - offset, length - sampIndex });
+
+		_ReadBank(sampIndex >> _bankShift, offset, dest + done, span);
+		done += span;
+	}
+}
+
+void BufferBank::FadeMixBlock(unsigned long index,
+	const float* src,
+	unsigned int srcStride,
+	unsigned int numSamps,
+	float fadeCurrent,
+	float fadeNew,
+	const float* fadeRamp,
+	float fadeCurrentRamp)
+{
+	auto capacity = Capacity();
+
+	_BeginTrackedWrite();
+
+	while (numSamps > 0)
+	{
+		if (index >= capacity)
+		{
+			// Either past the end, or a negative write offset that wrapped.
+			// Skip to where the index wraps back to zero, if it does so
+			// within this block.
+			auto sampsToWrap = 0ul - index;
+			if ((0ul == sampsToWrap) || (sampsToWrap >= numSamps))
+				break;
+
+			src += static_cast<size_t>(sampsToWrap) * srcStride;
+			if (nullptr != fadeRamp)
+				fadeRamp += sampsToWrap;
+			numSamps -= static_cast<unsigned int>(sampsToWrap);
+			index = 0ul;
+			continue;
+		}
+
+		auto bank = index >> _bankShift;
+		auto offset = index & _bankMask;
+		auto sampsInBank = BankSize() - offset;
+		auto span = numSamps < sampsInBank ? numSamps : static_cast<unsigned int>(sampsInBank);
+
+		// A packed bank with no reserve slab to unpack into drops the
+		// write, as past Capacity()
+		auto* samples = _WritableBank(bank, offset, span);
+
+		if (nullptr == samples)
+		{
+			if (nullptr != fadeRamp)
+				fadeRamp += span;
+		}
+		else if (nullptr == fadeRamp)
+		{
+			FadeKernels::FadeMix(samples + offset, src, srcStride, span, fadeCurrent, fadeNew);
+		}
+		else
+		{
+			FadeKernels::FadeMixRamp(samples + offset, src, srcStride, span, fadeCurrent, fadeNew, fadeRamp, fadeCurrentRamp);
+			fadeRamp += span;
+		}
+
+		if (nullptr != samples)
+		{
+			_UpdateBankSummary(bank, offset, span);
+			_MarkDirty(index, index + span);
+		}
+
+		src += static_cast<size_t>(span) * srcStride;
+		numSamps -= span;
+		index += span;
+	}
+
+	_EndTrackedWrite();
+}
+
+unsigned int BufferBank::PackBanks()
+{
+	auto numBanks = std::min(_numBanks.load(std::memory_order_acquire), NumBanksToHold(Length(), false));
+	auto numGrains = BankSize() >> SummaryGrainShift;
+	auto numPosted = 0u;
+
+	// Only this thread creates it, so a plain release store publishes it
+	auto* packedBanks = _packedBanks.load(std::memory_order_acquire);
+	if (nullptr == packedBanks)
+	{
+		packedBanks = new (std::nothrow) PackedBanks();
+		if (nullptr == packedBanks)
+			return 0u;
+
+		_packedBanks.store(packedBanks, std::memory_order_release);
+	}
+
+	for (auto bank = 0u; bank < numBanks; bank++)
+	{
+		// The audio thread only swaps a bank out after it has been posted
+		// here, so the slab stays put while it is encoded. A bank that is
+		// still being unpacked is left alone, as its slab is incomplete.
+		const auto* samples = _WholeSlab(bank);
+		if ((nullptr == samples) || (nullptr != packedBanks->Pending[bank].load(std::memory_order_acquire)))
+			continue;
+
+		std::unique_ptr<PackedSlab> packed;
+		try
+		{
+			packed = std::make_unique<PackedSlab>();
+			packed->Samples = std::make_unique<std::int16_t[]>(BankSize());
+			packed->Scales = std::make_unique<float[]>(numGrains);
+			packed->Unpacked = std::make_unique<std::atomic<std::uint64_t>[]>(numGrains >> GrainWordShift);
+			packed->NumUnpacked = 0u;
+		}
+		catch (const std::bad_alloc&)
+		{
+			break;
+		}
+
+		// Taken mid-write it is odd, so never matches at commit
+		packed->WriteCount = _writeCount.load(std::memory_order_acquire);
+
+		for (auto grain = 0ul; grain < numGrains; grain++)
+		{
+			auto offset = grain << SummaryGrainShift;
+			packed->Scales[grain] = PackKernels::Pack(samples + offset,
+				static_cast<unsigned int>(SummaryGrain),
+				packed->Samples.get() + offset);
+		}
+
+		packedBanks->Pending[bank].store(packed.release(), std::memory_order_release);
+		_numPending.fetch_add(1u, std::memory_order_release);
+		numPosted++;
+	}
+
+	return numPosted;
+}
+
+unsigned int BufferBank::CommitPacked() noexcept
+{
+	if (0u == _numPending.load(std::memory_order_acquire))
+		return 0u;
+
+	// Published before anything was posted to it
+	auto* packedBanks = _packedBanks.load(std::memory_order_acquire);
+	if (nullptr == packedBanks)
+		return 0u;
+
+	auto numBanks = _numBanks.load(std::memory_order_acquire);
+	auto writeCount = _writeCount.load(std::memory_order_relaxed);
+	auto numCommitted = 0u;
+
+	for (auto bank = 0u; bank < numBanks; bank++)
+	{
+		auto* packed = packedBanks->Pending[bank].load(std::memory_order_acquire);
+		if (nullptr == packed)
+			continue;
+
+		// Leave it until the last swap of this bank has been cleared away
+		if ((nullptr != packedBanks->RetiredSlabs[bank].load(std::memory_order_relaxed)) ||
+			(nullptr != packedBanks->RetiredPacks[bank].load(std::memory_order_relaxed)))
+			continue;
+
+		packedBanks->Pending[bank].store(nullptr, std::memory_order_relaxed);
+		_numPending.fetch_sub(1u, std::memory_order_relaxed);
+		_numRetired.fetch_add(1u, std::memory_order_relaxed);
+
+		if (packed->WriteCount != writeCount)
+		{
+			// Written while it was being encoded
+			packedBanks->RetiredPacks[bank].store(packed, std::memory_order_release);
+			continue;
+		}
+
+		auto* samples = _bufferBank[bank].load(std::memory_order_relaxed);
+		packedBanks->Packed[bank].store(packed, std::memory_order_release);
+		_bufferBank[bank].store(nullptr, std::memory_order_release);
+		packedBanks->RetiredSlabs[bank].store(samples, std::memory_order_release);
+		_numPacked.fetch_add(1u, std::memory_order_relaxed);
+		numCommitted++;
+	}
+
+	return numCommitted;
+}
+
+unsigned int BufferBank::NumPackedBanks() const noexcept
+{
+	return _numPacked.load(std::memory_order_relaxed);
+}
+
+void BufferBank::_ReadBank(unsigned long bank,
+	unsigned long offset,
+	float* dest,
+	unsigned long numSamps) const noexcept
+{
+	const auto* samples = _bufferBank[bank].load(std::memory_order_acquire);
+	const auto* packedBanks = _packedBanks.load(std::memory_order_acquire);
+	const auto* packed = (nullptr != packedBanks) ?
+		packedBanks->Packed[bank].load(std::memory_order_acquire) :
+		nullptr;
 
-	return &_bufferBank[bank][offset];
+	if (nullptr == packed)
+	{
+		// Finished unpacking between the two loads, and the slab went in first
+		if (nullptr == samples)
+			samples = _bufferBank[bank].load(std::memory_order_acquire);
+
+		if (nullptr == samples)
+			std::fill_n(dest, numSamps, 0.0f);
+		else
+			std::copy_n(samples + offset, numSamps, dest);
+
+		return;
+	}
+
+	if (nullptr == samples)
+	{
+		_UnpackRange(*packed, offset, dest, numSamps);
+		return;
+	}
+
+	// Part way through unpacking, so only the grains already written are
+	// in the slab
+	auto end = offset + numSamps;
+	while (offset < end)
+	{
+		auto grain = offset >> SummaryGrainShift;
+		auto span = std::min(end, (grain + 1ul) << SummaryGrainShift) - offset;
+		auto bit = 1ull << (grain & (GrainWordBits - 1ul));
+
+		if (0ull != (packed->Unpacked[grain >> GrainWordShift].load(std::memory_order_acquire) & bit))
+			std::copy_n(samples + offset, span, dest);
+		else
+			_UnpackRange(*packed, offset, dest, span);
+
+		dest += span;
+		offset += span;
+	}
+}
+
+BufferBank::SampleSummary BufferBank::_ScanBank(unsigned long bank,
+	unsigned long offset,
+	unsigned long numSamps) const noexcept
+{
+	const auto* samples = _WholeSlab(bank);
+	if (nullptr != samples)
+		return _ScanSummary(samples + offset, numSamps);
+
+	// Only ever called for the partial grains at either end of a range
+	float unpacked[2ul * SummaryGrain];
+	_ReadBank(bank, offset, unpacked, std::min(numSamps, 2ul * SummaryGrain));
+
+	return _ScanSummary(unpacked, std::min(numSamps, 2ul * SummaryGrain));
+}
+
+const float* BufferBank::_WholeSlab(unsigned long bank) const noexcept
+{
+	const auto* samples = _bufferBank[bank].load(std::memory_order_acquire);
+	const auto* packedBanks = _packedBanks.load(std::memory_order_acquire);
+
+	if ((nullptr != packedBanks) && (nullptr != packedBanks->Packed[bank].load(std::memory_order_acquire)))
+		return nullptr;
+
+	return samples;
+}
+
+float* BufferBank::_WritableBank(unsigned long bank,
+	unsigned long offset,
+	unsigned long numSamps) noexcept
+{
+	auto* samples = _bufferBank[bank].load(std::memory_order_acquire);
+	auto* packedBanks = _packedBanks.load(std::memory_order_acquire);
+	if (nullptr == packedBanks)
+		return samples;
+
+	auto* packed = packedBanks->Packed[bank].load(std::memory_order_acquire);
+	if (nullptr == packed)
+		return samples;
+
+	if (nullptr == samples)
+	{
+		auto slab = BankPool::Instance().TakeReserved();
+		if (!slab)
+			return nullptr;
+
+		samples = slab.release();
+		_bufferBank[bank].store(samples, std::memory_order_release);
+		_numPacked.fetch_sub(1u, std::memory_order_relaxed);
+		_numUnpacking.fetch_add(1u, std::memory_order_relaxed);
+	}
+
+	// Only the grains this write touches, so the cost follows the block
+	// size rather than the bank size
+	auto numGrains = static_cast<unsigned int>(BankSize() >> SummaryGrainShift);
+	auto first = offset >> SummaryGrainShift;
+	auto last = (offset + std::max(numSamps, 1ul) - 1ul) >> SummaryGrainShift;
+
+	for (auto grain = first; grain <= last; grain++)
+	{
+		auto& word = packed->Unpacked[grain >> GrainWordShift];
+		auto bit = 1ull << (grain & (GrainWordBits - 1ul));
+		if (0ull != (word.load(std::memory_order_relaxed) & bit))
+			continue;
+
+		auto start = grain << SummaryGrainShift;
+		_UnpackRange(*packed, start, samples + start, SummaryGrain);
+		word.fetch_or(bit, std::memory_order_release);
+		packed->NumUnpacked++;
+	}
+
+	// Once every grain is in the slab the pack can go, unless the last
+	// one retired from this bank is still waiting to be cleared away
+	if ((numGrains == packed->NumUnpacked) &&
+		(nullptr == packedBanks->RetiredPacks[bank].load(std::memory_order_relaxed)))
+	{
+		packedBanks->Packed[bank].store(nullptr, std::memory_order_release);
+		_numRetired.fetch_add(1u, std::memory_order_relaxed);
+		packedBanks->RetiredPacks[bank].store(packed, std::memory_order_release);
+		_numUnpacking.fetch_sub(1u, std::memory_order_relaxed);
+	}
+
+	return samples;
+}
+
+void BufferBank::_RetireReplaced()
+{
+	if (0u == _numRetired.load(std::memory_order_acquire))
+		return;
+
+	auto* packedBanks = _packedBanks.load(std::memory_order_acquire);
+	if (nullptr == packedBanks)
+		return;
+
+	auto numBanks = _numBanks.load(std::memory_order_acquire);
+
+	for (auto bank = 0u; bank < numBanks; bank++)
+	{
+		auto* samples = packedBanks->RetiredSlabs[bank].exchange(nullptr, std::memory_order_acquire);
+		if (nullptr != samples)
+		{
+			EpochDomain::Instance().Retire(std::shared_ptr<const void>(samples, [](float* slab) {
+				BankPool::Instance().Release(std::unique_ptr<float[]>(slab));
+			}));
+			_numRetired.fetch_sub(1u, std::memory_order_relaxed);
+		}
+
+		auto* packed = packedBanks->RetiredPacks[bank].exchange(nullptr, std::memory_order_acquire);
+		if (nullptr != packed)
+		{
+			EpochDomain::Instance().Retire(std::shared_ptr<const void>(packed, [](PackedSlab* slab) {
+				delete slab;
+			}));
+			_numRetired.fetch_sub(1u, std::memory_order_relaxed);
+		}
+	}
+}
+
+std::size_t BufferBank::_PackedBytes() const noexcept
+{
+	return (sizeof(std::int16_t) * BankSize()) + (sizeof(float) * (BankSize() >> SummaryGrainShift));
+}
+
+void BufferBank::_UnpackRange(const PackedSlab& packed,
+	unsigned long offset,
+	float* dest,
+	unsigned long numSamps) noexcept
+{
+	auto end = offset + numSamps;
+
+	while (offset < end)
+	{
+		auto grainEnd = ((offset >> SummaryGrainShift) + 1ul) << SummaryGrainShift;
+		auto span = std::min(end, grainEnd) - offset;
+
+		PackKernels::Unpack(packed.Samples.get() + offset,
+			packed.Scales[offset >> SummaryGrainShift],
+			static_cast<unsigned int>(span),
+			dest);
+
+		dest += span;
+		offset += span;
+	}
+}
+
+void BufferBank::_InitSummaryLayout() noexcept
+{
+	auto numNodes = 1u << (_bankShift - SummaryGrainShift);
+	auto offset = 0u;
+
+	_numSummaryLevels = 0u;
+	while (true)
+	{
+		_summaryLevelOffsets[_numSummaryLevels] = offset;
+		offset += numNodes;
+		_numSummaryLevels++;
+
+		if (numNodes <= 1u)
+			break;
+
+		numNodes = (numNodes + SummaryFanout - 1u) >> SummaryFanoutShift;
+	}
+
+	_summaryLevelOffsets[_numSummaryLevels] = offset;
+}
+
+void BufferBank::_UpdateBankSummary(unsigned long bank,
+	unsigned long offset,
+	unsigned long numSamps) noexcept
+{
+	if (0ul == numSamps)
+		return;
+
+	const auto* samples = _bufferBank[bank].load(std::memory_order_acquire);
+	if (nullptr == samples)
+		return;
+
+	auto* summary = _summaries[bank].get();
+	auto* audibleGrains = _audibleGrains[bank].get();
+
+	// Leaves are rebuilt from scratch, since overdub can shrink as well as
+	// grow a grain's extent
+	auto first = static_cast<unsigned int>(offset >> SummaryGrainShift);
+	auto last = static_cast<unsigned int>((offset + numSamps - 1ul) >> SummaryGrainShift);
+
+	for (auto leaf = first; leaf <= last; leaf++)
+	{
+		auto& leafSummary = summary[leaf];
+		leafSummary = _ScanSummary(samples + (static_cast<unsigned long>(leaf) << SummaryGrainShift), SummaryGrain);
+
+		auto isAudible = (leafSummary.Max > SilenceThreshold) || (leafSummary.Min < -SilenceThreshold);
+		auto& word = audibleGrains[leaf >> GrainWordShift];
+		auto bit = 1ull << (leaf & (GrainWordBits - 1ul));
+		word = isAudible ? (word | bit) : (word & ~bit);
+	}
+
+	for (auto level = 1u; level < _numSummaryLevels; level++)
+	{
+		const auto* children = summary + _summaryLevelOffsets[level - 1u];
+		auto numChildren = _summaryLevelOffsets[level] - _summaryLevelOffsets[level - 1u];
+		auto* nodes = summary + _summaryLevelOffsets[level];
+
+		first >>= SummaryFanoutShift;
+		last >>= SummaryFanoutShift;
+
+		for (auto node = first; node <= last; node++)
+		{
+			auto child = node << SummaryFanoutShift;
+			auto childEnd = std::min(child + SummaryFanout, numChildren);
+
+			auto combined = children[child];
+			for (child++; child < childEnd; child++)
+				_Accumulate(combined, children[child]);
+
+			nodes[node] = combined;
+		}
+	}
+
+}
+
+BufferBank::SampleSummary BufferBank::_BankSummary(unsigned long bank,
+	unsigned long start,
+	unsigned long end) const noexcept
+{
+	const auto* summary = _summaries[bank].get();
+
+	auto firstLeaf = (start + SummaryGrain - 1ul) >> SummaryGrainShift;
+	auto endLeaf = end >> SummaryGrainShift;
+
+	// Nothing but partial grains
+	if (firstLeaf >= endLeaf)
+		return _ScanBank(bank, start, end - start);
+
+	auto hasResult = false;
+	SampleSummary result = { 0.0f, 0.0f, 0.0f };
+	auto add = [&result, &hasResult](const SampleSummary& summary) {
+		if (hasResult)
+			_Accumulate(result, summary);
+		else
+			result = summary;
+
+		hasResult = true;
+	};
+
+	auto leadStart = firstLeaf << SummaryGrainShift;
+	auto tailStart = endLeaf << SummaryGrainShift;
+
+	if (start < leadStart)
+		add(_ScanBank(bank, start, leadStart - start));
+	if (tailStart < end)
+		add(_ScanBank(bank, tailStart, end - tailStart));
+
+	// Whole grains, bottom-up: peel unaligned nodes off each end, then move
+	// up a level
+	auto a = static_cast<unsigned int>(firstLeaf);
+	auto b = static_cast<unsigned int>(endLeaf);
+	for (auto level = 0u; (level < _numSummaryLevels) && (a < b); level++)
+	{
+		const auto* nodes = summary + _summaryLevelOffsets[level];
+		auto isTop = (level + 1u) == _numSummaryLevels;
+
+		while ((a < b) && (isTop || (0u != (a & (SummaryFanout - 1u)))))
+			add(nodes[a++]);
+		while ((a < b) && (0u != (b & (SummaryFanout - 1u))))
+			add(nodes[--b]);
+
+		a >>= SummaryFanoutShift;
+		b >>= SummaryFanoutShift;
+	}
+
+	return result;
+}
+
+void BufferBank::_BeginTrackedWrite() noexcept
+{
+	// Odd while the write is in progress. The fence keeps the samples
+	// from being written before a reader can see the odd count.
+	_writeCount.fetch_add(1u, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+}
+
+void BufferBank::_EndTrackedWrite() noexcept
+{
+	// Even again, after the samples and summary
+	_writeCount.fetch_add(1u, std::memory_order_release);
+}
+
+void BufferBank::_MarkDirty(unsigned long start, unsigned long end) noexcept
+{
+	auto current = _dirtyRange.load(std::memory_order_relaxed);
+	while (true)
+	{
+		auto curStart = static_cast<unsigned long>(current >> 32);
+		auto curEnd = static_cast<unsigned long>(current & 0xFFFFFFFFull);
+		auto packed = PackRange(std::min(curStart, start), std::max(curEnd, end));
+
+		if ((packed == current) ||
+			_dirtyRange.compare_exchange_weak(current, packed, std::memory_order_release, std::memory_order_relaxed))
+			return;
+	}
+}
+
+BufferBank::SampleSummary BufferBank::_ScanSummary(const float* samples, unsigned long numSamps) noexcept
+{
+	SampleSummary summary = { samples[0], samples[0], 0.0f };
+
+	for (auto i = 0ul; i < numSamps; i++)
+	{
+		auto samp = samples[i];
+		summary.Min = samp < summary.Min ? samp : summary.Min;
+		summary.Max = samp > summary.Max ? samp : summary.Max;
+		summary.SumSq += samp * samp;
+	}
+
+	return summary;
+}
+
+void BufferBank::_Accumulate(SampleSummary& summary, const SampleSummary& other) noexcept
+{
+	summary.Min = other.Min < summary.Min ? other.Min : summary.Min;
+	summary.Max = other.Max > summary.Max ? other.Max : summary.Max;
+	summary.SumSq += other.SumSq;
 }
@@ -2,14 +2,67 @@
 
 #include <array>
 #include <atomic>
+#include <cstdint>
 #include <memory>
 #include <vector>
+#include "BankPool.h"
 #include "../include/Constants.h"
 
 namespace audio
 {
+	// Growable sample store made of fixed-size slabs from the shared
+	// BankPool. The slab size is fixed for the lifetime of the bank (taken
+	// from the pool on construction), and is always a power of two.
+	//
+	// Each slab carries a min/max/sum-of-squares pyramid: one leaf per
+	// SummaryGrain samples, then one node per SummaryFanout children up to
+	// a single root per slab. FadeMixBlock keeps it current as it writes,
+	// so SubMin/SubMax/SubRms only scan the partial grains at either end of
+	// a range. Writes through operator[] are not tracked; follow them with
+	// UpdateSummary().
+	//
+	// Alongside the pyramid, each slab keeps a silence map of one bit per
+	// grain, set when any sample in the grain exceeds SilenceThreshold.
+	// IsSilent() tests a range a word of grains at a time.
+	//
+	// Banks of a loop that has gone idle can be packed to 16 bits with one
+	// scale per grain (see PackKernels), about half the memory of a slab.
+	// PackBanks() encodes on a background thread and CommitPacked() swaps
+	// the packed banks in on the audio thread, dropping them if anything
+	// was written meanwhile. Reads decode on the fly, and the summaries are
+	// kept as they were. Writing to a packed bank takes a slab from the
+	// pool's reserve and unpacks just the grains the write touches, so
+	// overdubbing undoes the packing a grain at a time without leaving the
+	// audio thread. Until every grain has been written, reads take the
+	// rest from the pack. Replaced slabs are handed to the
+	// EpochDomain by UpdateCapacity(), so readers off the audio thread must
+	// hold an EpochReadGuard.
 	class BufferBank
 	{
+	public:
+		struct SampleSummary
+		{
+			float Min;
+			float Max;
+			float SumSq;
+		};
+
+		// Half-open range of sample indices, empty when End <= Start.
+		struct SampleRange
+		{
+			unsigned long Start;
+			unsigned long End;
+
+			bool IsEmpty() const noexcept { return End <= Start; }
+		};
+
+		static constexpr unsigned int SummaryGrainShift = 8u;
+		static constexpr unsigned long SummaryGrain = 1ul << SummaryGrainShift;
+		static constexpr unsigned int SummaryFanoutShift = 3u;
+		static constexpr unsigned int SummaryFanout = 1u << SummaryFanoutShift;
+		// About -100 dBFS
+		static constexpr float SilenceThreshold = 1.0e-5f;
+
 	public:
 		BufferBank();
 		~BufferBank();
@@ -24,7 +77,9 @@ namespace audio
 		}
 
 	public:
-		const float& operator[] (unsigned long index) const;
+		float operator[] (unsigned long index) const;
+		// Unpacks a packed bank first, as FadeMixBlock() does. Without a
+		// reserve slab to unpack into, the index gives a dummy sample.
 		float& operator[] (unsigned long index);
 
 		void Init();
@@ -32,32 +87,156 @@ namespace audio
 		// Length() will never exceed Capacity(). UpdateCapacity() (via Loop::Update()) must be
 		// called off-thread to grow capacity and allow SetLength to advance further.
 		void SetLength(unsigned long length);
-		// Off-thread only: updates logical length and allocates buffer banks as needed.
-		// Do NOT call from the audio callback — performs heap allocation.
+		// Off-thread only: updates logical length and acquires buffer banks as needed.
+		// Do NOT call from the audio callback — takes the pool lock and may allocate
+		// until the pool is warm.
 		void Resize(unsigned long length);
 		void UpdateCapacity();
 		unsigned long Length() const;
 		unsigned long Capacity() const;
+		unsigned long BankSize() const noexcept { return 1ul << _bankShift; }
+		// A seqlock count over tracked writes: odd while FadeMixBlock() or
+		// UpdateSummary() is running, even otherwise. A reader off the audio
+		// thread has a clean copy when the count was even before it read and
+		// unchanged after (behind an acquire fence). Writes through
+		// operator[] count only from their UpdateSummary().
+		std::uint32_t WriteCount() const noexcept { return _writeCount.load(std::memory_order_acquire); }
+		// Bytes of pool slabs and packed banks held by this bank.
+		std::size_t AllocatedBytes() const;
+		// Range queries over [i1, i2), clamped to Length(). An empty range
+		// gives zero.
+		SampleSummary SubSummary(unsigned long i1, unsigned long i2) const;
 		float SubMin(unsigned long i1, unsigned long i2) const;
 		float SubMax(unsigned long i1, unsigned long i2) const;
+		float SubRms(unsigned long i1, unsigned long i2) const;
+		// Audio-callback safe: true when no grain overlapping [i1, i2) holds
+		// a sample above SilenceThreshold. Samples past Length() are silent.
+		bool IsSilent(unsigned long i1, unsigned long i2) const noexcept;
+		// Audio-callback safe: rebuilds the summary over [index, index + numSamps)
+		// after samples were written through operator[].
+		void UpdateSummary(unsigned long index, unsigned long numSamps);
+		// Samples written since the last call (union of all writes). Meant
+		// for a single consumer, i.e. the loop's visual model.
+		SampleRange TakeDirtyRange() noexcept;
 		bool IsBlockContiguous(unsigned long index, unsigned int numSamps) const;
+		// nullptr past Capacity() or in a bank that is packed, wholly or in
+		// part.
 		const float* BlockPtr(unsigned long index) const;
+		float* BlockPtr(unsigned long index);
+		// Audio-callback safe: copies [index, index + numSamps) into dest,
+		// unpacking as needed. Samples past Length() read as zero.
+		void Read(unsigned long index, float* dest, unsigned int numSamps) const noexcept;
+		// Audio-callback safe: dest = fadeNew * src + fadeCurrent * dest over
+		// [index, index + numSamps). Bank boundaries are resolved once per
+		// contiguous span rather than per sample. Samples beyond Capacity()
+		// are dropped, as with operator[].
+		void FadeMixBlock(unsigned long index,
+			const float* src,
+			unsigned int srcStride,
+			unsigned int numSamps,
+			float fadeCurrent,
+			float fadeNew)
+		{
+			FadeMixBlock(index, src, srcStride, numSamps, fadeCurrent, fadeNew, nullptr, 0.0f);
+		}
+		// As above, with an optional per-sample fade ramp (see FadeKernels).
+		void FadeMixBlock(unsigned long index,
+			const float* src,
+			unsigned int srcStride,
+			unsigned int numSamps,
+			float fadeCurrent,
+			float fadeNew,
+			const float* fadeRamp,
+			float fadeCurrentRamp);
+
+		// Packs every unpacked bank up to Length() that has nothing waiting
+		// to be committed, and returns how many were packed. Off-thread,
+		// and one thread at a time.
+		unsigned int PackBanks();
+		// Audio-callback safe: swaps in the banks PackBanks() has finished,
+		// unless the bank was written since, and returns how many.
+		unsigned int CommitPacked() noexcept;
+		unsigned int NumPackedBanks() const noexcept;
 
 	protected:
-		static unsigned int NumBanksToHold(unsigned long length, bool includeCapacityAhead);
+		struct PackedSlab
+		{
+			std::unique_ptr<std::int16_t[]> Samples;
+			// One per SummaryGrain
+			std::unique_ptr<float[]> Scales;
+			// _writeCount when it was encoded
+			std::uint32_t WriteCount;
+			// One bit per grain, set once the audio thread has unpacked the
+			// grain into the bank's slab
+			std::unique_ptr<std::atomic<std::uint64_t>[]> Unpacked;
+			// Audio thread only
+			unsigned int NumUnpacked;
+		};
+
+		// Created by the first PackBanks() and published through
+		// _packedBanks, so readers must check it for null. Each bank is held
+		// as a slab, packed, or both while it is being unpacked, never
+		// neither; a swap publishes the new form before clearing the old one.
+		struct PackedBanks;
+
+		unsigned int NumBanksToHold(unsigned long length, bool includeCapacityAhead) const;
+		void _ReleaseBanks() noexcept;
+		void _InitSummaryLayout() noexcept;
+		void _UpdateBankSummary(unsigned long bank, unsigned long offset, unsigned long numSamps) noexcept;
+		SampleSummary _BankSummary(unsigned long bank, unsigned long start, unsigned long end) const noexcept;
+		void _BeginTrackedWrite() noexcept;
+		void _EndTrackedWrite() noexcept;
+		void _MarkDirty(unsigned long start, unsigned long end) noexcept;
+		void _ReadBank(unsigned long bank, unsigned long offset, float* dest, unsigned long numSamps) const noexcept;
+		SampleSummary _ScanBank(unsigned long bank, unsigned long offset, unsigned long numSamps) const noexcept;
+		const float* _WholeSlab(unsigned long bank) const noexcept;
+		float* _WritableBank(unsigned long bank, unsigned long offset, unsigned long numSamps) noexcept;
+		void _RetireReplaced();
+		std::size_t _PackedBytes() const noexcept;
+
+		static void _UnpackRange(const PackedSlab& packed, unsigned long offset, float* dest, unsigned long numSamps) noexcept;
+
+		static SampleSummary _ScanSummary(const float* samples, unsigned long numSamps) noexcept;
+		static void _Accumulate(SampleSummary& summary, const SampleSummary& other) noexcept;
 	
 	public:
-		static constexpr unsigned long _BufferBankSize = 1000000ul;
-		static constexpr unsigned long _BufferCapacityAhead = 500000ul;
+		// Headroom kept ahead of Length() so recording can run between
+		// UpdateCapacity() calls.
+		static constexpr unsigned long _BufferCapacityAhead = 262144ul;
 		static constexpr unsigned int _MaxBanks =
 			static_cast<unsigned int>(
-				(constants::MaxLoopBufferSize + _BufferCapacityAhead + _BufferBankSize - 1ul) /
-				_BufferBankSize);
+				(constants::MaxLoopBufferSize + _BufferCapacityAhead + (1ul << BankPool::MinSlabShift) - 1ul) >>
+				BankPool::MinSlabShift);
+
+		static constexpr unsigned int _MaxSummaryLevels =
+			1u + ((BankPool::MaxSlabShift - SummaryGrainShift + SummaryFanoutShift - 1u) / SummaryFanoutShift);
 
 	protected:
 		float _dummy;
+		unsigned int _bankShift;
+		unsigned long _bankMask;
 		std::atomic<unsigned long> _length;
 		std::atomic<unsigned int> _numBanks;
-		std::array<std::unique_ptr<float[]>, _MaxBanks> _bufferBank;
+		// Pool slabs, owned here; nullptr while the bank is packed
+		std::array<std::atomic<float*>, _MaxBanks> _bufferBank;
+		unsigned int _numSummaryLevels;
+		// Node offset of each pyramid level within a slab's summary; the
+		// last used entry is the total node count.
+		std::array<unsigned int, _MaxSummaryLevels + 1u> _summaryLevelOffsets;
+		std::array<std::unique_ptr<SampleSummary[]>, _MaxBanks> _summaries;
+		// One bit per grain, set when the grain is audible
+		std::array<std::unique_ptr<std::uint64_t[]>, _MaxBanks> _audibleGrains;
+		// Start in the high word, end in the low word
+		std::atomic<std::uint64_t> _dirtyRange;
+		// Odd while a tracked write is in progress
+		std::atomic<std::uint32_t> _writeCount;
+		// Owned here
+		std::atomic<PackedBanks*> _packedBanks;
+		// Banks held only packed
+		std::atomic<unsigned int> _numPacked;
+		// Banks held as both a slab and a pack
+		std::atomic<unsigned int> _numUnpacking;
+		std::atomic<unsigned int> _numPending;
+		std::atomic<unsigned int> _numRetired;
 	};
 }
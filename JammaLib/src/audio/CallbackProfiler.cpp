@@ -0,0 +1,426 @@
+#include "CallbackProfiler.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+using namespace audio;
+
+thread_local CallbackProfiler::ThreadRecorder CallbackProfiler::_threadRecorder;
+
+CallbackProfiler::ThreadRecorder::~ThreadRecorder()
+{
+	CallbackProfiler::Instance()._ReleaseSlot(Slot);
+}
+
+CallbackProfiler::CallbackProfiler() :
+	_isEnabled(false),
+	_slots(),
+	_numSamps(0u),
+	_sampleRate(0u),
+	_numDropped(0u),
+	_reportMutex(),
+	_baseline(),
+	_csvMutex(),
+	_csv(),
+	_csvInterval(1000),
+	_csvLastTime(),
+	_csvStartTime(),
+	_csvLast()
+{
+	for (auto& slot : _slots)
+	{
+		for (auto& stage : slot.Stages)
+		{
+			for (auto& bucket : stage.Buckets)
+				bucket.store(0u, std::memory_order_relaxed);
+
+			stage.TotalNs.store(0u, std::memory_order_relaxed);
+			stage.MaxNs.store(0u, std::memory_order_relaxed);
+		}
+
+		for (auto& counter : slot.Counters)
+			counter.store(0u, std::memory_order_relaxed);
+
+		slot.IsClaimed.store(false, std::memory_order_relaxed);
+	}
+}
+
+CallbackProfiler::~CallbackProfiler()
+{
+	StopCsv();
+}
+
+CallbackProfiler& CallbackProfiler::Instance()
+{
+	static CallbackProfiler profiler;
+	return profiler;
+}
+
+const char* CallbackProfiler::StageName(Stage stage) noexcept
+{
+	switch (stage)
+	{
+	case STAGE_CALLBACK:
+		return "callback";
+	case STAGE_TICK:
+		return "tick";
+	case STAGE_BOUNCE:
+		return "bounce";
+	case STAGE_STATION:
+		return "station";
+	case STAGE_VST:
+		return "vst";
+	case STAGE_TAKE:
+		return "take";
+	case STAGE_LOOP:
+		return "loop";
+	case STAGE_NINJAM:
+		return "ninjam";
+	default:
+		return "unknown";
+	}
+}
+
+const char* CallbackProfiler::CounterName(Counter counter) noexcept
+{
+	switch (counter)
+	{
+	case COUNTER_SILENT_LOOP_BLOCKS:
+		return "silent loop blocks skipped";
+	case COUNTER_PREFETCH_MISSES:
+		return "stream prefetch misses";
+	default:
+		return "unknown";
+	}
+}
+
+unsigned int CallbackProfiler::BucketIndex(std::uint64_t ns) noexcept
+{
+	if (ns < SubBuckets)
+		return static_cast<unsigned int>(ns);
+
+	auto exponent = static_cast<unsigned int>(std::bit_width(ns)) - 1u;
+	if (exponent > MaxExponent)
+		return NumBuckets - 1u;
+
+	auto sub = static_cast<unsigned int>(ns >> (exponent - SubBucketBits)) & (SubBuckets - 1u);
+	return SubBuckets + ((exponent - SubBucketBits) * SubBuckets) + sub;
+}
+
+std::uint64_t CallbackProfiler::BucketUpperNs(unsigned int bucket) noexcept
+{
+	if (bucket < SubBuckets)
+		return bucket;
+
+	bucket = std::min(bucket, NumBuckets - 1u);
+	auto exponent = ((bucket - SubBuckets) / SubBuckets) + SubBucketBits;
+	auto sub = static_cast<std::uint64_t>((bucket - SubBuckets) % SubBuckets);
+	auto width = 1ull << (exponent - SubBucketBits);
+
+	return (1ull << exponent) + (sub * width) + width - 1ull;
+}
+
+std::uint64_t CallbackProfiler::Percentile(const StageCapture& stage, double fraction) noexcept
+{
+	if (0u == stage.Count)
+		return 0u;
+
+	auto rank = static_cast<std::uint64_t>(std::ceil(fraction * static_cast<double>(stage.Count)));
+	rank = std::clamp(rank, static_cast<std::uint64_t>(1u), stage.Count);
+
+	auto numSeen = 0ull;
+	for (auto bucket = 0u; bucket < NumBuckets; bucket++)
+	{
+		numSeen += stage.Buckets[bucket];
+		if (numSeen >= rank)
+			return std::min(BucketUpperNs(bucket), stage.MaxNs);
+	}
+
+	return stage.MaxNs;
+}
+
+CallbackProfiler::Capture CallbackProfiler::Capture::Since(const Capture& earlier) const
+{
+	Capture interval;
+	interval.NumSamps = NumSamps - std::min(NumSamps, earlier.NumSamps);
+	interval.SampleRate = SampleRate;
+
+	for (auto s = 0u; s < NUM_STAGES; s++)
+	{
+		const auto& later = Stages[s];
+		const auto& before = earlier.Stages[s];
+		auto& stage = interval.Stages[s];
+
+		auto highestBucket = -1;
+		for (auto bucket = 0u; bucket < NumBuckets; bucket++)
+		{
+			stage.Buckets[bucket] = later.Buckets[bucket] - std::min(later.Buckets[bucket], before.Buckets[bucket]);
+			stage.Count += stage.Buckets[bucket];
+
+			if (stage.Buckets[bucket] > 0u)
+				highestBucket = static_cast<int>(bucket);
+		}
+
+		stage.TotalNs = later.TotalNs - std::min(later.TotalNs, before.TotalNs);
+		stage.MaxNs = (highestBucket < 0) ? 0u :
+			std::min(later.MaxNs, BucketUpperNs(static_cast<unsigned int>(highestBucket)));
+	}
+
+	for (auto c = 0u; c < NUM_COUNTERS; c++)
+		interval.Counters[c] = Counters[c] - std::min(Counters[c], earlier.Counters[c]);
+
+	return interval;
+}
+
+std::vector<CallbackProfiler::StageStats> CallbackProfiler::Summarise(const Capture& capture)
+{
+	const auto budgetNs = (capture.SampleRate > 0u) ?
+		static_cast<double>(capture.NumSamps) * 1.0e9 / static_cast<double>(capture.SampleRate) :
+		0.0;
+
+	std::vector<StageStats> summary;
+	summary.reserve(NUM_STAGES);
+
+	for (auto s = 0u; s < NUM_STAGES; s++)
+	{
+		const auto& stage = capture.Stages[s];
+
+		StageStats stats;
+		stats.StageId = static_cast<Stage>(s);
+		stats.Count = stage.Count;
+		stats.P50Us = static_cast<double>(Percentile(stage, 0.5)) / 1000.0;
+		stats.P99Us = static_cast<double>(Percentile(stage, 0.99)) / 1000.0;
+		stats.MaxUs = static_cast<double>(stage.MaxNs) / 1000.0;
+		stats.MeanUs = (stage.Count > 0u) ?
+			static_cast<double>(stage.TotalNs) / static_cast<double>(stage.Count) / 1000.0 :
+			0.0;
+		stats.BudgetPercent = (budgetNs > 0.0) ?
+			100.0 * static_cast<double>(stage.TotalNs) / budgetNs :
+			0.0;
+
+		summary.push_back(stats);
+	}
+
+	return summary;
+}
+
+std::string CallbackProfiler::FormatStats(const StageStats& stats)
+{
+	std::stringstream ss;
+	ss << std::left << std::setw(9) << StageName(stats.StageId)
+		<< std::right << std::fixed << std::setprecision(1)
+		<< " n=" << std::setw(9) << stats.Count
+		<< "  p50 " << std::setw(8) << stats.P50Us << "us"
+		<< "  p99 " << std::setw(8) << stats.P99Us << "us"
+		<< "  max " << std::setw(8) << stats.MaxUs << "us"
+		<< "  budget " << std::setw(5) << stats.BudgetPercent << "%";
+
+	return ss.str();
+}
+
+void CallbackProfiler::SetEnabled(bool isEnabled) noexcept
+{
+	_isEnabled.store(isEnabled, std::memory_order_relaxed);
+}
+
+void CallbackProfiler::Record(Stage stage, std::uint64_t ns) noexcept
+{
+	auto slot = _ThreadSlot();
+	if ((slot < 0) || (stage >= NUM_STAGES))
+	{
+		_numDropped.fetch_add(1u, std::memory_order_relaxed);
+		return;
+	}
+
+	// Only this thread writes to its slot, so plain load/store pairs suffice
+	auto& histogram = _slots[slot].Stages[stage];
+	auto& bucket = histogram.Buckets[BucketIndex(ns)];
+	bucket.store(bucket.load(std::memory_order_relaxed) + 1u, std::memory_order_relaxed);
+	histogram.TotalNs.store(histogram.TotalNs.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+
+	if (ns > histogram.MaxNs.load(std::memory_order_relaxed))
+		histogram.MaxNs.store(ns, std::memory_order_relaxed);
+}
+
+void CallbackProfiler::RecordBlock(unsigned int numSamps, unsigned int sampleRate) noexcept
+{
+	if (!IsEnabled())
+		return;
+
+	_numSamps.fetch_add(numSamps, std::memory_order_relaxed);
+	_sampleRate.store(sampleRate, std::memory_order_relaxed);
+}
+
+void CallbackProfiler::Count(Counter counter) noexcept
+{
+	if (!IsEnabled())
+		return;
+
+	auto slot = _ThreadSlot();
+	if ((slot < 0) || (counter >= NUM_COUNTERS))
+	{
+		_numDropped.fetch_add(1u, std::memory_order_relaxed);
+		return;
+	}
+
+	auto& count = _slots[slot].Counters[counter];
+	count.store(count.load(std::memory_order_relaxed) + 1u, std::memory_order_relaxed);
+}
+
+CallbackProfiler::Capture CallbackProfiler::TakeCapture() const
+{
+	Capture capture;
+	capture.NumSamps = _numSamps.load(std::memory_order_relaxed);
+	capture.SampleRate = _sampleRate.load(std::memory_order_relaxed);
+
+	// Released slots are summed too, so counts from exited threads are kept
+	for (const auto& slot : _slots)
+	{
+		for (auto s = 0u; s < NUM_STAGES; s++)
+		{
+			const auto& histogram = slot.Stages[s];
+			auto& stage = capture.Stages[s];
+
+			for (auto bucket = 0u; bucket < NumBuckets; bucket++)
+			{
+				auto count = histogram.Buckets[bucket].load(std::memory_order_relaxed);
+				stage.Buckets[bucket] += count;
+				stage.Count += count;
+			}
+
+			stage.TotalNs += histogram.TotalNs.load(std::memory_order_relaxed);
+			stage.MaxNs = std::max(stage.MaxNs, histogram.MaxNs.load(std::memory_order_relaxed));
+		}
+
+		for (auto c = 0u; c < NUM_COUNTERS; c++)
+			capture.Counters[c] += slot.Counters[c].load(std::memory_order_relaxed);
+	}
+
+	return capture;
+}
+
+std::vector<CallbackProfiler::StageStats> CallbackProfiler::Report()
+{
+	std::lock_guard<std::mutex> lock(_reportMutex);
+	return Summarise(TakeCapture().Since(_baseline));
+}
+
+std::array<std::uint64_t, CallbackProfiler::NUM_COUNTERS> CallbackProfiler::ReportCounters()
+{
+	std::lock_guard<std::mutex> lock(_reportMutex);
+	return TakeCapture().Since(_baseline).Counters;
+}
+
+void CallbackProfiler::Reset()
+{
+	std::lock_guard<std::mutex> lock(_reportMutex);
+	_baseline = TakeCapture();
+}
+
+bool CallbackProfiler::StartCsv(const std::string& path, unsigned int intervalMs)
+{
+	std::lock_guard<std::mutex> lock(_csvMutex);
+
+	if (_csv.is_open())
+		_csv.close();
+
+	_csv.open(path, std::ios::out | std::ios::trunc);
+	if (!_csv.is_open())
+		return false;
+
+	_csv << "time_s,stage,count,p50_us,p99_us,max_us,mean_us,budget_pct\n";
+	_csv.flush();
+
+	_csvInterval = std::chrono::milliseconds(std::max(intervalMs, 100u));
+	_csvStartTime = std::chrono::steady_clock::now();
+	_csvLastTime = _csvStartTime;
+	_csvLast = TakeCapture();
+
+	return true;
+}
+
+void CallbackProfiler::StopCsv()
+{
+	std::lock_guard<std::mutex> lock(_csvMutex);
+
+	if (_csv.is_open())
+		_csv.close();
+}
+
+bool CallbackProfiler::IsWritingCsv() const
+{
+	std::lock_guard<std::mutex> lock(_csvMutex);
+	return _csv.is_open();
+}
+
+void CallbackProfiler::PumpCsv()
+{
+	std::lock_guard<std::mutex> lock(_csvMutex);
+
+	if (!_csv.is_open())
+		return;
+
+	auto now = std::chrono::steady_clock::now();
+	if (now - _csvLastTime < _csvInterval)
+		return;
+
+	auto capture = TakeCapture();
+	auto interval = capture.Since(_csvLast);
+	auto summary = Summarise(interval);
+	auto timeSecs = std::chrono::duration<double>(now - _csvStartTime).count();
+
+	_csv << std::fixed << std::setprecision(3);
+	for (const auto& stats : summary)
+	{
+		_csv << timeSecs << ","
+			<< StageName(stats.StageId) << ","
+			<< stats.Count << ","
+			<< stats.P50Us << ","
+			<< stats.P99Us << ","
+			<< stats.MaxUs << ","
+			<< stats.MeanUs << ","
+			<< stats.BudgetPercent << "\n";
+	}
+
+	for (auto c = 0u; c < NUM_COUNTERS; c++)
+		_csv << timeSecs << "," << CounterName(static_cast<Counter>(c)) << "," << interval.Counters[c] << ",,,,,\n";
+	_csv.flush();
+
+	_csvLast = capture;
+	_csvLastTime = now;
+}
+
+int CallbackProfiler::_ThreadSlot() noexcept
+{
+	auto& recorder = _threadRecorder;
+	if (!recorder.HasTriedSlot)
+	{
+		recorder.Slot = _ClaimSlot();
+		recorder.HasTriedSlot = true;
+	}
+
+	return recorder.Slot;
+}
+
+int CallbackProfiler::_ClaimSlot() noexcept
+{
+	for (auto i = 0u; i < MaxThreads; i++)
+	{
+		auto isClaimed = false;
+		if (_slots[i].IsClaimed.compare_exchange_strong(isClaimed, true, std::memory_order_acq_rel))
+			return static_cast<int>(i);
+	}
+
+	return -1;
+}
+
+void CallbackProfiler::_ReleaseSlot(int slot) noexcept
+{
+	if ((slot < 0) || (slot >= static_cast<int>(MaxThreads)))
+		return;
+
+	_slots[slot].IsClaimed.store(false, std::memory_order_release);
+}
@@ -0,0 +1,226 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Profiling scopes are compiled in when JAMMA_PROFILE_ENABLED is defined, and
+// even then only read the clock once profiling is switched on at runtime.
+#ifdef JAMMA_PROFILE_ENABLED
+#define JAMMA_PROFILE_CONCAT_INNER(a, b) a##b
+#define JAMMA_PROFILE_CONCAT(a, b) JAMMA_PROFILE_CONCAT_INNER(a, b)
+#define JAMMA_PROFILE_SCOPE(stage) audio::ProfileScope JAMMA_PROFILE_CONCAT(_profileScope, __LINE__)(audio::CallbackProfiler::stage)
+#define JAMMA_PROFILE_BLOCK(numSamps, sampleRate) audio::CallbackProfiler::Instance().RecordBlock(numSamps, sampleRate)
+#define JAMMA_PROFILE_COUNT(counter) audio::CallbackProfiler::Instance().Count(audio::CallbackProfiler::counter)
+#else
+#define JAMMA_PROFILE_SCOPE(stage)
+#define JAMMA_PROFILE_BLOCK(numSamps, sampleRate)
+#define JAMMA_PROFILE_COUNT(counter)
+#endif
+
+namespace audio
+{
+	// Per-stage timings of the audio callback.
+	//
+	// Each thread that records gets its own slot of fixed log-linear
+	// histograms, so recording is a clock read and a few relaxed stores with
+	// no allocation, locks or shared cache lines. Captures sum the slots on a
+	// non-real-time thread and are cumulative; subtract an earlier capture to
+	// get the stats for an interval. Stages nest (a loop is timed inside its
+	// take, inside its station), so each stage's time includes its children.
+	// Counters tally events such as skipped work, in the same per-thread slots.
+	class CallbackProfiler
+	{
+	public:
+		enum Stage : unsigned int
+		{
+			STAGE_CALLBACK,
+			STAGE_TICK,
+			STAGE_BOUNCE,
+			STAGE_STATION,
+			STAGE_VST,
+			STAGE_TAKE,
+			STAGE_LOOP,
+			STAGE_NINJAM,
+			NUM_STAGES
+		};
+
+		enum Counter : unsigned int
+		{
+			COUNTER_SILENT_LOOP_BLOCKS,
+			COUNTER_PREFETCH_MISSES,
+			NUM_COUNTERS
+		};
+
+		static constexpr unsigned int MaxThreads = 16u;
+		// Durations below 2^SubBucketBits ns get a bucket each, then every
+		// power of two is split into 2^SubBucketBits buckets (12.5% wide)
+		static constexpr unsigned int SubBucketBits = 3u;
+		static constexpr unsigned int SubBuckets = 1u << SubBucketBits;
+		static constexpr unsigned int MaxExponent = 31u;
+		static constexpr unsigned int NumBuckets = SubBuckets + (MaxExponent + 1u - SubBucketBits) * SubBuckets;
+
+		struct StageCapture
+		{
+			std::array<std::uint64_t, NumBuckets> Buckets{};
+			std::uint64_t Count = 0u;
+			std::uint64_t TotalNs = 0u;
+			std::uint64_t MaxNs = 0u;
+		};
+
+		struct Capture
+		{
+			std::array<StageCapture, NUM_STAGES> Stages{};
+			std::array<std::uint64_t, NUM_COUNTERS> Counters{};
+			std::uint64_t NumSamps = 0u;
+			unsigned int SampleRate = 0u;
+
+			// The histograms recorded after earlier was taken. Max is exact
+			// when it was reached in the interval, else a bucket bound.
+			Capture Since(const Capture& earlier) const;
+		};
+
+		struct StageStats
+		{
+			Stage StageId = STAGE_CALLBACK;
+			std::uint64_t Count = 0u;
+			double P50Us = 0.0;
+			double P99Us = 0.0;
+			double MaxUs = 0.0;
+			double MeanUs = 0.0;
+			// Share of the real-time budget for the captured audio, summed
+			// over threads (so parallel stations can exceed 100)
+			double BudgetPercent = 0.0;
+		};
+
+	public:
+		CallbackProfiler(const CallbackProfiler&) = delete;
+		CallbackProfiler& operator=(const CallbackProfiler&) = delete;
+		~CallbackProfiler();
+
+		static CallbackProfiler& Instance();
+		static constexpr bool IsCompiledIn() noexcept
+		{
+#ifdef JAMMA_PROFILE_ENABLED
+			return true;
+#else
+			return false;
+#endif
+		}
+
+		static const char* StageName(Stage stage) noexcept;
+		static const char* CounterName(Counter counter) noexcept;
+		static unsigned int BucketIndex(std::uint64_t ns) noexcept;
+		// Largest duration falling in the bucket, in ns
+		static std::uint64_t BucketUpperNs(unsigned int bucket) noexcept;
+		static std::uint64_t Percentile(const StageCapture& stage, double fraction) noexcept;
+		static std::vector<StageStats> Summarise(const Capture& capture);
+		static std::string FormatStats(const StageStats& stats);
+
+		bool IsEnabled() const noexcept { return _isEnabled.load(std::memory_order_relaxed); }
+		void SetEnabled(bool isEnabled) noexcept;
+
+		// Audio thread
+		void Record(Stage stage, std::uint64_t ns) noexcept;
+		void RecordBlock(unsigned int numSamps, unsigned int sampleRate) noexcept;
+		void Count(Counter counter) noexcept;
+		std::uint64_t NumDropped() const noexcept { return _numDropped.load(std::memory_order_relaxed); }
+
+		Capture TakeCapture() const;
+		// Stats since the last Reset()
+		std::vector<StageStats> Report();
+		// Counter totals since the last Reset()
+		std::array<std::uint64_t, NUM_COUNTERS> ReportCounters();
+		void Reset();
+
+		bool StartCsv(const std::string& path, unsigned int intervalMs);
+		void StopCsv();
+		bool IsWritingCsv() const;
+		// Appends a row per stage once the CSV interval has passed. Job thread.
+		void PumpCsv();
+
+	protected:
+		struct alignas(64) StageHistogram
+		{
+			std::array<std::atomic<std::uint64_t>, NumBuckets> Buckets;
+			std::atomic<std::uint64_t> TotalNs;
+			std::atomic<std::uint64_t> MaxNs;
+		};
+
+		struct ThreadSlot
+		{
+			std::array<StageHistogram, NUM_STAGES> Stages;
+			std::array<std::atomic<std::uint64_t>, NUM_COUNTERS> Counters;
+			std::atomic<bool> IsClaimed;
+		};
+
+		struct ThreadRecorder
+		{
+			int Slot = -1;
+			bool HasTriedSlot = false;
+
+			~ThreadRecorder();
+		};
+
+		CallbackProfiler();
+
+		// This thread's slot, claimed on first use, or -1 if none are free
+		int _ThreadSlot() noexcept;
+		int _ClaimSlot() noexcept;
+		void _ReleaseSlot(int slot) noexcept;
+
+	protected:
+		static thread_local ThreadRecorder _threadRecorder;
+
+		std::atomic<bool> _isEnabled;
+		std::array<ThreadSlot, MaxThreads> _slots;
+		std::atomic<std::uint64_t> _numSamps;
+		std::atomic<unsigned int> _sampleRate;
+		std::atomic<std::uint64_t> _numDropped;
+
+		std::mutex _reportMutex;
+		Capture _baseline;
+
+		mutable std::mutex _csvMutex;
+		std::ofstream _csv;
+		std::chrono::milliseconds _csvInterval;
+		std::chrono::steady_clock::time_point _csvLastTime;
+		std::chrono::steady_clock::time_point _csvStartTime;
+		Capture _csvLast;
+	};
+
+	// Times the enclosing scope into one stage. Use JAMMA_PROFILE_SCOPE.
+	class ProfileScope
+	{
+	public:
+		explicit ProfileScope(CallbackProfiler::Stage stage) noexcept :
+			_stage(stage),
+			_isActive(CallbackProfiler::Instance().IsEnabled()),
+			_start(_isActive ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point())
+		{
+		}
+
+		~ProfileScope() noexcept
+		{
+			if (!_isActive)
+				return;
+
+			auto elapsed = std::chrono::steady_clock::now() - _start;
+			CallbackProfiler::Instance().Record(_stage,
+				static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+		}
+
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+
+	private:
+		CallbackProfiler::Stage _stage;
+		bool _isActive;
+		std::chrono::steady_clock::time_point _start;
+	};
+}
@@ -1,4 +1,5 @@
 #include "ChannelMixer.h"
+#include "InterleaveKernels.h"
 
 using namespace audio;
 using namespace base;
@@ -25,24 +26,8 @@ void ChannelMixer::FromAdc(float* inBuf, unsigned int numChannels, unsigned int
 	if (numSamps < 1 || numChannels < 1)
 		return;
 
-	for (auto chan = 0u; chan < _adcMixer->NumOutputChannels(Audible::AUDIOSOURCE_ADC); chan++)
-	{
-		const auto buf = _adcMixer->Channel(chan);
-
-		if ((buf) && (numChannels > chan))
-		{
-			AudioWriteRequest request;
-			request.samples = &inBuf[chan];
-			request.numSamps = numSamps;
-			request.stride = numChannels;
-			request.fadeCurrent = 0.0f;
-			request.fadeNew = 1.0f;
-			request.source = _adcMixer->SourceType();
-
-			buf->OnBlockWrite(request, 0);
-			buf->EndWrite(numSamps, true);
-		}
-	}
+	auto numChans = std::min(_adcMixer->NumOutputChannels(Audible::AUDIOSOURCE_ADC), numChannels);
+	_adcMixer->WriteInterleaved(inBuf, numChans, numChannels, numSamps);
 }
 
 void ChannelMixer::InitPlay(unsigned int delaySamps, unsigned int blockSize)
@@ -68,8 +53,8 @@ void ChannelMixer::WriteToSink(const std::shared_ptr<MultiAudioSink> dest, unsig
 
 		if (buf && buf->SampsRecorded() > 0)
 		{
-			auto bufSize = buf->BufSize();
-			if (0 == bufSize)
+			auto capacity = buf->Capacity();
+			if (0 == capacity)
 				continue;
 
 			auto playIndex = buf->PlayIndex();
@@ -89,7 +74,7 @@ void ChannelMixer::WriteToSink(const std::shared_ptr<MultiAudioSink> dest, unsig
 			else
 			{
 				// Handle wrap-around: split into two contiguous writes
-				auto sampsToEnd = bufSize - playIndex;
+				auto sampsToEnd = capacity - playIndex;
 				auto firstChunk = (numSamps < sampsToEnd) ? numSamps : sampsToEnd;
 
 				request.samples = buf->BlockRead(playIndex);
@@ -112,36 +97,41 @@ void ChannelMixer::ToDac(float* outBuf, unsigned int numChannels, unsigned int n
 	if (numSamps < 1 || numChannels < 1)
 		return;
 
-	for (auto chan = 0u; chan < _dacMixer->NumInputChannels(Audible::AUDIOSOURCE_MIXER); chan++)
+	auto numChans = std::min(_dacMixer->NumInputChannels(Audible::AUDIOSOURCE_MIXER), numChannels);
+	_dacMixer->ReadInterleaved(outBuf, numChans, numChannels, numSamps);
+}
+
+std::shared_ptr<ChannelMixer::Bus> ChannelMixer::CreateBus() const
+{
+	auto bus = std::make_shared<ChannelMixer::Bus>();
+	bus->SetNumChannels(_dacMixer->NumInputChannels(Audible::AUDIOSOURCE_MIXER), constants::MaxBlockSize);
+
+	return bus;
+}
+
+void ChannelMixer::MixBus(Bus& bus, unsigned int numSamps)
+{
+	if (numSamps > constants::MaxBlockSize)
+		numSamps = constants::MaxBlockSize;
+
+	auto numChans = std::min(bus.NumInputChannels(Audible::AUDIOSOURCE_MIXER),
+		_dacMixer->NumInputChannels(Audible::AUDIOSOURCE_MIXER));
+
+	for (auto chan = 0u; chan < numChans; chan++)
 	{
-		auto buf = _dacMixer->Channel(chan);
+		const auto buf = bus.Channel(chan);
 
 		if (buf)
 		{
-			if ((numChannels > chan) && (buf->BufSize() > 0))
-			{
-				auto playIndex = buf->Delay(0);
+			AudioWriteRequest request;
+			request.samples = buf->BlockRead(0);
+			request.numSamps = numSamps;
+			request.stride = 1;
+			request.fadeCurrent = 1.0f;
+			request.fadeNew = 1.0f;
+			request.source = Audible::AUDIOSOURCE_MIXER;
 
-				if (buf->IsContiguous(playIndex, numSamps))
-				{
-					auto ptr = buf->BlockRead(playIndex);
-					auto offset = chan;
-					for (auto samp = 0u; samp < numSamps; samp++)
-					{
-						outBuf[offset] = ptr[samp];
-						offset += numChannels;
-					}
-				}
-				else
-				{
-					auto offset = chan;
-					for (auto samp = 0u; samp < numSamps; samp++)
-					{
-						outBuf[offset] = (*buf)[samp + playIndex];
-						offset += numChannels;
-					}
-				}
-			}
+			_dacMixer->OnBlockWriteChannel(chan, request, 0);
 		}
 	}
 }
@@ -161,6 +151,70 @@ void ChannelMixer::BufferMixer::SetNumChannels(unsigned int numChans, unsigned i
 
 	for (auto& buf : _buffers)
 		buf->SetSize(bufSize);
+
+	_blockPtrs.resize(numChans, nullptr);
+}
+
+void ChannelMixer::BufferMixer::WriteInterleaved(const float* src,
+	unsigned int numChans,
+	unsigned int stride,
+	unsigned int numSamps)
+{
+	auto done = 0u;
+
+	// Each pass runs up to the nearest ring end, so at most two passes
+	// when the rings share a size
+	while (done < numSamps)
+	{
+		auto seg = numSamps - done;
+
+		for (auto chan = 0u; chan < numChans; chan++)
+		{
+			auto& buf = _buffers[chan];
+			auto idx = (buf->WriteIndex() + done) & buf->Mask();
+			seg = std::min(seg, buf->Capacity() - idx);
+			_blockPtrs[chan] = buf->BlockWrite(idx);
+		}
+
+		if (0 == seg)
+			return;
+
+		InterleaveKernels::Deinterleave(_blockPtrs.data(), src + (static_cast<size_t>(done) * stride), numChans, stride, seg);
+		done += seg;
+	}
+
+	for (auto chan = 0u; chan < numChans; chan++)
+		_buffers[chan]->EndWrite(numSamps, true);
+}
+
+void ChannelMixer::BufferMixer::ReadInterleaved(float* dest,
+	unsigned int numChans,
+	unsigned int stride,
+	unsigned int numSamps)
+{
+	for (auto chan = 0u; chan < numChans; chan++)
+		_buffers[chan]->Delay(0);
+
+	auto done = 0u;
+
+	while (done < numSamps)
+	{
+		auto seg = numSamps - done;
+
+		for (auto chan = 0u; chan < numChans; chan++)
+		{
+			auto& buf = _buffers[chan];
+			auto idx = (buf->PlayIndex() + done) & buf->Mask();
+			seg = std::min(seg, buf->Capacity() - idx);
+			_blockPtrs[chan] = buf->BlockWrite(idx);
+		}
+
+		if (0 == seg)
+			return;
+
+		InterleaveKernels::Interleave(dest + (static_cast<size_t>(done) * stride), _blockPtrs.data(), numChans, stride, seg);
+		done += seg;
+	}
 }
 
 void ChannelMixer::AdcChannelMixer::EndMultiPlay(unsigned int numSamps)
@@ -24,8 +24,15 @@ namespace audio
 			void SetNumChannels(unsigned int numChans, unsigned int bufSize);
 			const std::shared_ptr<audio::AudioBuffer> Channel(unsigned int channel);
 
+			// Deinterleaves into the first numChans rings at their write
+			// index, then advances them
+			void WriteInterleaved(const float* src, unsigned int numChans, unsigned int stride, unsigned int numSamps);
+			// Interleaves from the first numChans rings at their play index
+			void ReadInterleaved(float* dest, unsigned int numChans, unsigned int stride, unsigned int numSamps);
+
 		protected:
 			std::vector<std::shared_ptr<AudioBuffer>> _buffers;
+			std::vector<float*> _blockPtrs;
 		};
 
 		class AdcChannelMixer :
@@ -56,6 +63,15 @@ namespace audio
 				base::Audible::AudioSourceType source) override;
 		};
 
+	public:
+		// Private per-station accumulation bus used by parallel rendering.
+		// Its write index is never advanced, so every block lands at index 0
+		// and can be summed into the DAC mixer with MixBus().
+		class Bus :
+			public DacChannelMixer
+		{
+		};
+
 	public:
 		ChannelMixer(ChannelMixerParams chanMixParams);
 		~ChannelMixer();
@@ -65,6 +81,8 @@ namespace audio
 		void FromAdc(float* inBuf, unsigned int numChannels, unsigned int numSamps);
 		void WriteToSink(const std::shared_ptr<base::MultiAudioSink> dest, unsigned int numSamps);
 		void ToDac(float* outBuf, unsigned int numChannels, unsigned int numSamps);
+		std::shared_ptr<Bus> CreateBus() const;
+		void MixBus(Bus& bus, unsigned int numSamps);
 		const std::shared_ptr<base::MultiAudioSource> Source();
 		const std::shared_ptr<base::MultiAudioSink> Sink();
 		void InitPlay(unsigned int delaySamps, unsigned int blockSize);
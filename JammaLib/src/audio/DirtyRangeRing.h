@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace audio
+{
+	// Sample ranges written by the audio thread, for a reader on another
+	// thread to pick up later.
+	//
+	// Single producer, single consumer and lock-free. A full ring drops the
+	// range and raises an overflow flag instead, telling the reader to
+	// treat everything as written.
+	template <std::size_t Capacity>
+	class DirtyRangeRing
+	{
+		static_assert(Capacity >= 2, "Capacity must be at least 2");
+		static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+	public:
+		struct Range
+		{
+			unsigned long Start = 0ul;
+			unsigned long NumSamps = 0ul;
+		};
+
+		static constexpr std::size_t capacity = Capacity;
+
+		DirtyRangeRing() noexcept :
+			_head(0),
+			_tail(0),
+			_isOverflowed(false)
+		{
+		}
+
+		DirtyRangeRing(const DirtyRangeRing&) = delete;
+		DirtyRangeRing& operator=(const DirtyRangeRing&) = delete;
+
+		bool Push(unsigned long start, unsigned long numSamps) noexcept
+		{
+			const auto tail = _tail.load(std::memory_order_relaxed);
+			const auto head = _head.load(std::memory_order_acquire);
+			const auto next = (tail + 1) & Mask;
+
+			if (next == head)
+			{
+				_isOverflowed.store(true, std::memory_order_release);
+				return false;
+			}
+
+			_buffer[tail] = { start, numSamps };
+			_tail.store(next, std::memory_order_release);
+			return true;
+		}
+
+		bool Pop(Range& out) noexcept
+		{
+			const auto head = _head.load(std::memory_order_relaxed);
+			const auto tail = _tail.load(std::memory_order_acquire);
+			if (head == tail)
+				return false;
+
+			out = _buffer[head];
+			_head.store((head + 1) & Mask, std::memory_order_release);
+			return true;
+		}
+
+		// True once if any range was dropped since the last call.
+		bool TakeOverflow() noexcept
+		{
+			return _isOverflowed.exchange(false, std::memory_order_acq_rel);
+		}
+
+	private:
+		static constexpr std::size_t Mask = Capacity - 1;
+
+		std::array<Range, Capacity> _buffer{};
+		std::atomic<std::size_t> _head;
+		std::atomic<std::size_t> _tail;
+		std::atomic<bool> _isOverflowed;
+	};
+}
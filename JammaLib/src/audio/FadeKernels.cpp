@@ -0,0 +1,438 @@
+#include "FadeKernels.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define JAMMA_FADEKERNELS_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC accepts any ISA intrinsic in any function; GCC/Clang need the
+// target spelled out per function. GCC would also fuse the multiply and
+// add into an FMA under AVX-512, breaking bit-exactness with the scalar path.
+#if defined(__GNUC__) || defined(__clang__)
+#define JAMMA_TARGET(isa) __attribute__((target(isa)))
+#if !defined(__clang__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+#else
+#define JAMMA_TARGET(isa)
+#endif
+
+using namespace audio;
+
+namespace
+{
+	void FadeMixScalar(float* dest,
+		const float* src,
+		unsigned int srcStride,
+		unsigned int numSamps,
+		float fadeCurrent,
+		float fadeNew) noexcept
+	{
+		for (auto i = 0u; i < numSamps; i++)
+			dest[i] = (fadeNew * src[i * srcStride]) + (fadeCurrent * dest[i]);
+	}
+
+	void FadeMixRampScalar(float* dest,
+		const float* src,
+		unsigned int srcStride,
+		unsigned int numSamps,
+		float fadeCurrent,
+		float fadeNew,
+		const float* ramp,
+		float fadeCurrentRamp) noexcept
+	{
+		for (auto i = 0u; i < numSamps; i++)
+		{
+			dest[i] = ((fadeNew * ramp[i]) * src[i * srcStride]) +
+				((fadeCurrent + (fadeCurrentRamp * ramp[i])) * dest[i]);
+		}
+	}
+
+#ifdef JAMMA_FADEKERNELS_X86
+	JAMMA_TARGET("sse2")
+	void FadeMixSse2(float* dest,
+		const float* src,
+		unsigned int srcStride,
+		unsigned int numSamps,
+		float fadeCurrent,
+		float fadeNew) noexcept
+	{
+		const auto current = _mm_set1_ps(fadeCurrent);
+		const auto gain = _mm_set1_ps(fadeNew);
+		auto i = 0u;
+
+		if (1u == srcStride)
+		{
+			for (; i + 4u <= numSamps; i += 4u)
+			{
+				auto samps = _mm_loadu_ps(src + i);
+				auto prev = _mm_loadu_ps(dest + i);
+				_mm_storeu_ps(dest + i, _mm_add_ps(_mm_mul_ps(gain, samps), _mm_mul_ps(current, prev)));
+			}
+		}
+		else
+		{
+			for (; i + 4u <= numSamps; i += 4u)
+			{
+				const auto* base = src + static_cast<size_t>(i) * srcStride;
+				auto samps = _mm_setr_ps(base[0],
+					base[srcStride],
+					base[2u * srcStride],
+					base[3u * srcStride]);
+				auto prev = _mm_loadu_ps(dest + i);
+				_mm_storeu_ps(dest + i, _mm_add_ps(_mm_mul_ps(gain, samps), _mm_mul_ps(current, prev)));
+			}
+		}
+
+		FadeMixScalar(dest + i,
+			src + static_cast<size_t>(i) * srcStride,
+			srcStride,
+			numSamps - i,
+			fadeCurrent,
+			fadeNew);
+	}
+
+	JAMMA_TARGET("sse2")
+	void FadeMixRampSse2(float* dest,
+		const float* src,
+		unsigned int srcStride,
+		unsigned int numSamps,
+		float fadeCurrent,
+		float fadeNew,
+		const float* ramp,
+		float fadeCurrentRamp) noexcept
+	{
+		const auto current = _mm_set1_ps(fadeCurrent);
+		const auto currentRamp = _mm_set1_ps(fadeCurrentRamp);
+		const auto gain = _mm_set1_ps(fadeNew);
+		auto i = 0u;
+
+		for (; i + 4u <= numSamps; i += 4u)
+		{
+			__m128 samps;
+			if (1u == srcStride)
+			{
+				samps = _mm_loadu_ps(src + i);
+			}
+			else
+			{
+				const auto* base = src + static_cast<size_t>(i) * srcStride;
+				samps = _mm_setr_ps(base[0],
+					base[srcStride],
+					base[2u * srcStride],
+					base[3u * srcStride]);
+			}
+
+			auto r = _mm_loadu_ps(ramp + i);
+			auto prev = _mm_loadu_ps(dest + i);
+			auto newPart = _mm_mul_ps(_mm_mul_ps(gain, r), samps);
+			auto currentPart = _mm_mul_ps(_mm_add_ps(current, _mm_mul_ps(currentRamp, r)), prev);
+			_mm_storeu_ps(dest + i, _mm_add_ps(newPart, currentPart));
+		}
+
+		FadeMixRampScalar(dest + i,
+			src + static_cast<size_t>(i) * srcStride,
+			srcStride,
+			numSamps - i,
+			fadeCurrent,
+			fadeNew,
+			ramp + i,
+			fadeCurrentRamp);
+	}
+
+	JAMMA_TARGET("avx2")
+	void FadeMixAvx2(float* dest,
+		const float* src,
+		unsigned int srcStride,
+		unsigned int numSamps,
+		float fadeCurrent,
+		float fadeNew) noexcept
+	{
+		const auto current = _mm256_set1_ps(fadeCurrent);
+		const auto gain = _mm256_set1_ps(fadeNew);
+		auto i = 0u;
+
+		if (1u == srcStride)
+		{
+			for (; i + 8u <= numSamps; i += 8u)
+			{
+				auto samps = _mm256_loadu_ps(src + i);
+				auto prev = _mm256_loadu_ps(dest + i);
+				_mm256_storeu_ps(dest + i, _mm256_add_ps(_mm256_mul_ps(gain, samps), _mm256_mul_ps(current, prev)));
+			}
+		}
+		else
+		{
+			const auto offsets = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+				_mm256_set1_epi32(static_cast<int>(srcStride)));
+
+			for (; i + 8u <= numSamps; i += 8u)
+			{
+				auto samps = _mm256_i32gather_ps(src + static_cast<size_t>(i) * srcStride, offsets, 4);
+				auto prev = _mm256_loadu_ps(dest + i);
+				_mm256_storeu_ps(dest + i, _mm256_add_ps(_mm256_mul_ps(gain, samps), _mm256_mul_ps(current, prev)));
+			}
+		}
+
+		FadeMixScalar(dest + i,
+			src + static_cast<size_t>(i) * srcStride,
+			srcStride,
+			numSamps - i,
+			fadeCurrent,
+			fadeNew);
+	}
+
+	JAMMA_TARGET("avx2")
+	void FadeMixRampAvx2(float* dest,
+		const float* src,
+		unsigned int srcStride,
+		unsigned int numSamps,
+		float fadeCurrent,
+		float fadeNew,
+		const float* ramp,
+		float fadeCurrentRamp) noexcept
+	{
+		const auto current = _mm256_set1_ps(fadeCurrent);
+		const auto currentRamp = _mm256_set1_ps(fadeCurrentRamp);
+		const auto gain = _mm256_set1_ps(fadeNew);
+		const auto offsets = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7),
+			_mm256_set1_epi32(static_cast<int>(srcStride)));
+		auto i = 0u;
+
+		for (; i + 8u <= numSamps; i += 8u)
+		{
+			auto samps = (1u == srcStride) ?
+				_mm256_loadu_ps(src + i) :
+				_mm256_i32gather_ps(src + static_cast<size_t>(i) * srcStride, offsets, 4);
+			auto r = _mm256_loadu_ps(ramp + i);
+			auto prev = _mm256_loadu_ps(dest + i);
+			auto newPart = _mm256_mul_ps(_mm256_mul_ps(gain, r), samps);
+			auto currentPart = _mm256_mul_ps(_mm256_add_ps(current, _mm256_mul_ps(currentRamp, r)), prev);
+			_mm256_storeu_ps(dest + i, _mm256_add_ps(newPart, currentPart));
+		}
+
+		FadeMixRampScalar(dest + i,
+			src + static_cast<size_t>(i) * srcStride,
+			srcStride,
+			numSamps - i,
+			fadeCurrent,
+			fadeNew,
+			ramp + i,
+			fadeCurrentRamp);
+	}
+
+	JAMMA_TARGET("avx512f")
+	void FadeMixAvx512(float* dest,
+		const float* src,
+		unsigned int srcStride,
+		unsigned int numSamps,
+		float fadeCurrent,
+		float fadeNew) noexcept
+	{
+		const auto current = _mm512_set1_ps(fadeCurrent);
+		const auto gain = _mm512_set1_ps(fadeNew);
+		auto i = 0u;
+
+		if (1u == srcStride)
+		{
+			for (; i + 16u <= numSamps; i += 16u)
+			{
+				auto samps = _mm512_loadu_ps(src + i);
+				auto prev = _mm512_loadu_ps(dest + i);
+				_mm512_storeu_ps(dest + i, _mm512_add_ps(_mm512_mul_ps(gain, samps), _mm512_mul_ps(current, prev)));
+			}
+
+			if (i < numSamps)
+			{
+				auto mask = static_cast<__mmask16>((1u << (numSamps - i)) - 1u);
+				auto samps = _mm512_maskz_loadu_ps(mask, src + i);
+				auto prev = _mm512_maskz_loadu_ps(mask, dest + i);
+				_mm512_mask_storeu_ps(dest + i, mask, _mm512_add_ps(_mm512_mul_ps(gain, samps), _mm512_mul_ps(current, prev)));
+			}
+
+			return;
+		}
+
+		const auto offsets = _mm512_mullo_epi32(
+			_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15),
+			_mm512_set1_epi32(static_cast<int>(srcStride)));
+
+		for (; i + 16u <= numSamps; i += 16u)
+		{
+			auto samps = _mm512_i32gather_ps(offsets, src + static_cast<size_t>(i) * srcStride, 4);
+			auto prev = _mm512_loadu_ps(dest + i);
+			_mm512_storeu_ps(dest + i, _mm512_add_ps(_mm512_mul_ps(gain, samps), _mm512_mul_ps(current, prev)));
+		}
+
+		FadeMixScalar(dest + i,
+			src + static_cast<size_t>(i) * srcStride,
+			srcStride,
+			numSamps - i,
+			fadeCurrent,
+			fadeNew);
+	}
+
+	JAMMA_TARGET("avx512f")
+	void FadeMixRampAvx512(float* dest,
+		const float* src,
+		unsigned int srcStride,
+		unsigned int numSamps,
+		float fadeCurrent,
+		float fadeNew,
+		const float* ramp,
+		float fadeCurrentRamp) noexcept
+	{
+		const auto current = _mm512_set1_ps(fadeCurrent);
+		const auto currentRamp = _mm512_set1_ps(fadeCurrentRamp);
+		const auto gain = _mm512_set1_ps(fadeNew);
+		const auto offsets = _mm512_mullo_epi32(
+			_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15),
+			_mm512_set1_epi32(static_cast<int>(srcStride)));
+		auto i = 0u;
+
+		for (; i + 16u <= numSamps; i += 16u)
+		{
+			auto samps = (1u == srcStride) ?
+				_mm512_loadu_ps(src + i) :
+				_mm512_i32gather_ps(offsets, src + static_cast<size_t>(i) * srcStride, 4);
+			auto r = _mm512_loadu_ps(ramp + i);
+			auto prev = _mm512_loadu_ps(dest + i);
+			auto newPart = _mm512_mul_ps(_mm512_mul_ps(gain, r), samps);
+			auto currentPart = _mm512_mul_ps(_mm512_add_ps(current, _mm512_mul_ps(currentRamp, r)), prev);
+			_mm512_storeu_ps(dest + i, _mm512_add_ps(newPart, currentPart));
+		}
+
+		FadeMixRampScalar(dest + i,
+			src + static_cast<size_t>(i) * srcStride,
+			srcStride,
+			numSamps - i,
+			fadeCurrent,
+			fadeNew,
+			ramp + i,
+			fadeCurrentRamp);
+	}
+
+	FadeKernels::SimdLevel DetectLevel() noexcept
+	{
+#ifdef _MSC_VER
+		int info[4] = {};
+		__cpuid(info, 0);
+		auto maxLeaf = info[0];
+
+		__cpuid(info, 1);
+		auto hasSse2 = 0 != (info[3] & (1 << 26));
+		auto hasOsxsave = 0 != (info[2] & (1 << 27));
+		auto hasAvx = 0 != (info[2] & (1 << 28));
+
+		if (!hasSse2)
+			return FadeKernels::SIMD_SCALAR;
+
+		if (!hasOsxsave || !hasAvx || (maxLeaf < 7))
+			return FadeKernels::SIMD_SSE2;
+
+		auto xcr0 = _xgetbv(0);
+		if (0x6 != (xcr0 & 0x6))
+			return FadeKernels::SIMD_SSE2;
+
+		__cpuidex(info, 7, 0);
+		auto hasAvx2 = 0 != (info[1] & (1 << 5));
+		auto hasAvx512f = 0 != (info[1] & (1 << 16));
+
+		if (hasAvx512f && (0xE6 == (xcr0 & 0xE6)))
+			return FadeKernels::SIMD_AVX512;
+
+		return hasAvx2 ? FadeKernels::SIMD_AVX2 : FadeKernels::SIMD_SSE2;
+#else
+		__builtin_cpu_init();
+
+		if (__builtin_cpu_supports("avx512f"))
+			return FadeKernels::SIMD_AVX512;
+		if (__builtin_cpu_supports("avx2"))
+			return FadeKernels::SIMD_AVX2;
+		if (__builtin_cpu_supports("sse2"))
+			return FadeKernels::SIMD_SSE2;
+
+		return FadeKernels::SIMD_SCALAR;
+#endif
+	}
+#else
+	FadeKernels::SimdLevel DetectLevel() noexcept
+	{
+		return FadeKernels::SIMD_SCALAR;
+	}
+#endif
+}
+
+// Detected once during static initialisation so the audio thread never
+// pays for it.
+FadeKernels::SimdLevel FadeKernels::_activeLevel = FadeKernels::SupportedLevel();
+FadeKernels::FadeMixFn FadeKernels::_activeFadeMix = FadeKernels::Kernel(FadeKernels::_activeLevel);
+FadeKernels::FadeMixRampFn FadeKernels::_activeFadeMixRamp = FadeKernels::RampKernel(FadeKernels::_activeLevel);
+
+FadeKernels::SimdLevel FadeKernels::SupportedLevel() noexcept
+{
+	static const auto level = DetectLevel();
+	return level;
+}
+
+FadeKernels::FadeMixFn FadeKernels::Kernel(SimdLevel level) noexcept
+{
+	if (level > SupportedLevel())
+		return nullptr;
+
+	switch (level)
+	{
+#ifdef JAMMA_FADEKERNELS_X86
+	case SIMD_SSE2:
+		return &FadeMixSse2;
+	case SIMD_AVX2:
+		return &FadeMixAvx2;
+	case SIMD_AVX512:
+		return &FadeMixAvx512;
+#endif
+	case SIMD_SCALAR:
+		return &FadeMixScalar;
+	default:
+		return nullptr;
+	}
+}
+
+FadeKernels::FadeMixRampFn FadeKernels::RampKernel(SimdLevel level) noexcept
+{
+	if (level > SupportedLevel())
+		return nullptr;
+
+	switch (level)
+	{
+#ifdef JAMMA_FADEKERNELS_X86
+	case SIMD_SSE2:
+		return &FadeMixRampSse2;
+	case SIMD_AVX2:
+		return &FadeMixRampAvx2;
+	case SIMD_AVX512:
+		return &FadeMixRampAvx512;
+#endif
+	case SIMD_SCALAR:
+		return &FadeMixRampScalar;
+	default:
+		return nullptr;
+	}
+}
+
+const char* FadeKernels::LevelName(SimdLevel level) noexcept
+{
+	switch (level)
+	{
+	case SIMD_SSE2:
+		return "sse2";
+	case SIMD_AVX2:
+		return "avx2";
+	case SIMD_AVX512:
+		return "avx512";
+	default:
+		return "scalar";
+	}
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+namespace audio
+{
+	// Fade-and-accumulate kernels for the block write paths:
+	//
+	//   dest[i] = (fadeNew * src[i * srcStride]) + (fadeCurrent * dest[i])
+	//
+	// The ramp variants take a per-sample gain for fades that move within
+	// the block:
+	//
+	//   dest[i] = ((fadeNew * ramp[i]) * src[i * srcStride]) +
+	//             ((fadeCurrent + (fadeCurrentRamp * ramp[i])) * dest[i])
+	//
+	// The SIMD variants use separate multiplies and an add (never FMA), so
+	// every level produces bit-identical output to the scalar reference.
+	// The best level supported by the CPU is picked once at start-up.
+	// All kernels are real-time safe.
+	class FadeKernels
+	{
+	public:
+		enum SimdLevel
+		{
+			SIMD_SCALAR,
+			SIMD_SSE2,
+			SIMD_AVX2,
+			SIMD_AVX512
+		};
+
+		using FadeMixFn = void(*)(float* dest,
+			const float* src,
+			unsigned int srcStride,
+			unsigned int numSamps,
+			float fadeCurrent,
+			float fadeNew) noexcept;
+		using FadeMixRampFn = void(*)(float* dest,
+			const float* src,
+			unsigned int srcStride,
+			unsigned int numSamps,
+			float fadeCurrent,
+			float fadeNew,
+			const float* ramp,
+			float fadeCurrentRamp) noexcept;
+
+	public:
+		// Dispatches to the active level.
+		static void FadeMix(float* dest,
+			const float* src,
+			unsigned int srcStride,
+			unsigned int numSamps,
+			float fadeCurrent,
+			float fadeNew) noexcept
+		{
+			_activeFadeMix(dest, src, srcStride, numSamps, fadeCurrent, fadeNew);
+		}
+
+		static void FadeMixRamp(float* dest,
+			const float* src,
+			unsigned int srcStride,
+			unsigned int numSamps,
+			float fadeCurrent,
+			float fadeNew,
+			const float* ramp,
+			float fadeCurrentRamp) noexcept
+		{
+			_activeFadeMixRamp(dest, src, srcStride, numSamps, fadeCurrent, fadeNew, ramp, fadeCurrentRamp);
+		}
+
+		static SimdLevel SupportedLevel() noexcept;
+		static SimdLevel ActiveLevel() noexcept { return _activeLevel; }
+		// Kernel for an explicit level, or nullptr if the CPU lacks it.
+		static FadeMixFn Kernel(SimdLevel level) noexcept;
+		static FadeMixRampFn RampKernel(SimdLevel level) noexcept;
+		static const char* LevelName(SimdLevel level) noexcept;
+
+	private:
+		static SimdLevel _activeLevel;
+		static FadeMixFn _activeFadeMix;
+		static FadeMixRampFn _activeFadeMixRamp;
+	};
+}
@@ -0,0 +1,375 @@
+#include "InterleaveKernels.h"
+
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define JAMMA_INTERLEAVEKERNELS_X86
+#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define JAMMA_TARGET(isa) __attribute__((target(isa)))
+#else
+#define JAMMA_TARGET(isa)
+#endif
+
+using namespace audio;
+
+namespace
+{
+	constexpr auto TileSamps = InterleaveKernels::TileSamps;
+
+	// Channels [chanStart, chanEnd) over samples [sampStart, sampEnd)
+	void DeinterleaveRange(float* const* dests,
+		const float* src,
+		unsigned int chanStart,
+		unsigned int chanEnd,
+		unsigned int stride,
+		unsigned int sampStart,
+		unsigned int sampEnd) noexcept
+	{
+		for (auto i = sampStart; i < sampEnd; i++)
+		{
+			const auto* frame = src + static_cast<size_t>(i) * stride;
+			for (auto c = chanStart; c < chanEnd; c++)
+				dests[c][i] = frame[c];
+		}
+	}
+
+	void InterleaveRange(float* dest,
+		const float* const* srcs,
+		unsigned int chanStart,
+		unsigned int chanEnd,
+		unsigned int stride,
+		unsigned int sampStart,
+		unsigned int sampEnd) noexcept
+	{
+		for (auto i = sampStart; i < sampEnd; i++)
+		{
+			auto* frame = dest + static_cast<size_t>(i) * stride;
+			for (auto c = chanStart; c < chanEnd; c++)
+				frame[c] = srcs[c][i];
+		}
+	}
+
+	void DeinterleaveScalar(float* const* dests,
+		const float* src,
+		unsigned int numChans,
+		unsigned int stride,
+		unsigned int numSamps) noexcept
+	{
+		DeinterleaveRange(dests, src, 0u, numChans, stride, 0u, numSamps);
+	}
+
+	void InterleaveScalar(float* dest,
+		const float* const* srcs,
+		unsigned int numChans,
+		unsigned int stride,
+		unsigned int numSamps) noexcept
+	{
+		InterleaveRange(dest, srcs, 0u, numChans, stride, 0u, numSamps);
+	}
+
+#ifdef JAMMA_INTERLEAVEKERNELS_X86
+	// Four frames of channels [c, c+4) become four channels of samples [i, i+4)
+	JAMMA_TARGET("sse2")
+	void DeinterleaveBlock4(float* const* dests,
+		const float* src,
+		unsigned int c,
+		unsigned int stride,
+		unsigned int i) noexcept
+	{
+		const auto* frame = src + static_cast<size_t>(i) * stride + c;
+		auto r0 = _mm_loadu_ps(frame);
+		auto r1 = _mm_loadu_ps(frame + stride);
+		auto r2 = _mm_loadu_ps(frame + 2u * stride);
+		auto r3 = _mm_loadu_ps(frame + 3u * stride);
+
+		_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+		_mm_storeu_ps(dests[c] + i, r0);
+		_mm_storeu_ps(dests[c + 1u] + i, r1);
+		_mm_storeu_ps(dests[c + 2u] + i, r2);
+		_mm_storeu_ps(dests[c + 3u] + i, r3);
+	}
+
+	JAMMA_TARGET("sse2")
+	void InterleaveBlock4(float* dest,
+		const float* const* srcs,
+		unsigned int c,
+		unsigned int stride,
+		unsigned int i) noexcept
+	{
+		auto r0 = _mm_loadu_ps(srcs[c] + i);
+		auto r1 = _mm_loadu_ps(srcs[c + 1u] + i);
+		auto r2 = _mm_loadu_ps(srcs[c + 2u] + i);
+		auto r3 = _mm_loadu_ps(srcs[c + 3u] + i);
+
+		_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+		auto* frame = dest + static_cast<size_t>(i) * stride + c;
+		_mm_storeu_ps(frame, r0);
+		_mm_storeu_ps(frame + stride, r1);
+		_mm_storeu_ps(frame + 2u * stride, r2);
+		_mm_storeu_ps(frame + 3u * stride, r3);
+	}
+
+	JAMMA_TARGET("avx2")
+	void Transpose8(__m256& r0, __m256& r1, __m256& r2, __m256& r3,
+		__m256& r4, __m256& r5, __m256& r6, __m256& r7) noexcept
+	{
+		auto t0 = _mm256_unpacklo_ps(r0, r1);
+		auto t1 = _mm256_unpackhi_ps(r0, r1);
+		auto t2 = _mm256_unpacklo_ps(r2, r3);
+		auto t3 = _mm256_unpackhi_ps(r2, r3);
+		auto t4 = _mm256_unpacklo_ps(r4, r5);
+		auto t5 = _mm256_unpackhi_ps(r4, r5);
+		auto t6 = _mm256_unpacklo_ps(r6, r7);
+		auto t7 = _mm256_unpackhi_ps(r6, r7);
+
+		auto s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+		auto s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+		auto s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+		auto s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+		auto s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+		auto s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+		auto s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+		auto s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+
+		r0 = _mm256_permute2f128_ps(s0, s4, 0x20);
+		r1 = _mm256_permute2f128_ps(s1, s5, 0x20);
+		r2 = _mm256_permute2f128_ps(s2, s6, 0x20);
+		r3 = _mm256_permute2f128_ps(s3, s7, 0x20);
+		r4 = _mm256_permute2f128_ps(s0, s4, 0x31);
+		r5 = _mm256_permute2f128_ps(s1, s5, 0x31);
+		r6 = _mm256_permute2f128_ps(s2, s6, 0x31);
+		r7 = _mm256_permute2f128_ps(s3, s7, 0x31);
+	}
+
+	JAMMA_TARGET("avx2")
+	void DeinterleaveBlock8(float* const* dests,
+		const float* src,
+		unsigned int c,
+		unsigned int stride,
+		unsigned int i) noexcept
+	{
+		const auto* frame = src + static_cast<size_t>(i) * stride + c;
+		auto r0 = _mm256_loadu_ps(frame);
+		auto r1 = _mm256_loadu_ps(frame + stride);
+		auto r2 = _mm256_loadu_ps(frame + 2u * stride);
+		auto r3 = _mm256_loadu_ps(frame + 3u * stride);
+		auto r4 = _mm256_loadu_ps(frame + 4u * stride);
+		auto r5 = _mm256_loadu_ps(frame + 5u * stride);
+		auto r6 = _mm256_loadu_ps(frame + 6u * stride);
+		auto r7 = _mm256_loadu_ps(frame + 7u * stride);
+
+		Transpose8(r0, r1, r2, r3, r4, r5, r6, r7);
+
+		_mm256_storeu_ps(dests[c] + i, r0);
+		_mm256_storeu_ps(dests[c + 1u] + i, r1);
+		_mm256_storeu_ps(dests[c + 2u] + i, r2);
+		_mm256_storeu_ps(dests[c + 3u] + i, r3);
+		_mm256_storeu_ps(dests[c + 4u] + i, r4);
+		_mm256_storeu_ps(dests[c + 5u] + i, r5);
+		_mm256_storeu_ps(dests[c + 6u] + i, r6);
+		_mm256_storeu_ps(dests[c + 7u] + i, r7);
+	}
+
+	JAMMA_TARGET("avx2")
+	void InterleaveBlock8(float* dest,
+		const float* const* srcs,
+		unsigned int c,
+		unsigned int stride,
+		unsigned int i) noexcept
+	{
+		auto r0 = _mm256_loadu_ps(srcs[c] + i);
+		auto r1 = _mm256_loadu_ps(srcs[c + 1u] + i);
+		auto r2 = _mm256_loadu_ps(srcs[c + 2u] + i);
+		auto r3 = _mm256_loadu_ps(srcs[c + 3u] + i);
+		auto r4 = _mm256_loadu_ps(srcs[c + 4u] + i);
+		auto r5 = _mm256_loadu_ps(srcs[c + 5u] + i);
+		auto r6 = _mm256_loadu_ps(srcs[c + 6u] + i);
+		auto r7 = _mm256_loadu_ps(srcs[c + 7u] + i);
+
+		Transpose8(r0, r1, r2, r3, r4, r5, r6, r7);
+
+		auto* frame = dest + static_cast<size_t>(i) * stride + c;
+		_mm256_storeu_ps(frame, r0);
+		_mm256_storeu_ps(frame + stride, r1);
+		_mm256_storeu_ps(frame + 2u * stride, r2);
+		_mm256_storeu_ps(frame + 3u * stride, r3);
+		_mm256_storeu_ps(frame + 4u * stride, r4);
+		_mm256_storeu_ps(frame + 5u * stride, r5);
+		_mm256_storeu_ps(frame + 6u * stride, r6);
+		_mm256_storeu_ps(frame + 7u * stride, r7);
+	}
+
+	JAMMA_TARGET("sse2")
+	void DeinterleaveSse2(float* const* dests,
+		const float* src,
+		unsigned int numChans,
+		unsigned int stride,
+		unsigned int numSamps) noexcept
+	{
+		const auto numVecChans = numChans & ~3u;
+
+		for (auto tileStart = 0u; tileStart < numSamps; tileStart += TileSamps)
+		{
+			const auto tileEnd = std::min(numSamps, tileStart + TileSamps);
+			const auto vecEnd = tileStart + ((tileEnd - tileStart) & ~3u);
+
+			for (auto c = 0u; c < numVecChans; c += 4u)
+			{
+				for (auto i = tileStart; i < vecEnd; i += 4u)
+					DeinterleaveBlock4(dests, src, c, stride, i);
+			}
+
+			DeinterleaveRange(dests, src, 0u, numVecChans, stride, vecEnd, tileEnd);
+			DeinterleaveRange(dests, src, numVecChans, numChans, stride, tileStart, tileEnd);
+		}
+	}
+
+	JAMMA_TARGET("sse2")
+	void InterleaveSse2(float* dest,
+		const float* const* srcs,
+		unsigned int numChans,
+		unsigned int stride,
+		unsigned int numSamps) noexcept
+	{
+		const auto numVecChans = numChans & ~3u;
+
+		for (auto tileStart = 0u; tileStart < numSamps; tileStart += TileSamps)
+		{
+			const auto tileEnd = std::min(numSamps, tileStart + TileSamps);
+			const auto vecEnd = tileStart + ((tileEnd - tileStart) & ~3u);
+
+			for (auto c = 0u; c < numVecChans; c += 4u)
+			{
+				for (auto i = tileStart; i < vecEnd; i += 4u)
+					InterleaveBlock4(dest, srcs, c, stride, i);
+			}
+
+			InterleaveRange(dest, srcs, 0u, numVecChans, stride, vecEnd, tileEnd);
+			InterleaveRange(dest, srcs, numVecChans, numChans, stride, tileStart, tileEnd);
+		}
+	}
+
+	// Channels go eight at a time, then four, then one. Samples go eight
+	// at a time, then four in the four-channel groups, then one.
+	JAMMA_TARGET("avx2")
+	void DeinterleaveAvx2(float* const* dests,
+		const float* src,
+		unsigned int numChans,
+		unsigned int stride,
+		unsigned int numSamps) noexcept
+	{
+		const auto numChans8 = numChans & ~7u;
+		const auto numChans4 = numChans & ~3u;
+
+		for (auto tileStart = 0u; tileStart < numSamps; tileStart += TileSamps)
+		{
+			const auto tileEnd = std::min(numSamps, tileStart + TileSamps);
+			const auto vecEnd8 = tileStart + ((tileEnd - tileStart) & ~7u);
+			const auto vecEnd4 = tileStart + ((tileEnd - tileStart) & ~3u);
+
+			for (auto c = 0u; c < numChans8; c += 8u)
+			{
+				for (auto i = tileStart; i < vecEnd8; i += 8u)
+					DeinterleaveBlock8(dests, src, c, stride, i);
+			}
+
+			for (auto c = 0u; c < numChans4; c += 4u)
+			{
+				auto i = (c < numChans8) ? vecEnd8 : tileStart;
+				for (; i < vecEnd4; i += 4u)
+					DeinterleaveBlock4(dests, src, c, stride, i);
+			}
+
+			DeinterleaveRange(dests, src, 0u, numChans4, stride, vecEnd4, tileEnd);
+			DeinterleaveRange(dests, src, numChans4, numChans, stride, tileStart, tileEnd);
+		}
+	}
+
+	JAMMA_TARGET("avx2")
+	void InterleaveAvx2(float* dest,
+		const float* const* srcs,
+		unsigned int numChans,
+		unsigned int stride,
+		unsigned int numSamps) noexcept
+	{
+		const auto numChans8 = numChans & ~7u;
+		const auto numChans4 = numChans & ~3u;
+
+		for (auto tileStart = 0u; tileStart < numSamps; tileStart += TileSamps)
+		{
+			const auto tileEnd = std::min(numSamps, tileStart + TileSamps);
+			const auto vecEnd8 = tileStart + ((tileEnd - tileStart) & ~7u);
+			const auto vecEnd4 = tileStart + ((tileEnd - tileStart) & ~3u);
+
+			for (auto c = 0u; c < numChans8; c += 8u)
+			{
+				for (auto i = tileStart; i < vecEnd8; i += 8u)
+					InterleaveBlock8(dest, srcs, c, stride, i);
+			}
+
+			for (auto c = 0u; c < numChans4; c += 4u)
+			{
+				auto i = (c < numChans8) ? vecEnd8 : tileStart;
+				for (; i < vecEnd4; i += 4u)
+					InterleaveBlock4(dest, srcs, c, stride, i);
+			}
+
+			InterleaveRange(dest, srcs, 0u, numChans4, stride, vecEnd4, tileEnd);
+			InterleaveRange(dest, srcs, numChans4, numChans, stride, tileStart, tileEnd);
+		}
+	}
+#endif
+}
+
+InterleaveKernels::DeinterleaveFn InterleaveKernels::_activeDeinterleave =
+	InterleaveKernels::DeinterleaveKernel(FadeKernels::SupportedLevel());
+InterleaveKernels::InterleaveFn InterleaveKernels::_activeInterleave =
+	InterleaveKernels::InterleaveKernel(FadeKernels::SupportedLevel());
+
+// AVX-512 has no wider transpose worth the shuffles, so it runs the AVX2 kernels.
+InterleaveKernels::DeinterleaveFn InterleaveKernels::DeinterleaveKernel(FadeKernels::SimdLevel level) noexcept
+{
+	if (level > FadeKernels::SupportedLevel())
+		return nullptr;
+
+	switch (level)
+	{
+#ifdef JAMMA_INTERLEAVEKERNELS_X86
+	case FadeKernels::SIMD_SSE2:
+		return &DeinterleaveSse2;
+	case FadeKernels::SIMD_AVX2:
+	case FadeKernels::SIMD_AVX512:
+		return &DeinterleaveAvx2;
+#endif
+	case FadeKernels::SIMD_SCALAR:
+		return &DeinterleaveScalar;
+	default:
+		return nullptr;
+	}
+}
+
+InterleaveKernels::InterleaveFn InterleaveKernels::InterleaveKernel(FadeKernels::SimdLevel level) noexcept
+{
+	if (level > FadeKernels::SupportedLevel())
+		return nullptr;
+
+	switch (level)
+	{
+#ifdef JAMMA_INTERLEAVEKERNELS_X86
+	case FadeKernels::SIMD_SSE2:
+		return &InterleaveSse2;
+	case FadeKernels::SIMD_AVX2:
+	case FadeKernels::SIMD_AVX512:
+		return &InterleaveAvx2;
+#endif
+	case FadeKernels::SIMD_SCALAR:
+		return &InterleaveScalar;
+	default:
+		return nullptr;
+	}
+}
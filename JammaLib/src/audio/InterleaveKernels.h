@@ -0,0 +1,66 @@
+#pragma once
+
+#include "FadeKernels.h"
+
+namespace audio
+{
+	// Transpose kernels between an interleaved device buffer and planar
+	// channel buffers:
+	//
+	//   Deinterleave: dests[c][i] = src[(i * stride) + c]
+	//   Interleave:   dest[(i * stride) + c] = srcs[c][i]
+	//
+	// for every c < numChans <= stride. Interleaved channels at or above
+	// numChans are left untouched.
+	//
+	// The interleaved buffer is walked once, in tiles of TileSamps frames
+	// that stay in L1 while every channel is visited. Within a tile,
+	// channels are transposed in 4x4 (SSE2) or 8x8 (AVX2 and up) register
+	// blocks. The kernels only move samples, so every level is bit-identical.
+	// The level is the one FadeKernels picked at start-up.
+	// All kernels are real-time safe.
+	class InterleaveKernels
+	{
+	public:
+		static constexpr unsigned int TileSamps = 64u;
+
+		using DeinterleaveFn = void(*)(float* const* dests,
+			const float* src,
+			unsigned int numChans,
+			unsigned int stride,
+			unsigned int numSamps) noexcept;
+		using InterleaveFn = void(*)(float* dest,
+			const float* const* srcs,
+			unsigned int numChans,
+			unsigned int stride,
+			unsigned int numSamps) noexcept;
+
+	public:
+		// Dispatches to the active level.
+		static void Deinterleave(float* const* dests,
+			const float* src,
+			unsigned int numChans,
+			unsigned int stride,
+			unsigned int numSamps) noexcept
+		{
+			_activeDeinterleave(dests, src, numChans, stride, numSamps);
+		}
+
+		static void Interleave(float* dest,
+			const float* const* srcs,
+			unsigned int numChans,
+			unsigned int stride,
+			unsigned int numSamps) noexcept
+		{
+			_activeInterleave(dest, srcs, numChans, stride, numSamps);
+		}
+
+		// Kernel for an explicit level, or nullptr if the CPU lacks it.
+		static DeinterleaveFn DeinterleaveKernel(FadeKernels::SimdLevel level) noexcept;
+		static InterleaveFn InterleaveKernel(FadeKernels::SimdLevel level) noexcept;
+
+	private:
+		static DeinterleaveFn _activeDeinterleave;
+		static InterleaveFn _activeInterleave;
+	};
+}
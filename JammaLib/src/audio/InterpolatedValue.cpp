@@ -1,4 +1,5 @@
 #include "InterpolatedValue.h"
+#include <cmath>
 
 using namespace audio;
 
@@ -22,40 +23,38 @@ void InterpolatedValue::SetTarget(double target)
 	_target = target;
 }
 
+void InterpolatedValue::Advance(unsigned int numSamps)
+{
+}
+
+void InterpolatedValue::FillRamp(float* ramp, unsigned int numSamps)
+{
+	auto val = (float)_target;
+	for (auto i = 0u; i < numSamps; i++)
+		ramp[i] = val;
+}
+
 InterpolatedValueLinear::InterpolatedValueLinear() :
 	InterpolatedValue({}),
+	_endVal(0.0),
+	_dVal(0.0),
+	_lastVal(0.0),
 	_params({})
 {
 }
 
 InterpolatedValueLinear::InterpolatedValueLinear(InterpolatedValueLinear::LinearParams linearParams) :
 	InterpolatedValue(linearParams),
+	_endVal(0.0),
+	_dVal(0.0),
+	_lastVal(0.0),
 	_params(linearParams)
 {
 }
 
 double InterpolatedValueLinear::Next()
 {
-	auto currentVal = _lastVal;
-
-	if (_dVal > 0.0)
-	{
-		if (currentVal >= _target)
-		{
-			currentVal = _target;
-			_dVal = 0.0;
-		}
-	}
-	else if (_dVal < 0.0)
-	{
-		if (currentVal <= _target)
-		{
-			currentVal = _target;
-			_dVal = 0.0;
-		}
-	}
-
-	_lastVal = currentVal + _dVal;
+	Advance(1u);
 
 	return _lastVal;
 }
@@ -67,6 +66,8 @@ double InterpolatedValueLinear::Current() const
 
 void InterpolatedValueLinear::SetTarget(double target)
 {
+	_target = target;
+
 	if (_endVal != target)
 	{
 		_endVal = target;
@@ -81,10 +82,48 @@ void InterpolatedValueLinear::SetTarget(double target)
 void InterpolatedValueLinear::Jump(double target)
 {
 	_lastVal = target;
+	_target = target;
 	_endVal = target;
 	_dVal = 0.0;
 }
 
+void InterpolatedValueLinear::Advance(unsigned int numSamps)
+{
+	if ((0.0 == _dVal) || (0u == numSamps))
+		return;
+
+	auto nextVal = _lastVal + (_dVal * numSamps);
+	auto isDone = _dVal > 0.0 ?
+		nextVal >= _target :
+		nextVal <= _target;
+
+	if (isDone)
+	{
+		_lastVal = _target;
+		_dVal = 0.0;
+	}
+	else
+	{
+		_lastVal = nextVal;
+	}
+}
+
+void InterpolatedValueLinear::FillRamp(float* ramp, unsigned int numSamps)
+{
+	auto isRising = _dVal > 0.0;
+
+	for (auto i = 0u; i < numSamps; i++)
+	{
+		auto val = _lastVal + (_dVal * (i + 1u));
+		if (isRising ? (val > _target) : (val < _target))
+			val = _target;
+
+		ramp[i] = (float)val;
+	}
+
+	Advance(numSamps);
+}
+
 InterpolatedValueExp::InterpolatedValueExp() :
 	InterpolatedValue({}),
 	_lastVal(0.0),
@@ -124,3 +163,42 @@ bool InterpolatedValueExp::IsSettled() const
 	auto diff = _target - _lastVal;
 	return (diff > -SettleEpsilon) && (diff < SettleEpsilon);
 }
+
+// Each Next() scales the distance to the target by (1 - 1/Damping), so
+// n steps scale it by that factor to the power n. Once settled, the value
+// lands exactly on the target rather than decaying into denormals.
+void InterpolatedValueExp::Advance(unsigned int numSamps)
+{
+	if (0u == numSamps)
+		return;
+
+	auto decay = std::pow(_Decay(), (double)numSamps);
+	_lastVal = _target + ((_lastVal - _target) * decay);
+
+	if (InterpolatedValueExp::IsSettled())
+		_lastVal = _target;
+}
+
+void InterpolatedValueExp::FillRamp(float* ramp, unsigned int numSamps)
+{
+	auto decay = _Decay();
+	auto diff = _lastVal - _target;
+
+	for (auto i = 0u; i < numSamps; i++)
+	{
+		diff *= decay;
+		ramp[i] = (float)(_target + diff);
+	}
+
+	_lastVal = _target + diff;
+
+	if (InterpolatedValueExp::IsSettled())
+		_lastVal = _target;
+}
+
+double InterpolatedValueExp::_Decay() const
+{
+	return _params.Damping > 1.0 ?
+		1.0 - (1.0 / _params.Damping) :
+		0.0;
+}
@@ -22,6 +22,11 @@ namespace audio
 		virtual void SetTarget(double target);
 		virtual void Jump(double target) = 0;
 		virtual bool IsSettled() const { return true; }
+		// Block-rate equivalents of calling Next() numSamps times.
+		// Advance() jumps straight to the result, FillRamp() also writes
+		// each intermediate value into ramp[0..numSamps).
+		virtual void Advance(unsigned int numSamps);
+		virtual void FillRamp(float* ramp, unsigned int numSamps);
 
 	protected:
 		double _target;
@@ -46,6 +51,8 @@ namespace audio
 		virtual void SetTarget(double target) override;
 		virtual void Jump(double target) override;
 		virtual bool IsSettled() const override { return _dVal == 0.0; }
+		virtual void Advance(unsigned int numSamps) override;
+		virtual void FillRamp(float* ramp, unsigned int numSamps) override;
 
 	protected:
 		double _endVal;
@@ -72,6 +79,11 @@ namespace audio
 		virtual double Current() const;
 		virtual void Jump(double target) override;
 		virtual bool IsSettled() const override;
+		virtual void Advance(unsigned int numSamps) override;
+		virtual void FillRamp(float* ramp, unsigned int numSamps) override;
+
+	protected:
+		double _Decay() const;
 
 	protected:
 		double _lastVal;
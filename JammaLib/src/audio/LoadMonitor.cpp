@@ -0,0 +1,273 @@
+#include "LoadMonitor.h"
+#include "../include/Constants.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+using namespace audio;
+
+namespace
+{
+	// Weight of each block in the smoothed load
+	constexpr float LoadSmoothing = 1.0f / 16.0f;
+}
+
+LoadMonitor::LoadMonitor() :
+	_shedLoadPercent(constants::DefaultShedLoadPercent),
+	_recoverLoadPercent(constants::DefaultRecoverLoadPercent),
+	_shedBlocks(constants::DefaultShedBlocks),
+	_policy(),
+	_numPolicySteps(0u),
+	_isResetPending(false),
+	_numOverBlocks(0u),
+	_numUnderBlocks(0u),
+	_shedLevel(0u),
+	_shedFlags(SHED_NONE),
+	_numBlocks(0u),
+	_numLateBlocks(0u),
+	_numInputOverflows(0u),
+	_numOutputUnderflows(0u),
+	_loadPercent(0.0f),
+	_peakLoadPercent(0.0f),
+	_lastPolledLevel(0u),
+	_lastPolledXruns(0u)
+{
+	auto policy = DefaultPolicy();
+	for (auto i = 0u; i < policy.size(); i++)
+		_policy[i].store(policy[i], std::memory_order_relaxed);
+
+	_numPolicySteps.store(static_cast<unsigned int>(policy.size()), std::memory_order_relaxed);
+}
+
+LoadMonitor& LoadMonitor::Instance()
+{
+	static LoadMonitor monitor;
+	return monitor;
+}
+
+void LoadMonitor::Configure(unsigned int shedLoadPercent,
+	unsigned int recoverLoadPercent,
+	unsigned int shedBlocks,
+	const std::vector<ShedStep>& policy)
+{
+	_shedLoadPercent.store(shedLoadPercent, std::memory_order_relaxed);
+	_recoverLoadPercent.store(std::min(recoverLoadPercent, shedLoadPercent), std::memory_order_relaxed);
+	_shedBlocks.store(std::max(shedBlocks, 1u), std::memory_order_relaxed);
+
+	auto numSteps = std::min(static_cast<unsigned int>(policy.size()), MaxSteps);
+	for (auto i = 0u; i < numSteps; i++)
+		_policy[i].store(policy[i], std::memory_order_relaxed);
+
+	_numPolicySteps.store(numSteps, std::memory_order_relaxed);
+
+	_SetLevel(0u);
+	_isResetPending.store(true, std::memory_order_release);
+}
+
+std::optional<std::vector<LoadMonitor::ShedStep>> LoadMonitor::ParsePolicy(const std::string& policy)
+{
+	std::vector<ShedStep> steps;
+	std::stringstream ss(policy);
+	std::string name;
+
+	while (std::getline(ss, name, ','))
+	{
+		name.erase(0, name.find_first_not_of(' '));
+		name.erase(name.find_last_not_of(' ') + 1);
+
+		if (name.empty())
+			continue;
+
+		auto step = SHED_NONE;
+		for (auto candidate : { SHED_VISUALS, SHED_VU, SHED_QUIETVST })
+		{
+			if (name == StepName(candidate))
+				step = candidate;
+		}
+
+		if (SHED_NONE == step)
+			return std::nullopt;
+
+		if ((std::find(steps.begin(), steps.end(), step) == steps.end()) && (steps.size() < MaxSteps))
+			steps.push_back(step);
+	}
+
+	return steps;
+}
+
+std::vector<LoadMonitor::ShedStep> LoadMonitor::DefaultPolicy()
+{
+	return { SHED_VISUALS, SHED_VU, SHED_QUIETVST };
+}
+
+const char* LoadMonitor::StepName(ShedStep step) noexcept
+{
+	switch (step)
+	{
+	case SHED_VISUALS:
+		return "visuals";
+	case SHED_VU:
+		return "vu";
+	case SHED_QUIETVST:
+		return "vst";
+	default:
+		return "none";
+	}
+}
+
+void LoadMonitor::RecordBlock(std::uint64_t elapsedNs,
+	unsigned int numSamps,
+	unsigned int sampleRate,
+	bool isInputOverflow,
+	bool isOutputUnderflow) noexcept
+{
+	if (_isResetPending.exchange(false, std::memory_order_acquire))
+	{
+		_numOverBlocks = 0u;
+		_numUnderBlocks = 0u;
+	}
+
+	if ((0u == numSamps) || (0u == sampleRate))
+		return;
+
+	auto periodNs = (static_cast<double>(numSamps) * 1.0e9) / static_cast<double>(sampleRate);
+	auto load = static_cast<float>((100.0 * static_cast<double>(elapsedNs)) / periodNs);
+
+	_numBlocks.fetch_add(1u, std::memory_order_relaxed);
+
+	if (load >= 100.0f)
+		_numLateBlocks.fetch_add(1u, std::memory_order_relaxed);
+	if (isInputOverflow)
+		_numInputOverflows.fetch_add(1u, std::memory_order_relaxed);
+	if (isOutputUnderflow)
+		_numOutputUnderflows.fetch_add(1u, std::memory_order_relaxed);
+
+	auto smoothed = _loadPercent.load(std::memory_order_relaxed);
+	_loadPercent.store(smoothed + (LoadSmoothing * (load - smoothed)), std::memory_order_relaxed);
+
+	if (load > _peakLoadPercent.load(std::memory_order_relaxed))
+		_peakLoadPercent.store(load, std::memory_order_relaxed);
+
+	auto shedLoad = _shedLoadPercent.load(std::memory_order_relaxed);
+	if (0u == shedLoad)
+	{
+		if (_shedLevel.load(std::memory_order_relaxed) > 0u)
+			_SetLevel(0u);
+
+		return;
+	}
+
+	auto isXrun = isInputOverflow || isOutputUnderflow;
+	auto isOver = isXrun || (load >= static_cast<float>(shedLoad));
+	auto isUnder = !isXrun && (load < static_cast<float>(_recoverLoadPercent.load(std::memory_order_relaxed)));
+
+	// Blocks in between the two thresholds hold the current level
+	_numOverBlocks = isOver ? _numOverBlocks + 1u : 0u;
+	_numUnderBlocks = isUnder ? _numUnderBlocks + 1u : 0u;
+
+	auto shedBlocks = _shedBlocks.load(std::memory_order_relaxed);
+	auto level = _shedLevel.load(std::memory_order_relaxed);
+
+	if (_numOverBlocks >= shedBlocks)
+	{
+		_numOverBlocks = 0u;
+
+		if (level < _numPolicySteps.load(std::memory_order_relaxed))
+			_SetLevel(level + 1u);
+	}
+	else if (_numUnderBlocks >= shedBlocks * RecoverScale)
+	{
+		_numUnderBlocks = 0u;
+
+		if (level > 0u)
+			_SetLevel(level - 1u);
+	}
+}
+
+LoadMonitor::Status LoadMonitor::GetStatus() const
+{
+	Status status;
+	status.NumBlocks = _numBlocks.load(std::memory_order_relaxed);
+	status.NumLateBlocks = _numLateBlocks.load(std::memory_order_relaxed);
+	status.NumInputOverflows = _numInputOverflows.load(std::memory_order_relaxed);
+	status.NumOutputUnderflows = _numOutputUnderflows.load(std::memory_order_relaxed);
+	status.LoadPercent = _loadPercent.load(std::memory_order_relaxed);
+	status.PeakLoadPercent = _peakLoadPercent.load(std::memory_order_relaxed);
+	status.ShedLevel = _shedLevel.load(std::memory_order_relaxed);
+	status.ShedFlags = _shedFlags.load(std::memory_order_relaxed);
+
+	return status;
+}
+
+std::optional<LoadMonitor::Status> LoadMonitor::PollChange(bool includeXruns)
+{
+	auto status = GetStatus();
+	auto numXruns = status.NumInputOverflows + status.NumOutputUnderflows;
+
+	auto isChanged = (status.ShedLevel != _lastPolledLevel) ||
+		(includeXruns && (numXruns != _lastPolledXruns));
+
+	_lastPolledLevel = status.ShedLevel;
+	_lastPolledXruns = numXruns;
+
+	if (!isChanged)
+		return std::nullopt;
+
+	return status;
+}
+
+void LoadMonitor::Reset()
+{
+	_SetLevel(0u);
+	_isResetPending.store(true, std::memory_order_release);
+
+	_numBlocks.store(0u, std::memory_order_relaxed);
+	_numLateBlocks.store(0u, std::memory_order_relaxed);
+	_numInputOverflows.store(0u, std::memory_order_relaxed);
+	_numOutputUnderflows.store(0u, std::memory_order_relaxed);
+	_loadPercent.store(0.0f, std::memory_order_relaxed);
+	_peakLoadPercent.store(0.0f, std::memory_order_relaxed);
+}
+
+std::string LoadMonitor::FormatStatus(const Status& status)
+{
+	std::stringstream ss;
+	ss << std::fixed << std::setprecision(0)
+		<< "load " << status.LoadPercent << "% (peak " << status.PeakLoadPercent << "%)"
+		<< ", late " << status.NumLateBlocks << "/" << status.NumBlocks
+		<< ", xruns in " << status.NumInputOverflows << " out " << status.NumOutputUnderflows
+		<< ", shedding ";
+
+	if (SHED_NONE == status.ShedFlags)
+	{
+		ss << "none";
+	}
+	else
+	{
+		auto isFirst = true;
+		for (auto step : { SHED_VISUALS, SHED_VU, SHED_QUIETVST })
+		{
+			if (0u == (status.ShedFlags & step))
+				continue;
+
+			ss << (isFirst ? "" : "+") << StepName(step);
+			isFirst = false;
+		}
+	}
+
+	return ss.str();
+}
+
+void LoadMonitor::_SetLevel(unsigned int level) noexcept
+{
+	auto numSteps = _numPolicySteps.load(std::memory_order_relaxed);
+	level = std::min(level, numSteps);
+
+	auto flags = static_cast<unsigned int>(SHED_NONE);
+	for (auto i = 0u; i < level; i++)
+		flags |= _policy[i].load(std::memory_order_relaxed);
+
+	_shedFlags.store(flags, std::memory_order_relaxed);
+	_shedLevel.store(level, std::memory_order_relaxed);
+}
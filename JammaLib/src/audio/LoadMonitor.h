@@ -0,0 +1,116 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace audio
+{
+	// Watches how close each device callback comes to its deadline, tallies
+	// the over/underflows the driver reports, and sheds optional work while
+	// the engine is overloaded.
+	//
+	// A block counts as overloaded when it took at least shedLoadPercent of
+	// its buffer period or the driver flagged an xrun. After shedBlocks
+	// overloaded blocks in a row the next step of the policy is switched on;
+	// after RecoverScale times as many blocks below recoverLoadPercent the
+	// most recent step is switched off again. Code that can do without some
+	// work checks IsShedding() once per block.
+	//
+	// RecordBlock runs on the audio thread only. Offline renders never call
+	// it, so they always run the full engine.
+	class LoadMonitor
+	{
+	public:
+		enum ShedStep : unsigned int
+		{
+			SHED_NONE = 0u,
+			SHED_VISUALS = 1u << 0,   // Skip loop waveform model refreshes
+			SHED_VU = 1u << 1,        // Skip VU peak tracking
+			SHED_QUIETVST = 1u << 2   // Bypass VST chains on muted or silent loops
+		};
+
+		static constexpr unsigned int MaxSteps = 3u;
+		static constexpr unsigned int RecoverScale = 4u;
+
+		struct Status
+		{
+			std::uint64_t NumBlocks = 0u;
+			std::uint64_t NumLateBlocks = 0u;
+			std::uint64_t NumInputOverflows = 0u;
+			std::uint64_t NumOutputUnderflows = 0u;
+			float LoadPercent = 0.0f;
+			float PeakLoadPercent = 0.0f;
+			unsigned int ShedLevel = 0u;
+			unsigned int ShedFlags = SHED_NONE;
+		};
+
+	public:
+		LoadMonitor(const LoadMonitor&) = delete;
+		LoadMonitor& operator=(const LoadMonitor&) = delete;
+
+		static LoadMonitor& Instance();
+
+		// Steps are taken in the order given. A shedLoadPercent of 0 turns
+		// shedding off, but load and xruns are still tracked.
+		void Configure(unsigned int shedLoadPercent,
+			unsigned int recoverLoadPercent,
+			unsigned int shedBlocks,
+			const std::vector<ShedStep>& policy);
+		// Parses a comma-separated list such as "visuals,vu,vst". Returns
+		// nullopt if any entry is unknown.
+		static std::optional<std::vector<ShedStep>> ParsePolicy(const std::string& policy);
+		static std::vector<ShedStep> DefaultPolicy();
+		static const char* StepName(ShedStep step) noexcept;
+
+		// Audio thread
+		void RecordBlock(std::uint64_t elapsedNs,
+			unsigned int numSamps,
+			unsigned int sampleRate,
+			bool isInputOverflow,
+			bool isOutputUnderflow) noexcept;
+		bool IsShedding(ShedStep step) const noexcept { return 0u != (_shedFlags.load(std::memory_order_relaxed) & step); }
+
+		Status GetStatus() const;
+		// The current status when shedding has changed since the last call,
+		// or, when includeXruns is set, when new xruns have been reported.
+		// Polled from the job thread for logging.
+		std::optional<Status> PollChange(bool includeXruns);
+		// Drops any shedding and restarts the counts.
+		void Reset();
+		static std::string FormatStatus(const Status& status);
+
+	protected:
+		LoadMonitor();
+
+		void _SetLevel(unsigned int level) noexcept;
+
+	protected:
+		std::atomic<unsigned int> _shedLoadPercent;
+		std::atomic<unsigned int> _recoverLoadPercent;
+		std::atomic<unsigned int> _shedBlocks;
+		std::array<std::atomic<unsigned int>, MaxSteps> _policy;
+		std::atomic<unsigned int> _numPolicySteps;
+		std::atomic<bool> _isResetPending;
+
+		// Audio thread only
+		unsigned int _numOverBlocks;
+		unsigned int _numUnderBlocks;
+
+		std::atomic<unsigned int> _shedLevel;
+		std::atomic<unsigned int> _shedFlags;
+		std::atomic<std::uint64_t> _numBlocks;
+		std::atomic<std::uint64_t> _numLateBlocks;
+		std::atomic<std::uint64_t> _numInputOverflows;
+		std::atomic<std::uint64_t> _numOutputUnderflows;
+		std::atomic<float> _loadPercent;
+		std::atomic<float> _peakLoadPercent;
+
+		// Job thread
+		unsigned int _lastPolledLevel;
+		std::uint64_t _lastPolledXruns;
+	};
+}
@@ -0,0 +1,312 @@
+#include "OfflineRenderer.h"
+#include "../actions/KeyAction.h"
+#include "../io/WavReadWriter.h"
+#include "../utils/Epoch.h"
+#include <algorithm>
+#include <chrono>
+
+using namespace audio;
+using actions::KeyAction;
+
+double OfflineRenderer::RenderStats::BlocksPerSec() const noexcept
+{
+	return (WallSecs > 0.0) ? static_cast<double>(NumBlocks) / WallSecs : 0.0;
+}
+
+double OfflineRenderer::RenderStats::RealtimeFactor(unsigned int sampleRate) const noexcept
+{
+	if ((WallSecs <= 0.0) || (0u == sampleRate))
+		return 0.0;
+
+	return (static_cast<double>(NumSamps) / static_cast<double>(sampleRate)) / WallSecs;
+}
+
+OfflineRenderer::OfflineRenderer(AudioHost& host,
+	const AudioStreamParams& streamParams,
+	StationList stations) :
+	_host(host),
+	_streamParams(streamParams),
+	_stations(std::move(stations)),
+	_events(),
+	_nextEvent(0u),
+	_input(),
+	_inBlock(),
+	_outBlock(),
+	_output(),
+	_samplePos(0u),
+	_commitIntervalSamps(std::max(1u, streamParams.SampleRate / 60u)),
+	_sampsSinceCommit(0u)
+{
+	_streamParams.BufSize = std::clamp(_streamParams.BufSize, 1u, constants::MaxBlockSize);
+	_inBlock.resize(static_cast<std::size_t>(_streamParams.NumInputChannels) * _streamParams.BufSize, 0.0f);
+	_outBlock.resize(static_cast<std::size_t>(_streamParams.NumOutputChannels) * _streamParams.BufSize, 0.0f);
+
+	_host.SetStations(std::make_shared<const StationList>(_stations));
+	_host.InitOffline(_streamParams,
+		[this](std::uint64_t sampleTime, unsigned int numSamps, const io::UserConfig& cfg, const AudioStreamParams& params) {
+			_OnTick(sampleTime, numSamps, cfg, params);
+		});
+
+	_CommitStations();
+}
+
+void OfflineRenderer::SetInput(std::vector<float> interleaved)
+{
+	_input = std::move(interleaved);
+}
+
+bool OfflineRenderer::LoadInputWavs(const std::vector<std::wstring>& fileNames)
+{
+	const auto numChans = _streamParams.NumInputChannels;
+	if ((0u == numChans) || (fileNames.size() != numChans))
+		return false;
+
+	io::WavReadWriter reader;
+	std::vector<std::vector<float>> channels;
+	std::size_t numSamps = 0u;
+
+	for (const auto& fileName : fileNames)
+	{
+		auto wav = reader.Read(fileName, static_cast<unsigned int>(constants::MaxLoopBufferSize));
+		if (!wav.has_value())
+			return false;
+
+		auto& [samples, numRead, sampleRate] = wav.value();
+		samples.resize(numRead);
+		numSamps = std::max(numSamps, samples.size());
+		channels.push_back(std::move(samples));
+	}
+
+	std::vector<float> interleaved(numSamps * numChans, 0.0f);
+	for (auto chan = 0u; chan < numChans; chan++)
+	{
+		const auto& samples = channels[chan];
+		for (auto i = 0u; i < samples.size(); i++)
+			interleaved[(i * numChans) + chan] = samples[i];
+	}
+
+	SetInput(std::move(interleaved));
+	return true;
+}
+
+void OfflineRenderer::AddEvent(const OfflineEvent& event)
+{
+	// Keeps events stable-sorted by time, after any with the same time
+	auto pos = std::upper_bound(_events.begin() + _nextEvent, _events.end(), event,
+		[](const OfflineEvent& lhs, const OfflineEvent& rhs) { return lhs.SampleTime < rhs.SampleTime; });
+	_events.insert(pos, event);
+}
+
+OfflineRenderer::RenderStats OfflineRenderer::Render(std::uint64_t numSamps)
+{
+	RenderStats stats;
+	const auto endSamp = _samplePos + numSamps;
+	const auto numOutChans = _streamParams.NumOutputChannels;
+	auto inBuf = _inBlock.empty() ? nullptr : _inBlock.data();
+	auto outBuf = _outBlock.empty() ? nullptr : _outBlock.data();
+
+	_output.reserve(_output.size() + static_cast<std::size_t>(numSamps * numOutChans));
+
+	auto startTime = std::chrono::steady_clock::now();
+
+	while (_samplePos < endSamp)
+	{
+		auto blockSamps = static_cast<unsigned int>(std::min(static_cast<std::uint64_t>(_streamParams.BufSize), endSamp - _samplePos));
+		stats.NumEvents += _DispatchDueEvents(_samplePos + blockSamps);
+
+		_FillInput(blockSamps);
+
+		auto streamTime = static_cast<double>(_samplePos) / static_cast<double>(std::max(1u, _streamParams.SampleRate));
+		_host.RenderOffline(inBuf, outBuf, blockSamps, streamTime);
+
+		if (nullptr != outBuf)
+			_output.insert(_output.end(), outBuf, outBuf + (static_cast<std::size_t>(blockSamps) * numOutChans));
+
+		_samplePos += blockSamps;
+		stats.NumBlocks++;
+		stats.NumSamps += blockSamps;
+
+		_sampsSinceCommit += blockSamps;
+		if (_sampsSinceCommit >= _commitIntervalSamps)
+			_CommitStations();
+	}
+
+	stats.WallSecs = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	return stats;
+}
+
+bool OfflineRenderer::WriteOutputWavs(const std::wstring& fileNamePrefix) const
+{
+	const auto numChans = _streamParams.NumOutputChannels;
+	if ((0u == numChans) || _output.empty())
+		return false;
+
+	const auto numSamps = static_cast<unsigned long>(_output.size() / numChans);
+
+	io::WavFormat format;
+	format.SampleFormat = io::WavSampleFormat::Float32;
+	format.SampleRate = _streamParams.SampleRate;
+
+	for (auto chan = 0u; chan < numChans; chan++)
+	{
+		auto fileName = fileNamePrefix + L"_" + std::to_wstring(chan) + L".wav";
+		io::WavReadWriter::CreateDirectory(fileName);
+
+		io::WavFileWriter writer;
+		if (!writer.Open(fileName, format))
+			return false;
+
+		auto isWritten = writer.WriteStrided(_output.data() + chan, numSamps, numChans);
+		if (!writer.Close() || !isWritten)
+			return false;
+	}
+
+	return true;
+}
+
+bool OfflineRenderer::WriteOutputWav(const std::wstring& fileName) const
+{
+	const auto numChans = _streamParams.NumOutputChannels;
+	if ((0u == numChans) || _output.empty())
+		return false;
+
+	io::WavFormat format;
+	format.SampleFormat = io::WavSampleFormat::Float32;
+	format.NumChannels = numChans;
+	format.SampleRate = _streamParams.SampleRate;
+
+	io::WavReadWriter::CreateDirectory(fileName);
+
+	io::WavFileWriter writer;
+	if (!writer.Open(fileName, format))
+		return false;
+
+	auto isWritten = writer.Write(_output.data(), static_cast<unsigned long>(_output.size() / numChans));
+
+	return writer.Close() && isWritten;
+}
+
+unsigned int OfflineRenderer::_DispatchDueEvents(std::uint64_t blockEnd)
+{
+	auto numDispatched = 0u;
+
+	while ((_nextEvent < _events.size()) && (_events[_nextEvent].SampleTime < blockEnd))
+	{
+		_DispatchEvent(_events[_nextEvent]);
+		_nextEvent++;
+		numDispatched++;
+	}
+
+	if (numDispatched > 0u)
+		_CommitStations();
+
+	return numDispatched;
+}
+
+void OfflineRenderer::_DispatchEvent(const OfflineEvent& event)
+{
+	if (event.StationIndex >= _stations.size())
+		return;
+
+	auto& station = _stations[event.StationIndex];
+	if (!station)
+		return;
+
+	switch (event.Type)
+	{
+	case OfflineEvent::EVENT_KEY:
+	{
+		KeyAction action;
+		action.KeyChar = event.KeyChar;
+		action.KeyActionType = event.IsKeyDown ? KeyAction::KEY_DOWN : KeyAction::KEY_UP;
+		action.SetActionTime(_RenderTime(event.SampleTime));
+		action.SetSampleTime(event.SampleTime);
+		action.SetUserConfig(_host.GetUserConfig());
+		action.SetAudioParams(_streamParams);
+		station->OnAction(action);
+		break;
+	}
+	case OfflineEvent::EVENT_MIDI:
+	{
+		if (event.MidiTrigger)
+		{
+			base::Action action;
+			action.SetActionTime(_RenderTime(event.SampleTime));
+			action.SetSampleTime(event.SampleTime);
+			action.SetUserConfig(_host.GetUserConfig());
+			action.SetAudioParams(_streamParams);
+			event.MidiTrigger->OnEvent(event.Midi, action);
+		}
+
+		const auto msgType = event.Midi.MessageType();
+		if ((msgType >= 0x80u) && (msgType <= 0xE0u))
+		{
+			// Live MIDI is stamped with the engine sample, which for an
+			// offline host counts from the start of the render
+			auto midi = event.Midi;
+			midi.sampleOffset = static_cast<std::uint32_t>(event.SampleTime);
+			station->EnqueueLiveMidiEvent(midi);
+		}
+		break;
+	}
+	}
+}
+
+Time OfflineRenderer::_RenderTime(std::uint64_t sampleTime) const
+{
+	// Counted from the clock's epoch, so renders never see the wall clock
+	auto secs = std::chrono::duration<double>(static_cast<double>(sampleTime) / static_cast<double>(std::max(1u, _streamParams.SampleRate)));
+
+	return Time(std::chrono::duration_cast<Time::duration>(secs));
+}
+
+void OfflineRenderer::_CommitStations()
+{
+	// Mirrors Scene::CommitChanges, running every job in line
+	for (auto& station : _stations)
+	{
+		station->UpdateBounceRoutes();
+		auto jobs = station->CommitChanges();
+
+		while (!jobs.empty())
+		{
+			for (auto& job : jobs)
+			{
+				auto receiver = job.Receiver.lock();
+				if (receiver)
+					receiver->OnAction(job);
+			}
+
+			jobs = station->CommitChanges();
+		}
+	}
+
+	utils::EpochDomain::Instance().Reclaim();
+	_sampsSinceCommit = 0u;
+}
+
+void OfflineRenderer::_FillInput(unsigned int numSamps)
+{
+	const auto numChans = static_cast<std::size_t>(_streamParams.NumInputChannels);
+	if (0u == numChans)
+		return;
+
+	const auto numVals = numSamps * numChans;
+	const auto start = static_cast<std::size_t>(_samplePos) * numChans;
+	const auto numAvailable = (start < _input.size()) ? std::min(numVals, _input.size() - start) : 0u;
+
+	if (numAvailable > 0u)
+		std::copy(_input.begin() + start, _input.begin() + start + numAvailable, _inBlock.begin());
+
+	std::fill(_inBlock.begin() + numAvailable, _inBlock.begin() + numVals, 0.0f);
+}
+
+void OfflineRenderer::_OnTick(std::uint64_t sampleTime,
+	unsigned int numSamps,
+	const io::UserConfig& cfg,
+	const AudioStreamParams& params)
+{
+	for (auto& station : _stations)
+		station->OnTick(sampleTime, numSamps, cfg, params);
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "AudioHost.h"
+#include "../engine/Station.h"
+#include "../engine/Trigger.h"
+#include "../midi/MidiEvent.h"
+
+namespace audio
+{
+	// An input event fired at an exact sample position during an offline render.
+	struct OfflineEvent
+	{
+		enum EventType
+		{
+			EVENT_KEY,
+			EVENT_MIDI
+		};
+
+		std::uint64_t SampleTime = 0u;
+		EventType Type = EVENT_KEY;
+		unsigned int StationIndex = 0u;
+
+		// EVENT_KEY
+		unsigned int KeyChar = 0u;
+		bool IsKeyDown = true;
+
+		// EVENT_MIDI. Channel messages go to the station's live MIDI, and to
+		// MidiTrigger's bindings if set, as the MIDI router would send them.
+		midi::MidiEvent Midi{};
+		std::shared_ptr<engine::Trigger> MidiTrigger;
+	};
+
+	// Drives the full AudioHost callback path with no audio device, as fast
+	// as the CPU allows.
+	//
+	// Input comes from an interleaved buffer and output is collected into
+	// another, so renders can be timed and compared sample for sample.
+	// Events due in a block are dispatched before it, stamped with their
+	// render sample (never the wall clock), and land on that sample as
+	// stamped live input does. Blocks are never split, so events do not
+	// move the block boundaries. Station changes are committed at a fixed
+	// sample interval (standing in for the UI frame) and after every event,
+	// with their jobs run in line on the rendering thread.
+	//
+	// The host's tick callback is bound to the renderer, so the host must not
+	// be rendered after the renderer is destroyed.
+	class OfflineRenderer
+	{
+	public:
+		using StationList = std::vector<std::shared_ptr<engine::Station>>;
+
+		struct RenderStats
+		{
+			std::uint64_t NumBlocks = 0u;
+			std::uint64_t NumSamps = 0u;
+			std::uint64_t NumEvents = 0u;
+			double WallSecs = 0.0;
+
+			double BlocksPerSec() const noexcept;
+			// Seconds of audio rendered per second of wall time
+			double RealtimeFactor(unsigned int sampleRate) const noexcept;
+		};
+
+	public:
+		OfflineRenderer(AudioHost& host,
+			const AudioStreamParams& streamParams,
+			StationList stations);
+
+		OfflineRenderer(const OfflineRenderer&) = delete;
+		OfflineRenderer& operator=(const OfflineRenderer&) = delete;
+
+	public:
+		// Interleaved over the stream's input channels. Silence follows the end.
+		void SetInput(std::vector<float> interleaved);
+		// One mono file per input channel
+		bool LoadInputWavs(const std::vector<std::wstring>& fileNames);
+		void AddEvent(const OfflineEvent& event);
+		void SetCommitIntervalSamps(unsigned int commitIntervalSamps) noexcept
+		{
+			_commitIntervalSamps = commitIntervalSamps;
+		}
+
+		RenderStats Render(std::uint64_t numSamps);
+
+		std::uint64_t SamplePos() const noexcept { return _samplePos; }
+		// Interleaved over the stream's output channels, since construction
+		const std::vector<float>& Output() const noexcept { return _output; }
+		void ClearOutput() { _output.clear(); }
+		// Writes one mono file per output channel, named <prefix>_<chan>.wav
+		bool WriteOutputWavs(const std::wstring& fileNamePrefix) const;
+		// Writes every output channel to one interleaved file
+		bool WriteOutputWav(const std::wstring& fileName) const;
+
+	protected:
+		// Dispatches every event before blockEnd, stamped with its sample
+		unsigned int _DispatchDueEvents(std::uint64_t blockEnd);
+		void _DispatchEvent(const OfflineEvent& event);
+		Time _RenderTime(std::uint64_t sampleTime) const;
+		void _CommitStations();
+		void _FillInput(unsigned int numSamps);
+		void _OnTick(std::uint64_t sampleTime,
+			unsigned int numSamps,
+			const io::UserConfig& cfg,
+			const AudioStreamParams& params);
+
+	protected:
+		AudioHost& _host;
+		AudioStreamParams _streamParams;
+		StationList _stations;
+		std::vector<OfflineEvent> _events;
+		std::size_t _nextEvent;
+		std::vector<float> _input;
+		std::vector<float> _inBlock;
+		std::vector<float> _outBlock;
+		std::vector<float> _output;
+		std::uint64_t _samplePos;
+		unsigned int _commitIntervalSamps;
+		unsigned int _sampsSinceCommit;
+	};
+}
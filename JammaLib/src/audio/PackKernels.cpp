@@ -0,0 +1,74 @@
+#include "PackKernels.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define JAMMA_PACKKERNELS_SSE2
+#include <emmintrin.h>
+#endif
+
+using namespace audio;
+
+namespace
+{
+	void UnpackScalar(const std::int16_t* src,
+		float scale,
+		unsigned int numSamps,
+		float* dest) noexcept
+	{
+		for (auto i = 0u; i < numSamps; i++)
+			dest[i] = static_cast<float>(src[i]) * scale;
+	}
+}
+
+float PackKernels::Pack(const float* src,
+	unsigned int numSamps,
+	std::int16_t* dest) noexcept
+{
+	auto peak = 0.0f;
+	for (auto i = 0u; i < numSamps; i++)
+		peak = std::max(peak, std::abs(src[i]));
+
+	if (!(peak > 0.0f) || !std::isfinite(peak))
+	{
+		std::fill_n(dest, numSamps, static_cast<std::int16_t>(0));
+		return 0.0f;
+	}
+
+	auto toPacked = MaxPacked / peak;
+
+	for (auto i = 0u; i < numSamps; i++)
+	{
+		auto packed = std::lround(src[i] * toPacked);
+		dest[i] = static_cast<std::int16_t>(std::clamp(packed, -32767l, 32767l));
+	}
+
+	return peak / MaxPacked;
+}
+
+void PackKernels::Unpack(const std::int16_t* src,
+	float scale,
+	unsigned int numSamps,
+	float* dest) noexcept
+{
+	auto i = 0u;
+
+#ifdef JAMMA_PACKKERNELS_SSE2
+	const auto gain = _mm_set1_ps(scale);
+
+	for (; i + 8u <= numSamps; i += 8u)
+	{
+		auto packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+
+		// Sign-extend by moving each value to the high half and shifting back
+		auto lo = _mm_srai_epi32(_mm_unpacklo_epi16(packed, packed), 16);
+		auto hi = _mm_srai_epi32(_mm_unpackhi_epi16(packed, packed), 16);
+
+		_mm_storeu_ps(dest + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), gain));
+		_mm_storeu_ps(dest + i + 4u, _mm_mul_ps(_mm_cvtepi32_ps(hi), gain));
+	}
+#endif
+
+	UnpackScalar(src + i, scale, numSamps - i, dest + i);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+namespace audio
+{
+	// 16-bit block-scaled sample packing for loops that have gone idle.
+	//
+	// Each block of samples is stored as 16-bit integers plus one float
+	// scale, taken from the block's peak so quiet passages keep their
+	// resolution:
+	//
+	//   src[i] ~= packed[i] * scale,   scale = max(|src|) / 32767
+	//
+	// Rounding error is at most half a step, i.e. max(|src|) / 65534 per
+	// sample. Pack runs off the audio thread. Unpack is real-time safe and
+	// uses SSE2 where available; every level gives identical output.
+	class PackKernels
+	{
+	public:
+		static constexpr float MaxPacked = 32767.0f;
+
+	public:
+		// Packs numSamps samples into dest and returns the block's scale.
+		static float Pack(const float* src,
+			unsigned int numSamps,
+			std::int16_t* dest) noexcept;
+		// dest[i] = src[i] * scale.
+		static void Unpack(const std::int16_t* src,
+			float scale,
+			unsigned int numSamps,
+			float* dest) noexcept;
+	};
+}
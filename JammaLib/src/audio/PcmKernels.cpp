@@ -0,0 +1,262 @@
+#include "PcmKernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define JAMMA_PCMKERNELS_SSE2
+#include <emmintrin.h>
+#endif
+
+using namespace audio;
+
+namespace
+{
+	// Largest float below 2^31, so full scale never overflows an int32
+	constexpr float MaxInt32Float = 2147483520.0f;
+
+	float ClampUnit(float value) noexcept
+	{
+		return std::min(std::max(value, -1.0f), 1.0f);
+	}
+
+	// Triangular noise in (-1, 1) steps, from the difference of two
+	// uniform draws off a xorshift generator
+	float NextNoise(PcmKernels::Dither& dither) noexcept
+	{
+		auto next = [&dither]() {
+			auto state = dither.State;
+			state ^= state << 13;
+			state ^= state >> 17;
+			state ^= state << 5;
+			dither.State = state;
+
+			return static_cast<float>(state >> 8) * (1.0f / 16777216.0f);
+		};
+
+		auto first = next();
+		return first - next();
+	}
+
+	void Int16ToFloatScalar(const std::uint8_t* src,
+		unsigned long numSamps,
+		float* dest) noexcept
+	{
+		for (auto i = 0ul; i < numSamps; i++)
+		{
+			auto value = static_cast<std::int16_t>(src[2ul * i] | (src[2ul * i + 1ul] << 8));
+			dest[i] = static_cast<float>(value) * PcmKernels::Int16Scale;
+		}
+	}
+
+	void Int32ToFloatScalar(const std::uint8_t* src,
+		unsigned long numSamps,
+		float* dest) noexcept
+	{
+		for (auto i = 0ul; i < numSamps; i++)
+		{
+			const auto* bytes = src + (4ul * i);
+			auto value = static_cast<std::uint32_t>(bytes[0]) |
+				static_cast<std::uint32_t>(bytes[1]) << 8 |
+				static_cast<std::uint32_t>(bytes[2]) << 16 |
+				static_cast<std::uint32_t>(bytes[3]) << 24;
+
+			dest[i] = static_cast<float>(static_cast<std::int32_t>(value)) * PcmKernels::Int32Scale;
+		}
+	}
+
+	void FloatToInt16Scalar(const float* src,
+		unsigned long numSamps,
+		std::uint8_t* dest) noexcept
+	{
+		for (auto i = 0ul; i < numSamps; i++)
+		{
+			auto value = static_cast<long>(std::nearbyint(ClampUnit(src[i]) * 32768.0f));
+			value = std::min(value, 32767l);
+
+			dest[2ul * i] = static_cast<std::uint8_t>(value & 0xff);
+			dest[2ul * i + 1ul] = static_cast<std::uint8_t>((value >> 8) & 0xff);
+		}
+	}
+
+	void FloatToInt32Scalar(const float* src,
+		unsigned long numSamps,
+		std::uint8_t* dest) noexcept
+	{
+		for (auto i = 0ul; i < numSamps; i++)
+		{
+			auto scaled = std::min(ClampUnit(src[i]) * 2147483648.0f, MaxInt32Float);
+			auto value = static_cast<std::uint32_t>(static_cast<std::int32_t>(std::nearbyint(scaled)));
+
+			auto* bytes = dest + (4ul * i);
+			bytes[0] = static_cast<std::uint8_t>(value & 0xff);
+			bytes[1] = static_cast<std::uint8_t>((value >> 8) & 0xff);
+			bytes[2] = static_cast<std::uint8_t>((value >> 16) & 0xff);
+			bytes[3] = static_cast<std::uint8_t>((value >> 24) & 0xff);
+		}
+	}
+}
+
+void PcmKernels::Int16ToFloat(const std::uint8_t* src,
+	unsigned long numSamps,
+	float* dest) noexcept
+{
+	auto i = 0ul;
+
+#ifdef JAMMA_PCMKERNELS_SSE2
+	const auto gain = _mm_set1_ps(Int16Scale);
+
+	for (; i + 8ul <= numSamps; i += 8ul)
+	{
+		auto pcm = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + (2ul * i)));
+
+		// Sign-extend by moving each value to the high half and shifting back
+		auto lo = _mm_srai_epi32(_mm_unpacklo_epi16(pcm, pcm), 16);
+		auto hi = _mm_srai_epi32(_mm_unpackhi_epi16(pcm, pcm), 16);
+
+		_mm_storeu_ps(dest + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), gain));
+		_mm_storeu_ps(dest + i + 4ul, _mm_mul_ps(_mm_cvtepi32_ps(hi), gain));
+	}
+#endif
+
+	Int16ToFloatScalar(src + (2ul * i), numSamps - i, dest + i);
+}
+
+void PcmKernels::Int24ToFloat(const std::uint8_t* src,
+	unsigned long numSamps,
+	float* dest) noexcept
+{
+	// Builds each sample in the top three bytes, so the arithmetic shift
+	// sign-extends it. Branch-free, which leaves the compiler free to
+	// vectorise the loop.
+	for (auto i = 0ul; i < numSamps; i++)
+	{
+		const auto* bytes = src + (3ul * i);
+		auto packed = static_cast<std::uint32_t>(bytes[0]) << 8 |
+			static_cast<std::uint32_t>(bytes[1]) << 16 |
+			static_cast<std::uint32_t>(bytes[2]) << 24;
+
+		dest[i] = static_cast<float>(static_cast<std::int32_t>(packed) >> 8) * Int24Scale;
+	}
+}
+
+void PcmKernels::Int32ToFloat(const std::uint8_t* src,
+	unsigned long numSamps,
+	float* dest) noexcept
+{
+	auto i = 0ul;
+
+#ifdef JAMMA_PCMKERNELS_SSE2
+	const auto gain = _mm_set1_ps(Int32Scale);
+
+	for (; i + 4ul <= numSamps; i += 4ul)
+	{
+		auto pcm = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + (4ul * i)));
+		_mm_storeu_ps(dest + i, _mm_mul_ps(_mm_cvtepi32_ps(pcm), gain));
+	}
+#endif
+
+	Int32ToFloatScalar(src + (4ul * i), numSamps - i, dest + i);
+}
+
+void PcmKernels::Float32ToFloat(const std::uint8_t* src,
+	unsigned long numSamps,
+	float* dest) noexcept
+{
+	// WAV floats are little-endian IEEE, as are ours
+	std::memcpy(dest, src, numSamps * sizeof(float));
+}
+
+void PcmKernels::FloatToInt16(const float* src,
+	unsigned long numSamps,
+	std::uint8_t* dest,
+	Dither* dither) noexcept
+{
+	if (nullptr != dither)
+	{
+		for (auto i = 0ul; i < numSamps; i++)
+		{
+			auto scaled = (ClampUnit(src[i]) * 32768.0f) + NextNoise(*dither);
+			auto value = std::clamp(static_cast<long>(std::nearbyint(scaled)), -32768l, 32767l);
+
+			dest[2ul * i] = static_cast<std::uint8_t>(value & 0xff);
+			dest[2ul * i + 1ul] = static_cast<std::uint8_t>((value >> 8) & 0xff);
+		}
+
+		return;
+	}
+
+	auto i = 0ul;
+
+#ifdef JAMMA_PCMKERNELS_SSE2
+	const auto minValue = _mm_set1_ps(-1.0f);
+	const auto maxValue = _mm_set1_ps(1.0f);
+	const auto gain = _mm_set1_ps(32768.0f);
+
+	for (; i + 8ul <= numSamps; i += 8ul)
+	{
+		auto lo = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i), minValue), maxValue);
+		auto hi = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i + 4ul), minValue), maxValue);
+
+		// Rounds to nearest, then saturates full scale down to 32767
+		auto packed = _mm_packs_epi32(_mm_cvtps_epi32(_mm_mul_ps(lo, gain)),
+			_mm_cvtps_epi32(_mm_mul_ps(hi, gain)));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + (2ul * i)), packed);
+	}
+#endif
+
+	FloatToInt16Scalar(src + i, numSamps - i, dest + (2ul * i));
+}
+
+void PcmKernels::FloatToInt24(const float* src,
+	unsigned long numSamps,
+	std::uint8_t* dest,
+	Dither* dither) noexcept
+{
+	for (auto i = 0ul; i < numSamps; i++)
+	{
+		auto scaled = ClampUnit(src[i]) * 8388608.0f;
+		if (nullptr != dither)
+			scaled += NextNoise(*dither);
+
+		auto value = std::clamp(static_cast<long>(std::nearbyint(scaled)), -8388608l, 8388607l);
+
+		auto* bytes = dest + (3ul * i);
+		bytes[0] = static_cast<std::uint8_t>(value & 0xff);
+		bytes[1] = static_cast<std::uint8_t>((value >> 8) & 0xff);
+		bytes[2] = static_cast<std::uint8_t>((value >> 16) & 0xff);
+	}
+}
+
+void PcmKernels::FloatToInt32(const float* src,
+	unsigned long numSamps,
+	std::uint8_t* dest) noexcept
+{
+	auto i = 0ul;
+
+#ifdef JAMMA_PCMKERNELS_SSE2
+	const auto minValue = _mm_set1_ps(-1.0f);
+	const auto maxValue = _mm_set1_ps(1.0f);
+	const auto gain = _mm_set1_ps(2147483648.0f);
+	const auto maxScaled = _mm_set1_ps(MaxInt32Float);
+
+	for (; i + 4ul <= numSamps; i += 4ul)
+	{
+		auto clamped = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(src + i), minValue), maxValue);
+		auto scaled = _mm_min_ps(_mm_mul_ps(clamped, gain), maxScaled);
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + (4ul * i)), _mm_cvtps_epi32(scaled));
+	}
+#endif
+
+	FloatToInt32Scalar(src + i, numSamps - i, dest + (4ul * i));
+}
+
+void PcmKernels::FloatToFloat32(const float* src,
+	unsigned long numSamps,
+	std::uint8_t* dest) noexcept
+{
+	std::memcpy(dest, src, numSamps * sizeof(float));
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+
+namespace audio
+{
+	// Converts between little-endian PCM file bytes and float samples, a
+	// block at a time. Byte buffers need no particular alignment, so any
+	// offset into a read or write buffer will do.
+	//
+	//   int16:   dest[i] = src[i] / 32768
+	//   int24:   dest[i] = src[i] / 8388608 (packed three bytes per sample)
+	//   int32:   dest[i] = src[i] / 2147483648
+	//   float32: dest[i] = src[i]
+	//
+	// Writing back scales by the same factors, clamps to full scale and
+	// rounds to nearest, so a file read and written at the same depth comes
+	// back unchanged. Given a Dither, int16 and int24 add triangular noise
+	// of up to one step first, which keeps quiet tails from truncating into
+	// distortion.
+	//
+	// Int16 and int32 use SSE2 where available; every level gives identical
+	// output for finite samples.
+	class PcmKernels
+	{
+	public:
+		static constexpr float Int16Scale = 1.0f / 32768.0f;
+		static constexpr float Int24Scale = 1.0f / 8388608.0f;
+		static constexpr float Int32Scale = 1.0f / 2147483648.0f;
+
+		// Noise state carried across blocks, so a file written in chunks
+		// gets the same noise as one written whole.
+		struct Dither
+		{
+			std::uint32_t State = 0x9e3779b9u;
+		};
+
+	public:
+		static void Int16ToFloat(const std::uint8_t* src,
+			unsigned long numSamps,
+			float* dest) noexcept;
+		static void Int24ToFloat(const std::uint8_t* src,
+			unsigned long numSamps,
+			float* dest) noexcept;
+		static void Int32ToFloat(const std::uint8_t* src,
+			unsigned long numSamps,
+			float* dest) noexcept;
+		static void Float32ToFloat(const std::uint8_t* src,
+			unsigned long numSamps,
+			float* dest) noexcept;
+
+		// A null dither rounds without noise.
+		static void FloatToInt16(const float* src,
+			unsigned long numSamps,
+			std::uint8_t* dest,
+			Dither* dither) noexcept;
+		static void FloatToInt24(const float* src,
+			unsigned long numSamps,
+			std::uint8_t* dest,
+			Dither* dither) noexcept;
+		static void FloatToInt32(const float* src,
+			unsigned long numSamps,
+			std::uint8_t* dest) noexcept;
+		static void FloatToFloat32(const float* src,
+			unsigned long numSamps,
+			std::uint8_t* dest) noexcept;
+	};
+}
@@ -0,0 +1,126 @@
+#include "StreamPrefetcher.h"
+#include "../include/Constants.h"
+
+#include <algorithm>
+#include <chrono>
+
+using namespace audio;
+
+StreamPrefetcher::StreamPrefetcher() :
+	_thresholdSamps(constants::DefaultStreamThresholdSamps),
+	_windowBanks(constants::DefaultStreamWindowBanks),
+	_mutex(),
+	_wake(),
+	_isRunning(false),
+	_isStopping(false),
+	_thread(),
+	_streams()
+{
+}
+
+StreamPrefetcher::~StreamPrefetcher()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_isStopping = true;
+	}
+
+	_wake.notify_all();
+
+	if (_thread.joinable())
+		_thread.join();
+}
+
+StreamPrefetcher& StreamPrefetcher::Instance()
+{
+	static StreamPrefetcher prefetcher;
+	return prefetcher;
+}
+
+void StreamPrefetcher::Configure(unsigned long thresholdSamps, unsigned int windowBanks)
+{
+	_thresholdSamps.store(thresholdSamps, std::memory_order_relaxed);
+	_windowBanks.store(std::clamp(windowBanks, 1u, StreamingBank::MaxWindowBanks), std::memory_order_relaxed);
+}
+
+bool StreamPrefetcher::ShouldStream(unsigned long length) const noexcept
+{
+	auto threshold = ThresholdSamps();
+	return (threshold > 0ul) && (length > threshold);
+}
+
+void StreamPrefetcher::Add(std::shared_ptr<StreamingBank> bank)
+{
+	if (!bank)
+		return;
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	_streams.push_back(bank);
+
+	if (_isRunning || _isStopping)
+		return;
+
+	// The previous thread has already given up the lock for good
+	if (_thread.joinable())
+		_thread.join();
+
+	_isRunning = true;
+	_thread = std::thread([this]() { _Run(); });
+}
+
+std::size_t StreamPrefetcher::NumStreams() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	return static_cast<std::size_t>(std::count_if(_streams.begin(), _streams.end(),
+		[](const std::weak_ptr<StreamingBank>& stream) { return !stream.expired(); }));
+}
+
+unsigned int StreamPrefetcher::Pump()
+{
+	auto numLoaded = 0u;
+
+	for (auto& stream : _LiveStreams())
+		numLoaded += stream->Prefetch();
+
+	return numLoaded;
+}
+
+std::vector<std::shared_ptr<StreamingBank>> StreamPrefetcher::_LiveStreams()
+{
+	std::vector<std::shared_ptr<StreamingBank>> streams;
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	for (auto& stream : _streams)
+	{
+		auto live = stream.lock();
+		if (live)
+			streams.push_back(std::move(live));
+	}
+
+	return streams;
+}
+
+void StreamPrefetcher::_Run()
+{
+	while (true)
+	{
+		auto numLoaded = Pump();
+
+		std::unique_lock<std::mutex> lock(_mutex);
+
+		_streams.erase(std::remove_if(_streams.begin(), _streams.end(),
+			[](const std::weak_ptr<StreamingBank>& stream) { return stream.expired(); }),
+			_streams.end());
+
+		if (_isStopping || _streams.empty())
+		{
+			_isRunning = false;
+			return;
+		}
+
+		// Keep going straight away while windows are still filling
+		if (0u == numLoaded)
+			_wake.wait_for(lock, std::chrono::milliseconds(PollIntervalMs), [this]() { return _isStopping; });
+	}
+}
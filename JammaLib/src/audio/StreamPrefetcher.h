@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "StreamingBank.h"
+
+namespace audio
+{
+	// Process-wide background thread that keeps every StreamingBank's
+	// window filled ahead of its play head.
+	//
+	// Banks are held weakly, so a loop dropping its stream is all it takes
+	// to stop prefetching for it. The thread polls, since the audio thread
+	// never signals it; it runs while there is at least one live stream and
+	// is started again by the next Add().
+	class StreamPrefetcher
+	{
+	public:
+		static constexpr unsigned int PollIntervalMs = 2u;
+
+	public:
+		StreamPrefetcher(const StreamPrefetcher&) = delete;
+		StreamPrefetcher& operator=(const StreamPrefetcher&) = delete;
+		~StreamPrefetcher();
+
+		static StreamPrefetcher& Instance();
+
+		// Loops longer than thresholdSamps stream from disk (0 disables
+		// streaming), each keeping windowBanks pool slabs resident.
+		void Configure(unsigned long thresholdSamps, unsigned int windowBanks);
+		unsigned long ThresholdSamps() const noexcept { return _thresholdSamps.load(std::memory_order_relaxed); }
+		unsigned int WindowBanks() const noexcept { return _windowBanks.load(std::memory_order_relaxed); }
+		bool ShouldStream(unsigned long length) const noexcept;
+
+		void Add(std::shared_ptr<StreamingBank> bank);
+		std::size_t NumStreams() const;
+		// Runs one prefetch pass over every live stream and returns how many
+		// banks were loaded.
+		unsigned int Pump();
+
+	protected:
+		StreamPrefetcher();
+
+		std::vector<std::shared_ptr<StreamingBank>> _LiveStreams();
+		void _Run();
+
+	protected:
+		std::atomic<unsigned long> _thresholdSamps;
+		std::atomic<unsigned int> _windowBanks;
+		mutable std::mutex _mutex;
+		std::condition_variable _wake;
+		bool _isRunning;
+		bool _isStopping;
+		std::thread _thread;
+		std::vector<std::weak_ptr<StreamingBank>> _streams;
+	};
+}
@@ -0,0 +1,296 @@
+#include "StreamingBank.h"
+#include "BankPool.h"
+#include "CallbackProfiler.h"
+
+#include <algorithm>
+#include <thread>
+
+using namespace audio;
+
+StreamingBank::StreamingBank(std::unique_ptr<SampleSource> source,
+	unsigned int numWindowBanks) :
+	_sourceMutex(),
+	_source(std::move(source)),
+	_bankShift(BankPool::Instance().SlabShift()),
+	_length(_source ? _source->Length() : 0ul),
+	_numSlots(0u),
+	_slots(),
+	_playHead(0ul),
+	_wrapStart(0ul),
+	_wrapEnd(0ul),
+	_numMisses(0u)
+{
+	// No point holding more slabs than the source has banks
+	auto numBanks = static_cast<unsigned int>((_length + BankSize() - 1ul) >> _bankShift);
+	auto numWanted = std::clamp(numWindowBanks, 1u, MaxWindowBanks);
+	numWanted = std::min(numWanted, numBanks);
+
+	_slots = std::make_unique<Slot[]>(numWanted);
+
+	for (auto i = 0u; i < numWanted; i++)
+	{
+		auto slab = BankPool::Instance().Acquire();
+		if (!slab)
+			break;
+
+		_slots[i].Samples = std::move(slab);
+		_slots[i].Bank.store(_NoBank, std::memory_order_relaxed);
+		_slots[i].NumReaders.store(0u, std::memory_order_relaxed);
+		_numSlots++;
+	}
+
+	_wrapEnd.store(_length, std::memory_order_relaxed);
+}
+
+StreamingBank::~StreamingBank()
+{
+	for (auto i = 0u; i < _numSlots; i++)
+		BankPool::Instance().Release(std::move(_slots[i].Samples));
+}
+
+unsigned int StreamingBank::NumResidentBanks() const noexcept
+{
+	auto numResident = 0u;
+
+	for (auto i = 0u; i < _numSlots; i++)
+	{
+		if (_NoBank != _slots[i].Bank.load(std::memory_order_relaxed))
+			numResident++;
+	}
+
+	return numResident;
+}
+
+std::size_t StreamingBank::AllocatedBytes() const noexcept
+{
+	return static_cast<std::size_t>(_numSlots) * BankSize() * sizeof(float);
+}
+
+bool StreamingBank::IsResident(unsigned long index, unsigned long numSamps) const noexcept
+{
+	auto end = std::min(index + numSamps, _length);
+	if (end <= index)
+		return true;
+
+	auto lastBank = static_cast<unsigned int>((end - 1ul) >> _bankShift);
+
+	for (auto bank = static_cast<unsigned int>(index >> _bankShift); bank <= lastBank; bank++)
+	{
+		auto isFound = false;
+
+		for (auto i = 0u; (i < _numSlots) && !isFound; i++)
+			isFound = (bank == _slots[i].Bank.load(std::memory_order_acquire));
+
+		if (!isFound)
+			return false;
+	}
+
+	return true;
+}
+
+bool StreamingBank::Read(unsigned long index, float* dest, unsigned int numSamps) noexcept
+{
+	auto isComplete = true;
+	auto bankMask = BankSize() - 1ul;
+	auto done = 0ul;
+
+	while (done < numSamps)
+	{
+		auto sampIndex = index + done;
+
+		if (sampIndex >= _length)
+		{
+			std::fill(dest + done, dest + numSamps, 0.0f);
+			break;
+		}
+
+		auto offset = sampIndex & bankMask;
+		auto span = std::min({ numSamps - done, BankSize() - offset, _length - sampIndex });
+
+		if (!_ReadBank(static_cast<unsigned int>(sampIndex >> _bankShift), offset, dest + done, span))
+		{
+			std::fill(dest + done, dest + done + span, 0.0f);
+			isComplete = false;
+		}
+
+		done += span;
+	}
+
+	if (!isComplete)
+	{
+		_numMisses.fetch_add(1u, std::memory_order_relaxed);
+		JAMMA_PROFILE_COUNT(COUNTER_PREFETCH_MISSES);
+	}
+
+	return isComplete;
+}
+
+void StreamingBank::SetPlayHead(unsigned long index,
+	unsigned long wrapStart,
+	unsigned long wrapEnd) noexcept
+{
+	_wrapStart.store(wrapStart, std::memory_order_relaxed);
+	_wrapEnd.store(wrapEnd, std::memory_order_relaxed);
+	_playHead.store(index, std::memory_order_release);
+}
+
+unsigned int StreamingBank::Prefetch()
+{
+	std::lock_guard<std::mutex> lock(_sourceMutex);
+
+	unsigned int wanted[MaxWindowBanks];
+	auto numWanted = _WantedBanks(wanted);
+	auto isWanted = [&](unsigned int bank) {
+		return std::find(wanted, wanted + numWanted, bank) != (wanted + numWanted);
+	};
+
+	auto numLoaded = 0u;
+
+	for (auto w = 0u; w < numWanted; w++)
+	{
+		Slot* victim = nullptr;
+		auto isResident = false;
+
+		for (auto i = 0u; i < _numSlots; i++)
+		{
+			auto bank = _slots[i].Bank.load(std::memory_order_relaxed);
+
+			if (wanted[w] == bank)
+			{
+				isResident = true;
+				break;
+			}
+
+			// Prefer an empty slot, else one holding a bank outside the window
+			if (_NoBank == bank)
+				victim = &_slots[i];
+			else if ((nullptr == victim) && !isWanted(bank))
+				victim = &_slots[i];
+		}
+
+		if (isResident)
+			continue;
+
+		if (nullptr == victim)
+			break;
+
+		_FillSlot(*victim, wanted[w]);
+		numLoaded++;
+	}
+
+	return numLoaded;
+}
+
+unsigned long StreamingBank::ReadSource(unsigned long index, float* dest, unsigned long numSamps)
+{
+	if (index >= _length)
+		return 0ul;
+
+	numSamps = std::min(numSamps, _length - index);
+	auto done = 0ul;
+
+	// A bank at a time, so Prefetch() gets the source in between and the
+	// window keeps up with playback during a long export
+	while (done < numSamps)
+	{
+		auto span = std::min(numSamps - done, BankSize());
+		unsigned long numRead;
+
+		{
+			std::lock_guard<std::mutex> lock(_sourceMutex);
+			if (!_source)
+				break;
+
+			numRead = _source->Read(index + done, dest + done, span);
+		}
+
+		done += numRead;
+		if (numRead < span)
+			break;
+	}
+
+	return done;
+}
+
+unsigned int StreamingBank::_WantedBanks(unsigned int* banks) const noexcept
+{
+	if ((0ul == _length) || (0u == _numSlots))
+		return 0u;
+
+	auto index = _playHead.load(std::memory_order_acquire);
+	auto wrapStart = _wrapStart.load(std::memory_order_relaxed);
+	auto wrapEnd = std::min(_wrapEnd.load(std::memory_order_relaxed), _length);
+
+	if (wrapStart >= wrapEnd)
+	{
+		wrapStart = 0ul;
+		wrapEnd = _length;
+	}
+
+	if (index >= wrapEnd)
+		index = wrapStart;
+
+	auto numBanks = 0u;
+
+	while (numBanks < _numSlots)
+	{
+		auto bank = static_cast<unsigned int>(index >> _bankShift);
+
+		// The window has come all the way round a short loop
+		if (std::find(banks, banks + numBanks, bank) != (banks + numBanks))
+			break;
+
+		banks[numBanks++] = bank;
+
+		index = static_cast<unsigned long>(bank + 1u) << _bankShift;
+		if (index >= wrapEnd)
+			index = wrapStart;
+	}
+
+	return numBanks;
+}
+
+bool StreamingBank::_ReadBank(unsigned int bank, unsigned long offset, float* dest, unsigned long numSamps) noexcept
+{
+	for (auto i = 0u; i < _numSlots; i++)
+	{
+		auto& slot = _slots[i];
+
+		if (bank != slot.Bank.load(std::memory_order_relaxed))
+			continue;
+
+		// Announce the read before confirming the tag, so a refill either
+		// waits for us or has already cleared the tag
+		slot.NumReaders.fetch_add(1u, std::memory_order_seq_cst);
+		auto isHit = (bank == slot.Bank.load(std::memory_order_seq_cst));
+
+		if (isHit)
+			std::copy_n(slot.Samples.get() + offset, numSamps, dest);
+
+		slot.NumReaders.fetch_sub(1u, std::memory_order_release);
+
+		if (isHit)
+			return true;
+	}
+
+	return false;
+}
+
+void StreamingBank::_FillSlot(Slot& slot, unsigned int bank)
+{
+	slot.Bank.store(_NoBank, std::memory_order_seq_cst);
+
+	// Readers that saw the old tag copy out in well under a block
+	while (slot.NumReaders.load(std::memory_order_seq_cst) > 0u)
+		std::this_thread::yield();
+
+	auto start = static_cast<unsigned long>(bank) << _bankShift;
+	auto numRead = 0ul;
+
+	if (_source && (start < _length))
+		numRead = _source->Read(start, slot.Samples.get(), std::min(BankSize(), _length - start));
+
+	std::fill(slot.Samples.get() + numRead, slot.Samples.get() + BankSize(), 0.0f);
+
+	slot.Bank.store(bank, std::memory_order_release);
+}
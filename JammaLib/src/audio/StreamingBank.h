@@ -0,0 +1,106 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+namespace audio
+{
+	// Random access to samples kept outside memory, such as a WAV file.
+	// Only called from the prefetch and loading threads, never from the
+	// audio callback.
+	class SampleSource
+	{
+	public:
+		virtual ~SampleSource() {}
+
+		virtual unsigned long Length() const = 0;
+		// Reads up to numSamps samples from index into dest and returns how
+		// many were read.
+		virtual unsigned long Read(unsigned long index, float* dest, unsigned long numSamps) = 0;
+	};
+
+	// Read-only loop store that keeps only a window of its samples resident.
+	//
+	// The samples stay in a SampleSource, and a fixed set of BankPool slabs
+	// hold the banks that play next. Prefetch() (on the StreamPrefetcher
+	// thread) fills the window ahead of the play head, wrapping from the end
+	// of the loop back to its start. The audio thread only copies out of
+	// slabs that are already filled. A bank that is not resident reads as
+	// silence and counts as a prefetch miss, so the callback never waits
+	// on I/O.
+	//
+	// Each slot is tagged with the bank it holds. Readers raise the slot's
+	// reader count and then check the tag; the prefetcher clears the tag
+	// and waits for readers to leave before refilling the slot.
+	class StreamingBank
+	{
+	public:
+		static constexpr unsigned int DefaultWindowBanks = 8u;
+		static constexpr unsigned int MaxWindowBanks = 64u;
+
+	public:
+		StreamingBank(std::unique_ptr<SampleSource> source,
+			unsigned int numWindowBanks);
+		~StreamingBank();
+		StreamingBank(const StreamingBank&) = delete;
+		StreamingBank& operator=(const StreamingBank&) = delete;
+
+	public:
+		unsigned long Length() const noexcept { return _length; }
+		unsigned long BankSize() const noexcept { return 1ul << _bankShift; }
+		unsigned int NumSlots() const noexcept { return _numSlots; }
+		unsigned int NumResidentBanks() const noexcept;
+		// Bytes of pool slabs held for the window.
+		std::size_t AllocatedBytes() const noexcept;
+		std::uint64_t NumMisses() const noexcept { return _numMisses.load(std::memory_order_relaxed); }
+		// True when every bank overlapping [index, index + numSamps) is
+		// resident. Samples past Length() need no bank.
+		bool IsResident(unsigned long index, unsigned long numSamps) const noexcept;
+
+		// Audio-callback safe: copies [index, index + numSamps) into dest.
+		// Samples past Length(), or in banks not yet resident, read as zero.
+		// Returns false on a prefetch miss.
+		bool Read(unsigned long index, float* dest, unsigned int numSamps) noexcept;
+		// Audio-callback safe: where playback reads next. Playback runs up to
+		// wrapEnd and continues from wrapStart.
+		void SetPlayHead(unsigned long index,
+			unsigned long wrapStart,
+			unsigned long wrapEnd) noexcept;
+
+		// Loads the banks the window is missing, nearest the play head
+		// first, and returns how many were loaded. Off-thread only.
+		unsigned int Prefetch();
+		// Reads straight from the source, bypassing the window (for export).
+		// Takes the source a bank at a time. Off-thread only.
+		unsigned long ReadSource(unsigned long index, float* dest, unsigned long numSamps);
+
+	protected:
+		struct Slot
+		{
+			std::unique_ptr<float[]> Samples;
+			std::atomic<unsigned int> Bank;
+			std::atomic<unsigned int> NumReaders;
+		};
+
+		static constexpr unsigned int _NoBank = ~0u;
+
+		unsigned int _WantedBanks(unsigned int* banks) const noexcept;
+		bool _ReadBank(unsigned int bank, unsigned long offset, float* dest, unsigned long numSamps) noexcept;
+		void _FillSlot(Slot& slot, unsigned int bank);
+
+	protected:
+		std::mutex _sourceMutex;
+		std::unique_ptr<SampleSource> _source;
+		unsigned int _bankShift;
+		unsigned long _length;
+		unsigned int _numSlots;
+		std::unique_ptr<Slot[]> _slots;
+		std::atomic<unsigned long> _playHead;
+		std::atomic<unsigned long> _wrapStart;
+		std::atomic<unsigned long> _wrapEnd;
+		std::atomic<std::uint64_t> _numMisses;
+	};
+}
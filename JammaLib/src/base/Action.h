@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <optional>
 #include <memory>
 #include "../utils/CommonTypes.h"
@@ -25,6 +26,7 @@ namespace base
 	public:
 		Action() :
 			_actionTime(std::chrono::steady_clock::now()),
+			_sampleTime(std::nullopt),
 			_userConfig(std::nullopt)
 		{};
 
@@ -34,6 +36,10 @@ namespace base
 		Time GetActionTime() const { return _actionTime; }
 		void SetActionTime(Time time) { _actionTime = time; }
 
+		// Engine sample at which the action occurred, if known
+		std::optional<std::uint64_t> GetSampleTime() const { return _sampleTime; }
+		void SetSampleTime(std::uint64_t sampleTime) { _sampleTime = sampleTime; }
+
 		std::optional<io::UserConfig> GetUserConfig() const { return _userConfig; }
 		void SetUserConfig(io::UserConfig cfg) { _userConfig = cfg; }
 
@@ -42,6 +48,7 @@ namespace base
 
 	protected:
 		Time _actionTime;
+		std::optional<std::uint64_t> _sampleTime;
 		std::optional<io::UserConfig> _userConfig;
 		std::optional< audio::AudioStreamParams> _audioStreamParams;
 	};
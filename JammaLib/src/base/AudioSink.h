@@ -17,6 +17,8 @@ namespace base
 		unsigned int stride;             // 1 = contiguous, N = interleaved
 		float fadeCurrent;               // Fade factor for existing content
 		float fadeNew;                   // Fade factor for new content
+		const float* fadeRamp;           // Optional per-sample gain (nullptr = constant fades)
+		float fadeCurrentRamp;           // fadeCurrent += fadeCurrentRamp * fadeRamp[i]
 		Audible::AudioSourceType source; // Audio source type
 
 		AudioWriteRequest() noexcept :
@@ -25,6 +27,8 @@ namespace base
 			stride(1),
 			fadeCurrent(0.0f),
 			fadeNew(1.0f),
+			fadeRamp(nullptr),
+			fadeCurrentRamp(0.0f),
 			source(Audible::AUDIOSOURCE_ADC)
 		{}
 	};
@@ -1,7 +1,7 @@
 #pragma once
 
+#include <cstdint>
 #include <optional>
-#include "Timer.h"
 #include "../io/UserConfig.h"
 #include "../audio/AudioDevice.h"
 
@@ -10,7 +10,9 @@ namespace base
 	class Tickable
 	{
 	public:
-		virtual void OnTick(Time curTime,
+		// Called once per audio block, after it has been processed.
+		// sampleTime is the engine sample count at the start of the block.
+		virtual void OnTick(std::uint64_t sampleTime,
 			unsigned int samps,
 			std::optional<io::UserConfig> cfg,
 			std::optional<audio::AudioStreamParams> params) = 0;
@@ -0,0 +1,225 @@
+#include "JobQueue.h"
+#include "ActionReceiver.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <utility>
+
+using namespace engine;
+using actions::JobAction;
+
+namespace
+{
+	void StoreMax(std::atomic<unsigned int>& dest, unsigned int value) noexcept
+	{
+		auto cur = dest.load(std::memory_order_relaxed);
+		while ((value > cur) && !dest.compare_exchange_weak(cur, value, std::memory_order_relaxed)) {}
+	}
+
+	void StoreMax(std::atomic<std::uint64_t>& dest, std::uint64_t value) noexcept
+	{
+		auto cur = dest.load(std::memory_order_relaxed);
+		while ((value > cur) && !dest.compare_exchange_weak(cur, value, std::memory_order_relaxed)) {}
+	}
+}
+
+JobQueue::JobQueue() :
+	_head(nullptr),
+	_depth(0u),
+	_signal(),
+	_numPushed(0u),
+	_numDrained(0u),
+	_numCoalesced(0u),
+	_maxDepth(0u),
+	_totalLatencyUs(0u),
+	_maxLatencyUs(0u)
+{
+}
+
+JobQueue::~JobQueue()
+{
+	auto node = _head.exchange(nullptr, std::memory_order_acquire);
+	while (nullptr != node)
+	{
+		auto next = node->Next;
+		delete node;
+		node = next;
+	}
+}
+
+void JobQueue::Push(JobAction job)
+{
+	auto node = new Node{ std::move(job), std::chrono::steady_clock::now(), nullptr };
+	_PushNodes(node, node, 1u);
+}
+
+void JobQueue::Push(std::vector<JobAction> jobs)
+{
+	if (jobs.empty())
+		return;
+
+	// Link the batch newest first, so it lands on the stack in one exchange
+	auto now = std::chrono::steady_clock::now();
+	Node* first = nullptr;
+	Node* last = nullptr;
+
+	for (auto& job : jobs)
+	{
+		first = new Node{ std::move(job), now, first };
+		if (nullptr == last)
+			last = first;
+	}
+
+	_PushNodes(first, last, static_cast<unsigned int>(jobs.size()));
+}
+
+void JobQueue::Wait(std::chrono::milliseconds timeout)
+{
+	_signal.Wait(timeout);
+}
+
+void JobQueue::Wake()
+{
+	_signal.Notify();
+}
+
+std::vector<JobAction> JobQueue::Drain(std::vector<JobAction>& dropped)
+{
+	auto node = _head.exchange(nullptr, std::memory_order_acquire);
+	if (nullptr == node)
+		return {};
+
+	// The stack holds the newest job first
+	std::vector<Node*> nodes;
+	for (; nullptr != node; node = node->Next)
+		nodes.push_back(node);
+
+	auto now = std::chrono::steady_clock::now();
+	std::uint64_t totalLatencyUs = 0u;
+	std::uint64_t maxLatencyUs = 0u;
+
+	std::vector<JobAction> jobs;
+	jobs.reserve(nodes.size());
+
+	for (auto n = nodes.rbegin(); n != nodes.rend(); ++n)
+	{
+		auto latencyUs = static_cast<std::uint64_t>(
+			std::chrono::duration_cast<std::chrono::microseconds>(now - (*n)->PushTime).count());
+		totalLatencyUs += latencyUs;
+		maxLatencyUs = std::max(maxLatencyUs, latencyUs);
+
+		jobs.push_back(std::move((*n)->Job));
+		delete *n;
+	}
+
+	auto numNodes = static_cast<unsigned int>(nodes.size());
+	_depth.fetch_sub(numNodes, std::memory_order_relaxed);
+	_numDrained.fetch_add(numNodes, std::memory_order_relaxed);
+	_totalLatencyUs.fetch_add(totalLatencyUs, std::memory_order_relaxed);
+	StoreMax(_maxLatencyUs, maxLatencyUs);
+
+	auto numDropped = dropped.size();
+	jobs = _Coalesce(std::move(jobs), dropped);
+	_numCoalesced.fetch_add(dropped.size() - numDropped, std::memory_order_relaxed);
+
+	return jobs;
+}
+
+JobQueue::Stats JobQueue::GetStats() const
+{
+	Stats stats;
+	stats.NumPushed = _numPushed.load(std::memory_order_relaxed);
+	stats.NumDrained = _numDrained.load(std::memory_order_relaxed);
+	stats.NumCoalesced = _numCoalesced.load(std::memory_order_relaxed);
+	stats.Depth = _depth.load(std::memory_order_relaxed);
+	stats.MaxDepth = _maxDepth.load(std::memory_order_relaxed);
+	stats.MaxLatencyMs = static_cast<double>(_maxLatencyUs.load(std::memory_order_relaxed)) / 1000.0;
+
+	if (stats.NumDrained > 0u)
+	{
+		stats.MeanLatencyMs = static_cast<double>(_totalLatencyUs.load(std::memory_order_relaxed)) /
+			(1000.0 * static_cast<double>(stats.NumDrained));
+	}
+
+	return stats;
+}
+
+void JobQueue::ResetStats()
+{
+	_numPushed.store(0u, std::memory_order_relaxed);
+	_numDrained.store(0u, std::memory_order_relaxed);
+	_numCoalesced.store(0u, std::memory_order_relaxed);
+	_maxDepth.store(_depth.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	_totalLatencyUs.store(0u, std::memory_order_relaxed);
+	_maxLatencyUs.store(0u, std::memory_order_relaxed);
+}
+
+std::string JobQueue::FormatStats(const Stats& stats)
+{
+	std::stringstream ss;
+	ss << "depth " << stats.Depth << " (max " << stats.MaxDepth << ")"
+		<< ", run " << (stats.NumDrained - stats.NumCoalesced) << "/" << stats.NumPushed
+		<< ", coalesced " << stats.NumCoalesced
+		<< std::fixed << std::setprecision(2)
+		<< ", latency " << stats.MeanLatencyMs << "ms (max " << stats.MaxLatencyMs << "ms)";
+
+	return ss.str();
+}
+
+void JobQueue::_PushNodes(Node* first, Node* last, unsigned int numNodes)
+{
+	auto depth = _depth.fetch_add(numNodes, std::memory_order_relaxed) + numNodes;
+	StoreMax(_maxDepth, depth);
+	_numPushed.fetch_add(numNodes, std::memory_order_relaxed);
+
+	auto head = _head.load(std::memory_order_relaxed);
+	do
+	{
+		last->Next = head;
+	} while (!_head.compare_exchange_weak(head, first, std::memory_order_release, std::memory_order_relaxed));
+
+	_signal.Notify();
+}
+
+std::vector<JobAction> JobQueue::_Coalesce(std::vector<JobAction> jobs,
+	std::vector<JobAction>& dropped)
+{
+	// Walk newest first, so the job that survives is the most recent one
+	// and sits at its own place in the order
+	using Key = std::pair<const void*, JobAction::JobType>;
+	std::map<Key, std::vector<std::size_t>> kept;
+	std::vector<bool> isKept(jobs.size(), false);
+
+	for (auto i = jobs.size(); i-- > 0u;)
+	{
+		auto& job = jobs[i];
+		auto receiver = job.Receiver.lock();
+
+		if (!receiver)
+			continue;
+
+		auto& sameKey = kept[{ receiver.get(), job.JobActionType }];
+		auto isDuplicate = std::any_of(sameKey.begin(), sameKey.end(), [&](std::size_t k) {
+			return job == jobs[k];
+		});
+
+		if (isDuplicate)
+			continue;
+
+		sameKey.push_back(i);
+		isKept[i] = true;
+	}
+
+	std::vector<JobAction> result;
+	for (auto i = 0u; i < jobs.size(); i++)
+	{
+		if (isKept[i])
+			result.push_back(std::move(jobs[i]));
+		else
+			dropped.push_back(std::move(jobs[i]));
+	}
+
+	return result;
+}
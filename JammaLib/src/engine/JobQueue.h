@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../actions/JobAction.h"
+#include "../utils/WakeSignal.h"
+
+namespace engine
+{
+	// Hands jobs from the UI thread to the job thread.
+	//
+	// Any number of threads may Push(); a single consumer Wait()s and then
+	// Drain()s everything pending in one go. Pushing never blocks on the
+	// consumer: jobs go onto a lock-free stack, then a WakeSignal wakes the
+	// consumer if it is asleep.
+	//
+	// Drain() coalesces the batch, keeping only the newest of any jobs that
+	// compare equal for the same receiver, and drops jobs whose receiver has
+	// gone. Queue depth and the time jobs spend waiting are tracked for
+	// GetStats().
+	class JobQueue
+	{
+	public:
+		struct Stats
+		{
+			std::uint64_t NumPushed = 0u;
+			std::uint64_t NumDrained = 0u;
+			std::uint64_t NumCoalesced = 0u;
+			unsigned int Depth = 0u;
+			unsigned int MaxDepth = 0u;
+			double MeanLatencyMs = 0.0;
+			double MaxLatencyMs = 0.0;
+		};
+
+	public:
+		JobQueue();
+		~JobQueue();
+
+		JobQueue(const JobQueue&) = delete;
+		JobQueue& operator=(const JobQueue&) = delete;
+
+		void Push(actions::JobAction job);
+		void Push(std::vector<actions::JobAction> jobs);
+		// Returns once jobs are pending, Wake() is called or the timeout
+		// passes, whichever is first. Consumer only.
+		void Wait(std::chrono::milliseconds timeout);
+		void Wake();
+		// Takes every pending job in push order, after coalescing. Jobs
+		// dropped by coalescing are moved to dropped, so any plugin they
+		// hold can be released on the right thread. Consumer only.
+		std::vector<actions::JobAction> Drain(std::vector<actions::JobAction>& dropped);
+		unsigned int Depth() const noexcept { return _depth.load(std::memory_order_relaxed); }
+
+		Stats GetStats() const;
+		void ResetStats();
+		static std::string FormatStats(const Stats& stats);
+
+	protected:
+		struct Node
+		{
+			actions::JobAction Job;
+			std::chrono::steady_clock::time_point PushTime;
+			Node* Next;
+		};
+
+		void _PushNodes(Node* first, Node* last, unsigned int numNodes);
+		static std::vector<actions::JobAction> _Coalesce(std::vector<actions::JobAction> jobs,
+			std::vector<actions::JobAction>& dropped);
+
+	protected:
+		std::atomic<Node*> _head;
+		std::atomic<unsigned int> _depth;
+		utils::WakeSignal _signal;
+
+		std::atomic<std::uint64_t> _numPushed;
+		std::atomic<std::uint64_t> _numDrained;
+		std::atomic<std::uint64_t> _numCoalesced;
+		std::atomic<unsigned int> _maxDepth;
+		std::atomic<std::uint64_t> _totalLatencyUs;
+		std::atomic<std::uint64_t> _maxLatencyUs;
+	};
+}
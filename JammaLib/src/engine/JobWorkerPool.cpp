@@ -0,0 +1,173 @@
+#include "JobWorkerPool.h"
+#include "ActionReceiver.h"
+
+#include <map>
+
+using namespace engine;
+using actions::JobAction;
+
+JobWorkerPool::JobWorkerPool() :
+	_workers(),
+	_mutex(),
+	_wake(),
+	_done(),
+	_tasks(),
+	_numBusy(0u),
+	_isStopping(false)
+{
+}
+
+JobWorkerPool::~JobWorkerPool()
+{
+	Stop();
+}
+
+void JobWorkerPool::Start(unsigned int numWorkers)
+{
+	Stop();
+
+	{
+		std::scoped_lock lock(_mutex);
+		_isStopping = false;
+	}
+
+	for (auto i = 0u; i < numWorkers; i++)
+		_workers.emplace_back([this]() { _WorkerLoop(); });
+}
+
+void JobWorkerPool::Stop()
+{
+	{
+		std::scoped_lock lock(_mutex);
+		_isStopping = true;
+	}
+
+	_wake.notify_all();
+
+	for (auto& worker : _workers)
+	{
+		if (worker.joinable())
+			worker.join();
+	}
+
+	_workers.clear();
+}
+
+void JobWorkerPool::Run(std::vector<JobAction>& jobs, const Runner& runner)
+{
+	if (_workers.empty() || (jobs.size() < 2u))
+	{
+		for (auto& job : jobs)
+			runner(job);
+
+		return;
+	}
+
+	// Group by receiver, keeping batch order within each group
+	std::map<const void*, std::vector<JobAction*>> groups;
+	std::map<const void*, bool> isGroupIndependent;
+	std::vector<const void*> groupOrder;
+	std::vector<const void*> keys;
+
+	for (auto& job : jobs)
+	{
+		auto key = static_cast<const void*>(job.Receiver.lock().get());
+		keys.push_back(key);
+
+		auto& group = groups[key];
+
+		if (group.empty())
+		{
+			groupOrder.push_back(key);
+			isGroupIndependent[key] = true;
+		}
+
+		group.push_back(&job);
+		isGroupIndependent[key] = isGroupIndependent[key] && IsIndependent(job);
+	}
+
+	std::vector<JobAction*> serialJobs;
+	std::vector<std::vector<JobAction*>> parallelGroups;
+
+	for (auto key : groupOrder)
+	{
+		if (isGroupIndependent[key] && (nullptr != key))
+			parallelGroups.push_back(std::move(groups[key]));
+	}
+
+	for (auto i = 0u; i < jobs.size(); i++)
+	{
+		if (!isGroupIndependent[keys[i]] || (nullptr == keys[i]))
+			serialJobs.push_back(&jobs[i]);
+	}
+
+	{
+		std::scoped_lock lock(_mutex);
+
+		for (auto& group : parallelGroups)
+		{
+			_tasks.push_back([&runner, &group]() {
+				for (auto job : group)
+					runner(*job);
+			});
+		}
+	}
+
+	_wake.notify_all();
+
+	for (auto job : serialJobs)
+		runner(*job);
+
+	// Help out with whatever is left, then wait for the workers
+	std::unique_lock lock(_mutex);
+	while (_RunNextTask(lock)) {}
+
+	_done.wait(lock, [this]() { return _tasks.empty() && (0u == _numBusy); });
+}
+
+bool JobWorkerPool::IsIndependent(const JobAction& job) noexcept
+{
+	switch (job.JobActionType)
+	{
+	case JobAction::JOB_UPDATEMIDIQUANTISATION:
+	case JobAction::JOB_COMPACTLOOP:
+		return true;
+	default:
+		return false;
+	}
+}
+
+void JobWorkerPool::_WorkerLoop()
+{
+	std::unique_lock lock(_mutex);
+
+	while (true)
+	{
+		_wake.wait(lock, [this]() { return _isStopping || !_tasks.empty(); });
+
+		if (_isStopping)
+			return;
+
+		_RunNextTask(lock);
+	}
+}
+
+bool JobWorkerPool::_RunNextTask(std::unique_lock<std::mutex>& lock)
+{
+	if (_tasks.empty())
+		return false;
+
+	auto task = std::move(_tasks.front());
+	_tasks.pop_front();
+	_numBusy++;
+
+	lock.unlock();
+	task();
+	lock.lock();
+
+	_numBusy--;
+	if (_tasks.empty() && (0u == _numBusy))
+		_done.notify_all();
+
+	return true;
+}
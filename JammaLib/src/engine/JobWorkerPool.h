@@ -0,0 +1,54 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "../actions/JobAction.h"
+
+namespace engine
+{
+	// Runs a drained batch of jobs, spreading independent receivers over a
+	// few worker threads.
+	//
+	// Each receiver's jobs still run one at a time, in order. A receiver
+	// goes to a worker only when all of its jobs in the batch are safe to
+	// run alongside other receivers (see IsIndependent); anything else,
+	// such as VST loading, stays on the calling thread. Run() returns once
+	// the whole batch is done, so batches never overlap.
+	class JobWorkerPool
+	{
+	public:
+		using Runner = std::function<void(actions::JobAction&)>;
+
+	public:
+		JobWorkerPool();
+		~JobWorkerPool();
+
+		JobWorkerPool(const JobWorkerPool&) = delete;
+		JobWorkerPool& operator=(const JobWorkerPool&) = delete;
+
+		// With no workers every job runs on the calling thread.
+		void Start(unsigned int numWorkers);
+		void Stop();
+		unsigned int NumWorkers() const noexcept { return static_cast<unsigned int>(_workers.size()); }
+
+		void Run(std::vector<actions::JobAction>& jobs, const Runner& runner);
+		static bool IsIndependent(const actions::JobAction& job) noexcept;
+
+	protected:
+		void _WorkerLoop();
+		bool _RunNextTask(std::unique_lock<std::mutex>& lock);
+
+	protected:
+		std::vector<std::thread> _workers;
+		std::mutex _mutex;
+		std::condition_variable _wake;
+		std::condition_variable _done;
+		std::deque<std::function<void()>> _tasks;
+		unsigned int _numBusy;
+		bool _isStopping;
+	};
+}
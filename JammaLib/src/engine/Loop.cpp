@@ -1,6 +1,10 @@
 #include "Loop.h"
+#include "../audio/CallbackProfiler.h"
+#include "../audio/LoadMonitor.h"
 #include <algorithm>
 #include <cmath>
+#include <iostream>
+#include <thread>
 
 namespace
 {
@@ -32,7 +36,7 @@ using actions::ActionResult;
 
 Loop::~Loop()
 {
-	DrainVstChain(_vstChain.load(std::memory_order_acquire));
+	DrainVstChain(_vstChain.LoadShared());
 	DrainVstChain(_backVstChain);
 	ReleaseResources();
 }
@@ -77,7 +81,10 @@ Loop::Loop(LoopParams params,
 	_children.push_back(_mixer);
 }
 
-std::optional<std::shared_ptr<Loop>> Loop::FromFile(LoopParams loopParams, io::JamFile::Loop loopStruct, std::wstring dir)
+std::optional<std::shared_ptr<Loop>> Loop::FromFile(LoopParams loopParams,
+	io::JamFile::Loop loopStruct,
+	std::wstring dir,
+	LoopLoader& loader)
 {
 	audio::BehaviourParams behaviour;
 	audio::WireMixBehaviourParams wire;
@@ -114,8 +121,17 @@ std::optional<std::shared_ptr<Loop>> Loop::FromFile(LoopParams loopParams, io::J
 	loopParams.Wav = utils::EncodeUtf8(dir) + "/" + loopStruct.Name;
 	auto loop = std::make_shared<Loop>(loopParams, mixerParams);
 
-	loop->Load(io::WavReadWriter());
-	loop->Play(loopStruct.MasterLoopCount, loopStruct.Length, false);
+	auto playIndex = loopStruct.MasterLoopCount;
+	auto loopLength = loopStruct.Length;
+
+	loader.Add([loop, playIndex, loopLength]() -> std::size_t {
+		if (!loop->Load(io::WavReadWriter()))
+			return 0u;
+
+		loop->Play(playIndex, loopLength, false);
+
+		return loop->BufferBytes();
+	});
 
 	return loop;
 }
@@ -187,84 +203,59 @@ void Loop::Draw3d(DrawContext& ctx,
 void Loop::OnBlockWrite(const base::AudioWriteRequest& request, int writeOffset)
 {
 	auto playState = _playState.load(std::memory_order_acquire);
-	if ((STATE_RECORDING != playState) &&
-		(STATE_PLAYINGRECORDING != playState) &&
-		(STATE_OVERDUBBING != playState) &&
-		(STATE_PUNCHEDIN != playState) &&
-		(STATE_OVERDUBBINGRECORDING != playState) &&
-		!_isPunchInActive.load(std::memory_order_acquire))
-		return;
+	auto isPunchInActive = _isPunchInActive.load(std::memory_order_acquire);
+	auto split = _transitionOffset.load(std::memory_order_acquire);
+	auto spanStart = static_cast<unsigned int>(writeOffset);
+	auto startIndex = _writeIndex.load(std::memory_order_relaxed) + spanStart;
 
-	if (AUDIOSOURCE_ADC == request.source)
-	{
-		auto canWriteAdc = (STATE_RECORDING == playState) ||
-			(STATE_PLAYINGRECORDING == playState) ||
-			(STATE_PUNCHEDIN == playState) ||
-			_isPunchInActive.load(std::memory_order_acquire);
-		if (!canWriteAdc)
-			return;
-	}
-	else if ((AUDIOSOURCE_BOUNCE == request.source) &&
-		(STATE_RECORDING == playState))
-	{
-		return;
-	}
-	else if ((STATE_OVERDUBBING == playState) &&
-		(AUDIOSOURCE_BOUNCE != request.source))
+	if (0u == split)
 	{
+		if (_AcceptsWrite(playState, isPunchInActive, request.source))
+			_WriteSpan(request, 0u, request.numSamps, startIndex, playState);
+
 		return;
 	}
 
-	auto writeIndex = _writeIndex.load(std::memory_order_relaxed);
+	// Samples before a pending transition still belong to the previous state
+	auto prevState = _prevPlayState.load(std::memory_order_relaxed);
+	auto wasPunchInActive = _wasPunchInActive.load(std::memory_order_relaxed);
+	auto numBefore = (split > spanStart) ?
+		std::min(split - spanStart, request.numSamps) :
+		0u;
 
-	if (AUDIOSOURCE_MONITOR == request.source)
-	{
-		float peak = _lastPeak;
+	if ((numBefore > 0u) && _AcceptsWrite(prevState, wasPunchInActive, request.source))
+		_WriteSpan(request, 0u, numBefore, startIndex, prevState);
 
-		for (unsigned int i = 0; i < request.numSamps; i++)
-		{
-			auto samp = request.samples[i * request.stride];
-			auto idx = writeIndex + writeOffset + i;
-			_monitorBufferBank[idx] = (request.fadeNew * samp) + (request.fadeCurrent * _monitorBufferBank[idx]);
-
-			if (STATE_RECORDING == playState)
-			{
-				auto absSamp = std::abs(samp);
-				if (absSamp > peak)
-					peak = absSamp;
-			}
-		}
-
-		_lastPeak = peak;
-	}
-	else
+	if ((numBefore < request.numSamps) && _AcceptsWrite(playState, isPunchInActive, request.source))
 	{
-		for (unsigned int i = 0; i < request.numSamps; i++)
-		{
-			auto samp = request.samples[i * request.stride];
-			auto idx = writeIndex + writeOffset + i;
-			_bufferBank[idx] = (request.fadeNew * samp) + (request.fadeCurrent * _bufferBank[idx]);
-		}
+		// Capture that only starts at the transition starts at the write index
+		auto captureOffset = _IsCapturing(prevState, wasPunchInActive) ? 0u : split;
+		_WriteSpan(request,
+			numBefore,
+			request.numSamps - numBefore,
+			startIndex + numBefore - captureOffset,
+			playState);
 	}
 }
 
 void Loop::EndWrite(unsigned int numSamps,
 	bool updateIndex)
 {
-	// Only update if currently recording
 	auto playState = _playState.load(std::memory_order_acquire);
-	if ((STATE_RECORDING != playState) &&
-		(STATE_PLAYINGRECORDING != playState) &&
-		(STATE_OVERDUBBING != playState) &&
-		(STATE_PUNCHEDIN != playState) &&
-		(STATE_OVERDUBBINGRECORDING != playState) &&
-		!_isPunchInActive.load(std::memory_order_acquire))
+	auto split = std::min(_transitionOffset.load(std::memory_order_acquire), numSamps);
+	auto isCapturing = _IsCapturing(playState, _isPunchInActive.load(std::memory_order_acquire));
+	auto wasCapturing = (split > 0u) &&
+		_IsCapturing(_prevPlayState.load(std::memory_order_relaxed), _wasPunchInActive.load(std::memory_order_relaxed));
+
+	// Only update if currently recording
+	if (!isCapturing && !wasCapturing)
 		return;
 
 	if (!updateIndex)
 		return;
 
-	auto writeIndex = _writeIndex.load(std::memory_order_relaxed) + numSamps;
+	auto sampsCaptured = (wasCapturing ? split : 0u) + (isCapturing ? numSamps - split : 0u);
+	auto writeIndex = _writeIndex.load(std::memory_order_relaxed) + sampsCaptured;
 	_writeIndex.store(writeIndex, std::memory_order_relaxed);
 	_bufferBank.SetLength(writeIndex);
 
@@ -272,8 +263,12 @@ void Loop::EndWrite(unsigned int numSamps,
 	{
 		_monitorBufferBank.SetLength(writeIndex);
 
-		auto newValue = _lastPeak * _mixer->Level();
-		_vu->SetValue(newValue, numSamps);
+		if (!audio::LoadMonitor::Instance().IsShedding(audio::LoadMonitor::SHED_VU))
+		{
+			auto newValue = _lastPeak * _mixer->Level();
+			_vu->SetValue(newValue, numSamps);
+		}
+
 		_lastPeak = 0.0f;
 	}
 }
@@ -285,117 +280,69 @@ unsigned int Loop::ReadBlock(float* outBuf,
 {
 	auto playState = _playState.load(std::memory_order_acquire);
 	auto loopLength = _loopLength.load(std::memory_order_relaxed);
-	auto isPlaying = (STATE_PLAYING == playState) ||
-		(STATE_PLAYINGRECORDING == playState) ||
-		(STATE_OVERDUBBINGRECORDING == playState) ||
-		(STATE_PUNCHEDIN == playState);
+	auto isPlaying = _IsAudible(playState);
+	auto split = _transitionOffset.load(std::memory_order_acquire);
+	auto wasPlaying = (split > 0u) ?
+		_IsAudible(_prevPlayState.load(std::memory_order_relaxed)) :
+		isPlaying;
 
-	if (!isPlaying || (0 == loopLength))
+	if ((!isPlaying && !wasPlaying) || (0 == loopLength))
 		return 0;
 
-	auto peak = 0.0f;
-	auto bufBankSize = _bufferBank.Length();
-	auto bufSize = loopLength + constants::MaxLoopFadeSamps;
-
-	// _playIndex is always within range:
-	// [constants::MaxLoopFadeSamps : _loopLength + constants::MaxLoopFadeSamps - 1)
-	// index should apply the offset and then also stay in the same range
-	auto index = _playIndex.load(std::memory_order_relaxed);
-
-	if (sampOffset >= 0)
-	{
-		index += sampOffset;
-	}
-	else
-	{
-		while (index < (unsigned long)(-sampOffset))
-			index += loopLength;
-
-		index += sampOffset;
-	}
-
-	while (index >= bufSize)
-		index -= loopLength;
-
-	if (index < constants::MaxLoopFadeSamps)
-		index += loopLength;
-
-	// Check if we are inside crossfading region at any point
-	auto isXfadeRegion = (index + numSamps) >= (bufSize - _loopParams.FadeSamps);
-
+	auto index = _PlayIndexAt(sampOffset, loopLength);
 	auto sampsToWrite = (numSamps <= constants::MaxBlockSize) ? numSamps : constants::MaxBlockSize;
 
-	if (isXfadeRegion)
+	if (_IsSilentSpan(index, sampsToWrite, loopLength))
 	{
-		// Fill temp buffer with crossfade-mixed samples
-		auto startIndex = index;
-
-		for (auto i = 0u; i < sampsToWrite; i++)
-		{
-			auto isXfade = (startIndex + i) >= (bufSize - _loopParams.FadeSamps);
-			isXfade &= index < bufSize;
-
-			if (index < bufBankSize)
-			{
-				auto samp = _bufferBank[index];
-
-				if (isXfade)
-				{
-					auto xfadeIndex = (startIndex + i) - (bufSize - _loopParams.FadeSamps);
-					auto xfadeBufIndex = constants::MaxLoopFadeSamps + xfadeIndex - _loopParams.FadeSamps;
-					auto xfadeSamp = _bufferBank[xfadeBufIndex];
-
-					samp = _hanning->Mix(xfadeSamp, samp, xfadeIndex);
-				}
-
-				outBuf[i] = samp;
+		std::fill(outBuf, outBuf + sampsToWrite, 0.0f);
+		_lastPeak = 0.0f;
+		return sampsToWrite;
+	}
 
-				if (std::abs(samp) > peak)
-					peak = std::abs(samp);
-			}
-			else
-			{
-				outBuf[i] = 0.0f;
-			}
+	auto stream = _Stream();
+	auto peak = (nullptr != stream) ?
+		_ReadSpan(*stream, outBuf, index, sampsToWrite, loopLength) :
+		_ReadSpan(_bufferBank, outBuf, index, sampsToWrite, loopLength);
 
-			index++;
-			if (index >= bufSize)
-				index -= loopLength;
-		}
-	}
-	else
+	// Silence whichever side of a mid-block transition was not playing
+	if (wasPlaying != isPlaying)
 	{
-		// Non-crossfade: fill output buffer from BufferBank, handling wrap-around
-		for (auto i = 0u; i < sampsToWrite; i++)
-		{
-			if (index < bufBankSize)
-			{
-				outBuf[i] = _bufferBank[index];
+		auto blockPos = static_cast<unsigned int>(std::max(sampOffset, 0));
+		auto splitAt = (split > blockPos) ?
+			std::min(split - blockPos, sampsToWrite) :
+			0u;
 
-				if (std::abs(outBuf[i]) > peak)
-					peak = std::abs(outBuf[i]);
-			}
-			else
-			{
-				outBuf[i] = 0.0f;
-			}
-
-			index++;
-			if (index >= bufSize)
-				index -= loopLength;
-		}
+		if (isPlaying)
+			std::fill(outBuf, outBuf + splitAt, 0.0f);
+		else
+			std::fill(outBuf + splitAt, outBuf + sampsToWrite, 0.0f);
 	}
 
 	_lastPeak = peak;
 	return sampsToWrite;
 }
 
+bool Loop::IsSilentBlock(int sampOffset,
+	unsigned int numSamps) const
+{
+	auto playState = _playState.load(std::memory_order_acquire);
+	auto loopLength = _loopLength.load(std::memory_order_relaxed);
+
+	if (!_IsAudible(playState) || (0 == loopLength))
+		return false;
+
+	auto sampsToRead = (numSamps <= constants::MaxBlockSize) ? numSamps : constants::MaxBlockSize;
+	return _IsSilentSpan(_PlayIndexAt(sampOffset, loopLength), sampsToRead, loopLength);
+}
+
 // Only called when outputting to DAC
 void Loop::WriteBlock(const std::shared_ptr<MultiAudioSink> dest,
 	const std::shared_ptr<Trigger> trigger,
 	int sampOffset,
 	unsigned int numSamps)
 {
+	JAMMA_PROFILE_SCOPE(STAGE_LOOP);
+
 	// Mixer will stereo spread the mono wav
 	// and adjust level
 	auto loopLength = _loopLength.load(std::memory_order_relaxed);
@@ -406,14 +353,33 @@ void Loop::WriteBlock(const std::shared_ptr<MultiAudioSink> dest,
 	if (STATE_RECORDING == playState)
 		_mixer->Offset(numSamps);
 
+	// A silent block adds nothing unless a plugin could still ring on
+	auto chain = _vstChain.Load();
+	auto isChainActive = chain && chain->IsActive();
+
+	// Under overload, plugins on loops that can't be heard don't get to ring on
+	if (isChainActive &&
+		audio::LoadMonitor::Instance().IsShedding(audio::LoadMonitor::SHED_QUIETVST) &&
+		(_mixer->IsMuted() || IsSilentBlock(sampOffset, numSamps)))
+		isChainActive = false;
+
+	if (!isChainActive && (nullptr == trigger) && IsSilentBlock(sampOffset, numSamps))
+	{
+		auto sampsSkipped = (numSamps <= constants::MaxBlockSize) ? numSamps : constants::MaxBlockSize;
+		_lastPeak = 0.0f;
+		_mixer->UpdateVu(0.0f, sampsSkipped);
+		_mixer->Offset(sampsSkipped);
+		JAMMA_PROFILE_COUNT(COUNTER_SILENT_LOOP_BLOCKS);
+		return;
+	}
+
 	// Read source data from BufferBank into stack-allocated temp buffer
 	float tempBuf[constants::MaxBlockSize];
 	auto sampsToWrite = ReadBlock(tempBuf, sampOffset, numSamps);
 
 	if (sampsToWrite > 0)
 	{
-		auto chain = _vstChain.load(std::memory_order_acquire);
-		if (chain && chain->IsActive())
+		if (isChainActive)
 			chain->ProcessBlock(tempBuf, static_cast<int>(sampsToWrite));
 
 		// Route to destination via mixer or trigger
@@ -427,6 +393,11 @@ void Loop::WriteBlock(const std::shared_ptr<MultiAudioSink> dest,
 
 void Loop::EndMultiPlay(unsigned int numSamps)
 {
+	// End of the block, so a pending transition is a block closer
+	auto split = _transitionOffset.load(std::memory_order_relaxed);
+	if (split > 0u)
+		_transitionOffset.compare_exchange_strong(split, (split > numSamps) ? split - numSamps : 0u, std::memory_order_release);
+
 	auto playState = _playState.load(std::memory_order_relaxed);
 	auto loopLength = _loopLength.load(std::memory_order_relaxed);
 	auto isPlaying = (STATE_PLAYING == playState) ||
@@ -448,6 +419,20 @@ void Loop::EndMultiPlay(unsigned int numSamps)
 		playIndex -= loopLength;
 	_playIndex.store(playIndex, std::memory_order_relaxed);
 
+	// Wrapping back to the crossfade pre-roll keeps it in the window
+	auto stream = _Stream();
+	if (nullptr != stream)
+		stream->SetPlayHead(playIndex, constants::MaxLoopFadeSamps - _loopParams.FadeSamps, bufSize);
+
+	// Swap in any banks packed since the last block, and count how long
+	// the loop has gone unwritten so Update() knows when to pack it
+	_bufferBank.CommitPacked();
+
+	if (_IsCapturing(playState, _isPunchInActive.load(std::memory_order_relaxed)))
+		_idleSamps.store(0ul, std::memory_order_relaxed);
+	else
+		_idleSamps.store(std::min(_idleSamps.load(std::memory_order_relaxed), ~0ul - numSamps) + numSamps, std::memory_order_relaxed);
+
 	for (unsigned int chan = 0; chan < NumOutputChannels(Audible::AUDIOSOURCE_LOOPS); chan++)
 	{
 		const auto& channel = _OutputChannel(chan);
@@ -456,6 +441,9 @@ void Loop::EndMultiPlay(unsigned int numSamps)
 			channel->EndPlay(numSamps);
 	}
 
+	if (audio::LoadMonitor::Instance().IsShedding(audio::LoadMonitor::SHED_VU))
+		return;
+
 	auto newValue = _lastPeak * _mixer->Level();
 	_vu->SetValue(newValue, numSamps);
 }
@@ -475,6 +463,12 @@ std::string Loop::Id() const
 	return _loopParams.Id;
 }
 
+bool Loop::IsBeingWritten() const noexcept
+{
+	auto playState = _playState.load(std::memory_order_acquire);
+	return (STATE_INACTIVE != playState) && (STATE_PLAYING != playState);
+}
+
 std::vector<float> Loop::ExportSamples() const
 {
 	auto playState = _playState.load(std::memory_order_acquire);
@@ -484,24 +478,63 @@ std::vector<float> Loop::ExportSamples() const
 		return {};
 
 	std::vector<float> out(loopLength);
-	unsigned long copied = 0;
-	while (copied < loopLength)
+
+	// Packed banks can be swapped out by the audio thread while we read
+	utils::EpochReadGuard guard;
+
+	if (IsStreaming())
 	{
-		const auto idx = constants::MaxLoopFadeSamps + copied;
-		const auto bankOffset = idx % BufferBank::_BufferBankSize;
-		const auto samplesInBank = BufferBank::_BufferBankSize - bankOffset;
-		const auto chunkSize = std::min(loopLength - copied, samplesInBank);
-		const auto* ptr = _bufferBank.BlockPtr(idx);
-
-		if (ptr != nullptr)
-			std::copy_n(ptr, chunkSize, out.data() + copied);
-		else
-			std::fill(out.data() + copied, out.data() + copied + chunkSize, 0.0f);
+		auto stream = _streamBank.LoadShared();
+		auto numRead = stream ? stream->ReadSource(constants::MaxLoopFadeSamps, out.data(), loopLength) : 0ul;
+		std::fill(out.begin() + numRead, out.end(), 0.0f);
 
-		copied += chunkSize;
+		return out;
 	}
 
-	return out;
+	// Audio keeps running, so an overdub may write while we copy. A copy
+	// is clean when the write count was even (no write in progress) before
+	// it and unchanged after. A loop overdubbed throughout every attempt
+	// gives nothing rather than a torn copy, so the export fails.
+	for (auto attempt = 0u; attempt < constants::ExportSnapshotAttempts; attempt++)
+	{
+		const auto writeCount = _bufferBank.WriteCount();
+		if (0u != (writeCount & 1u))
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		unsigned long copied = 0;
+		while (copied < loopLength)
+		{
+			const auto chunkSize = static_cast<unsigned int>(std::min<unsigned long>(loopLength - copied, constants::MaxBlockSize));
+			_bufferBank.Read(constants::MaxLoopFadeSamps + copied, out.data() + copied, chunkSize);
+
+			copied += chunkSize;
+		}
+
+		// Keeps the copy above from moving past the second load
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (_bufferBank.WriteCount() == writeCount)
+			return out;
+	}
+
+	return {};
+}
+
+unsigned long Loop::StoredLength() const
+{
+	utils::EpochReadGuard guard;
+
+	return _StoredLength();
+}
+
+void Loop::ReadStored(unsigned long index, float* dest, unsigned int numSamps) const
+{
+	// Packed banks can be swapped out by the audio thread while we read
+	utils::EpochReadGuard guard;
+
+	_bufferBank.Read(index, dest, numSamps);
 }
 
 io::JamFile::Loop Loop::ToJamFile(const std::string& wavFilename) const
@@ -553,7 +586,7 @@ io::JamFile::Loop Loop::ToJamFile(const std::string& wavFilename) const
 			entry.Path = utils::EncodeUtf8(_vstPluginPaths[i]);
 			entry.Bypass = false;
 
-			auto chain = _vstChain.load(std::memory_order_acquire);
+			auto chain = _vstChain.LoadShared();
 			if (chain && i < chain->NumPlugins())
 			{
 				auto plugin = chain->GetPlugin(i);
@@ -589,28 +622,35 @@ void Loop::SetVisualUpdatesEnabled(bool enabled)
 
 bool Loop::Load(const io::WavReadWriter& readWriter)
 {
-	auto loadOpt = readWriter.Read(utils::DecodeUtf8(_loopParams.Wav), constants::MaxLoopBufferSize);
+	auto stream = readWriter.OpenStream(utils::DecodeUtf8(_loopParams.Wav));
+	_fileSampleRate = stream ? stream->SampleRate() : 0u;
 
-	if (!loadOpt.has_value())
+	return LoadSource(std::move(stream));
+}
+
+bool Loop::LoadSource(std::unique_ptr<audio::SampleSource> source)
+{
+	if (!source)
 		return false;
 
-	auto [buffer, sampleRate, bitDepth] = loadOpt.value();
+	if (audio::StreamPrefetcher::Instance().ShouldStream(source->Length()))
+		return _LoadStreaming(std::move(source));
+
+	_isStreaming.store(false, std::memory_order_release);
+	_streamBank.Publish(nullptr);
 
 	_loopLength.store(0, std::memory_order_relaxed);
 	_bufferBank.Init();
 
-	auto length = (unsigned long)buffer.size();
-	_bufferBank.Resize(length);
+	auto length = _LoadBanks(*source, std::min(source->Length(), constants::MaxLoopBufferSize));
+	if (0ul == length)
+		return false;
 
-	for (auto i = 0u; i < length; i++)
-	{
-		_bufferBank[i] = buffer[i];
-	}
+	// Marks the whole loop dirty, so the next Update() builds the model
+	_bufferBank.UpdateSummary(0ul, length);
 
 	_loopLength.store(length - constants::MaxLoopFadeSamps, std::memory_order_relaxed);
 
-	_UpdateLoopModel();
-
 	return true;
 }
 
@@ -628,9 +668,14 @@ void Loop::Record()
 
 void Loop::Play(unsigned long index,
 	unsigned long loopLength,
-	bool continueRecording)
+	bool continueRecording,
+	unsigned int blockOffset)
 {
-	auto physBufSize = _bufferBank.Length();
+	// Play can come from the UI thread as well as the tick, and the stream
+	// is read through _Stream() below
+	utils::EpochReadGuard guard;
+
+	auto physBufSize = _StoredLength();
 
 	if (0 == physBufSize)
 	{
@@ -638,6 +683,8 @@ void Loop::Play(unsigned long index,
 		return;
 	}
 
+	_BeginTransition(blockOffset);
+
 	// Clamp against the smaller of the logical loop size and the currently
 	// recorded physical size. Keep the MaxLoopFadeSamps logical offset in this
 	// bound: playback indices are in [fadeOffset, fadeOffset + loopLength).
@@ -645,6 +692,11 @@ void Loop::Play(unsigned long index,
 	auto effectiveBufSize = std::min(logicalBufSize, physBufSize);
 	_playIndex.store((effectiveBufSize > 0 && index >= effectiveBufSize) ? (effectiveBufSize - 1) : index, std::memory_order_relaxed);
 	_loopLength.store(loopLength, std::memory_order_relaxed);
+
+	// Start the play head early by the offset, so it reaches index
+	// on the sample that playback starts
+	if ((blockOffset > 0u) && (loopLength > 0))
+		_playIndex.store(_PlayIndexAt(-static_cast<int>(blockOffset), loopLength), std::memory_order_relaxed);
 	if (_isPunchInActive.load(std::memory_order_relaxed))
 		continueRecording = true;
 
@@ -653,7 +705,7 @@ void Loop::Play(unsigned long index,
 	if (_isPunchInActive.load(std::memory_order_relaxed))
 		isOverdubbing = true;
 	auto recordState = isOverdubbing ? STATE_OVERDUBBINGRECORDING : STATE_PLAYINGRECORDING;
-	auto nextPlayState = continueRecording ? recordState : STATE_PLAYING;
+	auto nextPlayState = (continueRecording && !IsStreaming()) ? recordState : STATE_PLAYING;
 
 	// Pre-allocate buffer capacity for recording state to prevent SetLength clamping.
 	// This ensures the full loop length can be written during overdub/recording.
@@ -664,15 +716,22 @@ void Loop::Play(unsigned long index,
 		_bufferBank.Resize(logicalBufSize);
 	}
 
+	auto stream = _Stream();
+	if ((nullptr != stream) && (loopLength > 0))
+		stream->SetPlayHead(_playIndex.load(std::memory_order_relaxed), constants::MaxLoopFadeSamps - _loopParams.FadeSamps, logicalBufSize);
+
 	_playState.store(loopLength > 0 ? nextPlayState : STATE_INACTIVE, std::memory_order_release);
 }
 
 void Loop::Reset()
 {
 	_isPunchInActive.store(false, std::memory_order_relaxed);
+	_isStreaming.store(false, std::memory_order_relaxed);
+	_transitionOffset.store(0u, std::memory_order_relaxed);
 
 	_writeIndex.store(0ul, std::memory_order_relaxed);
 	_playIndex.store(0ul, std::memory_order_relaxed);
+	_idleSamps.store(0ul, std::memory_order_relaxed);
 	_loopLength.store(0ul, std::memory_order_relaxed);
 	_playState.store(STATE_INACTIVE, std::memory_order_release);
 	_mixer->UnMute();
@@ -683,6 +742,27 @@ void Loop::Update()
 {
 	RefreshVisualModel();
 	UpdateCapacity();
+
+	// Hand back the window of a stream that Reset() let go of
+	if (!IsStreaming() && (nullptr != _streamBank.LoadShared()))
+		_streamBank.Publish(nullptr);
+
+	// Pack the loop once it has played untouched for long enough, and
+	// again after any overdub has gone quiet
+	auto compactIdleSamps = audio::BankPool::Instance().CompactIdleSamps();
+	auto isIdle = (compactIdleSamps > 0ul) &&
+		(_idleSamps.load(std::memory_order_relaxed) >= compactIdleSamps);
+
+	if (!isIdle)
+	{
+		_isCompacted = false;
+	}
+	else if (!_isCompacted && _CanCompact() && !IsStreaming())
+	{
+		_isCompacted = true;
+		_isCompactPending = true;
+		_changesMade = true;
+	}
 }
 
 void Loop::UpdateCapacity()
@@ -691,6 +771,14 @@ void Loop::UpdateCapacity()
 	_monitorBufferBank.UpdateCapacity();
 }
 
+std::size_t Loop::BufferBytes() const
+{
+	auto stream = _streamBank.LoadShared();
+	auto streamBytes = stream ? stream->AllocatedBytes() : 0u;
+
+	return _bufferBank.AllocatedBytes() + _monitorBufferBank.AllocatedBytes() + streamBytes;
+}
+
 void Loop::RefreshVisualModel()
 {
 	if (!CanRefreshVisualModel())
@@ -768,25 +856,33 @@ void Loop::Overdub()
 	_playState.store(STATE_OVERDUBBING, std::memory_order_release);
 }
 
-void Loop::PunchIn()
+void Loop::PunchIn(unsigned int blockOffset)
 {
+	// A streamed loop has nowhere in memory to take the overdub
+	if (IsStreaming())
+		return;
+
 	auto playState = _playState.load(std::memory_order_relaxed);
 	if ((STATE_OVERDUBBING != playState) &&
 		(STATE_OVERDUBBINGRECORDING != playState) &&
 		(STATE_PLAYING != playState))
 		return;
 
+	_BeginTransition(blockOffset);
+
 	_isPunchInActive.store(true, std::memory_order_release);
 	if (STATE_OVERDUBBING == playState)
 		_playState.store(STATE_PUNCHEDIN, std::memory_order_release);
 }
 
-void Loop::PunchOut()
+void Loop::PunchOut(unsigned int blockOffset)
 {
 	auto playState = _playState.load(std::memory_order_relaxed);
 	if (!_isPunchInActive.load(std::memory_order_relaxed) && (STATE_PUNCHEDIN != playState))
 		return;
 
+	_BeginTransition(blockOffset);
+
 	_isPunchInActive.store(false, std::memory_order_release);
 	if (STATE_PUNCHEDIN == playState)
 		_playState.store(STATE_OVERDUBBING, std::memory_order_release);
@@ -845,11 +941,303 @@ LoopModel::LoopModelState Loop::_GetLoopModelState(base::DrawPass pass, LoopPlay
 	}
 }
 
+bool Loop::_IsCapturing(LoopPlayState playState, bool isPunchInActive) noexcept
+{
+	return (STATE_RECORDING == playState) ||
+		(STATE_PLAYINGRECORDING == playState) ||
+		(STATE_OVERDUBBING == playState) ||
+		(STATE_PUNCHEDIN == playState) ||
+		(STATE_OVERDUBBINGRECORDING == playState) ||
+		isPunchInActive;
+}
+
+bool Loop::_IsAudible(LoopPlayState playState) noexcept
+{
+	return (STATE_PLAYING == playState) ||
+		(STATE_PLAYINGRECORDING == playState) ||
+		(STATE_OVERDUBBINGRECORDING == playState) ||
+		(STATE_PUNCHEDIN == playState);
+}
+
+bool Loop::_AcceptsWrite(LoopPlayState playState,
+	bool isPunchInActive,
+	Audible::AudioSourceType source) noexcept
+{
+	if (!_IsCapturing(playState, isPunchInActive))
+		return false;
+
+	if (AUDIOSOURCE_ADC == source)
+	{
+		return (STATE_RECORDING == playState) ||
+			(STATE_PLAYINGRECORDING == playState) ||
+			(STATE_PUNCHEDIN == playState) ||
+			isPunchInActive;
+	}
+
+	if (AUDIOSOURCE_BOUNCE == source)
+		return STATE_RECORDING != playState;
+
+	return STATE_OVERDUBBING != playState;
+}
+
 unsigned long Loop::_ModelDisplayLength(bool isRecording, unsigned long actualLoopLength) const
 {
 	return actualLoopLength;
 }
 
+unsigned long Loop::_PlayIndexAt(int sampOffset, unsigned long loopLength) const
+{
+	auto bufSize = loopLength + constants::MaxLoopFadeSamps;
+
+	// _playIndex is always within range:
+	// [constants::MaxLoopFadeSamps : _loopLength + constants::MaxLoopFadeSamps - 1)
+	// index should apply the offset and then also stay in the same range
+	auto index = _playIndex.load(std::memory_order_relaxed);
+
+	if (sampOffset >= 0)
+	{
+		index += sampOffset;
+	}
+	else
+	{
+		while (index < (unsigned long)(-sampOffset))
+			index += loopLength;
+
+		index += sampOffset;
+	}
+
+	while (index >= bufSize)
+		index -= loopLength;
+
+	if (index < constants::MaxLoopFadeSamps)
+		index += loopLength;
+
+	return index;
+}
+
+bool Loop::_IsSilentSpan(unsigned long index,
+	unsigned long numSamps,
+	unsigned long loopLength) const
+{
+	// The silence map only covers loops held in memory
+	if (IsStreaming())
+		return false;
+
+	auto bufSize = loopLength + constants::MaxLoopFadeSamps;
+	auto preRollStart = constants::MaxLoopFadeSamps - _loopParams.FadeSamps;
+
+	// The span covers the whole loop at least once
+	if (numSamps >= loopLength)
+		return _bufferBank.IsSilent(preRollStart, bufSize);
+
+	auto end = index + numSamps;
+	if (end <= bufSize)
+	{
+		if (!_bufferBank.IsSilent(index, end))
+			return false;
+	}
+	else
+	{
+		if (!_bufferBank.IsSilent(index, bufSize) ||
+			!_bufferBank.IsSilent(constants::MaxLoopFadeSamps, end - loopLength))
+			return false;
+	}
+
+	// The crossfade also reads the pre-roll before the loop start
+	if (end >= (bufSize - _loopParams.FadeSamps))
+		return _bufferBank.IsSilent(preRollStart, constants::MaxLoopFadeSamps);
+
+	return true;
+}
+
+void Loop::_BeginTransition(unsigned int blockOffset) noexcept
+{
+	// A second change before the first has landed keeps the state the
+	// block started in, and lands no later than the first
+	auto pending = _transitionOffset.load(std::memory_order_relaxed);
+	if (0u == pending)
+	{
+		_prevPlayState.store(_playState.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		_wasPunchInActive.store(_isPunchInActive.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		_transitionOffset.store(blockOffset, std::memory_order_release);
+	}
+	else if (blockOffset < pending)
+	{
+		_transitionOffset.store(blockOffset, std::memory_order_release);
+	}
+}
+
+void Loop::_WriteSpan(const base::AudioWriteRequest& request,
+	unsigned int first,
+	unsigned int numSamps,
+	unsigned long startIndex,
+	LoopPlayState playState)
+{
+	auto samples = request.samples + (static_cast<size_t>(first) * request.stride);
+	auto fadeRamp = (nullptr != request.fadeRamp) ? request.fadeRamp + first : nullptr;
+
+	if (AUDIOSOURCE_MONITOR == request.source)
+	{
+		_monitorBufferBank.FadeMixBlock(startIndex,
+			samples,
+			request.stride,
+			numSamps,
+			request.fadeCurrent,
+			request.fadeNew,
+			fadeRamp,
+			request.fadeCurrentRamp);
+
+		if (STATE_RECORDING == playState)
+		{
+			float peak = _lastPeak;
+
+			for (unsigned int i = 0; i < numSamps; i++)
+			{
+				auto absSamp = std::abs(samples[i * request.stride]);
+				if (absSamp > peak)
+					peak = absSamp;
+			}
+
+			_lastPeak = peak;
+		}
+	}
+	else
+	{
+		_bufferBank.FadeMixBlock(startIndex,
+			samples,
+			request.stride,
+			numSamps,
+			request.fadeCurrent,
+			request.fadeNew,
+			fadeRamp,
+			request.fadeCurrentRamp);
+
+		if (_isJournalled.load(std::memory_order_relaxed))
+			_journalRing.Push(startIndex, numSamps);
+	}
+}
+
+unsigned long Loop::_LoadBanks(audio::SampleSource& source, unsigned long length)
+{
+	_bufferBank.Resize(length);
+
+	auto bankSize = _bufferBank.BankSize();
+	auto index = 0ul;
+
+	while (index < length)
+	{
+		// Null once the pool is out of budget
+		auto dest = _bufferBank.BlockPtr(index);
+		if (nullptr == dest)
+			break;
+
+		auto span = std::min(length - index, bankSize - (index & (bankSize - 1ul)));
+		auto numRead = source.Read(index, dest, span);
+		index += numRead;
+
+		if (numRead < span)
+			break;
+	}
+
+	if (index < length)
+		_bufferBank.Resize(index);
+
+	return index;
+}
+
+bool Loop::_LoadStreaming(std::unique_ptr<audio::SampleSource> source)
+{
+	auto length = source->Length();
+	if (length <= constants::MaxLoopFadeSamps)
+		return false;
+
+	auto& prefetcher = audio::StreamPrefetcher::Instance();
+	auto stream = std::make_shared<audio::StreamingBank>(std::move(source), prefetcher.WindowBanks());
+
+	// Fill the window from the loop start before anything plays
+	stream->SetPlayHead(constants::MaxLoopFadeSamps, constants::MaxLoopFadeSamps - _loopParams.FadeSamps, length);
+	stream->Prefetch();
+
+	_loopLength.store(0, std::memory_order_relaxed);
+	_bufferBank.Init();
+
+	_streamBank.Publish(stream);
+	_isStreaming.store(true, std::memory_order_release);
+	prefetcher.Add(stream);
+
+	// The model is left for the next Update(), as for loaded slabs
+	_loopLength.store(length - constants::MaxLoopFadeSamps, std::memory_order_relaxed);
+
+	return true;
+}
+
+audio::StreamingBank* Loop::_Stream() const noexcept
+{
+	if (!_isStreaming.load(std::memory_order_acquire))
+		return nullptr;
+
+	return _streamBank.Load();
+}
+
+unsigned long Loop::_StoredLength() const
+{
+	auto stream = _Stream();
+	return (nullptr != stream) ? stream->Length() : _bufferBank.Length();
+}
+
+template<typename Bank>
+float Loop::_ReadSpan(Bank& bank,
+	float* outBuf,
+	unsigned long index,
+	unsigned int numSamps,
+	unsigned long loopLength)
+{
+	auto bufSize = loopLength + constants::MaxLoopFadeSamps;
+	auto xfadeStart = bufSize - _loopParams.FadeSamps;
+	auto bankLength = bank.Length();
+	auto peak = 0.0f;
+	auto done = 0u;
+
+	// Contiguous reads up to each wrap, then the crossfade over the tail
+	while (done < numSamps)
+	{
+		auto span = static_cast<unsigned int>(std::min<unsigned long>(numSamps - done, bufSize - index));
+		auto spanBuf = outBuf + done;
+		bank.Read(index, spanBuf, span);
+
+		// Nothing is mixed over the silence past the end of the bank
+		auto xfadeEnd = std::min(index + span, bankLength);
+
+		if (xfadeEnd > xfadeStart)
+		{
+			float xfadeBuf[constants::MaxBlockSize];
+			auto first = std::max(index, xfadeStart);
+			auto numXfade = static_cast<unsigned int>(xfadeEnd - first);
+			auto xfadeIndex = first - xfadeStart;
+			bank.Read(constants::MaxLoopFadeSamps - _loopParams.FadeSamps + xfadeIndex, xfadeBuf, numXfade);
+
+			for (auto i = 0u; i < numXfade; i++)
+			{
+				auto& samp = spanBuf[first - index + i];
+				samp = _hanning->Mix(xfadeBuf[i], samp, xfadeIndex + i);
+			}
+		}
+
+		for (auto i = 0u; i < span; i++)
+		{
+			if (std::abs(spanBuf[i]) > peak)
+				peak = std::abs(spanBuf[i]);
+		}
+
+		done += span;
+		index += span;
+		if (index >= bufSize)
+			index -= loopLength;
+	}
+
+	return peak;
+}
+
 unsigned long Loop::_LoopIndex() const
 {
 	auto playIndex = _playIndex.load(std::memory_order_relaxed);
@@ -864,6 +1252,10 @@ void Loop::_UpdateLoopModel()
 	if (!_visualUpdatesEnabled)
 		return;
 
+	// The dirty range is kept, so the model catches up once load drops
+	if (audio::LoadMonitor::Instance().IsShedding(audio::LoadMonitor::SHED_VISUALS))
+		return;
+
 	_ForceUpdateLoopModel();
 }
 
@@ -879,17 +1271,21 @@ void Loop::_ForceUpdateLoopModel()
 
 	auto radius = (float)(CalcDrawRadius(displayLength) * _DrawRadiusScale());
 	auto& bufBank = isRecording ? _monitorBufferBank : _bufferBank;
-	_ApplyLoopVisualModel(bufBank, actualLength, displayLength, offset, radius);
+
+	// Keeps slabs swapped out for packed banks alive while they are summed
+	utils::EpochReadGuard guard;
+	_ApplyLoopVisualModel(bufBank, actualLength, displayLength, offset, radius, bufBank.TakeDirtyRange());
 }
 
 void Loop::_ApplyLoopVisualModel(const BufferBank& buffer,
 	unsigned long actualLength,
 	unsigned long displayLength,
 	unsigned long offset,
-	float radius)
+	float radius,
+	BufferBank::SampleRange changed)
 {
 	const auto allowUnchangedSkip = (STATE_PLAYING == _playState.load(std::memory_order_relaxed));
-	_model->UpdateModel(buffer, actualLength, displayLength, offset, radius, allowUnchangedSkip);
+	_model->UpdateModel(buffer, actualLength, displayLength, offset, radius, allowUnchangedSkip, changed);
 	_vu->UpdateModel(radius);
 }
 
@@ -906,9 +1302,21 @@ void Loop::UnloadVstPlugin(size_t index)
 	_changesMade = true;
 }
 
+void Loop::SetSampleRate(float sampleRate)
+{
+	_sampleRate = sampleRate;
+
+	// Nothing resamples, so the loop plays back at the wrong pitch
+	if ((0u != _fileSampleRate) && (_fileSampleRate != static_cast<unsigned int>(sampleRate)))
+	{
+		std::cout << "Loop " << Id() << " was recorded at " << _fileSampleRate
+			<< "Hz but plays at " << sampleRate << "Hz" << std::endl;
+	}
+}
+
 std::shared_ptr<vst::IVstPlugin> Loop::GetVstPlugin(size_t index) const
 {
-	auto chain = _vstChain.load(std::memory_order_acquire);
+	auto chain = _vstChain.LoadShared();
 	if (!chain)
 		return nullptr;
 
@@ -920,7 +1328,7 @@ std::vector<JobAction> Loop::_CommitChanges()
 	// Swap in a new VST chain when the job thread has delivered one.
 	if (_flipVstChain.exchange(false, std::memory_order_acquire))
 	{
-		_vstChain.store(_backVstChain, std::memory_order_release);
+		_vstChain.Publish(_backVstChain);
 	}
 
 	std::vector<JobAction> jobs;
@@ -950,6 +1358,17 @@ std::vector<JobAction> Loop::_CommitChanges()
 		jobs.push_back(std::move(job));
 	}
 
+	if (_isCompactPending)
+	{
+		_isCompactPending = false;
+
+		JobAction job;
+		job.JobActionType = JobAction::JOB_COMPACTLOOP;
+		job.SourceId = Id();
+		job.Receiver = ActionReceiver::shared_from_this();
+		jobs.push_back(job);
+	}
+
 	GuiElement::_CommitChanges();
 
 	return jobs;
@@ -964,7 +1383,7 @@ ActionResult Loop::OnAction(JobAction action)
 		// Take a snapshot of the current live chain under _vstChainMutex so we
 		// don't race with _CommitChanges() swapping it on the main thread.
 		std::shared_ptr<vst::VstChain> chainSnapshot;
-		chainSnapshot = _vstChain.load(std::memory_order_acquire);
+		chainSnapshot = _vstChain.LoadShared();
 
 		auto newChain = std::make_shared<vst::VstChain>();
 		if (chainSnapshot)
@@ -1011,7 +1430,7 @@ ActionResult Loop::OnAction(JobAction action)
 	{
 		// Take a snapshot of the current live chain under _vstChainMutex.
 		std::shared_ptr<vst::VstChain> chainSnapshot;
-		chainSnapshot = _vstChain.load(std::memory_order_acquire);
+		chainSnapshot = _vstChain.LoadShared();
 
 		auto newChain = std::make_shared<vst::VstChain>();
 		const auto removeIndex = action.VstIndex;
@@ -1042,6 +1461,16 @@ ActionResult Loop::OnAction(JobAction action)
 		res.ResultType = actions::ACTIONRESULT_DEFAULT;
 		return res;
 	}
+	case JobAction::JOB_COMPACTLOOP:
+	{
+		// The audio thread swaps the packed banks in at the end of a block
+		_bufferBank.PackBanks();
+
+		ActionResult res;
+		res.IsEaten = true;
+		res.ResultType = actions::ACTIONRESULT_DEFAULT;
+		return res;
+	}
 	default:
 		break;
 	}
@@ -6,6 +6,7 @@
 #include <mutex>
 #include "Trigger.h"
 #include "ActionReceiver.h"
+#include "LoopLoader.h"
 #include "Tweakable.h"
 #include "ResourceUser.h"
 #include "GlUtils.h"
@@ -15,12 +16,16 @@
 #include "../io/FileReadWriter.h"
 #include "../io/JamFile.h"
 #include "../audio/BufferBank.h"
+#include "../audio/DirtyRangeRing.h"
+#include "../audio/StreamingBank.h"
+#include "../audio/StreamPrefetcher.h"
 #include "../audio/AudioMixer.h"
 #include "../audio/Hanning.h"
 #include "../graphics/VU.h"
 #include "../graphics/GlDrawContext.h"
 #include "../resources/WavResource.h"
 #include "../vst/VstChain.h"
+#include "../utils/Epoch.h"
 
 namespace engine
 {
@@ -82,6 +87,8 @@ namespace engine
 		public base::AudioSink
 	{
 	public:
+		using JournalRing = audio::DirtyRangeRing<constants::JournalRingSize>;
+
 		enum LoopPlayState
 		{
 			STATE_INACTIVE,
@@ -112,6 +119,9 @@ namespace engine
 			_loopLength(other._loopLength.load(std::memory_order_relaxed)),
 			_playState(other._playState.load(std::memory_order_relaxed)),
 			_playIndex(other._playIndex.load(std::memory_order_relaxed)),
+			_transitionOffset(other._transitionOffset.load(std::memory_order_relaxed)),
+			_prevPlayState(other._prevPlayState.load(std::memory_order_relaxed)),
+			_wasPunchInActive(other._wasPunchInActive.load(std::memory_order_relaxed)),
 			_loopParams{other._loopParams},
 			_mixer(std::move(other._mixer)),
 			_hanning(std::move(other._hanning)),
@@ -119,12 +129,18 @@ namespace engine
 			_vu(std::move(other._vu)),
 			_bufferBank(std::move(other._bufferBank)),
 			_monitorBufferBank(std::move(other._monitorBufferBank)),
-			_vstChain(other._vstChain.exchange(nullptr, std::memory_order_acq_rel)),
+			_isStreaming(other._isStreaming.load(std::memory_order_relaxed)),
+			_streamBank(std::move(other._streamBank)),
+			_idleSamps(other._idleSamps.load(std::memory_order_relaxed)),
+			_isCompacted(other._isCompacted),
+			_isCompactPending(other._isCompactPending),
+			_vstChain(std::move(other._vstChain)),
 			_backVstChain(std::move(other._backVstChain)),
 			_flipVstChain(other._flipVstChain.load(std::memory_order_relaxed)),
 			_pendingVstLoads(std::move(other._pendingVstLoads)),
 			_pendingVstUnloads(std::move(other._pendingVstUnloads)),
 			_sampleRate(other._sampleRate),
+			_fileSampleRate(other._fileSampleRate),
 			_blockSize(other._blockSize),
 			_vstPluginPaths(std::move(other._vstPluginPaths))
 		{
@@ -132,6 +148,10 @@ namespace engine
 			other._writeIndex.store(0ul, std::memory_order_relaxed);
 			other._visualUpdatesEnabled = true;
 			other._isPunchInActive.store(false, std::memory_order_relaxed);
+			other._transitionOffset.store(0u, std::memory_order_relaxed);
+			other._prevPlayState.store(STATE_INACTIVE, std::memory_order_relaxed);
+			other._wasPunchInActive.store(false, std::memory_order_relaxed);
+			other._isStreaming.store(false, std::memory_order_relaxed);
 			other._loopParams = LoopParams();
 			other._mixer = std::make_unique<audio::AudioMixer>(audio::AudioMixerParams());
 			other._flipVstChain.store(false, std::memory_order_relaxed);
@@ -157,6 +177,12 @@ namespace engine
 				_playIndex.store(other._playIndex.exchange(playIndex, std::memory_order_relaxed), std::memory_order_relaxed);
 				auto playState = _playState.load(std::memory_order_relaxed);
 				_playState.store(other._playState.exchange(playState, std::memory_order_relaxed), std::memory_order_relaxed);
+				auto transitionOffset = _transitionOffset.load(std::memory_order_relaxed);
+				_transitionOffset.store(other._transitionOffset.exchange(transitionOffset, std::memory_order_relaxed), std::memory_order_relaxed);
+				auto prevPlayState = _prevPlayState.load(std::memory_order_relaxed);
+				_prevPlayState.store(other._prevPlayState.exchange(prevPlayState, std::memory_order_relaxed), std::memory_order_relaxed);
+				bool wasPunchIn = _wasPunchInActive.load(std::memory_order_relaxed);
+				_wasPunchInActive.store(other._wasPunchInActive.exchange(wasPunchIn, std::memory_order_relaxed), std::memory_order_relaxed);
 				std::swap(_loopParams, other._loopParams);
 				std::swap(_loggingConfig, other._loggingConfig);
 				_mixer.swap(other._mixer);
@@ -165,8 +191,14 @@ namespace engine
 				_vu.swap(other._vu);
 				std::swap(_bufferBank, other._bufferBank);
 				std::swap(_monitorBufferBank, other._monitorBufferBank);
-				auto chain = _vstChain.exchange(other._vstChain.load(std::memory_order_acquire), std::memory_order_acq_rel);
-				other._vstChain.store(chain, std::memory_order_release);
+				bool isStreaming = _isStreaming.load(std::memory_order_relaxed);
+				_isStreaming.store(other._isStreaming.exchange(isStreaming, std::memory_order_relaxed), std::memory_order_relaxed);
+				_streamBank.Swap(other._streamBank);
+				auto idleSamps = _idleSamps.load(std::memory_order_relaxed);
+				_idleSamps.store(other._idleSamps.exchange(idleSamps, std::memory_order_relaxed), std::memory_order_relaxed);
+				std::swap(_isCompacted, other._isCompacted);
+				std::swap(_isCompactPending, other._isCompactPending);
+				_vstChain.Swap(other._vstChain);
 				_backVstChain.swap(other._backVstChain);
 				bool flip = _flipVstChain.load(std::memory_order_relaxed);
 				_flipVstChain.store(other._flipVstChain.load(std::memory_order_relaxed), std::memory_order_relaxed);
@@ -174,6 +206,7 @@ namespace engine
 				std::swap(_pendingVstLoads, other._pendingVstLoads);
 				std::swap(_pendingVstUnloads, other._pendingVstUnloads);
 				std::swap(_sampleRate, other._sampleRate);
+				std::swap(_fileSampleRate, other._fileSampleRate);
 				std::swap(_blockSize, other._blockSize);
 				std::swap(_vstPluginPaths, other._vstPluginPaths);
 			}
@@ -182,9 +215,11 @@ namespace engine
 		}
 
 	public:
+		// The loop comes back empty, with its WAV load added to loader.
 		static std::optional<std::shared_ptr<Loop>> FromFile(LoopParams loopParams,
 			io::JamFile::Loop loopStruct,
-			std::wstring dir);
+			std::wstring dir,
+			LoopLoader& loader);
 		static audio::AudioMixerParams GetMixerParams(utils::Size2d loopSize,
 			audio::BehaviourParams behaviour);
 
@@ -198,6 +233,10 @@ namespace engine
 		unsigned int ReadBlock(float* outBuf,
 			int sampOffset,
 			unsigned int numSamps);
+		// True when playing and ReadBlock would only produce silence, going
+		// by the BufferBank silence map.
+		bool IsSilentBlock(int sampOffset,
+			unsigned int numSamps) const;
 
 		// Reads source data via ReadBlock, then routes to destination
 		// via mixer->WriteBlock → behaviour->ApplyBlock → dest->OnBlockWriteChannel.
@@ -221,34 +260,64 @@ namespace engine
 		void SetLoopChannel(unsigned int channel);
 		std::string Id() const;
 		LoopPlayState PlayState() const { return _playState.load(std::memory_order_relaxed); }
+		// True from Record() or Overdub() until the loop only plays.
+		bool IsBeingWritten() const noexcept;
 		unsigned long LoopLength() const noexcept { return _loopLength.load(std::memory_order_relaxed); }
+		// Pooled buffer memory held by this loop (record and monitor banks).
+		std::size_t BufferBytes() const;
 		static double CalcDrawRadius(unsigned long loopLength);
+		// Safe off the audio thread while audio runs. Empty when no copy
+		// could be taken clear of overdubs.
 		std::vector<float> ExportSamples() const;
+		// Samples held in memory, pre-roll included. Safe off the audio
+		// thread while audio runs; samples past the length read as silence.
+		unsigned long StoredLength() const;
+		void ReadStored(unsigned long index, float* dest, unsigned int numSamps) const;
 		io::JamFile::Loop ToJamFile(const std::string& wavFilename) const;
 		void SetMixerLevel(double level);
 		void SetMasterVisualScale(float scale) noexcept;
 		void SetVisualUpdatesEnabled(bool enabled);
 		bool Load(const io::WavReadWriter& readWriter);
+		// Streams long sources, and decodes the rest straight into the
+		// buffer's slabs. The visual model is left for the next Update().
+		bool LoadSource(std::unique_ptr<audio::SampleSource> source);
 		void Record();
+		// blockOffset delays a change to that many samples into the next
+		// block written; the samples before it keep the previous state.
 		void Play(unsigned long index,
 			unsigned long loopLength,
-			bool continueRecording);
+			bool continueRecording,
+			unsigned int blockOffset = 0u);
 		void EndRecording();
 		void Ditch();
 		void Overdub();
-		void PunchIn();
-		void PunchOut();
+		void PunchIn(unsigned int blockOffset = 0u);
+		void PunchOut(unsigned int blockOffset = 0u);
 		bool IsPunchInActive() const noexcept { return _isPunchInActive.load(std::memory_order_relaxed); }
+		// True when the loop plays from disk through a StreamingBank
+		// rather than from memory. Streamed loops are play-only.
+		bool IsStreaming() const noexcept { return _isStreaming.load(std::memory_order_relaxed); }
 		double LoopIndexFrac() const noexcept;
 
+		// While journalled, each span written to the buffer is queued for
+		// the LoopJournal, which takes them off on its own thread.
+		void SetJournalled(bool journalled) noexcept { _isJournalled.store(journalled, std::memory_order_release); }
+		bool IsJournalled() const noexcept { return _isJournalled.load(std::memory_order_acquire); }
+		bool TakeJournalRange(JournalRing::Range& range) noexcept { return _journalRing.Pop(range); }
+		// True if spans were dropped since the last call, so the whole
+		// buffer needs writing again.
+		bool TakeJournalOverflow() noexcept { return _journalRing.TakeOverflow(); }
+
 		// VST chain management — staging only; actual load/unload happens on the
 		// job thread after CommitChanges() queues the appropriate job.
 		void LoadVstPlugin(std::wstring path,
 			std::vector<std::uint8_t> initialState = {});
 		void UnloadVstPlugin(size_t index);
-		void SetSampleRate(float sampleRate) { _sampleRate = sampleRate; }
+		void SetSampleRate(float sampleRate);
 		void SetBlockSize(unsigned int blockSize) { _blockSize = blockSize; }
 		float GetSampleRate() const noexcept { return _sampleRate; }
+		// The rate of the WAV the loop was loaded from, or zero.
+		unsigned int GetFileSampleRate() const noexcept { return _fileSampleRate; }
 		unsigned int GetBlockSize() const noexcept { return _blockSize; }
 
 		// Non-RT accessor to retrieve a loaded plugin instance (or nullptr).
@@ -258,16 +327,51 @@ namespace engine
 
 	protected:
 		static LoopModel::LoopModelState _GetLoopModelState(base::DrawPass pass, LoopPlayState state, bool isMuted);
+		static bool _IsCapturing(LoopPlayState playState, bool isPunchInActive) noexcept;
+		static bool _IsAudible(LoopPlayState playState) noexcept;
+		static bool _AcceptsWrite(LoopPlayState playState,
+			bool isPunchInActive,
+			Audible::AudioSourceType source) noexcept;
 		virtual unsigned long _ModelDisplayLength(bool isRecording, unsigned long actualLoopLength) const;
 		virtual double _DrawRadiusScale() const noexcept { return 1.0; }
+		// Whether the loop packs its buffer once it has gone idle
+		virtual bool _CanCompact() const noexcept { return true; }
 		virtual void _ApplyLoopVisualModel(const audio::BufferBank& buffer,
 			unsigned long actualLength,
 			unsigned long displayLength,
 			unsigned long offset,
-			float radius);
+			float radius,
+			audio::BufferBank::SampleRange changed);
 		virtual std::vector<actions::JobAction> _CommitChanges() override;
 
 		unsigned long _LoopIndex() const;
+		bool _LoadStreaming(std::unique_ptr<audio::SampleSource> source);
+		// Reads up to length samples a slab at a time, and returns how many
+		// were read.
+		unsigned long _LoadBanks(audio::SampleSource& source, unsigned long length);
+		// The live stream, or nullptr when playing from memory. Callers
+		// must hold an EpochReadGuard, as the audio callback does.
+		audio::StreamingBank* _Stream() const noexcept;
+		// As _Stream(), needs an EpochReadGuard
+		unsigned long _StoredLength() const;
+		// Reads numSamps from index, wrapping at the loop end and mixing the
+		// pre-roll into the crossfade tail, and returns the peak. Samples
+		// past the bank's length read as silence.
+		template<typename Bank>
+		float _ReadSpan(Bank& bank,
+			float* outBuf,
+			unsigned long index,
+			unsigned int numSamps,
+			unsigned long loopLength);
+		// Play index after sampOffset, kept in [MaxLoopFadeSamps, loopLength + MaxLoopFadeSamps)
+		unsigned long _PlayIndexAt(int sampOffset, unsigned long loopLength) const;
+		bool _IsSilentSpan(unsigned long index, unsigned long numSamps, unsigned long loopLength) const;
+		void _BeginTransition(unsigned int blockOffset) noexcept;
+		void _WriteSpan(const base::AudioWriteRequest& request,
+			unsigned int first,
+			unsigned int numSamps,
+			unsigned long startIndex,
+			LoopPlayState playState);
 		void _UpdateLoopModel();
 		void _ForceUpdateLoopModel();
 
@@ -279,6 +383,12 @@ namespace engine
 		double _pitch;
 		std::atomic<unsigned long> _loopLength;
 		std::atomic<LoopPlayState> _playState;
+		// Samples into the current block at which the last state change
+		// lands (0 once it has). Until then the block runs in the state
+		// it started in.
+		std::atomic<unsigned int> _transitionOffset{ 0u };
+		std::atomic<LoopPlayState> _prevPlayState{ STATE_INACTIVE };
+		std::atomic<bool> _wasPunchInActive{ false };
 		LoopParams _loopParams;
 		std::shared_ptr<audio::AudioMixer> _mixer;
 		std::shared_ptr<audio::Hanning> _hanning;
@@ -287,13 +397,24 @@ namespace engine
 		float _masterVisualScale = 1.0f;
 		audio::BufferBank _bufferBank;
 		audio::BufferBank _monitorBufferBank;
+		// Cleared by Reset() on whichever thread; the stream itself is only
+		// dropped off-thread, by Update() or the next Load().
+		std::atomic<bool> _isStreaming{ false };
+		utils::EpochPtr<audio::StreamingBank> _streamBank;
+		std::atomic<bool> _isJournalled{ false };
+		JournalRing _journalRing;
+		// Samples played since the loop was last written to
+		std::atomic<unsigned long> _idleSamps{ 0ul };
+		bool _isCompacted{ false };
+		bool _isCompactPending{ false };
 		// Live VST chain published atomically for lock-free audio-thread reads.
-		std::atomic<std::shared_ptr<vst::VstChain>> _vstChain;
+		utils::EpochPtr<vst::VstChain> _vstChain;
 		std::shared_ptr<vst::VstChain> _backVstChain;
 		std::atomic<bool> _flipVstChain{ false };
 		std::vector<std::pair<std::wstring, std::vector<std::uint8_t>>> _pendingVstLoads;
 		std::vector<size_t> _pendingVstUnloads;
 		float _sampleRate{ static_cast<float>(constants::DefaultSampleRate) };
+		unsigned int _fileSampleRate{ 0u };
 		unsigned int _blockSize{ constants::DefaultBufferSizeSamps };
 		// Non-RT metadata: written on job thread (OnAction), read on main thread (VstEntries).
 		// Access is guarded by _vstPathsMutex in both directions.
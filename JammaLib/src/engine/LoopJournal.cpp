@@ -0,0 +1,456 @@
+#include "LoopJournal.h"
+#include "../include/Constants.h"
+#include "../io/SessionWriter.h"
+#include "../utils/StringUtils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace engine;
+
+LoopJournal::LoopJournal() :
+	_mutex(),
+	_wake(),
+	_isRunning(false),
+	_isStopping(false),
+	_thread(),
+	_dir(),
+	_entries(),
+	_pumpMutex(),
+	_copyBuffer(CopyBlockSamps),
+	_stats()
+{
+}
+
+LoopJournal::~LoopJournal()
+{
+	// Leaves the files, as after a crash. Loops may already be gone.
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_isStopping = true;
+	}
+
+	_wake.notify_all();
+
+	if (_thread.joinable())
+		_thread.join();
+}
+
+LoopJournal& LoopJournal::Instance()
+{
+	static LoopJournal journal;
+	return journal;
+}
+
+bool LoopJournal::Start(const std::wstring& dir)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	if (_isRunning)
+		return dir == _dir;
+
+	std::error_code error;
+	std::filesystem::create_directories(dir, error);
+	if (error)
+		return false;
+
+	// Never write over a journal nobody has recovered
+	if (std::filesystem::exists(std::filesystem::path(dir) / JamFileName, error))
+		return false;
+
+	_dir = dir;
+	_isRunning = true;
+	_thread = std::thread([this]() { _Run(); });
+
+	return true;
+}
+
+void LoopJournal::Stop(bool keepFiles)
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (!_isRunning || _isStopping)
+			return;
+
+		_isStopping = true;
+	}
+
+	_wake.notify_all();
+
+	if (_thread.joinable())
+		_thread.join();
+
+	// Whatever came in since the last pass
+	Pump();
+
+	std::vector<std::shared_ptr<Entry>> entries;
+	std::wstring dir;
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		entries.swap(_entries);
+		dir.swap(_dir);
+		_isRunning = false;
+		_isStopping = false;
+	}
+
+	for (auto& entry : entries)
+	{
+		entry->Writer.Close();
+
+		auto loop = entry->WeakLoop.lock();
+		if (loop)
+			loop->SetJournalled(false);
+	}
+
+	if (!keepFiles)
+	{
+		std::error_code error;
+		std::filesystem::remove_all(dir, error);
+	}
+}
+
+bool LoopJournal::IsRunning() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _isRunning && !_isStopping;
+}
+
+void LoopJournal::Add(std::shared_ptr<Loop> loop,
+	const std::string& stationName,
+	const std::string& takeId)
+{
+	if (!loop)
+		return;
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	if (!_isRunning || _isStopping)
+		return;
+
+	auto entry = std::make_shared<Entry>();
+	entry->WeakLoop = loop;
+	entry->StationName = stationName;
+	entry->TakeId = takeId;
+	entry->WavName = loop->Id() + ".wav";
+
+	// Mix settings are taken now, from the thread that changes them. Only
+	// the length changes from here on.
+	entry->Jam = loop->ToJamFile(entry->WavName);
+	entry->Jam.Length = 0ul;
+	entry->Jam.Index = 0ul;
+
+	loop->SetJournalled(true);
+	_entries.push_back(std::move(entry));
+}
+
+LoopJournal::Stats LoopJournal::Pump()
+{
+	std::lock_guard<std::mutex> pumpLock(_pumpMutex);
+
+	std::vector<std::shared_ptr<Entry>> entries;
+	std::wstring dir;
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		entries = _entries;
+		dir = _dir;
+	}
+
+	Stats stats;
+	std::vector<std::shared_ptr<Entry>> liveEntries;
+	std::vector<std::shared_ptr<Entry>> deadEntries;
+	auto isJamChanged = false;
+
+	for (auto& entry : entries)
+	{
+		auto loop = entry->WeakLoop.lock();
+
+		// Undo can keep a ditched loop alive, but it is no longer part of
+		// the session
+		if (!loop || (Loop::STATE_INACTIVE == loop->PlayState()))
+		{
+			entry->Writer.Close();
+			if (loop)
+				loop->SetJournalled(false);
+
+			std::error_code error;
+			std::filesystem::remove(std::filesystem::path(dir) / utils::DecodeUtf8(entry->WavName), error);
+
+			deadEntries.push_back(entry);
+			isJamChanged = isJamChanged || (entry->Jam.Length > 0ul);
+			continue;
+		}
+
+		liveEntries.push_back(entry);
+
+		if (entry->IsClosed)
+			continue;
+
+		if (!entry->Writer.IsOpen() && !entry->IsFailed)
+		{
+			io::WavFormat format;
+			format.SampleFormat = io::WavSampleFormat::Float32;
+			format.SampleRate = static_cast<unsigned int>(loop->GetSampleRate());
+
+			auto path = std::filesystem::path(dir) / utils::DecodeUtf8(entry->WavName);
+			if (!entry->Writer.Open(path.wstring(), format))
+			{
+				entry->IsFailed = true;
+				loop->SetJournalled(false);
+				std::cout << "[Journal] Could not open " << path.string() << std::endl;
+			}
+		}
+
+		if (entry->IsFailed)
+			stats.NumFailed++;
+		else
+			isJamChanged = _PumpEntry(*entry, *loop, stats) || isJamChanged;
+
+		if (!entry->IsClosed && !entry->IsFailed)
+			stats.NumOpen++;
+	}
+
+	stats.NumLoops = static_cast<unsigned int>(liveEntries.size());
+
+	// The samples are flushed first, so the jam never names audio that is
+	// not on disk yet
+	if (isJamChanged && !dir.empty())
+		_WriteJamFile(dir, liveEntries);
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		_entries.erase(std::remove_if(_entries.begin(), _entries.end(),
+			[&deadEntries](const std::shared_ptr<Entry>& entry) {
+				return deadEntries.end() != std::find(deadEntries.begin(), deadEntries.end(), entry);
+			}),
+			_entries.end());
+
+		_stats.NumLoops = stats.NumLoops;
+		_stats.NumOpen = stats.NumOpen;
+		_stats.SampsWritten += stats.SampsWritten;
+		_stats.NumOverflows += stats.NumOverflows;
+		_stats.NumFailed = stats.NumFailed;
+	}
+
+	return stats;
+}
+
+LoopJournal::Stats LoopJournal::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _stats;
+}
+
+unsigned int LoopJournal::Recover(const std::wstring& journalDir,
+	const std::wstring& sessionDir)
+{
+	const std::filesystem::path journalPath(journalDir);
+	std::error_code error;
+
+	if (!std::filesystem::exists(journalPath, error))
+		return 0u;
+
+	// Without a jam nothing got far enough to keep
+	if (!std::filesystem::exists(journalPath / JamFileName, error))
+	{
+		std::filesystem::remove_all(journalPath, error);
+		return 0u;
+	}
+
+	std::stringstream ss;
+	{
+		std::ifstream file(journalPath / JamFileName, std::ios::binary);
+		ss << file.rdbuf();
+	}
+
+	auto jam = io::JamFile::FromStream(std::move(ss));
+	auto numLoops = 0u;
+
+	if (jam.has_value())
+	{
+		for (const auto& station : jam->Stations)
+		{
+			for (const auto& take : station.LoopTakes)
+				numLoops += static_cast<unsigned int>(take.Loops.size());
+		}
+	}
+
+	std::filesystem::rename(journalPath, sessionDir, error);
+
+	return error ? 0u : numLoops;
+}
+
+bool LoopJournal::_PumpEntry(Entry& entry, Loop& loop, Stats& stats)
+{
+	using Range = Loop::JournalRing::Range;
+
+	// Taken before the ring is emptied, so a loop seen to have stopped has
+	// nothing more coming
+	const auto isWriting = loop.IsBeingWritten();
+
+	Range range;
+	while (loop.TakeJournalRange(range))
+		entry.Pending.push_back(range);
+
+	if (loop.TakeJournalOverflow())
+	{
+		entry.IsOverflowed = true;
+		stats.NumOverflows++;
+	}
+
+	const auto storedLength = loop.StoredLength();
+
+	if (entry.IsOverflowed)
+	{
+		entry.Pending.push_back({ 0ul, storedLength });
+		entry.IsOverflowed = false;
+	}
+
+	// Blocks arrive a callback at a time, so most spans join up into a few
+	// long runs
+	std::sort(entry.Pending.begin(), entry.Pending.end(),
+		[](const Range& a, const Range& b) { return a.Start < b.Start; });
+
+	std::vector<Range> runs;
+	for (const auto& pending : entry.Pending)
+	{
+		if (0ul == pending.NumSamps)
+			continue;
+
+		if (!runs.empty() && (pending.Start <= runs.back().Start + runs.back().NumSamps))
+		{
+			auto end = std::max(runs.back().Start + runs.back().NumSamps, pending.Start + pending.NumSamps);
+			runs.back().NumSamps = end - runs.back().Start;
+		}
+		else
+			runs.push_back(pending);
+	}
+
+	entry.Pending.clear();
+	auto isWritten = false;
+
+	for (const auto& run : runs)
+	{
+		const auto end = run.Start + run.NumSamps;
+		const auto writeEnd = std::min(end, storedLength);
+		auto index = run.Start;
+
+		while (index < writeEnd)
+		{
+			auto numSamps = static_cast<unsigned int>(std::min(writeEnd - index, static_cast<unsigned long>(CopyBlockSamps)));
+			loop.ReadStored(index, _copyBuffer.data(), numSamps);
+
+			if (!entry.Writer.WriteAt(index, _copyBuffer.data(), numSamps))
+			{
+				entry.IsFailed = true;
+				stats.NumFailed++;
+				loop.SetJournalled(false);
+				std::cout << "[Journal] Could not write " << entry.WavName << std::endl;
+
+				return false;
+			}
+
+			index += numSamps;
+			stats.SampsWritten += numSamps;
+			isWritten = true;
+		}
+
+		// Written by the audio thread before it stored the new length
+		if (end > index)
+			entry.Pending.push_back({ index, end - index });
+	}
+
+	// Still recording, so the length is as far as it has got
+	auto length = loop.LoopLength();
+	if (0ul == length)
+		length = (storedLength > constants::MaxLoopFadeSamps) ? storedLength - constants::MaxLoopFadeSamps : 0ul;
+
+	if (!isWriting && entry.Pending.empty())
+	{
+		// Done with, so its file handle and the audio thread's queueing
+		// are not held for the rest of the set
+		entry.IsClosed = true;
+		loop.SetJournalled(false);
+
+		if (!entry.Writer.Close())
+		{
+			entry.IsFailed = true;
+			stats.NumFailed++;
+			std::cout << "[Journal] Could not finish " << entry.WavName << std::endl;
+		}
+	}
+	else if (isWritten)
+		entry.Writer.Flush();
+
+	if (length == entry.Jam.Length)
+		return false;
+
+	entry.Jam.Length = length;
+	return true;
+}
+
+bool LoopJournal::_WriteJamFile(const std::wstring& dir,
+	const std::vector<std::shared_ptr<Entry>>& entries) const
+{
+	io::JamFile jam;
+	jam.Version = io::JamFile::VERSION_V;
+	jam.Name = "journal";
+	jam.TimerTicks = 0;
+	jam.QuantiseSamps = 0;
+	jam.Quantisation = utils::Timer::QUANTISE_OFF;
+
+	for (const auto& entry : entries)
+	{
+		if (entry->IsFailed || (0ul == entry->Jam.Length))
+			continue;
+
+		auto station = std::find_if(jam.Stations.begin(), jam.Stations.end(),
+			[&entry](const io::JamFile::Station& s) { return s.Name == entry->StationName; });
+
+		if (jam.Stations.end() == station)
+		{
+			io::JamFile::Station jamStation;
+			jamStation.Name = entry->StationName;
+			jamStation.StationType = 0;
+			station = jam.Stations.insert(jam.Stations.end(), jamStation);
+		}
+
+		auto take = std::find_if(station->LoopTakes.begin(), station->LoopTakes.end(),
+			[&entry](const io::JamFile::LoopTake& t) { return t.Name == entry->TakeId; });
+
+		if (station->LoopTakes.end() == take)
+		{
+			io::JamFile::LoopTake jamTake;
+			jamTake.Name = entry->TakeId;
+			take = station->LoopTakes.insert(station->LoopTakes.end(), jamTake);
+		}
+
+		take->Loops.push_back(entry->Jam);
+	}
+
+	std::stringstream ss;
+	io::JamFile::ToStream(jam, ss);
+
+	auto path = std::filesystem::path(dir) / JamFileName;
+	return io::SessionWriter::CommitTextFile(path.wstring(), ss.str());
+}
+
+void LoopJournal::_Run()
+{
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			if (_wake.wait_for(lock, std::chrono::milliseconds(constants::JournalFlushMs), [this]() { return _isStopping; }))
+				return;
+		}
+
+		Pump();
+	}
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Loop.h"
+#include "../io/WavFile.h"
+
+namespace engine
+{
+	// Process-wide write-behind journal that keeps recorded audio on disk
+	// while it is still being recorded, so a crash loses at most the last
+	// flush.
+	//
+	// Each journalled loop queues the spans the audio thread writes into
+	// its buffer (see Loop::SetJournalled()). A background thread wakes
+	// every JournalFlushMs, takes the spans, merges them and copies them out
+	// of the loop into a float WAV of the whole buffer, pre-roll included.
+	// Alongside sits a session.jam naming every journalled loop, so the
+	// journal directory opens as a session in its own right. Only this
+	// thread touches the files; the audio thread never does.
+	//
+	// Spans past the loop's stored length are kept back until the length
+	// catches up. Once a loop only plays, its file is finished and closed,
+	// leaving just its entry in the jam. Loops are held weakly, and one that
+	// goes away or is ditched has its file removed. Stop() removes the whole
+	// journal, so anything found by the next Start() was left by a run that
+	// never finished.
+	class LoopJournal
+	{
+	public:
+		static constexpr const wchar_t* JamFileName = L"session.jam";
+
+		struct Stats
+		{
+			// Loops in the jam, and those still being written
+			unsigned int NumLoops = 0u;
+			unsigned int NumOpen = 0u;
+			std::uint64_t SampsWritten = 0u;
+			unsigned int NumOverflows = 0u;
+			unsigned int NumFailed = 0u;
+		};
+
+	public:
+		LoopJournal(const LoopJournal&) = delete;
+		LoopJournal& operator=(const LoopJournal&) = delete;
+		~LoopJournal();
+
+		static LoopJournal& Instance();
+
+		// Journals into dir from now on. Returns false, leaving journalling
+		// off, if the directory cannot be made.
+		bool Start(const std::wstring& dir);
+		// Stops the thread and removes the journal unless keepFiles.
+		void Stop(bool keepFiles);
+		bool IsRunning() const;
+
+		// Starts journalling a loop that is being recorded or overdubbed.
+		// Not for the audio thread. Does nothing until Start().
+		void Add(std::shared_ptr<Loop> loop,
+			const std::string& stationName,
+			const std::string& takeId);
+		// Runs one pass over every journalled loop. The thread calls this;
+		// tests may too.
+		Stats Pump();
+		Stats GetStats() const;
+
+		// Moves a journal left behind in journalDir to sessionDir, ready to
+		// open as a session. Returns how many loops it held.
+		static unsigned int Recover(const std::wstring& journalDir,
+			const std::wstring& sessionDir);
+
+	protected:
+		static constexpr unsigned int CopyBlockSamps = 65536u;
+
+		struct Entry
+		{
+			std::weak_ptr<Loop> WeakLoop;
+			std::string StationName;
+			std::string TakeId;
+			std::string WavName;
+			io::WavFileWriter Writer;
+			// Spans taken off the ring but not yet written
+			std::vector<Loop::JournalRing::Range> Pending;
+			io::JamFile::Loop Jam;
+			// Copies the whole buffer next pass. Starts set, as the loop may
+			// have been written before it was journalled.
+			bool IsOverflowed = true;
+			// Finished, with only the jam entry left to keep
+			bool IsClosed = false;
+			bool IsFailed = false;
+		};
+
+	protected:
+		LoopJournal();
+
+		// True if the session.jam needs writing again
+		bool _PumpEntry(Entry& entry, Loop& loop, Stats& stats);
+		bool _WriteJamFile(const std::wstring& dir,
+			const std::vector<std::shared_ptr<Entry>>& entries) const;
+		void _Run();
+
+	protected:
+		mutable std::mutex _mutex;
+		std::condition_variable _wake;
+		bool _isRunning;
+		bool _isStopping;
+		std::thread _thread;
+		std::wstring _dir;
+		std::vector<std::shared_ptr<Entry>> _entries;
+		// Held for a whole pass, so Pump() never runs twice at once
+		std::mutex _pumpMutex;
+		std::vector<float> _copyBuffer;
+		Stats _stats;
+	};
+}
@@ -0,0 +1,59 @@
+#include "LoopLoader.h"
+
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include "../utils/BatchUtils.h"
+
+using namespace engine;
+
+LoopLoader::LoopLoader() :
+	_tasks()
+{
+}
+
+void LoopLoader::Add(LoadTask task)
+{
+	if (task)
+		_tasks.push_back(std::move(task));
+}
+
+LoopLoader::Stats LoopLoader::Run(unsigned int numWorkers)
+{
+	auto startTime = std::chrono::steady_clock::now();
+
+	std::atomic<unsigned int> numFailed(0u);
+	std::atomic<std::uint64_t> bytesLoaded(0u);
+
+	Stats stats;
+	stats.NumLoops = static_cast<unsigned int>(_tasks.size());
+	stats.NumWorkers = utils::RunBatch(_tasks.size(), numWorkers, [&](std::size_t index) {
+		auto numBytes = _tasks[index]();
+
+		if (numBytes > 0u)
+			bytesLoaded.fetch_add(numBytes, std::memory_order_relaxed);
+		else
+			numFailed.fetch_add(1u, std::memory_order_relaxed);
+	});
+
+	_tasks.clear();
+
+	stats.NumFailed = numFailed.load(std::memory_order_relaxed);
+	stats.BytesLoaded = bytesLoaded.load(std::memory_order_relaxed);
+	stats.ElapsedSecs = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	return stats;
+}
+
+std::string LoopLoader::FormatStats(const Stats& stats)
+{
+	std::stringstream ss;
+	ss << stats.NumLoops << " loop(s)";
+	if (stats.NumFailed > 0u)
+		ss << ", " << stats.NumFailed << " failed";
+
+	ss << ", " << utils::FormatThroughput(stats.BytesLoaded, stats.ElapsedSecs)
+		<< " on " << stats.NumWorkers << " thread(s)";
+
+	return ss.str();
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace engine
+{
+	// Loads the audio of a session's loops on a few threads at once.
+	//
+	// Opening a session builds every loop first, each adding a task that
+	// fills its buffer from disk. Run() spreads the tasks over the workers,
+	// with the calling thread working too, and returns once all are done.
+	// Tasks must not depend on each other, and the loops they fill must not
+	// be reachable from audio or the job thread until Run() returns.
+	class LoopLoader
+	{
+	public:
+		// Returns the bytes of audio loaded, or zero when the load failed.
+		using LoadTask = std::function<std::size_t()>;
+
+		struct Stats
+		{
+			unsigned int NumLoops = 0u;
+			unsigned int NumFailed = 0u;
+			unsigned int NumWorkers = 0u;
+			std::uint64_t BytesLoaded = 0u;
+			double ElapsedSecs = 0.0;
+		};
+
+	public:
+		LoopLoader();
+
+		LoopLoader(const LoopLoader&) = delete;
+		LoopLoader& operator=(const LoopLoader&) = delete;
+
+		void Add(LoadTask task);
+		std::size_t NumPending() const noexcept { return _tasks.size(); }
+
+		// Runs and clears every task added so far. Never uses more workers
+		// than there are tasks.
+		Stats Run(unsigned int numWorkers);
+		static std::string FormatStats(const Stats& stats);
+
+	protected:
+		std::vector<LoadTask> _tasks;
+	};
+}
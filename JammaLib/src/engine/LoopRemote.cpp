@@ -108,6 +108,17 @@ void LoopRemote::IngestSamples(const float* samples, unsigned int numSamps)
 		_monitorBufferBank[writeIndex] = samples[samp];
 	}
 
+	// The ring may have wrapped within this block
+	auto sampsToWrap = std::min<unsigned long>(numSamps, len - pos);
+	_bufferBank.UpdateSummary(baseIndex + pos, sampsToWrap);
+	_monitorBufferBank.UpdateSummary(baseIndex + pos, sampsToWrap);
+	if (sampsToWrap < numSamps)
+	{
+		auto sampsWrapped = std::min<unsigned long>(numSamps - sampsToWrap, len);
+		_bufferBank.UpdateSummary(baseIndex, sampsWrapped);
+		_monitorBufferBank.UpdateSummary(baseIndex, sampsWrapped);
+	}
+
 	pos = (pos + numSamps) % len;
 	_measurePositionSamps.store(pos);
 
@@ -33,6 +33,8 @@ namespace engine
 	protected:
 		virtual unsigned long _ModelDisplayLength(bool isRecording, unsigned long actualLoopLength) const override;
 		virtual double _DrawRadiusScale() const noexcept override { return 0.5; }
+		// Ingested samples are written in place, which packed banks can't take
+		virtual bool _CanCompact() const noexcept override { return false; }
 
 		std::atomic<bool> _modelDirty;
 		std::atomic<unsigned int> _measureLengthSamps;
@@ -4,9 +4,12 @@
 #include <cstdint>
 #include <limits>
 
+#include "LoopJournal.h"
+#include "Station.h"
 #include "../graphics/MidiModel.h"
 #include "../midi/MidiNote.h"
 #include "../midi/MidiIndexedOutputSink.h"
+#include "../audio/CallbackProfiler.h"
 
 namespace
 {
@@ -201,7 +204,7 @@ LoopTake::LoopTake(LoopTakeParams params,
 	_backAudioMixers(),
 	_audioBuffers(),
 	_backAudioBuffers(),
-	_vstChain(nullptr),
+	_vstChain(),
 	_vstPluginPaths(),
 	_vstBlockScratch(),
 	_vstBlockPtrs()
@@ -217,11 +220,14 @@ LoopTake::LoopTake(LoopTakeParams params,
 
 LoopTake::~LoopTake()
 {
-	DrainVstChain(_vstChain.load(std::memory_order_acquire));
+	DrainVstChain(_vstChain.LoadShared());
 	DrainVstChain(_backVstChain);
 }
 
-std::optional<std::shared_ptr<LoopTake>> LoopTake::FromFile(LoopTakeParams takeParams, io::JamFile::LoopTake takeStruct, std::wstring dir)
+std::optional<std::shared_ptr<LoopTake>> LoopTake::FromFile(LoopTakeParams takeParams,
+	io::JamFile::LoopTake takeStruct,
+	std::wstring dir,
+	LoopLoader& loader)
 {
 	auto mixerParams = GetMixerParams({ 100,100 }, audio::WireMixBehaviourParams());
 	auto take = std::make_shared<LoopTake>(takeParams, mixerParams);
@@ -234,7 +240,7 @@ std::optional<std::shared_ptr<LoopTake>> LoopTake::FromFile(LoopTakeParams takeP
 
 	for (auto loopStruct : takeStruct.Loops)
 	{
-		auto loop = Loop::FromFile(loopParams, loopStruct, dir);
+		auto loop = Loop::FromFile(loopParams, loopStruct, dir, loader);
 		
 		if (loop.has_value())
 		{
@@ -368,6 +374,8 @@ void LoopTake::WriteBlock(const std::shared_ptr<MultiAudioSink> dest,
 	int indexOffset,
 	unsigned int numSamps)
 {
+	JAMMA_PROFILE_SCOPE(STAGE_TAKE);
+
 	if (nullptr == dest)
 		return;
 	
@@ -391,12 +399,12 @@ void LoopTake::WriteBlock(const std::shared_ptr<MultiAudioSink> dest,
 
 	auto sampsToRead = (numSamps <= constants::MaxBlockSize) ? numSamps : constants::MaxBlockSize;
 	auto masterLevel = static_cast<float>(_masterMixer->Level());
+	auto masterRamp = _masterMixer->FadeRamp(sampsToRead);
 	auto masterPeak = 0.0f;
 	const auto channelCount = (state->AudioBuffers.size() < state->AudioMixers.size()) ? state->AudioBuffers.size() : state->AudioMixers.size();
 	if (channelCount == 0u)
 	{
 		_masterMixer->UpdateVu(0.0f, sampsToRead);
-		_masterMixer->Offset(sampsToRead);
 		return;
 	}
 
@@ -416,7 +424,7 @@ void LoopTake::WriteBlock(const std::shared_ptr<MultiAudioSink> dest,
 			std::copy(srcPtr, srcPtr + sampsToRead, scratch);
 	}
 
-	auto chain = _vstChain.load(std::memory_order_acquire);
+	auto chain = _vstChain.Load();
 	if (chain && chain->IsActive() && (state->VstBlockPtrs.size() >= channelCount))
 		chain->ProcessBlockMulti(state->VstBlockPtrs.data(), static_cast<int>(channelCount), sampsToRead);
 
@@ -429,7 +437,7 @@ void LoopTake::WriteBlock(const std::shared_ptr<MultiAudioSink> dest,
 		// Track max peak across all channels for the master VU.
 		for (auto samp = 0u; samp < sampsToRead; samp++)
 		{
-			scratch[samp] *= masterLevel;
+			scratch[samp] *= (nullptr != masterRamp) ? masterRamp[samp] : masterLevel;
 			auto absSamp = std::abs(scratch[samp]);
 			if (absSamp > masterPeak)
 				masterPeak = absSamp;
@@ -439,7 +447,6 @@ void LoopTake::WriteBlock(const std::shared_ptr<MultiAudioSink> dest,
 	}
 
 	_masterMixer->UpdateVu(masterPeak, sampsToRead);
-	_masterMixer->Offset(sampsToRead);
 }
 
 void LoopTake::EndMultiPlay(unsigned int numSamps)
@@ -653,7 +660,7 @@ ActionResult LoopTake::OnAction(JobAction action)
 		// Take a snapshot of the current live chain under _vstChainMutex so we
 		// don't race with _CommitChanges() swapping it on the main thread.
 		std::shared_ptr<vst::VstChain> chainSnapshot;
-		chainSnapshot = _vstChain.load(std::memory_order_acquire);
+		chainSnapshot = _vstChain.LoadShared();
 
 		auto newChain = std::make_shared<vst::VstChain>();
 		if (chainSnapshot)
@@ -703,7 +710,7 @@ ActionResult LoopTake::OnAction(JobAction action)
 	{
 		// Take a snapshot of the current live chain under _vstChainMutex.
 		std::shared_ptr<vst::VstChain> chainSnapshot;
-		chainSnapshot = _vstChain.load(std::memory_order_acquire);
+		chainSnapshot = _vstChain.LoadShared();
 
 		auto newChain = std::make_shared<vst::VstChain>();
 		const auto removeIndex = action.VstIndex;
@@ -811,6 +818,18 @@ unsigned long LoopTake::NumRecordedSamps() const
 	return _recordedSampCount.load(std::memory_order_relaxed);
 }
 
+std::size_t LoopTake::BufferBytes() const
+{
+	std::size_t bytes = 0;
+	for (const auto& loop : _loops)
+	{
+		if (loop)
+			bytes += loop->BufferBytes();
+	}
+
+	return bytes;
+}
+
 unsigned long LoopTake::VisualLoopLengthSamps() const noexcept
 {
 	auto length = 0ul;
@@ -1258,7 +1277,8 @@ std::uint32_t LoopTake::ResolveMidiRecordSample(std::uint32_t eventGlobalSample,
 void LoopTake::Play(unsigned long index,
 	unsigned long loopLength,
 	unsigned int endRecordSamps,
-	int midiQuantisationErrorSamps)
+	int midiQuantisationErrorSamps,
+	unsigned int blockOffset)
 {
 	auto state = _state.load(std::memory_order_relaxed);
 	if ((STATE_RECORDING != state) &&
@@ -1266,8 +1286,10 @@ void LoopTake::Play(unsigned long index,
 		(STATE_PUNCHEDIN != state))
 		return;
 
+	// The first block is counted in full, including the samples before
+	// the change lands
 	_endRecordSampCount = 0;
-	_endRecordSamps = endRecordSamps;
+	_endRecordSamps = endRecordSamps + blockOffset;
 	_midiVisualLoopLength = loopLength;
 
 	_midiVisualPlayIndex = InitialMidiPlayIndex(loopLength, midiQuantisationErrorSamps);
@@ -1288,7 +1310,7 @@ void LoopTake::Play(unsigned long index,
 
 	for (auto& loop : _loops)
 	{
-		loop->Play(index, loopLength, continueCapture);
+		loop->Play(index, loopLength, continueCapture, blockOffset);
 	}
 
 	const auto midiLoopLength = static_cast<std::uint32_t>(loopLength);
@@ -1580,7 +1602,9 @@ void LoopTake::Overdub(std::vector<unsigned int> channels,
 	_changesMade = true;
 }
 
-void LoopTake::PunchIn(bool applyAudio, bool applyMidi)
+void LoopTake::PunchIn(bool applyAudio,
+	bool applyMidi,
+	unsigned int blockOffset)
 {
 	auto state = _state.load(std::memory_order_relaxed);
 	const auto canPunchAudio = (STATE_OVERDUBBING == state) ||
@@ -1593,7 +1617,7 @@ void LoopTake::PunchIn(bool applyAudio, bool applyMidi)
 	if (applyMidi && canPunchMidi && !_isMidiPunchInActive.load(std::memory_order_relaxed))
 	{
 		_isMidiPunchInActive.store(true, std::memory_order_release);
-		const auto punchSample = static_cast<std::uint32_t>(_recordedSampCount.load(std::memory_order_relaxed));
+		const auto punchSample = static_cast<std::uint32_t>(_recordedSampCount.load(std::memory_order_relaxed) + blockOffset);
 		_OpenMidiPunchWindow(punchSample);
 	}
 
@@ -1606,11 +1630,13 @@ void LoopTake::PunchIn(bool applyAudio, bool applyMidi)
 
 	for (auto& loop : _loops)
 	{
-		loop->PunchIn();
+		loop->PunchIn(blockOffset);
 	}
 }
 
-void LoopTake::PunchOut(bool applyAudio, bool applyMidi)
+void LoopTake::PunchOut(bool applyAudio,
+	bool applyMidi,
+	unsigned int blockOffset)
 {
 	auto state = _state.load(std::memory_order_relaxed);
 	const auto hasAudioPunch = _isPunchInActive.load(std::memory_order_relaxed) || (STATE_PUNCHEDIN == state);
@@ -1623,7 +1649,7 @@ void LoopTake::PunchOut(bool applyAudio, bool applyMidi)
 		_isMidiPunchInActive.store(false, std::memory_order_release);
 		if (_midiOverdubSession.Active)
 		{
-		const auto punchSample = static_cast<std::uint32_t>(_recordedSampCount.load(std::memory_order_relaxed));
+		const auto punchSample = static_cast<std::uint32_t>(_recordedSampCount.load(std::memory_order_relaxed) + blockOffset);
 		_CloseMidiPunchWindow(punchSample, true);
 		}
 	}
@@ -1637,7 +1663,7 @@ void LoopTake::PunchOut(bool applyAudio, bool applyMidi)
 
 	for (auto& loop : _loops)
 	{
-		loop->PunchOut();
+		loop->PunchOut(blockOffset);
 	}
 
 	auto nextState = _state.load(std::memory_order_relaxed);
@@ -1727,6 +1753,14 @@ std::vector<JobAction> LoopTake::_CommitChanges()
 			loop->SetParent(GuiElement::shared_from_this());
 			loop->Init();
 			_children.push_back(loop);
+
+			// Record() may have run on the audio thread, so new loops join
+			// the journal from here instead
+			if (loop->IsBeingWritten())
+			{
+				auto station = std::dynamic_pointer_cast<Station>(_parent);
+				LoopJournal::Instance().Add(loop, station ? station->Name() : "", _id);
+			}
 		}
 
 		for (auto& loop : toRemove)
@@ -1755,7 +1789,7 @@ std::vector<JobAction> LoopTake::_CommitChanges()
 	// Swap in the VST chain when the job thread has delivered a new one.
 	if (_flipVstChain.exchange(false, std::memory_order_acquire))
 	{
-		_vstChain.store(_backVstChain, std::memory_order_release);
+		_vstChain.Publish(_backVstChain);
 	}
 
 	std::vector<JobAction> jobs;
@@ -1858,9 +1892,9 @@ const std::shared_ptr<AudioSink> LoopTake::_InputChannel(unsigned int channel,
 	return nullptr;
 }
 
-std::shared_ptr<const LoopTake::AudioState> LoopTake::_AudioStateSnapshot() const
+const LoopTake::AudioState* LoopTake::_AudioStateSnapshot() const noexcept
 {
-	return _audioState.load(std::memory_order_acquire);
+	return _audioState.Load();
 }
 
 void LoopTake::_PublishAudioState()
@@ -1875,7 +1909,7 @@ void LoopTake::_PublishAudioState()
 	state->VstBlockPtrs.resize(state->AudioBuffers.size(), nullptr);
 	for (auto i = 0u; i < state->AudioBuffers.size(); i++)
 		state->VstBlockPtrs[i] = state->VstBlockScratch.data() + (static_cast<size_t>(i) * constants::MaxBlockSize);
-	_audioState.store(state, std::memory_order_release);
+	_audioState.Publish(state);
 }
 
 void LoopTake::_ArrangeChildren()
@@ -2669,7 +2703,7 @@ void LoopTake::UnloadVstPlugin(size_t index)
 
 std::shared_ptr<vst::IVstPlugin> LoopTake::GetVstPlugin(size_t index) const
 {
-	auto chain = _vstChain.load(std::memory_order_acquire);
+	auto chain = _vstChain.LoadShared();
 	if (!chain)
 		return nullptr;
 
@@ -2680,7 +2714,7 @@ std::vector<io::JamFile::VstEntry> LoopTake::VstEntries() const
 {
 	std::vector<io::JamFile::VstEntry> entries;
 
-	auto chain = _vstChain.load(std::memory_order_acquire);
+	auto chain = _vstChain.LoadShared();
 	std::lock_guard<std::mutex> lock(_vstPathsMutex);
 	entries.reserve(_vstPluginPaths.size());
 
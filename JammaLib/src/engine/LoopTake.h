@@ -17,6 +17,7 @@
 #include "../audio/AudioBuffer.h"
 #include "../gui/GuiRack.h"
 #include "../vst/VstChain.h"
+#include "../utils/Epoch.h"
 
 using base::Audible;
 
@@ -92,7 +93,8 @@ namespace engine
 	public:
 		static std::optional<std::shared_ptr<LoopTake>> FromFile(LoopTakeParams takeParams,
 			io::JamFile::LoopTake takeStruct,
-			std::wstring dir);
+			std::wstring dir,
+			LoopLoader& loader);
 		static audio::AudioMixerParams GetMixerParams(utils::Size2d loopSize,
 			audio::BehaviourParams behaviour);
 
@@ -132,6 +134,7 @@ namespace engine
 		const std::vector<std::shared_ptr<Loop>>& GetLoops() const { return _loops; }
 		LoopTakeState TakeState() const;
 		unsigned long NumRecordedSamps() const;
+		std::size_t BufferBytes() const;
 		unsigned long VisualLoopLengthSamps() const noexcept;
 		double LoopIndexFrac() const noexcept;
 		float VisualRadius() const noexcept;
@@ -161,7 +164,7 @@ namespace engine
 		// an editor-driven automation event.
 		bool OwnsPlugin(const vst::IVstPlugin* plugin) const noexcept
 		{
-			auto chain = _vstChain.load(std::memory_order_acquire);
+			auto chain = _vstChain.LoadShared();
 			return chain && chain->ContainsPlugin(plugin);
 		}
 
@@ -173,10 +176,13 @@ namespace engine
 			// Empty device name means "device-agnostic / any source".
 			std::vector<std::pair<std::string, midi::MidiNoteSnapshot>> heldAtStart = {},
 			std::uint64_t transportStartSamps = 0u);
+		// blockOffset lands the change that many samples into the next
+		// block, see Loop::Play()
 		void Play(unsigned long index,
 			unsigned long loopLength,
 			unsigned int endRecordSamps,
-			int midiQuantisationErrorSamps = 0);
+			int midiQuantisationErrorSamps = 0,
+			unsigned int blockOffset = 0u);
 		void EndRecording();
 		void Ditch();
 		void Overdub(std::vector<unsigned int> channels,
@@ -185,8 +191,12 @@ namespace engine
 			std::vector<std::string> midiDevices = {},
 			std::shared_ptr<LoopTake> sourceTake = nullptr,
 			std::uint64_t transportStartSamps = 0u);
-		void PunchIn(bool applyAudio = true, bool applyMidi = true);
-		void PunchOut(bool applyAudio = true, bool applyMidi = true);
+		void PunchIn(bool applyAudio = true,
+			bool applyMidi = true,
+			unsigned int blockOffset = 0u);
+		void PunchOut(bool applyAudio = true,
+			bool applyMidi = true,
+			unsigned int blockOffset = 0u);
 		bool IsPunchInActive() const noexcept { return _isPunchInActive.load(std::memory_order_relaxed); }
 
 		bool RecordMidiEvent(const midi::MidiEvent& ev, std::uint32_t globalSampleNow) noexcept;
@@ -249,7 +259,7 @@ namespace engine
 		void _RemoveMidiModelChildren();
 		void _WireVuSliders();
 		void _PublishAudioState();
-		std::shared_ptr<const AudioState> _AudioStateSnapshot() const;
+		const AudioState* _AudioStateSnapshot() const noexcept;
 		void _ResizeVstScratch(unsigned int channelCount);
 		void _LogMidiQuantisationFractionChange(midi::MidiQuantisationFraction previous,
 			midi::MidiQuantisationFraction updated,
@@ -322,9 +332,9 @@ namespace engine
 		std::vector<std::shared_ptr<audio::AudioMixer>> _backAudioMixers;
 		std::vector<std::shared_ptr<audio::AudioBuffer>> _audioBuffers;
 		std::vector<std::shared_ptr<audio::AudioBuffer>> _backAudioBuffers;
-		std::atomic<std::shared_ptr<const AudioState>> _audioState;
+		utils::EpochPtr<const AudioState> _audioState;
 		// Live VST chain published atomically for lock-free audio-thread reads.
-		std::atomic<std::shared_ptr<vst::VstChain>> _vstChain;
+		utils::EpochPtr<vst::VstChain> _vstChain;
 		std::shared_ptr<vst::VstChain> _backVstChain;
 		std::atomic<bool> _flipVstChain{ false };
 		std::vector<std::pair<std::wstring, std::vector<std::uint8_t>>> _pendingVstLoads;
@@ -1,9 +1,15 @@
 #include "Scene.h"
+#include <chrono>
 #include <iostream>
 #include "glm/ext.hpp"
 #include "../utils/PathUtils.h"
+#include "../utils/StringUtils.h"
+#include "../utils/Epoch.h"
+#include "../audio/CallbackProfiler.h"
+#include "../audio/LoadMonitor.h"
 #include "../midi/MidiTimestampMapper.h"
 #include "../io/IoSessionExporter.h"
+#include "LoopJournal.h"
 #include "../vst/Vst3Plugin.h"
 
 using namespace base;
@@ -134,7 +140,9 @@ Scene::Scene(SceneParams params,
 
 	_PublishAudioStations();
 
+	_jobWorkers.Start(constants::NumJobWorkers);
 	_jobRunner = std::thread([this]() { this->_JobLoop(); });
+	_midiRunner = std::thread([this]() { this->_MidiLoop(); });
 }
 
 std::optional<std::shared_ptr<Scene>> Scene::FromFile(SceneParams sceneParams,
@@ -142,7 +150,27 @@ std::optional<std::shared_ptr<Scene>> Scene::FromFile(SceneParams sceneParams,
 	io::RigFile rigStruct,
 	std::wstring dir)
 {
+	// Before any loops exist, so the slab size can still change
+	audio::BankPool::Instance().Configure(rigStruct.User.Loop.BankSlabSamps,
+		static_cast<std::size_t>(rigStruct.User.Loop.BankBudgetMb) << 20);
+	audio::StreamPrefetcher::Instance().Configure(rigStruct.User.Loop.StreamThresholdSamps,
+		rigStruct.User.Loop.StreamWindowBanks);
+	audio::BankPool::Instance().SetCompactIdleSamps(rigStruct.User.Loop.CompactIdleSamps);
+
+	// Whatever a run that never finished left in the journal becomes a
+	// session of its own, before this one starts journalling
+	const auto journalDir = dir + L"\\journal";
+	const auto recoveredDir = dir + L"\\recovered-" +
+		std::to_wstring(std::chrono::system_clock::to_time_t(std::chrono::system_clock::now()));
+	auto numRecovered = LoopJournal::Recover(journalDir, recoveredDir);
+	if (numRecovered > 0u)
+		std::cout << "Recovered " << numRecovered << " loop(s) from the last run into " << utils::EncodeUtf8(recoveredDir) << std::endl;
+	if (!LoopJournal::Instance().Start(journalDir))
+		std::cout << "Could not start the recording journal in " << utils::EncodeUtf8(journalDir) << std::endl;
+
+	auto startTime = std::chrono::steady_clock::now();
 	auto scene = std::make_shared<Scene>(sceneParams, rigStruct.User);
+	auto sceneTime = std::chrono::steady_clock::now();
 
 	TriggerParams trigParams;
 	trigParams.Size = { 24, 24 };
@@ -152,7 +180,7 @@ std::optional<std::shared_ptr<Scene>> Scene::FromFile(SceneParams sceneParams,
 	trigParams.TextureDitchDown = "blue";
 	trigParams.TextureOverdubbing = "orange";
 	trigParams.TexturePunchedIn = "purple";
-	trigParams.DebounceMs = rigStruct.User.Trigger.DebounceSamps;
+	trigParams.DebounceSamps = rigStruct.User.Trigger.DebounceSamps;
 
 	StationParams stationParams;
 	stationParams.Index = 0;
@@ -166,9 +194,15 @@ std::optional<std::shared_ptr<Scene>> Scene::FromFile(SceneParams sceneParams,
 	MergeMixBehaviourParams mergeParams;
 	AudioMixerParams mixerParams = Station::GetMixerParams(stationParams.Size, mergeParams);
 
+	// Stations are built with empty loops, then all the WAVs load together.
+	// Only then do the stations join the scene, so nothing reads a loop
+	// while it fills.
+	LoopLoader loader;
+	std::vector<std::shared_ptr<Station>> stations;
+
 	for (auto& stationStruct : jamStruct.Stations)
 	{
-		auto station = Station::FromFile(stationParams, mixerParams, stationStruct, dir);
+		auto station = Station::FromFile(stationParams, mixerParams, stationStruct, dir, loader);
 		if (station.has_value())
 		{
 			if (rigStruct.Triggers.size() > stationParams.Index)
@@ -185,7 +219,7 @@ std::optional<std::shared_ptr<Scene>> Scene::FromFile(SceneParams sceneParams,
 				}
 			}
 
-			scene->_AddStation(station.value());
+			stations.push_back(station.value());
 		}
 
 		stationParams.Index++;
@@ -193,11 +227,29 @@ std::optional<std::shared_ptr<Scene>> Scene::FromFile(SceneParams sceneParams,
 		stationParams.ModelPosition += { 600, 0 };
 	}
 
+	auto buildTime = std::chrono::steady_clock::now();
+	auto loadStats = loader.Run(constants::NumLoadWorkers);
+	auto loadTime = std::chrono::steady_clock::now();
+
+	for (auto& station : stations)
+		scene->_AddStation(station);
+
 	scene->_SetQuantisation(jamStruct.QuantiseSamps, jamStruct.Quantisation);
 	scene->_quantisation.SetGlobalPhaseOffsetSamps(jamStruct.GlobalPhaseOffsetSamps, scene->_stations);
 	scene->_networkService->GetController()->LoadConfig(jamStruct.Ninjam);
 	scene->InitReceivers();
 
+	auto msSince = [](std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+		return std::chrono::duration_cast<std::chrono::milliseconds>(to - from).count();
+	};
+	auto endTime = std::chrono::steady_clock::now();
+
+	std::cout << "[Startup] Scene " << msSince(startTime, sceneTime) << "ms"
+		<< ", stations " << msSince(sceneTime, buildTime) << "ms"
+		<< ", audio " << msSince(buildTime, loadTime) << "ms (" << LoopLoader::FormatStats(loadStats) << ")"
+		<< ", wiring " << msSince(loadTime, endTime) << "ms"
+		<< ", total " << msSince(startTime, endTime) << "ms" << std::endl;
+
 	return scene;
 }
 
@@ -610,9 +662,9 @@ ActionResult Scene::OnAction(KeyAction action)
 			_quantisation,
 			_userConfig,
 			_audioEngine->GetStreamParams(),
-			_audioEngine->GetDevice(),
 			_sceneMutex,
-			_networkService->GetController());
+			_networkService->GetController(),
+			_sessionWriter);
 	}
 
 	// Insert + Ctrl+Shift+L/W/X/[/] - MIDI automation record, learn, wire, delete, lane cycle.
@@ -708,7 +760,7 @@ ActionResult Scene::OnAction(GuiAction action)
 	return ActionResult::NoAction();
 }
 
-void Scene::OnTick(Time curTime,
+void Scene::OnTick(std::uint64_t sampleTime,
 	unsigned int samps,
 	std::optional<io::UserConfig> cfg,
 	std::optional<audio::AudioStreamParams> params)
@@ -723,7 +775,7 @@ void Scene::OnTick(Time curTime,
 
 	for (auto& station : stations)
 	{
-		station->OnTick(curTime,
+		station->OnTick(sampleTime,
 			samps,
 			_userConfig,
 			_audioEngine->GetStreamParams());
@@ -740,8 +792,12 @@ void Scene::OnTick(Time curTime,
 
 void Scene::OnJobTick(Time curTime)
 {
-	_PumpMidi();
-	_PumpSerial();
+	audio::CallbackProfiler::Instance().PumpCsv();
+
+	// Shedding changes are always reported, xruns only when logging audio verbosely
+	auto loadChange = audio::LoadMonitor::Instance().PollChange(_loggingConfig.Audio == "verbose");
+	if (loadChange.has_value())
+		std::cout << "[AUDIO] " << audio::LoadMonitor::FormatStatus(loadChange.value()) << std::endl;
 
 	auto snapshot = _networkService->GetController()->Pump();
 	{
@@ -757,34 +813,15 @@ void Scene::OnJobTick(Time curTime)
 		}
 	}
 
-	actions::JobAction job;
-	job.SetActionTime(Timer::GetTime());
-	job.SetUserConfig(_userConfig);
-	job.SetAudioParams(_audioEngine->GetStreamParams());
-
-	{
-		std::scoped_lock lock(_jobMutex);
-
-		if (_jobList.empty())
-			return;
-
-		job = _jobList.front();
-		_jobList.pop_front();
-
-		// Run only the newest job,
-		// removing previous identical jobs
-		for (auto j = _jobList.begin(); j != _jobList.end();)
-		{
-			if (job == *j)
-				j = _jobList.erase(j);
-			else
-				++j;
-		}
-	}
+	// Run everything pending, keeping only the newest of identical jobs
+	std::vector<actions::JobAction> dropped;
+	auto jobs = _jobQueue.Drain(dropped);
 
-	auto receiver = job.Receiver.lock();
-	if (receiver)
-		receiver->OnAction(job);
+	_jobWorkers.Run(jobs, [](actions::JobAction& job) {
+		auto receiver = job.Receiver.lock();
+		if (receiver)
+			receiver->OnAction(job);
+	});
 
 	// Hand any PreInit'd VST plugin (created on the UI thread) back to the UI
 	// thread for destruction. On success the chain holds its own ref so this
@@ -793,21 +830,20 @@ void Scene::OnJobTick(Time curTime)
 	// IComponent::terminate() / FreeLibrary run on the thread that PreInit'd
 	// the plugin. Releasing on this job thread instead violates VST3 threading
 	// and can crash plugins or leave dangling state until window close.
-	if (job.PreInitPlugin)
-		vst::QueueForUiThreadDestroy(std::move(job.PreInitPlugin));
+	for (auto jobSet : { &jobs, &dropped })
+	{
+		for (auto& job : *jobSet)
+		{
+			if (job.PreInitPlugin)
+				vst::QueueForUiThreadDestroy(std::move(job.PreInitPlugin));
+		}
+	}
 }
 
 void Scene::_PumpMidi()
 {
     auto summary = _inputSubsystem->PumpMidi(_stations, _audioEngine->GetAudioSampleCounter(), _audioEngine->GetStreamParams(), _sceneMutex);
-	if (summary.Activated)
-	{
-		_isSceneReset.store(false, std::memory_order_relaxed);
-		if (auto clock = _quantisation.Clock())
-			_SetMidiQuantisationGrain(clock->QuantiseSamps(), "loop activated");
-	}
-	if (summary.Ditched)
-		_ResetIfEmpty();
+	_ApplyInputResult(summary);
 }
 
 void Scene::_RegisterMidiTriggerRoute(const std::string& deviceName, std::shared_ptr<Trigger> trigger)
@@ -817,14 +853,26 @@ void Scene::_RegisterMidiTriggerRoute(const std::string& deviceName, std::shared
 
 void Scene::_PumpSerial()
 {
-    auto summary = _inputSubsystem->PumpSerial(_stations, _audioEngine->GetStreamParams(), _sceneMutex);
-	if (summary.Activated)
+    auto summary = _inputSubsystem->PumpSerial(_stations, _audioEngine->GetAudioSampleCounter(), _audioEngine->GetStreamParams(), _sceneMutex);
+	_ApplyInputResult(summary);
+}
+
+void Scene::_ApplyInputResult(const io::IoInputSubsystem::PumpResult& result)
+{
+	if (!result.Activated && !result.Ditched)
+		return;
+
+	// Runs on the MIDI thread, while OnJobTick() changes the same
+	// quantisation under the lock on the job thread
+	std::scoped_lock lock(_sceneMutex);
+
+	if (result.Activated)
 	{
 		_isSceneReset.store(false, std::memory_order_relaxed);
 		if (auto clock = _quantisation.Clock())
 			_SetMidiQuantisationGrain(clock->QuantiseSamps(), "loop activated");
 	}
-	if (summary.Ditched)
+	if (result.Ditched)
 		_ResetIfEmpty();
 }
 
@@ -926,8 +974,8 @@ void Scene::InitGui()
 void Scene::InitAudio()
 {
 	// Setup audio engine which starts device
-	bool started = _audioEngine->Init(_networkService->GetController(), [this](Time streamTime, unsigned int numSamps, const io::UserConfig& cfg, const audio::AudioStreamParams& params) {
-		this->OnTick(Timer::GetTime(), numSamps, cfg, params);
+	bool started = _audioEngine->Init(_networkService->GetController(), [this](std::uint64_t sampleTime, unsigned int numSamps, const io::UserConfig& cfg, const audio::AudioStreamParams& params) {
+		this->OnTick(sampleTime, numSamps, cfg, params);
 	});
 
 	if (started) {
@@ -973,8 +1021,17 @@ bool Scene::PumpGlobalInsertCapture(actions::KeyAction& action) noexcept
 void Scene::Shutdown()
 {
 	_isSceneQuitting.store(true, std::memory_order_release);
+	_jobQueue.Wake();
+	_inputSubsystem->WakeInput();
 	if (_jobRunner.joinable())
 		_jobRunner.join();
+	if (_midiRunner.joinable())
+		_midiRunner.join();
+	_jobWorkers.Stop();
+	// An export in progress still holds its loops, so let it finish
+	_sessionWriter.Wait();
+	// A clean exit leaves nothing to recover
+	LoopJournal::Instance().Stop(false);
 
 	CloseGlobalInsertCapture();
 	CloseAudio();
@@ -994,6 +1051,7 @@ void Scene::CommitChanges()
 
 		for (auto& station : _stations)
 		{
+			station->UpdateBounceRoutes();
 			auto jobs = station->CommitChanges();
 			if (!jobs.empty())
 			{
@@ -1021,6 +1079,10 @@ void Scene::CommitChanges()
 			receiver->OnAction(job);
 	}
 
+	// Free audio snapshots that were still being read when they were
+	// replaced. Done here so their destructors stay on the UI thread.
+	EpochDomain::Instance().Reclaim();
+
 	// Pre-initialise VST DLLs on the UI thread before handing jobs to the job
 	// thread. Do this after releasing _sceneMutex so LoadLibraryW stays out of
 	// the audio lock and later attached() calls remain UI-thread bound.
@@ -1037,11 +1099,22 @@ void Scene::CommitChanges()
 		}
 	}
 
-	if (!jobList.empty())
+	_jobQueue.Push(std::move(jobList));
+}
+
+std::vector<std::pair<std::string, std::size_t>> Scene::GetStationBufferBytes()
+{
+	std::scoped_lock lock(_sceneMutex);
+
+	std::vector<std::pair<std::string, std::size_t>> bytes;
+	bytes.reserve(_stations.size());
+	for (const auto& station : _stations)
 	{
-		std::scoped_lock lock(_jobMutex);
-		_jobList.insert(_jobList.end(), jobList.begin(), jobList.end());
+		if (station)
+			bytes.emplace_back(station->Name(), station->BufferBytes());
 	}
+
+	return bytes;
 }
 
 std::shared_ptr<StationRemote> Scene::FindRemoteStation(const std::vector<std::shared_ptr<Station>>& stations,
@@ -1348,7 +1421,23 @@ void Scene::_JobLoop()
 	while (!_isSceneQuitting.load(std::memory_order_acquire))
 	{
 		OnJobTick(Timer::GetTime());
-		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+		// Jobs wake the thread straight away; the timeout keeps the
+		// profiler and network pumps ticking over
+		_jobQueue.Wait(std::chrono::milliseconds(constants::JobTickMs));
+	}
+}
+
+void Scene::_MidiLoop()
+{
+	while (!_isSceneQuitting.load(std::memory_order_acquire))
+	{
+		_PumpMidi();
+		_PumpSerial();
+
+		// Device callbacks wake the thread as input arrives; the timeout
+		// keeps editor automation polled while nothing is played
+		_inputSubsystem->WaitForInput(std::chrono::milliseconds(constants::MidiIdleTickMs));
 	}
 }
 
@@ -27,6 +27,7 @@
 #include "../io/RigFile.h"
 #include "../io/InitFile.h"
 #include "../io/SerialDevice.h"
+#include "../io/SessionWriter.h"
 #include "../ninjam/NinjamController.h"
 #include "../audio/AudioHost.h"
 #include "../io/IoInputSubsystem.h"
@@ -45,6 +46,8 @@
 #include "Sizeable.h"
 #include "GuiElement.h"
 #include "Station.h"
+#include "JobQueue.h"
+#include "JobWorkerPool.h"
 #include "StationRemote.h"
 #include "../actions/ActionUndoHistory.h"
 
@@ -186,11 +189,16 @@ namespace engine
 		virtual actions::ActionResult OnAction(actions::TouchMoveAction action) override;
 		virtual actions::ActionResult OnAction(actions::KeyAction action) override;
 		virtual actions::ActionResult OnAction(actions::GuiAction action) override;
-		virtual void OnTick(Time curTime,
+		virtual void OnTick(std::uint64_t sampleTime,
 			unsigned int samps,
 			std::optional<io::UserConfig> cfg,
 			std::optional<audio::AudioStreamParams> params) override;
 		virtual void OnJobTick(Time curTime);
+		JobQueue::Stats GetJobStats() const { return _jobQueue.GetStats(); }
+		void ResetJobStats() { _jobQueue.ResetStats(); }
+		io::SessionWriter::Progress GetExportProgress() const { return _sessionWriter.GetProgress(); }
+		// Loop buffer bytes held by each station, by name
+		std::vector<std::pair<std::string, std::size_t>> GetStationBufferBytes();
 		virtual void InitResources(resources::ResourceLib& resourceLib, bool forceInit) override;
 		void InitReceivers();
 		void AddChild(std::shared_ptr<base::GuiElement> child);
@@ -272,9 +280,11 @@ namespace engine
 		void _SetQuantisation(unsigned int quantiseSamps, utils::Timer::QuantisationType quantisation);
 		void _SetMidiQuantisationGrain(unsigned int grainSamps, const char* source);
 		void _JobLoop();
+		void _MidiLoop();
 		void _PumpMidi();
 		void _RegisterMidiTriggerRoute(const std::string& deviceName, std::shared_ptr<Trigger> trigger);
 		void _PumpSerial();
+		void _ApplyInputResult(const io::IoInputSubsystem::PumpResult& result);
 		void _PublishAudioStations();
 		std::shared_ptr<base::GuiElement> _ChildFromPath(std::vector<unsigned char> path);
 		void _UpdateSelectDepth(unsigned int depth);
@@ -353,8 +363,10 @@ namespace engine
 		timing::TimingQuantiserController _quantisationInteraction;
 		graphics::Camera _camera;
 		std::thread _jobRunner;
-		std::mutex _jobMutex;
-		std::list<actions::JobAction> _jobList;
+		std::thread _midiRunner;
+		JobQueue _jobQueue;
+		JobWorkerPool _jobWorkers;
+		io::SessionWriter _sessionWriter;
 		std::mutex _sceneMutex;
 		io::UserConfig _userConfig;
 		ViewMode _viewMode;
@@ -1,9 +1,11 @@
 ﻿#include "Station.h"
 #include <algorithm>
 #include <cmath>
+#include <iterator>
 #include <limits>
 #include <memory>
 #include "../midi/MidiRouter.h"
+#include "../audio/CallbackProfiler.h"
 
 using namespace engine;
 using namespace timing;
@@ -88,15 +90,16 @@ Station::Station(StationParams params,
 	_backAudioMixers(),
 	_audioBuffers(),
 	_backAudioBuffers(),
-	_audioState(nullptr),
-	_vstChain(nullptr),
+	_audioState(),
+	_bounceRoutes(),
+	_vstChain(),
 	_backVstChain(nullptr),
 	_flipVstChain(false),
 	_pendingVstLoads(),
 	_pendingVstUnloads(),
 	_vstPathsMutex(),
 	_vstPluginPaths(),
-	_liveMidiIngress(),
+	_liveMidi(std::make_shared<midi::LiveMidiInput>()),
 	_midiVstRoutes(nullptr),
 	_retainedMidiVstRoutes(),
 	_sampleRate(44100.0f),
@@ -118,18 +121,20 @@ Station::Station(StationParams params,
 
 	_WireVuSliders();
 	_PublishAudioState();
+	_PublishBounceRoutes();
 }
 
 Station::~Station()
 {
-	_DrainVstChain(_vstChain.load(std::memory_order_acquire));
+	_DrainVstChain(_vstChain.LoadShared());
 	_DrainVstChain(_backVstChain);
 }
 
 std::optional<std::shared_ptr<Station>> Station::FromFile(StationParams stationParams,
 	AudioMixerParams mixerParams,
 	io::JamFile::Station stationStruct,
-	std::wstring dir)
+	std::wstring dir,
+	LoopLoader& loader)
 {
 	stationParams.Name = stationStruct.Name;
 	auto station = std::make_shared<Station>(stationParams, mixerParams);
@@ -149,7 +154,7 @@ std::optional<std::shared_ptr<Station>> Station::FromFile(StationParams stationP
 	for (auto takeStruct : stationStruct.LoopTakes)
 	{
 		takeParams.ModelPosition = { (float)gap.Width, (float)(takeCount * takeHeight + gap.Height), 0.0 };
-		auto take = LoopTake::FromFile(takeParams, takeStruct, dir);
+		auto take = LoopTake::FromFile(takeParams, takeStruct, dir, loader);
 		
 		if (take.has_value())
 			station->AddTake(take.value());
@@ -329,6 +334,8 @@ void Station::WriteBlock(const std::shared_ptr<base::MultiAudioSink> dest,
 	unsigned int numSamps,
 	std::uint32_t blockStartSample)
 {
+	JAMMA_PROFILE_SCOPE(STAGE_STATION);
+
 	auto ptr = Sharable::shared_from_this();
 	auto state = _AudioStateSnapshot();
 	if (!state)
@@ -345,16 +352,17 @@ void Station::WriteBlock(const std::shared_ptr<base::MultiAudioSink> dest,
 
 	auto sampsToRead = (numSamps <= constants::MaxBlockSize) ? numSamps : constants::MaxBlockSize;
 	auto masterLevel = static_cast<float>(_masterMixer->Level());
+	auto masterRamp = _masterMixer->FadeRamp(sampsToRead);
 	auto masterPeak = 0.0f;
 	const auto channelCount = (state->AudioBuffers.size() < state->AudioMixers.size()) ? state->AudioBuffers.size() : state->AudioMixers.size();
 
 	_PrepareVstScratch(*state, sampsToRead);
 
-	auto chain = _vstChain.load(std::memory_order_acquire);
+	auto chain = _vstChain.Load();
 	const auto* routes = _midiVstRoutes.load(std::memory_order_acquire);
 	const bool vstActive = (channelCount > 0u) && chain && chain->IsActive() && (state->VstBlockPtrs.size() >= channelCount);
 
-	_RunVstBlock(chain.get(), routes, *state, vstActive,
+	_RunVstBlock(chain, routes, *state, vstActive,
 		static_cast<unsigned int>(channelCount), sampsToRead, blockStartSample);
 
 	// Drive any wired parameter automation. Runs independently of vstActive so a
@@ -365,7 +373,6 @@ void Station::WriteBlock(const std::shared_ptr<base::MultiAudioSink> dest,
 	if (channelCount == 0u)
 	{
 		_masterMixer->UpdateVu(0.0f, sampsToRead);
-		_masterMixer->Offset(sampsToRead);
 		return;
 	}
 
@@ -374,7 +381,7 @@ void Station::WriteBlock(const std::shared_ptr<base::MultiAudioSink> dest,
 		auto* scratch = state->VstBlockPtrs[i];
 		for (auto samp = 0u; samp < sampsToRead; samp++)
 		{
-			scratch[samp] *= masterLevel;
+			scratch[samp] *= (nullptr != masterRamp) ? masterRamp[samp] : masterLevel;
 			auto absSamp = std::abs(scratch[samp]);
 			if (absSamp > masterPeak)
 				masterPeak = absSamp;
@@ -384,7 +391,6 @@ void Station::WriteBlock(const std::shared_ptr<base::MultiAudioSink> dest,
 	}
 
 	_masterMixer->UpdateVu(masterPeak, sampsToRead);
-	_masterMixer->Offset(sampsToRead);
 }
 
 void Station::_PrepareVstScratch(const AudioState& state, unsigned int sampsToRead) noexcept
@@ -412,6 +418,8 @@ void Station::_RunVstBlock(vst::VstChain* chain,
 	unsigned int sampsToRead,
 	std::uint32_t blockStartSample) noexcept
 {
+	JAMMA_PROFILE_SCOPE(STAGE_VST);
+
 	if (vstActive)
 	{
 		vst::HostTimeState hostTime;
@@ -434,12 +442,10 @@ void Station::_RunVstBlock(vst::VstChain* chain,
 	}
 
 	// Always drain live MIDI to avoid backlogging stale events when no instrument is active.
-	MidiEvent liveMidi{};
-	while (_liveMidiIngress.Pop(liveMidi))
-	{
+	_liveMidi->ReadBlock(blockStartSample, sampsToRead, [&](const MidiEvent& liveMidi) noexcept {
 		if (vstActive)
 			midi::SendMidiToVstChain(chain, routes, liveMidi, true, LiveMidiOutputIndex);
-	}
+	});
 
 	if (!vstActive)
 		return;
@@ -537,7 +543,7 @@ std::shared_ptr<midi::MidiLoop> Station::ResolveEditorAutomationLoop(const vst::
 
 	// Station-level ownership: record into the station's last recorded loop
 	// (the most recently created MIDI loop across all takes).
-	auto chain = _vstChain.load(std::memory_order_acquire);
+	auto chain = _vstChain.LoadShared();
 	if (chain && chain->ContainsPlugin(plugin))
 	{
 		std::shared_ptr<midi::MidiLoop> last;
@@ -820,10 +826,7 @@ ActionResult Station::OnAction(TriggerAction action)
 	{
 		std::vector<std::pair<std::string, MidiNoteSnapshot>> heldSnapshot;
 		if (!action.MidiInputChannels.empty())
-		{
-			std::scoped_lock lock(_liveHeldMidiMutex);
-			heldSnapshot = _liveHeldMidi;
-		}
+			heldSnapshot = _liveMidi->HeldNotes();
 		auto newLoopTake = AddTake();
 		const auto transportStartSamps = _clock ? _clock->AbsoluteSamplePos() : 0ul;
 		newLoopTake->Record(action.InputChannels,
@@ -892,7 +895,7 @@ ActionResult Station::OnAction(TriggerAction action)
 			std::cout << "Playing loop from " << playPos << " with loop length " << loopLength << " (out latency = " << outLatency << ")" << std::endl;
 
 			if (loopTake.has_value())
-				loopTake.value()->Play(playPos, loopLength, endRecordSamps, errorSamps);
+				loopTake.value()->Play(playPos, loopLength, endRecordSamps, errorSamps, action.BlockOffset);
 
 			res.IsEaten = true;
 			res.ResultType = actions::ActionResultType::ACTIONRESULT_ACTIVATE;
@@ -972,7 +975,7 @@ ActionResult Station::OnAction(TriggerAction action)
 			std::cout << "Playing loop from " << playPos << " with loop length " << loopLength << " (out latency = " << outLatency << ")" << std::endl;
 
 			if (loopTake.has_value())
-				loopTake.value()->Play(playPos, loopLength, endRecordSamps, errorSamps);
+				loopTake.value()->Play(playPos, loopLength, endRecordSamps, errorSamps, action.BlockOffset);
 
 			auto sourceLoopTake = _TryGetTake(action.SourceId);
 			if (sourceLoopTake.has_value())
@@ -991,7 +994,7 @@ ActionResult Station::OnAction(TriggerAction action)
 		}
 
 		if (action.ApplyToTargetTake && loopTake.has_value())
-			loopTake.value()->PunchIn(action.ApplyToTargetAudio, action.ApplyToTargetMidi);
+			loopTake.value()->PunchIn(action.ApplyToTargetAudio, action.ApplyToTargetMidi, action.BlockOffset);
 
 		if (action.ApplyToSourceTake)
 		{
@@ -1010,7 +1013,7 @@ ActionResult Station::OnAction(TriggerAction action)
 		}
 
 		if (action.ApplyToTargetTake && loopTake.has_value())
-			loopTake.value()->PunchOut(action.ApplyToTargetAudio, action.ApplyToTargetMidi);
+			loopTake.value()->PunchOut(action.ApplyToTargetAudio, action.ApplyToTargetMidi, action.BlockOffset);
 
 		if (action.ApplyToSourceTake)
 		{
@@ -1057,24 +1060,21 @@ ActionResult Station::OnAction(TriggerAction action)
 	return res;
 }
 
-void Station::OnTick(Time curTime,
+void Station::OnTick(std::uint64_t sampleTime,
 	unsigned int samps,
 	std::optional<io::UserConfig> cfg,
 	std::optional<audio::AudioStreamParams> params)
 {
 	for (auto& trig : _triggers)
 	{
-		trig->OnTick(curTime, samps, cfg, params);
+		trig->OnTick(sampleTime, samps, cfg, params);
 	}
 }
 
 void Station::Reset()
 {
 	Jammable::Reset();
-	{
-		std::scoped_lock lock(_liveHeldMidiMutex);
-		_liveHeldMidi.clear();
-	}
+	_liveMidi->ResetHeldNotes();
 	if (_stationModel)
 		_stationModel->ResetStationLevel();
 
@@ -1093,6 +1093,7 @@ void Station::Reset()
 			_children.erase(child);
 	}
 	_triggers.clear();
+	_PublishBounceRoutes();
 }
 
 std::shared_ptr<LoopTake> Station::AddTake()
@@ -1130,6 +1131,7 @@ void Station::AddTrigger(std::shared_ptr<Trigger> trigger)
 
 	_triggers.push_back(trigger);
 	_children.push_back(trigger);
+	_PublishBounceRoutes();
 }
 
 unsigned int Station::NumTakes() const
@@ -1139,6 +1141,18 @@ unsigned int Station::NumTakes() const
 		(unsigned int)_loopTakes.size();
 }
 
+std::size_t Station::BufferBytes() const
+{
+	std::size_t bytes = 0;
+	for (const auto& take : GetLoopTakes())
+	{
+		if (take)
+			bytes += take->BufferBytes();
+	}
+
+	return bytes;
+}
+
 std::string Station::Name() const
 {
 	return _name;
@@ -1425,44 +1439,39 @@ unsigned int Station::NumBusChannels() const
 }
 
 void Station::OnBounce(unsigned int numSamps,
-	io::UserConfig config,
+	const io::UserConfig& config,
 	std::optional<audio::AudioStreamParams> params)
 {
+	JAMMA_PROFILE_SCOPE(STAGE_BOUNCE);
+
 	auto outLatency = params.has_value() ? params.value().OutputLatency : 0u;
 	if (0u == outLatency)
 		outLatency = config.Audio.LatencyOut;
 
 	auto sourceOffset = config.OverdubSourceReadOffset(outLatency);
-	auto state = _AudioStateSnapshot();
-	if (!state)
+	auto routes = _bounceRoutes.Load();
+	if (!routes)
 		return;
 
-	for (auto& trigger : _triggers)
+	for (const auto& route : routes->Routes)
 	{
-		auto takes = trigger->GetTakes();
-
-		for (auto& take : takes)
-		{
-			std::string sourceId = take.SourceTakeId;
-			std::string targetId = take.TargetTakeId;
-			auto sourceMatch = std::find_if(state->LoopTakes.begin(),
-				state->LoopTakes.end(),
-				[&sourceId](const std::weak_ptr<LoopTake>& arg) { auto t = arg.lock(); return t && t->Id() == sourceId; });
-			auto targetMatch = std::find_if(state->LoopTakes.begin(),
-				state->LoopTakes.end(),
-				[&targetId](const std::weak_ptr<LoopTake>& arg) { auto t = arg.lock(); return t && t->Id() == targetId; });
-
-			if ((state->LoopTakes.end() != sourceMatch) && (state->LoopTakes.end() != targetMatch))
-			{
-				auto sourceTake = sourceMatch->lock();
-				auto targetTake = targetMatch->lock();
-				if (sourceTake && targetTake)
-					sourceTake->WriteBlock(targetTake, trigger, sourceOffset, numSamps);
-			}
-		}
+		routes->Takes[route.SourceTake]->WriteBlock(routes->Takes[route.TargetTake],
+			routes->Triggers[route.BounceTrigger],
+			sourceOffset,
+			numSamps);
 	}
 }
 
+void Station::UpdateBounceRoutes()
+{
+	for (const auto& trigger : _triggers)
+		trigger->CommitTakes();
+
+	auto routes = _bounceRoutes.LoadShared();
+	if (!routes || (routes->TakesVersion != _TriggerTakesVersion()))
+		_PublishBounceRoutes();
+}
+
 void Station::SetRackVisibility(bool showStationRack, bool showLoopTakeRacks)
 {
 	// Set the visibility of the Station (master/channels/router) rack
@@ -1502,30 +1511,9 @@ void Station::EnqueueLiveMidiEvent(const MidiEvent& event)
 
 void Station::EnqueueLiveMidiEvent(const MidiEvent& event, const std::string& deviceName)
 {
-	if (event.IsNoteOn() || event.IsNoteOff())
-	{
-		const auto channel = event.Channel();
-		const auto note = static_cast<std::uint8_t>(event.data1 & 0x7F);
-		std::scoped_lock lock(_liveHeldMidiMutex);
-		// Keep one snapshot for "any device" and one snapshot for the actual device.
-		// The empty-name snapshot is for device-agnostic recording; the named one is
-		// for real MIDI input from a specific device.
-		auto upsert = [&](const std::string& key) {
-			auto it = std::find_if(_liveHeldMidi.begin(), _liveHeldMidi.end(),
-				[&key](const auto& p) { return p.first == key; });
-			if (it == _liveHeldMidi.end())
-			{
-				_liveHeldMidi.push_back({ key, MidiNoteSnapshot{} });
-				it = std::prev(_liveHeldMidi.end());
-			}
-			if (event.IsNoteOn()) it->second.Set(channel, note, event.data2);
-			else it->second.Clear(channel, note);
-		};
-		upsert("");
-		if (!deviceName.empty())
-			upsert(deviceName);
-	}
-	_liveMidiIngress.Push(event);
+	// Held notes are kept for "any device" and for the named device, so
+	// recording can seed from either.
+	_liveMidi->Push(event, deviceName);
 }
 
 void Station::SetMidiVstRoute(unsigned int midiOutputIndex, size_t vstIndex)
@@ -1661,12 +1649,13 @@ std::vector<JobAction> Station::_CommitChanges()
 	if (audioStateChanged)
 	{
 		_PublishAudioState();
+		_PublishBounceRoutes();
 	}
 
 	// Swap in the VST chain if the job thread has delivered a new one.
 	if (_flipVstChain.exchange(false, std::memory_order_acquire))
 	{
-		_vstChain.store(_backVstChain, std::memory_order_release);
+		_vstChain.Publish(_backVstChain);
 	}
 
 	// Detect pending VST load/unload requests and queue a job for them.
@@ -1726,9 +1715,9 @@ const std::shared_ptr<AudioSink> Station::_InputChannel(unsigned int channel,
 	return nullptr;
 }
 
-std::shared_ptr<const Station::AudioState> Station::_AudioStateSnapshot() const
+const Station::AudioState* Station::_AudioStateSnapshot() const noexcept
 {
-	return _audioState.load(std::memory_order_acquire);
+	return _audioState.Load();
 }
 
 void Station::_PublishAudioState()
@@ -1743,7 +1732,57 @@ void Station::_PublishAudioState()
 	state->VstBlockPtrs.resize(state->AudioBuffers.size(), nullptr);
 	for (auto i = 0u; i < state->AudioBuffers.size(); i++)
 		state->VstBlockPtrs[i] = state->VstBlockScratch.data() + (static_cast<size_t>(i) * constants::MaxBlockSize);
-	_audioState.store(state, std::memory_order_release);
+	_audioState.Publish(state);
+}
+
+void Station::_PublishBounceRoutes()
+{
+	auto routes = std::make_shared<BounceRoutes>();
+	routes->TakesVersion = _TriggerTakesVersion();
+
+	// Adds the matching take to the snapshot once, returning its index
+	auto findTake = [this, &routes](const std::string& id) -> std::optional<unsigned int> {
+		auto match = std::find_if(_loopTakes.begin(), _loopTakes.end(),
+			[&id](const std::shared_ptr<LoopTake>& take) { return take->Id() == id; });
+		if (_loopTakes.end() == match)
+			return std::nullopt;
+
+		auto held = std::find(routes->Takes.begin(), routes->Takes.end(), *match);
+		if (routes->Takes.end() == held)
+			held = routes->Takes.insert(routes->Takes.end(), *match);
+
+		return static_cast<unsigned int>(std::distance(routes->Takes.begin(), held));
+	};
+
+	for (const auto& trigger : _triggers)
+	{
+		auto takes = trigger->GetTakes();
+		for (const auto& take : *takes)
+		{
+			auto sourceTake = findTake(take.SourceTakeId);
+			auto targetTake = findTake(take.TargetTakeId);
+			if (!sourceTake.has_value() || !targetTake.has_value())
+				continue;
+
+			if (routes->Triggers.empty() || (routes->Triggers.back() != trigger))
+				routes->Triggers.push_back(trigger);
+
+			routes->Routes.push_back({ sourceTake.value(),
+				targetTake.value(),
+				static_cast<unsigned int>(routes->Triggers.size() - 1u) });
+		}
+	}
+
+	_bounceRoutes.Publish(routes);
+}
+
+unsigned int Station::_TriggerTakesVersion() const noexcept
+{
+	auto version = 0u;
+	for (const auto& trigger : _triggers)
+		version += trigger->TakesVersion();
+
+	return version;
 }
 
 void Station::_ArrangeChildren()
@@ -1867,7 +1906,7 @@ void Station::UnloadVstPlugin(size_t index)
 
 std::shared_ptr<vst::IVstPlugin> Station::GetVstPlugin(size_t index) const
 {
-	auto chain = _vstChain.load(std::memory_order_acquire);
+	auto chain = _vstChain.LoadShared();
 	if (!chain)
 		return nullptr;
 
@@ -1878,7 +1917,7 @@ std::vector<io::JamFile::VstEntry> Station::VstEntries() const
 {
 	std::vector<io::JamFile::VstEntry> entries;
 
-	auto chain = _vstChain.load(std::memory_order_acquire);
+	auto chain = _vstChain.LoadShared();
 	std::lock_guard<std::mutex> lock(_vstPathsMutex);
 	entries.reserve(_vstPluginPaths.size());
 
@@ -1917,7 +1956,7 @@ ActionResult Station::OnAction(JobAction action)
 		// Take a snapshot of the current live chain under _vstChainMutex so
 		// we don't race with _CommitChanges() swapping it on the main thread.
 		std::shared_ptr<vst::VstChain> chainSnapshot;
-		chainSnapshot = _vstChain.load(std::memory_order_acquire);
+		chainSnapshot = _vstChain.LoadShared();
 
 		auto newChain = std::make_shared<vst::VstChain>();
 		if (chainSnapshot)
@@ -1973,7 +2012,7 @@ ActionResult Station::OnAction(JobAction action)
 		// This runs on the job thread so DLL teardown is not under the audio mutex.
 		// Take a snapshot of the current live chain under _vstChainMutex.
 		std::shared_ptr<vst::VstChain> chainSnapshot;
-		chainSnapshot = _vstChain.load(std::memory_order_acquire);
+		chainSnapshot = _vstChain.LoadShared();
 
 		auto newChain = std::make_shared<vst::VstChain>();
 		const auto removeIndex = action.VstIndex;
@@ -19,9 +19,10 @@
 #include "../base/Jammable.h"
 #include "../gui/GuiRack.h"
 #include "../io/InitFile.h"
-#include "../midi/MidiQueue.h"
+#include "../midi/LiveMidiInput.h"
 #include "../midi/MidiVstOutputSink.h"
 #include "../vst/VstChain.h"
+#include "../utils/Epoch.h"
 
 namespace engine
 {
@@ -81,7 +82,8 @@ namespace engine
 		static std::optional<std::shared_ptr<Station>> FromFile(StationParams stationParams,
 			audio::AudioMixerParams mixerParams,
 			io::JamFile::Station stationStruct,
-			std::wstring dir);
+			std::wstring dir,
+			LoopLoader& loader);
 		static audio::AudioMixerParams GetMixerParams(utils::Size2d stationSize,
 			audio::BehaviourParams behaviour);
 
@@ -115,7 +117,7 @@ namespace engine
 			const std::string& device = "");
 		virtual actions::ActionResult OnAction(actions::GuiAction action) override;
 		virtual actions::ActionResult OnAction(actions::TriggerAction action) override;
-		virtual void OnTick(Time curTime,
+		virtual void OnTick(std::uint64_t sampleTime,
 			unsigned int samps,
 			std::optional<io::UserConfig> cfg,
 			std::optional<audio::AudioStreamParams> params) override;
@@ -132,6 +134,7 @@ namespace engine
 		void AddTake(std::shared_ptr<LoopTake> take);
 		void AddTrigger(std::shared_ptr<Trigger> trigger);
 		unsigned int NumTakes() const;
+		std::size_t BufferBytes() const;
 		std::string Name() const;
 		void SetName(std::string name);
 		void SetClock(std::shared_ptr<utils::Timer> clock);
@@ -151,8 +154,12 @@ namespace engine
 		void SetNumDacChannels(unsigned int chans);
 		unsigned int NumBusChannels() const;
 		void OnBounce(unsigned int numSamps,
-			io::UserConfig config,
+			const io::UserConfig& config,
 			std::optional<audio::AudioStreamParams> params = std::nullopt);
+		// Commits each trigger's take history, then rebuilds the bounce routes
+		// if any of it has changed since they were last published. Call from
+		// the GUI thread.
+		void UpdateBounceRoutes();
 		void SetRackVisibility(bool showStationRack, bool showLoopTakeRacks);
 		std::vector<io::JamFile::VstEntry> VstEntries() const;
 		// Returns true if the named device is allowed to drive this station's live
@@ -162,8 +169,12 @@ namespace engine
 		// For synthetic live MIDI events, like punch-in NoteOn/NoteOff pairs,
 		// without associated deviceName.
 		void EnqueueLiveMidiEvent(const midi::MidiEvent& event);
-		// For real live MIDI input, with associated deviceName.
+		// For live MIDI input from a named device that has no direct path to
+		// the audio thread.
 		void EnqueueLiveMidiEvent(const midi::MidiEvent& event, const std::string& deviceName);
+		// MIDI device callbacks push live events here directly. See
+		// midi::LiveMidiInput.
+		std::shared_ptr<midi::LiveMidiInput> LiveMidi() const noexcept { return _liveMidi; }
 		// Replacement semantics: one MIDI output routes to at most one plugin.
 		void SetMidiVstRoute(unsigned int midiOutputIndex, size_t vstIndex);
 		void ClearMidiVstRoutes();
@@ -233,11 +244,35 @@ namespace engine
 			std::vector<float*> VstBlockPtrs;
 		};
 
+		// One (source take -> target take) overdub pair, resolved from the
+		// trigger's take ids when the routes are published, so OnBounce does
+		// no id lookups on the audio thread. Indices into the owning
+		// BounceRoutes, so OnBounce needs no weak_ptr locks either.
+		struct BounceRoute
+		{
+			unsigned int SourceTake;
+			unsigned int TargetTake;
+			unsigned int BounceTrigger;
+		};
+
+		// Holds the takes and triggers its routes use, so they stay alive
+		// for as long as a callback has the snapshot loaded. They are
+		// released when the epoch reclaims it, off the audio thread.
+		struct BounceRoutes
+		{
+			std::vector<std::shared_ptr<LoopTake>> Takes;
+			std::vector<std::shared_ptr<Trigger>> Triggers;
+			std::vector<BounceRoute> Routes;
+			unsigned int TakesVersion;
+		};
+
 		void _CollapseOtherTakeRouters();
 		void _CollapseOtherTakeRoutersToChannels();
 		void _ApplyMidiQuantisationPhaseOffset() noexcept;
 		void _PublishAudioState();
-		std::shared_ptr<const AudioState> _AudioStateSnapshot() const;
+		const AudioState* _AudioStateSnapshot() const noexcept;
+		void _PublishBounceRoutes();
+		unsigned int _TriggerTakesVersion() const noexcept;
 
 		gui::GuiRackParams _GetRackParams(utils::Size2d size);
 		std::optional<std::shared_ptr<LoopTake>> _TryGetTake(std::string id);
@@ -323,7 +358,8 @@ namespace engine
 		std::vector<std::shared_ptr<audio::AudioMixer>> _backAudioMixers;
 		std::vector<std::shared_ptr<audio::AudioBuffer>> _audioBuffers;
 		std::vector<std::shared_ptr<audio::AudioBuffer>> _backAudioBuffers;
-		std::atomic<std::shared_ptr<const AudioState>> _audioState;
+		utils::EpochPtr<const AudioState> _audioState;
+		utils::EpochPtr<const BounceRoutes> _bounceRoutes;
 
 		// Flat automation dispatch list, double-buffered and published with an
 		// atomic-swap release store (audio thread reads with acquire). Built only on
@@ -343,7 +379,7 @@ namespace engine
 		// VST insert chain applied after all LoopTakes are mixed down,
 		// just before each channel is sent to the output AudioMixer.
 		// Published atomically for lock-free audio-thread reads.
-		std::atomic<std::shared_ptr<vst::VstChain>> _vstChain;
+		utils::EpochPtr<vst::VstChain> _vstChain;
 		std::shared_ptr<vst::VstChain> _backVstChain;
 		std::atomic<bool> _flipVstChain{ false };
 
@@ -356,9 +392,8 @@ namespace engine
 		// Access is guarded by _vstPathsMutex in both directions.
 		mutable std::mutex _vstPathsMutex;
 		std::vector<std::wstring> _vstPluginPaths;
-		midi::MidiQueue<1024> _liveMidiIngress;
-		mutable std::mutex _liveHeldMidiMutex;
-		std::vector<std::pair<std::string, midi::MidiNoteSnapshot>> _liveHeldMidi;
+		// Shared with the MIDI device callbacks, which push into it directly.
+		std::shared_ptr<midi::LiveMidiInput> _liveMidi;
 		// Route snapshots are published off the audio thread.
 		// The callback reads an immutable snapshot pointer for O(1) lookups.
 		std::atomic<const MidiVstRoutingSnapshot*> _midiVstRoutes;
@@ -0,0 +1,132 @@
+#include "TakeHistory.h"
+#include <algorithm>
+
+using namespace engine;
+
+TakeHistory::TakeHistory() :
+	_takes(),
+	_numTakes(0u),
+	_edits(),
+	_editHead(0u),
+	_editTail(0u),
+	_numDropped(0u),
+	_committed(),
+	_snapshot(),
+	_version(0u)
+{
+	for (auto& take : _takes)
+		_Reserve(take);
+
+	for (auto& edit : _edits)
+		_Reserve(edit.Take);
+
+	_committed.reserve(MaxTakes);
+	_snapshot.Publish(std::make_shared<const TakeList>());
+}
+
+void TakeHistory::Push(const TriggerTake& take)
+{
+	// Rotating swaps the strings, so the reserved space moves with them
+	if (MaxTakes == _numTakes)
+	{
+		std::rotate(_takes.begin(), _takes.begin() + 1, _takes.end());
+		_numTakes--;
+	}
+
+	_Assign(_takes[_numTakes], take);
+	_numTakes++;
+
+	_PushEdit(Edit::EDIT_PUSH, &take);
+}
+
+void TakeHistory::Pop()
+{
+	if (0u == _numTakes)
+		return;
+
+	_numTakes--;
+	_PushEdit(Edit::EDIT_POP, nullptr);
+}
+
+void TakeHistory::Clear()
+{
+	_numTakes = 0u;
+	_PushEdit(Edit::EDIT_CLEAR, nullptr);
+}
+
+bool TakeHistory::Commit()
+{
+	auto head = _editHead.load(std::memory_order_relaxed);
+	const auto tail = _editTail.load(std::memory_order_acquire);
+
+	if (head == tail)
+		return false;
+
+	while (head != tail)
+	{
+		const auto& edit = _edits[head];
+
+		switch (edit.Type)
+		{
+		case Edit::EDIT_PUSH:
+			if (_committed.size() >= MaxTakes)
+				_committed.erase(_committed.begin());
+			// Copied, so the slot keeps its reserved strings
+			_committed.push_back(edit.Take);
+			break;
+		case Edit::EDIT_POP:
+			if (!_committed.empty())
+				_committed.pop_back();
+			break;
+		case Edit::EDIT_CLEAR:
+			_committed.clear();
+			break;
+		}
+
+		head = (head + 1u) & _EditMask;
+		_editHead.store(head, std::memory_order_release);
+	}
+
+	_snapshot.Publish(std::make_shared<const TakeList>(_committed));
+	_version.fetch_add(1u, std::memory_order_release);
+
+	return true;
+}
+
+std::shared_ptr<const TakeHistory::TakeList> TakeHistory::Snapshot() const
+{
+	return _snapshot.LoadShared();
+}
+
+void TakeHistory::_Reserve(TriggerTake& take)
+{
+	take.SourceTakeId.reserve(MaxIdChars);
+	take.TargetTakeId.reserve(MaxIdChars);
+}
+
+void TakeHistory::_Assign(TriggerTake& dest, const TriggerTake& src)
+{
+	dest.SourceType = src.SourceType;
+	dest.SourceTakeId.assign(src.SourceTakeId);
+	dest.TargetTakeId.assign(src.TargetTakeId);
+}
+
+void TakeHistory::_PushEdit(Edit::EditType type, const TriggerTake* take)
+{
+	const auto tail = _editTail.load(std::memory_order_relaxed);
+	const auto head = _editHead.load(std::memory_order_acquire);
+	const auto next = (tail + 1u) & _EditMask;
+
+	if (next == head)
+	{
+		_numDropped.fetch_add(1u, std::memory_order_relaxed);
+		return;
+	}
+
+	auto& edit = _edits[tail];
+	edit.Type = type;
+	if (nullptr != take)
+		_Assign(edit.Take, *take);
+
+	_editTail.store(next, std::memory_order_release);
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../utils/Epoch.h"
+
+namespace engine
+{
+	struct TriggerTake
+	{
+		enum SourceType
+		{
+			SOURCE_ADC,
+			SOURCE_LOOPTAKE,
+			SOURCE_STATION
+		};
+		SourceType SourceType;
+		std::string SourceTakeId;
+		std::string TargetTakeId;
+	};
+
+	// The takes a trigger has recorded or overdubbed, newest last.
+	//
+	// The trigger's state machine runs on the audio tick and edits its own
+	// fixed-size copy. Ids are copied into strings reserved up front, so an
+	// edit neither locks nor allocates (unless an id is longer than
+	// MaxIdChars). Each edit also goes onto a single-producer ring, which
+	// Commit() replays on the UI thread into an immutable snapshot published
+	// through utils::EpochPtr.
+	//
+	// Past MaxTakes the oldest take is forgotten, and can no longer be
+	// ditched from the trigger.
+	class TakeHistory
+	{
+	public:
+		static constexpr unsigned int MaxTakes = 64u;
+		static constexpr unsigned int MaxEdits = 64u;
+		static constexpr std::size_t MaxIdChars = 128u;
+
+		using TakeList = std::vector<TriggerTake>;
+
+	public:
+		TakeHistory();
+
+		TakeHistory(const TakeHistory&) = delete;
+		TakeHistory& operator=(const TakeHistory&) = delete;
+
+		// State machine side
+		bool IsEmpty() const noexcept { return 0u == _numTakes; }
+		// Only valid while not empty
+		const TriggerTake& Back() const noexcept { return _takes[_numTakes - 1u]; }
+		void Push(const TriggerTake& take);
+		void Pop();
+		void Clear();
+
+		// UI thread. Replays pending edits and publishes them, returning
+		// true if anything changed.
+		bool Commit();
+		std::shared_ptr<const TakeList> Snapshot() const;
+		// Bumped each time Commit() publishes a new snapshot
+		unsigned int Version() const noexcept { return _version.load(std::memory_order_acquire); }
+		// Edits lost because the UI thread fell MaxEdits behind
+		std::uint64_t NumDropped() const noexcept { return _numDropped.load(std::memory_order_relaxed); }
+
+	protected:
+		struct Edit
+		{
+			enum EditType
+			{
+				EDIT_PUSH,
+				EDIT_POP,
+				EDIT_CLEAR
+			};
+
+			EditType Type = EDIT_CLEAR;
+			TriggerTake Take{};
+		};
+
+		static void _Reserve(TriggerTake& take);
+		static void _Assign(TriggerTake& dest, const TriggerTake& src);
+		void _PushEdit(Edit::EditType type, const TriggerTake* take);
+
+	protected:
+		static constexpr unsigned int _EditMask = MaxEdits - 1u;
+		static_assert((MaxEdits & _EditMask) == 0u, "MaxEdits must be a power of two");
+
+		std::array<TriggerTake, MaxTakes> _takes;
+		unsigned int _numTakes;
+		std::array<Edit, MaxEdits> _edits;
+		std::atomic<unsigned int> _editHead;
+		std::atomic<unsigned int> _editTail;
+		std::atomic<std::uint64_t> _numDropped;
+		TakeList _committed;
+		utils::EpochPtr<const TakeList> _snapshot;
+		std::atomic<unsigned int> _version;
+	};
+}
@@ -84,26 +84,34 @@ Trigger::Trigger(TriggerParams trigParams) :
 	_midiInputChannels(trigParams.MidiInputChannels),
 	_midiInputDevices(trigParams.MidiInputDevices),
 	_state(TRIGSTATE_DEFAULT),
-	_debounceTimeMs(trigParams.DebounceMs),
-	_lastActivateTime(),
-	_lastDitchTime(),
+	_debounceSamps(trigParams.DebounceSamps),
+	_lastActivateSample(std::nullopt),
+	_lastDitchSample(std::nullopt),
 	_isDitchDown(false),
 	_isLastActivateDown(false),
 	_isLastDitchDown(false),
 	_isLastActivateDownRaw(false),
 	_isLastDitchDownRaw(false),
-	_recordSampCount(0),
+	_sampleClock(0u),
+	_recordStartSample(0u),
 	_textureRecording(ImageParams(DrawableParams{ trigParams.TextureRecording }, SizeableParams{ trigParams.Size,trigParams.MinSize }, "texture", trigParams.Rot90, trigParams.FlipH, trigParams.FlipV)),
 	_textureDitchDown(ImageParams(DrawableParams{ trigParams.TextureDitchDown }, SizeableParams{ trigParams.Size,trigParams.MinSize }, "texture", trigParams.Rot90, trigParams.FlipH, trigParams.FlipV)),
 	_textureOverdubbing(ImageParams(DrawableParams{ trigParams.TextureOverdubbing }, SizeableParams{ trigParams.Size,trigParams.MinSize }, "texture", trigParams.Rot90, trigParams.FlipH, trigParams.FlipV)),
 	_texturePunchedIn(ImageParams(DrawableParams{ trigParams.TexturePunchedIn }, SizeableParams{ trigParams.Size,trigParams.MinSize }, "texture", trigParams.Rot90, trigParams.FlipH, trigParams.FlipV)),
-	_loopTakeHistory({}),
+	_loopTakeHistory(),
 	_overdubMixer(std::shared_ptr<audio::AudioMixer>()),
 	_delayedActions({}),
-	_delayedTriggerActions({})
+	_delayedTriggerActions({}),
+	_blockLevelChanges(),
+	_levelBlockStart(0u),
+	_levelSegments(),
+	_numLevelSegments(0u),
+	_numLevelSamps(0u),
+	_levelRamp()
 {
 	_overdubMixer = std::make_shared<AudioMixer>(
 		GetOverdubMixerParams(trigParams.InputChannels));
+	_blockLevelChanges.reserve(MaxBlockLevelChanges);
 }
 
 Trigger::~Trigger()
@@ -298,55 +306,55 @@ ActionResult Trigger::OnEvent(TriggerSource source,
 	return res;
 }
 
-void Trigger::OnTick(Time curTime,
+void Trigger::OnTick(std::uint64_t sampleTime,
 	unsigned int samps,
 	std::optional<io::UserConfig> cfg,
 	std::optional<audio::AudioStreamParams> params)
 {
-	bool isRecording = (TriggerState::TRIGSTATE_RECORDING == _state) ||
-		(TriggerState::TRIGSTATE_OVERDUBBING == _state) ||
-		(TriggerState::TRIGSTATE_PUNCHEDIN == _state);
+	auto blockEnd = sampleTime + samps;
+	_sampleClock.store(blockEnd, std::memory_order_relaxed);
 
-	if (isRecording)
-		_recordSampCount.fetch_add(samps, std::memory_order_relaxed);
+	// Anything due in the next block (assumed to be the same size as
+	// this one) goes out now, to land on its sample within that block
+	auto lookaheadEnd = blockEnd + samps;
+	FlushDelayedTriggerActions(lookaheadEnd);
 
-	for (auto& action : _delayedActions)
+	// Eventually flick to new state (if held long enough),
+	// as of the sample at which the debounce window closed
+	if ((0 != _debounceSamps) && (_isLastActivateDownRaw != _isLastActivateDown))
 	{
-		action.OnTick(curTime, samps, cfg, params);
-	}
-
-	FlushDelayedTriggerActions(curTime, samps, cfg, params);
-
-	if (0 == _debounceTimeMs)
-		return;
-
-	// Eventually flick to new state
-	// (if held long enough)
-	auto elapsedMs = Timer::GetElapsedSeconds(_lastActivateTime, curTime) * 1000.0;
+		auto dueSample = _lastActivateSample.has_value() ?
+			_lastActivateSample.value() + _debounceSamps :
+			sampleTime;
 
-	if (_isLastActivateDownRaw != _isLastActivateDown)
-	{
-		if (elapsedMs > _debounceTimeMs)
+		if (dueSample < lookaheadEnd)
 		{
-			_lastActivateTime = Timer::GetZero();
+			_lastActivateSample = std::nullopt;
 			_isLastActivateDown = _isLastActivateDownRaw;
 
-			StateMachine(_isLastActivateDownRaw, true, cfg, params);
+			StateMachine(_isLastActivateDownRaw, true, dueSample, cfg, params);
 		}
 	}
 
-	elapsedMs = Timer::GetElapsedSeconds(_lastDitchTime, curTime) * 1000.0;
-	
-	if (_isLastDitchDownRaw != _isLastDitchDown)
+	if ((0 != _debounceSamps) && (_isLastDitchDownRaw != _isLastDitchDown))
 	{
-		if (elapsedMs > _debounceTimeMs)
+		auto dueSample = _lastDitchSample.has_value() ?
+			_lastDitchSample.value() + _debounceSamps :
+			sampleTime;
+
+		if (dueSample < lookaheadEnd)
 		{
-			_lastDitchTime = Timer::GetZero();
+			_lastDitchSample = std::nullopt;
 			_isLastDitchDown = _isLastDitchDownRaw;
 
-			StateMachine(_isLastDitchDownRaw, false, cfg, params);
+			StateMachine(_isLastDitchDownRaw, false, dueSample, cfg, params);
 		}
 	}
+
+	// After the state machine, so level changes it has just queued for
+	// the next block are in the snapshot
+	BeginLevelBlock(blockEnd);
+	TakeBlockLevelChanges(lookaheadEnd);
 }
 
 void Trigger::Draw(base::DrawContext& ctx)
@@ -461,10 +469,13 @@ void Trigger::Reset()
 		b.Reset();
 
 	_state = TriggerState::TRIGSTATE_DEFAULT;
-	_recordSampCount = 0;
-	_loopTakeHistory.clear();
+	_recordStartSample = _sampleClock.load(std::memory_order_relaxed);
+	_loopTakeHistory.Clear();
 	_delayedActions.clear();
 	_delayedTriggerActions.clear();
+	_blockLevelChanges.clear();
+	_numLevelSegments = 0u;
+	_numLevelSamps = 0u;
 }
 
 std::string Trigger::Name() const
@@ -477,9 +488,19 @@ void Trigger::SetName(std::string name)
 	_name = name;
 }
 
-std::vector<TriggerTake> Trigger::GetTakes() const
+void Trigger::CommitTakes()
 {
-	return _loopTakeHistory;
+	_loopTakeHistory.Commit();
+}
+
+std::shared_ptr<const TakeHistory::TakeList> Trigger::GetTakes() const
+{
+	return _loopTakeHistory.Snapshot();
+}
+
+unsigned int Trigger::TakesVersion() const noexcept
+{
+	return _loopTakeHistory.Version();
 }
 
 void Trigger::WriteBlock(const std::shared_ptr<MultiAudioSink> dest,
@@ -487,39 +508,132 @@ void Trigger::WriteBlock(const std::shared_ptr<MultiAudioSink> dest,
 	unsigned int numSamps,
 	unsigned int destChannel)
 {
-	for (auto& action : _delayedActions)
+	if (!_overdubMixer)
+		return;
+
+	auto blockStart = _sampleClock.load(std::memory_order_relaxed);
+
+	// No tick since the last block, so start the block here
+	if (blockStart != _levelBlockStart)
+		BeginLevelBlock(blockStart);
+
+	// Changes queued since the tick still make it in, as long as
+	// nothing in the block has been written yet
+	if (0u == _numLevelSamps)
+		TakeBlockLevelChanges(blockStart + numSamps);
+
+	PlanBlockLevels(numSamps);
+
+	if ((nullptr == dest) || (nullptr == srcBuf))
+		return;
+
+	auto sampsDone = 0u;
+
+	// Write the block in segments, split wherever a delayed
+	// level change falls due
+	for (auto i = 0u; (i < _numLevelSegments) && (sampsDone < numSamps); i++)
 	{
-		if (action.SampsLeft(0) == 0)
+		const auto& segment = _levelSegments[i];
+		auto segmentEnd = std::min(segment.End, numSamps);
+
+		base::AudioWriteRequest request;
+		request.samples = srcBuf + sampsDone;
+		request.numSamps = segmentEnd - sampsDone;
+		request.stride = 1;
+		request.source = base::Audible::AUDIOSOURCE_BOUNCE;
+
+		if (segment.IsRamped)
 		{
-			auto val = action.GetTarget();
-			_overdubMixer->SetUnmutedLevel(val);
+			request.fadeCurrent = 1.0f;
+			request.fadeNew = 1.0f;
+			request.fadeRamp = _levelRamp.data() + sampsDone;
+			request.fadeCurrentRamp = -1.0f;
 		}
+		else
+		{
+			request.fadeCurrent = 1.0f - segment.Level;
+			request.fadeNew = segment.Level;
+		}
+
+		dest->OnBlockWriteChannel(destChannel, request, static_cast<int>(sampsDone));
+		sampsDone = segmentEnd;
 	}
+}
 
-	// Erase expired actions in-place (no heap allocation)
-	_delayedActions.erase(
-		std::remove_if(_delayedActions.begin(), _delayedActions.end(),
-			[](DelayedAction& action) { return action.SampsLeft(0) == 0; }),
-		_delayedActions.end());
+void Trigger::BeginLevelBlock(std::uint64_t blockStart)
+{
+	_levelBlockStart = blockStart;
+	_numLevelSegments = 0u;
+	_numLevelSamps = 0u;
+}
 
-	if ((nullptr == dest) || (nullptr == srcBuf) || !_overdubMixer)
-		return;
+void Trigger::TakeBlockLevelChanges(std::uint64_t blockEnd)
+{
+	// Moved in order, so changes due on the same sample apply as queued
+	auto action = _delayedActions.begin();
+	while (action != _delayedActions.end())
+	{
+		if ((action->DueSample() >= blockEnd) || (_blockLevelChanges.size() >= MaxBlockLevelChanges))
+		{
+			++action;
+			continue;
+		}
 
-	base::AudioWriteRequest request;
-	request.samples = srcBuf;
-	request.numSamps = numSamps;
-	request.stride = 1;
-	request.fadeCurrent = 1.0f - static_cast<float>(_overdubMixer->Level());
-	request.fadeNew = static_cast<float>(_overdubMixer->Level());
-	request.source = base::Audible::AUDIOSOURCE_BOUNCE;
+		_blockLevelChanges.push_back(*action);
+		action = _delayedActions.erase(action);
+	}
+}
 
-	dest->OnBlockWriteChannel(destChannel, request, 0);
-	_overdubMixer->Offset(numSamps);
+void Trigger::PlanBlockLevels(unsigned int numSamps)
+{
+	while ((_numLevelSamps < numSamps) && (_numLevelSegments < _levelSegments.size()))
+	{
+		auto sampsDone = _numLevelSamps;
+		auto segmentEnd = numSamps;
+
+		for (const auto& action : _blockLevelChanges)
+		{
+			auto offset = action.SampsLeft(_levelBlockStart);
+
+			if (offset <= sampsDone)
+				_overdubMixer->SetUnmutedLevel(action.GetTarget());
+			else if (offset < segmentEnd)
+				segmentEnd = offset;
+		}
+
+		// Erase applied actions in-place (no heap allocation)
+		auto blockStart = _levelBlockStart;
+		_blockLevelChanges.erase(
+			std::remove_if(_blockLevelChanges.begin(), _blockLevelChanges.end(),
+				[blockStart, sampsDone](const DelayedAction& action) { return action.SampsLeft(blockStart) <= sampsDone; }),
+			_blockLevelChanges.end());
+
+		// The last segment takes whatever is left of the block
+		if (_numLevelSegments + 1u == _levelSegments.size())
+			segmentEnd = numSamps;
+
+		auto segmentSamps = segmentEnd - sampsDone;
+		auto& segment = _levelSegments[_numLevelSegments];
+		segment.End = segmentEnd;
+		segment.Level = static_cast<float>(_overdubMixer->Level());
+
+		// Past MaxBlockSize the ramp has nowhere to go, so the segment
+		// holds the level it fades to
+		auto overdubRamp = _overdubMixer->FadeRamp(segmentSamps);
+		segment.IsRamped = (nullptr != overdubRamp) && (segmentEnd <= _levelRamp.size());
+		if (segment.IsRamped)
+			std::copy_n(overdubRamp, segmentSamps, _levelRamp.data() + sampsDone);
+		else if (nullptr != overdubRamp)
+			segment.Level = static_cast<float>(_overdubMixer->Level());
+
+		_numLevelSegments++;
+		_numLevelSamps = segmentEnd;
+	}
 }
 
-void Trigger::QueueTriggerAction(const TriggerAction& action, unsigned int sampsDelay)
+void Trigger::QueueTriggerAction(const TriggerAction& action, std::uint64_t dueSample)
 {
-	_delayedTriggerActions.push_back({ action, sampsDelay });
+	_delayedTriggerActions.push_back({ action, dueSample });
 }
 
 void Trigger::DispatchTriggerAction(const TriggerAction& action)
@@ -530,29 +644,20 @@ void Trigger::DispatchTriggerAction(const TriggerAction& action)
 	auto res = _receiver->OnAction(action);
 	if ((TriggerAction::TRIGGER_OVERDUB_START == action.ActionType) && res.IsEaten)
 	{
-		TriggerTake newTake = { TriggerTake::SOURCE_ADC, res.SourceId, res.TargetId };
-		_loopTakeHistory.push_back(newTake);
+		_AddTake({ TriggerTake::SOURCE_ADC, res.SourceId, res.TargetId });
 	}
 }
 
-void Trigger::FlushDelayedTriggerActions(Time curTime,
-	unsigned int samps,
-	std::optional<io::UserConfig> cfg,
-	std::optional<audio::AudioStreamParams> params)
+void Trigger::FlushDelayedTriggerActions(std::uint64_t lookaheadEnd)
 {
-	for (auto& action : _delayedTriggerActions)
-	{
-		if (samps >= action.SampsLeft)
-			action.SampsLeft = 0u;
-		else
-			action.SampsLeft -= samps;
-	}
-
 	auto readyEnd = std::stable_partition(_delayedTriggerActions.begin(),
 		_delayedTriggerActions.end(),
-		[](const DelayedTriggerAction& action) { return action.SampsLeft > 0u; });
+		[lookaheadEnd](const DelayedTriggerAction& action) { return action.DueSample >= lookaheadEnd; });
 	for (auto it = readyEnd; it != _delayedTriggerActions.end(); ++it)
+	{
+		it->Action.BlockOffset = BlockOffset(it->DueSample);
 		DispatchTriggerAction(it->Action);
+	}
 	_delayedTriggerActions.erase(readyEnd, _delayedTriggerActions.end());
 }
 
@@ -580,21 +685,23 @@ bool Trigger::IgnoreRepeats(bool isActivate, DualBinding::TestResult trigResult)
 
 bool Trigger::Debounce(bool isActivate,
 	DualBinding::TestResult trigResult,
-	Time actionTime)
+	std::uint64_t actionSample)
 {
 	auto allowedThrough = false;
 
 	if (isActivate)
 	{
-		auto isDebounceBypassed = Timer::IsZero(_lastActivateTime) || (0 == _debounceTimeMs);
-		auto elapsedMs = Timer::GetElapsedSeconds(_lastActivateTime, actionTime) * 1000.0;
+		auto isDebounceBypassed = !_lastActivateSample.has_value() || (0 == _debounceSamps);
+		auto elapsedSamps = isDebounceBypassed || (actionSample < _lastActivateSample.value()) ?
+			0u :
+			actionSample - _lastActivateSample.value();
 
 		if ((DualBinding::MATCH_DOWN == trigResult) && !_isLastActivateDownRaw)
 		{
-			_lastActivateTime = actionTime;
+			_lastActivateSample = actionSample;
 			_isLastActivateDownRaw = true;
 
-			if (isDebounceBypassed || (elapsedMs > _debounceTimeMs))
+			if (isDebounceBypassed || (elapsedSamps >= _debounceSamps))
 			{
 				allowedThrough = true;
 				_isLastActivateDown = true;
@@ -602,10 +709,10 @@ bool Trigger::Debounce(bool isActivate,
 		}
 		else if ((DualBinding::MATCH_RELEASE == trigResult) && _isLastActivateDownRaw)
 		{
-			_lastActivateTime = actionTime;
+			_lastActivateSample = actionSample;
 			_isLastActivateDownRaw = false;
 
-			if (isDebounceBypassed || (elapsedMs > _debounceTimeMs))
+			if (isDebounceBypassed || (elapsedSamps >= _debounceSamps))
 			{
 				allowedThrough = true;
 				_isLastActivateDown = false;
@@ -614,15 +721,17 @@ bool Trigger::Debounce(bool isActivate,
 	}
 	else
 	{
-		auto isDebounceBypassed = Timer::IsZero(_lastDitchTime) || (0 == _debounceTimeMs);
-		auto elapsedMs = Timer::GetElapsedSeconds(_lastDitchTime, actionTime) * 1000.0;
+		auto isDebounceBypassed = !_lastDitchSample.has_value() || (0 == _debounceSamps);
+		auto elapsedSamps = isDebounceBypassed || (actionSample < _lastDitchSample.value()) ?
+			0u :
+			actionSample - _lastDitchSample.value();
 
 		if ((DualBinding::MATCH_DOWN == trigResult) && !_isLastDitchDownRaw)
 		{
-			_lastDitchTime = actionTime;
+			_lastDitchSample = actionSample;
 			_isLastDitchDownRaw = true;
 
-			if (isDebounceBypassed || (elapsedMs > _debounceTimeMs))
+			if (isDebounceBypassed || (elapsedSamps >= _debounceSamps))
 			{
 				allowedThrough = true;
 				_isLastDitchDown = true;
@@ -630,10 +739,10 @@ bool Trigger::Debounce(bool isActivate,
 		}
 		else if ((DualBinding::MATCH_RELEASE == trigResult) && _isLastDitchDownRaw)
 		{
-			_lastDitchTime = actionTime;
+			_lastDitchSample = actionSample;
 			_isLastDitchDownRaw = false;
 
-			if (isDebounceBypassed || (elapsedMs > _debounceTimeMs))
+			if (isDebounceBypassed || (elapsedSamps >= _debounceSamps))
 			{
 				allowedThrough = true;
 				_isLastDitchDown = false;
@@ -664,9 +773,10 @@ bool Trigger::TryChangeState(DualBinding& binding,
 		return false;
 	}
 
+	auto actionSample = ActionSample(action);
 	allowedThrough = Debounce(isActivate,
 		trigResult,
-		action.GetActionTime());
+		actionSample);
 
 	if (!allowedThrough)
 	{
@@ -676,10 +786,10 @@ bool Trigger::TryChangeState(DualBinding& binding,
 	switch (trigResult)
 	{
 	case DualBinding::MATCH_DOWN:
-		StateMachine(true, isActivate, action.GetUserConfig(), action.GetAudioParams());
+		StateMachine(true, isActivate, actionSample, action.GetUserConfig(), action.GetAudioParams());
 		return true;
 	case DualBinding::MATCH_RELEASE:
-		StateMachine(false, isActivate, action.GetUserConfig(), action.GetAudioParams());
+		StateMachine(false, isActivate, actionSample, action.GetUserConfig(), action.GetAudioParams());
 		return true;
 	}
 
@@ -688,6 +798,7 @@ bool Trigger::TryChangeState(DualBinding& binding,
 
 bool Trigger::StateMachine(bool isDown,
 	bool isActivate,
+	std::uint64_t sampleTime,
 	std::optional<io::UserConfig> cfg,
 	std::optional<audio::AudioStreamParams> params)
 {
@@ -702,7 +813,7 @@ bool Trigger::StateMachine(bool isDown,
 			{
 				if (_isDitchDown)
 				{
-					StartOverdub(cfg, params);
+					StartOverdub(sampleTime, cfg, params);
 					_isDitchDown = false; // Prevent next release ditching the playing loop
 					_isLastDitchDownRaw = false;
 					_isLastDitchDown = false;
@@ -710,7 +821,7 @@ bool Trigger::StateMachine(bool isDown,
 						binding.Reset();
 				}
 				else
-					StartRecording(cfg, params);
+					StartRecording(sampleTime, cfg, params);
 			}
 
 			changedState = true;
@@ -721,7 +832,7 @@ bool Trigger::StateMachine(bool isDown,
 				_isDitchDown = true;
 			else if (_isDitchDown)
 			{
-				Ditch(cfg, params);
+				Ditch(sampleTime, cfg, params);
 				_isDitchDown = false;
 				changedState = true;
 			}
@@ -732,7 +843,7 @@ bool Trigger::StateMachine(bool isDown,
 		{
 			if (isDown)
 			{
-				EndRecording(cfg, params);
+				EndRecording(sampleTime, cfg, params);
 				_isDitchDown = false; // Prevent next release ditching the playing loop
 				_isLastDitchDownRaw = false;
 				_isLastDitchDown = false;
@@ -747,7 +858,7 @@ bool Trigger::StateMachine(bool isDown,
 				_isDitchDown = true;
 			else if (_isDitchDown)
 			{
-				Ditch(cfg, params);
+				Ditch(sampleTime, cfg, params);
 				_isDitchDown = false;
 				changedState = true;
 			}
@@ -760,7 +871,7 @@ bool Trigger::StateMachine(bool isDown,
 			{
 				if (_isDitchDown)
 				{
-					EndOverdub(cfg, params);
+					EndOverdub(sampleTime, cfg, params);
 					_isDitchDown = false; // Prevent next release ditching the playing loop
 					_isLastDitchDownRaw = false;
 					_isLastDitchDown = false;
@@ -770,7 +881,7 @@ bool Trigger::StateMachine(bool isDown,
 				}
 				else
 				{
-					StartPunchIn(cfg, params);
+					StartPunchIn(sampleTime, cfg, params);
 					changedState = true;
 				}
 			}
@@ -783,7 +894,7 @@ bool Trigger::StateMachine(bool isDown,
 			}
 			else if (_isDitchDown)
 			{
-				Ditch(cfg, params);
+				Ditch(sampleTime, cfg, params);
 				_isDitchDown = false;
 				changedState = true;
 			}
@@ -795,7 +906,7 @@ bool Trigger::StateMachine(bool isDown,
 			if (!isDown)
 			{
 				// End punch-in but maintain overdub mode (release)
-				EndPunchIn(cfg, params);
+				EndPunchIn(sampleTime, cfg, params);
 				changedState = true;
 			}
 		}
@@ -813,14 +924,15 @@ bool Trigger::StateMachine(bool isDown,
 	return changedState;
 }
 
-void Trigger::StartRecording(std::optional<io::UserConfig> cfg,
+void Trigger::StartRecording(std::uint64_t sampleTime,
+	std::optional<io::UserConfig> cfg,
 	std::optional<audio::AudioStreamParams> params)
 {
 	_state = TRIGSTATE_RECORDING;
 
 	std::cout << "~~~~ Trigger RECORDING" << std::endl;
 
-	_recordSampCount = 0;
+	_recordStartSample.store(sampleTime, std::memory_order_relaxed);
 	_delayedActions.clear();
 
 	if (_receiver)
@@ -843,27 +955,28 @@ void Trigger::StartRecording(std::optional<io::UserConfig> cfg,
 
 		if (res.IsEaten)
 		{
-			TriggerTake newTake = { TriggerTake::SOURCE_ADC, res.SourceId, res.TargetId };
-			_loopTakeHistory.push_back(newTake);
+			_AddTake({ TriggerTake::SOURCE_ADC, res.SourceId, res.TargetId });
 		}
 	}
 }
 
-void Trigger::EndRecording(std::optional<io::UserConfig> cfg,
+void Trigger::EndRecording(std::uint64_t sampleTime,
+	std::optional<io::UserConfig> cfg,
 	std::optional<audio::AudioStreamParams> params)
 {
 	_state = TRIGSTATE_DEFAULT;
 
 	std::cout << "~~~~ Trigger END RECORDING" << std::endl;
 
-	if ((_receiver) && !_loopTakeHistory.empty())
+	if ((_receiver) && !_loopTakeHistory.IsEmpty())
 	{
-		auto lastTake = _loopTakeHistory.back();
+		const auto& lastTake = _loopTakeHistory.Back();
 
 		TriggerAction trigAction;
 		trigAction.ActionType = TriggerAction::TRIGGER_REC_END;
 		trigAction.TargetId = lastTake.TargetTakeId;
-		trigAction.SampleCount = _recordSampCount;
+		trigAction.SampleCount = RecordSampCount(sampleTime);
+		trigAction.BlockOffset = BlockOffset(sampleTime);
 
 		if (cfg.has_value())
 			trigAction.SetUserConfig(cfg.value());
@@ -877,7 +990,8 @@ void Trigger::EndRecording(std::optional<io::UserConfig> cfg,
 	}
 }
 
-void Trigger::Ditch(std::optional<io::UserConfig> cfg,
+void Trigger::Ditch(std::uint64_t sampleTime,
+	std::optional<io::UserConfig> cfg,
 	std::optional<audio::AudioStreamParams> params)
 {
 	_state = TRIGSTATE_DEFAULT;
@@ -885,21 +999,21 @@ void Trigger::Ditch(std::optional<io::UserConfig> cfg,
 	std::cout << "~~~~ Trigger DITCH" << std::endl;
 
 	_delayedActions.clear();
-	auto popBack = !_loopTakeHistory.empty();
+	auto popBack = !_loopTakeHistory.IsEmpty();
 
 	if ((_receiver) && popBack)
 	{
-		auto lastTake = _loopTakeHistory.back();
+		const auto& lastTake = _loopTakeHistory.Back();
 
 		TriggerAction ditchAction;
 		ditchAction.ActionType = TriggerAction::TRIGGER_DITCH;
 		ditchAction.TargetId = lastTake.TargetTakeId;
-		ditchAction.SampleCount = _recordSampCount;
+		ditchAction.SampleCount = RecordSampCount(sampleTime);
 
 		TriggerAction unmuteAction;
 		unmuteAction.ActionType = TriggerAction::TRIGGER_DITCH_UNMUTE;
 		unmuteAction.TargetId = lastTake.SourceTakeId;
-		unmuteAction.SampleCount = _recordSampCount;
+		unmuteAction.SampleCount = RecordSampCount(sampleTime);
 
 		if (cfg.has_value())
 		{
@@ -918,17 +1032,18 @@ void Trigger::Ditch(std::optional<io::UserConfig> cfg,
 	}
 
 	if (popBack)
-		_loopTakeHistory.pop_back();
+		_loopTakeHistory.Pop();
 }
 
-void Trigger::StartOverdub(std::optional<io::UserConfig> cfg,
+void Trigger::StartOverdub(std::uint64_t sampleTime,
+	std::optional<io::UserConfig> cfg,
 	std::optional<audio::AudioStreamParams> params)
 {
 	_state = TRIGSTATE_OVERDUBBING;
 
 	std::cout << "~~~~ Trigger START OVERDUB" << std::endl;
 
-	_recordSampCount = 0;
+	_recordStartSample.store(sampleTime, std::memory_order_relaxed);
 	_delayedActions.clear();
 	_delayedTriggerActions.clear();
 	_overdubMixer->SetUnmutedLevel(1.0);
@@ -951,22 +1066,24 @@ void Trigger::StartOverdub(std::optional<io::UserConfig> cfg,
 	}
 }
 
-void Trigger::EndOverdub(std::optional<io::UserConfig> cfg,
+void Trigger::EndOverdub(std::uint64_t sampleTime,
+	std::optional<io::UserConfig> cfg,
 	std::optional<audio::AudioStreamParams> params)
 {
 	_state = TRIGSTATE_DEFAULT;
 
 	std::cout << "~~~~ Trigger END OVERDUB" << std::endl;
 
-	if ((_receiver) && !_loopTakeHistory.empty())
+	if ((_receiver) && !_loopTakeHistory.IsEmpty())
 	{
-		auto lastTake = _loopTakeHistory.back();
+		const auto& lastTake = _loopTakeHistory.Back();
 
 		TriggerAction trigAction;
 		trigAction.ActionType = TriggerAction::TRIGGER_OVERDUB_END;
 		trigAction.SourceId = lastTake.SourceTakeId;
 		trigAction.TargetId = lastTake.TargetTakeId;
-		trigAction.SampleCount = _recordSampCount;
+		trigAction.SampleCount = RecordSampCount(sampleTime);
+		trigAction.BlockOffset = BlockOffset(sampleTime);
 
 		if (cfg.has_value())
 			trigAction.SetUserConfig(cfg.value());
@@ -978,7 +1095,8 @@ void Trigger::EndOverdub(std::optional<io::UserConfig> cfg,
 	}
 }
 
-void Trigger::DitchOverdub(std::optional<io::UserConfig> cfg,
+void Trigger::DitchOverdub(std::uint64_t sampleTime,
+	std::optional<io::UserConfig> cfg,
 	std::optional<audio::AudioStreamParams> params)
 {
 	_state = TRIGSTATE_DEFAULT;
@@ -987,15 +1105,15 @@ void Trigger::DitchOverdub(std::optional<io::UserConfig> cfg,
 
 	_delayedActions.clear();
 	_delayedTriggerActions.clear();
-	auto popBack = !_loopTakeHistory.empty();
+	auto popBack = !_loopTakeHistory.IsEmpty();
 
 	if ((_receiver) && popBack)
 	{
-		auto lastTake = _loopTakeHistory.back();
+		const auto& lastTake = _loopTakeHistory.Back();
 		TriggerAction trigAction;
 		trigAction.ActionType = TriggerAction::TRIGGER_OVERDUB_DITCH;
 		trigAction.TargetId = lastTake.TargetTakeId;
-		trigAction.SampleCount = _recordSampCount;
+		trigAction.SampleCount = RecordSampCount(sampleTime);
 
 		if (cfg.has_value())
 			trigAction.SetUserConfig(cfg.value());
@@ -1007,10 +1125,11 @@ void Trigger::DitchOverdub(std::optional<io::UserConfig> cfg,
 	}
 
 	if (popBack)
-		_loopTakeHistory.pop_back();
+		_loopTakeHistory.Pop();
 }
 
-void Trigger::StartPunchIn(std::optional<io::UserConfig> cfg,
+void Trigger::StartPunchIn(std::uint64_t sampleTime,
+	std::optional<io::UserConfig> cfg,
 	std::optional<audio::AudioStreamParams> params)
 {
 	_state = TRIGSTATE_PUNCHEDIN;
@@ -1022,11 +1141,11 @@ void Trigger::StartPunchIn(std::optional<io::UserConfig> cfg,
 	if (sampsDelay == 0u)
 		_overdubMixer->SetUnmutedLevel(0.0);
 	else
-		_delayedActions.push_back(DelayedAction(sampsDelay, 0.0));
+		_delayedActions.push_back(DelayedAction(sampleTime + sampsDelay, 0.0));
 
-	if ((_receiver) && !_loopTakeHistory.empty())
+	if ((_receiver) && !_loopTakeHistory.IsEmpty())
 	{
-		auto lastTake = _loopTakeHistory.back();
+		const auto& lastTake = _loopTakeHistory.Back();
 		const auto hasTargetAudio = _midiInputChannels.empty() || !_inputChannels.empty();
 		const auto hasTargetMidi = !_midiInputChannels.empty();
 
@@ -1034,7 +1153,8 @@ void Trigger::StartPunchIn(std::optional<io::UserConfig> cfg,
 		sourceAction.ActionType = TriggerAction::TRIGGER_PUNCHIN_START;
 		sourceAction.SourceId = lastTake.SourceTakeId;
 		sourceAction.TargetId = lastTake.TargetTakeId;
-		sourceAction.SampleCount = _recordSampCount;
+		sourceAction.SampleCount = RecordSampCount(sampleTime);
+		sourceAction.BlockOffset = BlockOffset(sampleTime);
 		sourceAction.ApplyToTargetTake = false;
 		sourceAction.ApplyToSourceTake = true;
 
@@ -1069,12 +1189,13 @@ void Trigger::StartPunchIn(std::optional<io::UserConfig> cfg,
 		}
 		else
 		{
-			QueueTriggerAction(targetAction, targetDelay);
+			QueueTriggerAction(targetAction, sampleTime + targetDelay);
 		}
 	}
 }
 
-void Trigger::EndPunchIn(std::optional<io::UserConfig> cfg,
+void Trigger::EndPunchIn(std::uint64_t sampleTime,
+	std::optional<io::UserConfig> cfg,
 	std::optional<audio::AudioStreamParams> params)
 {
 	_state = TRIGSTATE_OVERDUBBING;
@@ -1086,11 +1207,11 @@ void Trigger::EndPunchIn(std::optional<io::UserConfig> cfg,
 	if (sampsDelay == 0u)
 		_overdubMixer->SetUnmutedLevel(1.0);
 	else
-		_delayedActions.push_back(DelayedAction(sampsDelay, 1.0));
+		_delayedActions.push_back(DelayedAction(sampleTime + sampsDelay, 1.0));
 
-	if ((_receiver) && !_loopTakeHistory.empty())
+	if ((_receiver) && !_loopTakeHistory.IsEmpty())
 	{
-		auto lastTake = _loopTakeHistory.back();
+		const auto& lastTake = _loopTakeHistory.Back();
 		const auto hasTargetAudio = _midiInputChannels.empty() || !_inputChannels.empty();
 		const auto hasTargetMidi = !_midiInputChannels.empty();
 
@@ -1098,7 +1219,8 @@ void Trigger::EndPunchIn(std::optional<io::UserConfig> cfg,
 		sourceAction.ActionType = TriggerAction::TRIGGER_PUNCHIN_END;
 		sourceAction.SourceId = lastTake.SourceTakeId;
 		sourceAction.TargetId = lastTake.TargetTakeId;
-		sourceAction.SampleCount = _recordSampCount;
+		sourceAction.SampleCount = RecordSampCount(sampleTime);
+		sourceAction.BlockOffset = BlockOffset(sampleTime);
 		sourceAction.ApplyToTargetTake = false;
 		sourceAction.ApplyToSourceTake = true;
 
@@ -1133,11 +1255,38 @@ void Trigger::EndPunchIn(std::optional<io::UserConfig> cfg,
 		}
 		else
 		{
-			QueueTriggerAction(targetAction, targetDelay);
+			QueueTriggerAction(targetAction, sampleTime + targetDelay);
 		}
 	}
 }
 
+std::uint64_t Trigger::ActionSample(const base::Action& action) const
+{
+	auto sampleTime = action.GetSampleTime();
+
+	return sampleTime.has_value() ?
+		sampleTime.value() :
+		_sampleClock.load(std::memory_order_relaxed);
+}
+
+unsigned int Trigger::BlockOffset(std::uint64_t sampleTime) const
+{
+	auto blockStart = _sampleClock.load(std::memory_order_relaxed);
+
+	return sampleTime > blockStart ?
+		static_cast<unsigned int>(sampleTime - blockStart) :
+		0u;
+}
+
+unsigned long Trigger::RecordSampCount(std::uint64_t sampleTime) const
+{
+	auto startSample = _recordStartSample.load(std::memory_order_relaxed);
+
+	return sampleTime > startSample ?
+		static_cast<unsigned long>(sampleTime - startSample) :
+		0ul;
+}
+
 unsigned int Trigger::CalcInputAlignedDelaySamps(std::optional<io::UserConfig> cfg,
 	std::optional<audio::AudioStreamParams> params) const
 {
@@ -1193,3 +1342,8 @@ void Trigger::_UpdateBehaviour()
 		std::move(std::make_unique<audio::BounceMixBehaviour>(
 			GetOverdubBehaviourParams(_inputChannels))));
 }
+
+void Trigger::_AddTake(const TriggerTake& take)
+{
+	_loopTakeHistory.Push(take);
+}
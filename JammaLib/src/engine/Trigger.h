@@ -1,14 +1,16 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
 #include <atomic>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <optional>
 #include "ActionReceiver.h"
 #include "GuiElement.h"
 #include "Tickable.h"
-#include "../utils/Timer.h"
+#include "TakeHistory.h"
 #include "../midi/MidiEvent.h"
 #include "../actions/KeyAction.h"
 #include "../actions/TriggerAction.h"
@@ -16,22 +18,10 @@
 #include "../actions/DelayedAction.h"
 #include "../audio/AudioMixer.h"
 #include "../io/RigFile.h"
+#include "../../include/Constants.h"
 
 namespace engine
 {
-	struct TriggerTake
-	{
-		enum SourceType
-		{
-			SOURCE_ADC,
-			SOURCE_LOOPTAKE,
-			SOURCE_STATION
-		};
-		SourceType SourceType;
-		std::string SourceTakeId;
-		std::string TargetTakeId;
-	};
-
 	enum TriggerSource
 	{
 		TRIGGER_NOTSET,
@@ -228,7 +218,7 @@ namespace engine
 		std::string TextureDitchDown;
 		std::string TextureOverdubbing;
 		std::string TexturePunchedIn;
-		unsigned int DebounceMs = 0u;
+		unsigned int DebounceSamps = 0u;
 	};
 
 	enum TriggerState
@@ -242,13 +232,25 @@ namespace engine
 	struct DelayedTriggerAction
 	{
 		actions::TriggerAction Action;
-		unsigned int SampsLeft;
+		std::uint64_t DueSample;
+	};
+
+	// A stretch of the block written at one overdub level, or along the
+	// fade ramp from where the last one ended
+	struct OverdubLevelSegment
+	{
+		unsigned int End;
+		float Level;
+		bool IsRamped;
 	};
 	
 	class Trigger :
 		public base::Tickable,
 		public base::GuiElement
 	{
+	public:
+		static constexpr unsigned int MaxBlockLevelChanges = 8u;
+
 	public:
 		Trigger(TriggerParams trigParams);
 		~Trigger();
@@ -269,7 +271,7 @@ namespace engine
 			unsigned int state,
 			const base::Action& action,
 			const std::string& device = "");
-		virtual void OnTick(Time curTime,
+		virtual void OnTick(std::uint64_t sampleTime,
 			unsigned int samps,
 			std::optional<io::UserConfig> cfg,
 			std::optional<audio::AudioStreamParams> params) override;
@@ -289,7 +291,19 @@ namespace engine
 		void Reset();
 		std::string Name() const;
 		void SetName(std::string name);
-		std::vector<TriggerTake> GetTakes() const;
+		// Publishes take history changes made since the last call. UI
+		// thread, before reading GetTakes().
+		void CommitTakes();
+		// The last committed take history. Not for the audio thread.
+		std::shared_ptr<const TakeHistory::TakeList> GetTakes() const;
+		// Bumped whenever CommitTakes() publishes a change, so owners can
+		// tell when anything derived from GetTakes() needs rebuilding.
+		unsigned int TakesVersion() const noexcept;
+		// Delayed level changes take effect at their exact sample within
+		// the block, which is taken to start where the last tick ended.
+		// The level across the block is worked out by the first call, so
+		// every loop written through this trigger in the block switches
+		// on the same sample.
 		void WriteBlock(const std::shared_ptr<base::MultiAudioSink> dest,
 			const float* srcBuf,
 			unsigned int numSamps,
@@ -300,6 +314,7 @@ namespace engine
 		virtual void _ReleaseResources() override;
 
 		void _UpdateBehaviour();
+		void _AddTake(const TriggerTake& take);
 
 	private:
 		static bool TryEncodeMidiEvent(const midi::MidiEvent& event,
@@ -309,7 +324,7 @@ namespace engine
 			DualBinding::TestResult trigResult);
 		bool Debounce(bool isActivate,
 			DualBinding::TestResult trigResult,
-			Time acionTime);
+			std::uint64_t actionSample);
 		bool TryChangeState(DualBinding& binding,
 			bool isActivate,
 			TriggerSource source,
@@ -319,33 +334,46 @@ namespace engine
 			const std::string& device);
 		bool StateMachine(bool isDown,
 			bool isActivate,
+			std::uint64_t sampleTime,
 			std::optional<io::UserConfig> cfg,
 			std::optional<audio::AudioStreamParams> params);
 
 		// Only call from state machine
-		void StartRecording(std::optional<io::UserConfig> cfg, std::optional<audio::AudioStreamParams> params);
-		void EndRecording(std::optional<io::UserConfig> cfg, std::optional<audio::AudioStreamParams> params);
+		void StartRecording(std::uint64_t sampleTime, std::optional<io::UserConfig> cfg, std::optional<audio::AudioStreamParams> params);
+		void EndRecording(std::uint64_t sampleTime, std::optional<io::UserConfig> cfg, std::optional<audio::AudioStreamParams> params);
 		void SetDitchDown(std::optional<io::UserConfig> cfg, std::optional<audio::AudioStreamParams> params);
 		void SetDitchUp(std::optional<io::UserConfig> cfg, std::optional<audio::AudioStreamParams> params);
-		void Ditch(std::optional<io::UserConfig> cfg, std::optional<audio::AudioStreamParams> params);
-		void StartOverdub(std::optional<io::UserConfig> cfg, std::optional<audio::AudioStreamParams> params);
-		void EndOverdub(std::optional<io::UserConfig> cfg, std::optional<audio::AudioStreamParams> params);
-		void DitchOverdub(std::optional<io::UserConfig> cfg, std::optional<audio::AudioStreamParams> params);
-		void StartPunchIn(std::optional<io::UserConfig> cfg, std::optional<audio::AudioStreamParams> params);
-		void EndPunchIn(std::optional<io::UserConfig> cfg, std::optional<audio::AudioStreamParams> params);
+		void Ditch(std::uint64_t sampleTime, std::optional<io::UserConfig> cfg, std::optional<audio::AudioStreamParams> params);
+		void StartOverdub(std::uint64_t sampleTime, std::optional<io::UserConfig> cfg, std::optional<audio::AudioStreamParams> params);
+		void EndOverdub(std::uint64_t sampleTime, std::optional<io::UserConfig> cfg, std::optional<audio::AudioStreamParams> params);
+		void DitchOverdub(std::uint64_t sampleTime, std::optional<io::UserConfig> cfg, std::optional<audio::AudioStreamParams> params);
+		void StartPunchIn(std::uint64_t sampleTime, std::optional<io::UserConfig> cfg, std::optional<audio::AudioStreamParams> params);
+		void EndPunchIn(std::uint64_t sampleTime, std::optional<io::UserConfig> cfg, std::optional<audio::AudioStreamParams> params);
 		unsigned int CalcInputAlignedDelaySamps(std::optional<io::UserConfig> cfg,
 			std::optional<audio::AudioStreamParams> params) const;
 		unsigned int CalcPunchStateDelaySamps(std::optional<io::UserConfig> cfg) const;
-		void QueueTriggerAction(const actions::TriggerAction& action, unsigned int sampsDelay);
+		void QueueTriggerAction(const actions::TriggerAction& action, std::uint64_t dueSample);
 		void DispatchTriggerAction(const actions::TriggerAction& action);
-		void FlushDelayedTriggerActions(Time curTime,
-			unsigned int samps,
-			std::optional<io::UserConfig> cfg,
-			std::optional<audio::AudioStreamParams> params);
+		// Dispatches queued actions due before lookaheadEnd, each set to
+		// land at its own offset into the next block
+		void FlushDelayedTriggerActions(std::uint64_t lookaheadEnd);
+		// Starts a new block of overdub levels, keeping any level changes
+		// the last block did not reach
+		void BeginLevelBlock(std::uint64_t blockStart);
+		// Moves level changes due before blockEnd into the block's snapshot
+		void TakeBlockLevelChanges(std::uint64_t blockEnd);
+		// Works out the overdub level for the block up to numSamps
+		void PlanBlockLevels(unsigned int numSamps);
+		// Engine sample of an incoming action, falling back to the start
+		// of the next block for actions that were not stamped
+		std::uint64_t ActionSample(const base::Action& action) const;
+		// Offset into the next block of sampleTime, 0 if already past
+		unsigned int BlockOffset(std::uint64_t sampleTime) const;
+		unsigned long RecordSampCount(std::uint64_t sampleTime) const;
 
 	private:
 		std::string _name;
-		double _debounceTimeMs;
+		unsigned int _debounceSamps;
 		std::vector<DualBinding> _activateBindings;
 		std::vector<DualBinding> _ditchBindings;
 		std::vector<unsigned int> _inputChannels;
@@ -353,12 +381,14 @@ namespace engine
 		std::vector<std::string> _midiInputDevices;
 		TriggerState _state;
 		std::string _overdubSourceId;
-		// Written by audio thread (OnTick) and read by event-handler threads
-		// (key/MIDI/serial pumps) during state transitions. Atomic load/store
-		// (relaxed) gives a coherent snapshot without locks on the RT path.
-		std::atomic<unsigned long> _recordSampCount;
-		Time _lastActivateTime;
-		Time _lastDitchTime;
+		// Engine sample at the end of the last tick, i.e. the start of the
+		// next block. Written by audio thread (OnTick) and read by
+		// event-handler threads (key/MIDI/serial pumps) to place actions
+		// that carry no sample time. Relaxed atomics are enough here.
+		std::atomic<std::uint64_t> _sampleClock;
+		std::atomic<std::uint64_t> _recordStartSample;
+		std::optional<std::uint64_t> _lastActivateSample;
+		std::optional<std::uint64_t> _lastDitchSample;
 		bool _isDitchDown;
 		bool _isLastActivateDown;
 		bool _isLastDitchDown;
@@ -368,9 +398,19 @@ namespace engine
 		graphics::Image _textureDitchDown;
 		graphics::Image _textureOverdubbing;
 		graphics::Image _texturePunchedIn;
-		std::vector<TriggerTake> _loopTakeHistory;
+		TakeHistory _loopTakeHistory;
 		std::vector<actions::DelayedAction> _delayedActions;
 		std::vector<DelayedTriggerAction> _delayedTriggerActions;
 		std::shared_ptr<audio::AudioMixer> _overdubMixer;
+		// Level changes due in the block being written, taken in OnTick()
+		// so that later writes in the block see the same ones. Reserved up
+		// front; any past MaxBlockLevelChanges wait for the next block.
+		std::vector<actions::DelayedAction> _blockLevelChanges;
+		std::uint64_t _levelBlockStart;
+		std::array<OverdubLevelSegment, MaxBlockLevelChanges + 1u> _levelSegments;
+		unsigned int _numLevelSegments;
+		// Samples of the block planned so far
+		unsigned int _numLevelSamps;
+		std::array<float, constants::MaxBlockSize> _levelRamp;
 	};
 }
@@ -39,6 +39,7 @@ LoopModel::LoopModel(LoopModelParams params) :
 	_lastWaveformDisplayLength(0ul),
 	_lastWaveformOffset(0ul),
 	_lastWaveformRadius(0.0f),
+	_pendingWaveformChange({ 0ul, 0ul }),
 	_waveformColorScale(1.0f)
 {
 	auto [fixedVerts, fixedUvs] = BuildFixedGeometry(_WaveformSegments, _UnitMeshRadius);
@@ -263,22 +264,34 @@ void LoopModel::UpdateModel(const BufferBank& buffer,
 	unsigned long displayLoopLength,
 	unsigned long offset,
 	float radius,
-	bool allowUnchangedSkip)
+	bool allowUnchangedSkip,
+	std::optional<BufferBank::SampleRange> changed)
 {
 	auto availableSamples = buffer.Length() > offset ? buffer.Length() - offset : 0ul;
 	auto clampedSourceLength = std::min(sourceLoopLength, availableSamples);
 	auto clampedDisplayLength = std::min(displayLoopLength, clampedSourceLength);
 
+	// Changes are held until they are drawn, as updates can be throttled
+	if (changed.has_value() && !changed->IsEmpty())
+	{
+		if (_pendingWaveformChange.IsEmpty())
+			_pendingWaveformChange = changed.value();
+		else
+		{
+			_pendingWaveformChange.Start = std::min(_pendingWaveformChange.Start, changed->Start);
+			_pendingWaveformChange.End = std::max(_pendingWaveformChange.End, changed->End);
+		}
+	}
+
 	auto waveformRadius = std::max(radius, 1.0f);
-	if (allowUnchangedSkip &&
-		_hasWaveformUpdateSignature &&
+	auto isSameLayout = _hasWaveformUpdateSignature &&
 		(clampedSourceLength == _lastWaveformSourceLength) &&
 		(clampedDisplayLength == _lastWaveformDisplayLength) &&
 		(offset == _lastWaveformOffset) &&
-		(std::fabs(waveformRadius - _lastWaveformRadius) <= 0.0001f))
-	{
+		(std::fabs(waveformRadius - _lastWaveformRadius) <= 0.0001f);
+
+	if (allowUnchangedSkip && isSameLayout && _pendingWaveformChange.IsEmpty())
 		return;
-	}
 
 	if (!allowUnchangedSkip && _hasWaveformUpdateSignature)
 	{
@@ -304,13 +317,49 @@ void LoopModel::UpdateModel(const BufferBank& buffer,
 	else
 		std::fill(waveformDecimated.begin(), waveformDecimated.end(), glm::vec2(0.0f, 0.0f));
 
-	if (hasWaveformData)
+	// Same layout and a known set of changes: keep the segments we already
+	// have and only redo those overlapping the changed samples. Short loops
+	// map several segments onto one sample, so just redo them all.
+	auto isPartialUpdate = changed.has_value() &&
+		isSameLayout &&
+		hasWaveformData &&
+		(clampedDisplayLength >= _WaveformSegments);
+
+	if (isPartialUpdate)
+	{
+		auto changeStart = std::max(_pendingWaveformChange.Start, offset);
+		auto changeEnd = std::min(_pendingWaveformChange.End, offset + clampedDisplayLength);
+		_pendingWaveformChange = { 0ul, 0ul };
+
+		if (changeEnd <= changeStart)
+			return;
+
+		{
+			std::lock_guard<std::mutex> waveformLock(_waveformMutex);
+			waveformDecimated = _waveformDecimated;
+		}
+
+		auto segmentCount = static_cast<unsigned long long>(waveformDecimated.size());
+		auto firstSegment = ((changeStart - offset) * segmentCount) / clampedDisplayLength;
+		auto endSegment = (((changeEnd - offset) * segmentCount) / clampedDisplayLength) + 2ull;
+
+		DecimateWaveformRange(buffer,
+			offset,
+			clampedDisplayLength,
+			waveformDecimated,
+			static_cast<unsigned long>(firstSegment > 0ull ? firstSegment - 1ull : 0ull),
+			static_cast<unsigned long>(std::min(endSegment, segmentCount)));
+	}
+	else if (hasWaveformData)
 	{
 		DecimateWaveformInto(buffer,
 			offset,
 			clampedDisplayLength,
 			waveformDecimated);
+	}
 
+	if (hasWaveformData)
+	{
 		auto maxPeakLevel = 0.0f;
 		for (const auto& minMax : waveformDecimated)
 		{
@@ -335,6 +384,7 @@ void LoopModel::UpdateModel(const BufferBank& buffer,
 		_lastWaveformDisplayLength = clampedDisplayLength;
 		_lastWaveformOffset = offset;
 		_lastWaveformRadius = waveformRadius;
+		_pendingWaveformChange = { 0ul, 0ul };
 	}
 }
 
@@ -355,6 +405,24 @@ void LoopModel::DecimateWaveformInto(const BufferBank& buffer,
 
 	std::fill(outSegments.begin(), outSegments.end(), glm::vec2(0.0f, 0.0f));
 
+	if ((0ul == length) || (offset >= buffer.Length()))
+		return;
+
+	DecimateWaveformRange(buffer,
+		offset,
+		length,
+		outSegments,
+		0ul,
+		static_cast<unsigned long>(outSegments.size()));
+}
+
+void LoopModel::DecimateWaveformRange(const BufferBank& buffer,
+	unsigned long offset,
+	unsigned long length,
+	std::vector<glm::vec2>& outSegments,
+	unsigned long firstSegment,
+	unsigned long endSegment)
+{
 	if ((0ul == length) || (offset >= buffer.Length()))
 		return;
 
@@ -363,28 +431,22 @@ void LoopModel::DecimateWaveformInto(const BufferBank& buffer,
 	if (0ul == clampedLength)
 		return;
 
-	auto segmentCount = static_cast<unsigned long>(outSegments.size());
-	for (auto segment = 0ul; segment < segmentCount; segment++)
+	// 64-bit, as segment * length overflows a 32-bit long for long loops
+	auto segmentCount = static_cast<unsigned long long>(outSegments.size());
+	endSegment = std::min(endSegment, static_cast<unsigned long>(segmentCount));
+
+	for (auto segment = static_cast<unsigned long long>(firstSegment); segment < endSegment; segment++)
 	{
-		auto segmentStart = (segment * clampedLength) / segmentCount;
-		auto segmentEnd = ((segment + 1ul) * clampedLength) / segmentCount;
+		auto segmentStart = static_cast<unsigned long>((segment * clampedLength) / segmentCount);
+		auto segmentEnd = static_cast<unsigned long>(((segment + 1ull) * clampedLength) / segmentCount);
 		if (segmentEnd <= segmentStart)
 		{
 			segmentStart = std::min(segmentStart, clampedLength - 1ul);
 			segmentEnd = segmentStart + 1ul;
 		}
 
-		auto segmentMin = std::numeric_limits<float>::max();
-		auto segmentMax = std::numeric_limits<float>::lowest();
-
-		for (auto sampleIndex = segmentStart; sampleIndex < segmentEnd; sampleIndex++)
-		{
-			auto sample = buffer[offset + sampleIndex];
-			segmentMin = std::min(segmentMin, sample);
-			segmentMax = std::max(segmentMax, sample);
-		}
-
-		outSegments[segment] = glm::vec2(segmentMin, segmentMax);
+		auto summary = buffer.SubSummary(offset + segmentStart, offset + segmentEnd);
+		outSegments[segment] = glm::vec2(summary.Min, summary.Max);
 	}
 }
 
@@ -588,8 +650,9 @@ LoopModel::CalcGrainGeometry(const BufferBank& buffer,
 	auto sourceEnd = static_cast<unsigned long>(ceil((static_cast<double>(grain) * static_cast<double>(sourceLoopLength)) / static_cast<double>(numGrains)));
 	auto i1 = offset + std::min(sourceStart, sourceLoopLength);
 	auto i2 = offset + std::min(std::max(sourceEnd, sourceStart + 1ul), sourceLoopLength);
-	auto gMin = buffer.SubMin(i1, i2);
-	auto gMax = buffer.SubMax(i1, i2);
+	auto grainSummary = buffer.SubSummary(i1, i2);
+	auto gMin = grainSummary.Min;
+	auto gMax = grainSummary.Max;
 
 	auto xInner1 = sin(angle1) * (radius - radialThickness);
 	auto xInner2 = sin(angle2) * (radius - radialThickness);
@@ -2,6 +2,7 @@
 
 #include <array>
 #include <mutex>
+#include <optional>
 #include <vector>
 #include <tuple>
 #include <memory>
@@ -66,12 +67,16 @@ namespace engine
 			unsigned long offset,
 			float radius,
 			bool allowUnchangedSkip = false);
+		// With changed given (from BufferBank::TakeDirtyRange) and the same
+		// lengths/offset/radius as last time, only the segments overlapping
+		// the changed samples are rebuilt. Without it, everything is.
 		void UpdateModel(const audio::BufferBank& buffer,
 			unsigned long sourceLoopLength,
 			unsigned long displayLoopLength,
 			unsigned long offset,
 			float radius,
-			bool allowUnchangedSkip = false);
+			bool allowUnchangedSkip = false,
+			std::optional<audio::BufferBank::SampleRange> changed = std::nullopt);
 
 		// Waveform Decimation & Texture Data Generation
 		static std::vector<glm::vec2> DecimateWaveform(const audio::BufferBank& buffer, unsigned long offset, unsigned long length, unsigned int numSegments);
@@ -109,6 +114,12 @@ namespace engine
 			unsigned long offset,
 			unsigned long length,
 			std::vector<glm::vec2>& outSegments);
+		static void DecimateWaveformRange(const audio::BufferBank& buffer,
+			unsigned long offset,
+			unsigned long length,
+			std::vector<glm::vec2>& outSegments,
+			unsigned long firstSegment,
+			unsigned long endSegment);
 		static std::tuple<std::vector<float>, std::vector<float>> BuildFixedGeometry(unsigned int numSegments, float radius);
 
 	protected:
@@ -138,6 +149,7 @@ namespace engine
 		unsigned long _lastWaveformDisplayLength;
 		unsigned long _lastWaveformOffset;
 		float _lastWaveformRadius;
+		audio::BufferBank::SampleRange _pendingWaveformChange;
 		float _waveformColorScale;
 		std::mutex _waveformMutex;
 	};
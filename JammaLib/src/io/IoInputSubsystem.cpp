@@ -26,7 +26,7 @@ namespace io
 		std::atomic<std::int64_t>& midiAnchorMicros)
 	{
 		_midiRouter.InitMidi(_userConfig, _loggingConfig, audioSampleCounter, midiAnchorMicros);
-		_midiRouter.InitSerial(_userConfig);
+		_midiRouter.InitSerial(_userConfig, audioSampleCounter, midiAnchorMicros);
 	}
 
 	void IoInputSubsystem::Close()
@@ -106,7 +106,7 @@ namespace io
 		std::scoped_lock lock(audioMutex);
 		PumpResult result;
 		auto midiSummary = _midiRouter.PumpMidi(stations,
-			static_cast<std::uint32_t>(audioSampleCounter),
+			audioSampleCounter,
 			_userConfig,
 			streamParams);
 		if (midiSummary.Activated) result.Activated = true;
@@ -115,12 +115,16 @@ namespace io
 	}
 
 	IoInputSubsystem::PumpResult IoInputSubsystem::PumpSerial(std::vector<std::shared_ptr<Station>>& stations,
+		std::uint64_t audioSampleCounter,
 		const audio::AudioStreamParams& streamParams,
 		std::mutex& audioMutex)
 	{
 		std::scoped_lock lock(audioMutex);
 		PumpResult result;
-		auto serialSummary = _midiRouter.PumpSerial(stations, _userConfig, streamParams);
+		auto serialSummary = _midiRouter.PumpSerial(stations,
+			audioSampleCounter,
+			_userConfig,
+			streamParams);
 		if (serialSummary.Activated) result.Activated = true;
 		if (serialSummary.Ditched) result.Ditched = true;
 		return result;
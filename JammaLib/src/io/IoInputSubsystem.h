@@ -3,6 +3,7 @@
 #include <memory>
 #include <mutex>
 #include <atomic>
+#include <chrono>
 #include <functional>
 #include <windows.h>
 #include "../io/UserConfig.h"
@@ -37,9 +38,13 @@ namespace io
 			std::mutex& audioMutex);
 
 		PumpResult PumpSerial(std::vector<std::shared_ptr<engine::Station>>& stations,
+			std::uint64_t audioSampleCounter,
 			const audio::AudioStreamParams& streamParams,
 			std::mutex& audioMutex);
 
+		bool WaitForInput(std::chrono::milliseconds timeout) { return _midiRouter.WaitForIngress(timeout); }
+		void WakeInput() noexcept { _midiRouter.WakeIngress(); }
+
 		actions::ActionResult HandleAutomationKey(const actions::KeyAction& action,
 			const std::vector<std::shared_ptr<engine::Station>>& stations,
 			const std::vector<unsigned char>& hoverPath,
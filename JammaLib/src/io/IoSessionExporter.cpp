@@ -4,7 +4,6 @@
 #include <utility>
 #include <vector>
 #include "../io/JamFile.h"
-#include "../io/TextReadWriter.h"
 #include "../io/WavReadWriter.h"
 #include "../utils/PathUtils.h"
 
@@ -16,33 +15,16 @@ namespace io
 		const timing::TimingQuantiser& quantisation,
 		const io::UserConfig& userConfig,
 		const audio::AudioStreamParams& streamParams,
-		audio::AudioDevice* device,
 		std::mutex& sceneMutex,
-		const std::shared_ptr<ninjam::NinjamController>& ninjamController)
+		const std::shared_ptr<ninjam::NinjamController>& ninjamController,
+		SessionWriter& writer)
 	{
-		struct AudioPauseGuard
+		if (writer.IsRunning())
 		{
-			explicit AudioPauseGuard(audio::AudioDevice* deviceRef) : Device(deviceRef), WasPlaying(deviceRef && deviceRef->Pause()) {}
-			~AudioPauseGuard() { Resume(); }
-
-			void Resume()
-			{
-				if (WasPlaying && Device)
-				{
-					Device->Resume();
-					WasPlaying = false;
-				}
-			}
-
-			audio::AudioDevice* Device;
-			bool WasPlaying;
-		};
-
-		struct LoopSnapshot
-		{
-			std::wstring Path;
-			std::vector<float> Samples;
-		};
+			std::cout << "Export: still writing the last export ("
+				<< SessionWriter::FormatProgress(writer.GetProgress()) << ")" << std::endl;
+			return actions::ActionResult::NoAction();
+		}
 
 		const auto exportDir = utils::PickDirectory(L"Choose export directory");
 		if (exportDir.empty())
@@ -59,10 +41,11 @@ namespace io
 		jam.GlobalPhaseOffsetSamps = quantisation.GlobalPhaseOffsetSamps();
 		jam.Quantisation = utils::Timer::QUANTISE_OFF;
 
-		std::vector<LoopSnapshot> loops;
+		std::vector<SessionWriter::LoopFile> loops;
 
+		// Only the layout is taken under the lock. Samples are read later,
+		// by the writer's workers.
 		{
-			AudioPauseGuard pause(device);
 			std::scoped_lock lock(sceneMutex);
 
 			for (const auto& station : stations)
@@ -85,18 +68,18 @@ namespace io
 
 					for (const auto& loop : take->GetLoops())
 					{
-						const auto wavFilename = loop->Id() + ".wav";
-
-						auto samples = loop->ExportSamples();
-						if (samples.empty())
+						const auto loopLength = loop->LoopLength();
+						if ((0ul == loopLength) || (Loop::STATE_INACTIVE == loop->PlayState()))
 							continue;
 
+						const auto wavFilename = loop->Id() + ".wav";
 						jamTake.Loops.push_back(loop->ToJamFile(wavFilename));
 
-						LoopSnapshot snap;
-						snap.Path = exportDir + L"\\" + utils::DecodeUtf8(wavFilename);
-						snap.Samples = std::move(samples);
-						loops.push_back(std::move(snap));
+						SessionWriter::LoopFile loopFile;
+						loopFile.Path = exportDir + L"\\" + utils::DecodeUtf8(wavFilename);
+						loopFile.NumBytes = static_cast<std::size_t>(loopLength) * sizeof(float);
+						loopFile.ReadSamples = [loop]() { return loop->ExportSamples(); };
+						loops.push_back(std::move(loopFile));
 					}
 
 					if (!jamTake.Loops.empty())
@@ -113,27 +96,22 @@ namespace io
 			return actions::ActionResult::NoAction();
 		}
 
-		io::WavReadWriter wavWriter;
-		unsigned int wavCount = 0;
-		for (const auto& loop : loops)
-		{
-			if (wavWriter.Write(loop.Path, loop.Samples, (unsigned int)loop.Samples.size(), sampleRate))
-				++wavCount;
-		}
-
 		std::stringstream jamStream;
 		io::JamFile::ToStream(jam, jamStream);
-		const auto jamPath = exportDir + L"\\session.jam";
-		const auto wroteJamFile = io::TextReadWriter().Write(jamPath, jamStream.str(), 0, 0);
-		if (!wroteJamFile)
-		{
-			std::cout << "Export: failed to write session.jam to "
-				<< utils::EncodeUtf8(jamPath) << std::endl;
-			return actions::ActionResult::NoAction();
-		}
 
-		std::cout << "Exported " << wavCount << " loop(s) + session.jam to "
-			<< utils::EncodeUtf8(exportDir) << std::endl;
+		// 24-bit keeps the loops' float resolution down to the noise floor
+		auto wavWriter = [sampleRate](const std::wstring& path, const std::vector<float>& samples) {
+			return io::WavReadWriter(io::WavSampleFormat::Int24).Write(path, samples, static_cast<unsigned int>(samples.size()), sampleRate);
+		};
+
+		writer.Start(std::move(loops),
+			exportDir + L"\\session.jam",
+			jamStream.str(),
+			wavWriter,
+			constants::NumExportWorkers,
+			static_cast<std::size_t>(constants::ExportBudgetMb) * 1024u * 1024u);
+
+		std::cout << "Exporting to " << utils::EncodeUtf8(exportDir) << std::endl;
 
 		return actions::ActionResult::NoAction();
 	}
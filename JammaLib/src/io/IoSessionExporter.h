@@ -5,6 +5,7 @@
 #include <vector>
 #include "../actions/ActionResult.h"
 #include "../audio/AudioDevice.h"
+#include "../io/SessionWriter.h"
 #include "../io/UserConfig.h"
 #include "../ninjam/NinjamController.h"
 #include "../timing/TimingQuantiser.h"
@@ -15,12 +16,14 @@ namespace io
 	class IoSessionExporter
 	{
 	public:
+		// Gathers the session under the scene mutex, then hands the loops to
+		// the writer and returns. Audio keeps running throughout.
 		static actions::ActionResult ExportSession(const std::vector<std::shared_ptr<engine::Station>>& stations,
 			const timing::TimingQuantiser& quantisation,
 			const io::UserConfig& userConfig,
 			const audio::AudioStreamParams& streamParams,
-			audio::AudioDevice* device,
 			std::mutex& sceneMutex,
-			const std::shared_ptr<ninjam::NinjamController>& ninjamController);
+			const std::shared_ptr<ninjam::NinjamController>& ninjamController,
+			SessionWriter& writer);
 	};
 }
@@ -3,6 +3,8 @@
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
 
+#include <array>
+#include <chrono>
 #include <iostream>
 
 using namespace io;
@@ -64,7 +66,7 @@ bool SerialDevice::Open(const std::string& deviceName,
 		0,
 		nullptr,
 		OPEN_EXISTING,
-		0,
+		FILE_FLAG_OVERLAPPED,
 		nullptr);
 
 	if (handle == INVALID_HANDLE_VALUE)
@@ -101,10 +103,12 @@ bool SerialDevice::Open(const std::string& deviceName,
 		return false;
 	}
 
+	// Reads return as soon as any bytes are waiting, taking all of them,
+	// or after ReadTimeoutMs with nothing
 	COMMTIMEOUTS timeouts{};
-	timeouts.ReadIntervalTimeout = 10;
-	timeouts.ReadTotalTimeoutConstant = 10;
-	timeouts.ReadTotalTimeoutMultiplier = 0;
+	timeouts.ReadIntervalTimeout = MAXDWORD;
+	timeouts.ReadTotalTimeoutConstant = ReadTimeoutMs;
+	timeouts.ReadTotalTimeoutMultiplier = MAXDWORD;
 	if (!SetCommTimeouts(handle, &timeouts))
 	{
 		std::cout << "[Serial] Failed to set timeouts for device \"" << deviceName << "\" on "
@@ -158,11 +162,26 @@ void SerialDevice::Close()
 void SerialDevice::_ReadLoop()
 {
 	auto handle = AsHandle(_handle);
+	OVERLAPPED overlapped{};
+	overlapped.hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+	if (nullptr == overlapped.hEvent)
+	{
+		std::cout << "[Serial] Failed to create read event for device \"" << _deviceName << "\" ("
+			<< _portName << ", error " << GetLastError() << ")" << std::endl;
+		return;
+	}
+
+	std::array<unsigned char, ReadChunkSize> bytes{};
+
 	while (_running.load(std::memory_order_acquire) && (handle != nullptr))
 	{
-		unsigned char byte = 0u;
 		DWORD bytesRead = 0u;
-		if (!ReadFile(handle, &byte, 1u, &bytesRead, nullptr))
+		ResetEvent(overlapped.hEvent);
+		auto isRead = ReadFile(handle, bytes.data(), static_cast<DWORD>(bytes.size()), &bytesRead, &overlapped);
+		if (!isRead && (ERROR_IO_PENDING == GetLastError()))
+			isRead = GetOverlappedResult(handle, &overlapped, &bytesRead, TRUE);
+
+		if (!isRead)
 		{
 			if (_running.load(std::memory_order_acquire))
 			{
@@ -172,16 +191,26 @@ void SerialDevice::_ReadLoop()
 			break;
 		}
 
-		if (bytesRead != 1u)
+		if (0u == bytesRead)
 			continue;
 
-		SerialTriggerEvent event{};
-		if (_callback && _protocol.PushByte(byte, event))
+		// The read returns as soon as bytes arrive, so its completion stands
+		// in for their arrival time
+		const auto arrivalMicros = std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+
+		for (DWORD i = 0u; i < bytesRead; ++i)
 		{
-			event.Device = &_deviceName;
-			_callback(event);
+			SerialTriggerEvent event{};
+			if (_callback && _protocol.PushByte(bytes[i], event, arrivalMicros))
+			{
+				event.Device = &_deviceName;
+				_callback(event);
+			}
 		}
 	}
+
+	CloseHandle(overlapped.hEvent);
 }
 
 std::string SerialDevice::_NormalisePortName(const std::string& portName)
@@ -36,6 +36,9 @@ namespace io
 		unsigned int BaudRate() const noexcept { return _baudRate; }
 
 	private:
+		static constexpr unsigned int ReadChunkSize = 64u;
+		static constexpr unsigned long ReadTimeoutMs = 50ul;
+
 		void _ReadLoop();
 		static std::string _NormalisePortName(const std::string& portName);
 
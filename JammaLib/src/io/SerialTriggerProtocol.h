@@ -10,6 +10,10 @@ namespace io
 		const std::string* Device = nullptr;
 		unsigned int ButtonIndex = 0u;
 		bool IsPressed = false;
+		// Steady clock time the packet started arriving
+		std::int64_t ArrivalMicros = 0;
+		// Low 32 bits of the engine sample ArrivalMicros maps to
+		std::uint32_t SampleTime = 0u;
 	};
 
 	class SerialTriggerProtocol
@@ -17,18 +21,24 @@ namespace io
 	public:
 		static constexpr std::uint8_t PacketHeader = 0xA5u;
 
-		bool PushByte(std::uint8_t byte, SerialTriggerEvent& out) noexcept
+		// The event is stamped with the arrival time of its header byte, so a
+		// packet split across reads keeps the time the press was sent
+		bool PushByte(std::uint8_t byte, SerialTriggerEvent& out, std::int64_t arrivalMicros = 0) noexcept
 		{
 			switch (_state)
 			{
 			case State::WaitingForHeader:
 				if (byte == PacketHeader)
+				{
 					_state = State::WaitingForIndex;
+					_headerMicros = arrivalMicros;
+				}
 				return false;
 			case State::WaitingForIndex:
 				if (byte == PacketHeader)
 				{
 					_state = State::WaitingForIndex;
+					_headerMicros = arrivalMicros;
 					return false;
 				}
 
@@ -39,11 +49,13 @@ namespace io
 				if (byte == PacketHeader)
 				{
 					_state = State::WaitingForIndex;
+					_headerMicros = arrivalMicros;
 					return false;
 				}
 
 				out.ButtonIndex = _buttonIndex;
 				out.IsPressed = byte != 0u;
+				out.ArrivalMicros = _headerMicros;
 				Reset();
 				return true;
 			}
@@ -55,6 +67,7 @@ namespace io
 		{
 			_state = State::WaitingForHeader;
 			_buttonIndex = 0u;
+			_headerMicros = 0;
 		}
 
 	private:
@@ -67,5 +80,6 @@ namespace io
 
 		State _state = State::WaitingForHeader;
 		unsigned int _buttonIndex = 0u;
+		std::int64_t _headerMicros = 0;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,207 @@
+#include "SessionWriter.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <system_error>
+#include "../utils/BatchUtils.h"
+
+using namespace io;
+
+namespace
+{
+	std::int64_t NowUs()
+	{
+		return std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+}
+
+SessionWriter::SessionWriter() :
+	_runner(),
+	_loops(),
+	_jamPath(),
+	_jamText(),
+	_wavWriter(),
+	_budgetMutex(),
+	_budgetFreed(),
+	_bytesInFlight(0u),
+	_maxBytesInFlight(0u),
+	_startUs(0),
+	_numLoops(0u),
+	_numWritten(0u),
+	_numFailed(0u),
+	_bytesWritten(0u),
+	_elapsedUs(0),
+	_isRunning(false),
+	_isCommitted(false)
+{
+}
+
+SessionWriter::~SessionWriter()
+{
+	Wait();
+}
+
+bool SessionWriter::Start(std::vector<LoopFile> loops,
+	std::wstring jamPath,
+	std::string jamText,
+	WavWriter wavWriter,
+	unsigned int numWorkers,
+	std::size_t maxBytesInFlight)
+{
+	if (IsRunning())
+		return false;
+
+	Wait();
+
+	_loops = std::move(loops);
+	_jamPath = std::move(jamPath);
+	_jamText = std::move(jamText);
+	_wavWriter = std::move(wavWriter);
+	_bytesInFlight = 0u;
+	_maxBytesInFlight = maxBytesInFlight;
+
+	_startUs.store(NowUs(), std::memory_order_relaxed);
+	_numLoops.store(static_cast<unsigned int>(_loops.size()), std::memory_order_relaxed);
+	_numWritten.store(0u, std::memory_order_relaxed);
+	_numFailed.store(0u, std::memory_order_relaxed);
+	_bytesWritten.store(0u, std::memory_order_relaxed);
+	_elapsedUs.store(0, std::memory_order_relaxed);
+	_isCommitted.store(false, std::memory_order_relaxed);
+	_isRunning.store(true, std::memory_order_release);
+
+	_runner = std::thread([this, numWorkers]() { _Run(numWorkers); });
+
+	return true;
+}
+
+void SessionWriter::Wait()
+{
+	if (_runner.joinable())
+		_runner.join();
+}
+
+SessionWriter::Progress SessionWriter::GetProgress() const
+{
+	Progress progress;
+	progress.NumLoops = _numLoops.load(std::memory_order_relaxed);
+	progress.NumWritten = _numWritten.load(std::memory_order_relaxed);
+	progress.NumFailed = _numFailed.load(std::memory_order_relaxed);
+	progress.BytesWritten = _bytesWritten.load(std::memory_order_relaxed);
+	progress.IsRunning = IsRunning();
+	progress.IsCommitted = _isCommitted.load(std::memory_order_acquire);
+
+	// Elapsed time stops counting once the export has finished
+	auto elapsedUs = progress.IsRunning ?
+		NowUs() - _startUs.load(std::memory_order_relaxed) :
+		_elapsedUs.load(std::memory_order_relaxed);
+	progress.ElapsedSecs = static_cast<double>(elapsedUs) / 1000000.0;
+
+	return progress;
+}
+
+std::string SessionWriter::FormatProgress(const Progress& progress)
+{
+	std::stringstream ss;
+	ss << progress.NumWritten << "/" << progress.NumLoops << " loop(s)";
+	if (progress.NumFailed > 0u)
+		ss << ", " << progress.NumFailed << " failed";
+
+	ss << ", " << utils::FormatThroughput(progress.BytesWritten, progress.ElapsedSecs);
+
+	if (progress.IsRunning)
+		ss << ", writing";
+	else
+		ss << (progress.IsCommitted ? ", committed" : ", not committed");
+
+	return ss.str();
+}
+
+bool SessionWriter::CommitTextFile(const std::wstring& path, const std::string& text)
+{
+	const std::filesystem::path finalPath(path);
+	auto tempPath = finalPath;
+	tempPath += L".tmp";
+
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file)
+			return false;
+
+		file.write(text.data(), static_cast<std::streamsize>(text.size()));
+		file.flush();
+		if (!file)
+			return false;
+	}
+
+	// Replaces any previous file in one step
+	std::error_code error;
+	std::filesystem::rename(tempPath, finalPath, error);
+	if (error)
+	{
+		std::filesystem::remove(tempPath, error);
+		return false;
+	}
+
+	return true;
+}
+
+void SessionWriter::_Run(unsigned int numWorkers)
+{
+	utils::RunBatch(_loops.size(), numWorkers, [this](std::size_t index) { _WriteLoop(_loops[index]); });
+
+	if (0u == _numFailed.load(std::memory_order_relaxed))
+		_isCommitted.store(CommitTextFile(_jamPath, _jamText), std::memory_order_release);
+
+	_elapsedUs.store(NowUs() - _startUs.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+	_loops.clear();
+	_wavWriter = WavWriter();
+	_isRunning.store(false, std::memory_order_release);
+
+	std::cout << "[Export] " << FormatProgress(GetProgress()) << std::endl;
+}
+
+void SessionWriter::_WriteLoop(const LoopFile& loop)
+{
+	_AcquireBytes(loop.NumBytes);
+
+	auto samples = loop.ReadSamples ? loop.ReadSamples() : std::vector<float>();
+	auto isWritten = !samples.empty() && _wavWriter && _wavWriter(loop.Path, samples);
+
+	if (isWritten)
+	{
+		_numWritten.fetch_add(1u, std::memory_order_relaxed);
+		_bytesWritten.fetch_add(samples.size() * sizeof(float), std::memory_order_relaxed);
+	}
+	else
+		_numFailed.fetch_add(1u, std::memory_order_relaxed);
+
+	samples = std::vector<float>();
+	_ReleaseBytes(loop.NumBytes);
+}
+
+void SessionWriter::_AcquireBytes(std::size_t numBytes)
+{
+	std::unique_lock lock(_budgetMutex);
+
+	// A loop bigger than the whole budget still goes, once nothing else is held
+	_budgetFreed.wait(lock, [this, numBytes]() {
+		return (0u == _bytesInFlight) || (_bytesInFlight + numBytes <= _maxBytesInFlight);
+	});
+
+	_bytesInFlight += numBytes;
+}
+
+void SessionWriter::_ReleaseBytes(std::size_t numBytes)
+{
+	{
+		std::scoped_lock lock(_budgetMutex);
+		_bytesInFlight -= numBytes;
+	}
+
+	_budgetFreed.notify_all();
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace io
+{
+	// Writes an exported session on background threads, so saving never
+	// holds up audio or the UI.
+	//
+	// Workers take loops in turn, reading each one's samples just before
+	// writing it. A worker waits while the samples already held would go
+	// past the memory budget. The jam file goes to a temporary file that is
+	// renamed into place only once every WAV has been written. A failed
+	// export therefore never leaves a jam file naming loops that are not
+	// there.
+	class SessionWriter
+	{
+	public:
+		struct LoopFile
+		{
+			std::wstring Path;
+			// Counted against the budget while the samples are held
+			std::size_t NumBytes = 0u;
+			// Empty when the samples could not be read, which fails the loop
+			std::function<std::vector<float>()> ReadSamples;
+		};
+
+		using WavWriter = std::function<bool(const std::wstring& path, const std::vector<float>& samples)>;
+
+		struct Progress
+		{
+			unsigned int NumLoops = 0u;
+			unsigned int NumWritten = 0u;
+			unsigned int NumFailed = 0u;
+			std::uint64_t BytesWritten = 0u;
+			double ElapsedSecs = 0.0;
+			bool IsRunning = false;
+			bool IsCommitted = false;
+		};
+
+	public:
+		SessionWriter();
+		~SessionWriter();
+
+		SessionWriter(const SessionWriter&) = delete;
+		SessionWriter& operator=(const SessionWriter&) = delete;
+
+		// Returns false without starting if an export is still running.
+		bool Start(std::vector<LoopFile> loops,
+			std::wstring jamPath,
+			std::string jamText,
+			WavWriter wavWriter,
+			unsigned int numWorkers,
+			std::size_t maxBytesInFlight);
+		void Wait();
+		bool IsRunning() const noexcept { return _isRunning.load(std::memory_order_acquire); }
+
+		Progress GetProgress() const;
+		static std::string FormatProgress(const Progress& progress);
+
+		// Writes text beside path, then renames it over path.
+		static bool CommitTextFile(const std::wstring& path, const std::string& text);
+
+	protected:
+		void _Run(unsigned int numWorkers);
+		void _WriteLoop(const LoopFile& loop);
+		void _AcquireBytes(std::size_t numBytes);
+		void _ReleaseBytes(std::size_t numBytes);
+
+	protected:
+		std::thread _runner;
+		std::vector<LoopFile> _loops;
+		std::wstring _jamPath;
+		std::string _jamText;
+		WavWriter _wavWriter;
+
+		std::mutex _budgetMutex;
+		std::condition_variable _budgetFreed;
+		std::size_t _bytesInFlight;
+		std::size_t _maxBytesInFlight;
+
+		// Steady clock ticks, as GetProgress() reads it from other threads
+		std::atomic<std::int64_t> _startUs;
+		std::atomic<unsigned int> _numLoops;
+		std::atomic<unsigned int> _numWritten;
+		std::atomic<unsigned int> _numFailed;
+		std::atomic<std::uint64_t> _bytesWritten;
+		std::atomic<std::int64_t> _elapsedUs;
+		std::atomic<bool> _isRunning;
+		std::atomic<bool> _isCommitted;
+	};
+}
@@ -104,6 +104,11 @@ std::optional<UserConfig::AudioSettings> UserConfig::AudioSettings::FromJson(Jso
 	unsigned int numBuffers = 4;
 	unsigned int numChannelsIn = 2;
 	unsigned int numChannelsOut = 2;
+	unsigned int renderWorkers = 0;
+	unsigned int shedLoadPercent = constants::DefaultShedLoadPercent;
+	unsigned int recoverLoadPercent = constants::DefaultRecoverLoadPercent;
+	unsigned int shedBlocks = constants::DefaultShedBlocks;
+	std::string shedPolicy = "visuals,vu,vst";
 
 	auto iter = json.KeyValues.find("name");
 	if (iter != json.KeyValues.end())
@@ -161,6 +166,41 @@ std::optional<UserConfig::AudioSettings> UserConfig::AudioSettings::FromJson(Jso
 			numChannelsOut = std::get<unsigned long>(json.KeyValues["numchannelsout"]);
 	}
 
+	iter = json.KeyValues.find("renderworkers");
+	if (iter != json.KeyValues.end())
+	{
+		if (json.KeyValues["renderworkers"].index() == 2)
+			renderWorkers = std::get<unsigned long>(json.KeyValues["renderworkers"]);
+	}
+
+	iter = json.KeyValues.find("shedloadpercent");
+	if (iter != json.KeyValues.end())
+	{
+		if (json.KeyValues["shedloadpercent"].index() == 2)
+			shedLoadPercent = std::get<unsigned long>(json.KeyValues["shedloadpercent"]);
+	}
+
+	iter = json.KeyValues.find("recoverloadpercent");
+	if (iter != json.KeyValues.end())
+	{
+		if (json.KeyValues["recoverloadpercent"].index() == 2)
+			recoverLoadPercent = std::get<unsigned long>(json.KeyValues["recoverloadpercent"]);
+	}
+
+	iter = json.KeyValues.find("shedblocks");
+	if (iter != json.KeyValues.end())
+	{
+		if (json.KeyValues["shedblocks"].index() == 2)
+			shedBlocks = std::get<unsigned long>(json.KeyValues["shedblocks"]);
+	}
+
+	iter = json.KeyValues.find("shedpolicy");
+	if (iter != json.KeyValues.end())
+	{
+		if (json.KeyValues["shedpolicy"].index() == 4)
+			shedPolicy = std::get<std::string>(json.KeyValues["shedpolicy"]);
+	}
+
 	AudioSettings audio;
 	audio.Name = name;
 	audio.SampleRate = sampleRate;
@@ -170,6 +210,11 @@ std::optional<UserConfig::AudioSettings> UserConfig::AudioSettings::FromJson(Jso
 	audio.NumBuffers = numBuffers;
 	audio.NumChannelsIn = numChannelsIn;
 	audio.NumChannelsOut = numChannelsOut;
+	audio.RenderWorkers = renderWorkers;
+	audio.ShedLoadPercent = shedLoadPercent;
+	audio.RecoverLoadPercent = recoverLoadPercent;
+	audio.ShedBlocks = shedBlocks;
+	audio.ShedPolicy = shedPolicy;
 	return audio;
 }
 
@@ -180,6 +225,11 @@ std::optional<UserConfig::LoopSettings> UserConfig::LoopSettings::FromJson(Json:
 	unsigned int seedGrainTargetMaxMs = constants::DefaultSeedGrainTargetMaxMs;
 	unsigned int seedBpmMin = constants::DefaultSeedBpmMin;
 	auto seedUsesPowers = true;
+	unsigned int bankSlabSamps = constants::DefaultBankSlabSamps;
+	unsigned int bankBudgetMb = constants::DefaultBankBudgetMb;
+	unsigned long streamThresholdSamps = constants::DefaultStreamThresholdSamps;
+	unsigned int streamWindowBanks = constants::DefaultStreamWindowBanks;
+	unsigned long compactIdleSamps = constants::DefaultCompactIdleSamps;
 
 	auto iter = json.KeyValues.find("fadeSamps");
 	if (iter != json.KeyValues.end())
@@ -213,12 +263,52 @@ std::optional<UserConfig::LoopSettings> UserConfig::LoopSettings::FromJson(Json:
 	if ((iter != json.KeyValues.end()) && (json.KeyValues["seedQuantisation"].index() == 4))
 		seedUsesPowers = std::get<std::string>(json.KeyValues["seedQuantisation"]) != "multiple";
 
+	iter = json.KeyValues.find("bankSlabSamps");
+	if (iter != json.KeyValues.end())
+	{
+		if (json.KeyValues["bankSlabSamps"].index() == 2)
+			bankSlabSamps = std::get<unsigned long>(json.KeyValues["bankSlabSamps"]);
+	}
+
+	iter = json.KeyValues.find("bankBudgetMb");
+	if (iter != json.KeyValues.end())
+	{
+		if (json.KeyValues["bankBudgetMb"].index() == 2)
+			bankBudgetMb = std::get<unsigned long>(json.KeyValues["bankBudgetMb"]);
+	}
+
+	iter = json.KeyValues.find("streamThresholdSamps");
+	if (iter != json.KeyValues.end())
+	{
+		if (json.KeyValues["streamThresholdSamps"].index() == 2)
+			streamThresholdSamps = std::get<unsigned long>(json.KeyValues["streamThresholdSamps"]);
+	}
+
+	iter = json.KeyValues.find("streamWindowBanks");
+	if (iter != json.KeyValues.end())
+	{
+		if (json.KeyValues["streamWindowBanks"].index() == 2)
+			streamWindowBanks = std::get<unsigned long>(json.KeyValues["streamWindowBanks"]);
+	}
+
+	iter = json.KeyValues.find("compactIdleSamps");
+	if (iter != json.KeyValues.end())
+	{
+		if (json.KeyValues["compactIdleSamps"].index() == 2)
+			compactIdleSamps = std::get<unsigned long>(json.KeyValues["compactIdleSamps"]);
+	}
+
 	LoopSettings loop;
 	loop.FadeSamps = fadeSamps;
 	loop.SeedGrainMinMs = seedGrainMinMs;
 	loop.SeedGrainTargetMaxMs = seedGrainTargetMaxMs;
 	loop.SeedBpmMin = seedBpmMin;
 	loop.SeedUsesPowers = seedUsesPowers;
+	loop.BankSlabSamps = bankSlabSamps;
+	loop.BankBudgetMb = bankBudgetMb;
+	loop.StreamThresholdSamps = streamThresholdSamps;
+	loop.StreamWindowBanks = streamWindowBanks;
+	loop.CompactIdleSamps = compactIdleSamps;
 	return loop;
 }
 
@@ -42,6 +42,11 @@ namespace io
 			unsigned int NumBuffers; // The number of buffers used by the device, if applicable
 			unsigned int NumChannelsIn; // The number of input channels used in current scene
 			unsigned int NumChannelsOut; // The number of output channels used in current scene
+			unsigned int RenderWorkers = 0u; // Extra threads rendering stations in parallel (0 = render on the audio thread only)
+			unsigned int ShedLoadPercent = constants::DefaultShedLoadPercent; // Callback load, as a share of the buffer period, that counts as overloaded (0 = never shed work)
+			unsigned int RecoverLoadPercent = constants::DefaultRecoverLoadPercent; // Load below which shed work is brought back
+			unsigned int ShedBlocks = constants::DefaultShedBlocks; // Overloaded blocks in a row before the next step of the policy is taken
+			std::string ShedPolicy = "visuals,vu,vst"; // Work to shed under overload, in order (visuals, vu, vst)
 
 			static std::optional<AudioSettings> FromJson(Json::JsonPart json);
 		};
@@ -53,6 +58,11 @@ namespace io
 			unsigned int SeedGrainTargetMaxMs = constants::DefaultSeedGrainTargetMaxMs; // Prefer grains below this duration
 			unsigned int SeedBpmMin = constants::DefaultSeedBpmMin; // Choose beats-per-grain so BPM is at least this value
 			bool SeedUsesPowers = true; // true => 1x,2x,4x... ; false => 1x,2x,3x...
+			unsigned int BankSlabSamps = constants::DefaultBankSlabSamps; // Size of each pooled loop buffer slab (rounded up to a power of two)
+			unsigned int BankBudgetMb = constants::DefaultBankBudgetMb; // Hard cap on memory held for loop audio, in MB
+			unsigned long StreamThresholdSamps = constants::DefaultStreamThresholdSamps; // Loops loaded longer than this play from disk (0 = never)
+			unsigned int StreamWindowBanks = constants::DefaultStreamWindowBanks; // Slabs each streamed loop keeps resident ahead of playback
+			unsigned long CompactIdleSamps = constants::DefaultCompactIdleSamps; // Loops unwritten for this long are packed to 16 bits in memory (0 = never)
 
 			static std::optional<LoopSettings> FromJson(Json::JsonPart json);
 		};
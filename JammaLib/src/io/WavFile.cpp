@@ -0,0 +1,568 @@
+#include "WavFile.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <share.h>
+
+using namespace io;
+using audio::PcmKernels;
+
+namespace
+{
+	constexpr std::uint16_t FormatPcm = 1u;
+	constexpr std::uint16_t FormatFloat = 3u;
+	constexpr std::uint16_t FormatExtensible = 0xfffeu;
+
+	// Left in the data size by writers that stream without seeking back
+	constexpr std::uint32_t UnsetDataSize = 0xffffffffu;
+
+	// Samples converted per block when writing
+	constexpr unsigned long WriteBlockSamps = 65536ul;
+
+	// KSDATAFORMAT_SUBTYPE_PCM/IEEE_FLOAT, after the leading format tag
+	constexpr std::uint8_t SubFormatTail[14] = {
+		0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00, 0x00, 0xaa, 0x00, 0x38, 0x9b, 0x71 };
+
+	std::uint16_t GetU16(const std::uint8_t* bytes)
+	{
+		return static_cast<std::uint16_t>(bytes[0] | (bytes[1] << 8));
+	}
+
+	std::uint32_t GetU32(const std::uint8_t* bytes)
+	{
+		return static_cast<std::uint32_t>(bytes[0]) |
+			static_cast<std::uint32_t>(bytes[1]) << 8 |
+			static_cast<std::uint32_t>(bytes[2]) << 16 |
+			static_cast<std::uint32_t>(bytes[3]) << 24;
+	}
+
+	void PutU16(std::vector<std::uint8_t>& bytes, std::uint16_t value)
+	{
+		bytes.push_back(static_cast<std::uint8_t>(value & 0xff));
+		bytes.push_back(static_cast<std::uint8_t>((value >> 8) & 0xff));
+	}
+
+	void PutU32(std::vector<std::uint8_t>& bytes, std::uint32_t value)
+	{
+		PutU16(bytes, static_cast<std::uint16_t>(value & 0xffff));
+		PutU16(bytes, static_cast<std::uint16_t>((value >> 16) & 0xffff));
+	}
+
+	void PutId(std::vector<std::uint8_t>& bytes, const char* id)
+	{
+		bytes.insert(bytes.end(), id, id + 4);
+	}
+
+	bool PatchU32(FILE* file, long offset, std::uint64_t value)
+	{
+		std::vector<std::uint8_t> bytes;
+		PutU32(bytes, static_cast<std::uint32_t>(std::min(value, static_cast<std::uint64_t>(0xffffffffu))));
+
+		return (0 == _fseeki64(file, offset, SEEK_SET)) &&
+			(fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size());
+	}
+
+	// True when a chunk header, with an ID of printable characters and a
+	// body that fits in the file, starts at pos
+	bool IsChunkAt(FILE* file, std::uint64_t pos, std::uint64_t fileLength)
+	{
+		std::uint8_t chunkHeader[8];
+		if ((pos + sizeof(chunkHeader) > fileLength) ||
+			(0 != _fseeki64(file, static_cast<long long>(pos), SEEK_SET)) ||
+			(fread(chunkHeader, 1, sizeof(chunkHeader), file) != sizeof(chunkHeader)))
+			return false;
+
+		for (auto i = 0u; i < 4u; i++)
+		{
+			if ((chunkHeader[i] < 0x20u) || (chunkHeader[i] > 0x7eu))
+				return false;
+		}
+
+		return pos + sizeof(chunkHeader) + GetU32(chunkHeader + 4) <= fileLength;
+	}
+}
+
+unsigned int WavFormat::BytesPerSample() const noexcept
+{
+	switch (SampleFormat)
+	{
+	case WavSampleFormat::Int24:
+		return 3u;
+	case WavSampleFormat::Int32:
+	case WavSampleFormat::Float32:
+		return 4u;
+	default:
+		return 2u;
+	}
+}
+
+WavFileReader::WavFileReader() :
+	_file(nullptr),
+	_format(),
+	_dataOffset(0u),
+	_numFrames(0u),
+	_nextFrame(0u),
+	_readBuffer()
+{
+}
+
+WavFileReader::~WavFileReader()
+{
+	Close();
+}
+
+bool WavFileReader::Open(const std::wstring& fileName)
+{
+	Close();
+
+	_file = _wfsopen(fileName.c_str(), L"rb", _SH_DENYNO);
+
+	if (nullptr == _file)
+	{
+		std::cout << "Open (Read) wav file error\n";
+		return false;
+	}
+
+	auto fileLength = (0 == _fseeki64(_file, 0, SEEK_END)) ? _ftelli64(_file) : -1ll;
+
+	if ((fileLength < 0) || (0 != _fseeki64(_file, 0, SEEK_SET)) ||
+		!_ReadChunks(static_cast<std::uint64_t>(fileLength)))
+	{
+		std::cout << "Unsupported or corrupt wav file\n";
+		Close();
+
+		return false;
+	}
+
+	// Unknown file position, so the first read seeks
+	_nextFrame = _numFrames;
+
+	return true;
+}
+
+void WavFileReader::Close()
+{
+	if (nullptr != _file)
+		fclose(_file);
+
+	_file = nullptr;
+	_dataOffset = 0u;
+	_numFrames = 0u;
+	_nextFrame = 0u;
+}
+
+unsigned long WavFileReader::Read(std::uint64_t frame, float* dest, unsigned long numFrames)
+{
+	if ((nullptr == _file) || (frame >= _numFrames))
+		return 0;
+
+	numFrames = static_cast<unsigned long>(std::min(static_cast<std::uint64_t>(numFrames), _numFrames - frame));
+
+	const auto frameBytes = _format.BytesPerFrame();
+
+	if ((frame != _nextFrame) &&
+		(0 != _fseeki64(_file, static_cast<long long>(_dataOffset + (frame * frameBytes)), SEEK_SET)))
+	{
+		_nextFrame = _numFrames;
+		return 0;
+	}
+
+	_readBuffer.resize(static_cast<std::size_t>(numFrames) * frameBytes);
+	auto numRead = static_cast<unsigned long>(fread(_readBuffer.data(), 1, _readBuffer.size(), _file) / frameBytes);
+	_nextFrame = (numRead == numFrames) ? frame + numRead : _numFrames;
+
+	auto numSamps = numRead * _format.NumChannels;
+
+	switch (_format.SampleFormat)
+	{
+	case WavSampleFormat::Int16:
+		PcmKernels::Int16ToFloat(_readBuffer.data(), numSamps, dest);
+		break;
+	case WavSampleFormat::Int24:
+		PcmKernels::Int24ToFloat(_readBuffer.data(), numSamps, dest);
+		break;
+	case WavSampleFormat::Int32:
+		PcmKernels::Int32ToFloat(_readBuffer.data(), numSamps, dest);
+		break;
+	case WavSampleFormat::Float32:
+		PcmKernels::Float32ToFloat(_readBuffer.data(), numSamps, dest);
+		break;
+	}
+
+	return numRead;
+}
+
+bool WavFileReader::_ReadChunks(std::uint64_t fileLength)
+{
+	std::uint8_t riff[12];
+	if ((fread(riff, 1, sizeof(riff), _file) != sizeof(riff)) ||
+		(0 != std::memcmp(riff, "RIFF", 4)) ||
+		(0 != std::memcmp(riff + 8, "WAVE", 4)))
+		return false;
+
+	auto hasFormat = false;
+	auto hasData = false;
+	std::uint64_t dataSize = 0u;
+	std::uint64_t pos = sizeof(riff);
+
+	while (pos + 8u <= fileLength)
+	{
+		std::uint8_t chunkHeader[8];
+		if ((0 != _fseeki64(_file, static_cast<long long>(pos), SEEK_SET)) ||
+			(fread(chunkHeader, 1, sizeof(chunkHeader), _file) != sizeof(chunkHeader)))
+			break;
+
+		const auto chunkSize = GetU32(chunkHeader + 4);
+		const auto bodyPos = pos + sizeof(chunkHeader);
+
+		if (0 == std::memcmp(chunkHeader, "fmt ", 4))
+		{
+			// Only the extensible fields matter past the first 40 bytes
+			std::uint8_t chunk[40] = {};
+			auto numBytes = std::min(chunkSize, static_cast<std::uint32_t>(sizeof(chunk)));
+
+			if ((fread(chunk, 1, numBytes, _file) != numBytes) || !_ReadFormat(chunk, numBytes))
+				return false;
+
+			hasFormat = true;
+		}
+		else if (0 == std::memcmp(chunkHeader, "data", 4))
+		{
+			// Writers that never finished leave the size unset, so the data
+			// runs to the end of the file. All ones is always unset. Zero is
+			// also a valid empty chunk, so is only unset when no chunk
+			// follows it. A size past the end is cut to what is there.
+			const auto isUnset = (UnsetDataSize == chunkSize) ||
+				((0u == chunkSize) && !IsChunkAt(_file, bodyPos, fileLength));
+			_dataOffset = bodyPos;
+			dataSize = isUnset ?
+				fileLength - bodyPos :
+				std::min(static_cast<std::uint64_t>(chunkSize), fileLength - bodyPos);
+			hasData = true;
+
+			// Nothing after unset data can be found
+			if (hasFormat || isUnset)
+				break;
+		}
+
+		// Chunks are padded to an even length
+		pos = bodyPos + chunkSize + (chunkSize & 1u);
+	}
+
+	if (!hasFormat || !hasData)
+		return false;
+
+	_numFrames = dataSize / _format.BytesPerFrame();
+
+	return true;
+}
+
+bool WavFileReader::_ReadFormat(const std::uint8_t* chunk, std::uint32_t chunkSize)
+{
+	if (chunkSize < 16u)
+		return false;
+
+	auto formatTag = GetU16(chunk);
+	const auto numChannels = GetU16(chunk + 2);
+	const auto sampleRate = GetU32(chunk + 4);
+	const auto blockAlign = GetU16(chunk + 12);
+	const auto bitsPerSample = GetU16(chunk + 14);
+
+	// The real format is the start of the sub-format GUID
+	if (FormatExtensible == formatTag)
+	{
+		if (chunkSize < 40u)
+			return false;
+
+		formatTag = GetU16(chunk + 24);
+	}
+
+	if ((FormatPcm == formatTag) && (16u == bitsPerSample))
+		_format.SampleFormat = WavSampleFormat::Int16;
+	else if ((FormatPcm == formatTag) && (24u == bitsPerSample))
+		_format.SampleFormat = WavSampleFormat::Int24;
+	else if ((FormatPcm == formatTag) && (32u == bitsPerSample))
+		_format.SampleFormat = WavSampleFormat::Int32;
+	else if ((FormatFloat == formatTag) && (32u == bitsPerSample))
+		_format.SampleFormat = WavSampleFormat::Float32;
+	else
+		return false;
+
+	_format.NumChannels = numChannels;
+	_format.SampleRate = sampleRate;
+
+	// Rules out samples padded into wider containers
+	return (numChannels > 0u) && (blockAlign == _format.BytesPerFrame());
+}
+
+WavFileWriter::WavFileWriter() :
+	_file(nullptr),
+	_format(),
+	_isDithered(true),
+	_isFailed(false),
+	_numFrames(0u),
+	_factSizeOffset(0),
+	_dataSizeOffset(0),
+	_dataOffset(0),
+	_dither(),
+	_strideBuffer(),
+	_writeBuffer()
+{
+}
+
+WavFileWriter::~WavFileWriter()
+{
+	Close();
+}
+
+bool WavFileWriter::Open(const std::wstring& fileName, WavFormat format)
+{
+	Close();
+
+	if (0u == format.NumChannels)
+		return false;
+
+	if (0 != _wfopen_s(&_file, fileName.c_str(), L"wb"))
+	{
+		std::cout << "Open (Write) wav file error\n";
+		_file = nullptr;
+
+		return false;
+	}
+
+	_format = format;
+	_isFailed = false;
+	_numFrames = 0u;
+	_dither = audio::PcmKernels::Dither();
+
+	if (!_WriteHeader())
+	{
+		_isFailed = true;
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+bool WavFileWriter::Write(const float* src, unsigned long numFrames)
+{
+	if ((nullptr == _file) || _isFailed)
+		return false;
+
+	auto numSamps = numFrames * _format.NumChannels;
+	auto done = 0ul;
+
+	while (done < numSamps)
+	{
+		auto blockSamps = std::min(numSamps - done, WriteBlockSamps);
+		if (!_WriteBlock(src + done, blockSamps))
+			return false;
+
+		done += blockSamps;
+	}
+
+	_numFrames += numFrames;
+
+	return true;
+}
+
+bool WavFileWriter::WriteStrided(const float* src, unsigned long numFrames, unsigned int stride)
+{
+	if ((nullptr == _file) || _isFailed || (1u != _format.NumChannels))
+		return false;
+
+	auto done = 0ul;
+
+	while (done < numFrames)
+	{
+		auto blockSamps = std::min(numFrames - done, WriteBlockSamps);
+		_strideBuffer.resize(blockSamps);
+
+		for (auto i = 0ul; i < blockSamps; i++)
+			_strideBuffer[i] = src[static_cast<std::size_t>(done + i) * stride];
+
+		if (!_WriteBlock(_strideBuffer.data(), blockSamps))
+			return false;
+
+		done += blockSamps;
+	}
+
+	_numFrames += numFrames;
+
+	return true;
+}
+
+bool WavFileWriter::WriteAt(std::uint64_t frame, const float* src, unsigned long numFrames)
+{
+	if ((nullptr == _file) || _isFailed)
+		return false;
+
+	const auto frameBytes = _format.BytesPerFrame();
+
+	if (frame > _numFrames)
+	{
+		// Appends the silence in blocks, from the end of the data
+		_strideBuffer.assign(WriteBlockSamps, 0.0f);
+		auto numSamps = (frame - _numFrames) * _format.NumChannels;
+
+		while (numSamps > 0u)
+		{
+			auto blockSamps = static_cast<unsigned long>(std::min(numSamps, static_cast<std::uint64_t>(WriteBlockSamps)));
+			if (!_WriteBlock(_strideBuffer.data(), blockSamps))
+				return false;
+
+			numSamps -= blockSamps;
+		}
+
+		_numFrames = frame;
+	}
+	else if (0 != _fseeki64(_file, static_cast<long long>(_dataOffset + (frame * frameBytes)), SEEK_SET))
+	{
+		_isFailed = true;
+		return false;
+	}
+
+	auto numSamps = numFrames * _format.NumChannels;
+	auto done = 0ul;
+
+	while (done < numSamps)
+	{
+		auto blockSamps = std::min(numSamps - done, WriteBlockSamps);
+		if (!_WriteBlock(src + done, blockSamps))
+			return false;
+
+		done += blockSamps;
+	}
+
+	_numFrames = std::max(_numFrames, frame + numFrames);
+
+	// Back to the end, for the next append
+	if (0 != _fseeki64(_file, static_cast<long long>(_dataOffset + (_numFrames * frameBytes)), SEEK_SET))
+		_isFailed = true;
+
+	return !_isFailed;
+}
+
+bool WavFileWriter::Flush()
+{
+	if ((nullptr == _file) || _isFailed)
+		return false;
+
+	if (!_PatchSizes(0u) || (0 != fflush(_file)))
+		_isFailed = true;
+
+	return !_isFailed;
+}
+
+bool WavFileWriter::Close()
+{
+	if (nullptr == _file)
+		return false;
+
+	// The data chunk gets a pad byte to keep the length even
+	const auto numPadBytes = static_cast<unsigned int>((_numFrames * _format.BytesPerFrame()) & 1u);
+
+	if (!_isFailed && (numPadBytes > 0u))
+		_isFailed = (EOF == fputc(0, _file));
+
+	if (!_isFailed)
+		_isFailed = !_PatchSizes(numPadBytes);
+
+	if (0 != fclose(_file))
+		_isFailed = true;
+
+	_file = nullptr;
+
+	return !_isFailed;
+}
+
+bool WavFileWriter::_WriteHeader()
+{
+	const auto isFloat = WavSampleFormat::Float32 == _format.SampleFormat;
+	const auto isExtensible = _format.NumChannels > 2u;
+	const auto formatTag = isFloat ? FormatFloat : FormatPcm;
+	const auto bitsPerSample = static_cast<std::uint16_t>(_format.BytesPerSample() * 8u);
+
+	std::vector<std::uint8_t> header;
+	PutId(header, "RIFF");
+	PutU32(header, 0u);
+	PutId(header, "WAVE");
+
+	PutId(header, "fmt ");
+	PutU32(header, isExtensible ? 40u : (isFloat ? 18u : 16u));
+	PutU16(header, isExtensible ? FormatExtensible : formatTag);
+	PutU16(header, static_cast<std::uint16_t>(_format.NumChannels));
+	PutU32(header, _format.SampleRate);
+	PutU32(header, _format.SampleRate * _format.BytesPerFrame());
+	PutU16(header, static_cast<std::uint16_t>(_format.BytesPerFrame()));
+	PutU16(header, bitsPerSample);
+
+	if (isExtensible)
+	{
+		// Front speakers first, in the standard order
+		auto channelMask = (_format.NumChannels < 18u) ? (1u << _format.NumChannels) - 1u : 0u;
+
+		PutU16(header, 22u);
+		PutU16(header, bitsPerSample);
+		PutU32(header, channelMask);
+		PutU16(header, formatTag);
+		header.insert(header.end(), std::begin(SubFormatTail), std::end(SubFormatTail));
+	}
+	else if (isFloat)
+		PutU16(header, 0u);
+
+	_factSizeOffset = 0;
+	if (isFloat)
+	{
+		PutId(header, "fact");
+		PutU32(header, 4u);
+		_factSizeOffset = static_cast<long>(header.size());
+		PutU32(header, 0u);
+	}
+
+	PutId(header, "data");
+	_dataSizeOffset = static_cast<long>(header.size());
+	PutU32(header, 0u);
+	_dataOffset = static_cast<long>(header.size());
+
+	return fwrite(header.data(), 1, header.size(), _file) == header.size();
+}
+
+bool WavFileWriter::_WriteBlock(const float* src, unsigned long numSamps)
+{
+	_writeBuffer.resize(static_cast<std::size_t>(numSamps) * _format.BytesPerSample());
+	auto dither = _isDithered ? &_dither : nullptr;
+
+	switch (_format.SampleFormat)
+	{
+	case WavSampleFormat::Int16:
+		PcmKernels::FloatToInt16(src, numSamps, _writeBuffer.data(), dither);
+		break;
+	case WavSampleFormat::Int24:
+		PcmKernels::FloatToInt24(src, numSamps, _writeBuffer.data(), dither);
+		break;
+	case WavSampleFormat::Int32:
+		PcmKernels::FloatToInt32(src, numSamps, _writeBuffer.data());
+		break;
+	case WavSampleFormat::Float32:
+		PcmKernels::FloatToFloat32(src, numSamps, _writeBuffer.data());
+		break;
+	}
+
+	if (fwrite(_writeBuffer.data(), 1, _writeBuffer.size(), _file) != _writeBuffer.size())
+		_isFailed = true;
+
+	return !_isFailed;
+}
+
+bool WavFileWriter::_PatchSizes(unsigned int numPadBytes)
+{
+	const auto dataBytes = _numFrames * _format.BytesPerFrame();
+	const auto dataEnd = static_cast<std::uint64_t>(_dataOffset) + dataBytes;
+
+	return PatchU32(_file, 4, dataEnd + numPadBytes - 8u) &&
+		PatchU32(_file, _dataSizeOffset, dataBytes) &&
+		((0 == _factSizeOffset) || PatchU32(_file, _factSizeOffset, _numFrames)) &&
+		(0 == _fseeki64(_file, static_cast<long long>(dataEnd + numPadBytes), SEEK_SET));
+}
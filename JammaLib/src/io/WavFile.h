@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "../audio/PcmKernels.h"
+
+namespace io
+{
+	enum class WavSampleFormat
+	{
+		Int16,
+		Int24,
+		Int32,
+		Float32
+	};
+
+	struct WavFormat
+	{
+		WavSampleFormat SampleFormat = WavSampleFormat::Int16;
+		unsigned int NumChannels = 1u;
+		unsigned int SampleRate = 44100u;
+
+		unsigned int BytesPerSample() const noexcept;
+		unsigned int BytesPerFrame() const noexcept { return BytesPerSample() * NumChannels; }
+	};
+
+	// Reads the samples of a WAV file a block at a time, as float.
+	//
+	// Open() walks the RIFF chunks for "fmt " and "data", skipping any
+	// others, and accepts 16/24/32-bit integer and 32-bit float samples in
+	// plain or WAVE_FORMAT_EXTENSIBLE files. Frames come back interleaved.
+	// Reads that carry on from the last one skip the seek.
+	class WavFileReader
+	{
+	public:
+		WavFileReader();
+		~WavFileReader();
+		WavFileReader(const WavFileReader&) = delete;
+		WavFileReader& operator=(const WavFileReader&) = delete;
+
+	public:
+		bool Open(const std::wstring& fileName);
+		void Close();
+		bool IsOpen() const noexcept { return nullptr != _file; }
+		const WavFormat& Format() const noexcept { return _format; }
+		std::uint64_t NumFrames() const noexcept { return _numFrames; }
+
+		// Reads up to numFrames frames from frame into dest, which holds
+		// NumChannels floats per frame, and returns how many were read.
+		unsigned long Read(std::uint64_t frame, float* dest, unsigned long numFrames);
+
+	protected:
+		bool _ReadChunks(std::uint64_t fileLength);
+		bool _ReadFormat(const std::uint8_t* chunk, std::uint32_t chunkSize);
+
+	protected:
+		FILE* _file;
+		WavFormat _format;
+		std::uint64_t _dataOffset;
+		std::uint64_t _numFrames;
+		std::uint64_t _nextFrame;
+		std::vector<std::uint8_t> _readBuffer;
+	};
+
+	// Writes a WAV file a block at a time, from float.
+	//
+	// The header goes out with Open() and its sizes are filled in by
+	// Flush() and Close(), so a file can be written without ever holding
+	// all of it. Files with more than two channels use
+	// WAVE_FORMAT_EXTENSIBLE; float files also get the "fact" chunk their
+	// format calls for. Integer output is dithered unless SetDither(false).
+	class WavFileWriter
+	{
+	public:
+		WavFileWriter();
+		~WavFileWriter();
+		WavFileWriter(const WavFileWriter&) = delete;
+		WavFileWriter& operator=(const WavFileWriter&) = delete;
+
+	public:
+		bool Open(const std::wstring& fileName, WavFormat format);
+		// Writes numFrames interleaved frames.
+		bool Write(const float* src, unsigned long numFrames);
+		// Writes numFrames frames of a mono file from every stride-th sample.
+		bool WriteStrided(const float* src, unsigned long numFrames, unsigned int stride);
+		// Overwrites from frame onwards, filling any gap past the end with
+		// silence. Later Write() calls still append.
+		bool WriteAt(std::uint64_t frame, const float* src, unsigned long numFrames);
+		// Fills in the header for what has been written so far and flushes,
+		// leaving a readable file should the process die.
+		bool Flush();
+		// Finishes the header and closes. False if any write failed.
+		bool Close();
+		bool IsOpen() const noexcept { return nullptr != _file; }
+		std::uint64_t NumFrames() const noexcept { return _numFrames; }
+		void SetDither(bool dither) noexcept { _isDithered = dither; }
+
+	protected:
+		bool _WriteHeader();
+		bool _WriteBlock(const float* src, unsigned long numSamps);
+		// Leaves the file position at the end of the data
+		bool _PatchSizes(unsigned int numPadBytes);
+
+	protected:
+		FILE* _file;
+		WavFormat _format;
+		bool _isDithered;
+		bool _isFailed;
+		std::uint64_t _numFrames;
+		// Where the sizes to fill in live, from the start of the file
+		long _factSizeOffset;
+		long _dataSizeOffset;
+		long _dataOffset;
+		audio::PcmKernels::Dither _dither;
+		std::vector<float> _strideBuffer;
+		std::vector<std::uint8_t> _writeBuffer;
+	};
+}
@@ -1,63 +1,63 @@
 #include "WavReadWriter.h"
 #include <algorithm>
+#include <limits>
 
 using namespace io;
 
+namespace
+{
+	// Samples read per call when loading a whole file
+	constexpr unsigned long ReadBlockSamps = 65536ul;
+}
+
+WavReadWriter::WavReadWriter(WavSampleFormat writeFormat) :
+	_writeFormat(writeFormat)
+{
+}
+
 std::optional<std::tuple<std::vector<float>, unsigned int, unsigned int>>
 	WavReadWriter::_Read(const std::wstring& fileName, unsigned int maxVals) const
 {
-	struct SoundHeader info;
-	struct SoundHeader* pinfo = &info;
-
-	// The variable maxSamps represents the maximum
+	// The variable maxVals represents the maximum
 	// number of 32 bit floats the array can contain.
 	if (maxVals < 1)
 		return std::nullopt;
 
-	auto fileNameStr = utils::EncodeUtf8(fileName);
-	auto cname = new char[fileNameStr.size() + 1];
-	strcpy_s(cname, fileNameStr.size() + 1, fileNameStr.c_str());
-
-	auto fid = OpenSoundIn(cname, pinfo);
-
-	delete[] cname;
+	auto stream = OpenStream(fileName);
 
-	if (fid == NULL)
+	if (!stream)
 		return {};
 
-	size_t numSampsLoaded = maxVals;
+	auto length = std::min(stream->Length(), static_cast<unsigned long>(maxVals));
+	std::vector<float> buffer(length);
+	auto numSampsLoaded = 0ul;
 
-	// Only load the reported number of samples
-	// (but prevent loading more than the array can hold)
-	if (info.dlength < (long)(maxVals * 2))
-		numSampsLoaded = info.dlength / 2; // Two 16 bit integers per sample (32 bit float)
-
-	if (numSampsLoaded < 1)
+	while (numSampsLoaded < length)
 	{
-		numSampsLoaded = 0;
-		fclose(fid);
+		auto numSamps = std::min(length - numSampsLoaded, ReadBlockSamps);
+		auto numRead = stream->Read(numSampsLoaded, buffer.data() + numSampsLoaded, numSamps);
+		numSampsLoaded += numRead;
 
-		return {};
+		if (numRead < numSamps)
+			break;
 	}
 
-	auto bufferIn = new char[numSampsLoaded * 2];  // Two bytes per wav file sample (16 bit integer)
-	auto bytesRead = fread(bufferIn, 1, numSampsLoaded * 2, fid);
-
-	if ((bytesRead / 2) < numSampsLoaded)
-		numSampsLoaded = bytesRead / 2;  // Two bytes per wav file sample (16 bit integer)
+	if (numSampsLoaded < 1)
+		return {};
 
-	fclose(fid);
+	buffer.resize(numSampsLoaded);
 
-	std::vector<float> buffer(numSampsLoaded);
+	return std::make_tuple(std::move(buffer), (unsigned int)numSampsLoaded, stream->SampleRate());
+}
 
-	for (auto i=0U; i<numSampsLoaded; i++)
-	{
-		buffer[i] = CharToFloat(bufferIn + (i * 2));
-	}
+std::unique_ptr<WavStream> WavReadWriter::OpenStream(const std::wstring& fileName) const
+{
+	auto reader = std::make_unique<WavFileReader>();
 
-	delete[] bufferIn;
+	if (!reader->Open(fileName) || (0u == reader->NumFrames()))
+		return nullptr;
 
-	return std::make_tuple(std::move(buffer), (unsigned int)numSampsLoaded, info.srate);
+	return std::make_unique<WavStream>(std::move(reader));
 }
 
 bool WavReadWriter::_Write(std::wstring fileName,
@@ -65,132 +65,54 @@ bool WavReadWriter::_Write(std::wstring fileName,
 	unsigned int numVals,
 	unsigned int sampleRate) const
 {
-	char* cname;
-	char* bufferOut;
-	struct SoundHeader info;
-	struct SoundHeader* pinfo = &info;
-	FILE* fid;
-
-	auto fileNameStr = utils::EncodeUtf8(fileName);
-	cname = new char[fileNameStr.size() + 1];
-	strcpy_s(cname, fileNameStr.size() + 1, fileNameStr.c_str());
+	numVals = std::min(numVals, static_cast<unsigned int>(data.size()));
 
 	if (numVals < 1)
-	{
-		delete[] cname;
 		return false;
-	}
-
-	info.srate = sampleRate;
-	info.dlength = numVals * 2;
-	info.bits_per_samp = 16;
-
-	FillHeader(info);
 
-	fid = OpenSoundOut(cname, pinfo);
+	WavFormat format;
+	format.SampleFormat = _writeFormat;
+	format.NumChannels = 1u;
+	format.SampleRate = sampleRate;
 
-	delete[] cname;
+	WavFileWriter writer;
 
-	if (fid == NULL)
+	if (!writer.Open(fileName, format))
 		return false;
 
-	bufferOut = new char[numVals * 2]; // Two bytes per wav file sample (16 bit integer)
+	auto isWritten = writer.Write(data.data(), numVals);
 
-	for (unsigned int i = 0; i < numVals; i++)
-	{
-		FloatToChar(data[i], bufferOut + (i * 2));
-	}
-
-	fwrite(bufferOut, 1, numVals * 2, fid);
-
-	fclose(fid);
-	delete[] bufferOut;
-
-	return true;
+	return writer.Close() && isWritten;
 }
 
-FILE* WavReadWriter::OpenSoundIn(char *fileName, struct SoundHeader *hdr)
+WavStream::WavStream(std::unique_ptr<WavFileReader> reader) :
+	_reader(std::move(reader)),
+	_length((unsigned long)std::min(_reader->NumFrames(), static_cast<std::uint64_t>(std::numeric_limits<unsigned long>::max()))),
+	_frameBuffer()
 {
-	FILE *myfile;
-
-	// Check file name for .wav extension
-	if (fileName[strlen(fileName) - 1] == 'v')
-	{
-		myfile = _fsopen(fileName, "rb", _SH_DENYNO);
-
-		if (myfile == NULL)
-		{
-			std::cout << "Open (Read) wav file error\n";
-		}
-		else
-			fread(hdr, 1, 44, myfile);
-	}
-	else
-	{
-		std::cout << "You must specify a valid .wav file name\n";
-		myfile = 0;
-	}
-
-	return myfile;
 }
 
-FILE *WavReadWriter::OpenSoundOut(char *fileName, struct SoundHeader *hdr)
+unsigned long WavStream::Read(unsigned long index, float* dest, unsigned long numSamps)
 {
-	FILE *myfile;
-	errno_t err;
-
-	// Check file name for .wav extension
-	if (fileName[strlen(fileName) - 1] == 'v')
-	{
-		err = fopen_s(&myfile, fileName, "wb");
-
-		if (err != 0)
-		{
-			std::cout << "Open (Write) wav file error\n";
-			myfile = 0;
-		}
-		else
-			fwrite(hdr, 1, 44, myfile);
-	}
-	else
-	{
-		std::cout << "You must specify a valid .wav file name\n";
-		myfile = 0;
-	}
+	const auto numChans = _reader->Format().NumChannels;
 
-	return myfile;
-}
+	if (1u == numChans)
+		return _reader->Read(index, dest, numSamps);
 
-void WavReadWriter::FillHeader(struct SoundHeader &hdr)
-{
-	struct SoundHeader myhdr = { "RIF", 88244, "WAV", "fmt", 16, 1, 1,
-		44100, 88200, 2, 16, "dat", 88200 };
-
-	myhdr.srate = hdr.srate;
-	myhdr.bits_per_samp = hdr.bits_per_samp;
-	myhdr.bytes_per_samp = (hdr.bits_per_samp / 8);
-	myhdr.dlength = hdr.dlength;
-	myhdr.flength = hdr.dlength + 44;
-	myhdr.bytes_per_sec = hdr.srate * myhdr.bytes_per_samp;
-	myhdr.riff[3] = 'F';
-	myhdr.wave[3] = 'E';
-	myhdr.fmt[3] = ' ';
-	myhdr.data[3] = 'a';
-	hdr = myhdr;
-}
+	_frameBuffer.resize(static_cast<std::size_t>(numSamps) * numChans);
+	auto numRead = _reader->Read(index, _frameBuffer.data(), numSamps);
+	const auto gain = 1.0f / static_cast<float>(numChans);
 
-void WavReadWriter::FloatToChar(float f, char* c)
-{
-	auto clamped = std::clamp(f, -1.0f, 1.0f);
-	int tempint = (int)(clamped * 32767.0f);
+	for (auto i = 0ul; i < numRead; i++)
+	{
+		const auto* frame = _frameBuffer.data() + (static_cast<std::size_t>(i) * numChans);
+		auto sum = 0.0f;
 
-	*c = (char)(tempint & 0xFF);
-	*(c + 1) = (char)((tempint >> 8) & 0xFF);
-}
+		for (auto chan = 0u; chan < numChans; chan++)
+			sum += frame[chan];
 
-float WavReadWriter::CharToFloat(char* c)
-{
-	short tempshort = (short)(((((short) *(c + 1)) << 8) & 0xFF00) | (((short)*c) & 0x00FF));
+		dest[i] = sum * gain;
+	}
 
-	return (((float)tempshort) / 32768.0f);
+	return numRead;
 }
@@ -1,35 +1,52 @@
 #pragma once
 
+#include <cstdint>
 #include <iostream>
 #include <vector>
 #include <string>
 #include <optional>
 #include <memory>
 #include "FileReadWriter.h"
+#include "WavFile.h"
+#include "../audio/StreamingBank.h"
 #include "../utils/StringUtils.h"
 
 namespace io
 {
-	struct SoundHeader
+	// Reads samples from an open WAV file on demand, for loops that load
+	// or stream from it. Files with more than one channel are mixed down to
+	// mono. Loading and prefetch threads only.
+	class WavStream :
+		public audio::SampleSource
 	{
-		char  riff[4];        /* "RIFF"                                  */
-		long  flength;        /* file length in bytes                    */
-		char  wave[4];        /* "WAVE"                                  */
-		char  fmt[4];         /* "fmt "                                  */
-		long  block_size;     /* in bytes (generally 16)                 */
-		short format_tag;     /* 1=PCM, 257=Mu-Law, 258=A-Law, 259=ADPCM */
-		short num_chans;      /* 1=mono, 2=stereo                        */
-		long  srate;          /* Sampling rate in samples per second     */
-		long  bytes_per_sec;  /* bytes per second                        */
-		short bytes_per_samp; /* 2=16-bit mono, 4=16-bit stereo          */
-		short bits_per_samp;  /* Number of bits per sample               */
-		char  data[4];        /* "data"                                  */
-		long  dlength;        /* data length in bytes (filelength - 44)  */
+	public:
+		WavStream(std::unique_ptr<WavFileReader> reader);
+		WavStream(const WavStream&) = delete;
+		WavStream& operator=(const WavStream&) = delete;
+
+		virtual unsigned long Length() const override { return _length; }
+		virtual unsigned long Read(unsigned long index, float* dest, unsigned long numSamps) override;
+
+		unsigned int SampleRate() const noexcept { return _reader->Format().SampleRate; }
+
+	protected:
+		std::unique_ptr<WavFileReader> _reader;
+		unsigned long _length;
+		std::vector<float> _frameBuffer;
 	};
 
+	// Mono WAV files as a whole, written in writeFormat. Reads accept any
+	// format WavFileReader does.
 	class WavReadWriter :
 		public FileReadWriter<std::vector<float>>
 	{
+	public:
+		WavReadWriter(WavSampleFormat writeFormat = WavSampleFormat::Int16);
+
+	public:
+		// Opens the file for streaming, without reading any samples.
+		std::unique_ptr<WavStream> OpenStream(const std::wstring& fileName) const;
+
 	protected:
 		std::optional<std::tuple<std::vector<float>, unsigned int, unsigned int>>
 			_Read(const std::wstring& fileName, unsigned int maxVals) const;
@@ -40,11 +57,6 @@ namespace io
 			unsigned int sampleRate) const;
 
 	protected:
-		static FILE* OpenSoundIn(char* fileName, struct SoundHeader* hdr);
-		static FILE* OpenSoundOut(char* fileName, struct SoundHeader* hdr);
-		static void FillHeader(struct SoundHeader& hdr);
-
-		static void FloatToChar(float f, char* c);
-		static float CharToFloat(char* c);
+		WavSampleFormat _writeFormat;
 	};
 }
@@ -0,0 +1,156 @@
+#include "LiveMidiInput.h"
+
+using namespace midi;
+
+LiveMidiInput::LiveMidiInput() noexcept :
+	_deviceIngress(),
+	_sharedIngress(),
+	_sharedIngressMutex(),
+	_deviceNamesMutex(),
+	_deviceNames(),
+	_numDevices(0u),
+	_held(),
+	_blockEvents()
+{
+}
+
+std::uint8_t LiveMidiInput::ClaimSlot(const std::string& deviceName)
+{
+	std::scoped_lock lock(_deviceNamesMutex);
+
+	for (auto slot = 0u; slot < _numDevices; slot++)
+	{
+		if (_deviceNames[slot] == deviceName)
+			return static_cast<std::uint8_t>(slot);
+	}
+
+	if (deviceName.empty() || (_numDevices >= MaxDevices))
+		return NoSlot;
+
+	_deviceNames[_numDevices] = deviceName;
+	return static_cast<std::uint8_t>(_numDevices++);
+}
+
+bool LiveMidiInput::PushFromDevice(std::uint8_t slot, const MidiEvent& event) noexcept
+{
+	if (slot >= MaxDevices)
+		return false;
+
+	_UpdateHeld(0u, event);
+	_UpdateHeld(slot + 1u, event);
+
+	return _deviceIngress[slot].Push(event);
+}
+
+void LiveMidiInput::Push(const MidiEvent& event, const std::string& deviceName)
+{
+	_UpdateHeld(0u, event);
+
+	if (!deviceName.empty())
+	{
+		auto slot = ClaimSlot(deviceName);
+		if (NoSlot != slot)
+			_UpdateHeld(slot + 1u, event);
+	}
+
+	std::scoped_lock lock(_sharedIngressMutex);
+	_sharedIngress.Push(event);
+}
+
+std::vector<std::pair<std::string, MidiNoteSnapshot>> LiveMidiInput::HeldNotes() const
+{
+	std::vector<std::pair<std::string, MidiNoteSnapshot>> snapshots;
+	snapshots.push_back({ "", _Snapshot(_held[0]) });
+
+	std::scoped_lock lock(_deviceNamesMutex);
+	for (auto slot = 0u; slot < _numDevices; slot++)
+		snapshots.push_back({ _deviceNames[slot], _Snapshot(_held[slot + 1u]) });
+
+	return snapshots;
+}
+
+void LiveMidiInput::ResetHeldNotes() noexcept
+{
+	for (auto& held : _held)
+	{
+		for (auto& velocity : held)
+			velocity.store(0u, std::memory_order_relaxed);
+	}
+}
+
+std::uint32_t LiveMidiInput::PlaceInBlock(std::uint32_t eventSample,
+	std::uint32_t blockStartSample,
+	unsigned int numSamps) noexcept
+{
+	if (0u == numSamps)
+		return blockStartSample;
+
+	// Signed, so events either side of the sample counter wrapping still place
+	auto offset = static_cast<std::int32_t>(eventSample - blockStartSample);
+	if (offset < 0)
+		return blockStartSample;
+
+	if (static_cast<std::uint32_t>(offset) >= numSamps)
+		return blockStartSample + (numSamps - 1u);
+
+	return blockStartSample + static_cast<std::uint32_t>(offset);
+}
+
+std::uint64_t LiveMidiInput::DroppedCount() const noexcept
+{
+	auto dropped = _sharedIngress.DroppedCount();
+	for (const auto& ingress : _deviceIngress)
+		dropped += ingress.DroppedCount();
+
+	return dropped;
+}
+
+void LiveMidiInput::_UpdateHeld(std::size_t heldIndex, const MidiEvent& event) noexcept
+{
+	if (event.IsNoteOn())
+		_held[heldIndex][MidiNote::NoteSlot(event.Channel(), event.data1)].store(event.data2, std::memory_order_relaxed);
+	else if (event.IsNoteOff())
+		_held[heldIndex][MidiNote::NoteSlot(event.Channel(), event.data1)].store(0u, std::memory_order_relaxed);
+}
+
+std::size_t LiveMidiInput::_GatherDeviceEvents(std::uint32_t blockStartSample, unsigned int numSamps) noexcept
+{
+	// Sort on the offset within the block rather than the absolute sample,
+	// so ordering survives the sample counter wrapping. Anything past
+	// MaxBlockEvents waits in its ring for the next block.
+	std::size_t numEvents = 0u;
+	MidiEvent event{};
+
+	for (auto& ingress : _deviceIngress)
+	{
+		while ((numEvents < MaxBlockEvents) && ingress.Pop(event))
+		{
+			event.sampleOffset = PlaceInBlock(event.sampleOffset, blockStartSample, numSamps) - blockStartSample;
+			_blockEvents[numEvents++] = event;
+		}
+	}
+
+	MidiNote::SortMidiEvents(_blockEvents.data(), numEvents);
+
+	for (std::size_t i = 0u; i < numEvents; ++i)
+		_blockEvents[i].sampleOffset += blockStartSample;
+
+	return numEvents;
+}
+
+MidiNoteSnapshot LiveMidiInput::_Snapshot(const HeldVelocities& held) noexcept
+{
+	MidiNoteSnapshot snapshot;
+
+	for (std::size_t slot = 0u; slot < MidiNote::TotalNoteSlots; ++slot)
+	{
+		auto velocity = held[slot].load(std::memory_order_relaxed);
+		if (velocity > 0u)
+		{
+			snapshot.Held.set(slot);
+			snapshot.Velocity[slot] = velocity;
+		}
+	}
+
+	return snapshot;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "MidiEvent.h"
+#include "MidiNote.h"
+#include "MidiQueue.h"
+
+namespace midi
+{
+	// Live MIDI bound for one station's instruments.
+	//
+	// Each MIDI input device claims a slot, and its callback pushes straight
+	// into that slot's ring, so notes reach the audio thread without passing
+	// through the MIDI dispatch thread. Device events carry the audio sample
+	// their arrival maps to (see MapMidiTimestampToAudioSample), and ReadBlock()
+	// plays them at the matching offset in the block instead of at its start.
+	//
+	// Events from anywhere else, such as punch-in transitions from the action
+	// thread, share one more ring whose producers are serialised by a mutex.
+	// These keep the sample offset they were given.
+	//
+	// Held notes are kept in atomics, per device slot and for all devices
+	// together, so a recording can pick up the held chord while the device
+	// callbacks keep writing.
+	class LiveMidiInput
+	{
+	public:
+		static constexpr std::size_t MaxDevices = 8u;
+		static constexpr std::uint8_t NoSlot = 0xffu;
+		static constexpr std::size_t DeviceRingCapacity = 256u;
+		static constexpr std::size_t MaxBlockEvents = 256u;
+
+	public:
+		LiveMidiInput() noexcept;
+
+		LiveMidiInput(const LiveMidiInput&) = delete;
+		LiveMidiInput& operator=(const LiveMidiInput&) = delete;
+
+		// Returns the slot for the named device, claiming a free one the first
+		// time a name is seen, or NoSlot if all slots are taken. Not real-time.
+		std::uint8_t ClaimSlot(const std::string& deviceName);
+		// Device callback only, one producer per slot. Returns false if the
+		// ring is full and the event was dropped.
+		bool PushFromDevice(std::uint8_t slot, const MidiEvent& event) noexcept;
+		// Any thread. An empty deviceName only updates the held notes for all
+		// devices.
+		void Push(const MidiEvent& event, const std::string& deviceName);
+
+		// One snapshot for all devices, keyed by the empty name, then one per
+		// claimed device.
+		std::vector<std::pair<std::string, MidiNoteSnapshot>> HeldNotes() const;
+		void ResetHeldNotes() noexcept;
+
+		// Audio thread. Hands every pending event to onEvent: shared events
+		// first, then device events in time order, placed within the block
+		// starting at blockStartSample.
+		template <typename OnEvent>
+		void ReadBlock(std::uint32_t blockStartSample,
+			unsigned int numSamps,
+			OnEvent&& onEvent) noexcept
+		{
+			MidiEvent event{};
+			while (_sharedIngress.Pop(event))
+				onEvent(event);
+
+			const auto numEvents = _GatherDeviceEvents(blockStartSample, numSamps);
+			for (std::size_t i = 0u; i < numEvents; ++i)
+				onEvent(_blockEvents[i]);
+		}
+
+		// Absolute sample an event mapped to eventSample plays at in the block.
+		// Events mapped before the block play at its first sample, and any
+		// mapped past it at its last.
+		static std::uint32_t PlaceInBlock(std::uint32_t eventSample,
+			std::uint32_t blockStartSample,
+			unsigned int numSamps) noexcept;
+
+		std::uint64_t DroppedCount() const noexcept;
+
+	protected:
+		using HeldVelocities = std::array<std::atomic<std::uint8_t>, MidiNote::TotalNoteSlots>;
+
+		void _UpdateHeld(std::size_t heldIndex, const MidiEvent& event) noexcept;
+		std::size_t _GatherDeviceEvents(std::uint32_t blockStartSample, unsigned int numSamps) noexcept;
+		static MidiNoteSnapshot _Snapshot(const HeldVelocities& held) noexcept;
+
+	protected:
+		std::array<MidiQueue<DeviceRingCapacity>, MaxDevices> _deviceIngress;
+		MidiQueue<1024> _sharedIngress;
+		std::mutex _sharedIngressMutex;
+
+		mutable std::mutex _deviceNamesMutex;
+		std::array<std::string, MaxDevices> _deviceNames;
+		std::size_t _numDevices;
+
+		// Index 0 holds notes from every source, index slot + 1 each device
+		std::array<HeldVelocities, MaxDevices + 1u> _held;
+
+		// Audio thread only
+		std::array<MidiEvent, MaxBlockEvents> _blockEvents;
+	};
+}
@@ -0,0 +1,91 @@
+#include "MidiLatencyMonitor.h"
+
+#include <iomanip>
+#include <sstream>
+
+using namespace midi;
+using audio::CallbackProfiler;
+
+MidiLatencyMonitor::MidiLatencyMonitor() :
+	_isEnabled(false),
+	_buckets(),
+	_totalNs(0u),
+	_maxNs(0u)
+{
+	Reset();
+}
+
+MidiLatencyMonitor& MidiLatencyMonitor::Instance()
+{
+	static MidiLatencyMonitor monitor;
+	return monitor;
+}
+
+void MidiLatencyMonitor::SetEnabled(bool isEnabled) noexcept
+{
+	_isEnabled.store(isEnabled, std::memory_order_relaxed);
+}
+
+void MidiLatencyMonitor::Record(std::uint64_t latencyNs) noexcept
+{
+	_buckets[CallbackProfiler::BucketIndex(latencyNs)].fetch_add(1u, std::memory_order_relaxed);
+	_totalNs.fetch_add(latencyNs, std::memory_order_relaxed);
+
+	if (latencyNs > _maxNs.load(std::memory_order_relaxed))
+		_maxNs.store(latencyNs, std::memory_order_relaxed);
+}
+
+MidiLatencyMonitor::Histogram MidiLatencyMonitor::TakeHistogram() const
+{
+	Histogram histogram;
+	for (auto bucket = 0u; bucket < CallbackProfiler::NumBuckets; bucket++)
+	{
+		histogram.Buckets[bucket] = _buckets[bucket].load(std::memory_order_relaxed);
+		histogram.Count += histogram.Buckets[bucket];
+	}
+
+	histogram.TotalNs = _totalNs.load(std::memory_order_relaxed);
+	histogram.MaxNs = _maxNs.load(std::memory_order_relaxed);
+
+	return histogram;
+}
+
+MidiLatencyMonitor::Stats MidiLatencyMonitor::Summarise(const Histogram& histogram)
+{
+	Stats stats;
+	stats.Count = histogram.Count;
+
+	if (0u == histogram.Count)
+		return stats;
+
+	stats.P50Us = static_cast<double>(CallbackProfiler::Percentile(histogram, 0.5)) / 1000.0;
+	stats.P90Us = static_cast<double>(CallbackProfiler::Percentile(histogram, 0.9)) / 1000.0;
+	stats.P99Us = static_cast<double>(CallbackProfiler::Percentile(histogram, 0.99)) / 1000.0;
+	stats.MaxUs = static_cast<double>(histogram.MaxNs) / 1000.0;
+	stats.MeanUs = static_cast<double>(histogram.TotalNs) / (1000.0 * static_cast<double>(histogram.Count));
+
+	return stats;
+}
+
+void MidiLatencyMonitor::Reset()
+{
+	for (auto& bucket : _buckets)
+		bucket.store(0u, std::memory_order_relaxed);
+
+	_totalNs.store(0u, std::memory_order_relaxed);
+	_maxNs.store(0u, std::memory_order_relaxed);
+}
+
+std::string MidiLatencyMonitor::FormatStats(const Stats& stats)
+{
+	std::stringstream ss;
+	ss << std::fixed << std::setprecision(1)
+		<< "n=" << stats.Count
+		<< "  p50 " << stats.P50Us << "us"
+		<< "  p90 " << stats.P90Us << "us"
+		<< "  p99 " << stats.P99Us << "us"
+		<< "  max " << stats.MaxUs << "us"
+		<< "  mean " << stats.MeanUs << "us";
+
+	return ss.str();
+}
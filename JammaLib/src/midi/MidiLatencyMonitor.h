@@ -0,0 +1,60 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include "../audio/CallbackProfiler.h"
+
+namespace midi
+{
+	// Measures how long MIDI input waits between the device callback and
+	// dispatch to triggers, stations and automation.
+	//
+	// Latencies go into the same log-linear histogram CallbackProfiler uses.
+	// Recording happens on the MIDI dispatch thread only, and only while
+	// measuring is switched on, so normal running never reads the clock for
+	// it. Reports are cumulative until Reset().
+	class MidiLatencyMonitor
+	{
+	public:
+		using Histogram = audio::CallbackProfiler::StageCapture;
+
+		struct Stats
+		{
+			std::uint64_t Count = 0u;
+			double P50Us = 0.0;
+			double P90Us = 0.0;
+			double P99Us = 0.0;
+			double MaxUs = 0.0;
+			double MeanUs = 0.0;
+		};
+
+	public:
+		MidiLatencyMonitor(const MidiLatencyMonitor&) = delete;
+		MidiLatencyMonitor& operator=(const MidiLatencyMonitor&) = delete;
+
+		static MidiLatencyMonitor& Instance();
+
+		bool IsEnabled() const noexcept { return _isEnabled.load(std::memory_order_relaxed); }
+		void SetEnabled(bool isEnabled) noexcept;
+
+		// Dispatch thread
+		void Record(std::uint64_t latencyNs) noexcept;
+
+		Histogram TakeHistogram() const;
+		static Stats Summarise(const Histogram& histogram);
+		Stats Report() const { return Summarise(TakeHistogram()); }
+		void Reset();
+		static std::string FormatStats(const Stats& stats);
+
+	protected:
+		MidiLatencyMonitor();
+
+	protected:
+		std::atomic<bool> _isEnabled;
+		std::array<std::atomic<std::uint64_t>, audio::CallbackProfiler::NumBuckets> _buckets;
+		std::atomic<std::uint64_t> _totalNs;
+		std::atomic<std::uint64_t> _maxNs;
+	};
+}
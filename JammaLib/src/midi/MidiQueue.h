@@ -4,31 +4,34 @@
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <type_traits>
 
 #include "MidiEvent.h"
 
 namespace midi
 {
 	// Lock-free single-producer/single-consumer ring of MidiEvents for the MIDI ingress path.
+	// The element type can be swapped for any trivially copyable event that wraps one.
 	//
 	// Real-time invariants:
 	//   - No heap allocation: storage is a fixed-size std::array.
 	//   - No locks: only acquire/release atomics.
-	//   - Push (producer / MIDI device callback) and Pop (consumer / job thread) are wait-free.
+	//   - Push (producer / MIDI device callback) and Pop (consumer / MIDI dispatch thread) are wait-free.
 	//
 	// Overflow policy: drop-newest.
 	// When the ring is full, Push() leaves queued events untouched, increments dropped count,
 	// and returns false so the caller can count drops.
 	//
 	// Capacity is a compile-time power of two so head/tail can be masked instead of modded.
-	template <std::size_t Capacity>
+	template <std::size_t Capacity, typename T = midi::MidiEvent>
 	class MidiQueue
 	{
 		static_assert(Capacity >= 2, "Capacity must be at least 2");
 		static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+		static_assert(std::is_trivially_copyable_v<T>, "Events must be trivially copyable");
 
 	public:
-		using value_type = midi::MidiEvent;
+		using value_type = T;
 		static constexpr std::size_t capacity = Capacity;
 
 		MidiQueue() noexcept
@@ -1,5 +1,6 @@
 #include "MidiRouter.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cmath>
 #include <iostream>
@@ -10,6 +11,7 @@
 #include "../engine/Trigger.h"
 #include "../io/UserConfig.h"
 #include "../vst/IVstPlugin.h"
+#include "MidiLatencyMonitor.h"
 #include "MidiTimestampMapper.h"
 #include "MidiLoop.h"
 using namespace midi;
@@ -312,11 +314,13 @@ void MidiRouter::InitMidi(const io::UserConfig& cfg,
 
 		auto opened = endpoint->Device->Open(
 			endpoint->ConfiguredName,
-			[endpoint, sampleRate, audioSampleCounter = &audioSampleCounter, midiAnchorMicros = &midiAnchorMicros](std::uint8_t status, std::uint8_t data1, std::uint8_t data2)
+			[this, endpoint, sampleRate, audioSampleCounter = &audioSampleCounter, midiAnchorMicros = &midiAnchorMicros](std::uint8_t status, std::uint8_t data1, std::uint8_t data2)
 			{
-				midi::MidiEvent ingress{};
-				const auto nowMicros = std::chrono::duration_cast<std::chrono::microseconds>(
+				TimedMidiEvent timed{};
+				auto& ingress = timed.Event;
+				const auto nowNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
 					std::chrono::steady_clock::now().time_since_epoch()).count();
+				const auto nowMicros = nowNs / 1000;
 				const auto anchorSample = audioSampleCounter->load(std::memory_order_acquire);
 				const auto anchorMicros = midiAnchorMicros->load(std::memory_order_acquire);
 				const auto mappedSample = midi::MapMidiTimestampToAudioSample(sampleRate,
@@ -329,7 +333,23 @@ void MidiRouter::InitMidi(const io::UserConfig& cfg,
 				ingress.data1 = data1;
 				ingress.data2 = data2;
 				ingress._pad = 0u;
-				endpoint->Ingress.Push(ingress);
+				timed.IngressNs = nowNs;
+
+				// Channel messages also go straight to the stations playing
+				// this device, timestamped for the audio thread to place
+				const auto msgType = ingress.MessageType();
+				if ((msgType >= 0x80u) && (msgType <= 0xE0u))
+				{
+					utils::EpochReadGuard guard;
+					if (const auto* targets = endpoint->LiveTargets.Load())
+					{
+						for (const auto& target : *targets)
+							target.Input->PushFromDevice(target.Slot, ingress);
+					}
+				}
+
+				if (endpoint->Ingress.Push(timed))
+					_ingressSignal.Notify();
 			},
 			loggingConfig.Midi == "verbose");
 
@@ -400,7 +420,9 @@ void MidiRouter::CloseMidi()
 	}
 }
 
-void MidiRouter::InitSerial(const io::UserConfig& cfg)
+void MidiRouter::InitSerial(const io::UserConfig& cfg,
+	std::atomic<std::uint64_t>& audioSampleCounter,
+	std::atomic<std::int64_t>& midiAnchorMicros)
 {
 	CloseSerial();
 	{
@@ -417,6 +439,7 @@ void MidiRouter::InitSerial(const io::UserConfig& cfg)
 	for (const auto& port : availablePorts)
 		std::cout << "[Serial]   " << port << std::endl;
 
+	const auto sampleRate = cfg.Audio.SampleRate;
 	unsigned int activeConnections = 0u;
 	for (const auto& serialConfig : cfg.Serial.Devices)
 	{
@@ -437,10 +460,12 @@ void MidiRouter::InitSerial(const io::UserConfig& cfg)
 			serialConfig.Name,
 			serialConfig.Port,
 			serialConfig.BaudRate,
-			[this](const io::SerialTriggerEvent& event)
+			[this, sampleRate, audioSampleCounter = &audioSampleCounter, midiAnchorMicros = &midiAnchorMicros](const io::SerialTriggerEvent& event)
 			{
-				std::scoped_lock lock(_serialIngressMutex);
-				_serialIngress.Push(event);
+				PushSerialEvent(event,
+					sampleRate,
+					audioSampleCounter->load(std::memory_order_acquire),
+					midiAnchorMicros->load(std::memory_order_acquire));
 			});
 
 		if (!opened)
@@ -637,7 +662,9 @@ MidiRouter::TriggerDispatchSummary MidiRouter::PumpMidi(const std::vector<std::s
 	const audio::AudioStreamParams& audioParams) noexcept
 {
 	TriggerDispatchSummary summary;
-	midi::MidiEvent ingress{};
+	TimedMidiEvent timed{};
+	const auto& ingress = timed.Event;
+	auto& latencyMonitor = MidiLatencyMonitor::Instance();
 	const auto midiInputs = _midiInputs.load(std::memory_order_acquire);
 	if (!midiInputs)
 	{
@@ -649,21 +676,27 @@ MidiRouter::TriggerDispatchSummary MidiRouter::PumpMidi(const std::vector<std::s
 		if (!input)
 			continue;
 
-		while (input->Ingress.Pop(ingress))
+		_PublishLiveMidiTargets(*input, stations);
+
+		while (input->Ingress.Pop(timed))
 		{
-			auto dispatch = _DispatchMidiTriggerEvent(input->DeviceSlot, ingress, userConfig, audioParams);
+			if (latencyMonitor.IsEnabled())
+			{
+				const auto nowNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+					std::chrono::steady_clock::now().time_since_epoch()).count();
+				latencyMonitor.Record(static_cast<std::uint64_t>(std::max<std::int64_t>(nowNs - timed.IngressNs, 0)));
+			}
+
+			auto dispatch = _DispatchMidiTriggerEvent(input->DeviceSlot, ingress, globalSampleNow, userConfig, audioParams);
 			summary.Activated = summary.Activated || dispatch.Activated;
 			summary.Ditched = summary.Ditched || dispatch.Ditched;
 
 			const auto msgType = ingress.MessageType();
 			if ((msgType >= 0x80u) && (msgType <= 0xE0u))
 			{
-				const auto& deviceName = input->ConfiguredName;
-				for (const auto& station : stations)
-				{
-					if (station && !station->IsRemote() && station->AcceptsLiveMidiFromDevice(deviceName))
-						station->EnqueueLiveMidiEvent(ingress, deviceName);
-				}
+				// Most stations were already played from the device callback
+				for (const auto& station : input->PumpedStations)
+					station->EnqueueLiveMidiEvent(ingress, input->ConfiguredName);
 			}
 
 			// Control Change handling: MIDI-learn capture and automation recording.
@@ -747,7 +780,27 @@ MidiRouter::TriggerDispatchSummary MidiRouter::PumpMidi(const std::vector<std::s
 	return summary;
 }
 
+void MidiRouter::PushSerialEvent(const io::SerialTriggerEvent& event,
+	unsigned int sampleRate,
+	std::uint64_t anchorSample,
+	std::int64_t anchorMicros)
+{
+	auto timed = event;
+	timed.SampleTime = static_cast<std::uint32_t>(midi::MapMidiTimestampToAudioSample(sampleRate,
+		anchorSample,
+		anchorMicros,
+		event.ArrivalMicros));
+
+	{
+		std::scoped_lock lock(_serialIngressMutex);
+		_serialIngress.Push(timed);
+	}
+
+	_ingressSignal.Notify();
+}
+
 MidiRouter::TriggerDispatchSummary MidiRouter::PumpSerial(const std::vector<std::shared_ptr<engine::Station>>& stations,
+	std::uint64_t globalSampleNow,
 	const io::UserConfig& userConfig,
 	const audio::AudioStreamParams& audioParams) noexcept
 {
@@ -766,6 +819,7 @@ MidiRouter::TriggerDispatchSummary MidiRouter::PumpSerial(const std::vector<std:
 		action.SetActionTime(utils::Timer::GetTime());
 		action.SetUserConfig(userConfig);
 		action.SetAudioParams(audioParams);
+		action.SetSampleTime(_WidenSampleTime(globalSampleNow, ev.SampleTime));
 		const auto& device = ev.Device ? *ev.Device : EmptyDevice;
 
 		for (const auto& station : stations)
@@ -802,6 +856,7 @@ MidiRouter::TriggerDispatchSummary MidiRouter::PumpSerial(const std::vector<std:
 
 MidiRouter::TriggerDispatchSummary MidiRouter::_DispatchMidiTriggerEvent(std::uint8_t deviceSlot,
 	const midi::MidiEvent& event,
+	std::uint64_t globalSampleNow,
 	const io::UserConfig& userConfig,
 	const audio::AudioStreamParams& audioParams)
 {
@@ -811,6 +866,8 @@ MidiRouter::TriggerDispatchSummary MidiRouter::_DispatchMidiTriggerEvent(std::ui
 	triggerAction.SetAudioParams(audioParams);
 	triggerAction.SetActionTime(utils::Timer::GetTime());
 
+	triggerAction.SetSampleTime(_WidenSampleTime(globalSampleNow, event.sampleOffset));
+
 	auto routes = _midiTriggerRoutesSnapshot.load(std::memory_order_acquire);
 	if (!routes)
 		return summary;
@@ -839,8 +896,55 @@ MidiRouter::TriggerDispatchSummary MidiRouter::_DispatchMidiTriggerEvent(std::ui
 	return summary;
 }
 
+std::uint64_t MidiRouter::_WidenSampleTime(std::uint64_t globalSampleNow, std::uint32_t sampleTime) noexcept
+{
+	// Ingress timestamps hold the low 32 bits of the mapped engine sample,
+	// so widen them against the current sample count
+	const auto lag = static_cast<std::int32_t>(static_cast<std::uint32_t>(globalSampleNow) - sampleTime);
+	return static_cast<std::uint64_t>(static_cast<std::int64_t>(globalSampleNow) - lag);
+}
+
 void MidiRouter::_PublishMidiTriggerRoutes()
 {
 	auto routes = std::make_shared<const std::vector<MidiTriggerRoute>>(_midiTriggerRoutes.begin(), _midiTriggerRoutes.end());
 	_midiTriggerRoutesSnapshot.store(routes, std::memory_order_release);
-}
\ No newline at end of file
+}
+
+void MidiRouter::_PublishLiveMidiTargets(MidiInputEndpoint& input,
+	const std::vector<std::shared_ptr<engine::Station>>& stations)
+{
+	// Runs every pump, so only compare against what was last published.
+	// Slots are claimed (under the input's lock) once the routes change.
+	input.NextRoutedInputs.clear();
+
+	for (const auto& station : stations)
+	{
+		if (!station || station->IsRemote() || !station->AcceptsLiveMidiFromDevice(input.ConfiguredName))
+			continue;
+
+		input.NextRoutedInputs.push_back(station->LiveMidi().get());
+	}
+
+	if (input.LiveTargets.Load() && (input.NextRoutedInputs == input.RoutedInputs))
+		return;
+
+	auto targets = std::make_shared<std::vector<LiveMidiTarget>>();
+	input.PumpedStations.clear();
+
+	for (const auto& station : stations)
+	{
+		if (!station || station->IsRemote() || !station->AcceptsLiveMidiFromDevice(input.ConfiguredName))
+			continue;
+
+		auto liveMidi = station->LiveMidi();
+		auto slot = liveMidi->ClaimSlot(input.ConfiguredName);
+
+		if (midi::LiveMidiInput::NoSlot == slot)
+			input.PumpedStations.push_back(station);
+		else
+			targets->push_back({ liveMidi, slot });
+	}
+
+	input.LiveTargets.Publish(std::move(targets));
+	input.RoutedInputs.swap(input.NextRoutedInputs);
+}
@@ -2,6 +2,7 @@
 
 #include <array>
 #include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
@@ -16,8 +17,11 @@
 #include "../io/SerialDevice.h"
 #include "../io/SerialTriggerQueue.h"
 #include "../midi/MidiDevice.h"
+#include "../midi/LiveMidiInput.h"
 #include "../midi/MidiEvent.h"
 #include "../midi/MidiQueue.h"
+#include "../utils/Epoch.h"
+#include "../utils/WakeSignal.h"
 
 namespace io
 {
@@ -62,7 +66,9 @@ namespace midi
 			std::atomic<std::uint64_t>& audioSampleCounter,
 			std::atomic<std::int64_t>& midiAnchorMicros);
 		void CloseMidi();
-		void InitSerial(const io::UserConfig& cfg);
+		void InitSerial(const io::UserConfig& cfg,
+			std::atomic<std::uint64_t>& audioSampleCounter,
+			std::atomic<std::int64_t>& midiAnchorMicros);
 		void CloseSerial();
 		void RegisterTrigger(const std::string& deviceName, std::shared_ptr<engine::Trigger> trigger);
 
@@ -71,10 +77,25 @@ namespace midi
 			const io::UserConfig& userConfig,
 			const audio::AudioStreamParams& audioParams) noexcept;
 
+		// Maps a serial event's arrival onto the audio timeline the same way
+		// as MIDI, from the sample counter and anchor time the device
+		// callback read, and queues it for PumpSerial().
+		void PushSerialEvent(const io::SerialTriggerEvent& event,
+			unsigned int sampleRate,
+			std::uint64_t anchorSample,
+			std::int64_t anchorMicros);
+		// Serial events apply at the sample they arrived at, like MIDI
 		TriggerDispatchSummary PumpSerial(const std::vector<std::shared_ptr<engine::Station>>& stations,
+			std::uint64_t globalSampleNow,
 			const io::UserConfig& userConfig,
 			const audio::AudioStreamParams& audioParams) noexcept;
 
+		// Blocks the dispatch thread until a MIDI or serial device pushes
+		// input, WakeIngress() is called or the timeout passes. Returns true
+		// if woken before the timeout.
+		bool WaitForIngress(std::chrono::milliseconds timeout) { return _ingressSignal.Wait(timeout); }
+		void WakeIngress() noexcept { _ingressSignal.Notify(); }
+
 		actions::ActionResult HandleAutomationKey(const actions::KeyAction& action,
 			const std::vector<std::shared_ptr<engine::Station>>& stations,
 			const std::vector<unsigned char>& hoverPath,
@@ -110,13 +131,41 @@ namespace midi
 	private:
 		static constexpr std::uint8_t UnresolvedMidiDeviceSlot = 0xffu;
 
+		// Steady clock time of the device callback rides along with each
+		// event, for MidiLatencyMonitor
+		struct TimedMidiEvent
+		{
+			midi::MidiEvent Event;
+			std::int64_t IngressNs;
+		};
+
+		// A station's live input, and the slot this device has in it
+		struct LiveMidiTarget
+		{
+			std::shared_ptr<midi::LiveMidiInput> Input;
+			std::uint8_t Slot = midi::LiveMidiInput::NoSlot;
+		};
+
 		struct MidiInputEndpoint
 		{
 			std::uint8_t DeviceSlot = 0u;
 			std::string ConfiguredName;
 			std::unique_ptr<midi::MidiDevice> Device;
-			midi::MidiQueue<1024> Ingress;
+			midi::MidiQueue<1024, TimedMidiEvent> Ingress;
 			std::uint64_t LastDroppedCount = 0u;
+			// Stations the device callback plays directly, loaded under an
+			// EpochReadGuard. Republished by the dispatch thread when the
+			// stations taking this device change.
+			utils::EpochPtr<const std::vector<LiveMidiTarget>> LiveTargets;
+			// Stations with no free slot, fed by the dispatch thread instead.
+			// Dispatch thread only.
+			std::vector<std::shared_ptr<engine::Station>> PumpedStations;
+			// Live inputs of the stations taking this device, in order, as
+			// last published. Held alive by LiveTargets and PumpedStations,
+			// so an address can't be reused while it is listed here.
+			// Dispatch thread only.
+			std::vector<const midi::LiveMidiInput*> RoutedInputs;
+			std::vector<const midi::LiveMidiInput*> NextRoutedInputs;
 		};
 
 		struct MidiTriggerRoute
@@ -128,6 +177,7 @@ namespace midi
 
 		TriggerDispatchSummary _DispatchMidiTriggerEvent(std::uint8_t deviceSlot,
 			const midi::MidiEvent& event,
+			std::uint64_t globalSampleNow,
 			const io::UserConfig& userConfig,
 			const audio::AudioStreamParams& audioParams);
 		std::pair<std::shared_ptr<engine::Station>, std::shared_ptr<midi::MidiLoop>> _ResolveAutomationTarget(
@@ -135,6 +185,9 @@ namespace midi
 			const std::vector<unsigned char>& hoverPath,
 			const std::shared_ptr<engine::LoopTake>& hoveredTake) const;
 		void _PublishMidiTriggerRoutes();
+		static std::uint64_t _WidenSampleTime(std::uint64_t globalSampleNow, std::uint32_t sampleTime) noexcept;
+		void _PublishLiveMidiTargets(MidiInputEndpoint& input,
+			const std::vector<std::shared_ptr<engine::Station>>& stations);
 
 		// Non-RT: poll vst::_lastTouchedParam for a fresh editor-origin parameter
 		// change and, while automation record is held, record it into the owning
@@ -152,6 +205,7 @@ namespace midi
 		io::SerialTriggerQueue<256> _serialIngress;
 		std::mutex _serialIngressMutex;
 		std::uint64_t _lastSerialDropCount = 0u;
+		utils::WakeSignal _ingressSignal;
 		std::atomic<bool> _learnMidiCCMode{ false };
 		std::atomic<std::uint8_t> _learnedCC{ LearnNothingCaptured };
 		std::atomic<std::uint8_t> _learnedChannel{ LearnNothingCaptured };
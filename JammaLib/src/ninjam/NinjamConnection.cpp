@@ -8,6 +8,7 @@
 #include <set>
 #include "njclient.h"
 #include "../../include/Constants.h"
+#include "../audio/CallbackProfiler.h"
 
 namespace
 {
@@ -331,6 +332,8 @@ void NinjamConnection::ProcessAudioBlock(const float* interleavedInput,
 	unsigned int numFrames,
 	unsigned int sampleRate)
 {
+	JAMMA_PROFILE_SCOPE(STAGE_NINJAM);
+
 	if (!_isConnected || !_client || numFrames == 0u)
 		return;
 
@@ -0,0 +1,55 @@
+#include "BatchUtils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace utils
+{
+	unsigned int RunBatch(std::size_t numTasks,
+		unsigned int numWorkers,
+		const std::function<void(std::size_t)>& runTask)
+	{
+		const auto maxWorkers = static_cast<unsigned int>(std::min<std::size_t>(numWorkers, numTasks));
+		const auto numThreads = std::max(1u, maxWorkers);
+
+		std::atomic<std::size_t> nextTask(0u);
+		auto runTasks = [&]() {
+			while (true)
+			{
+				auto index = nextTask.fetch_add(1u, std::memory_order_relaxed);
+				if (index >= numTasks)
+					return;
+
+				runTask(index);
+			}
+		};
+
+		std::vector<std::thread> workers;
+		for (auto i = 1u; i < numThreads; i++)
+			workers.emplace_back(runTasks);
+
+		runTasks();
+
+		for (auto& worker : workers)
+			worker.join();
+
+		return numThreads;
+	}
+
+	std::string FormatThroughput(std::uint64_t numBytes, double elapsedSecs)
+	{
+		const auto megabytes = static_cast<double>(numBytes) / (1024.0 * 1024.0);
+		const auto rate = (elapsedSecs > 0.0) ? megabytes / elapsedSecs : 0.0;
+
+		std::stringstream ss;
+		ss << std::fixed << std::setprecision(1)
+			<< megabytes << " MB in " << elapsedSecs << "s"
+			<< " (" << rate << " MB/s)";
+
+		return ss.str();
+	}
+}
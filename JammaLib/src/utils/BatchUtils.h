@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace utils
+{
+	// Calls runTask(index) once for every index below numTasks, spread over
+	// up to numWorkers threads with the calling thread as one of them.
+	// Workers take the next index in turn, so tasks must not depend on each
+	// other. Returns the number of threads used, once every task is done.
+	// Never uses more threads than there are tasks, nor fewer than one.
+	unsigned int RunBatch(std::size_t numTasks,
+		unsigned int numWorkers,
+		const std::function<void(std::size_t)>& runTask);
+
+	// "6.0 MB in 2.0s (3.0 MB/s)", as loading and exporting a session
+	// report it.
+	std::string FormatThroughput(std::uint64_t numBytes, double elapsedSecs);
+}
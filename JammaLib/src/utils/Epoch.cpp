@@ -0,0 +1,165 @@
+#include "Epoch.h"
+
+#include <algorithm>
+#include <limits>
+
+using namespace utils;
+
+thread_local EpochDomain::ThreadReader EpochDomain::_threadReader;
+
+EpochDomain::ThreadReader::~ThreadReader()
+{
+	EpochDomain::Instance()._ReleaseSlot(Slot);
+}
+
+EpochDomain::EpochDomain() :
+	_readers(),
+	_numUnslottedReaders(0u),
+	_epoch(1u),
+	_retiredMutex(),
+	_retired()
+{
+	for (auto& reader : _readers)
+	{
+		reader.Epoch.store(_IdleEpoch, std::memory_order_relaxed);
+		reader.IsClaimed.store(false, std::memory_order_relaxed);
+	}
+}
+
+EpochDomain::~EpochDomain()
+{
+	std::lock_guard<std::mutex> lock(_retiredMutex);
+	_retired.clear();
+}
+
+EpochDomain& EpochDomain::Instance()
+{
+	static EpochDomain domain;
+	return domain;
+}
+
+void EpochDomain::Retire(std::shared_ptr<const void> retired)
+{
+	if (!retired)
+		return;
+
+	// Orders the publisher's pointer swap before the reader slots are
+	// scanned in Reclaim(). Pairs with the fence in _Enter().
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	auto epoch = _epoch.fetch_add(1u, std::memory_order_acq_rel);
+
+	std::lock_guard<std::mutex> lock(_retiredMutex);
+	_retired.push_back({ epoch, std::move(retired) });
+}
+
+std::size_t EpochDomain::Reclaim()
+{
+	std::vector<Retired> freeable;
+
+	{
+		std::lock_guard<std::mutex> lock(_retiredMutex);
+		if (_retired.empty())
+			return 0u;
+
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (_numUnslottedReaders.load(std::memory_order_acquire) > 0u)
+			return 0u;
+
+		// A reader that entered at epoch e may hold anything retired at or
+		// after e, so only snapshots retired before the oldest reader go.
+		auto oldestEpoch = _OldestReaderEpoch();
+		auto firstKept = std::stable_partition(_retired.begin(), _retired.end(),
+			[oldestEpoch](const Retired& retired) { return retired.Epoch < oldestEpoch; });
+
+		freeable.assign(std::make_move_iterator(_retired.begin()),
+			std::make_move_iterator(firstKept));
+		_retired.erase(_retired.begin(), firstKept);
+	}
+
+	// Destructors run outside the lock, as they may publish or retire in turn
+	return freeable.size();
+}
+
+std::size_t EpochDomain::NumRetired() const
+{
+	std::lock_guard<std::mutex> lock(_retiredMutex);
+	return _retired.size();
+}
+
+void EpochDomain::_Enter() noexcept
+{
+	auto& reader = _threadReader;
+	if (reader.Depth++ > 0u)
+		return;
+
+	if (!reader.HasTriedSlot)
+	{
+		reader.Slot = _ClaimSlot();
+		reader.HasTriedSlot = true;
+	}
+
+	if (reader.Slot >= 0)
+		_readers[reader.Slot].Epoch.store(_epoch.load(std::memory_order_acquire), std::memory_order_relaxed);
+	else
+		_numUnslottedReaders.fetch_add(1u, std::memory_order_relaxed);
+
+	// The slot must be visible before any snapshot pointer is loaded
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+void EpochDomain::_Exit() noexcept
+{
+	auto& reader = _threadReader;
+	if (--reader.Depth > 0u)
+		return;
+
+	if (reader.Slot >= 0)
+		_readers[reader.Slot].Epoch.store(_IdleEpoch, std::memory_order_release);
+	else
+		_numUnslottedReaders.fetch_sub(1u, std::memory_order_release);
+}
+
+int EpochDomain::_ClaimSlot() noexcept
+{
+	for (auto i = 0u; i < MaxReaders; i++)
+	{
+		auto isClaimed = false;
+		if (_readers[i].IsClaimed.compare_exchange_strong(isClaimed, true, std::memory_order_acq_rel))
+			return static_cast<int>(i);
+	}
+
+	return -1;
+}
+
+void EpochDomain::_ReleaseSlot(int slot) noexcept
+{
+	if ((slot < 0) || (slot >= static_cast<int>(MaxReaders)))
+		return;
+
+	_readers[slot].Epoch.store(_IdleEpoch, std::memory_order_release);
+	_readers[slot].IsClaimed.store(false, std::memory_order_release);
+}
+
+std::uint64_t EpochDomain::_OldestReaderEpoch() const noexcept
+{
+	auto oldest = std::numeric_limits<std::uint64_t>::max();
+
+	for (const auto& reader : _readers)
+	{
+		auto epoch = reader.Epoch.load(std::memory_order_acquire);
+		if (_IdleEpoch != epoch)
+			oldest = std::min(oldest, epoch);
+	}
+
+	return oldest;
+}
+
+EpochReadGuard::EpochReadGuard() noexcept
+{
+	EpochDomain::Instance()._Enter();
+}
+
+EpochReadGuard::~EpochReadGuard() noexcept
+{
+	EpochDomain::Instance()._Exit();
+}
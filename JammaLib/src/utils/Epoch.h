@@ -0,0 +1,178 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace utils
+{
+	// Epoch-based reclamation for snapshots read on the audio thread.
+	//
+	// Readers open an EpochReadGuard, load raw pointers from EpochPtrs and
+	// use them until the guard closes. Entering and leaving a guard is a
+	// couple of stores to a reader slot owned by the calling thread, with no
+	// reference counting and no locks. Publishers swap in a new snapshot and
+	// retire the old one. A retired snapshot is only freed, by Reclaim() on a
+	// non-real-time thread, once every reader that could still see it has
+	// left its guard.
+	//
+	// Up to MaxReaders threads may hold guards at once. Any further threads
+	// still read safely, but block all reclamation while their guard is open.
+	class EpochDomain
+	{
+	public:
+		static constexpr unsigned int MaxReaders = 64u;
+
+	public:
+		EpochDomain(const EpochDomain&) = delete;
+		EpochDomain& operator=(const EpochDomain&) = delete;
+		~EpochDomain();
+
+		static EpochDomain& Instance();
+
+		// Hands an unpublished snapshot over for deferred destruction.
+		void Retire(std::shared_ptr<const void> retired);
+		// Frees every retired snapshot no reader can still see and returns
+		// how many were freed. Destructors run on the calling thread.
+		std::size_t Reclaim();
+		std::size_t NumRetired() const;
+
+	protected:
+		friend class EpochReadGuard;
+
+		struct alignas(64) ReaderSlot
+		{
+			std::atomic<std::uint64_t> Epoch;
+			std::atomic<bool> IsClaimed;
+		};
+
+		struct Retired
+		{
+			std::uint64_t Epoch;
+			std::shared_ptr<const void> Object;
+		};
+
+		// Per-thread reader state. The slot is claimed on the thread's first
+		// guard and handed back when the thread exits.
+		struct ThreadReader
+		{
+			int Slot = -1;
+			bool HasTriedSlot = false;
+			unsigned int Depth = 0u;
+
+			~ThreadReader();
+		};
+
+		EpochDomain();
+
+		void _Enter() noexcept;
+		void _Exit() noexcept;
+		int _ClaimSlot() noexcept;
+		void _ReleaseSlot(int slot) noexcept;
+		std::uint64_t _OldestReaderEpoch() const noexcept;
+
+	protected:
+		static constexpr std::uint64_t _IdleEpoch = 0u;
+		static thread_local ThreadReader _threadReader;
+
+		std::array<ReaderSlot, MaxReaders> _readers;
+		std::atomic<unsigned int> _numUnslottedReaders;
+		std::atomic<std::uint64_t> _epoch;
+		mutable std::mutex _retiredMutex;
+		std::vector<Retired> _retired;
+	};
+
+	// Marks the calling thread as reading epoch-protected snapshots. Guards
+	// nest; only the outermost one on a thread has any effect. Real-time safe.
+	class EpochReadGuard
+	{
+	public:
+		EpochReadGuard() noexcept;
+		~EpochReadGuard() noexcept;
+
+		EpochReadGuard(const EpochReadGuard&) = delete;
+		EpochReadGuard& operator=(const EpochReadGuard&) = delete;
+	};
+
+	// A published snapshot, loaded as a raw pointer under an EpochReadGuard.
+	//
+	// Publish() and LoadShared() take a mutex and belong on non-real-time
+	// threads. Destroying an EpochPtr frees its current value immediately, so
+	// its owner must already be unreachable from readers.
+	template<typename T>
+	class EpochPtr
+	{
+	public:
+		EpochPtr() noexcept :
+			_mutex(),
+			_ptr(nullptr),
+			_owner()
+		{
+		}
+
+		EpochPtr(EpochPtr&& other) :
+			_mutex(),
+			_ptr(nullptr),
+			_owner()
+		{
+			std::lock_guard<std::mutex> lock(other._mutex);
+			_owner = std::move(other._owner);
+			_ptr.store(_owner.get(), std::memory_order_release);
+			other._ptr.store(nullptr, std::memory_order_release);
+		}
+
+		EpochPtr(const EpochPtr&) = delete;
+		EpochPtr& operator=(const EpochPtr&) = delete;
+		EpochPtr& operator=(EpochPtr&&) = delete;
+
+	public:
+		// Audio thread. Only valid until the enclosing EpochReadGuard closes.
+		T* Load() const noexcept
+		{
+			return _ptr.load(std::memory_order_acquire);
+		}
+
+		std::shared_ptr<T> LoadShared() const
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			return _owner;
+		}
+
+		void Publish(std::shared_ptr<T> value)
+		{
+			std::shared_ptr<T> previous;
+
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_ptr.store(value.get(), std::memory_order_release);
+				previous = std::exchange(_owner, std::move(value));
+			}
+
+			auto& domain = EpochDomain::Instance();
+			domain.Retire(std::move(previous));
+			domain.Reclaim();
+		}
+
+		// Neither value is retired, so readers of either side stay valid.
+		void Swap(EpochPtr& other)
+		{
+			if (this == &other)
+				return;
+
+			std::scoped_lock lock(_mutex, other._mutex);
+			_owner.swap(other._owner);
+			_ptr.store(_owner.get(), std::memory_order_release);
+			other._ptr.store(other._owner.get(), std::memory_order_release);
+		}
+
+	private:
+		mutable std::mutex _mutex;
+		std::atomic<T*> _ptr;
+		std::shared_ptr<T> _owner;
+	};
+}
@@ -0,0 +1,43 @@
+#include "WakeSignal.h"
+
+using namespace utils;
+
+WakeSignal::WakeSignal() :
+	_isSignalled(false),
+	_numWaiters(0u),
+	_mutex(),
+	_wake()
+{
+}
+
+void WakeSignal::Notify() noexcept
+{
+	// Already pending, so the waiter has yet to see it
+	if (_isSignalled.exchange(true, std::memory_order_seq_cst))
+		return;
+
+	if (0u == _numWaiters.load(std::memory_order_seq_cst))
+		return;
+
+	// Taking the mutex orders this wake after the waiter's check
+	{
+		std::scoped_lock lock(_mutex);
+	}
+
+	_wake.notify_one();
+}
+
+bool WakeSignal::Wait(std::chrono::milliseconds timeout)
+{
+	std::unique_lock lock(_mutex);
+
+	// Notifiers only take the mutex when they see a waiter, so register
+	// first and check the signal after
+	_numWaiters.fetch_add(1u, std::memory_order_seq_cst);
+	_wake.wait_for(lock, timeout, [this]() {
+		return _isSignalled.load(std::memory_order_seq_cst);
+	});
+	_numWaiters.fetch_sub(1u, std::memory_order_relaxed);
+
+	return _isSignalled.exchange(false, std::memory_order_acq_rel);
+}
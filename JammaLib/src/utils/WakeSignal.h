@@ -0,0 +1,36 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+namespace utils
+{
+	// Wakes one waiting thread from any number of notifiers.
+	//
+	// Notify() is a single atomic exchange while the waiter is busy, so it
+	// is cheap enough for device callbacks; the mutex is only taken when
+	// the waiter is asleep and needs waking. A notify with nobody waiting
+	// stays pending, so the next Wait() returns at once. Several notifies
+	// before a Wait() collapse into one.
+	class WakeSignal
+	{
+	public:
+		WakeSignal();
+
+		WakeSignal(const WakeSignal&) = delete;
+		WakeSignal& operator=(const WakeSignal&) = delete;
+
+		void Notify() noexcept;
+		// Returns true if notified, false if the timeout passed first.
+		// Clears the signal. Single waiter.
+		bool Wait(std::chrono::milliseconds timeout);
+
+	protected:
+		std::atomic<bool> _isSignalled;
+		std::atomic<unsigned int> _numWaiters;
+		std::mutex _mutex;
+		std::condition_variable _wake;
+	};
+}
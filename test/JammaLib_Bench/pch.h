@@ -0,0 +1,7 @@
+//
+// pch.h
+//
+
+#pragma once
+
+#include "benchmark/benchmark.h"
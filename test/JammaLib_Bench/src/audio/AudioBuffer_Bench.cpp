@@ -0,0 +1,71 @@
+#include "benchmark/benchmark.h"
+#include "audio/AudioBuffer.h"
+#include "audio/ChannelMixer.h"
+#include <vector>
+
+using audio::AudioBuffer;
+using base::Audible;
+using base::AudioWriteRequest;
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+
+namespace {
+
+constexpr unsigned int BufSize = audio::ChannelMixer::DefaultBufferSize;
+
+// Fills the ring once round, so its write index is back at zero.
+void FillBuffer(AudioBuffer& buffer)
+{
+	std::vector<float> samples(BufSize);
+	for (auto i = 0u; i < BufSize; i++)
+		samples[i] = static_cast<float>(i % 200u) / 200.0f - 0.5f;
+
+	AudioWriteRequest request;
+	request.samples = samples.data();
+	request.numSamps = BufSize;
+	request.stride = 1;
+	request.fadeCurrent = 0.0f;
+	request.fadeNew = 1.0f;
+	request.source = Audible::AUDIOSOURCE_ADC;
+	buffer.OnBlockWrite(request, 0);
+	buffer.EndWrite(BufSize, true);
+}
+
+// One block read from the ring. Args are { blockSize, isWrapped }, where
+// isWrapped starts the read half a block before the end of the ring, so the
+// copy into the temp buffer is taken instead of the zero-copy pointer.
+void BM_AudioBufferPlaybackRead(benchmark::State& state)
+{
+	const auto blockSize = static_cast<unsigned int>(state.range(0));
+	const auto isWrapped = 0 != state.range(1);
+
+	AudioBuffer buffer(BufSize);
+	FillBuffer(buffer);
+	buffer.Delay(isWrapped ? blockSize / 2u : BufSize / 2u);
+	std::vector<float> tempBuf(blockSize, 0.0f);
+
+	for (auto _ : state)
+	{
+		auto ptr = buffer.PlaybackRead(tempBuf.data(), blockSize);
+		benchmark::DoNotOptimize(ptr);
+		benchmark::ClobberMemory();
+	}
+
+	state.SetLabel(isWrapped ? "wrapped" : "contiguous");
+	state.SetItemsProcessed(state.iterations() * blockSize);
+}
+
+void PlaybackReadArgs(benchmark::internal::Benchmark* bench)
+{
+	for (auto isWrapped : { 0, 1 })
+	{
+		for (auto blockSize : { 64, 256, 1024 })
+			bench->Args({ blockSize, isWrapped });
+	}
+}
+
+} // namespace
+
+BENCHMARK(BM_AudioBufferPlaybackRead)->Apply(PlaybackReadArgs);
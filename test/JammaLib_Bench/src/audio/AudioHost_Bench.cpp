@@ -0,0 +1,212 @@
+#include "benchmark/benchmark.h"
+#include "audio/AudioHost.h"
+#include "audio/AudioMixer.h"
+#include "audio/OfflineRenderer.h"
+#include "engine/Station.h"
+#include "engine/LoopTake.h"
+#include "engine/Loop.h"
+
+using engine::Station;
+using engine::StationParams;
+using engine::LoopTake;
+using engine::LoopTakeParams;
+using audio::AudioHost;
+using audio::AudioStreamParams;
+using audio::ChannelMixerParams;
+using audio::OfflineRenderer;
+using audio::MergeMixBehaviourParams;
+using base::Audible;
+using base::AudioWriteRequest;
+using io::UserConfig;
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+
+namespace {
+
+constexpr unsigned int NumChans = 2u;
+constexpr unsigned long LoopLength = 2u * constants::DefaultSampleRate;
+
+UserConfig MakeUserConfig(unsigned int blockSize)
+{
+	UserConfig cfg;
+	cfg.Audio.SampleRate = constants::DefaultSampleRate;
+	cfg.Audio.BufSize = blockSize;
+	cfg.Audio.NumBuffers = 1u;
+	cfg.Audio.NumChannelsIn = NumChans;
+	cfg.Audio.NumChannelsOut = NumChans;
+	cfg.Audio.LatencyIn = 0u;
+	cfg.Audio.LatencyOut = 0u;
+	cfg.Trigger.PreDelay = 0u;
+	cfg.Trigger.DebounceSamps = 0u;
+
+	return cfg;
+}
+
+AudioStreamParams MakeStreamParams(unsigned int blockSize)
+{
+	AudioStreamParams streamParams{};
+	streamParams.SampleRate = constants::DefaultSampleRate;
+	streamParams.BufSize = blockSize;
+	streamParams.NumBuffers = 1u;
+	streamParams.NumInputChannels = NumChans;
+	streamParams.NumOutputChannels = NumChans;
+	streamParams.InputLatency = 0u;
+	streamParams.OutputLatency = 0u;
+
+	return streamParams;
+}
+
+// A station holding one playing take with a loop per channel.
+std::shared_ptr<Station> MakePlayingStation(unsigned int stationIndex)
+{
+	StationParams stationParams;
+	stationParams.Size = { 200, 200 };
+	stationParams.FadeSamps = constants::DefaultFadeSamps;
+
+	MergeMixBehaviourParams mergeParams;
+	auto station = std::make_shared<Station>(stationParams,
+		Station::GetMixerParams(stationParams.Size, mergeParams));
+	station->SetNumBusChannels(NumChans);
+	station->SetNumDacChannels(NumChans);
+
+	LoopTakeParams takeParams;
+	takeParams.Size = { 100, 100 };
+	takeParams.FadeSamps = constants::DefaultFadeSamps;
+
+	auto take = std::make_shared<LoopTake>(takeParams,
+		LoopTake::GetMixerParams(takeParams.Size, mergeParams));
+	take->SetNumBusChannels(NumChans);
+	take->Record({}, "bench");
+
+	const unsigned long totalRecord = constants::MaxLoopFadeSamps + LoopLength;
+	std::vector<float> samples(totalRecord);
+
+	for (auto chan = 0u; chan < NumChans; chan++)
+	{
+		auto loop = take->AddLoop(chan, "bench");
+		loop->Record();
+
+		for (auto i = 0ul; i < totalRecord; i++)
+			samples[i] = static_cast<float>(((i + stationIndex * 31u + chan * 7u) % 200u)) / 200.0f - 0.5f;
+
+		AudioWriteRequest request;
+		request.samples = samples.data();
+		request.numSamps = static_cast<unsigned int>(totalRecord);
+		request.stride = 1;
+		request.fadeCurrent = 0.0f;
+		request.fadeNew = 1.0f;
+		request.source = Audible::AUDIOSOURCE_ADC;
+		loop->OnBlockWrite(request, 0);
+		loop->EndWrite(request.numSamps, true);
+	}
+
+	take->CommitChanges();
+	take->Play(constants::MaxLoopFadeSamps, LoopLength, 0u);
+
+	station->AddTake(take);
+	station->CommitChanges();
+
+	return station;
+}
+
+// Full AudioHost callback with no device: ADC in, every station rendered,
+// DAC out. Args are { numStations, numWorkers, blockSize }.
+void BM_AudioHostProcessBlock(benchmark::State& state)
+{
+	const auto numStations = static_cast<unsigned int>(state.range(0));
+	const auto numWorkers = static_cast<unsigned int>(state.range(1));
+	const auto blockSize = static_cast<unsigned int>(state.range(2));
+
+	auto cfg = MakeUserConfig(blockSize);
+	auto streamParams = MakeStreamParams(blockSize);
+
+	AudioHost host(cfg);
+	host.GetChannelMixer()->SetParams(ChannelMixerParams({
+		cfg.AdcBufferDelay(0u) + blockSize,
+		audio::ChannelMixer::DefaultBufferSize,
+		NumChans,
+		NumChans }));
+
+	auto stations = std::make_shared<std::vector<std::shared_ptr<Station>>>();
+	for (auto i = 0u; i < numStations; i++)
+		stations->push_back(MakePlayingStation(i));
+
+	host.SetStations(stations);
+	host.SetRenderWorkers(numWorkers);
+
+	std::vector<float> inBuf(NumChans * blockSize, 0.25f);
+	std::vector<float> outBuf(NumChans * blockSize, 0.0f);
+
+	for (auto _ : state)
+	{
+		host.ProcessBlock(inBuf.data(), outBuf.data(), blockSize, streamParams);
+		benchmark::DoNotOptimize(outBuf.data());
+		benchmark::ClobberMemory();
+	}
+
+	host.SetRenderWorkers(0u);
+
+	state.SetItemsProcessed(state.iterations() * blockSize);
+	state.counters["stations"] = static_cast<double>(numStations);
+	state.counters["workers"] = static_cast<double>(numWorkers);
+}
+
+void AudioHostArgs(benchmark::internal::Benchmark* bench)
+{
+	for (auto numStations : { 1, 2, 4, 8, 16, 32 })
+	{
+		for (auto numWorkers : { 0, 1, 3, 7 })
+			bench->Args({ numStations, numWorkers, 256 });
+	}
+}
+
+// One second of audio per iteration through the offline renderer, including
+// its commits and output capture. Args are { numStations, numWorkers }.
+void BM_OfflineRender(benchmark::State& state)
+{
+	const auto numStations = static_cast<unsigned int>(state.range(0));
+	const auto numWorkers = static_cast<unsigned int>(state.range(1));
+	const auto blockSize = 256u;
+
+	auto cfg = MakeUserConfig(blockSize);
+	cfg.Audio.RenderWorkers = numWorkers;
+
+	OfflineRenderer::StationList stations;
+	for (auto i = 0u; i < numStations; i++)
+		stations.push_back(MakePlayingStation(i));
+
+	AudioHost host(cfg);
+	OfflineRenderer renderer(host, MakeStreamParams(blockSize), stations);
+
+	std::uint64_t numBlocks = 0u;
+	for (auto _ : state)
+	{
+		auto stats = renderer.Render(constants::DefaultSampleRate);
+		numBlocks += stats.NumBlocks;
+
+		state.PauseTiming();
+		renderer.ClearOutput();
+		state.ResumeTiming();
+	}
+
+	host.SetRenderWorkers(0u);
+
+	state.SetItemsProcessed(state.iterations() * constants::DefaultSampleRate);
+	state.counters["blocks/s"] = benchmark::Counter(static_cast<double>(numBlocks), benchmark::Counter::kIsRate);
+	state.counters["stations"] = static_cast<double>(numStations);
+	state.counters["workers"] = static_cast<double>(numWorkers);
+}
+
+} // namespace
+
+BENCHMARK(BM_AudioHostProcessBlock)
+	->Apply(AudioHostArgs)
+	->Unit(benchmark::kMicrosecond)
+	->UseRealTime();
+BENCHMARK(BM_OfflineRender)
+	->Args({ 8, 0 })
+	->Args({ 8, 3 })
+	->Unit(benchmark::kMillisecond)
+	->UseRealTime();
@@ -0,0 +1,124 @@
+#include "benchmark/benchmark.h"
+#include "audio/AudioMixer.h"
+#include "audio/ChannelMixer.h"
+#include <vector>
+
+using audio::ChannelMixer;
+using audio::ChannelMixerParams;
+using audio::BehaviourParams;
+using audio::MixerBehaviourFactory;
+using audio::WireMixBehaviourParams;
+using audio::PanMixBehaviourParams;
+using audio::BounceMixBehaviourParams;
+using audio::MergeMixBehaviourParams;
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+
+namespace {
+
+enum BehaviourType
+{
+	BEHAVIOUR_WIRE,
+	BEHAVIOUR_PAN,
+	BEHAVIOUR_BOUNCE,
+	BEHAVIOUR_MERGE
+};
+
+const char* BehaviourName(BehaviourType type)
+{
+	switch (type)
+	{
+	case BEHAVIOUR_WIRE:
+		return "wire";
+	case BEHAVIOUR_PAN:
+		return "pan";
+	case BEHAVIOUR_BOUNCE:
+		return "bounce";
+	case BEHAVIOUR_MERGE:
+		return "merge";
+	default:
+		return "unknown";
+	}
+}
+
+// Wire and bounce feed a single channel, as a loop's mixer does. Pan and
+// merge feed every channel, as a take or station mixer does.
+BehaviourParams MakeBehaviourParams(BehaviourType type, unsigned int numChans)
+{
+	std::vector<unsigned int> allChannels;
+	for (auto chan = 0u; chan < numChans; chan++)
+		allChannels.push_back(chan);
+
+	switch (type)
+	{
+	case BEHAVIOUR_PAN:
+	{
+		PanMixBehaviourParams panParams;
+		panParams.ChannelLevels = std::vector<float>(numChans, 0.7f);
+		return panParams;
+	}
+	case BEHAVIOUR_BOUNCE:
+	{
+		BounceMixBehaviourParams bounceParams;
+		bounceParams.Channels = { 0u };
+		return bounceParams;
+	}
+	case BEHAVIOUR_MERGE:
+	{
+		MergeMixBehaviourParams mergeParams;
+		mergeParams.Channels = allChannels;
+		return mergeParams;
+	}
+	default:
+		return WireMixBehaviourParams({ 0u });
+	}
+}
+
+// One block applied through a behaviour into the DAC rings.
+// Args are { behaviour, blockSize, numChans }.
+void BM_MixBehaviourApplyBlock(benchmark::State& state)
+{
+	const auto type = static_cast<BehaviourType>(state.range(0));
+	const auto blockSize = static_cast<unsigned int>(state.range(1));
+	const auto numChans = static_cast<unsigned int>(state.range(2));
+
+	auto behaviour = std::visit(MixerBehaviourFactory(), MakeBehaviourParams(type, numChans));
+	ChannelMixer channelMixer(ChannelMixerParams({
+		ChannelMixer::DefaultBufferSize,
+		ChannelMixer::DefaultBufferSize,
+		numChans,
+		numChans }));
+	auto dest = channelMixer.Sink();
+
+	std::vector<float> srcBuf(blockSize);
+	for (auto i = 0u; i < blockSize; i++)
+		srcBuf[i] = static_cast<float>(i % 200u) / 200.0f - 0.5f;
+
+	for (auto _ : state)
+	{
+		behaviour->ApplyBlock(dest, srcBuf.data(), 0.8f, nullptr, blockSize, 0u);
+		benchmark::ClobberMemory();
+	}
+
+	state.SetLabel(BehaviourName(type));
+	state.SetItemsProcessed(state.iterations() * blockSize);
+	state.counters["chans"] = static_cast<double>(numChans);
+}
+
+void ApplyBlockArgs(benchmark::internal::Benchmark* bench)
+{
+	for (auto type : { BEHAVIOUR_WIRE, BEHAVIOUR_PAN, BEHAVIOUR_BOUNCE, BEHAVIOUR_MERGE })
+	{
+		for (auto numChans : { 2, 8 })
+		{
+			for (auto blockSize : { 64, 256, 1024 })
+				bench->Args({ static_cast<long long>(type), blockSize, numChans });
+		}
+	}
+}
+
+} // namespace
+
+BENCHMARK(BM_MixBehaviourApplyBlock)->Apply(ApplyBlockArgs);
@@ -0,0 +1,90 @@
+#include "benchmark/benchmark.h"
+#include "audio/ChannelMixer.h"
+#include <vector>
+
+using audio::ChannelMixer;
+using audio::ChannelMixerParams;
+using base::Audible;
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+
+namespace {
+
+ChannelMixer MakeChannelMixer(unsigned int numChans, unsigned int blockSize)
+{
+	ChannelMixer mixer(ChannelMixerParams({
+		ChannelMixer::DefaultBufferSize,
+		ChannelMixer::DefaultBufferSize,
+		numChans,
+		numChans }));
+	mixer.InitPlay(0u, blockSize);
+
+	return mixer;
+}
+
+std::vector<float> MakeInterleaved(unsigned int numChans, unsigned int blockSize)
+{
+	std::vector<float> samples(numChans * blockSize);
+	for (auto i = 0u; i < samples.size(); i++)
+		samples[i] = static_cast<float>(i % 200u) / 200.0f - 0.5f;
+
+	return samples;
+}
+
+// Deinterleaving one device block into the ADC rings.
+// Args are { blockSize, numChans }.
+void BM_ChannelMixerFromAdc(benchmark::State& state)
+{
+	const auto blockSize = static_cast<unsigned int>(state.range(0));
+	const auto numChans = static_cast<unsigned int>(state.range(1));
+
+	auto mixer = MakeChannelMixer(numChans, blockSize);
+	auto inBuf = MakeInterleaved(numChans, blockSize);
+
+	for (auto _ : state)
+	{
+		mixer.FromAdc(inBuf.data(), numChans, blockSize);
+		benchmark::ClobberMemory();
+	}
+
+	state.SetItemsProcessed(state.iterations() * blockSize * numChans);
+	state.counters["chans"] = static_cast<double>(numChans);
+}
+
+// Interleaving the DAC rings into one device block, advancing the rings as
+// the audio callback does. Args are { blockSize, numChans }.
+void BM_ChannelMixerToDac(benchmark::State& state)
+{
+	const auto blockSize = static_cast<unsigned int>(state.range(0));
+	const auto numChans = static_cast<unsigned int>(state.range(1));
+
+	auto mixer = MakeChannelMixer(numChans, blockSize);
+	std::vector<float> outBuf(numChans * blockSize, 0.0f);
+
+	for (auto _ : state)
+	{
+		mixer.ToDac(outBuf.data(), numChans, blockSize);
+		mixer.Sink()->EndMultiWrite(blockSize, true, Audible::AUDIOSOURCE_LOOPS);
+		benchmark::DoNotOptimize(outBuf.data());
+		benchmark::ClobberMemory();
+	}
+
+	state.SetItemsProcessed(state.iterations() * blockSize * numChans);
+	state.counters["chans"] = static_cast<double>(numChans);
+}
+
+void ChannelMixerArgs(benchmark::internal::Benchmark* bench)
+{
+	for (auto numChans : { 2, 8, 32 })
+	{
+		for (auto blockSize : { 64, 256, 1024 })
+			bench->Args({ blockSize, numChans });
+	}
+}
+
+} // namespace
+
+BENCHMARK(BM_ChannelMixerFromAdc)->Apply(ChannelMixerArgs);
+BENCHMARK(BM_ChannelMixerToDac)->Apply(ChannelMixerArgs);
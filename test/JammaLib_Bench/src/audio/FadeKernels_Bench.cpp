@@ -0,0 +1,239 @@
+#include "benchmark/benchmark.h"
+#include "audio/FadeKernels.h"
+#include "audio/BufferBank.h"
+#include "audio/InterpolatedValue.h"
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+using audio::FadeKernels;
+using audio::BufferBank;
+using audio::InterpolatedValue;
+using audio::InterpolatedValueExp;
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+
+namespace {
+
+std::vector<float> MakeSamples(unsigned int numSamps)
+{
+	std::vector<float> samples(numSamps);
+	for (auto i = 0u; i < numSamps; i++)
+		samples[i] = static_cast<float>(i % 200u) / 200.0f - 0.5f;
+
+	return samples;
+}
+
+// One kernel level over a block. Args are { level, stride, numSamps }.
+void BM_FadeMix(benchmark::State& state)
+{
+	const auto level = static_cast<FadeKernels::SimdLevel>(state.range(0));
+	const auto stride = static_cast<unsigned int>(state.range(1));
+	const auto numSamps = static_cast<unsigned int>(state.range(2));
+
+	auto kernel = FadeKernels::Kernel(level);
+	if (nullptr == kernel)
+	{
+		state.SkipWithError("SIMD level not supported on this CPU");
+		return;
+	}
+
+	auto src = MakeSamples(numSamps * stride);
+	std::vector<float> dest(numSamps, 0.0f);
+
+	for (auto _ : state)
+	{
+		kernel(dest.data(), src.data(), stride, numSamps, 0.999f, 0.5f);
+		benchmark::DoNotOptimize(dest.data());
+		benchmark::ClobberMemory();
+	}
+
+	state.SetLabel(FadeKernels::LevelName(level));
+	state.SetItemsProcessed(state.iterations() * numSamps);
+}
+
+void FadeMixArgs(benchmark::internal::Benchmark* bench)
+{
+	for (auto level : { FadeKernels::SIMD_SCALAR, FadeKernels::SIMD_SSE2, FadeKernels::SIMD_AVX2, FadeKernels::SIMD_AVX512 })
+	{
+		for (auto stride : { 1, 2 })
+		{
+			for (auto numSamps : { 64, 256, 1024, 4096 })
+				bench->Args({ static_cast<long long>(level), stride, numSamps });
+		}
+	}
+}
+
+// Per-sample operator[] loop, as Loop::OnBlockWrite used to do it.
+void BM_BufferBankIndexedWrite(benchmark::State& state)
+{
+	const auto numSamps = static_cast<unsigned int>(state.range(0));
+
+	BufferBank bank;
+	auto src = MakeSamples(numSamps);
+	const auto startIndex = bank.BankSize() / 2ul;
+
+	for (auto _ : state)
+	{
+		for (auto i = 0u; i < numSamps; i++)
+		{
+			auto idx = startIndex + i;
+			bank[idx] = (0.5f * src[i]) + (0.999f * bank[idx]);
+		}
+		benchmark::ClobberMemory();
+	}
+
+	state.SetItemsProcessed(state.iterations() * numSamps);
+}
+
+// Span-resolved, dispatched block write.
+void BM_BufferBankFadeMixBlock(benchmark::State& state)
+{
+	const auto numSamps = static_cast<unsigned int>(state.range(0));
+
+	BufferBank bank;
+	auto src = MakeSamples(numSamps);
+	const auto startIndex = bank.BankSize() / 2ul;
+
+	for (auto _ : state)
+	{
+		bank.FadeMixBlock(startIndex, src.data(), 1u, numSamps, 0.999f, 0.5f);
+		benchmark::ClobberMemory();
+	}
+
+	state.SetLabel(FadeKernels::LevelName(FadeKernels::ActiveLevel()));
+	state.SetItemsProcessed(state.iterations() * numSamps);
+}
+
+BufferBank MakeFilledBank(unsigned long numSamps)
+{
+	BufferBank bank;
+	bank.Resize(numSamps);
+
+	auto block = MakeSamples(4096u);
+	for (auto i = 0ul; i < numSamps; i += 4096ul)
+	{
+		auto numToWrite = static_cast<unsigned int>(std::min(4096ul, numSamps - i));
+		bank.FadeMixBlock(i, block.data(), 1u, numToWrite, 0.0f, 1.0f);
+	}
+
+	return bank;
+}
+
+// Min/max of a waveform segment by walking operator[], as SubMin/SubMax
+// used to. Arg is the range length.
+void BM_BufferBankScanMinMax(benchmark::State& state)
+{
+	const auto rangeSamps = static_cast<unsigned long>(state.range(0));
+	auto bank = MakeFilledBank(rangeSamps + 1000ul);
+
+	for (auto _ : state)
+	{
+		auto curMin = bank[1000ul];
+		auto curMax = bank[1000ul];
+		for (auto i = 1000ul; i < rangeSamps + 1000ul; i++)
+		{
+			curMin = std::min(curMin, bank[i]);
+			curMax = std::max(curMax, bank[i]);
+		}
+
+		benchmark::DoNotOptimize(curMin);
+		benchmark::DoNotOptimize(curMax);
+	}
+
+	state.SetItemsProcessed(state.iterations() * rangeSamps);
+}
+
+// The same query answered from the summary pyramid.
+void BM_BufferBankSubSummary(benchmark::State& state)
+{
+	const auto rangeSamps = static_cast<unsigned long>(state.range(0));
+	auto bank = MakeFilledBank(rangeSamps + 1000ul);
+
+	for (auto _ : state)
+	{
+		auto summary = bank.SubSummary(1000ul, rangeSamps + 1000ul);
+		benchmark::DoNotOptimize(summary);
+	}
+
+	state.SetItemsProcessed(state.iterations() * rangeSamps);
+}
+
+// SubMin and SubMax as the waveform drawing calls them, one query each.
+// Arg is the range length.
+void BM_BufferBankSubMinMax(benchmark::State& state)
+{
+	const auto rangeSamps = static_cast<unsigned long>(state.range(0));
+	auto bank = MakeFilledBank(rangeSamps + 1000ul);
+
+	for (auto _ : state)
+	{
+		auto curMin = bank.SubMin(1000ul, rangeSamps + 1000ul);
+		auto curMax = bank.SubMax(1000ul, rangeSamps + 1000ul);
+		benchmark::DoNotOptimize(curMin);
+		benchmark::DoNotOptimize(curMax);
+	}
+
+	state.SetItemsProcessed(state.iterations() * rangeSamps);
+}
+
+std::unique_ptr<InterpolatedValue> MakeMovingFade()
+{
+	InterpolatedValueExp::ExponentialParams params;
+	params.Damping = 1.0e9;
+
+	auto fade = std::make_unique<InterpolatedValueExp>(params);
+	fade->Jump(1.0);
+	fade->SetTarget(0.0);
+
+	return fade;
+}
+
+// Per-sample virtual Next(), as AudioMixer::Offset used to do it.
+void BM_FadeNextPerSample(benchmark::State& state)
+{
+	const auto numSamps = static_cast<unsigned int>(state.range(0));
+	auto fade = MakeMovingFade();
+	std::vector<float> ramp(numSamps);
+
+	for (auto _ : state)
+	{
+		for (auto i = 0u; i < numSamps; i++)
+			ramp[i] = static_cast<float>(fade->Next());
+
+		benchmark::DoNotOptimize(ramp.data());
+		benchmark::ClobberMemory();
+	}
+
+	state.SetItemsProcessed(state.iterations() * numSamps);
+}
+
+// One virtual call per block.
+void BM_FadeFillRamp(benchmark::State& state)
+{
+	const auto numSamps = static_cast<unsigned int>(state.range(0));
+	auto fade = MakeMovingFade();
+	std::vector<float> ramp(numSamps);
+
+	for (auto _ : state)
+	{
+		fade->FillRamp(ramp.data(), numSamps);
+		benchmark::DoNotOptimize(ramp.data());
+		benchmark::ClobberMemory();
+	}
+
+	state.SetItemsProcessed(state.iterations() * numSamps);
+}
+
+} // namespace
+
+BENCHMARK(BM_FadeMix)->Apply(FadeMixArgs);
+BENCHMARK(BM_BufferBankIndexedWrite)->Arg(256)->Arg(1024)->Arg(4096);
+BENCHMARK(BM_BufferBankFadeMixBlock)->Arg(256)->Arg(1024)->Arg(4096);
+BENCHMARK(BM_BufferBankScanMinMax)->Arg(20000)->Arg(1 << 22);
+BENCHMARK(BM_BufferBankSubSummary)->Arg(20000)->Arg(1 << 22);
+BENCHMARK(BM_BufferBankSubMinMax)->Arg(256)->Arg(20000)->Arg(1 << 22);
+BENCHMARK(BM_FadeNextPerSample)->Arg(256)->Arg(1024);
+BENCHMARK(BM_FadeFillRamp)->Arg(256)->Arg(1024);
@@ -0,0 +1,134 @@
+#include "benchmark/benchmark.h"
+#include "engine/Loop.h"
+#include <vector>
+
+using engine::Loop;
+using engine::LoopParams;
+using audio::AudioMixerParams;
+using audio::WireMixBehaviourParams;
+using base::Audible;
+using base::AudioWriteRequest;
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+
+namespace {
+
+constexpr unsigned long LoopLength = 2u * constants::DefaultSampleRate;
+
+std::vector<float> MakeSamples(unsigned int numSamps)
+{
+	std::vector<float> samples(numSamps);
+	for (auto i = 0u; i < numSamps; i++)
+		samples[i] = static_cast<float>(i % 200u) / 200.0f - 0.5f;
+
+	return samples;
+}
+
+std::unique_ptr<Loop> MakeLoop()
+{
+	WireMixBehaviourParams mixBehaviour;
+	mixBehaviour.Channels = { 0 };
+
+	AudioMixerParams mixerParams;
+	mixerParams.Size = { 160, 320 };
+	mixerParams.Position = { 6, 6 };
+	mixerParams.Behaviour = mixBehaviour;
+
+	LoopParams loopParams;
+	loopParams.Wav = "bench";
+	loopParams.Size = { 80, 80 };
+	loopParams.Position = { 10, 22 };
+	loopParams.FadeSamps = constants::DefaultFadeSamps;
+
+	return std::make_unique<Loop>(loopParams, mixerParams);
+}
+
+std::unique_ptr<Loop> MakePlayingLoop()
+{
+	auto loop = MakeLoop();
+	loop->Record();
+
+	const auto totalRecord = static_cast<unsigned int>(constants::MaxLoopFadeSamps + LoopLength);
+	auto samples = MakeSamples(totalRecord);
+
+	AudioWriteRequest request;
+	request.samples = samples.data();
+	request.numSamps = totalRecord;
+	request.stride = 1;
+	request.fadeCurrent = 0.0f;
+	request.fadeNew = 1.0f;
+	request.source = Audible::AUDIOSOURCE_ADC;
+	loop->OnBlockWrite(request, 0);
+	loop->EndWrite(totalRecord, true);
+
+	loop->Play(constants::MaxLoopFadeSamps, LoopLength, false);
+
+	return loop;
+}
+
+// One block read from a playing loop. Args are { blockSize, isXfade }, where
+// isXfade places the whole block at the end of the loop so every sample is
+// crossfaded with the pre-roll.
+void BM_LoopReadBlock(benchmark::State& state)
+{
+	const auto blockSize = static_cast<unsigned int>(state.range(0));
+	const auto isXfade = 0 != state.range(1);
+
+	auto loop = MakePlayingLoop();
+	std::vector<float> outBuf(constants::MaxBlockSize, 0.0f);
+	const auto sampOffset = isXfade ? static_cast<int>(LoopLength - blockSize) : 0;
+
+	for (auto _ : state)
+	{
+		auto numRead = loop->ReadBlock(outBuf.data(), sampOffset, blockSize);
+		benchmark::DoNotOptimize(numRead);
+		benchmark::DoNotOptimize(outBuf.data());
+		benchmark::ClobberMemory();
+	}
+
+	state.SetLabel(isXfade ? "xfade" : "steady");
+	state.SetItemsProcessed(state.iterations() * blockSize);
+}
+
+void LoopReadBlockArgs(benchmark::internal::Benchmark* bench)
+{
+	for (auto isXfade : { 0, 1 })
+	{
+		for (auto blockSize : { 64, 256, 1024 })
+			bench->Args({ blockSize, isXfade });
+	}
+}
+
+// One ADC block written into a recording loop. The write index is not
+// advanced, so every iteration lands on the same span. Arg is the block size.
+void BM_LoopOnBlockWrite(benchmark::State& state)
+{
+	const auto blockSize = static_cast<unsigned int>(state.range(0));
+
+	auto loop = MakeLoop();
+	loop->Record();
+
+	auto samples = MakeSamples(blockSize);
+	AudioWriteRequest request;
+	request.samples = samples.data();
+	request.numSamps = blockSize;
+	request.stride = 1;
+	request.fadeCurrent = 0.999f;
+	request.fadeNew = 0.5f;
+	request.source = Audible::AUDIOSOURCE_ADC;
+
+	for (auto _ : state)
+	{
+		loop->OnBlockWrite(request, 0);
+		benchmark::ClobberMemory();
+	}
+
+	state.SetItemsProcessed(state.iterations() * blockSize);
+}
+
+} // namespace
+
+BENCHMARK(BM_LoopReadBlock)->Apply(LoopReadBlockArgs);
+BENCHMARK(BM_LoopOnBlockWrite)->Arg(64)->Arg(256)->Arg(1024);
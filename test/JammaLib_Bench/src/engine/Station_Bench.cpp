@@ -0,0 +1,252 @@
+#include "benchmark/benchmark.h"
+#include "engine/Station.h"
+#include "engine/LoopTake.h"
+#include "engine/Trigger.h"
+#include "engine/Loop.h"
+#include "audio/ChannelMixer.h"
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+using engine::Station;
+using engine::StationParams;
+using engine::LoopTake;
+using engine::LoopTakeParams;
+using engine::Trigger;
+using engine::TriggerParams;
+using engine::TriggerTake;
+using audio::AudioStreamParams;
+using audio::ChannelMixer;
+using audio::ChannelMixerParams;
+using audio::MergeMixBehaviourParams;
+using base::Audible;
+using base::AudioWriteRequest;
+using io::UserConfig;
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+
+namespace {
+
+constexpr unsigned int BlockSize = 256u;
+constexpr unsigned long LoopLength = 2u * constants::DefaultSampleRate;
+
+// Trigger whose take history is filled directly, so the bench doesn't have
+// to play out a key sequence per overdub.
+class RoutedTrigger :
+	public Trigger
+{
+public:
+	RoutedTrigger() :
+		Trigger(TriggerParams()) {}
+
+public:
+	void AddRoute(const std::string& sourceId, const std::string& targetId)
+	{
+		_AddTake({ TriggerTake::SOURCE_LOOPTAKE, sourceId, targetId });
+	}
+};
+
+// A station with numTakes takes, paired off into numTakes/2 overdub routes
+// on a single trigger.
+std::pair<std::shared_ptr<Station>, std::shared_ptr<Trigger>> MakeRoutedStation(unsigned int numTakes)
+{
+	StationParams stationParams;
+	stationParams.Size = { 200, 200 };
+	stationParams.FadeSamps = constants::DefaultFadeSamps;
+
+	MergeMixBehaviourParams mergeParams;
+	auto station = std::make_shared<Station>(stationParams,
+		Station::GetMixerParams(stationParams.Size, mergeParams));
+
+	for (auto i = 0u; i < numTakes; i++)
+		station->AddTake();
+
+	station->CommitChanges();
+
+	auto trigger = std::make_shared<RoutedTrigger>();
+	const auto& takes = station->GetLoopTakes();
+	for (auto i = 0u; i + 1u < takes.size(); i += 2u)
+		trigger->AddRoute(takes[i]->Id(), takes[i + 1u]->Id());
+
+	station->AddTrigger(trigger);
+	station->UpdateBounceRoutes();
+
+	return { station, trigger };
+}
+
+UserConfig MakeUserConfig()
+{
+	UserConfig cfg;
+	cfg.Audio.BufSize = BlockSize;
+	cfg.Audio.LatencyOut = 0u;
+
+	return cfg;
+}
+
+// Per-block id lookup over every trigger's take history, as OnBounce used
+// to resolve its routes. Arg is the number of takes.
+void BM_StationBounceLookup(benchmark::State& state)
+{
+	const auto numTakes = static_cast<unsigned int>(state.range(0));
+	auto [station, trigger] = MakeRoutedStation(numTakes);
+	const auto& takes = station->GetLoopTakes();
+	std::vector<std::weak_ptr<LoopTake>> weakTakes(takes.begin(), takes.end());
+	std::vector<std::shared_ptr<Trigger>> triggers = { trigger };
+
+	for (auto _ : state)
+	{
+		auto numMatched = 0u;
+
+		for (auto& trig : triggers)
+		{
+			for (auto& take : *trig->GetTakes())
+			{
+				const auto& sourceId = take.SourceTakeId;
+				const auto& targetId = take.TargetTakeId;
+				auto sourceMatch = std::find_if(weakTakes.begin(), weakTakes.end(),
+					[&sourceId](const std::weak_ptr<LoopTake>& arg) { auto t = arg.lock(); return t && t->Id() == sourceId; });
+				auto targetMatch = std::find_if(weakTakes.begin(), weakTakes.end(),
+					[&targetId](const std::weak_ptr<LoopTake>& arg) { auto t = arg.lock(); return t && t->Id() == targetId; });
+
+				if ((weakTakes.end() != sourceMatch) && (weakTakes.end() != targetMatch))
+					numMatched++;
+			}
+		}
+
+		benchmark::DoNotOptimize(numMatched);
+	}
+
+	state.counters["takes"] = static_cast<double>(numTakes);
+}
+
+// Full OnBounce walking the published route table. Arg is the number of takes.
+void BM_StationOnBounce(benchmark::State& state)
+{
+	const auto numTakes = static_cast<unsigned int>(state.range(0));
+	auto station = MakeRoutedStation(numTakes).first;
+	auto cfg = MakeUserConfig();
+
+	AudioStreamParams streamParams{};
+	streamParams.BufSize = BlockSize;
+	streamParams.OutputLatency = 0u;
+
+	for (auto _ : state)
+	{
+		station->OnBounce(BlockSize, cfg, streamParams);
+		benchmark::ClobberMemory();
+	}
+
+	state.counters["takes"] = static_cast<double>(numTakes);
+}
+
+// A station holding numTakes playing takes, each with a loop per channel.
+std::shared_ptr<Station> MakePlayingStation(unsigned int numTakes, unsigned int numChans)
+{
+	StationParams stationParams;
+	stationParams.Size = { 200, 200 };
+	stationParams.FadeSamps = constants::DefaultFadeSamps;
+
+	MergeMixBehaviourParams mergeParams;
+	auto station = std::make_shared<Station>(stationParams,
+		Station::GetMixerParams(stationParams.Size, mergeParams));
+	station->SetNumBusChannels(numChans);
+	station->SetNumDacChannels(numChans);
+
+	LoopTakeParams takeParams;
+	takeParams.Size = { 100, 100 };
+	takeParams.FadeSamps = constants::DefaultFadeSamps;
+
+	const unsigned long totalRecord = constants::MaxLoopFadeSamps + LoopLength;
+	std::vector<float> samples(totalRecord);
+
+	for (auto takeIndex = 0u; takeIndex < numTakes; takeIndex++)
+	{
+		auto take = std::make_shared<LoopTake>(takeParams,
+			LoopTake::GetMixerParams(takeParams.Size, mergeParams));
+		take->SetNumBusChannels(numChans);
+		take->Record({}, "bench");
+
+		for (auto chan = 0u; chan < numChans; chan++)
+		{
+			auto loop = take->AddLoop(chan, "bench");
+			loop->Record();
+
+			for (auto i = 0ul; i < totalRecord; i++)
+				samples[i] = static_cast<float>(((i + takeIndex * 31u + chan * 7u) % 200u)) / 200.0f - 0.5f;
+
+			AudioWriteRequest request;
+			request.samples = samples.data();
+			request.numSamps = static_cast<unsigned int>(totalRecord);
+			request.stride = 1;
+			request.fadeCurrent = 0.0f;
+			request.fadeNew = 1.0f;
+			request.source = Audible::AUDIOSOURCE_ADC;
+			loop->OnBlockWrite(request, 0);
+			loop->EndWrite(request.numSamps, true);
+		}
+
+		take->CommitChanges();
+		take->Play(constants::MaxLoopFadeSamps, LoopLength, 0u);
+		station->AddTake(take);
+	}
+
+	station->CommitChanges();
+
+	return station;
+}
+
+// One station block into the DAC rings, as the serial audio callback renders
+// it. Args are { numTakes, numChans, blockSize }, so the loop count is
+// numTakes * numChans.
+void BM_StationWriteBlock(benchmark::State& state)
+{
+	const auto numTakes = static_cast<unsigned int>(state.range(0));
+	const auto numChans = static_cast<unsigned int>(state.range(1));
+	const auto blockSize = static_cast<unsigned int>(state.range(2));
+
+	auto station = MakePlayingStation(numTakes, numChans);
+	ChannelMixer channelMixer(ChannelMixerParams({
+		ChannelMixer::DefaultBufferSize,
+		ChannelMixer::DefaultBufferSize,
+		numChans,
+		numChans }));
+	auto dest = channelMixer.Sink();
+	std::uint32_t blockStartSample = 0u;
+
+	for (auto _ : state)
+	{
+		dest->Zero(blockSize, Audible::AUDIOSOURCE_LOOPS);
+		station->Zero(blockSize, Audible::AUDIOSOURCE_LOOPS);
+		station->WriteBlock(dest, nullptr, 0, blockSize, blockStartSample);
+		station->EndMultiPlay(blockSize);
+		dest->EndMultiWrite(blockSize, true, Audible::AUDIOSOURCE_LOOPS);
+		blockStartSample += blockSize;
+		benchmark::ClobberMemory();
+	}
+
+	state.SetItemsProcessed(state.iterations() * blockSize);
+	state.counters["takes"] = static_cast<double>(numTakes);
+	state.counters["chans"] = static_cast<double>(numChans);
+	state.counters["loops"] = static_cast<double>(numTakes * numChans);
+}
+
+void StationWriteBlockArgs(benchmark::internal::Benchmark* bench)
+{
+	for (auto numTakes : { 1, 4, 16 })
+	{
+		for (auto numChans : { 2, 8 })
+		{
+			for (auto blockSize : { 64, 256, 1024 })
+				bench->Args({ numTakes, numChans, blockSize });
+		}
+	}
+}
+
+} // namespace
+
+BENCHMARK(BM_StationBounceLookup)->Arg(8)->Arg(64);
+BENCHMARK(BM_StationOnBounce)->Arg(8)->Arg(64);
+BENCHMARK(BM_StationWriteBlock)->Apply(StationWriteBlockArgs);
@@ -0,0 +1,80 @@
+#include "benchmark/benchmark.h"
+#include "midi/MidiLoop.h"
+#include "midi/MidiEvent.h"
+#include <memory>
+
+using midi::IMidiSink;
+using midi::MidiEvent;
+using midi::MidiLoop;
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+
+namespace {
+
+constexpr std::uint32_t LoopLength = 2u * constants::DefaultSampleRate;
+
+class CountingSink : public IMidiSink
+{
+public:
+	void OnEvent(const MidiEvent& ev) noexcept override { NumEvents++; }
+
+	std::uint64_t NumEvents = 0u;
+};
+
+// A playing loop holding numNotes evenly spaced notes, each held for half
+// the gap to the next.
+std::unique_ptr<MidiLoop> MakePlayingLoop(unsigned int numNotes)
+{
+	auto loop = std::make_unique<MidiLoop>();
+	loop->StartRecord();
+
+	const auto gap = LoopLength / numNotes;
+	for (auto i = 0u; i < numNotes; i++)
+	{
+		auto note = static_cast<std::uint8_t>(36u + (i % 48u));
+		loop->RecordEvent(MidiEvent::MakeNoteOn(i * gap, 0, note, 100));
+		loop->RecordEvent(MidiEvent::MakeNoteOff((i * gap) + (gap / 2u), 0, note));
+	}
+
+	loop->EndRecord(LoopLength);
+
+	return loop;
+}
+
+// Consecutive blocks read from a playing loop, wrapping round it.
+// Args are { blockSize, numNotes }.
+void BM_MidiLoopReadBlock(benchmark::State& state)
+{
+	const auto blockSize = static_cast<std::uint32_t>(state.range(0));
+	const auto numNotes = static_cast<unsigned int>(state.range(1));
+
+	auto loop = MakePlayingLoop(numNotes);
+	CountingSink sink;
+	std::uint32_t globalSample = 0u;
+
+	for (auto _ : state)
+	{
+		loop->ReadBlock(globalSample, blockSize, sink);
+		globalSample += blockSize;
+	}
+
+	benchmark::DoNotOptimize(sink.NumEvents);
+
+	state.SetItemsProcessed(state.iterations() * blockSize);
+	state.counters["events"] = benchmark::Counter(static_cast<double>(sink.NumEvents), benchmark::Counter::kAvgIterations);
+}
+
+void MidiLoopReadBlockArgs(benchmark::internal::Benchmark* bench)
+{
+	for (auto numNotes : { 16, 256, 2048 })
+	{
+		for (auto blockSize : { 64, 256, 1024 })
+			bench->Args({ blockSize, numNotes });
+	}
+}
+
+} // namespace
+
+BENCHMARK(BM_MidiLoopReadBlock)->Apply(MidiLoopReadBlockArgs);
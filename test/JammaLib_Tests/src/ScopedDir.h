@@ -0,0 +1,27 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <system_error>
+
+// Fresh directory under the temp path, removed again afterwards
+class ScopedDir
+{
+public:
+	explicit ScopedDir(const std::string& name) :
+		Path(std::filesystem::temp_directory_path() / ("jamma_" + name))
+	{
+		std::filesystem::remove_all(Path);
+		std::filesystem::create_directories(Path);
+	}
+
+	~ScopedDir()
+	{
+		std::error_code error;
+		std::filesystem::remove_all(Path, error);
+	}
+
+	std::wstring File(const std::string& name) const { return (Path / name).wstring(); }
+
+	std::filesystem::path Path;
+};
@@ -335,3 +335,20 @@ TEST(AudioBuffer, PreservesRequestedSizeAboveMaxBlockSize)
 
     ASSERT_EQ(resizedSize, audioBuf->BufSize());
 }
+
+TEST(AudioBuffer, RoundsCapacityUpToPowerOfTwo)
+{
+    auto audioBuf = std::make_shared<AudioBuffer>(3000u);
+
+    ASSERT_EQ(3000u, audioBuf->BufSize());
+    ASSERT_EQ(4096u, audioBuf->Capacity());
+    ASSERT_EQ(4095u, audioBuf->Mask());
+
+    audioBuf->SetSize(4096u);
+
+    ASSERT_EQ(4096u, audioBuf->Capacity());
+
+    audioBuf->SetSize(0u);
+
+    ASSERT_EQ(0u, audioBuf->Capacity());
+}
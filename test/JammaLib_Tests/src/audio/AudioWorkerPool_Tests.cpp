@@ -0,0 +1,85 @@
+#include "gtest/gtest.h"
+#include "audio/AudioWorkerPool.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using audio::AudioWorkerPool;
+
+namespace {
+
+constexpr unsigned int MaxTestItems = 64u;
+
+struct CountContext
+{
+	std::array<std::atomic<unsigned int>, MaxTestItems> Hits{};
+};
+
+void CountTask(void* context, unsigned int index) noexcept
+{
+	static_cast<CountContext*>(context)->Hits[index].fetch_add(1u, std::memory_order_relaxed);
+}
+
+// Slow enough that workers join in before the caller has claimed everything
+void SlowCountTask(void* context, unsigned int index) noexcept
+{
+	std::this_thread::sleep_for(std::chrono::microseconds(200));
+	CountTask(context, index);
+}
+
+}
+
+TEST(AudioWorkerPool, SerialWithoutWorkersRunsEveryItem)
+{
+	AudioWorkerPool pool;
+	CountContext context;
+
+	pool.Run(&CountTask, &context, 10u);
+
+	ASSERT_EQ(0u, pool.NumWorkers());
+	for (auto i = 0u; i < MaxTestItems; i++)
+		ASSERT_EQ(i < 10u ? 1u : 0u, context.Hits[i].load());
+}
+
+TEST(AudioWorkerPool, RunsEveryItemExactlyOncePerGeneration)
+{
+	const unsigned int numRuns = 2000u;
+
+	AudioWorkerPool pool;
+	pool.Start(3u);
+	ASSERT_EQ(3u, pool.NumWorkers());
+
+	CountContext context;
+	for (auto run = 0u; run < numRuns; run++)
+		pool.Run(&CountTask, &context, MaxTestItems);
+
+	pool.Stop();
+	ASSERT_EQ(0u, pool.NumWorkers());
+
+	for (auto i = 0u; i < MaxTestItems; i++)
+		ASSERT_EQ(numRuns, context.Hits[i].load());
+}
+
+TEST(AudioWorkerPool, IdleWorkersSleepAfterRunning)
+{
+	AudioWorkerPool pool;
+	pool.Start(3u);
+
+	CountContext context;
+	for (auto run = 0u; run < 10u; run++)
+		pool.Run(&SlowCountTask, &context, MaxTestItems);
+
+	// Spinning workers would never get here
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while ((pool.NumSleeping() < 3u) && (std::chrono::steady_clock::now() < deadline))
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+	EXPECT_EQ(3u, pool.NumSleeping());
+
+	pool.Run(&CountTask, &context, MaxTestItems);
+	pool.Stop();
+
+	for (auto i = 0u; i < MaxTestItems; i++)
+		ASSERT_EQ(11u, context.Hits[i].load());
+}
@@ -0,0 +1,203 @@
+#include "gtest/gtest.h"
+#include "audio/BankPool.h"
+#include "audio/BufferBank.h"
+#include <utility>
+
+using audio::BankPool;
+using audio::BufferBank;
+
+namespace {
+
+std::size_t HeldBytes(const BankPool::Usage& usage)
+{
+	return usage.InUseBytes + usage.FreeBytes;
+}
+
+// A pool of its own, so slab size changes don't depend on what earlier
+// tests left in use in the shared one
+class LocalPool : public BankPool
+{
+public:
+	LocalPool() : BankPool() {}
+};
+
+}
+
+TEST(BankPool, ReleasedSlabIsReusedZeroed)
+{
+	auto& pool = BankPool::Instance();
+
+	auto slab = pool.Acquire();
+	ASSERT_NE(nullptr, slab);
+
+	slab[0] = 0.5f;
+	slab[pool.SlabSize() - 1ul] = -0.5f;
+	auto slabPtr = slab.get();
+	pool.Release(std::move(slab));
+
+	auto heldBefore = HeldBytes(pool.GetUsage());
+	auto reused = pool.Acquire();
+
+	ASSERT_EQ(slabPtr, reused.get());
+	ASSERT_EQ(0.0f, reused[0]);
+	ASSERT_EQ(0.0f, reused[pool.SlabSize() - 1ul]);
+	ASSERT_EQ(heldBefore, HeldBytes(pool.GetUsage()));
+
+	pool.Release(std::move(reused));
+}
+
+TEST(BankPool, BudgetCapsAcquire)
+{
+	auto& pool = BankPool::Instance();
+	pool.Trim();
+
+	auto usage = pool.GetUsage();
+	pool.Configure(pool.SlabSize(), usage.InUseBytes + (2u * usage.SlabBytes));
+
+	auto slab1 = pool.Acquire();
+	auto slab2 = pool.Acquire();
+	auto slab3 = pool.Acquire();
+
+	EXPECT_NE(nullptr, slab1);
+	EXPECT_NE(nullptr, slab2);
+	EXPECT_EQ(nullptr, slab3);
+
+	pool.Release(std::move(slab1));
+	pool.Release(std::move(slab2));
+	pool.Configure(pool.SlabSize(), usage.BudgetBytes);
+}
+
+TEST(BankPool, SlabSizeIsLockedWhileInUse)
+{
+	LocalPool pool;
+	auto slabSize = pool.SlabSize();
+	auto budget = pool.GetUsage().BudgetBytes;
+	ASSERT_EQ(0u, pool.GetUsage().InUseBytes);
+
+	auto slab = pool.Acquire();
+	ASSERT_NE(nullptr, slab);
+	ASSERT_FALSE(pool.Configure(slabSize * 2ul, budget));
+	ASSERT_EQ(slabSize, pool.SlabSize());
+
+	pool.Release(std::move(slab));
+
+	ASSERT_TRUE(pool.Configure(slabSize * 2ul, budget));
+	ASSERT_EQ(slabSize * 2ul, pool.SlabSize());
+	ASSERT_TRUE(pool.Configure(slabSize, budget));
+	ASSERT_EQ(slabSize, pool.SlabSize());
+}
+
+TEST(BankPool, SlabSizeIsLockedWhileBanksAttached)
+{
+	LocalPool pool;
+	auto slabSize = pool.SlabSize();
+	auto budget = pool.GetUsage().BudgetBytes;
+	ASSERT_EQ(0u, pool.GetUsage().InUseBytes);
+
+	// A bank holding nothing but packed samples still indexes by slab size
+	ASSERT_EQ(pool.SlabShift(), pool.AttachBank());
+	ASSERT_FALSE(pool.Configure(slabSize * 2ul, budget));
+	ASSERT_EQ(slabSize, pool.SlabSize());
+
+	pool.DetachBank();
+
+	ASSERT_TRUE(pool.Configure(slabSize * 2ul, budget));
+	ASSERT_TRUE(pool.Configure(slabSize, budget));
+}
+
+TEST(BankPool, BufferBankLocksSlabSize)
+{
+	auto& pool = BankPool::Instance();
+	auto slabSize = pool.SlabSize();
+	auto budget = pool.GetUsage().BudgetBytes;
+
+	BufferBank bank;
+	ASSERT_FALSE(pool.Configure(slabSize * 2ul, budget));
+	ASSERT_EQ(slabSize, pool.SlabSize());
+
+	BufferBank moved(std::move(bank));
+	ASSERT_EQ(slabSize, moved.BankSize());
+	ASSERT_FALSE(pool.Configure(slabSize * 2ul, budget));
+}
+
+TEST(BankPool, RoundsSlabSizeToPowerOfTwo)
+{
+	LocalPool pool;
+	auto slabSize = pool.SlabSize();
+	auto budget = pool.GetUsage().BudgetBytes;
+	ASSERT_EQ(0u, pool.GetUsage().InUseBytes);
+
+	pool.Configure(100000ul, budget);
+	EXPECT_EQ(131072ul, pool.SlabSize());
+
+	pool.Configure(1ul, budget);
+	EXPECT_EQ(1ul << BankPool::MinSlabShift, pool.SlabSize());
+
+	pool.Configure(slabSize, budget);
+	ASSERT_EQ(slabSize, pool.SlabSize());
+}
+
+TEST(BankPool, BufferBankRecyclesSlabs)
+{
+	auto& pool = BankPool::Instance();
+	pool.Trim();
+
+	auto inUseBefore = pool.GetUsage().InUseBytes;
+	std::size_t bankBytes = 0;
+
+	{
+		BufferBank bank;
+		bank.Resize(3ul * bank.BankSize());
+		bankBytes = bank.AllocatedBytes();
+
+		ASSERT_GT(bankBytes, 0u);
+		ASSERT_EQ(inUseBefore + bankBytes, pool.GetUsage().InUseBytes);
+	}
+
+	auto usage = pool.GetUsage();
+	ASSERT_EQ(inUseBefore, usage.InUseBytes);
+	ASSERT_EQ(bankBytes, usage.FreeBytes);
+
+	// A warm pool serves the next bank without allocating
+	auto heldBefore = HeldBytes(usage);
+	{
+		BufferBank bank;
+		bank.Resize(3ul * bank.BankSize());
+
+		ASSERT_EQ(bankBytes, bank.AllocatedBytes());
+		ASSERT_EQ(heldBefore, HeldBytes(pool.GetUsage()));
+		ASSERT_EQ(0.0f, bank[2ul * bank.BankSize()]);
+	}
+}
+
+TEST(BankPool, BufferBankStopsGrowingAtBudget)
+{
+	auto& pool = BankPool::Instance();
+	pool.Trim();
+
+	auto usage = pool.GetUsage();
+	pool.Configure(pool.SlabSize(), usage.InUseBytes + (2u * usage.SlabBytes));
+
+	{
+		BufferBank bank;
+		bank.Resize(10ul * bank.BankSize());
+
+		ASSERT_EQ(2ul * bank.BankSize(), bank.Capacity());
+
+		// Writes beyond capacity are dropped rather than crashing
+		bank[5ul * bank.BankSize()] = 1.0f;
+	}
+
+	pool.Configure(pool.SlabSize(), usage.BudgetBytes);
+}
+
+TEST(BankPool, FormatsUsageInMegabytes)
+{
+	BankPool::Usage usage;
+	usage.SlabBytes = 512u * 1024u;
+	usage.BudgetBytes = std::size_t(4096u) << 20;
+	usage.InUseBytes = 3u * usage.SlabBytes;
+	usage.FreeBytes = usage.SlabBytes;
+
+	EXPECT_EQ("in use 1.5 MB, free 0.5 MB, budget 4096.0 MB (512 KB slabs)", BankPool::FormatUsage(usage));
+}
@@ -17,6 +17,7 @@ using audio::PanMixBehaviourParams;
 using audio::BounceMixBehaviourParams;
 using audio::MergeMixBehaviourParams;
 using audio::InterpolatedValueExp;
+using audio::InterpolatedValueLinear;
 using engine::Loop;
 using engine::LoopParams;
 using base::AudioSink;
@@ -42,8 +43,13 @@ public:
 		{
 			auto destIndex = _writeIndex + writeOffset + i;
 			if (destIndex < Samples.size())
-				Samples[destIndex] = (request.fadeNew * request.samples[i * request.stride]) +
-					(request.fadeCurrent * Samples[destIndex]);
+			{
+				auto ramp = (nullptr != request.fadeRamp) ? request.fadeRamp[i] : 1.0f;
+				auto fadeCurrent = request.fadeCurrent +
+					((nullptr != request.fadeRamp) ? request.fadeCurrentRamp * ramp : 0.0f);
+				Samples[destIndex] = ((request.fadeNew * ramp) * request.samples[i * request.stride]) +
+					(fadeCurrent * Samples[destIndex]);
+			}
 		}
 	}
 
@@ -318,6 +324,44 @@ TEST(BlockApi, PanMixerWriteBlock) {
 	}
 }
 
+TEST(BlockApi, MixerWriteBlockRampsMidFade) {
+	auto numSamps = 64u;
+
+	WireMixBehaviourParams wire;
+	wire.Channels = { 0 };
+
+	AudioMixerParams mixerParams;
+	mixerParams.Size = { 110, 80 };
+	mixerParams.Position = { 6, 6 };
+	mixerParams.Behaviour = wire;
+
+	auto mixer = AudioMixer(mixerParams);
+	mixer.Mute();
+
+	auto dest = std::make_shared<MockedMultiSink>(1, numSamps);
+	std::vector<float> src(numSamps, 1.0f);
+
+	mixer.WriteBlock(dest, src.data(), numSamps);
+
+	// Reference: the same fade stepped one sample at a time
+	InterpolatedValueExp::ExponentialParams params;
+	params.Damping = 100.0;
+	auto fade = InterpolatedValueExp(params);
+	fade.Jump(AudioMixer::DefaultLevel);
+	fade.SetTarget(0.0);
+
+	auto sink = dest->GetSink(0);
+	for (auto i = 0u; i < numSamps; i++)
+	{
+		auto expected = fade.Next();
+		ASSERT_NEAR(expected, sink->Samples[i], 1e-6)
+			<< "Ramp mismatch at sample " << i;
+	}
+
+	ASSERT_LT(sink->Samples[numSamps - 1], sink->Samples[0]);
+	ASSERT_NEAR(fade.Current(), mixer.Level(), 1e-9);
+}
+
 // ---------------------------------------------------------------
 // Loop block write and read tests
 // ---------------------------------------------------------------
@@ -509,6 +553,74 @@ TEST(BlockApi, FadeIsNotSettledDuringRamp) {
 	ASSERT_FALSE(fade.IsSettled());
 }
 
+TEST(BlockApi, FadeAdvanceMatchesNext) {
+	InterpolatedValueExp::ExponentialParams params;
+	params.Damping = 100.0;
+	auto stepped = InterpolatedValueExp(params);
+	auto advanced = InterpolatedValueExp(params);
+
+	stepped.Jump(0.0);
+	stepped.SetTarget(1.0);
+	advanced.Jump(0.0);
+	advanced.SetTarget(1.0);
+
+	for (auto i = 0u; i < 250u; i++)
+		stepped.Next();
+	advanced.Advance(250u);
+
+	ASSERT_NEAR(stepped.Current(), advanced.Current(), 1e-9);
+	ASSERT_FALSE(advanced.IsSettled());
+
+	advanced.Advance(100000u);
+	ASSERT_EQ(1.0, advanced.Current());
+}
+
+TEST(BlockApi, FadeRampMatchesNext) {
+	InterpolatedValueExp::ExponentialParams params;
+	params.Damping = 50.0;
+	auto stepped = InterpolatedValueExp(params);
+	auto ramped = InterpolatedValueExp(params);
+
+	stepped.Jump(1.0);
+	stepped.SetTarget(0.25);
+	ramped.Jump(1.0);
+	ramped.SetTarget(0.25);
+
+	std::vector<float> ramp(128u);
+	ramped.FillRamp(ramp.data(), (unsigned int)ramp.size());
+
+	for (auto i = 0u; i < ramp.size(); i++)
+		ASSERT_NEAR(stepped.Next(), ramp[i], 1e-6) << "Ramp mismatch at sample " << i;
+
+	ASSERT_NEAR(stepped.Current(), ramped.Current(), 1e-9);
+}
+
+TEST(BlockApi, LinearFadeClampsAtTarget) {
+	InterpolatedValueLinear::LinearParams params;
+	params.Rate = 0.1;
+	auto fade = InterpolatedValueLinear(params);
+
+	fade.Jump(0.0);
+	fade.SetTarget(1.0);
+
+	std::vector<float> ramp(16u);
+	fade.FillRamp(ramp.data(), (unsigned int)ramp.size());
+
+	for (auto i = 0u; i < 9u; i++)
+		ASSERT_NEAR(0.1 * (i + 1), ramp[i], 1e-6);
+	for (auto i = 9u; i < ramp.size(); i++)
+		ASSERT_FLOAT_EQ(1.0f, ramp[i]);
+
+	ASSERT_TRUE(fade.IsSettled());
+	ASSERT_EQ(1.0, fade.Current());
+
+	fade.SetTarget(0.0);
+	fade.Advance(5u);
+	ASSERT_NEAR(0.5, fade.Current(), 1e-9);
+	fade.Advance(50u);
+	ASSERT_EQ(0.0, fade.Current());
+}
+
 // ---------------------------------------------------------------
 // MultiAudioSink::OnBlockWriteChannel test
 // ---------------------------------------------------------------
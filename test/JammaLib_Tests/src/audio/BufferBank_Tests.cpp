@@ -1,7 +1,13 @@
 
 #include "gtest/gtest.h"
+#include "audio/BankPool.h"
 #include "audio/BufferBank.h"
+#include "utils/Epoch.h"
+#include <algorithm>
+#include <utility>
+#include <vector>
 
+using audio::BankPool;
 using audio::BufferBank;
 
 class BufferBankSource
@@ -107,3 +113,326 @@ TEST(BufferBank, SetLengthDoesNotExceedCapacityAfterResize) {
 	bank.SetLength(newCapacity + 1);
 	ASSERT_EQ(bank.Length(), newCapacity);
 }
+
+TEST(BufferBank, SummaryMatchesLinearScan) {
+	BufferBank bank;
+	auto numSamps = (unsigned int)(bank.BankSize() * 2ul + 1000ul);
+	BufferBankSource source(numSamps);
+	source.Fill(bank);
+	bank.UpdateSummary(0ul, numSamps);
+
+	// Ranges inside one grain, across grains, and across slabs
+	std::vector<std::pair<unsigned long, unsigned long>> ranges = {
+		{ 3ul, 40ul },
+		{ 100ul, 3000ul },
+		{ 0ul, bank.BankSize() },
+		{ bank.BankSize() - 777ul, bank.BankSize() + 5000ul },
+		{ 12345ul, numSamps },
+		{ 0ul, numSamps + 100ul }
+	};
+
+	for (auto [i1, i2] : ranges)
+	{
+		auto end = std::min<unsigned long>(i2, numSamps);
+		auto expectedMin = bank[i1];
+		auto expectedMax = bank[i1];
+		for (auto i = i1; i < end; i++)
+		{
+			expectedMin = std::min(expectedMin, bank[i]);
+			expectedMax = std::max(expectedMax, bank[i]);
+		}
+
+		ASSERT_EQ(expectedMin, bank.SubMin(i1, i2));
+		ASSERT_EQ(expectedMax, bank.SubMax(i1, i2));
+	}
+}
+
+TEST(BufferBank, FadeMixBlockKeepsSummaryCurrent) {
+	BufferBank bank;
+	auto numSamps = 4096u;
+	bank.Resize(numSamps);
+
+	std::vector<float> loud(numSamps, 0.8f);
+	std::vector<float> quiet(numSamps, 0.1f);
+	loud[1000] = -0.9f;
+
+	bank.FadeMixBlock(0ul, loud.data(), 1u, numSamps, 0.0f, 1.0f);
+	ASSERT_EQ(-0.9f, bank.SubMin(0ul, numSamps));
+	ASSERT_EQ(0.8f, bank.SubMax(0ul, numSamps));
+
+	// Overdubbing over the top can shrink the range as well as grow it
+	bank.FadeMixBlock(0ul, quiet.data(), 1u, numSamps, 0.0f, 1.0f);
+	ASSERT_EQ(0.1f, bank.SubMin(0ul, numSamps));
+	ASSERT_EQ(0.1f, bank.SubMax(0ul, numSamps));
+	ASSERT_NEAR(0.1f, bank.SubRms(0ul, numSamps), 1e-5f);
+}
+
+TEST(BufferBank, SummaryIgnoresUntrackedWritesUntilUpdated) {
+	BufferBank bank;
+	bank.Resize(2048u);
+
+	bank[600] = 0.5f;
+	ASSERT_EQ(0.0f, bank.SubMax(0ul, 2048ul));
+
+	bank.UpdateSummary(600ul, 1ul);
+	ASSERT_EQ(0.5f, bank.SubMax(0ul, 2048ul));
+}
+
+TEST(BufferBank, DirtyRangeCoversWritesUntilTaken) {
+	BufferBank bank;
+	bank.Resize(8192u);
+	bank.TakeDirtyRange();
+
+	std::vector<float> samps(256u, 0.25f);
+	bank.FadeMixBlock(1000ul, samps.data(), 1u, 256u, 1.0f, 1.0f);
+	bank.FadeMixBlock(5000ul, samps.data(), 1u, 100u, 1.0f, 1.0f);
+
+	auto range = bank.TakeDirtyRange();
+	ASSERT_EQ(1000ul, range.Start);
+	ASSERT_EQ(5100ul, range.End);
+	ASSERT_TRUE(bank.TakeDirtyRange().IsEmpty());
+}
+
+TEST(BufferBank, WriteCountIsEvenBetweenWrites) {
+	BufferBank bank;
+	bank.Resize(4096u);
+
+	auto writeCount = bank.WriteCount();
+	ASSERT_EQ(0u, writeCount & 1u);
+
+	// Odd for the length of each write, so every write moves it on by two
+	std::vector<float> samps(256u, 0.25f);
+	bank.FadeMixBlock(1000ul, samps.data(), 1u, 256u, 1.0f, 1.0f);
+	ASSERT_EQ(writeCount + 2u, bank.WriteCount());
+
+	bank[600] = 0.5f;
+	bank.UpdateSummary(600ul, 1ul);
+	ASSERT_EQ(writeCount + 4u, bank.WriteCount());
+
+	// A write wholly past the end still closes what it opened
+	bank.FadeMixBlock(bank.Capacity(), samps.data(), 1u, 256u, 1.0f, 1.0f);
+	ASSERT_EQ(0u, bank.WriteCount() & 1u);
+}
+
+TEST(BufferBank, SilenceMapTracksAudibleGrains) {
+	BufferBank bank;
+	bank.Resize(8192u);
+	ASSERT_TRUE(bank.IsSilent(0ul, 8192ul));
+
+	// Spans the grains at 768 and 1024
+	std::vector<float> samps(40u, 0.5f);
+	bank.FadeMixBlock(1000ul, samps.data(), 1u, 40u, 0.0f, 1.0f);
+	ASSERT_FALSE(bank.IsSilent(0ul, 8192ul));
+	ASSERT_FALSE(bank.IsSilent(1279ul, 1280ul));
+	ASSERT_FALSE(bank.IsSilent(767ul, 769ul));
+	ASSERT_TRUE(bank.IsSilent(0ul, 768ul));
+	ASSERT_TRUE(bank.IsSilent(1280ul, 8192ul));
+
+	// Fading out over the top silences the grains again
+	bank.FadeMixBlock(1000ul, samps.data(), 1u, 40u, 0.0f, 0.0f);
+	ASSERT_TRUE(bank.IsSilent(0ul, 8192ul));
+
+	// Untracked writes need an update, and must clear the threshold
+	bank[5000] = BufferBank::SilenceThreshold * 0.5f;
+	bank[6000] = 0.1f;
+	ASSERT_TRUE(bank.IsSilent(0ul, 8192ul));
+	bank.UpdateSummary(5000ul, 1001ul);
+	ASSERT_TRUE(bank.IsSilent(4096ul, 5888ul));
+	ASSERT_FALSE(bank.IsSilent(6000ul, 6001ul));
+
+	ASSERT_TRUE(bank.IsSilent(8192ul, 100000ul));
+	ASSERT_TRUE(bank.IsSilent(7000ul, 7000ul));
+}
+
+TEST(BufferBank, SilenceMapSpansBanks) {
+	BufferBank bank;
+	auto bankSize = bank.BankSize();
+	bank.Resize(3ul * bankSize);
+
+	bank[bankSize + 10ul] = -0.25f;
+	bank.UpdateSummary(bankSize + 10ul, 1ul);
+
+	ASSERT_FALSE(bank.IsSilent(0ul, 3ul * bankSize));
+	ASSERT_FALSE(bank.IsSilent(bankSize - 1ul, bankSize + 1ul));
+	ASSERT_TRUE(bank.IsSilent(0ul, bankSize));
+	ASSERT_TRUE(bank.IsSilent(bankSize + BufferBank::SummaryGrain, 3ul * bankSize));
+}
+
+TEST(BufferBank, PackedBanksReadBackWithinOneStep) {
+	BufferBank bank;
+	auto bankSize = bank.BankSize();
+	auto numSamps = (unsigned int)(bankSize * 2ul + 1000ul);
+	BufferBankSource source(numSamps);
+	source.Fill(bank);
+	bank.UpdateSummary(0ul, numSamps);
+
+	std::vector<float> before(numSamps);
+	bank.Read(0ul, before.data(), numSamps);
+	auto alignedMax = bank.SubMax(0ul, 2ul * bankSize);
+	auto max = bank.SubMax(5ul, numSamps);
+
+	ASSERT_EQ(3u, bank.PackBanks());
+	ASSERT_EQ(3u, bank.CommitPacked());
+	ASSERT_EQ(3u, bank.NumPackedBanks());
+
+	std::vector<float> after(numSamps + 10u, 1.0f);
+	bank.Read(0ul, after.data(), numSamps + 10u);
+
+	// Every source sample is under 1, so a step is under 1 / 32767
+	for (auto i = 0u; i < numSamps; i++)
+	{
+		ASSERT_NEAR(before[i], after[i], 1.0f / 32767.0f) << "sample " << i;
+		ASSERT_EQ(after[i], std::as_const(bank)[i]);
+	}
+
+	for (auto i = numSamps; i < numSamps + 10u; i++)
+		ASSERT_EQ(0.0f, after[i]);
+
+	// Whole grains still come from the summaries taken before packing
+	ASSERT_EQ(alignedMax, bank.SubMax(0ul, 2ul * bankSize));
+	ASSERT_NEAR(max, bank.SubMax(5ul, numSamps), 1.0f / 32767.0f);
+	ASSERT_EQ(nullptr, bank.BlockPtr(0ul));
+}
+
+TEST(BufferBank, PackingHalvesHeldMemory) {
+	auto& pool = BankPool::Instance();
+	utils::EpochDomain::Instance().Reclaim();
+
+	BufferBank bank;
+	auto bankSize = bank.BankSize();
+	bank.Resize(4ul * bankSize);
+
+	auto slabBytes = sizeof(float) * bankSize;
+	auto packedBytes = (sizeof(std::int16_t) * bankSize) + (sizeof(float) * (bankSize / BufferBank::SummaryGrain));
+	auto bytes = bank.AllocatedBytes();
+	auto inUse = pool.GetUsage().InUseBytes;
+	auto numReserved = pool.NumReserved();
+
+	bank.PackBanks();
+	ASSERT_EQ(4u, bank.CommitPacked());
+	ASSERT_EQ(bytes - (4u * slabBytes) + (4u * packedBytes), bank.AllocatedBytes());
+
+	// The slabs go back to the pool once no reader can still see them,
+	// less whatever was taken to refill the reserve
+	bank.UpdateCapacity();
+	utils::EpochDomain::Instance().Reclaim();
+
+	auto numRefilled = pool.NumReserved() - numReserved;
+	ASSERT_EQ(inUse - ((4u - numRefilled) * slabBytes), pool.GetUsage().InUseBytes);
+}
+
+TEST(BufferBank, WriteUnpacksPackedBank) {
+	BufferBank bank;
+	auto bankSize = bank.BankSize();
+	bank.Resize(2ul * bankSize);
+
+	std::vector<float> quiet(2ul * bankSize, 0.25f);
+	bank.FadeMixBlock(0ul, quiet.data(), 1u, (unsigned int)quiet.size(), 0.0f, 1.0f);
+	bank.PackBanks();
+	ASSERT_EQ(2u, bank.CommitPacked());
+
+	BankPool::Instance().RefillReserve();
+
+	std::vector<float> loud(100u, 0.5f);
+	bank.FadeMixBlock(bankSize + 10ul, loud.data(), 1u, 100u, 1.0f, 1.0f);
+
+	ASSERT_EQ(1u, bank.NumPackedBanks());
+	ASSERT_NEAR(0.75f, std::as_const(bank)[bankSize + 10ul], 1e-6f);
+	ASSERT_NEAR(0.25f, std::as_const(bank)[bankSize + 200ul], 1e-6f);
+	ASSERT_NEAR(0.75f, bank.SubMax(bankSize, 2ul * bankSize), 1e-6f);
+
+	// The other bank is still packed
+	ASSERT_NEAR(0.25f, std::as_const(bank)[10ul], 1e-6f);
+	ASSERT_EQ(nullptr, bank.BlockPtr(10ul));
+
+	bank.UpdateCapacity();
+}
+
+TEST(BufferBank, WriteUnpacksOnlyTouchedGrains) {
+	BufferBank bank;
+	auto bankSize = bank.BankSize();
+	bank.Resize(bankSize);
+
+	std::vector<float> quiet(bankSize, 0.25f);
+	bank.FadeMixBlock(0ul, quiet.data(), 1u, (unsigned int)quiet.size(), 0.0f, 1.0f);
+	bank.PackBanks();
+	ASSERT_EQ(1u, bank.CommitPacked());
+
+	BankPool::Instance().RefillReserve();
+	auto slabBytes = sizeof(float) * bankSize;
+	auto packBytes = (sizeof(std::int16_t) * bankSize) + (sizeof(float) * (bankSize / BufferBank::SummaryGrain));
+	auto packedBytes = bank.AllocatedBytes();
+
+	// Straddles the first two grains
+	auto grain = BufferBank::SummaryGrain;
+	std::vector<float> loud(grain, 0.5f);
+	bank.FadeMixBlock(grain / 2ul, loud.data(), 1u, (unsigned int)grain, 1.0f, 1.0f);
+
+	// Held as both until every grain has been written
+	ASSERT_EQ(0u, bank.NumPackedBanks());
+	ASSERT_EQ(packedBytes + slabBytes, bank.AllocatedBytes());
+	ASSERT_EQ(nullptr, bank.BlockPtr(0ul));
+
+	std::vector<float> samps(3ul * grain);
+	bank.Read(0ul, samps.data(), (unsigned int)samps.size());
+	for (auto i = 0ul; i < samps.size(); i++)
+	{
+		auto expected = ((i >= grain / 2ul) && (i < grain + (grain / 2ul))) ? 0.75f : 0.25f;
+		ASSERT_NEAR(expected, samps[i], 1e-6f) << "sample " << i;
+	}
+
+	bank.FadeMixBlock(0ul, quiet.data(), 1u, (unsigned int)quiet.size(), 1.0f, 1.0f);
+	ASSERT_EQ(packedBytes + slabBytes - packBytes, bank.AllocatedBytes());
+	ASSERT_NE(nullptr, bank.BlockPtr(0ul));
+	ASSERT_NEAR(1.0f, std::as_const(bank)[grain], 1e-6f);
+	ASSERT_NEAR(0.5f, std::as_const(bank)[bankSize - 1ul], 1e-6f);
+
+	bank.UpdateCapacity();
+}
+
+TEST(BufferBank, WriteWhilePackingKeepsSlab) {
+	BufferBank bank;
+	auto bankSize = bank.BankSize();
+	bank.Resize(bankSize);
+
+	std::vector<float> samps(1000u, 0.25f);
+	bank.FadeMixBlock(0ul, samps.data(), 1u, 1000u, 0.0f, 1.0f);
+	ASSERT_EQ(1u, bank.PackBanks());
+
+	bank.FadeMixBlock(500ul, samps.data(), 1u, 10u, 1.0f, 1.0f);
+	ASSERT_EQ(0u, bank.CommitPacked());
+	ASSERT_EQ(0u, bank.NumPackedBanks());
+	ASSERT_EQ(0.5f, std::as_const(bank)[505ul]);
+
+	// Once the stale pack is cleared away the bank can be packed again
+	bank.UpdateCapacity();
+	ASSERT_EQ(1u, bank.PackBanks());
+	ASSERT_EQ(1u, bank.CommitPacked());
+	ASSERT_NEAR(0.5f, std::as_const(bank)[505ul], 1e-6f);
+}
+
+TEST(BufferBank, WriteWithoutReserveIsDropped) {
+	auto& pool = BankPool::Instance();
+	BufferBank bank;
+	bank.Resize(1000u);
+
+	std::vector<float> samps(100u, 0.25f);
+	bank.FadeMixBlock(0ul, samps.data(), 1u, 100u, 0.0f, 1.0f);
+	bank.PackBanks();
+	ASSERT_EQ(1u, bank.CommitPacked());
+
+	std::vector<std::unique_ptr<float[]>> taken;
+	while (auto slab = pool.TakeReserved())
+		taken.push_back(std::move(slab));
+
+	bank.FadeMixBlock(0ul, samps.data(), 1u, 100u, 1.0f, 1.0f);
+	ASSERT_EQ(1u, bank.NumPackedBanks());
+	ASSERT_NEAR(0.25f, std::as_const(bank)[50ul], 1e-6f);
+
+	bank[50ul] = 1.0f;
+	ASSERT_EQ(1u, bank.NumPackedBanks());
+	ASSERT_NEAR(0.25f, std::as_const(bank)[50ul], 1e-6f);
+
+	for (auto& slab : taken)
+		pool.Release(std::move(slab));
+}
@@ -0,0 +1,193 @@
+#include "gtest/gtest.h"
+#include "audio/CallbackProfiler.h"
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using audio::CallbackProfiler;
+using audio::ProfileScope;
+
+TEST(CallbackProfiler, BucketsCoverEveryDuration)
+{
+	auto prevIndex = 0u;
+
+	for (auto ns = 0ull; ns < 5000000ull; ns = (ns < 64ull) ? ns + 1ull : ns + (ns / 7ull))
+	{
+		auto index = CallbackProfiler::BucketIndex(ns);
+		ASSERT_LT(index, CallbackProfiler::NumBuckets);
+		ASSERT_GE(index, prevIndex);
+		ASSERT_GE(CallbackProfiler::BucketUpperNs(index), ns);
+
+		if (index > 0u)
+		{
+			ASSERT_LT(CallbackProfiler::BucketUpperNs(index - 1u), ns);
+		}
+
+		prevIndex = index;
+	}
+
+	ASSERT_EQ(CallbackProfiler::NumBuckets - 1u, CallbackProfiler::BucketIndex(~0ull));
+}
+
+TEST(CallbackProfiler, SinceGivesIntervalPercentiles)
+{
+	auto& profiler = CallbackProfiler::Instance();
+	auto before = profiler.TakeCapture();
+
+	for (auto us = 1u; us <= 100u; us++)
+		profiler.Record(CallbackProfiler::STAGE_LOOP, us * 1000ull);
+
+	auto interval = profiler.TakeCapture().Since(before);
+	const auto& loop = interval.Stages[CallbackProfiler::STAGE_LOOP];
+
+	ASSERT_EQ(100u, loop.Count);
+	ASSERT_EQ(5050000u, loop.TotalNs);
+	ASSERT_EQ(100000u, loop.MaxNs);
+
+	// Buckets are 12.5% wide
+	auto p50 = CallbackProfiler::Percentile(loop, 0.5);
+	auto p99 = CallbackProfiler::Percentile(loop, 0.99);
+	ASSERT_GE(p50, 50000u);
+	ASSERT_LE(p50, 56250u);
+	ASSERT_GE(p99, 99000u);
+	ASSERT_LE(p99, 100000u);
+
+	auto stats = CallbackProfiler::Summarise(interval);
+	ASSERT_EQ(CallbackProfiler::NUM_STAGES, stats.size());
+	ASSERT_EQ(100u, stats[CallbackProfiler::STAGE_LOOP].Count);
+	ASSERT_DOUBLE_EQ(50.5, stats[CallbackProfiler::STAGE_LOOP].MeanUs);
+}
+
+TEST(CallbackProfiler, SinceBoundsMaxToInterval)
+{
+	auto& profiler = CallbackProfiler::Instance();
+	profiler.Record(CallbackProfiler::STAGE_NINJAM, 900000u);
+
+	auto before = profiler.TakeCapture();
+	profiler.Record(CallbackProfiler::STAGE_NINJAM, 2000u);
+
+	auto interval = profiler.TakeCapture().Since(before);
+	const auto& ninjam = interval.Stages[CallbackProfiler::STAGE_NINJAM];
+
+	ASSERT_EQ(1u, ninjam.Count);
+	ASSERT_GE(ninjam.MaxNs, 2000u);
+	ASSERT_LT(ninjam.MaxNs, 2500u);
+}
+
+TEST(CallbackProfiler, BudgetIsShareOfBlockTime)
+{
+	auto& profiler = CallbackProfiler::Instance();
+	auto wasEnabled = profiler.IsEnabled();
+	profiler.SetEnabled(true);
+
+	auto before = profiler.TakeCapture();
+
+	// Ten 1ms blocks, each taking 250us
+	for (auto i = 0u; i < 10u; i++)
+	{
+		profiler.RecordBlock(48u, 48000u);
+		profiler.Record(CallbackProfiler::STAGE_TICK, 250000u);
+	}
+
+	profiler.SetEnabled(wasEnabled);
+
+	auto stats = CallbackProfiler::Summarise(profiler.TakeCapture().Since(before));
+	ASSERT_NEAR(25.0, stats[CallbackProfiler::STAGE_TICK].BudgetPercent, 0.001);
+}
+
+TEST(CallbackProfiler, ScopeOnlyRecordsWhenEnabled)
+{
+	auto& profiler = CallbackProfiler::Instance();
+	auto wasEnabled = profiler.IsEnabled();
+
+	profiler.SetEnabled(false);
+	auto before = profiler.TakeCapture();
+	{
+		ProfileScope scope(CallbackProfiler::STAGE_VST);
+	}
+	ASSERT_EQ(0u, profiler.TakeCapture().Since(before).Stages[CallbackProfiler::STAGE_VST].Count);
+
+	profiler.SetEnabled(true);
+	{
+		ProfileScope scope(CallbackProfiler::STAGE_VST);
+	}
+	profiler.SetEnabled(wasEnabled);
+
+	ASSERT_EQ(1u, profiler.TakeCapture().Since(before).Stages[CallbackProfiler::STAGE_VST].Count);
+}
+
+TEST(CallbackProfiler, CountersOnlyCountWhenEnabled)
+{
+	auto& profiler = CallbackProfiler::Instance();
+	auto wasEnabled = profiler.IsEnabled();
+	const auto counter = CallbackProfiler::COUNTER_SILENT_LOOP_BLOCKS;
+
+	profiler.SetEnabled(false);
+	auto before = profiler.TakeCapture();
+	profiler.Count(counter);
+	ASSERT_EQ(0u, profiler.TakeCapture().Since(before).Counters[counter]);
+
+	profiler.SetEnabled(true);
+	profiler.Count(counter);
+	profiler.Count(counter);
+	profiler.SetEnabled(wasEnabled);
+
+	ASSERT_EQ(2u, profiler.TakeCapture().Since(before).Counters[counter]);
+	ASSERT_STREQ("silent loop blocks skipped", CallbackProfiler::CounterName(counter));
+}
+
+TEST(CallbackProfiler, ThreadsKeepTheirCountsAfterExit)
+{
+	const unsigned int numThreads = 4u;
+	const unsigned int numRecords = 10000u;
+
+	auto& profiler = CallbackProfiler::Instance();
+	auto before = profiler.TakeCapture();
+
+	for (auto round = 0u; round < 2u; round++)
+	{
+		std::vector<std::thread> threads;
+		for (auto t = 0u; t < numThreads; t++)
+		{
+			threads.emplace_back([&profiler, numRecords]() {
+				for (auto i = 0u; i < numRecords; i++)
+					profiler.Record(CallbackProfiler::STAGE_STATION, 1000u + i);
+			});
+		}
+
+		for (auto& thread : threads)
+			thread.join();
+	}
+
+	auto interval = profiler.TakeCapture().Since(before);
+	ASSERT_EQ(2u * numThreads * numRecords, interval.Stages[CallbackProfiler::STAGE_STATION].Count);
+	ASSERT_EQ(0u, profiler.NumDropped());
+}
+
+TEST(CallbackProfiler, CsvWritesRowPerStage)
+{
+	auto path = (std::filesystem::temp_directory_path() / "jamma_profile_test.csv").string();
+	auto& profiler = CallbackProfiler::Instance();
+
+	ASSERT_TRUE(profiler.StartCsv(path, 100u));
+	profiler.Record(CallbackProfiler::STAGE_TAKE, 3000u);
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(120));
+	profiler.PumpCsv();
+	profiler.StopCsv();
+	ASSERT_FALSE(profiler.IsWritingCsv());
+
+	std::ifstream csv(path);
+	std::vector<std::string> lines;
+	std::string line;
+	while (std::getline(csv, line))
+		lines.push_back(line);
+	csv.close();
+	std::filesystem::remove(path);
+
+	ASSERT_EQ(1u + CallbackProfiler::NUM_STAGES + CallbackProfiler::NUM_COUNTERS, lines.size());
+	ASSERT_EQ(0u, lines[0].find("time_s,stage,count"));
+	ASSERT_NE(std::string::npos, lines[1 + CallbackProfiler::STAGE_TAKE].find(",take,1,"));
+}
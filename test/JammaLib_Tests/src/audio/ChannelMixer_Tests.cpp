@@ -263,3 +263,52 @@ TEST(ChannelMixer, ShrinkRemovesChannelsAndExpandRestoresThem)
 
     EXPECT_EQ(std::vector<float>({ 100.0f, 200.0f, 300.0f, 400.0f }), sink->Samples(2u));
 }
+
+TEST(ChannelMixer, MixBusAccumulatesBusesIntoDac)
+{
+    const unsigned int numChans = 2u;
+    const unsigned int blockSize = 32u;
+
+    ChannelMixerParams chanParams;
+    chanParams.InputBufferSize = constants::MaxBlockSize;
+    chanParams.OutputBufferSize = constants::MaxBlockSize;
+    chanParams.NumInputChannels = numChans;
+    chanParams.NumOutputChannels = numChans;
+    ChannelMixer chanMixer(chanParams);
+
+    auto busA = chanMixer.CreateBus();
+    auto busB = chanMixer.CreateBus();
+    EXPECT_EQ(numChans, busA->NumInputChannels(base::Audible::AUDIOSOURCE_MIXER));
+
+    std::vector<float> samples(blockSize);
+    for (auto samp = 0u; samp < blockSize; samp++)
+        samples[samp] = static_cast<float>(samp + 1u) * 0.01f;
+
+    AudioWriteRequest request;
+    request.samples = samples.data();
+    request.numSamps = blockSize;
+    request.stride = 1;
+    request.fadeCurrent = 1.0f;
+    request.fadeNew = 1.0f;
+    request.source = base::Audible::AUDIOSOURCE_MIXER;
+
+    busA->Zero(blockSize, base::Audible::AUDIOSOURCE_MIXER);
+    busA->OnBlockWriteChannel(0u, request, 0);
+    busA->OnBlockWriteChannel(1u, request, 0);
+
+    busB->Zero(blockSize, base::Audible::AUDIOSOURCE_MIXER);
+    busB->OnBlockWriteChannel(0u, request, 0);
+
+    chanMixer.Sink()->Zero(blockSize, base::Audible::AUDIOSOURCE_MIXER);
+    chanMixer.MixBus(*busA, blockSize);
+    chanMixer.MixBus(*busB, blockSize);
+
+    std::vector<float> outBuf(numChans * blockSize, 0.0f);
+    chanMixer.ToDac(outBuf.data(), numChans, blockSize);
+
+    for (auto samp = 0u; samp < blockSize; samp++)
+    {
+        ASSERT_FLOAT_EQ(2.0f * samples[samp], outBuf[samp * numChans]);
+        ASSERT_FLOAT_EQ(samples[samp], outBuf[samp * numChans + 1u]);
+    }
+}
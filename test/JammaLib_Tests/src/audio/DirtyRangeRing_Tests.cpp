@@ -0,0 +1,38 @@
+#include "gtest/gtest.h"
+#include "audio/DirtyRangeRing.h"
+
+using audio::DirtyRangeRing;
+
+TEST(DirtyRangeRing, PopsRangesInOrder)
+{
+	DirtyRangeRing<8> ring;
+	ASSERT_TRUE(ring.Push(0ul, 256ul));
+	ASSERT_TRUE(ring.Push(256ul, 128ul));
+
+	DirtyRangeRing<8>::Range range;
+	ASSERT_TRUE(ring.Pop(range));
+	EXPECT_EQ(0ul, range.Start);
+	EXPECT_EQ(256ul, range.NumSamps);
+	ASSERT_TRUE(ring.Pop(range));
+	EXPECT_EQ(256ul, range.Start);
+	EXPECT_EQ(128ul, range.NumSamps);
+	EXPECT_FALSE(ring.Pop(range));
+	EXPECT_FALSE(ring.TakeOverflow());
+}
+
+TEST(DirtyRangeRing, FlagsOverflowOnce)
+{
+	DirtyRangeRing<4> ring;
+
+	// One slot always stays empty
+	for (auto i = 0ul; i < 3ul; i++)
+		ASSERT_TRUE(ring.Push(i * 64ul, 64ul));
+
+	EXPECT_FALSE(ring.Push(192ul, 64ul));
+	EXPECT_TRUE(ring.TakeOverflow());
+	EXPECT_FALSE(ring.TakeOverflow());
+
+	DirtyRangeRing<4>::Range range;
+	ASSERT_TRUE(ring.Pop(range));
+	EXPECT_TRUE(ring.Push(192ul, 64ul));
+}
@@ -0,0 +1,217 @@
+#include "gtest/gtest.h"
+#include "audio/FadeKernels.h"
+#include "audio/BufferBank.h"
+#include <cstring>
+#include <vector>
+
+using audio::FadeKernels;
+using audio::BufferBank;
+
+namespace {
+
+// Plain per-sample reference, written out independently of the kernels.
+void ReferenceFadeMix(float* dest, const float* src, unsigned int srcStride,
+	unsigned int numSamps, float fadeCurrent, float fadeNew)
+{
+	for (auto i = 0u; i < numSamps; i++)
+		dest[i] = (fadeNew * src[i * srcStride]) + (fadeCurrent * dest[i]);
+}
+
+void ReferenceFadeMixRamp(float* dest, const float* src, unsigned int srcStride,
+	unsigned int numSamps, float fadeCurrent, float fadeNew, const float* ramp, float fadeCurrentRamp)
+{
+	for (auto i = 0u; i < numSamps; i++)
+		dest[i] = ((fadeNew * ramp[i]) * src[i * srcStride]) + ((fadeCurrent + (fadeCurrentRamp * ramp[i])) * dest[i]);
+}
+
+float TestSample(unsigned int index, unsigned int multiplier)
+{
+	const auto wrapped = static_cast<int>(((index + 1u) * multiplier) % 2000u);
+	return static_cast<float>(wrapped - 1000) / 1001.0f;
+}
+
+bool BitEqual(const std::vector<float>& a, const std::vector<float>& b)
+{
+	return (a.size() == b.size()) &&
+		(0 == std::memcmp(a.data(), b.data(), a.size() * sizeof(float)));
+}
+
+std::vector<FadeKernels::SimdLevel> SupportedLevels()
+{
+	std::vector<FadeKernels::SimdLevel> levels;
+	for (auto level : { FadeKernels::SIMD_SCALAR, FadeKernels::SIMD_SSE2, FadeKernels::SIMD_AVX2, FadeKernels::SIMD_AVX512 })
+	{
+		if (nullptr != FadeKernels::Kernel(level))
+			levels.push_back(level);
+	}
+
+	return levels;
+}
+
+}
+
+TEST(FadeKernels, ActiveLevelIsSupported)
+{
+	ASSERT_LE(FadeKernels::ActiveLevel(), FadeKernels::SupportedLevel());
+	ASSERT_NE(nullptr, FadeKernels::Kernel(FadeKernels::ActiveLevel()));
+	ASSERT_NE(nullptr, FadeKernels::Kernel(FadeKernels::SIMD_SCALAR));
+}
+
+TEST(FadeKernels, MatchesScalarReferenceBitForBit)
+{
+	const std::vector<std::pair<float, float>> fades = {
+		{ 0.0f, 1.0f },
+		{ 1.0f, 1.0f },
+		{ 1.0f, 0.0f },
+		{ 0.3f, 0.7f },
+		{ 0.999f, 0.12345f },
+		{ 1.0f, -0.61f }
+	};
+
+	for (auto level : SupportedLevels())
+	{
+		auto kernel = FadeKernels::Kernel(level);
+
+		for (auto stride : { 1u, 2u, 3u, 8u })
+		{
+			for (auto numSamps = 0u; numSamps < 70u; numSamps++)
+			{
+				// Offset by one so the vector paths see unaligned pointers
+				for (auto offset : { 0u, 1u })
+				{
+					for (auto& fade : fades)
+					{
+						std::vector<float> src((numSamps + offset) * stride + 1u);
+						for (auto i = 0u; i < src.size(); i++)
+							src[i] = TestSample(i, 7u);
+
+						std::vector<float> expected(numSamps + offset);
+						for (auto i = 0u; i < expected.size(); i++)
+							expected[i] = TestSample(i, 13u);
+						auto actual = expected;
+
+						ReferenceFadeMix(expected.data() + offset, src.data() + offset, stride, numSamps, fade.first, fade.second);
+						kernel(actual.data() + offset, src.data() + offset, stride, numSamps, fade.first, fade.second);
+
+						ASSERT_TRUE(BitEqual(expected, actual))
+							<< FadeKernels::LevelName(level) << " stride " << stride << " numSamps " << numSamps;
+					}
+				}
+			}
+		}
+	}
+}
+
+TEST(FadeKernels, RampMatchesScalarReferenceBitForBit)
+{
+	for (auto level : SupportedLevels())
+	{
+		auto kernel = FadeKernels::RampKernel(level);
+		ASSERT_NE(nullptr, kernel);
+
+		for (auto stride : { 1u, 2u, 3u })
+		{
+			for (auto numSamps = 0u; numSamps < 70u; numSamps++)
+			{
+				for (auto fadeCurrentRamp : { 0.0f, -1.0f })
+				{
+					std::vector<float> src(numSamps * stride + 1u);
+					for (auto i = 0u; i < src.size(); i++)
+						src[i] = TestSample(i, 7u);
+
+					std::vector<float> ramp(numSamps + 1u);
+					for (auto i = 0u; i < ramp.size(); i++)
+						ramp[i] = 1.0f - (static_cast<float>(i) / 71.0f);
+
+					std::vector<float> expected(numSamps + 1u);
+					for (auto i = 0u; i < expected.size(); i++)
+						expected[i] = TestSample(i, 13u);
+					auto actual = expected;
+
+					// Offset by one so the vector paths see unaligned pointers
+					ReferenceFadeMixRamp(expected.data() + 1, src.data() + 1, stride, numSamps, 1.0f, 0.8f, ramp.data() + 1, fadeCurrentRamp);
+					kernel(actual.data() + 1, src.data() + 1, stride, numSamps, 1.0f, 0.8f, ramp.data() + 1, fadeCurrentRamp);
+
+					ASSERT_TRUE(BitEqual(expected, actual))
+						<< FadeKernels::LevelName(level) << " stride " << stride << " numSamps " << numSamps;
+				}
+			}
+		}
+	}
+}
+
+TEST(FadeKernels, DispatchedMatchesScalarOnMaxBlock)
+{
+	const auto numSamps = constants::MaxBlockSize;
+
+	std::vector<float> src(numSamps * 2u);
+	for (auto i = 0u; i < src.size(); i++)
+		src[i] = TestSample(i, 11u);
+
+	std::vector<float> expected(numSamps);
+	for (auto i = 0u; i < numSamps; i++)
+		expected[i] = TestSample(i, 3u);
+	auto actual = expected;
+
+	ReferenceFadeMix(expected.data(), src.data(), 2u, numSamps, 0.25f, 0.875f);
+	FadeKernels::FadeMix(actual.data(), src.data(), 2u, numSamps, 0.25f, 0.875f);
+
+	ASSERT_TRUE(BitEqual(expected, actual));
+}
+
+TEST(FadeKernels, BufferBankBlockSpansBanks)
+{
+	BufferBank bank;
+	bank.Resize(bank.BankSize() + 100ul);
+
+	const auto numSamps = 200u;
+	const auto startIndex = bank.BankSize() - 64ul;
+
+	std::vector<float> src(numSamps);
+	for (auto i = 0u; i < numSamps; i++)
+		src[i] = TestSample(i, 7u);
+
+	for (auto i = 0u; i < numSamps; i++)
+		bank[startIndex + i] = TestSample(i, 5u);
+
+	bank.FadeMixBlock(startIndex, src.data(), 1u, numSamps, 0.5f, 0.75f);
+
+	for (auto i = 0u; i < numSamps; i++)
+	{
+		auto expected = (0.75f * src[i]) + (0.5f * TestSample(i, 5u));
+		ASSERT_EQ(expected, bank[startIndex + i]);
+	}
+}
+
+TEST(FadeKernels, BufferBankRampSpansBanks)
+{
+	BufferBank bank;
+	bank.Resize(bank.BankSize() + 100ul);
+
+	const auto numSamps = 100u;
+	const auto startIndex = bank.BankSize() - 30ul;
+
+	std::vector<float> src(numSamps, 1.0f);
+	std::vector<float> ramp(numSamps);
+	for (auto i = 0u; i < numSamps; i++)
+		ramp[i] = static_cast<float>(i) / 100.0f;
+
+	bank.FadeMixBlock(startIndex, src.data(), 1u, numSamps, 0.0f, 1.0f, ramp.data(), 0.0f);
+
+	for (auto i = 0u; i < numSamps; i++)
+		ASSERT_EQ(ramp[i], bank[startIndex + i]);
+}
+
+TEST(FadeKernels, BufferBankBlockDropsBeyondCapacity)
+{
+	BufferBank bank;
+	const auto capacity = bank.Capacity();
+
+	std::vector<float> src(32u, 1.0f);
+	bank.FadeMixBlock(capacity - 16ul, src.data(), 1u, 32u, 0.0f, 1.0f);
+
+	for (auto i = 0ul; i < 16ul; i++)
+		ASSERT_EQ(1.0f, bank[capacity - 16ul + i]);
+
+	ASSERT_EQ(capacity, bank.Capacity());
+}
@@ -0,0 +1,131 @@
+#include "gtest/gtest.h"
+#include "audio/InterleaveKernels.h"
+#include <cstring>
+#include <vector>
+
+using audio::FadeKernels;
+using audio::InterleaveKernels;
+
+namespace {
+
+float TestSample(unsigned int index, unsigned int multiplier)
+{
+	const auto wrapped = static_cast<int>(((index + 1u) * multiplier) % 2000u);
+	return static_cast<float>(wrapped - 1000) / 1001.0f;
+}
+
+bool BitEqual(const std::vector<float>& a, const std::vector<float>& b)
+{
+	return (a.size() == b.size()) &&
+		(0 == std::memcmp(a.data(), b.data(), a.size() * sizeof(float)));
+}
+
+std::vector<FadeKernels::SimdLevel> SupportedLevels()
+{
+	std::vector<FadeKernels::SimdLevel> levels;
+	for (auto level : { FadeKernels::SIMD_SCALAR, FadeKernels::SIMD_SSE2, FadeKernels::SIMD_AVX2, FadeKernels::SIMD_AVX512 })
+	{
+		if (nullptr != InterleaveKernels::DeinterleaveKernel(level))
+			levels.push_back(level);
+	}
+
+	return levels;
+}
+
+// Planar channels laid out back to back, each padded by one so the
+// vector paths see unaligned pointers
+class Planar
+{
+public:
+	Planar(unsigned int numChans, unsigned int numSamps, float fill) :
+		Samples((numChans * (numSamps + 1u)) + 1u, fill),
+		Ptrs(numChans)
+	{
+		for (auto c = 0u; c < numChans; c++)
+			Ptrs[c] = Samples.data() + 1u + (c * (numSamps + 1u));
+	}
+
+	std::vector<float> Samples;
+	std::vector<float*> Ptrs;
+};
+
+}
+
+TEST(InterleaveKernels, ScalarAlwaysSupported)
+{
+	ASSERT_NE(nullptr, InterleaveKernels::DeinterleaveKernel(FadeKernels::SIMD_SCALAR));
+	ASSERT_NE(nullptr, InterleaveKernels::InterleaveKernel(FadeKernels::SIMD_SCALAR));
+	ASSERT_NE(nullptr, InterleaveKernels::DeinterleaveKernel(FadeKernels::SupportedLevel()));
+	ASSERT_NE(nullptr, InterleaveKernels::InterleaveKernel(FadeKernels::SupportedLevel()));
+}
+
+TEST(InterleaveKernels, DeinterleaveMatchesReferenceBitForBit)
+{
+	for (auto level : SupportedLevels())
+	{
+		auto kernel = InterleaveKernels::DeinterleaveKernel(level);
+
+		for (auto numChans : { 1u, 2u, 3u, 4u, 7u, 8u, 9u, 12u, 17u, 32u })
+		{
+			for (auto stride : { numChans, numChans + 3u })
+			{
+				for (auto numSamps : { 0u, 1u, 3u, 4u, 7u, 8u, 63u, 64u, 65u, 130u })
+				{
+					std::vector<float> src(stride * numSamps);
+					for (auto i = 0u; i < src.size(); i++)
+						src[i] = TestSample(i, 37u);
+
+					Planar expected(numChans, numSamps, -2.0f);
+					for (auto i = 0u; i < numSamps; i++)
+					{
+						for (auto c = 0u; c < numChans; c++)
+							expected.Ptrs[c][i] = src[(i * stride) + c];
+					}
+
+					Planar actual(numChans, numSamps, -2.0f);
+					kernel(actual.Ptrs.data(), src.data(), numChans, stride, numSamps);
+
+					ASSERT_TRUE(BitEqual(expected.Samples, actual.Samples))
+						<< "level " << FadeKernels::LevelName(level)
+						<< " chans " << numChans << " stride " << stride << " samps " << numSamps;
+				}
+			}
+		}
+	}
+}
+
+TEST(InterleaveKernels, InterleaveMatchesReferenceBitForBit)
+{
+	for (auto level : SupportedLevels())
+	{
+		auto kernel = InterleaveKernels::InterleaveKernel(level);
+
+		for (auto numChans : { 1u, 2u, 3u, 4u, 7u, 8u, 9u, 12u, 17u, 32u })
+		{
+			for (auto stride : { numChans, numChans + 3u })
+			{
+				for (auto numSamps : { 0u, 1u, 3u, 4u, 7u, 8u, 63u, 64u, 65u, 130u })
+				{
+					Planar src(numChans, numSamps, 0.0f);
+					for (auto i = 0u; i < src.Samples.size(); i++)
+						src.Samples[i] = TestSample(i, 53u);
+
+					// Unwritten interleaved channels must be left alone
+					std::vector<float> expected(stride * numSamps, -2.0f);
+					for (auto i = 0u; i < numSamps; i++)
+					{
+						for (auto c = 0u; c < numChans; c++)
+							expected[(i * stride) + c] = src.Ptrs[c][i];
+					}
+
+					std::vector<float> actual(stride * numSamps, -2.0f);
+					kernel(actual.data(), src.Ptrs.data(), numChans, stride, numSamps);
+
+					ASSERT_TRUE(BitEqual(expected, actual))
+						<< "level " << FadeKernels::LevelName(level)
+						<< " chans " << numChans << " stride " << stride << " samps " << numSamps;
+				}
+			}
+		}
+	}
+}
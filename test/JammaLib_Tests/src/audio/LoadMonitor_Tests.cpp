@@ -0,0 +1,184 @@
+#include "gtest/gtest.h"
+#include "audio/LoadMonitor.h"
+#include "../include/Constants.h"
+#include <string>
+
+using audio::LoadMonitor;
+
+namespace {
+
+const unsigned int BlockSize = 480u;
+const unsigned int SampleRate = 48000u;
+// 10 ms per block
+const std::uint64_t PeriodNs = 10000000u;
+
+void RecordBlocks(LoadMonitor& monitor, unsigned int numBlocks, unsigned int loadPercent)
+{
+	for (auto i = 0u; i < numBlocks; i++)
+		monitor.RecordBlock((PeriodNs * loadPercent) / 100u, BlockSize, SampleRate, false, false);
+}
+
+// Leaves the shared monitor as the engine expects to find it
+class ScopedMonitor
+{
+public:
+	ScopedMonitor(unsigned int shedBlocks, const std::vector<LoadMonitor::ShedStep>& policy) :
+		Monitor(LoadMonitor::Instance())
+	{
+		Monitor.Configure(80u, 50u, shedBlocks, policy);
+		Monitor.Reset();
+	}
+
+	~ScopedMonitor()
+	{
+		Monitor.Configure(constants::DefaultShedLoadPercent,
+			constants::DefaultRecoverLoadPercent,
+			constants::DefaultShedBlocks,
+			LoadMonitor::DefaultPolicy());
+		Monitor.Reset();
+	}
+
+	LoadMonitor& Monitor;
+};
+
+}
+
+TEST(LoadMonitor, SustainedOverloadShedsInPolicyOrder)
+{
+	ScopedMonitor scoped(4u, { LoadMonitor::SHED_VU, LoadMonitor::SHED_VISUALS });
+	auto& monitor = scoped.Monitor;
+
+	RecordBlocks(monitor, 3u, 95u);
+	ASSERT_EQ(0u, monitor.GetStatus().ShedLevel);
+
+	RecordBlocks(monitor, 1u, 95u);
+	ASSERT_TRUE(monitor.IsShedding(LoadMonitor::SHED_VU));
+	ASSERT_FALSE(monitor.IsShedding(LoadMonitor::SHED_VISUALS));
+
+	RecordBlocks(monitor, 4u, 95u);
+	ASSERT_TRUE(monitor.IsShedding(LoadMonitor::SHED_VISUALS));
+	ASSERT_FALSE(monitor.IsShedding(LoadMonitor::SHED_QUIETVST));
+
+	// Nothing left in the policy to shed
+	RecordBlocks(monitor, 8u, 95u);
+	ASSERT_EQ(2u, monitor.GetStatus().ShedLevel);
+}
+
+TEST(LoadMonitor, BriefSpikesDoNotShed)
+{
+	ScopedMonitor scoped(4u, LoadMonitor::DefaultPolicy());
+	auto& monitor = scoped.Monitor;
+
+	for (auto i = 0u; i < 10u; i++)
+	{
+		RecordBlocks(monitor, 3u, 95u);
+		RecordBlocks(monitor, 1u, 30u);
+	}
+
+	ASSERT_EQ(0u, monitor.GetStatus().ShedLevel);
+	ASSERT_EQ(40u, monitor.GetStatus().NumBlocks);
+}
+
+TEST(LoadMonitor, RecoversOneStepAtATime)
+{
+	ScopedMonitor scoped(2u, LoadMonitor::DefaultPolicy());
+	auto& monitor = scoped.Monitor;
+
+	RecordBlocks(monitor, 4u, 95u);
+	ASSERT_EQ(2u, monitor.GetStatus().ShedLevel);
+
+	// Load between the thresholds holds the current level
+	RecordBlocks(monitor, 100u, 60u);
+	ASSERT_EQ(2u, monitor.GetStatus().ShedLevel);
+
+	RecordBlocks(monitor, 2u * LoadMonitor::RecoverScale, 20u);
+	ASSERT_EQ(1u, monitor.GetStatus().ShedLevel);
+	ASSERT_TRUE(monitor.IsShedding(LoadMonitor::SHED_VISUALS));
+	ASSERT_FALSE(monitor.IsShedding(LoadMonitor::SHED_VU));
+
+	RecordBlocks(monitor, 2u * LoadMonitor::RecoverScale, 20u);
+	ASSERT_EQ(0u, monitor.GetStatus().ShedLevel);
+	ASSERT_FALSE(monitor.IsShedding(LoadMonitor::SHED_VISUALS));
+}
+
+TEST(LoadMonitor, XrunsCountAsOverload)
+{
+	ScopedMonitor scoped(2u, LoadMonitor::DefaultPolicy());
+	auto& monitor = scoped.Monitor;
+
+	monitor.RecordBlock(PeriodNs / 10u, BlockSize, SampleRate, true, false);
+	monitor.RecordBlock(PeriodNs / 10u, BlockSize, SampleRate, false, true);
+
+	auto status = monitor.GetStatus();
+	ASSERT_EQ(1u, status.NumInputOverflows);
+	ASSERT_EQ(1u, status.NumOutputUnderflows);
+	ASSERT_EQ(0u, status.NumLateBlocks);
+	ASSERT_EQ(1u, status.ShedLevel);
+}
+
+TEST(LoadMonitor, ZeroThresholdOnlyMeasures)
+{
+	ScopedMonitor scoped(1u, LoadMonitor::DefaultPolicy());
+	auto& monitor = scoped.Monitor;
+	monitor.Configure(0u, 0u, 1u, LoadMonitor::DefaultPolicy());
+
+	RecordBlocks(monitor, 10u, 150u);
+
+	auto status = monitor.GetStatus();
+	ASSERT_EQ(0u, status.ShedLevel);
+	ASSERT_EQ(10u, status.NumLateBlocks);
+	ASSERT_NEAR(150.0f, status.PeakLoadPercent, 0.01f);
+}
+
+TEST(LoadMonitor, PollReportsShedChanges)
+{
+	ScopedMonitor scoped(1u, LoadMonitor::DefaultPolicy());
+	auto& monitor = scoped.Monitor;
+	monitor.PollChange(true);
+
+	ASSERT_FALSE(monitor.PollChange(true).has_value());
+
+	RecordBlocks(monitor, 1u, 95u);
+	auto change = monitor.PollChange(false);
+	ASSERT_TRUE(change.has_value());
+	ASSERT_EQ(1u, change.value().ShedLevel);
+	ASSERT_FALSE(monitor.PollChange(false).has_value());
+
+	// Xruns alone are only reported when asked for
+	monitor.Configure(0u, 0u, 1u, LoadMonitor::DefaultPolicy());
+	monitor.PollChange(true);
+
+	monitor.RecordBlock(PeriodNs / 10u, BlockSize, SampleRate, false, true);
+	ASSERT_FALSE(monitor.PollChange(false).has_value());
+
+	monitor.RecordBlock(PeriodNs / 10u, BlockSize, SampleRate, false, true);
+	ASSERT_TRUE(monitor.PollChange(true).has_value());
+	ASSERT_FALSE(monitor.PollChange(true).has_value());
+}
+
+TEST(LoadMonitor, ParsesPolicy)
+{
+	auto policy = LoadMonitor::ParsePolicy("vst, visuals");
+	ASSERT_TRUE(policy.has_value());
+	ASSERT_EQ(2u, policy.value().size());
+	ASSERT_EQ(LoadMonitor::SHED_QUIETVST, policy.value()[0]);
+	ASSERT_EQ(LoadMonitor::SHED_VISUALS, policy.value()[1]);
+
+	ASSERT_TRUE(LoadMonitor::ParsePolicy("").value().empty());
+	ASSERT_FALSE(LoadMonitor::ParsePolicy("vu,reverb").has_value());
+}
+
+TEST(LoadMonitor, FormatsStatus)
+{
+	LoadMonitor::Status status;
+	status.NumBlocks = 200u;
+	status.NumLateBlocks = 3u;
+	status.NumInputOverflows = 1u;
+	status.NumOutputUnderflows = 2u;
+	status.LoadPercent = 42.0f;
+	status.PeakLoadPercent = 97.0f;
+	status.ShedFlags = LoadMonitor::SHED_VISUALS | LoadMonitor::SHED_VU;
+
+	ASSERT_EQ("load 42% (peak 97%), late 3/200, xruns in 1 out 2, shedding visuals+vu",
+		LoadMonitor::FormatStatus(status));
+}
@@ -2,6 +2,10 @@
 #include "gtest/gtest.h"
 #include "resources/ResourceLib.h"
 #include "engine/Loop.h"
+#include "audio/BankPool.h"
+#include "actions/JobAction.h"
+#include "utils/Epoch.h"
+#include <cmath>
 
 using resources::ResourceLib;
 using engine::Loop;
@@ -13,6 +17,8 @@ using base::AudioSink;
 using base::MultiAudioSink;
 using base::AudioSourceParams;
 using base::AudioWriteRequest;
+using audio::BankPool;
+using actions::JobAction;
 
 class LoopMockedSink :
 public AudioSink
@@ -125,6 +131,11 @@ public:
     {
         return _playIndex;
     }
+
+    float Sample(unsigned long index) const
+    {
+        return _bufferBank[index];
+    }
 };
 
 // -- Helpers ----------------------------------------------------------------
@@ -715,6 +726,100 @@ TEST(Loop, PunchOutAfterPlayKeepsPlaybackWhileStoppingAdcCapture)
 	ASSERT_EQ(before, after);
 }
 
+TEST(Loop, PlayAtBlockOffsetIsIndependentOfBlockSize)
+{
+	const auto loopLength = 4096ul;
+	const auto blockOffset = 100u;
+	const auto totalSamps = 1024u;
+	const auto totalRecordSamps = constants::MaxLoopFadeSamps + loopLength;
+
+	std::vector<float> recordData(totalRecordSamps);
+	for (auto i = 0u; i < totalRecordSamps; i++)
+		recordData[i] = 0.01f + 0.0001f * static_cast<float>(i % 1000u);
+
+	auto render = [&](unsigned int blockSize) {
+		auto loop = MakeLoop();
+		loop.Record();
+
+		AudioWriteRequest writeReq;
+		writeReq.samples = recordData.data();
+		writeReq.numSamps = static_cast<unsigned int>(totalRecordSamps);
+		writeReq.stride = 1;
+		writeReq.fadeCurrent = 0.0f;
+		writeReq.fadeNew = 1.0f;
+		writeReq.source = base::Audible::AUDIOSOURCE_ADC;
+		loop.OnBlockWrite(writeReq, 0);
+		loop.EndWrite(static_cast<unsigned int>(totalRecordSamps), true);
+		loop.Play(constants::MaxLoopFadeSamps, loopLength, false, blockOffset);
+
+		std::vector<float> out;
+		float tempBuf[constants::MaxBlockSize]{};
+
+		for (auto done = 0u; done < totalSamps; done += blockSize)
+		{
+			auto sampsRead = loop.ReadBlock(tempBuf, 0, blockSize);
+			EXPECT_EQ(blockSize, sampsRead);
+			out.insert(out.end(), tempBuf, tempBuf + blockSize);
+			loop.EndMultiPlay(blockSize);
+		}
+
+		return out;
+	};
+
+	auto out64 = render(64u);
+	auto out256 = render(256u);
+
+	ASSERT_EQ(out64, out256);
+
+	for (auto i = 0u; i < blockOffset; i++)
+		ASSERT_EQ(0.0f, out64[i]) << "sample " << i;
+
+	for (auto i = blockOffset; i < totalSamps; i++)
+		ASSERT_FLOAT_EQ(recordData[constants::MaxLoopFadeSamps + i - blockOffset], out64[i]) << "sample " << i;
+}
+
+TEST(Loop, PunchAtBlockOffsetSplitsAdcCapture)
+{
+	const auto blockSize = 32u;
+	const auto punchInOffset = 10u;
+	const auto punchOutOffset = 6u;
+
+	auto loop = MakeLoopProbe();
+	loop.Overdub();
+
+	auto writeAdcBlock = [&](float value) {
+		std::vector<float> data(blockSize, value);
+		AudioWriteRequest request;
+		request.samples = data.data();
+		request.numSamps = blockSize;
+		request.stride = 1;
+		request.fadeCurrent = 0.0f;
+		request.fadeNew = 1.0f;
+		request.source = base::Audible::AUDIOSOURCE_ADC;
+		loop.OnBlockWrite(request, 0);
+		loop.EndWrite(blockSize, true);
+		loop.EndMultiPlay(blockSize);
+	};
+
+	loop.PunchIn(punchInOffset);
+	ASSERT_EQ(Loop::STATE_PUNCHEDIN, loop.PlayState());
+	writeAdcBlock(0.5f);
+
+	for (auto i = 0u; i < punchInOffset; i++)
+		ASSERT_EQ(0.0f, loop.Sample(i)) << "sample " << i;
+	for (auto i = punchInOffset; i < blockSize; i++)
+		ASSERT_EQ(0.5f, loop.Sample(i)) << "sample " << i;
+
+	loop.PunchOut(punchOutOffset);
+	ASSERT_EQ(Loop::STATE_OVERDUBBING, loop.PlayState());
+	writeAdcBlock(0.25f);
+
+	for (auto i = 0u; i < punchOutOffset; i++)
+		ASSERT_EQ(0.25f, loop.Sample(blockSize + i)) << "sample " << (blockSize + i);
+	for (auto i = punchOutOffset; i < blockSize; i++)
+		ASSERT_EQ(0.0f, loop.Sample(blockSize + i)) << "sample " << (blockSize + i);
+}
+
 // Regression: when loopLength is quantised upward so that logicalBufSize >
 // physBufSize, Play() must clamp _playIndex to physBufSize-1 rather than
 // logicalBufSize-1 so that subsequent ReadBlock calls never seek into
@@ -880,3 +985,216 @@ TEST(Loop, TwoLoopsWithSameContentProduceSameSamples)
     for (auto s = 0u; s < blockSize; s++)
         EXPECT_FLOAT_EQ(samplesL[s], samplesR[s]) << "sample " << s;
 }
+
+// -- Silence skipping tests --------------------------------------------------
+
+TEST(Loop, SilentBlocksAreSkipped)
+{
+    const auto loopLength = 4096ul;
+    const auto blockSize = 256u;
+    const auto totalRecordSamps = constants::MaxLoopFadeSamps + loopLength;
+
+    // A single burst in an otherwise silent loop
+    std::vector<float> seedData(totalRecordSamps, 0.0f);
+    for (auto i = 1024u; i < 1100u; i++)
+        seedData[constants::MaxLoopFadeSamps + i] = 0.5f;
+
+    auto loop = MakeLoop();
+    loop.Record();
+    AudioWriteRequest writeReq;
+    writeReq.samples = seedData.data();
+    writeReq.numSamps = static_cast<unsigned int>(totalRecordSamps);
+    writeReq.stride = 1;
+    writeReq.fadeCurrent = 0.0f;
+    writeReq.fadeNew = 1.0f;
+    writeReq.source = base::Audible::AUDIOSOURCE_ADC;
+    loop.OnBlockWrite(writeReq, 0);
+    loop.EndWrite(static_cast<unsigned int>(totalRecordSamps), true);
+    loop.Play(constants::MaxLoopFadeSamps, loopLength, false);
+
+    auto sink = std::make_shared<MockMultiSink>(blockSize);
+    auto numSilent = 0u;
+
+    for (auto block = 0u; block < (2u * loopLength) / blockSize; block++)
+    {
+        auto isSilent = loop.IsSilentBlock(0, blockSize);
+        PlayOneBlock(loop, sink, blockSize);
+
+        if (isSilent)
+        {
+            numSilent++;
+            ASSERT_FALSE(HasNonZeroSample(sink->GetSamples())) << "block " << block;
+        }
+    }
+
+    // Everything but the burst's grain (and its neighbour) can be skipped
+    ASSERT_GT(numSilent, 0u);
+    ASSERT_LT(numSilent, (2u * loopLength) / blockSize);
+}
+
+TEST(Loop, LoudLoopIsNeverSilent)
+{
+    auto loop = MakeLoop();
+    RecordAndPlay(loop, 1000ul, false, 0.5f);
+
+    ASSERT_FALSE(loop.IsSilentBlock(0, 256u));
+    ASSERT_FALSE(loop.IsSilentBlock(0, 5000u));
+}
+
+// -- Idle compaction tests ---------------------------------------------------
+
+TEST(Loop, IdleLoopIsPackedAndStillPlays)
+{
+    const auto loopLength = 4096ul;
+    const auto blockSize = 256u;
+    const auto totalRecordSamps = constants::MaxLoopFadeSamps + loopLength;
+
+    std::vector<float> seedData(totalRecordSamps, 0.0f);
+    for (auto i = 0u; i < loopLength; i++)
+        seedData[constants::MaxLoopFadeSamps + i] = 0.5f * std::sin(static_cast<float>(i) * 0.05f);
+
+    auto makeSeededLoop = [&]()
+    {
+        auto loop = MakeLoop();
+        loop.SetVisualUpdatesEnabled(false);
+        loop.Record();
+        AudioWriteRequest writeReq;
+        writeReq.samples = seedData.data();
+        writeReq.numSamps = static_cast<unsigned int>(totalRecordSamps);
+        writeReq.stride = 1;
+        writeReq.fadeCurrent = 0.0f;
+        writeReq.fadeNew = 1.0f;
+        writeReq.source = base::Audible::AUDIOSOURCE_ADC;
+        loop.OnBlockWrite(writeReq, 0);
+        loop.EndWrite(static_cast<unsigned int>(totalRecordSamps), true);
+        loop.Play(constants::MaxLoopFadeSamps, loopLength, false);
+        return loop;
+    };
+
+    auto& pool = BankPool::Instance();
+    auto compactIdleSamps = pool.CompactIdleSamps();
+    pool.SetCompactIdleSamps(2ul * blockSize);
+
+    auto reference = makeSeededLoop();
+    auto loop = std::make_shared<Loop>(makeSeededLoop());
+
+    auto refSink = std::make_shared<MockMultiSink>(blockSize);
+    auto sink = std::make_shared<MockMultiSink>(blockSize);
+    std::vector<JobAction> compactJobs;
+
+    auto playBoth = [&]()
+    {
+        PlayOneBlock(reference, refSink, blockSize);
+        PlayOneBlock(*loop, sink, blockSize);
+
+        loop->Update();
+        for (auto& job : loop->CommitChanges())
+        {
+            if (JobAction::JOB_COMPACTLOOP == job.JobActionType)
+                compactJobs.push_back(job);
+        }
+
+        // Packing error is at most half a step of the block's peak
+        for (auto s = 0u; s < blockSize; s++)
+            ASSERT_NEAR(refSink->GetSamples()[s], sink->GetSamples()[s], 1.0e-4f) << "sample " << s;
+    };
+
+    playBoth();
+    ASSERT_TRUE(compactJobs.empty());
+
+    playBoth();
+    ASSERT_EQ(1u, compactJobs.size());
+
+    auto bytesBefore = loop->BufferBytes();
+    loop->OnAction(compactJobs[0]);
+
+    // The packed banks are swapped in by the next block, and keep playing
+    for (auto block = 0u; block < (2u * loopLength) / blockSize; block++)
+        playBoth();
+
+    utils::EpochDomain::Instance().Reclaim();
+
+    EXPECT_LT(loop->BufferBytes(), bytesBefore);
+    EXPECT_EQ(1u, compactJobs.size());
+
+    pool.SetCompactIdleSamps(compactIdleSamps);
+}
+
+// -- Loading tests ------------------------------------------------------------
+
+namespace {
+
+// Sample i holds i, scaled down to stay exact in a float. Reads stop
+// short at readLimit, as a truncated file would.
+class RampSource : public audio::SampleSource
+{
+public:
+    RampSource(unsigned long length, unsigned long readLimit) :
+        _length(length),
+        _readLimit(readLimit)
+    {
+    }
+
+    unsigned long Length() const override { return _length; }
+
+    unsigned long Read(unsigned long index, float* dest, unsigned long numSamps) override
+    {
+        if (index >= _readLimit)
+            return 0ul;
+
+        auto numRead = std::min(numSamps, _readLimit - index);
+        for (auto i = 0ul; i < numRead; i++)
+            dest[i] = Expected(index + i);
+
+        return numRead;
+    }
+
+    static float Expected(unsigned long index)
+    {
+        return static_cast<float>(index) / 16777216.0f;
+    }
+
+private:
+    unsigned long _length;
+    unsigned long _readLimit;
+};
+
+}
+
+TEST(Loop, LoadSourceFillsEverySlab)
+{
+    auto loop = MakeLoopProbe();
+    loop.SetVisualUpdatesEnabled(false);
+
+    // Spans several slabs, ending partway into the last
+    const auto length = (3ul * BankPool::Instance().SlabSize()) + 100ul;
+    ASSERT_TRUE(loop.LoadSource(std::make_unique<RampSource>(length, length)));
+
+    EXPECT_EQ(length - constants::MaxLoopFadeSamps, loop.LoopLength());
+    EXPECT_FALSE(loop.IsStreaming());
+
+    for (auto i = 0ul; i < length; i++)
+        ASSERT_EQ(RampSource::Expected(i), loop.Sample(i)) << "sample " << i;
+}
+
+TEST(Loop, LoadSourceKeepsWhatAShortReadGave)
+{
+    auto loop = MakeLoopProbe();
+    loop.SetVisualUpdatesEnabled(false);
+
+    const auto length = 2ul * BankPool::Instance().SlabSize();
+    const auto readLimit = length - 500ul;
+    ASSERT_TRUE(loop.LoadSource(std::make_unique<RampSource>(length, readLimit)));
+
+    EXPECT_EQ(readLimit - constants::MaxLoopFadeSamps, loop.LoopLength());
+    EXPECT_EQ(RampSource::Expected(readLimit - 1ul), loop.Sample(readLimit - 1ul));
+}
+
+TEST(Loop, LoadSourceFailsWhenNothingReads)
+{
+    auto loop = MakeLoop();
+
+    EXPECT_FALSE(loop.LoadSource(nullptr));
+    EXPECT_FALSE(loop.LoadSource(std::make_unique<RampSource>(1000ul, 0ul)));
+    EXPECT_EQ(0ul, loop.LoopLength());
+}
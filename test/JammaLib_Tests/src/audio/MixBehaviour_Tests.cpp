@@ -21,6 +21,8 @@ float FadeNew;
 base::Audible::AudioSourceType Source;
 unsigned int StartIndex;
 const float* Samples;
+const float* FadeRamp;
+float FadeCurrentRamp;
 };
 
 class MockBlockSink :
@@ -57,7 +59,9 @@ int writeOffset) override
 	request.fadeNew,
 	request.source,
 	static_cast<unsigned int>(writeOffset),
-	request.samples
+	request.samples,
+	request.fadeRamp,
+	request.fadeCurrentRamp
 	});
 }
 
@@ -83,7 +87,7 @@ WireMixBehaviour behaviour(params);
 
 float srcBuf[] = { 0.5f };
 auto sink = std::make_shared<MockBlockMultiSink>(4u);
-behaviour.ApplyBlock(sink, srcBuf, 0.8f, 1, 0);
+behaviour.ApplyBlock(sink, srcBuf, 0.8f, nullptr, 1, 0);
 
 ASSERT_EQ(1u, sink->Calls.size());
 EXPECT_EQ(1u, sink->Calls[0].Channel);
@@ -97,7 +101,7 @@ WireMixBehaviour behaviour(params);
 
 float srcBuf[] = { 0.3f };
 auto sink = std::make_shared<MockBlockMultiSink>(2u);
-behaviour.ApplyBlock(sink, srcBuf, 0.6f, 1, 0);
+behaviour.ApplyBlock(sink, srcBuf, 0.6f, nullptr, 1, 0);
 
 ASSERT_EQ(1u, sink->Calls.size());
 EXPECT_FLOAT_EQ(0.0f, sink->Calls[0].FadeCurrent);
@@ -110,7 +114,7 @@ WireMixBehaviour behaviour(params);
 
 float srcBuf[] = { 1.0f, 1.0f };
 auto sink = std::make_shared<MockBlockMultiSink>(4u);
-behaviour.ApplyBlock(sink, srcBuf, 1.0f, 2, 5);
+behaviour.ApplyBlock(sink, srcBuf, 1.0f, nullptr, 2, 5);
 
 ASSERT_EQ(3u, sink->Calls.size());
 EXPECT_EQ(0u, sink->Calls[0].Channel);
@@ -125,13 +129,30 @@ EXPECT_EQ(2u, call.NumSamps);
 }
 }
 
+TEST(WireMixBehaviour, ApplyBlockPassesFadeRamp)
+{
+WireMixBehaviourParams params({ 0u });
+WireMixBehaviour behaviour(params);
+
+float srcBuf[] = { 0.5f, 0.5f };
+float fadeRamp[] = { 0.25f, 0.5f };
+auto sink = std::make_shared<MockBlockMultiSink>(2u);
+behaviour.ApplyBlock(sink, srcBuf, 0.8f, fadeRamp, 2, 0);
+
+ASSERT_EQ(1u, sink->Calls.size());
+EXPECT_EQ(fadeRamp, sink->Calls[0].FadeRamp);
+EXPECT_FLOAT_EQ(1.0f, sink->Calls[0].FadeNew);
+EXPECT_FLOAT_EQ(0.0f, sink->Calls[0].FadeCurrent);
+EXPECT_FLOAT_EQ(0.0f, sink->Calls[0].FadeCurrentRamp);
+}
+
 TEST(WireMixBehaviour, ApplyBlockNullDestDoesNotCrash)
 {
 WireMixBehaviourParams params({ 0u });
 WireMixBehaviour behaviour(params);
 
 float srcBuf[] = { 1.0f };
-EXPECT_NO_FATAL_FAILURE(behaviour.ApplyBlock(nullptr, srcBuf, 1.0f, 1, 0));
+EXPECT_NO_FATAL_FAILURE(behaviour.ApplyBlock(nullptr, srcBuf, 1.0f, nullptr, 1, 0));
 }
 
 TEST(WireMixBehaviour, SetParamsUpdatesChannels)
@@ -144,7 +165,7 @@ behaviour.SetParams(updated);
 
 float srcBuf[] = { 0.5f };
 auto sink = std::make_shared<MockBlockMultiSink>(4u);
-behaviour.ApplyBlock(sink, srcBuf, 1.0f, 1, 0);
+behaviour.ApplyBlock(sink, srcBuf, 1.0f, nullptr, 1, 0);
 
 ASSERT_EQ(2u, sink->Calls.size());
 EXPECT_EQ(1u, sink->Calls[0].Channel);
@@ -160,7 +181,7 @@ behaviour.SetMaxChannels(2u);
 
 float srcBuf[] = { 1.0f };
 auto sink = std::make_shared<MockBlockMultiSink>(4u);
-behaviour.ApplyBlock(sink, srcBuf, 1.0f, 1, 0);
+behaviour.ApplyBlock(sink, srcBuf, 1.0f, nullptr, 1, 0);
 
 // SetMaxChannels keeps channels with index < chans (count semantics).
 // For chans = 2, channels 0 and 1 remain; channels 2 and 3 are removed.
@@ -179,7 +200,7 @@ MergeMixBehaviour behaviour(params);
 
 float srcBuf[] = { 0.7f };
 auto sink = std::make_shared<MockBlockMultiSink>(2u);
-behaviour.ApplyBlock(sink, srcBuf, 0.5f, 1, 0);
+behaviour.ApplyBlock(sink, srcBuf, 0.5f, nullptr, 1, 0);
 
 ASSERT_EQ(1u, sink->Calls.size());
 EXPECT_EQ(0u, sink->Calls[0].Channel);
@@ -194,7 +215,7 @@ MergeMixBehaviour behaviour(params);
 
 float srcBuf[] = { 0.4f };
 auto sink = std::make_shared<MockBlockMultiSink>(2u);
-behaviour.ApplyBlock(sink, srcBuf, 0.9f, 1, 0);
+behaviour.ApplyBlock(sink, srcBuf, 0.9f, nullptr, 1, 0);
 
 ASSERT_EQ(1u, sink->Calls.size());
 EXPECT_FLOAT_EQ(1.0f, sink->Calls[0].FadeCurrent);
@@ -208,7 +229,7 @@ MergeMixBehaviour behaviour(params);
 
 float srcBuf[] = { 0.5f };
 auto sink = std::make_shared<MockBlockMultiSink>(2u);
-behaviour.ApplyBlock(sink, srcBuf, 0.5f, 1, 0);
+behaviour.ApplyBlock(sink, srcBuf, 0.5f, nullptr, 1, 0);
 
 ASSERT_EQ(2u, sink->Calls.size());
 for (const auto& call : sink->Calls)
@@ -225,7 +246,7 @@ params.Channels = { 0u };
 MergeMixBehaviour behaviour(params);
 
 float srcBuf[] = { 1.0f };
-EXPECT_NO_FATAL_FAILURE(behaviour.ApplyBlock(nullptr, srcBuf, 1.0f, 1, 0));
+EXPECT_NO_FATAL_FAILURE(behaviour.ApplyBlock(nullptr, srcBuf, 1.0f, nullptr, 1, 0));
 }
 
 TEST(MergeMixBehaviour, SetParamsUpdatesChannels)
@@ -239,7 +260,7 @@ behaviour.SetParams(updated);
 
 float srcBuf[] = { 1.0f };
 auto sink = std::make_shared<MockBlockMultiSink>(4u);
-behaviour.ApplyBlock(sink, srcBuf, 1.0f, 1, 0);
+behaviour.ApplyBlock(sink, srcBuf, 1.0f, nullptr, 1, 0);
 
 ASSERT_EQ(2u, sink->Calls.size());
 EXPECT_EQ(2u, sink->Calls[0].Channel);
@@ -256,7 +277,7 @@ behaviour.SetMaxChannels(2u);
 
 float srcBuf[] = { 1.0f };
 auto sink = std::make_shared<MockBlockMultiSink>(4u);
-behaviour.ApplyBlock(sink, srcBuf, 1.0f, 1, 0);
+behaviour.ApplyBlock(sink, srcBuf, 1.0f, nullptr, 1, 0);
 
 // SetMaxChannels removes channels >= chans.
 // Channel 3 (3 >= 2) is removed; channels 0 and 1 remain.
@@ -275,7 +296,7 @@ BounceMixBehaviour behaviour(params);
 
 float srcBuf[] = { 0.8f };
 auto sink = std::make_shared<MockBlockMultiSink>(2u);
-behaviour.ApplyBlock(sink, srcBuf, 0.0f, 1, 0);
+behaviour.ApplyBlock(sink, srcBuf, 0.0f, nullptr, 1, 0);
 
 ASSERT_EQ(1u, sink->Calls.size());
 EXPECT_FLOAT_EQ(0.0f, sink->Calls[0].FadeNew);
@@ -290,7 +311,7 @@ BounceMixBehaviour behaviour(params);
 
 float srcBuf[] = { 0.8f };
 auto sink = std::make_shared<MockBlockMultiSink>(2u);
-behaviour.ApplyBlock(sink, srcBuf, 1.0f, 1, 0);
+behaviour.ApplyBlock(sink, srcBuf, 1.0f, nullptr, 1, 0);
 
 ASSERT_EQ(1u, sink->Calls.size());
 EXPECT_FLOAT_EQ(1.0f, sink->Calls[0].FadeNew);
@@ -305,7 +326,7 @@ BounceMixBehaviour behaviour(params);
 
 float srcBuf[] = { 0.5f };
 auto sink = std::make_shared<MockBlockMultiSink>(2u);
-behaviour.ApplyBlock(sink, srcBuf, 0.4f, 1, 0);
+behaviour.ApplyBlock(sink, srcBuf, 0.4f, nullptr, 1, 0);
 
 	ASSERT_EQ(1u, sink->Calls.size());
 	EXPECT_FLOAT_EQ(0.4f, sink->Calls[0].FadeNew);
@@ -313,6 +334,24 @@ behaviour.ApplyBlock(sink, srcBuf, 0.4f, 1, 0);
 	EXPECT_EQ(base::Audible::AUDIOSOURCE_BOUNCE, sink->Calls[0].Source);
 }
 
+TEST(BounceMixBehaviour, ApplyBlockFadeRampCrossfades)
+{
+BounceMixBehaviourParams params;
+params.Channels = { 0u };
+BounceMixBehaviour behaviour(params);
+
+float srcBuf[] = { 0.5f, 0.5f };
+float fadeRamp[] = { 0.25f, 0.5f };
+auto sink = std::make_shared<MockBlockMultiSink>(2u);
+behaviour.ApplyBlock(sink, srcBuf, 0.4f, fadeRamp, 2, 0);
+
+ASSERT_EQ(1u, sink->Calls.size());
+EXPECT_EQ(fadeRamp, sink->Calls[0].FadeRamp);
+EXPECT_FLOAT_EQ(1.0f, sink->Calls[0].FadeNew);
+EXPECT_FLOAT_EQ(1.0f, sink->Calls[0].FadeCurrent);
+EXPECT_FLOAT_EQ(-1.0f, sink->Calls[0].FadeCurrentRamp);
+}
+
 TEST(BounceMixBehaviour, ApplyBlockNullDestDoesNotCrash)
 {
 BounceMixBehaviourParams params;
@@ -320,7 +359,7 @@ params.Channels = { 0u };
 BounceMixBehaviour behaviour(params);
 
 float srcBuf[] = { 1.0f };
-EXPECT_NO_FATAL_FAILURE(behaviour.ApplyBlock(nullptr, srcBuf, 0.5f, 1, 0));
+EXPECT_NO_FATAL_FAILURE(behaviour.ApplyBlock(nullptr, srcBuf, 0.5f, nullptr, 1, 0));
 }
 
 TEST(BounceMixBehaviour, ApplyBlockWritesToMultipleChannels)
@@ -331,7 +370,7 @@ BounceMixBehaviour behaviour(params);
 
 float srcBuf[] = { 0.5f };
 auto sink = std::make_shared<MockBlockMultiSink>(2u);
-behaviour.ApplyBlock(sink, srcBuf, 0.3f, 1, 0);
+behaviour.ApplyBlock(sink, srcBuf, 0.3f, nullptr, 1, 0);
 
 ASSERT_EQ(2u, sink->Calls.size());
 EXPECT_EQ(0u, sink->Calls[0].Channel);
@@ -0,0 +1,235 @@
+#include "gtest/gtest.h"
+#include "audio/OfflineRenderer.h"
+#include "audio/AudioHost.h"
+#include "engine/Station.h"
+#include "engine/LoopTake.h"
+#include "engine/Loop.h"
+#include "engine/Trigger.h"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+using engine::Station;
+using engine::StationParams;
+using engine::LoopTake;
+using engine::LoopTakeParams;
+using engine::Trigger;
+using engine::TriggerParams;
+using engine::TriggerBinding;
+using audio::AudioHost;
+using audio::AudioStreamParams;
+using audio::MergeMixBehaviourParams;
+using audio::OfflineEvent;
+using audio::OfflineRenderer;
+using base::Audible;
+using base::AudioWriteRequest;
+using io::UserConfig;
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+
+namespace {
+
+constexpr unsigned int NumChans = 2u;
+constexpr unsigned int BlockSize = 256u;
+constexpr unsigned int ActivateChar = 49u;
+constexpr unsigned long LoopLength = 20000ul;
+
+UserConfig MakeUserConfig()
+{
+	UserConfig cfg;
+	cfg.Audio.SampleRate = constants::DefaultSampleRate;
+	cfg.Audio.BufSize = BlockSize;
+	cfg.Audio.NumBuffers = 1u;
+	cfg.Audio.NumChannelsIn = NumChans;
+	cfg.Audio.NumChannelsOut = NumChans;
+	cfg.Audio.LatencyIn = 0u;
+	cfg.Audio.LatencyOut = 0u;
+	cfg.Trigger.PreDelay = 0u;
+	cfg.Trigger.DebounceSamps = 0u;
+
+	return cfg;
+}
+
+AudioStreamParams MakeStreamParams()
+{
+	AudioStreamParams streamParams{};
+	streamParams.SampleRate = constants::DefaultSampleRate;
+	streamParams.BufSize = BlockSize;
+	streamParams.NumBuffers = 1u;
+	streamParams.NumInputChannels = NumChans;
+	streamParams.NumOutputChannels = NumChans;
+	streamParams.InputLatency = 0u;
+	streamParams.OutputLatency = 0u;
+
+	return streamParams;
+}
+
+std::shared_ptr<Station> MakeStation()
+{
+	StationParams stationParams;
+	stationParams.Size = { 200, 200 };
+	stationParams.FadeSamps = constants::DefaultFadeSamps;
+
+	MergeMixBehaviourParams mergeParams;
+	auto station = std::make_shared<Station>(stationParams,
+		Station::GetMixerParams(stationParams.Size, mergeParams));
+	station->SetNumBusChannels(NumChans);
+	station->SetNumDacChannels(NumChans);
+
+	return station;
+}
+
+// A station holding one playing take with a loop per channel.
+std::shared_ptr<Station> MakePlayingStation()
+{
+	auto station = MakeStation();
+
+	LoopTakeParams takeParams;
+	takeParams.Size = { 100, 100 };
+	takeParams.FadeSamps = constants::DefaultFadeSamps;
+
+	MergeMixBehaviourParams mergeParams;
+	auto take = std::make_shared<LoopTake>(takeParams,
+		LoopTake::GetMixerParams(takeParams.Size, mergeParams));
+	take->SetNumBusChannels(NumChans);
+	take->Record({}, "offline");
+
+	const unsigned long totalRecord = constants::MaxLoopFadeSamps + LoopLength;
+	std::vector<float> samples(totalRecord);
+
+	for (auto chan = 0u; chan < NumChans; chan++)
+	{
+		auto loop = take->AddLoop(chan, "offline");
+		loop->Record();
+
+		for (auto i = 0ul; i < totalRecord; i++)
+			samples[i] = static_cast<float>(((i + chan * 7u) % 200u)) / 200.0f - 0.5f;
+
+		AudioWriteRequest request;
+		request.samples = samples.data();
+		request.numSamps = static_cast<unsigned int>(totalRecord);
+		request.stride = 1;
+		request.fadeCurrent = 0.0f;
+		request.fadeNew = 1.0f;
+		request.source = Audible::AUDIOSOURCE_ADC;
+		loop->OnBlockWrite(request, 0);
+		loop->EndWrite(request.numSamps, true);
+	}
+
+	take->CommitChanges();
+	take->Play(constants::MaxLoopFadeSamps, LoopLength, 0u);
+
+	station->AddTake(take);
+	station->CommitChanges();
+
+	return station;
+}
+
+std::shared_ptr<Trigger> MakeKeyTrigger()
+{
+	engine::DualBinding activate;
+	activate.SetDown(TriggerBinding(engine::TRIGGER_KEY, ActivateChar, 1), true);
+	activate.SetRelease(TriggerBinding(engine::TRIGGER_KEY, ActivateChar, 0), true);
+
+	TriggerParams triggerParams;
+	triggerParams.Activate = { activate };
+	triggerParams.InputChannels = { 0u };
+	triggerParams.DebounceSamps = 0u;
+
+	return std::make_shared<Trigger>(triggerParams);
+}
+
+OfflineEvent KeyEvent(std::uint64_t sampleTime, unsigned int keyChar, bool isDown)
+{
+	OfflineEvent event;
+	event.SampleTime = sampleTime;
+	event.Type = OfflineEvent::EVENT_KEY;
+	event.StationIndex = 0u;
+	event.KeyChar = keyChar;
+	event.IsKeyDown = isDown;
+
+	return event;
+}
+
+std::vector<float> MakeInput(unsigned int numSamps)
+{
+	std::vector<float> input(numSamps * NumChans);
+	for (auto i = 0u; i < input.size(); i++)
+		input[i] = 0.5f * std::sin(static_cast<float>(i) * 0.01f);
+
+	return input;
+}
+
+} // namespace
+
+TEST(OfflineRenderer, KeepsBlocksWholeAroundEvents)
+{
+	AudioHost host(MakeUserConfig());
+	OfflineRenderer renderer(host, MakeStreamParams(), { MakeStation() });
+
+	renderer.AddEvent(KeyEvent(100u, 'z', true));
+	auto stats = renderer.Render(2u * BlockSize);
+
+	// The event goes out before the first block, stamped with its sample
+	ASSERT_EQ(2u, stats.NumBlocks);
+	ASSERT_EQ(2u * BlockSize, stats.NumSamps);
+	ASSERT_EQ(1u, stats.NumEvents);
+	ASSERT_EQ(2u * BlockSize, renderer.SamplePos());
+	ASSERT_EQ(2u * BlockSize * NumChans, renderer.Output().size());
+}
+
+TEST(OfflineRenderer, RendersDeterministically)
+{
+	const unsigned int numSamps = 3u * LoopLength;
+
+	AudioHost hostA(MakeUserConfig());
+	OfflineRenderer rendererA(hostA, MakeStreamParams(), { MakePlayingStation() });
+	rendererA.Render(numSamps);
+
+	AudioHost hostB(MakeUserConfig());
+	OfflineRenderer rendererB(hostB, MakeStreamParams(), { MakePlayingStation() });
+
+	// Events that change nothing must not change the output
+	rendererB.AddEvent(KeyEvent(777u, 'z', true));
+	rendererB.AddEvent(KeyEvent(LoopLength + 5u, 'z', false));
+	rendererB.Render(numSamps);
+
+	const auto& outA = rendererA.Output();
+	const auto& outB = rendererB.Output();
+	ASSERT_EQ(numSamps * NumChans, outA.size());
+	ASSERT_EQ(outA.size(), outB.size());
+
+	auto peak = 0.0f;
+	for (auto i = 0u; i < outA.size(); i++)
+	{
+		ASSERT_EQ(outA[i], outB[i]) << "sample " << i;
+		peak = std::max(peak, std::abs(outA[i]));
+	}
+
+	ASSERT_GT(peak, 0.1f);
+}
+
+TEST(OfflineRenderer, KeyEventsRecordLoop)
+{
+	auto station = MakeStation();
+	station->AddTrigger(MakeKeyTrigger());
+
+	AudioHost host(MakeUserConfig());
+	OfflineRenderer renderer(host, MakeStreamParams(), { station });
+	renderer.SetInput(MakeInput(4u * LoopLength));
+
+	renderer.AddEvent(KeyEvent(1000u, ActivateChar, true));
+	renderer.AddEvent(KeyEvent(1010u, ActivateChar, false));
+
+	renderer.Render(2000u);
+	ASSERT_EQ(1u, station->NumTakes());
+
+	renderer.AddEvent(KeyEvent(1000u + LoopLength, ActivateChar, true));
+	renderer.AddEvent(KeyEvent(1010u + LoopLength, ActivateChar, false));
+
+	auto stats = renderer.Render(2u * LoopLength);
+	ASSERT_EQ(2u, stats.NumEvents);
+	ASSERT_EQ(1u, station->NumTakes());
+}
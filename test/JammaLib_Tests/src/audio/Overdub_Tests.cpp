@@ -223,7 +223,7 @@ std::shared_ptr<Trigger> MakeOverdubTrigger(unsigned int inputChannel)
 	triggerParams.Activate = { activate };
 	triggerParams.Ditch = { ditch };
 	triggerParams.InputChannels = { inputChannel };
-	triggerParams.DebounceMs = 0u;
+	triggerParams.DebounceSamps = 0u;
 
 	return std::make_shared<Trigger>(triggerParams);
 }
@@ -325,6 +325,7 @@ void SimulateAudioCallback(ChannelMixer& chanMixer,
 	float* outBuf,
 	unsigned int numChans,
 	unsigned int numSamps,
+	std::uint64_t& sampleTime,
 	const UserConfig& cfg,
 	const AudioStreamParams& streamParams)
 {
@@ -358,7 +359,8 @@ void SimulateAudioCallback(ChannelMixer& chanMixer,
 	chanMixer.ToDac(outBuf, numChans, numSamps);
 	chanMixer.Sink()->EndMultiWrite(numSamps, true, Audible::AUDIOSOURCE_LOOPS);
 
-	station->OnTick(utils::Timer::GetTime(), numSamps, cfg, streamParams);
+	station->OnTick(sampleTime, numSamps, cfg, streamParams);
+	sampleTime += numSamps;
 	DrainCommitJobs(station);
 }
 
@@ -367,6 +369,7 @@ void SimulateRemainingRecordTail(ChannelMixer& chanMixer,
 	unsigned int numChans,
 	unsigned int blockSize,
 	unsigned int totalSamps,
+	std::uint64_t& sampleTime,
 	const UserConfig& cfg,
 	const AudioStreamParams& streamParams)
 {
@@ -383,6 +386,7 @@ void SimulateRemainingRecordTail(ChannelMixer& chanMixer,
 			outBuf.data(),
 			numChans,
 			sampsThisBlock,
+			sampleTime,
 			cfg,
 			streamParams);
 		sampsLeft -= sampsThisBlock;
@@ -400,6 +404,7 @@ struct OverdubSession
 	unsigned int OverdubBlocks = 0u;
 	unsigned long LoopSamps = 0ul;
 	unsigned long OverdubSamps = 0ul;
+	std::uint64_t SampleTime = 0u;
 };
 
 OverdubSession CreateOverdubSession(
@@ -464,6 +469,7 @@ void RunOverdubAndTail(OverdubSession& session, unsigned int tailSamps)
 			outBuf.data(),
 			session.Params.NumChans,
 			session.Params.BlockSize,
+			session.SampleTime,
 			session.Cfg,
 			session.StreamParams);
 	}
@@ -481,6 +487,7 @@ void RunOverdubAndTail(OverdubSession& session, unsigned int tailSamps)
 		session.Params.NumChans,
 		session.Params.BlockSize,
 		tailSamps,
+		session.SampleTime,
 		session.Cfg,
 		session.StreamParams);
 
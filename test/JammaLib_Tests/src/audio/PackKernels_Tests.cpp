@@ -0,0 +1,76 @@
+#include "gtest/gtest.h"
+#include "audio/PackKernels.h"
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+using audio::PackKernels;
+
+namespace {
+
+float TestSample(unsigned int index, float peak)
+{
+	const auto wrapped = static_cast<int>(((index + 1u) * 7919u) % 2000u);
+	return peak * static_cast<float>(wrapped - 1000) / 1000.0f;
+}
+
+}
+
+TEST(PackKernels, RoundTripIsWithinHalfAStep)
+{
+	for (auto peak : { 1.0f, 0.3f, 1.0e-4f })
+	{
+		std::vector<float> src(256u);
+		for (auto i = 0u; i < src.size(); i++)
+			src[i] = TestSample(i, peak);
+
+		std::vector<std::int16_t> packed(src.size());
+		auto scale = PackKernels::Pack(src.data(), (unsigned int)src.size(), packed.data());
+
+		std::vector<float> unpacked(src.size());
+		PackKernels::Unpack(packed.data(), scale, (unsigned int)src.size(), unpacked.data());
+
+		// Quiet blocks keep their resolution, as the step follows the peak
+		auto maxError = peak / (2.0f * PackKernels::MaxPacked);
+		for (auto i = 0u; i < src.size(); i++)
+			ASSERT_NEAR(src[i], unpacked[i], maxError * 1.01f) << "peak " << peak << " sample " << i;
+	}
+}
+
+TEST(PackKernels, SilentBlockPacksToZero)
+{
+	std::vector<float> src(64u, 0.0f);
+	std::vector<std::int16_t> packed(src.size(), 1);
+
+	ASSERT_EQ(0.0f, PackKernels::Pack(src.data(), 64u, packed.data()));
+
+	std::vector<float> unpacked(src.size(), 1.0f);
+	PackKernels::Unpack(packed.data(), 0.0f, 64u, unpacked.data());
+
+	for (auto i = 0u; i < src.size(); i++)
+	{
+		ASSERT_EQ(0, packed[i]);
+		ASSERT_EQ(0.0f, unpacked[i]);
+	}
+}
+
+TEST(PackKernels, UnpackMatchesScalarAtAnyLength)
+{
+	std::vector<std::int16_t> packed(40u);
+	for (auto i = 0u; i < packed.size(); i++)
+		packed[i] = static_cast<std::int16_t>(((i * 5003u) % 65535u) - 32767);
+
+	auto scale = 0.7f / PackKernels::MaxPacked;
+
+	// Covers the vector body and every scalar tail length
+	for (auto numSamps = 0u; numSamps <= packed.size(); numSamps++)
+	{
+		std::vector<float> unpacked(packed.size() + 1u, -2.0f);
+		PackKernels::Unpack(packed.data(), scale, numSamps, unpacked.data());
+
+		for (auto i = 0u; i < numSamps; i++)
+			ASSERT_EQ(static_cast<float>(packed[i]) * scale, unpacked[i]) << "length " << numSamps;
+
+		ASSERT_EQ(-2.0f, unpacked[numSamps]);
+	}
+}
@@ -0,0 +1,178 @@
+#include "gtest/gtest.h"
+#include "audio/PcmKernels.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+using audio::PcmKernels;
+
+namespace {
+
+std::int32_t TestValue(unsigned int index, std::int32_t maxValue)
+{
+	const auto wrapped = static_cast<std::int64_t>((index * 7919u) % 2001u) - 1000;
+	return static_cast<std::int32_t>((wrapped * maxValue) / 1000);
+}
+
+}
+
+TEST(PcmKernels, Int16MatchesScalarAtEveryLength)
+{
+	// Covers the vector body and every tail length, from an odd offset
+	for (auto numSamps = 0u; numSamps < 40u; numSamps++)
+	{
+		std::vector<std::uint8_t> bytes(1u + (2u * numSamps));
+		std::vector<float> expected(numSamps);
+
+		for (auto i = 0u; i < numSamps; i++)
+		{
+			auto value = static_cast<std::int16_t>(TestValue(i, 32767));
+			if (0u == i)
+				value = -32768;
+
+			bytes[1u + (2u * i)] = static_cast<std::uint8_t>(value & 0xff);
+			bytes[2u + (2u * i)] = static_cast<std::uint8_t>((value >> 8) & 0xff);
+			expected[i] = static_cast<float>(value) / 32768.0f;
+		}
+
+		std::vector<float> dest(numSamps + 1u, 7.0f);
+		PcmKernels::Int16ToFloat(bytes.data() + 1u, numSamps, dest.data());
+
+		for (auto i = 0u; i < numSamps; i++)
+			ASSERT_EQ(expected[i], dest[i]) << "length " << numSamps << " sample " << i;
+
+		ASSERT_EQ(7.0f, dest[numSamps]) << "length " << numSamps;
+	}
+}
+
+TEST(PcmKernels, Int24SignExtends)
+{
+	const std::vector<std::int32_t> values = { 0, 1, -1, 8388607, -8388608, 4660, -1193046 };
+
+	std::vector<std::uint8_t> bytes;
+	for (auto value : values)
+	{
+		bytes.push_back(static_cast<std::uint8_t>(value & 0xff));
+		bytes.push_back(static_cast<std::uint8_t>((value >> 8) & 0xff));
+		bytes.push_back(static_cast<std::uint8_t>((value >> 16) & 0xff));
+	}
+
+	std::vector<float> dest(values.size());
+	PcmKernels::Int24ToFloat(bytes.data(), (unsigned long)values.size(), dest.data());
+
+	for (auto i = 0u; i < values.size(); i++)
+		ASSERT_EQ(static_cast<float>(values[i]) / 8388608.0f, dest[i]) << "sample " << i;
+
+	EXPECT_EQ(-1.0f, dest[4]);
+}
+
+TEST(PcmKernels, Float32CopiesExactly)
+{
+	const std::vector<float> values = { 0.0f, -0.5f, 0.25f, 1.5f, -1.0e-7f };
+
+	std::vector<std::uint8_t> bytes(1u + values.size() * sizeof(float));
+	std::memcpy(bytes.data() + 1u, values.data(), values.size() * sizeof(float));
+
+	std::vector<float> dest(values.size());
+	PcmKernels::Float32ToFloat(bytes.data() + 1u, (unsigned long)values.size(), dest.data());
+
+	EXPECT_EQ(values, dest);
+}
+
+TEST(PcmKernels, Int32MatchesScalarAtEveryLength)
+{
+	for (auto numSamps = 0u; numSamps < 12u; numSamps++)
+	{
+		std::vector<std::uint8_t> bytes(1u + (4u * numSamps));
+		std::vector<float> expected(numSamps);
+
+		for (auto i = 0u; i < numSamps; i++)
+		{
+			auto value = TestValue(i, 2147483647);
+			auto raw = static_cast<std::uint32_t>(value);
+
+			for (auto b = 0u; b < 4u; b++)
+				bytes[1u + (4u * i) + b] = static_cast<std::uint8_t>((raw >> (8u * b)) & 0xff);
+
+			expected[i] = static_cast<float>(value) / 2147483648.0f;
+		}
+
+		std::vector<float> dest(numSamps);
+		PcmKernels::Int32ToFloat(bytes.data() + 1u, numSamps, dest.data());
+
+		for (auto i = 0u; i < numSamps; i++)
+			ASSERT_EQ(expected[i], dest[i]) << "length " << numSamps << " sample " << i;
+	}
+}
+
+TEST(PcmKernels, WritesReadBackUnchanged)
+{
+	// Every int16 value, plus full scale either side
+	std::vector<float> values;
+	for (auto value = -32768; value < 32768; value++)
+		values.push_back(static_cast<float>(value) / 32768.0f);
+
+	const auto numSamps = static_cast<unsigned long>(values.size());
+	std::vector<std::uint8_t> bytes(4u * values.size());
+	std::vector<float> dest(values.size());
+
+	PcmKernels::FloatToInt16(values.data(), numSamps, bytes.data(), nullptr);
+	PcmKernels::Int16ToFloat(bytes.data(), numSamps, dest.data());
+	EXPECT_EQ(values, dest);
+
+	PcmKernels::FloatToInt24(values.data(), numSamps, bytes.data(), nullptr);
+	PcmKernels::Int24ToFloat(bytes.data(), numSamps, dest.data());
+	EXPECT_EQ(values, dest);
+
+	PcmKernels::FloatToInt32(values.data(), numSamps, bytes.data());
+	PcmKernels::Int32ToFloat(bytes.data(), numSamps, dest.data());
+	EXPECT_EQ(values, dest);
+}
+
+TEST(PcmKernels, WritesClampToFullScale)
+{
+	// Past full scale either way, at lengths reaching the vector bodies
+	std::vector<float> values(9u, 2.0f);
+	values[1] = -2.0f;
+	values[8] = 1.0f;
+
+	std::vector<std::uint8_t> bytes(4u * values.size());
+	std::vector<float> dest(values.size());
+	const auto numSamps = static_cast<unsigned long>(values.size());
+
+	PcmKernels::FloatToInt16(values.data(), numSamps, bytes.data(), nullptr);
+	PcmKernels::Int16ToFloat(bytes.data(), numSamps, dest.data());
+	EXPECT_EQ(32767.0f / 32768.0f, dest[0]);
+	EXPECT_EQ(-1.0f, dest[1]);
+	EXPECT_EQ(32767.0f / 32768.0f, dest[8]);
+
+	PcmKernels::FloatToInt32(values.data(), numSamps, bytes.data());
+	PcmKernels::Int32ToFloat(bytes.data(), numSamps, dest.data());
+	EXPECT_EQ(-1.0f, dest[1]);
+	EXPECT_GT(dest[0], 0.99999f);
+	EXPECT_EQ(dest[0], dest[8]);
+}
+
+TEST(PcmKernels, DitherIsTriangularAndRepeatable)
+{
+	std::vector<float> silence(4096u, 0.0f);
+	std::vector<std::uint8_t> first(2u * silence.size());
+	std::vector<std::uint8_t> second(2u * silence.size());
+	const auto numSamps = static_cast<unsigned long>(silence.size());
+
+	PcmKernels::Dither dither;
+	PcmKernels::FloatToInt16(silence.data(), numSamps, first.data(), &dither);
+
+	// Noise reaches at most one step either side
+	std::vector<float> dest(silence.size());
+	PcmKernels::Int16ToFloat(first.data(), numSamps, dest.data());
+	for (auto sample : dest)
+		ASSERT_LE(std::abs(sample), PcmKernels::Int16Scale);
+
+	// Split into blocks, the same state gives the same noise
+	PcmKernels::Dither chunked;
+	PcmKernels::FloatToInt16(silence.data(), 1000ul, second.data(), &chunked);
+	PcmKernels::FloatToInt16(silence.data() + 1000u, numSamps - 1000ul, second.data() + 2000u, &chunked);
+	EXPECT_EQ(first, second);
+}
@@ -40,4 +40,31 @@ TEST(SerialTriggerProtocol, ResynchronisesOnHeaderMidPacket) {
 	EXPECT_TRUE(protocol.PushByte(1u, event));
 	EXPECT_EQ(3u, event.ButtonIndex);
 	EXPECT_TRUE(event.IsPressed);
-}
\ No newline at end of file
+}
+
+TEST(SerialTriggerProtocol, StampsEventWithHeaderArrival) {
+	SerialTriggerProtocol protocol;
+	SerialTriggerEvent event{};
+
+	EXPECT_FALSE(protocol.PushByte(SerialTriggerProtocol::PacketHeader, event, 1000));
+	EXPECT_FALSE(protocol.PushByte(4u, event, 1000));
+	EXPECT_TRUE(protocol.PushByte(1u, event, 1750));
+	EXPECT_EQ(4u, event.ButtonIndex);
+	EXPECT_EQ(1000, event.ArrivalMicros);
+}
+
+TEST(SerialTriggerProtocol, RestampsOnHeaderMidPacket) {
+	SerialTriggerProtocol protocol;
+	SerialTriggerEvent event{};
+
+	EXPECT_FALSE(protocol.PushByte(SerialTriggerProtocol::PacketHeader, event, 1000));
+	EXPECT_FALSE(protocol.PushByte(SerialTriggerProtocol::PacketHeader, event, 2000));
+	EXPECT_FALSE(protocol.PushByte(5u, event, 2000));
+	EXPECT_TRUE(protocol.PushByte(0u, event, 3000));
+	EXPECT_EQ(2000, event.ArrivalMicros);
+
+	EXPECT_FALSE(protocol.PushByte(SerialTriggerProtocol::PacketHeader, event, 4000));
+	EXPECT_FALSE(protocol.PushByte(6u, event, 4000));
+	EXPECT_TRUE(protocol.PushByte(1u, event, 4000));
+	EXPECT_EQ(4000, event.ArrivalMicros);
+}
@@ -0,0 +1,222 @@
+#include "gtest/gtest.h"
+#include "audio/BankPool.h"
+#include "audio/StreamingBank.h"
+#include "audio/StreamPrefetcher.h"
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using audio::BankPool;
+using audio::SampleSource;
+using audio::StreamingBank;
+using audio::StreamPrefetcher;
+
+namespace {
+
+// Sample i holds i, scaled down to stay exact in a float
+class RampSource : public SampleSource
+{
+public:
+	explicit RampSource(unsigned long length) :
+		_length(length),
+		NumReads(0u)
+	{
+	}
+
+	unsigned long Length() const override { return _length; }
+
+	unsigned long Read(unsigned long index, float* dest, unsigned long numSamps) override
+	{
+		NumReads++;
+
+		if (index >= _length)
+			return 0ul;
+
+		auto numRead = std::min(numSamps, _length - index);
+		for (auto i = 0ul; i < numRead; i++)
+			dest[i] = Expected(index + i);
+
+		return numRead;
+	}
+
+	static float Expected(unsigned long index)
+	{
+		return static_cast<float>(index) / 16777216.0f;
+	}
+
+private:
+	unsigned long _length;
+
+public:
+	unsigned int NumReads;
+};
+
+std::unique_ptr<RampSource> MakeSource(unsigned long numBanks)
+{
+	return std::make_unique<RampSource>(numBanks * BankPool::Instance().SlabSize());
+}
+
+}
+
+TEST(StreamingBank, ReadsPrefetchedSamples)
+{
+	auto bankSize = BankPool::Instance().SlabSize();
+	StreamingBank stream(MakeSource(16ul), 4u);
+
+	stream.SetPlayHead(0ul, 0ul, stream.Length());
+	ASSERT_EQ(4u, stream.Prefetch());
+	ASSERT_EQ(4u, stream.NumResidentBanks());
+
+	// Straddles a bank boundary
+	std::vector<float> buf(256);
+	auto index = bankSize - 100ul;
+	ASSERT_TRUE(stream.Read(index, buf.data(), 256u));
+
+	for (auto i = 0u; i < 256u; i++)
+		ASSERT_EQ(RampSource::Expected(index + i), buf[i]);
+
+	ASSERT_EQ(0u, stream.NumMisses());
+}
+
+TEST(StreamingBank, MissReadsSilenceAndCounts)
+{
+	StreamingBank stream(MakeSource(16ul), 4u);
+
+	std::vector<float> buf(64, 1.0f);
+	ASSERT_FALSE(stream.Read(1000ul, buf.data(), 64u));
+
+	for (auto samp : buf)
+		ASSERT_EQ(0.0f, samp);
+
+	ASSERT_EQ(1u, stream.NumMisses());
+}
+
+TEST(StreamingBank, HoldsOnlyTheWindow)
+{
+	auto bankSize = BankPool::Instance().SlabSize();
+	StreamingBank stream(MakeSource(32ul), 4u);
+
+	ASSERT_EQ(4u, stream.NumSlots());
+	ASSERT_EQ(4u * bankSize * sizeof(float), stream.AllocatedBytes());
+
+	// A short source never takes more slabs than it has banks
+	StreamingBank shortStream(MakeSource(2ul), 8u);
+	ASSERT_EQ(2u, shortStream.NumSlots());
+}
+
+TEST(StreamingBank, WindowFollowsPlayHead)
+{
+	auto bankSize = BankPool::Instance().SlabSize();
+	StreamingBank stream(MakeSource(16ul), 4u);
+
+	stream.SetPlayHead(0ul, 0ul, stream.Length());
+	stream.Prefetch();
+	ASSERT_TRUE(stream.IsResident(0ul, 4ul * bankSize));
+
+	stream.SetPlayHead(6ul * bankSize + 10ul, 0ul, stream.Length());
+	ASSERT_EQ(4u, stream.Prefetch());
+
+	ASSERT_FALSE(stream.IsResident(0ul, 1ul));
+	ASSERT_TRUE(stream.IsResident(6ul * bankSize, 4ul * bankSize));
+
+	// Nothing more to load until the play head moves on
+	ASSERT_EQ(0u, stream.Prefetch());
+}
+
+TEST(StreamingBank, WindowWrapsToLoopStart)
+{
+	auto bankSize = BankPool::Instance().SlabSize();
+	StreamingBank stream(MakeSource(16ul), 4u);
+
+	// Loop runs over banks 2-11, with the play head in bank 10
+	auto wrapStart = 2ul * bankSize + 5ul;
+	auto wrapEnd = 12ul * bankSize - 5ul;
+	stream.SetPlayHead(10ul * bankSize, wrapStart, wrapEnd);
+	stream.Prefetch();
+
+	ASSERT_TRUE(stream.IsResident(10ul * bankSize, 2ul * bankSize));
+	ASSERT_TRUE(stream.IsResident(wrapStart, 2ul * bankSize - 5ul));
+	ASSERT_FALSE(stream.IsResident(12ul * bankSize, 1ul));
+}
+
+TEST(StreamingBank, ShortLoopStopsWhenWindowComesRound)
+{
+	auto bankSize = BankPool::Instance().SlabSize();
+	auto source = MakeSource(16ul);
+	auto sourcePtr = source.get();
+	StreamingBank stream(std::move(source), 8u);
+
+	stream.SetPlayHead(bankSize, bankSize, 3ul * bankSize);
+	ASSERT_EQ(2u, stream.Prefetch());
+	ASSERT_EQ(2u, stream.NumResidentBanks());
+	ASSERT_EQ(2u, sourcePtr->NumReads);
+}
+
+TEST(StreamingBank, ReadSourceBypassesWindow)
+{
+	auto bankSize = BankPool::Instance().SlabSize();
+	StreamingBank stream(MakeSource(16ul), 2u);
+
+	std::vector<float> buf(32);
+	auto index = 9ul * bankSize;
+	ASSERT_EQ(32ul, stream.ReadSource(index, buf.data(), 32ul));
+	ASSERT_EQ(RampSource::Expected(index + 31ul), buf[31]);
+	ASSERT_EQ(0u, stream.NumResidentBanks());
+}
+
+TEST(StreamingBank, ReadSourceTakesTheSourceABankAtATime)
+{
+	auto bankSize = BankPool::Instance().SlabSize();
+	auto source = MakeSource(8ul);
+	auto& ramp = *source;
+	StreamingBank stream(std::move(source), 2u);
+
+	// Runs off the end, so the last read comes up short
+	auto index = 5ul * bankSize + (bankSize / 2ul);
+	std::vector<float> buf(4ul * bankSize);
+	ramp.NumReads = 0u;
+	ASSERT_EQ(8ul * bankSize - index, stream.ReadSource(index, buf.data(), static_cast<unsigned long>(buf.size())));
+	EXPECT_EQ(3u, ramp.NumReads);
+
+	for (auto i = 0ul; i < 8ul * bankSize - index; i++)
+		ASSERT_EQ(RampSource::Expected(index + i), buf[i]) << "sample " << i;
+}
+
+TEST(StreamingBank, PrefetcherFillsWindowInBackground)
+{
+	auto stream = std::make_shared<StreamingBank>(MakeSource(8ul), 4u);
+	stream->SetPlayHead(0ul, 0ul, stream->Length());
+
+	StreamPrefetcher::Instance().Add(stream);
+
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while ((stream->NumResidentBanks() < 4u) && (std::chrono::steady_clock::now() < deadline))
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+	ASSERT_EQ(4u, stream->NumResidentBanks());
+
+	stream.reset();
+
+	deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while ((StreamPrefetcher::Instance().NumStreams() > 0u) && (std::chrono::steady_clock::now() < deadline))
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+	ASSERT_EQ(0u, StreamPrefetcher::Instance().NumStreams());
+}
+
+TEST(StreamingBank, ThresholdSelectsStreaming)
+{
+	auto& prefetcher = StreamPrefetcher::Instance();
+	auto threshold = prefetcher.ThresholdSamps();
+	auto windowBanks = prefetcher.WindowBanks();
+
+	prefetcher.Configure(1000ul, 6u);
+	EXPECT_FALSE(prefetcher.ShouldStream(1000ul));
+	EXPECT_TRUE(prefetcher.ShouldStream(1001ul));
+	EXPECT_EQ(6u, prefetcher.WindowBanks());
+
+	prefetcher.Configure(0ul, 6u);
+	EXPECT_FALSE(prefetcher.ShouldStream(1000000000ul));
+
+	prefetcher.Configure(threshold, windowBanks);
+}
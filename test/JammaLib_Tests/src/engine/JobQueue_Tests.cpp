@@ -0,0 +1,327 @@
+#include "gtest/gtest.h"
+#include "engine/JobQueue.h"
+#include "engine/JobWorkerPool.h"
+#include "base/ActionReceiver.h"
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using actions::JobAction;
+using base::ActionReceiver;
+using engine::JobQueue;
+using engine::JobWorkerPool;
+
+namespace {
+
+class JobRecorder :
+	public ActionReceiver
+{
+public:
+	virtual actions::ActionResult OnAction(actions::JobAction action) override
+	{
+		std::scoped_lock lock(_mutex);
+		Jobs.push_back(action);
+		ThreadIds.push_back(std::this_thread::get_id());
+		return actions::ActionResult::NoAction();
+	}
+
+	std::vector<JobAction> Jobs;
+	std::vector<std::thread::id> ThreadIds;
+
+private:
+	std::mutex _mutex;
+};
+
+JobAction MakeJob(JobAction::JobType type,
+	const std::shared_ptr<ActionReceiver>& receiver,
+	const std::string& sourceId)
+{
+	JobAction job;
+	job.JobActionType = type;
+	job.SourceId = sourceId;
+	job.Receiver = receiver;
+	return job;
+}
+
+JobAction MakeLoadVst(const std::shared_ptr<ActionReceiver>& receiver, const std::wstring& path)
+{
+	auto job = MakeJob(JobAction::JOB_LOADVST, receiver, "loop");
+	job.VstPath = path;
+	return job;
+}
+
+}
+
+TEST(JobQueue, DrainsEverythingInPushOrder)
+{
+	auto receiver = std::make_shared<JobRecorder>();
+	JobQueue queue;
+
+	queue.Push(MakeLoadVst(receiver, L"a.vst3"));
+	queue.Push(std::vector<JobAction>{ MakeLoadVst(receiver, L"b.vst3"), MakeLoadVst(receiver, L"c.vst3") });
+	ASSERT_EQ(3u, queue.Depth());
+
+	std::vector<JobAction> dropped;
+	auto jobs = queue.Drain(dropped);
+
+	ASSERT_EQ(3u, jobs.size());
+	ASSERT_EQ(L"a.vst3", jobs[0].VstPath);
+	ASSERT_EQ(L"b.vst3", jobs[1].VstPath);
+	ASSERT_EQ(L"c.vst3", jobs[2].VstPath);
+	ASSERT_TRUE(dropped.empty());
+	ASSERT_EQ(0u, queue.Depth());
+	ASSERT_TRUE(queue.Drain(dropped).empty());
+}
+
+TEST(JobQueue, CoalescesToNewestPerReceiver)
+{
+	auto first = std::make_shared<JobRecorder>();
+	auto second = std::make_shared<JobRecorder>();
+	JobQueue queue;
+
+	auto oldJob = MakeJob(JobAction::JOB_UPDATEMIDIQUANTISATION, first, "take");
+	oldJob.VstIndex = 1u;
+	auto newJob = MakeJob(JobAction::JOB_UPDATEMIDIQUANTISATION, first, "take");
+	newJob.VstIndex = 2u;
+
+	queue.Push(oldJob);
+	queue.Push(MakeLoadVst(first, L"a.vst3"));
+	queue.Push(MakeJob(JobAction::JOB_UPDATEMIDIQUANTISATION, second, "take"));
+	queue.Push(newJob);
+
+	std::vector<JobAction> dropped;
+	auto jobs = queue.Drain(dropped);
+
+	// The newest duplicate survives, in its own place
+	ASSERT_EQ(3u, jobs.size());
+	ASSERT_EQ(JobAction::JOB_LOADVST, jobs[0].JobActionType);
+	ASSERT_EQ(second.get(), jobs[1].Receiver.lock().get());
+	ASSERT_EQ(2u, jobs[2].VstIndex);
+
+	ASSERT_EQ(1u, dropped.size());
+	ASSERT_EQ(1u, dropped[0].VstIndex);
+	ASSERT_EQ(1u, queue.GetStats().NumCoalesced);
+}
+
+TEST(JobQueue, KeepsDistinctVstLoadsAndDropsExpiredReceivers)
+{
+	auto receiver = std::make_shared<JobRecorder>();
+	auto gone = std::make_shared<JobRecorder>();
+	JobQueue queue;
+
+	queue.Push(MakeLoadVst(receiver, L"a.vst3"));
+	queue.Push(MakeLoadVst(gone, L"a.vst3"));
+	queue.Push(MakeLoadVst(receiver, L"b.vst3"));
+	gone.reset();
+
+	std::vector<JobAction> dropped;
+	auto jobs = queue.Drain(dropped);
+
+	ASSERT_EQ(2u, jobs.size());
+	ASSERT_EQ(L"a.vst3", jobs[0].VstPath);
+	ASSERT_EQ(L"b.vst3", jobs[1].VstPath);
+	ASSERT_EQ(1u, dropped.size());
+}
+
+TEST(JobQueue, PushWakesWaiter)
+{
+	auto receiver = std::make_shared<JobRecorder>();
+	JobQueue queue;
+
+	auto start = std::chrono::steady_clock::now();
+	std::thread pusher([&]() {
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		queue.Push(MakeLoadVst(receiver, L"a.vst3"));
+	});
+
+	queue.Wait(std::chrono::seconds(10));
+	auto elapsed = std::chrono::steady_clock::now() - start;
+	pusher.join();
+
+	ASSERT_LT(elapsed, std::chrono::seconds(5));
+	ASSERT_EQ(1u, queue.Depth());
+}
+
+TEST(JobQueue, WaitReturnsAtOnceWithJobsPending)
+{
+	auto receiver = std::make_shared<JobRecorder>();
+	JobQueue queue;
+	queue.Push(MakeLoadVst(receiver, L"a.vst3"));
+
+	auto start = std::chrono::steady_clock::now();
+	queue.Wait(std::chrono::seconds(10));
+
+	ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+}
+
+TEST(JobQueue, WakeInterruptsWait)
+{
+	JobQueue queue;
+
+	auto start = std::chrono::steady_clock::now();
+	std::thread waker([&]() {
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		queue.Wake();
+	});
+
+	queue.Wait(std::chrono::seconds(10));
+	auto elapsed = std::chrono::steady_clock::now() - start;
+	waker.join();
+
+	ASSERT_LT(elapsed, std::chrono::seconds(5));
+}
+
+TEST(JobQueue, ConcurrentPushersLoseNothing)
+{
+	constexpr auto NumPushers = 4u;
+	constexpr auto NumJobs = 500u;
+
+	std::vector<std::shared_ptr<JobRecorder>> receivers;
+	for (auto i = 0u; i < NumPushers; i++)
+		receivers.push_back(std::make_shared<JobRecorder>());
+
+	JobQueue queue;
+	std::vector<std::thread> pushers;
+
+	for (auto p = 0u; p < NumPushers; p++)
+	{
+		pushers.emplace_back([&, p]() {
+			for (auto i = 0u; i < NumJobs; i++)
+				queue.Push(MakeLoadVst(receivers[p], std::to_wstring(i)));
+		});
+	}
+
+	std::vector<JobAction> jobs;
+	std::vector<JobAction> dropped;
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+
+	while ((jobs.size() < NumPushers * NumJobs) && (std::chrono::steady_clock::now() < deadline))
+	{
+		queue.Wait(std::chrono::milliseconds(1));
+		auto batch = queue.Drain(dropped);
+		jobs.insert(jobs.end(), batch.begin(), batch.end());
+	}
+
+	for (auto& pusher : pushers)
+		pusher.join();
+
+	ASSERT_EQ(NumPushers * NumJobs, jobs.size());
+	ASSERT_TRUE(dropped.empty());
+
+	// Each pusher's jobs arrive in the order they were pushed
+	std::vector<unsigned int> next(NumPushers, 0u);
+	for (auto& job : jobs)
+	{
+		for (auto p = 0u; p < NumPushers; p++)
+		{
+			if (job.Receiver.lock() == receivers[p])
+			{
+				ASSERT_EQ(std::to_wstring(next[p]), job.VstPath);
+				next[p]++;
+			}
+		}
+	}
+}
+
+TEST(JobQueue, StatsTrackDepthAndLatency)
+{
+	auto receiver = std::make_shared<JobRecorder>();
+	JobQueue queue;
+
+	queue.Push(MakeLoadVst(receiver, L"a.vst3"));
+	queue.Push(MakeLoadVst(receiver, L"b.vst3"));
+	queue.Push(MakeLoadVst(receiver, L"b.vst3"));
+	std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+	std::vector<JobAction> dropped;
+	queue.Drain(dropped);
+
+	auto stats = queue.GetStats();
+	ASSERT_EQ(3u, stats.NumPushed);
+	ASSERT_EQ(3u, stats.NumDrained);
+	ASSERT_EQ(1u, stats.NumCoalesced);
+	ASSERT_EQ(0u, stats.Depth);
+	ASSERT_EQ(3u, stats.MaxDepth);
+	ASSERT_GE(stats.MaxLatencyMs, 4.0);
+	ASSERT_GE(stats.MaxLatencyMs, stats.MeanLatencyMs);
+	ASSERT_NE(std::string::npos, JobQueue::FormatStats(stats).find("coalesced 1"));
+
+	queue.ResetStats();
+	ASSERT_EQ(0u, queue.GetStats().NumPushed);
+	ASSERT_EQ(0u, queue.GetStats().MaxDepth);
+}
+
+TEST(JobWorkerPool, RunsIndependentReceiversOnWorkers)
+{
+	auto vstReceiver = std::make_shared<JobRecorder>();
+	std::vector<std::shared_ptr<JobRecorder>> loops;
+	std::vector<JobAction> jobs;
+
+	jobs.push_back(MakeLoadVst(vstReceiver, L"a.vst3"));
+	for (auto i = 0u; i < 8u; i++)
+	{
+		loops.push_back(std::make_shared<JobRecorder>());
+		jobs.push_back(MakeJob(JobAction::JOB_COMPACTLOOP, loops.back(), "loop"));
+		jobs.push_back(MakeJob(JobAction::JOB_UPDATEMIDIQUANTISATION, loops.back(), "loop"));
+	}
+	jobs.push_back(MakeLoadVst(vstReceiver, L"b.vst3"));
+
+	JobWorkerPool pool;
+	pool.Start(2u);
+	pool.Run(jobs, [](JobAction& job) {
+		auto receiver = job.Receiver.lock();
+		if (receiver)
+			receiver->OnAction(job);
+	});
+	pool.Stop();
+
+	// VST jobs stay on the calling thread, in order
+	ASSERT_EQ(2u, vstReceiver->Jobs.size());
+	ASSERT_EQ(L"a.vst3", vstReceiver->Jobs[0].VstPath);
+	ASSERT_EQ(L"b.vst3", vstReceiver->Jobs[1].VstPath);
+	ASSERT_EQ(std::this_thread::get_id(), vstReceiver->ThreadIds[0]);
+	ASSERT_EQ(std::this_thread::get_id(), vstReceiver->ThreadIds[1]);
+
+	// Each loop's jobs all ran, in order, on one thread
+	for (auto& loop : loops)
+	{
+		ASSERT_EQ(2u, loop->Jobs.size());
+		ASSERT_EQ(JobAction::JOB_COMPACTLOOP, loop->Jobs[0].JobActionType);
+		ASSERT_EQ(JobAction::JOB_UPDATEMIDIQUANTISATION, loop->Jobs[1].JobActionType);
+		ASSERT_EQ(loop->ThreadIds[0], loop->ThreadIds[1]);
+	}
+}
+
+TEST(JobWorkerPool, MixedReceiverStaysOnCallingThread)
+{
+	auto receiver = std::make_shared<JobRecorder>();
+	std::vector<JobAction> jobs;
+	jobs.push_back(MakeJob(JobAction::JOB_COMPACTLOOP, receiver, "loop"));
+	jobs.push_back(MakeLoadVst(receiver, L"a.vst3"));
+
+	JobWorkerPool pool;
+	pool.Start(2u);
+	pool.Run(jobs, [](JobAction& job) {
+		job.Receiver.lock()->OnAction(job);
+	});
+
+	ASSERT_EQ(2u, receiver->Jobs.size());
+	ASSERT_EQ(JobAction::JOB_COMPACTLOOP, receiver->Jobs[0].JobActionType);
+	ASSERT_EQ(std::this_thread::get_id(), receiver->ThreadIds[0]);
+	ASSERT_EQ(std::this_thread::get_id(), receiver->ThreadIds[1]);
+}
+
+TEST(JobWorkerPool, IndependentJobTypes)
+{
+	JobAction job;
+
+	job.JobActionType = JobAction::JOB_COMPACTLOOP;
+	ASSERT_TRUE(JobWorkerPool::IsIndependent(job));
+	job.JobActionType = JobAction::JOB_UPDATEMIDIQUANTISATION;
+	ASSERT_TRUE(JobWorkerPool::IsIndependent(job));
+	job.JobActionType = JobAction::JOB_LOADVST;
+	ASSERT_FALSE(JobWorkerPool::IsIndependent(job));
+	job.JobActionType = JobAction::JOB_UNLOADVST;
+	ASSERT_FALSE(JobWorkerPool::IsIndependent(job));
+}
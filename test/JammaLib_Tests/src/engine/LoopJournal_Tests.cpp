@@ -0,0 +1,242 @@
+#include "gtest/gtest.h"
+#include "engine/LoopJournal.h"
+#include "io/JamFile.h"
+#include "io/WavFile.h"
+#include "../ScopedDir.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using engine::Loop;
+using engine::LoopJournal;
+using engine::LoopParams;
+using audio::AudioMixerParams;
+using audio::WireMixBehaviourParams;
+using base::AudioWriteRequest;
+
+namespace {
+
+std::shared_ptr<Loop> MakeLoop(const std::string& id)
+{
+	WireMixBehaviourParams mixBehaviour;
+	mixBehaviour.Channels = { 1 };
+	AudioMixerParams mixerParams;
+	mixerParams.Size = { 160, 320 };
+	mixerParams.Position = { 6, 6 };
+	mixerParams.Behaviour = mixBehaviour;
+
+	LoopParams loopParams;
+	loopParams.Id = id;
+	loopParams.Size = { 80, 80 };
+	loopParams.Position = { 10, 22 };
+
+	return std::make_shared<Loop>(loopParams, mixerParams);
+}
+
+// Records numSamps of a ramp in callback-sized blocks
+std::vector<float> RecordRamp(Loop& loop, unsigned long numSamps, unsigned int blockSize)
+{
+	std::vector<float> samples(numSamps);
+	for (auto i = 0ul; i < numSamps; i++)
+		samples[i] = static_cast<float>(i % 1000ul) / 1000.0f;
+
+	for (auto index = 0ul; index < numSamps; index += blockSize)
+	{
+		AudioWriteRequest request;
+		request.samples = samples.data() + index;
+		request.numSamps = static_cast<unsigned int>(std::min(static_cast<unsigned long>(blockSize), numSamps - index));
+		request.stride = 1;
+		request.fadeCurrent = 0.0f;
+		request.fadeNew = 1.0f;
+		request.source = base::Audible::AUDIOSOURCE_ADC;
+		loop.OnBlockWrite(request, 0);
+		loop.EndWrite(request.numSamps, true);
+	}
+
+	return samples;
+}
+
+std::optional<io::JamFile> ReadJam(const std::filesystem::path& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		return std::nullopt;
+
+	std::stringstream ss;
+	ss << file.rdbuf();
+	return io::JamFile::FromStream(std::move(ss));
+}
+
+}
+
+TEST(LoopJournal, DoesNothingUntilStarted)
+{
+	auto loop = MakeLoop("idle");
+	loop->Record();
+	LoopJournal::Instance().Add(loop, "station", "take");
+
+	EXPECT_FALSE(loop->IsJournalled());
+	EXPECT_EQ(0u, LoopJournal::Instance().Pump().NumLoops);
+}
+
+TEST(LoopJournal, WritesRecordedAudioAndJam)
+{
+	ScopedDir dir("journal_write");
+	auto journalDir = dir.Path / "journal";
+	auto& journal = LoopJournal::Instance();
+	ASSERT_TRUE(journal.Start(journalDir.wstring()));
+
+	auto loop = MakeLoop("loop-a");
+	loop->Record();
+	journal.Add(loop, "station", "take-1");
+	ASSERT_TRUE(loop->IsJournalled());
+
+	auto samples = RecordRamp(*loop, constants::MaxLoopFadeSamps + 5000ul, 256u);
+	journal.Pump();
+
+	io::WavFileReader reader;
+	ASSERT_TRUE(reader.Open((journalDir / "loop-a.wav").wstring()));
+	EXPECT_EQ(io::WavSampleFormat::Float32, reader.Format().SampleFormat);
+	ASSERT_EQ(loop->StoredLength(), reader.NumFrames());
+
+	std::vector<float> onDisk(static_cast<std::size_t>(reader.NumFrames()));
+	ASSERT_EQ(onDisk.size(), reader.Read(0u, onDisk.data(), static_cast<unsigned long>(onDisk.size())));
+	for (auto i = 0u; i < onDisk.size(); i++)
+	{
+		float stored;
+		loop->ReadStored(i, &stored, 1u);
+		ASSERT_EQ(stored, onDisk[i]) << "sample " << i;
+	}
+
+	auto jam = ReadJam(journalDir / LoopJournal::JamFileName);
+	ASSERT_TRUE(jam.has_value());
+	ASSERT_EQ(1u, jam->Stations.size());
+	EXPECT_EQ("station", jam->Stations[0].Name);
+	ASSERT_EQ(1u, jam->Stations[0].LoopTakes.size());
+	EXPECT_EQ("take-1", jam->Stations[0].LoopTakes[0].Name);
+	ASSERT_EQ(1u, jam->Stations[0].LoopTakes[0].Loops.size());
+	EXPECT_EQ("loop-a.wav", jam->Stations[0].LoopTakes[0].Loops[0].Name);
+	EXPECT_EQ(loop->StoredLength() - constants::MaxLoopFadeSamps, jam->Stations[0].LoopTakes[0].Loops[0].Length);
+
+	// A clean stop leaves nothing behind
+	journal.Stop(false);
+	EXPECT_FALSE(loop->IsJournalled());
+	EXPECT_FALSE(std::filesystem::exists(journalDir));
+}
+
+TEST(LoopJournal, RemovesFilesOfLoopsThatGoAway)
+{
+	ScopedDir dir("journal_expire");
+	auto journalDir = dir.Path / "journal";
+	auto& journal = LoopJournal::Instance();
+	ASSERT_TRUE(journal.Start(journalDir.wstring()));
+
+	auto loop = MakeLoop("loop-b");
+	loop->Record();
+	journal.Add(loop, "station", "take-1");
+	RecordRamp(*loop, constants::MaxLoopFadeSamps + 1000ul, 512u);
+	journal.Pump();
+	ASSERT_TRUE(std::filesystem::exists(journalDir / "loop-b.wav"));
+
+	loop.reset();
+	EXPECT_EQ(0u, journal.Pump().NumLoops);
+	EXPECT_FALSE(std::filesystem::exists(journalDir / "loop-b.wav"));
+
+	auto jam = ReadJam(journalDir / LoopJournal::JamFileName);
+	ASSERT_TRUE(jam.has_value());
+	EXPECT_TRUE(jam->Stations.empty());
+
+	journal.Stop(false);
+}
+
+TEST(LoopJournal, ClosesLoopsThatStopRecording)
+{
+	ScopedDir dir("journal_close");
+	auto journalDir = dir.Path / "journal";
+	auto& journal = LoopJournal::Instance();
+	ASSERT_TRUE(journal.Start(journalDir.wstring()));
+
+	auto loop = MakeLoop("loop-d");
+	loop->Record();
+	journal.Add(loop, "station", "take-1");
+	RecordRamp(*loop, constants::MaxLoopFadeSamps + 5000ul, 256u);
+	EXPECT_EQ(1u, journal.Pump().NumOpen);
+
+	loop->Play(constants::MaxLoopFadeSamps, 5000ul, false);
+	auto stats = journal.Pump();
+	EXPECT_EQ(1u, stats.NumLoops);
+	EXPECT_EQ(0u, stats.NumOpen);
+	EXPECT_FALSE(loop->IsJournalled());
+
+	io::WavFileReader reader;
+	ASSERT_TRUE(reader.Open((journalDir / "loop-d.wav").wstring()));
+	EXPECT_EQ(loop->StoredLength(), reader.NumFrames());
+
+	auto jam = ReadJam(journalDir / LoopJournal::JamFileName);
+	ASSERT_TRUE(jam.has_value());
+	ASSERT_EQ(1u, jam->Stations.size());
+	ASSERT_EQ(1u, jam->Stations[0].LoopTakes[0].Loops.size());
+	EXPECT_EQ(5000ul, jam->Stations[0].LoopTakes[0].Loops[0].Length);
+
+	journal.Stop(false);
+}
+
+TEST(LoopJournal, DropsDitchedLoops)
+{
+	ScopedDir dir("journal_ditch");
+	auto journalDir = dir.Path / "journal";
+	auto& journal = LoopJournal::Instance();
+	ASSERT_TRUE(journal.Start(journalDir.wstring()));
+
+	auto loop = MakeLoop("loop-e");
+	loop->Record();
+	journal.Add(loop, "station", "take-1");
+	RecordRamp(*loop, constants::MaxLoopFadeSamps + 1000ul, 512u);
+	journal.Pump();
+	ASSERT_TRUE(std::filesystem::exists(journalDir / "loop-e.wav"));
+
+	// Still held, as by an undo, but no longer part of the set
+	loop->Ditch();
+	EXPECT_EQ(0u, journal.Pump().NumLoops);
+	EXPECT_FALSE(loop->IsJournalled());
+	EXPECT_FALSE(std::filesystem::exists(journalDir / "loop-e.wav"));
+
+	auto jam = ReadJam(journalDir / LoopJournal::JamFileName);
+	ASSERT_TRUE(jam.has_value());
+	EXPECT_TRUE(jam->Stations.empty());
+
+	journal.Stop(false);
+}
+
+TEST(LoopJournal, RecoversJournalLeftBehind)
+{
+	ScopedDir dir("journal_recover");
+	auto journalDir = dir.Path / "journal";
+	auto recoveredDir = dir.Path / "recovered";
+	auto& journal = LoopJournal::Instance();
+	ASSERT_TRUE(journal.Start(journalDir.wstring()));
+
+	auto loop = MakeLoop("loop-c");
+	loop->Record();
+	journal.Add(loop, "station", "take-1");
+	RecordRamp(*loop, constants::MaxLoopFadeSamps + 2000ul, 128u);
+
+	// As if the process died, files and all
+	journal.Stop(true);
+	ASSERT_TRUE(std::filesystem::exists(journalDir / LoopJournal::JamFileName));
+
+	// Not to be written over before it is recovered
+	EXPECT_FALSE(journal.Start(journalDir.wstring()));
+
+	EXPECT_EQ(1u, LoopJournal::Recover(journalDir.wstring(), recoveredDir.wstring()));
+	EXPECT_FALSE(std::filesystem::exists(journalDir));
+	EXPECT_TRUE(std::filesystem::exists(recoveredDir / LoopJournal::JamFileName));
+	EXPECT_TRUE(std::filesystem::exists(recoveredDir / "loop-c.wav"));
+
+	EXPECT_EQ(0u, LoopJournal::Recover(journalDir.wstring(), recoveredDir.wstring()));
+}
@@ -0,0 +1,21 @@
+#include "gtest/gtest.h"
+#include "engine/LoopLoader.h"
+
+using engine::LoopLoader;
+
+TEST(LoopLoader, CountsFailedLoads)
+{
+	LoopLoader loader;
+	loader.Add([]() -> std::size_t { return 64u; });
+	loader.Add([]() -> std::size_t { return 0u; });
+	loader.Add([]() -> std::size_t { return 64u; });
+	ASSERT_EQ(3u, loader.NumPending());
+
+	auto stats = loader.Run(8u);
+
+	EXPECT_EQ(0u, loader.NumPending());
+	EXPECT_EQ(3u, stats.NumLoops);
+	EXPECT_EQ(1u, stats.NumFailed);
+	EXPECT_EQ(3u, stats.NumWorkers);
+	EXPECT_EQ(128u, stats.BytesLoaded);
+}
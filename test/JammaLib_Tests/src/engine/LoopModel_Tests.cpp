@@ -41,6 +41,11 @@ namespace
 			return _backUvs;
 		}
 
+		const std::vector<glm::vec2>& Waveform() const
+		{
+			return _waveformDecimated;
+		}
+
 		bool WaveformNeedsUpload() const
 		{
 			return _waveformNeedsUpload;
@@ -84,6 +89,7 @@ TEST(LoopModelMesh, CalcGrainGeometryUsesExpectedRingCoordinates)
 	auto buffer = MakeBuffer(constants::GrainSamps * 4u);
 	buffer[0] = -0.5f;
 	buffer[1] = 0.75f;
+	buffer.UpdateSummary(0ul, 2ul);
 
 	const auto tol = 1e-5f;
 	const auto radius = 100.0f;
@@ -388,3 +394,29 @@ TEST(LoopModelWaveform, UpdateModelThrottlesRecordingCadence)
 	model.UpdateModel(buffer, interval * 2ul, interval * 2ul, 0ul, 120.0f, false);
 	EXPECT_TRUE(model.WaveformNeedsUpload());
 }
+
+TEST(LoopModelWaveform, UpdateModelRedrawsOnlyChangedSegments)
+{
+	auto model = TestLoopModel();
+	const auto offset = static_cast<unsigned long>(constants::MaxLoopFadeSamps);
+	const auto displayLength = 8192ul;
+	auto buffer = MakeBuffer(offset + displayLength);
+
+	model.UpdateModel(buffer, displayLength, displayLength, offset, 120.0f, false, buffer.TakeDirtyRange());
+
+	// A change the model is never told about...
+	buffer[offset + 6000ul] = 0.5f;
+	buffer.UpdateSummary(offset + 6000ul, 1ul);
+	buffer.TakeDirtyRange();
+
+	// ...and one it is
+	buffer[offset + 100ul] = -0.5f;
+	buffer.UpdateSummary(offset + 100ul, 1ul);
+
+	model.UpdateModel(buffer, displayLength, displayLength, offset, 120.0f, false, buffer.TakeDirtyRange());
+	EXPECT_FLOAT_EQ(-0.5f, model.Waveform()[25].x);
+	EXPECT_FLOAT_EQ(0.0f, model.Waveform()[1500].y);
+
+	model.UpdateModel(buffer, displayLength, displayLength, offset, 120.0f, false);
+	EXPECT_FLOAT_EQ(0.5f, model.Waveform()[1500].y);
+}
@@ -0,0 +1,92 @@
+#include "gtest/gtest.h"
+#include "engine/TakeHistory.h"
+#include <string>
+
+using engine::TakeHistory;
+using engine::TriggerTake;
+
+namespace {
+
+TriggerTake MakeTake(unsigned int index)
+{
+	return { TriggerTake::SOURCE_LOOPTAKE, "source-" + std::to_string(index), "target-" + std::to_string(index) };
+}
+
+}
+
+TEST(TakeHistory, PublishesEditsOnCommit)
+{
+	TakeHistory history;
+	auto startVersion = history.Version();
+
+	history.Push(MakeTake(0u));
+	history.Push(MakeTake(1u));
+	history.Pop();
+	history.Push(MakeTake(2u));
+
+	ASSERT_FALSE(history.IsEmpty());
+	EXPECT_EQ("target-2", history.Back().TargetTakeId);
+	EXPECT_TRUE(history.Snapshot()->empty());
+	EXPECT_EQ(startVersion, history.Version());
+
+	ASSERT_TRUE(history.Commit());
+	auto takes = history.Snapshot();
+	ASSERT_EQ(2u, takes->size());
+	EXPECT_EQ("source-0", (*takes)[0].SourceTakeId);
+	EXPECT_EQ("target-2", (*takes)[1].TargetTakeId);
+	EXPECT_NE(startVersion, history.Version());
+
+	// Nothing new, so nothing is published
+	auto commitVersion = history.Version();
+	EXPECT_FALSE(history.Commit());
+	EXPECT_EQ(commitVersion, history.Version());
+
+	history.Clear();
+	EXPECT_TRUE(history.IsEmpty());
+	ASSERT_TRUE(history.Commit());
+	EXPECT_TRUE(history.Snapshot()->empty());
+	EXPECT_EQ(0u, history.NumDropped());
+}
+
+TEST(TakeHistory, ForgetsOldestTakesPastMax)
+{
+	TakeHistory history;
+	const auto numTakes = TakeHistory::MaxTakes + 5u;
+
+	for (auto i = 0u; i < numTakes; i++)
+	{
+		history.Push(MakeTake(i));
+
+		// Commit as the UI thread would, before the edit ring fills
+		if (0u == (i % 16u))
+			history.Commit();
+	}
+
+	history.Commit();
+
+	EXPECT_EQ("target-" + std::to_string(numTakes - 1u), history.Back().TargetTakeId);
+
+	auto takes = history.Snapshot();
+	ASSERT_EQ(TakeHistory::MaxTakes, takes->size());
+	EXPECT_EQ("source-5", takes->front().SourceTakeId);
+	EXPECT_EQ("source-" + std::to_string(numTakes - 1u), takes->back().SourceTakeId);
+
+	for (auto i = 0u; i < TakeHistory::MaxTakes; i++)
+		history.Pop();
+
+	EXPECT_TRUE(history.IsEmpty());
+}
+
+TEST(TakeHistory, CountsEditsDroppedWhileUncommitted)
+{
+	TakeHistory history;
+
+	// One ring slot always stays empty
+	for (auto i = 0u; i < TakeHistory::MaxEdits; i++)
+		history.Push(MakeTake(i));
+
+	EXPECT_EQ(1u, history.NumDropped());
+
+	history.Commit();
+	EXPECT_EQ(TakeHistory::MaxEdits - 1u, history.Snapshot()->size());
+}
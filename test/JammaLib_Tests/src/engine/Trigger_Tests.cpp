@@ -34,11 +34,6 @@ Time GetTime()
 	return std::chrono::steady_clock::now();
 }
 
-Time OffsetTime(const Time t, unsigned int ms)
-{
-	return t + std::chrono::milliseconds(ms);
-}
-
 static void SendMidiEvent(const std::shared_ptr<Trigger>& trigger, const midi::MidiEvent& event, Time t)
 {
 	base::Action midiAction;
@@ -137,6 +132,47 @@ private:
 	std::vector<TriggerAction> _actions;
 };
 
+// Records the gain applied to each sample written, indexed by
+// engine sample
+class GainCaptureSink :
+	public base::MultiAudioSink
+{
+public:
+	GainCaptureSink(std::size_t numSamps) :
+		BlockStart(0u),
+		Gains(numSamps, 0.0f)
+	{
+	}
+
+public:
+	virtual unsigned int NumInputChannels(base::Audible::AudioSourceType source) const override
+	{
+		return 1u;
+	}
+
+	virtual void OnBlockWriteChannel(unsigned int channel,
+		const base::AudioWriteRequest& request,
+		int writeOffset) override
+	{
+		for (auto i = 0u; i < request.numSamps; i++)
+		{
+			auto gain = (nullptr == request.fadeRamp) ? request.fadeNew : request.fadeRamp[i];
+			Gains[BlockStart + writeOffset + i] = gain * request.samples[i * request.stride];
+		}
+	}
+
+public:
+	std::size_t BlockStart;
+	std::vector<float> Gains;
+
+protected:
+	virtual const std::shared_ptr<base::AudioSink> _InputChannel(unsigned int channel,
+		base::Audible::AudioSourceType source) override
+	{
+		return nullptr;
+	}
+};
+
 class TestLoopTake :
 	public LoopTake
 {
@@ -198,7 +234,7 @@ std::shared_ptr<TestLoopTake> MakeTestLoopTake(const std::string& id = "take-0")
 }
 
 std::unique_ptr<Trigger> MakeDefaultTrigger(std::shared_ptr<ActionReceiver> receiver,
-	unsigned int debounceMs)
+	unsigned int debounceSamps)
 {
 	auto activateBind = engine::DualBinding();
 	activateBind.SetDown(engine::TriggerBinding(engine::TRIGGER_KEY, ActivateChar, 1), true);
@@ -210,14 +246,14 @@ std::unique_ptr<Trigger> MakeDefaultTrigger(std::shared_ptr<ActionReceiver> rece
 	trigParams.Activate = { activateBind };
 	TriggerParams ditchParams;
 	trigParams.Ditch = { ditchBind };
-	trigParams.DebounceMs = debounceMs;
+	trigParams.DebounceSamps = debounceSamps;
 	auto trigger = std::make_unique<Trigger>(trigParams);
 	trigger->SetReceiver(receiver);
 
 	return std::move(trigger);
 }
 
-std::shared_ptr<Trigger> MakeSharedDefaultTrigger(unsigned int debounceMs = 0u)
+std::shared_ptr<Trigger> MakeSharedDefaultTrigger(unsigned int debounceSamps = 0u)
 {
 	auto activateBind = engine::DualBinding();
 	activateBind.SetDown(engine::TriggerBinding(engine::TRIGGER_KEY, ActivateChar, 1), true);
@@ -228,12 +264,12 @@ std::shared_ptr<Trigger> MakeSharedDefaultTrigger(unsigned int debounceMs = 0u)
 	TriggerParams trigParams;
 	trigParams.Activate = { activateBind };
 	trigParams.Ditch = { ditchBind };
-	trigParams.DebounceMs = debounceMs;
+	trigParams.DebounceSamps = debounceSamps;
 	return std::make_shared<Trigger>(trigParams);
 }
 
 std::shared_ptr<Trigger> MakeTriggerFromRigJson(const std::string& jsonText,
-	unsigned int debounceMs = 0u)
+	unsigned int debounceSamps = 0u)
 {
 	auto testStream = std::stringstream(jsonText);
 	auto json = std::get<io::Json::JsonPart>(io::Json::FromStream(std::move(testStream)).value());
@@ -243,7 +279,7 @@ std::shared_ptr<Trigger> MakeTriggerFromRigJson(const std::string& jsonText,
 		return nullptr;
 
 	TriggerParams trigParams;
-	trigParams.DebounceMs = debounceMs;
+	trigParams.DebounceSamps = debounceSamps;
 	auto trigger = Trigger::FromFile(trigParams, trigStruct.value());
 	EXPECT_TRUE(trigger.has_value());
 	return trigger.has_value() ? trigger.value() : nullptr;
@@ -268,6 +304,35 @@ TEST(Trigger, DitchesLoop) {
 	ASSERT_TRUE(receiver->GetLastMatched());
 }
 
+TEST(Trigger, TakesVersionTracksHistory) {
+	auto receiver = std::make_shared<MockedTriggerReceiver>();
+	auto trigger = MakeDefaultTrigger(receiver, 0);
+	auto action = KeyAction();
+	auto startVersion = trigger->TakesVersion();
+
+	receiver->SetExpected(TriggerAction::TRIGGER_REC_START);
+	action.KeyChar = ActivateChar;
+	action.KeyActionType = KeyAction::KEY_DOWN;
+	trigger->OnAction(action);
+
+	// Nothing is published until the UI thread commits
+	ASSERT_EQ(0u, trigger->GetTakes()->size());
+	ASSERT_EQ(startVersion, trigger->TakesVersion());
+	trigger->CommitTakes();
+	ASSERT_EQ(1u, trigger->GetTakes()->size());
+
+	auto recordVersion = trigger->TakesVersion();
+	ASSERT_NE(startVersion, recordVersion);
+
+	receiver->SetExpected(TriggerAction::TRIGGER_DITCH);
+	action.KeyChar = DitchChar;
+	action.KeyActionType = KeyAction::KEY_UP;
+	trigger->OnAction(action);
+	trigger->CommitTakes();
+	ASSERT_EQ(0u, trigger->GetTakes()->size());
+	ASSERT_NE(recordVersion, trigger->TakesVersion());
+}
+
 TEST(Trigger, RecordsTwoLoops) {
 	auto receiver = std::make_shared<MockedTriggerReceiver>();
 	auto trigger = MakeDefaultTrigger(receiver, 0);
@@ -521,72 +586,325 @@ TEST(Trigger, OverDubNotReleasingActivateBeforeDub) {
 
 TEST(Trigger, DebounceSimpleTest) {
 	auto receiver = std::make_shared<MockedTriggerReceiver>();
-	auto debounceMs = 100;
-	auto trigger = MakeDefaultTrigger(receiver, debounceMs);
+	auto debounceSamps = 4800u;
+	auto trigger = MakeDefaultTrigger(receiver, debounceSamps);
 	auto action = KeyAction();
 	actions::ActionResult actionRes;
-	auto curTime = GetTime();
+	std::uint64_t curSample = 0u;
 
 	receiver->SetExpected(TriggerAction::TRIGGER_REC_START);
 	action.KeyChar = ActivateChar;
 	action.KeyActionType = KeyAction::KEY_DOWN;
-	action.SetActionTime(curTime);
+	action.SetSampleTime(curSample);
 	actionRes = trigger->OnAction(action);
 	ASSERT_TRUE(receiver->GetLastMatched());
 	ASSERT_EQ(1, receiver->GetNumTimesCalled());
 
-	curTime = OffsetTime(curTime, debounceMs/2);
+	curSample += debounceSamps / 2;
 	action.KeyChar = ActivateChar;
 	action.KeyActionType = KeyAction::KEY_UP;
-	action.SetActionTime(curTime);
+	action.SetSampleTime(curSample);
 	actionRes = trigger->OnAction(action);
 	ASSERT_EQ(1, receiver->GetNumTimesCalled());
 
-	curTime = OffsetTime(curTime, debounceMs/2);
+	curSample += debounceSamps / 2;
 	action.KeyChar = ActivateChar;
 	action.KeyActionType = KeyAction::KEY_DOWN;
-	action.SetActionTime(curTime);
+	action.SetSampleTime(curSample);
 	actionRes = trigger->OnAction(action);
 	ASSERT_EQ(1, receiver->GetNumTimesCalled());
 
-	curTime = OffsetTime(curTime, debounceMs/2);
+	curSample += debounceSamps / 2;
 	action.KeyChar = ActivateChar;
 	action.KeyActionType = KeyAction::KEY_UP;
-	action.SetActionTime(curTime);
+	action.SetSampleTime(curSample);
 	actionRes = trigger->OnAction(action);
 	ASSERT_EQ(1, receiver->GetNumTimesCalled());
 
-	curTime = OffsetTime(curTime, debounceMs*2);
+	curSample += debounceSamps * 2;
 	receiver->SetExpected(TriggerAction::TRIGGER_REC_END);
 	action.KeyChar = ActivateChar;
 	action.KeyActionType = KeyAction::KEY_DOWN;
-	action.SetActionTime(curTime);
+	action.SetSampleTime(curSample);
 	actionRes = trigger->OnAction(action);
 	ASSERT_TRUE(receiver->GetLastMatched());
 	ASSERT_EQ(2, receiver->GetNumTimesCalled());
 
-	curTime = OffsetTime(curTime, debounceMs/2);
+	curSample += debounceSamps / 2;
 	action.KeyChar = ActivateChar;
 	action.KeyActionType = KeyAction::KEY_UP;
-	action.SetActionTime(curTime);
+	action.SetSampleTime(curSample);
 	actionRes = trigger->OnAction(action);
 	ASSERT_EQ(2, receiver->GetNumTimesCalled());
 
-	curTime = OffsetTime(curTime, debounceMs/2);
+	curSample += debounceSamps / 2;
 	action.KeyChar = ActivateChar;
 	action.KeyActionType = KeyAction::KEY_DOWN;
-	action.SetActionTime(curTime);
+	action.SetSampleTime(curSample);
 	actionRes = trigger->OnAction(action);
 	ASSERT_EQ(2, receiver->GetNumTimesCalled());
 
-	curTime = OffsetTime(curTime, debounceMs/2);
+	curSample += debounceSamps / 2;
 	action.KeyChar = ActivateChar;
 	action.KeyActionType = KeyAction::KEY_UP;
-	action.SetActionTime(curTime);
+	action.SetSampleTime(curSample);
 	actionRes = trigger->OnAction(action);
 	ASSERT_EQ(2, receiver->GetNumTimesCalled());
 }
 
+TEST(Trigger, DebounceResolvesOnSameSampleForAnyBlockSize) {
+	constexpr unsigned int debounceSamps = 1000u;
+
+	struct KeyEvent
+	{
+		std::uint64_t Sample;
+		bool IsDown;
+	};
+
+	// Start recording, release, then press again inside the debounce
+	// window, so the end of recording waits for the window to close
+	const std::vector<KeyEvent> events = { { 0u, true }, { 1500u, false }, { 2000u, true } };
+
+	auto recordLength = [&](unsigned int blockSize) {
+		auto receiver = std::make_shared<SequenceTriggerReceiver>();
+		auto trigger = MakeDefaultTrigger(receiver, debounceSamps);
+		auto nextEvent = 0u;
+
+		for (std::uint64_t blockStart = 0u; blockStart < 8192u; blockStart += blockSize)
+		{
+			while ((nextEvent < events.size()) && (events[nextEvent].Sample < blockStart + blockSize))
+			{
+				auto action = KeyAction();
+				action.KeyChar = ActivateChar;
+				action.KeyActionType = events[nextEvent].IsDown ? KeyAction::KEY_DOWN : KeyAction::KEY_UP;
+				action.SetSampleTime(events[nextEvent].Sample);
+				trigger->OnAction(action);
+				nextEvent++;
+			}
+
+			trigger->OnTick(blockStart, blockSize, std::nullopt, std::nullopt);
+		}
+
+		for (auto& action : receiver->Actions())
+		{
+			if (TriggerAction::TRIGGER_REC_END == action.ActionType)
+				return action.SampleCount;
+		}
+
+		return 0ul;
+	};
+
+	EXPECT_EQ(2000ul + debounceSamps, recordLength(64u));
+	EXPECT_EQ(2000ul + debounceSamps, recordLength(256u));
+	EXPECT_EQ(2000ul + debounceSamps, recordLength(2048u));
+}
+
+TEST(Trigger, DebouncedChangeLandsAtBlockOffsetForAnyBlockSize) {
+	constexpr unsigned int debounceSamps = 1000u;
+
+	struct KeyEvent
+	{
+		std::uint64_t Sample;
+		bool IsDown;
+	};
+
+	const std::vector<KeyEvent> events = { { 0u, true }, { 1500u, false }, { 2000u, true } };
+
+	// Engine sample at which REC_END lands: the start of the block after
+	// the tick that sent it, plus its offset into that block
+	auto landingSample = [&](unsigned int blockSize) {
+		auto receiver = std::make_shared<SequenceTriggerReceiver>();
+		auto trigger = MakeDefaultTrigger(receiver, debounceSamps);
+		auto nextEvent = 0u;
+
+		for (std::uint64_t blockStart = 0u; blockStart < 8192u; blockStart += blockSize)
+		{
+			while ((nextEvent < events.size()) && (events[nextEvent].Sample < blockStart + blockSize))
+			{
+				auto action = KeyAction();
+				action.KeyChar = ActivateChar;
+				action.KeyActionType = events[nextEvent].IsDown ? KeyAction::KEY_DOWN : KeyAction::KEY_UP;
+				action.SetSampleTime(events[nextEvent].Sample);
+				trigger->OnAction(action);
+				nextEvent++;
+			}
+
+			trigger->OnTick(blockStart, blockSize, std::nullopt, std::nullopt);
+
+			for (auto& action : receiver->Actions())
+			{
+				if (TriggerAction::TRIGGER_REC_END == action.ActionType)
+				{
+					EXPECT_LT(action.BlockOffset, blockSize);
+					return blockStart + blockSize + action.BlockOffset;
+				}
+			}
+		}
+
+		return std::uint64_t{ 0u };
+	};
+
+	EXPECT_EQ(2000u + debounceSamps, landingSample(64u));
+	EXPECT_EQ(2000u + debounceSamps, landingSample(256u));
+	EXPECT_EQ(2000u + debounceSamps, landingSample(2048u));
+}
+
+TEST(Trigger, DelayedLevelChangeLandsOnSameSampleForAnyBlockSize) {
+	constexpr unsigned int totalSamps = 36u * 2048u;
+	constexpr std::uint64_t punchInSample = 1000u;
+
+	io::UserConfig cfg;
+	cfg.Audio = {
+		"",
+		48000,
+		256,
+		0,
+		0,
+		2,
+		1,
+		1
+	};
+	cfg.Loop = { 0 };
+	cfg.Trigger = { 0, 0 };
+
+	const auto dueSample = punchInSample + cfg.AdcBufferDelay(0u);
+	ASSERT_LT(dueSample + 2048u, totalSamps);
+
+	auto render = [&](unsigned int blockSize) {
+		auto receiver = std::make_shared<SequenceTriggerReceiver>();
+		auto trigger = MakeDefaultTrigger(receiver, 0);
+		trigger->AddInputChannel(0u);
+		auto sink = std::make_shared<GainCaptureSink>(totalSamps);
+		std::vector<float> ones(blockSize, 1.0f);
+
+		auto action = KeyAction();
+		action.SetUserConfig(cfg);
+		action.SetSampleTime(0u);
+
+		// Start overdub, then punch in, muting the overdub input once
+		// the input latency has passed
+		action.KeyChar = DitchChar;
+		action.KeyActionType = KeyAction::KEY_DOWN;
+		trigger->OnAction(action);
+
+		action.KeyChar = ActivateChar;
+		action.KeyActionType = KeyAction::KEY_DOWN;
+		trigger->OnAction(action);
+
+		action.KeyActionType = KeyAction::KEY_UP;
+		trigger->OnAction(action);
+
+		action.KeyActionType = KeyAction::KEY_DOWN;
+		action.SetSampleTime(punchInSample);
+		trigger->OnAction(action);
+
+		for (auto blockStart = 0u; blockStart < totalSamps; blockStart += blockSize)
+		{
+			sink->BlockStart = blockStart;
+			trigger->WriteBlock(sink, ones.data(), blockSize, 0u);
+			trigger->OnTick(blockStart, blockSize, cfg, std::nullopt);
+		}
+
+		return sink->Gains;
+	};
+
+	auto gains64 = render(64u);
+	auto gains256 = render(256u);
+	auto gains2048 = render(2048u);
+
+	EXPECT_FLOAT_EQ(1.0f, gains64[dueSample - 1u]);
+	EXPECT_LT(gains64[dueSample], 1.0f);
+	EXPECT_NEAR(0.0f, gains64.back(), 1e-5f);
+
+	for (auto samp = 0u; samp < totalSamps; samp++)
+	{
+		ASSERT_NEAR(gains64[samp], gains256[samp], 1e-5f) << "at sample " << samp;
+		ASSERT_NEAR(gains64[samp], gains2048[samp], 1e-5f) << "at sample " << samp;
+	}
+}
+
+TEST(Trigger, DelayedLevelChangeLandsOnSameSampleForEveryWriteInBlock) {
+	constexpr unsigned int blockSize = 256u;
+	constexpr unsigned int numBlocks = 64u;
+	constexpr unsigned int totalSamps = numBlocks * blockSize;
+	constexpr unsigned int numLoops = 3u;
+	// OnBounce runs once for MONITOR and once for BOUNCE each block
+	constexpr unsigned int numPasses = 2u;
+	constexpr std::uint64_t punchInSample = 1000u;
+
+	io::UserConfig cfg;
+	cfg.Audio = {
+		"",
+		48000,
+		256,
+		0,
+		0,
+		2,
+		1,
+		1
+	};
+	cfg.Loop = { 0 };
+	cfg.Trigger = { 0, 0 };
+
+	const auto dueSample = punchInSample + cfg.AdcBufferDelay(0u);
+	ASSERT_LT(dueSample + blockSize, totalSamps);
+	ASSERT_NE(0u, dueSample % blockSize);
+
+	auto receiver = std::make_shared<SequenceTriggerReceiver>();
+	auto trigger = MakeDefaultTrigger(receiver, 0);
+	trigger->AddInputChannel(0u);
+	std::vector<float> ones(blockSize, 1.0f);
+
+	std::vector<std::shared_ptr<GainCaptureSink>> sinks;
+	for (auto i = 0u; i < numLoops * numPasses; i++)
+		sinks.push_back(std::make_shared<GainCaptureSink>(totalSamps));
+
+	auto action = KeyAction();
+	action.SetUserConfig(cfg);
+	action.SetSampleTime(0u);
+
+	action.KeyChar = DitchChar;
+	action.KeyActionType = KeyAction::KEY_DOWN;
+	trigger->OnAction(action);
+
+	action.KeyChar = ActivateChar;
+	action.KeyActionType = KeyAction::KEY_DOWN;
+	trigger->OnAction(action);
+
+	action.KeyActionType = KeyAction::KEY_UP;
+	trigger->OnAction(action);
+
+	action.KeyActionType = KeyAction::KEY_DOWN;
+	action.SetSampleTime(punchInSample);
+	trigger->OnAction(action);
+
+	for (auto blockStart = 0u; blockStart < totalSamps; blockStart += blockSize)
+	{
+		for (auto pass = 0u; pass < numPasses; pass++)
+		{
+			for (auto loop = 0u; loop < numLoops; loop++)
+			{
+				auto& sink = sinks[(pass * numLoops) + loop];
+				sink->BlockStart = blockStart;
+				trigger->WriteBlock(sink, ones.data(), blockSize, 0u);
+			}
+		}
+
+		trigger->OnTick(blockStart, blockSize, cfg, std::nullopt);
+	}
+
+	const auto& first = sinks[0]->Gains;
+	EXPECT_FLOAT_EQ(1.0f, first[dueSample - 1u]);
+	EXPECT_LT(first[dueSample], 1.0f);
+	EXPECT_NEAR(0.0f, first.back(), 1e-5f);
+
+	for (auto i = 1u; i < sinks.size(); i++)
+	{
+		for (auto samp = 0u; samp < totalSamps; samp++)
+			ASSERT_FLOAT_EQ(first[samp], sinks[i]->Gains[samp]) << "write " << i << " at sample " << samp;
+	}
+}
+
 TEST(Trigger, EndOverdubPreservesDelayedPunchActions) {
 	auto receiver = std::make_shared<SequenceTriggerReceiver>();
 	auto trigger = MakeDefaultTrigger(receiver, 0);
@@ -651,7 +969,7 @@ TEST(Trigger, EndOverdubPreservesDelayedPunchActions) {
 	EXPECT_EQ(TriggerAction::TRIGGER_OVERDUB_END, actionsBeforeTick[3].ActionType);
 
 	// Flush delayed queues; target-side punch actions should still be emitted after overdub ends.
-	trigger->OnTick(GetTime(), cfg.Trigger.PreDelay + constants::MaxLoopFadeSamps, cfg, std::nullopt);
+	trigger->OnTick(0u, cfg.Trigger.PreDelay + constants::MaxLoopFadeSamps, cfg, std::nullopt);
 
 	auto actionsAfterTick = receiver->Actions();
 	ASSERT_EQ(6u, actionsAfterTick.size());
@@ -727,7 +1045,7 @@ TEST(Trigger, MixedAudioMidiPunchDelaysAudioTargetButNotMidiTarget) {
 	EXPECT_FALSE(actionsBeforeTick[4].ApplyToTargetAudio);
 	EXPECT_TRUE(actionsBeforeTick[4].ApplyToTargetMidi);
 
-	trigger->OnTick(GetTime(), cfg.Trigger.PreDelay + constants::MaxLoopFadeSamps, cfg, std::nullopt);
+	trigger->OnTick(0u, cfg.Trigger.PreDelay + constants::MaxLoopFadeSamps, cfg, std::nullopt);
 
 	auto actionsAfterTick = receiver->Actions();
 	ASSERT_EQ(7u, actionsAfterTick.size());
@@ -752,7 +1070,7 @@ TEST(Trigger, MidiBindingsDriveRecordAndDitchActions) {
 	ASSERT_TRUE(trigStruct.has_value());
 
 	TriggerParams trigParams;
-	trigParams.DebounceMs = 0u;
+	trigParams.DebounceSamps = 0u;
 	auto trigger = Trigger::FromFile(trigParams, trigStruct.value());
 	ASSERT_TRUE(trigger.has_value());
 	trigger.value()->SetReceiver(receiver);
@@ -784,7 +1102,7 @@ TEST(Trigger, NoteOffMidiActivateBindingStartsAndEndsRecordingOnRelease) {
 	ASSERT_TRUE(trigStruct.has_value());
 
 	TriggerParams trigParams;
-	trigParams.DebounceMs = 0u;
+	trigParams.DebounceSamps = 0u;
 	auto trigger = Trigger::FromFile(trigParams, trigStruct.value());
 	ASSERT_TRUE(trigger.has_value());
 	trigger.value()->SetReceiver(receiver);
@@ -813,7 +1131,7 @@ TEST(Trigger, NoteOffMidiDitchBindingCompletesOnNextNoteOn) {
 	ASSERT_TRUE(trigStruct.has_value());
 
 	TriggerParams trigParams;
-	trigParams.DebounceMs = 0u;
+	trigParams.DebounceSamps = 0u;
 	auto trigger = Trigger::FromFile(trigParams, trigStruct.value());
 	ASSERT_TRUE(trigger.has_value());
 	trigger.value()->SetReceiver(receiver);
@@ -885,7 +1203,7 @@ TEST(Trigger, TriggerFromFileRejectsInvalidMidiBindingSpecsFromNonJsonCallers) {
 	};
 
 	TriggerParams trigParams;
-	trigParams.DebounceMs = 0u;
+	trigParams.DebounceSamps = 0u;
 	auto trigger = Trigger::FromFile(trigParams, trigStruct);
 
 	EXPECT_FALSE(trigger.has_value());
@@ -939,7 +1257,7 @@ TEST(SceneReset, KeyTriggerDitchWhileRecording_ResetsScene) {
 }
 
 TEST(SceneReset, KeyTriggerDebouncedDitch_ResetsSceneViaOnTick) {
-	constexpr unsigned int debounceMs = 100u;
+	constexpr unsigned int debounceSamps = 4800u;
 
 	SceneParams sceneParams{ base::DrawableParams(),
 		base::MoveableParams(),
@@ -948,14 +1266,14 @@ TEST(SceneReset, KeyTriggerDebouncedDitch_ResetsSceneViaOnTick) {
 	TestScene scene(sceneParams, userConfig);
 
 	auto station = MakeTestStation();
-	station->AddTrigger(MakeSharedDefaultTrigger(debounceMs));
+	station->AddTrigger(MakeSharedDefaultTrigger(debounceSamps));
 	scene.AddStationForTest(station);
 
-	auto curTime = GetTime();
+	std::uint64_t curSample = 0u;
 
 	// Activate
 	KeyAction action;
-	action.SetActionTime(curTime);
+	action.SetSampleTime(curSample);
 	action.KeyChar = ActivateChar;
 	action.KeyActionType = KeyAction::KEY_DOWN;
 	scene.OnAction(action);
@@ -967,13 +1285,13 @@ TEST(SceneReset, KeyTriggerDebouncedDitch_ResetsSceneViaOnTick) {
 	station->CommitChanges();
 
 	// Ditch DOWN: first ditch is debounce-bypassed, sets _isDitchDown
-	action.SetActionTime(curTime);
+	action.SetSampleTime(curSample);
 	action.KeyChar = DitchChar;
 	action.KeyActionType = KeyAction::KEY_DOWN;
 	scene.OnAction(action);
 
-	// Ditch UP immediately (same timestamp): within debounce window, deferred
-	action.SetActionTime(curTime);
+	// Ditch UP immediately (same sample): within debounce window, deferred
+	action.SetSampleTime(curSample);
 	action.KeyChar = DitchChar;
 	action.KeyActionType = KeyAction::KEY_UP;
 	scene.OnAction(action);
@@ -984,7 +1302,7 @@ TEST(SceneReset, KeyTriggerDebouncedDitch_ResetsSceneViaOnTick) {
 
 	// Simulate audio tick well past debounce window: deferred ditch fires,
 	// then scene sees zero takes and clears timing state
-	scene.OnTick(OffsetTime(curTime, debounceMs * 2), 256u, std::nullopt, std::nullopt);
+	scene.OnTick(curSample + debounceSamps * 2, 256u, std::nullopt, std::nullopt);
 
 	EXPECT_EQ(0u, station->NumTakes());
 	EXPECT_TRUE(scene.IsSceneResetForTest());
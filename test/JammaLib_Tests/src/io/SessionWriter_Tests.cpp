@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "io/SessionWriter.h"
+#include "../ScopedDir.h"
+
+using io::SessionWriter;
+
+namespace {
+
+std::string ReadText(const std::wstring& path)
+{
+	std::ifstream file{ std::filesystem::path(path), std::ios::binary };
+	return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+std::vector<SessionWriter::LoopFile> MakeLoops(const ScopedDir& dir, unsigned int numLoops, std::size_t numSamps)
+{
+	std::vector<SessionWriter::LoopFile> loops;
+
+	for (auto i = 0u; i < numLoops; i++)
+	{
+		SessionWriter::LoopFile loop;
+		loop.Path = dir.File("loop" + std::to_string(i) + ".wav");
+		loop.NumBytes = numSamps * sizeof(float);
+		loop.ReadSamples = [numSamps, i]() { return std::vector<float>(numSamps, static_cast<float>(i)); };
+		loops.push_back(std::move(loop));
+	}
+
+	return loops;
+}
+
+}
+
+TEST(SessionWriter, WritesEveryLoopThenCommitsJam)
+{
+	ScopedDir dir("writer_commit");
+	std::mutex writtenMutex;
+	std::set<std::wstring> written;
+
+	SessionWriter writer;
+	ASSERT_TRUE(writer.Start(MakeLoops(dir, 5u, 64u),
+		dir.File("session.jam"),
+		"jam",
+		[&](const std::wstring& path, const std::vector<float>& samples) {
+			std::scoped_lock lock(writtenMutex);
+			written.insert(path);
+			return 64u == samples.size();
+		},
+		3u,
+		1024u * 1024u));
+	writer.Wait();
+
+	auto progress = writer.GetProgress();
+	EXPECT_EQ(5u, written.size());
+	EXPECT_EQ(5u, progress.NumLoops);
+	EXPECT_EQ(5u, progress.NumWritten);
+	EXPECT_EQ(0u, progress.NumFailed);
+	EXPECT_EQ(5u * 64u * sizeof(float), progress.BytesWritten);
+	EXPECT_FALSE(progress.IsRunning);
+	EXPECT_TRUE(progress.IsCommitted);
+	EXPECT_EQ("jam", ReadText(dir.File("session.jam")));
+	EXPECT_FALSE(std::filesystem::exists(dir.Path / "session.jam.tmp"));
+}
+
+TEST(SessionWriter, FailedLoopLeavesJamUncommitted)
+{
+	ScopedDir dir("writer_failed");
+	ASSERT_TRUE(SessionWriter::CommitTextFile(dir.File("session.jam"), "previous"));
+
+	auto loops = MakeLoops(dir, 3u, 16u);
+	loops[1].ReadSamples = []() { return std::vector<float>(); };
+
+	SessionWriter writer;
+	ASSERT_TRUE(writer.Start(std::move(loops),
+		dir.File("session.jam"),
+		"next",
+		[](const std::wstring&, const std::vector<float>&) { return true; },
+		2u,
+		1024u));
+	writer.Wait();
+
+	auto progress = writer.GetProgress();
+	EXPECT_EQ(2u, progress.NumWritten);
+	EXPECT_EQ(1u, progress.NumFailed);
+	EXPECT_FALSE(progress.IsCommitted);
+	EXPECT_EQ("previous", ReadText(dir.File("session.jam")));
+}
+
+TEST(SessionWriter, KeepsHeldSamplesWithinBudget)
+{
+	ScopedDir dir("writer_budget");
+	constexpr std::size_t NumSamps = 1024u;
+	constexpr std::size_t LoopBytes = NumSamps * sizeof(float);
+
+	std::atomic<std::size_t> held{ 0u };
+	std::atomic<std::size_t> maxHeld{ 0u };
+
+	auto loops = MakeLoops(dir, 12u, NumSamps);
+	for (auto& loop : loops)
+	{
+		loop.ReadSamples = [&]() {
+			auto now = held.fetch_add(LoopBytes) + LoopBytes;
+			auto cur = maxHeld.load();
+			while ((now > cur) && !maxHeld.compare_exchange_weak(cur, now)) {}
+
+			return std::vector<float>(NumSamps, 0.5f);
+		};
+	}
+
+	SessionWriter writer;
+	ASSERT_TRUE(writer.Start(std::move(loops),
+		dir.File("session.jam"),
+		"jam",
+		[&](const std::wstring&, const std::vector<float>&) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			held.fetch_sub(LoopBytes);
+			return true;
+		},
+		6u,
+		2u * LoopBytes));
+	writer.Wait();
+
+	EXPECT_EQ(12u, writer.GetProgress().NumWritten);
+	EXPECT_LE(maxHeld.load(), 2u * LoopBytes);
+}
+
+TEST(SessionWriter, LoopBiggerThanBudgetStillWrites)
+{
+	ScopedDir dir("writer_oversize");
+
+	SessionWriter writer;
+	ASSERT_TRUE(writer.Start(MakeLoops(dir, 2u, 256u),
+		dir.File("session.jam"),
+		"jam",
+		[](const std::wstring&, const std::vector<float>&) { return true; },
+		2u,
+		16u));
+	writer.Wait();
+
+	EXPECT_EQ(2u, writer.GetProgress().NumWritten);
+	EXPECT_TRUE(writer.GetProgress().IsCommitted);
+}
+
+TEST(SessionWriter, RejectsStartWhileRunning)
+{
+	ScopedDir dir("writer_busy");
+	std::promise<void> release;
+	auto released = release.get_future().share();
+
+	SessionWriter writer;
+	ASSERT_TRUE(writer.Start(MakeLoops(dir, 1u, 8u),
+		dir.File("session.jam"),
+		"first",
+		[released](const std::wstring&, const std::vector<float>&) { released.wait(); return true; },
+		1u,
+		1024u));
+
+	EXPECT_TRUE(writer.IsRunning());
+	EXPECT_FALSE(writer.Start(MakeLoops(dir, 1u, 8u),
+		dir.File("session.jam"),
+		"second",
+		[](const std::wstring&, const std::vector<float>&) { return true; },
+		1u,
+		1024u));
+
+	release.set_value();
+	writer.Wait();
+
+	EXPECT_FALSE(writer.IsRunning());
+	EXPECT_EQ("first", ReadText(dir.File("session.jam")));
+}
+
+TEST(SessionWriter, FormatsProgress)
+{
+	SessionWriter::Progress progress;
+	progress.NumLoops = 4u;
+	progress.NumWritten = 3u;
+	progress.BytesWritten = 3u * 1024u * 1024u;
+	progress.ElapsedSecs = 2.0;
+	progress.IsCommitted = true;
+
+	EXPECT_EQ("3/4 loop(s), 3.0 MB in 2.0s (1.5 MB/s), committed", SessionWriter::FormatProgress(progress));
+}
@@ -23,6 +23,31 @@ TEST(UserConfig, ParsesAudioSettings) {
 	ASSERT_EQ(212, audio.value().LatencyOut);
 	ASSERT_EQ(6, audio.value().NumChannelsIn);
 	ASSERT_EQ(8, audio.value().NumChannelsOut);
+	ASSERT_EQ(0u, audio.value().RenderWorkers);
+}
+
+TEST(UserConfig, ParsesAudioRenderWorkers) {
+	auto str = "{\"name\":\"Soundblaster\",\"bufsize\":12,\"renderworkers\":3}";
+	auto testStream = std::stringstream(str);
+	auto json = std::get<Json::JsonPart>(Json::FromStream(std::move(testStream)).value());
+	auto audio = UserConfig::AudioSettings::FromJson(json);
+
+	ASSERT_TRUE(audio.has_value());
+	ASSERT_EQ(12, audio.value().BufSize);
+	ASSERT_EQ(3u, audio.value().RenderWorkers);
+}
+
+TEST(UserConfig, ParsesAudioShedSettings) {
+	auto str = "{\"shedloadpercent\":90,\"recoverloadpercent\":50,\"shedblocks\":8,\"shedpolicy\":\"vu,vst\"}";
+	auto testStream = std::stringstream(str);
+	auto json = std::get<Json::JsonPart>(Json::FromStream(std::move(testStream)).value());
+	auto audio = UserConfig::AudioSettings::FromJson(json);
+
+	ASSERT_TRUE(audio.has_value());
+	ASSERT_EQ(90u, audio.value().ShedLoadPercent);
+	ASSERT_EQ(50u, audio.value().RecoverLoadPercent);
+	ASSERT_EQ(8u, audio.value().ShedBlocks);
+	ASSERT_EQ("vu,vst", audio.value().ShedPolicy);
 }
 
 TEST(UserConfig, ParsesLoopSettings) {
@@ -37,6 +62,41 @@ TEST(UserConfig, ParsesLoopSettings) {
 	ASSERT_EQ(2800u, loop.value().SeedGrainTargetMaxMs);
 	ASSERT_EQ(90u, loop.value().SeedBpmMin);
 	ASSERT_FALSE(loop.value().SeedUsesPowers);
+	ASSERT_EQ(constants::DefaultBankSlabSamps, loop.value().BankSlabSamps);
+	ASSERT_EQ(constants::DefaultBankBudgetMb, loop.value().BankBudgetMb);
+}
+
+TEST(UserConfig, ParsesLoopBankSettings) {
+	auto str = "{\"fadeSamps\":13,\"bankSlabSamps\":65536,\"bankBudgetMb\":512}";
+	auto testStream = std::stringstream(str);
+	auto json = std::get<Json::JsonPart>(Json::FromStream(std::move(testStream)).value());
+	auto loop = UserConfig::LoopSettings::FromJson(json);
+
+	ASSERT_TRUE(loop.has_value());
+	ASSERT_EQ(65536u, loop.value().BankSlabSamps);
+	ASSERT_EQ(512u, loop.value().BankBudgetMb);
+}
+
+TEST(UserConfig, ParsesLoopStreamSettings) {
+	auto str = "{\"streamThresholdSamps\":2646000,\"streamWindowBanks\":12}";
+	auto testStream = std::stringstream(str);
+	auto json = std::get<Json::JsonPart>(Json::FromStream(std::move(testStream)).value());
+	auto loop = UserConfig::LoopSettings::FromJson(json);
+
+	ASSERT_TRUE(loop.has_value());
+	ASSERT_EQ(2646000ul, loop.value().StreamThresholdSamps);
+	ASSERT_EQ(12u, loop.value().StreamWindowBanks);
+}
+
+TEST(UserConfig, ParsesLoopCompactIdleSamps) {
+	auto str = "{\"compactIdleSamps\":441000}";
+	auto testStream = std::stringstream(str);
+	auto json = std::get<Json::JsonPart>(Json::FromStream(std::move(testStream)).value());
+	auto loop = UserConfig::LoopSettings::FromJson(json);
+
+	ASSERT_TRUE(loop.has_value());
+	ASSERT_EQ(441000ul, loop.value().CompactIdleSamps);
+	ASSERT_EQ(constants::DefaultStreamWindowBanks, loop.value().StreamWindowBanks);
 }
 
 TEST(UserConfig, ParsesTriggerSettings) {
@@ -0,0 +1,341 @@
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "io/WavFile.h"
+#include "../ScopedDir.h"
+
+using io::WavFileReader;
+using io::WavFileWriter;
+using io::WavFormat;
+using io::WavSampleFormat;
+
+namespace {
+
+std::vector<std::uint8_t> ReadBytes(const std::wstring& path)
+{
+	std::ifstream file{ std::filesystem::path(path), std::ios::binary };
+	return std::vector<std::uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+void WriteBytes(const std::wstring& path, const std::vector<std::uint8_t>& bytes)
+{
+	std::ofstream file{ std::filesystem::path(path), std::ios::binary };
+	file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+}
+
+std::uint32_t GetU32(const std::vector<std::uint8_t>& bytes, std::size_t offset)
+{
+	std::uint32_t value = 0u;
+	for (auto i = 0u; i < 4u; i++)
+		value |= static_cast<std::uint32_t>(bytes[offset + i]) << (8u * i);
+
+	return value;
+}
+
+void PutU16(std::vector<std::uint8_t>& bytes, std::uint16_t value)
+{
+	bytes.push_back(static_cast<std::uint8_t>(value & 0xff));
+	bytes.push_back(static_cast<std::uint8_t>(value >> 8));
+}
+
+void PutU32(std::vector<std::uint8_t>& bytes, std::uint32_t value)
+{
+	PutU16(bytes, static_cast<std::uint16_t>(value & 0xffff));
+	PutU16(bytes, static_cast<std::uint16_t>(value >> 16));
+}
+
+void PutId(std::vector<std::uint8_t>& bytes, const char* id)
+{
+	bytes.insert(bytes.end(), id, id + 4);
+}
+
+// Values every format holds exactly: multiples of 2^-15 inside full scale
+std::vector<float> ExactSamples(unsigned int numSamps)
+{
+	std::vector<float> samples(numSamps);
+	for (auto i = 0u; i < numSamps; i++)
+		samples[i] = static_cast<float>(static_cast<int>((i * 7919u) % 65535u) - 32767) / 32768.0f;
+
+	return samples;
+}
+
+std::vector<float> WriteAndReadBack(const ScopedDir& dir, WavFormat format, const std::vector<float>& samples)
+{
+	auto path = dir.File("roundtrip.wav");
+
+	WavFileWriter writer;
+	writer.SetDither(false);
+	EXPECT_TRUE(writer.Open(path, format));
+
+	// Uneven pieces, to cover the header being finished after the fact
+	auto numFrames = static_cast<unsigned long>(samples.size() / format.NumChannels);
+	auto firstFrames = numFrames / 3ul;
+	EXPECT_TRUE(writer.Write(samples.data(), firstFrames));
+	EXPECT_TRUE(writer.Write(samples.data() + (firstFrames * format.NumChannels), numFrames - firstFrames));
+	EXPECT_TRUE(writer.Close());
+
+	WavFileReader reader;
+	EXPECT_TRUE(reader.Open(path));
+	EXPECT_EQ(format.SampleFormat, reader.Format().SampleFormat);
+	EXPECT_EQ(format.NumChannels, reader.Format().NumChannels);
+	EXPECT_EQ(format.SampleRate, reader.Format().SampleRate);
+	EXPECT_EQ(numFrames, reader.NumFrames());
+
+	std::vector<float> readBack(samples.size());
+	EXPECT_EQ(numFrames, reader.Read(0u, readBack.data(), numFrames));
+
+	return readBack;
+}
+
+}
+
+TEST(WavFile, RoundTripsEveryFormat)
+{
+	ScopedDir dir("wavfile_formats");
+	const auto samples = ExactSamples(1001u);
+
+	for (auto sampleFormat : { WavSampleFormat::Int16, WavSampleFormat::Int24, WavSampleFormat::Int32, WavSampleFormat::Float32 })
+	{
+		WavFormat format;
+		format.SampleFormat = sampleFormat;
+		format.SampleRate = 48000u;
+
+		EXPECT_EQ(samples, WriteAndReadBack(dir, format, samples)) << "format " << static_cast<int>(sampleFormat);
+	}
+}
+
+TEST(WavFile, WritesExtensibleForMultichannel)
+{
+	ScopedDir dir("wavfile_extensible");
+	const auto samples = ExactSamples(6u * 500u);
+
+	WavFormat format;
+	format.SampleFormat = WavSampleFormat::Int24;
+	format.NumChannels = 6u;
+
+	EXPECT_EQ(samples, WriteAndReadBack(dir, format, samples));
+
+	auto bytes = ReadBytes(dir.File("roundtrip.wav"));
+	ASSERT_GE(bytes.size(), 60u);
+	EXPECT_EQ(40u, GetU32(bytes, 16));
+	EXPECT_EQ(0xfffeu, bytes[20] | (bytes[21] << 8));
+	EXPECT_EQ(0x3fu, GetU32(bytes, 40));
+	EXPECT_EQ(bytes.size() - 8u, GetU32(bytes, 4));
+}
+
+TEST(WavFile, PadsOddLengthData)
+{
+	ScopedDir dir("wavfile_pad");
+	auto path = dir.File("odd.wav");
+
+	WavFormat format;
+	format.SampleFormat = WavSampleFormat::Int24;
+
+	WavFileWriter writer;
+	ASSERT_TRUE(writer.Open(path, format));
+	ASSERT_TRUE(writer.Write(ExactSamples(3u).data(), 3u));
+	ASSERT_TRUE(writer.Close());
+
+	auto bytes = ReadBytes(path);
+	EXPECT_EQ(0u, bytes.size() % 2u);
+	EXPECT_EQ(9u, GetU32(bytes, 40));
+	EXPECT_EQ(bytes.size() - 8u, GetU32(bytes, 4));
+}
+
+TEST(WavFile, SkipsUnknownChunks)
+{
+	ScopedDir dir("wavfile_chunks");
+	auto path = dir.File("chunks.wav");
+
+	// A LIST chunk of odd length, with its pad byte, ahead of "fmt "
+	std::vector<std::uint8_t> bytes;
+	PutId(bytes, "RIFF");
+	PutU32(bytes, 0u);
+	PutId(bytes, "WAVE");
+	PutId(bytes, "LIST");
+	PutU32(bytes, 3u);
+	bytes.insert(bytes.end(), { 'a', 'b', 'c', 0 });
+	PutId(bytes, "fmt ");
+	PutU32(bytes, 16u);
+	PutU16(bytes, 1u);
+	PutU16(bytes, 1u);
+	PutU32(bytes, 22050u);
+	PutU32(bytes, 44100u);
+	PutU16(bytes, 2u);
+	PutU16(bytes, 16u);
+	PutId(bytes, "data");
+	PutU32(bytes, 6u);
+	PutU16(bytes, 0x4000u);
+	PutU16(bytes, 0xc000u);
+	PutU16(bytes, 0x0000u);
+	WriteBytes(path, bytes);
+
+	WavFileReader reader;
+	ASSERT_TRUE(reader.Open(path));
+	EXPECT_EQ(22050u, reader.Format().SampleRate);
+	ASSERT_EQ(3u, reader.NumFrames());
+
+	float samples[3];
+	ASSERT_EQ(3ul, reader.Read(0u, samples, 3ul));
+	EXPECT_EQ(0.5f, samples[0]);
+	EXPECT_EQ(-0.5f, samples[1]);
+	EXPECT_EQ(0.0f, samples[2]);
+}
+
+TEST(WavFile, ClipsUnfinishedDataSizeToFile)
+{
+	ScopedDir dir("wavfile_unfinished");
+	auto path = dir.File("unfinished.wav");
+
+	WavFormat format;
+	WavFileWriter writer;
+	writer.SetDither(false);
+	ASSERT_TRUE(writer.Open(path, format));
+	ASSERT_TRUE(writer.Write(ExactSamples(100u).data(), 100u));
+	ASSERT_TRUE(writer.Close());
+
+	// As left by a writer that died before filling in the sizes
+	auto bytes = ReadBytes(path);
+	for (auto unsetByte : { 0xff, 0x00 })
+	{
+		bytes[40] = bytes[41] = bytes[42] = bytes[43] = static_cast<std::uint8_t>(unsetByte);
+		WriteBytes(path, bytes);
+
+		WavFileReader reader;
+		ASSERT_TRUE(reader.Open(path));
+		EXPECT_EQ(100u, reader.NumFrames()) << "size byte " << unsetByte;
+	}
+}
+
+TEST(WavFile, KeepsEmptyDataChunkFollowedByAnother)
+{
+	ScopedDir dir("wavfile_empty");
+	auto path = dir.File("empty.wav");
+
+	// A finished file with no samples, and a LIST chunk after the data
+	std::vector<std::uint8_t> bytes;
+	PutId(bytes, "RIFF");
+	PutU32(bytes, 0u);
+	PutId(bytes, "WAVE");
+	PutId(bytes, "fmt ");
+	PutU32(bytes, 16u);
+	PutU16(bytes, 1u);
+	PutU16(bytes, 1u);
+	PutU32(bytes, 44100u);
+	PutU32(bytes, 88200u);
+	PutU16(bytes, 2u);
+	PutU16(bytes, 16u);
+	PutId(bytes, "data");
+	PutU32(bytes, 0u);
+	PutId(bytes, "LIST");
+	PutU32(bytes, 4u);
+	PutId(bytes, "INFO");
+	WriteBytes(path, bytes);
+
+	// Not read as unset data running on through the LIST chunk
+	WavFileReader reader;
+	ASSERT_TRUE(reader.Open(path));
+	EXPECT_EQ(0u, reader.NumFrames());
+}
+
+TEST(WavFile, RejectsUnsupportedFiles)
+{
+	ScopedDir dir("wavfile_reject");
+	auto path = dir.File("eight.wav");
+
+	std::vector<std::uint8_t> bytes;
+	PutId(bytes, "RIFF");
+	PutU32(bytes, 40u);
+	PutId(bytes, "WAVE");
+	PutId(bytes, "fmt ");
+	PutU32(bytes, 16u);
+	PutU16(bytes, 1u);
+	PutU16(bytes, 1u);
+	PutU32(bytes, 44100u);
+	PutU32(bytes, 44100u);
+	PutU16(bytes, 1u);
+	PutU16(bytes, 8u);
+	PutId(bytes, "data");
+	PutU32(bytes, 4u);
+	PutU32(bytes, 0u);
+	WriteBytes(path, bytes);
+
+	WavFileReader reader;
+	EXPECT_FALSE(reader.Open(path));
+	EXPECT_FALSE(reader.Open(dir.File("missing.wav")));
+}
+
+TEST(WavFile, DitheredWritesStayCloseToTheInput)
+{
+	ScopedDir dir("wavfile_dither");
+	auto path = dir.File("dither.wav");
+
+	// Well below one 16-bit step, so plain rounding gives silence
+	std::vector<float> samples(4096u, 0.25f / 32768.0f);
+
+	WavFileWriter writer;
+	ASSERT_TRUE(writer.Open(path, WavFormat()));
+	ASSERT_TRUE(writer.Write(samples.data(), static_cast<unsigned long>(samples.size())));
+	ASSERT_TRUE(writer.Close());
+
+	WavFileReader reader;
+	ASSERT_TRUE(reader.Open(path));
+
+	std::vector<float> readBack(samples.size());
+	ASSERT_EQ(samples.size(), reader.Read(0u, readBack.data(), static_cast<unsigned long>(readBack.size())));
+
+	auto numNonZero = 0u;
+	for (auto sample : readBack)
+	{
+		// One step of noise, plus half a step of rounding
+		EXPECT_LE(std::abs(sample - samples[0]), 1.5f / 32768.0f);
+		if (0.0f != sample)
+			numNonZero++;
+	}
+
+	EXPECT_GT(numNonZero, 0u);
+}
+
+TEST(WavFile, WritesAtAnyFrameAndFlushesAReadableFile)
+{
+	ScopedDir dir("wavfile_writeat");
+	auto path = dir.File("journal.wav");
+	const auto samples = ExactSamples(300u);
+
+	WavFormat format;
+	format.SampleFormat = WavSampleFormat::Float32;
+
+	WavFileWriter writer;
+	ASSERT_TRUE(writer.Open(path, format));
+
+	// Past the end, over the middle, then a plain append
+	ASSERT_TRUE(writer.WriteAt(100u, samples.data() + 100u, 100ul));
+	ASSERT_TRUE(writer.WriteAt(50u, samples.data() + 50u, 100ul));
+	ASSERT_TRUE(writer.Write(samples.data() + 200u, 100ul));
+	ASSERT_TRUE(writer.Flush());
+	EXPECT_EQ(300u, writer.NumFrames());
+
+	// Readable while the writer still has it open
+	{
+		WavFileReader reader;
+		ASSERT_TRUE(reader.Open(path));
+		ASSERT_EQ(300u, reader.NumFrames());
+
+		std::vector<float> readBack(300u);
+		ASSERT_EQ(300ul, reader.Read(0u, readBack.data(), 300ul));
+
+		for (auto i = 0u; i < 50u; i++)
+			ASSERT_EQ(0.0f, readBack[i]) << "sample " << i;
+
+		for (auto i = 50u; i < 300u; i++)
+			ASSERT_EQ(samples[i], readBack[i]) << "sample " << i;
+	}
+
+	ASSERT_TRUE(writer.Close());
+}
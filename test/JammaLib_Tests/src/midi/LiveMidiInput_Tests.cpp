@@ -0,0 +1,129 @@
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "midi/LiveMidiInput.h"
+
+using midi::LiveMidiInput;
+using midi::MidiEvent;
+
+namespace {
+
+std::vector<MidiEvent> ReadBlock(LiveMidiInput& input, std::uint32_t blockStartSample, unsigned int numSamps)
+{
+	std::vector<MidiEvent> events;
+	input.ReadBlock(blockStartSample, numSamps, [&events](const MidiEvent& event) {
+		events.push_back(event);
+	});
+
+	return events;
+}
+
+}
+
+TEST(LiveMidiInput, PlacesEventsInsideBlock)
+{
+	EXPECT_EQ(1000u, LiveMidiInput::PlaceInBlock(1000u, 1000u, 128u));
+	EXPECT_EQ(1064u, LiveMidiInput::PlaceInBlock(1064u, 1000u, 128u));
+	EXPECT_EQ(1127u, LiveMidiInput::PlaceInBlock(1127u, 1000u, 128u));
+}
+
+TEST(LiveMidiInput, ClampsEventsOutsideBlock)
+{
+	EXPECT_EQ(1000u, LiveMidiInput::PlaceInBlock(900u, 1000u, 128u));
+	EXPECT_EQ(1127u, LiveMidiInput::PlaceInBlock(1128u, 1000u, 128u));
+	EXPECT_EQ(1127u, LiveMidiInput::PlaceInBlock(5000u, 1000u, 128u));
+}
+
+TEST(LiveMidiInput, PlacesEventsAcrossCounterWrap)
+{
+	const std::uint32_t blockStart = 0xffffffc0u;
+	EXPECT_EQ(0x10u, LiveMidiInput::PlaceInBlock(0x10u, blockStart, 128u));
+	EXPECT_EQ(blockStart, LiveMidiInput::PlaceInBlock(blockStart - 1u, blockStart, 128u));
+}
+
+TEST(LiveMidiInput, DeviceEventsKeepTheirOffsetInOrder)
+{
+	LiveMidiInput input;
+	auto keys = input.ClaimSlot("Keys");
+	auto pads = input.ClaimSlot("Pads");
+	ASSERT_NE(LiveMidiInput::NoSlot, keys);
+	ASSERT_NE(LiveMidiInput::NoSlot, pads);
+
+	input.PushFromDevice(keys, MidiEvent::MakeNoteOn(560u, 0u, 60u, 100u));
+	input.PushFromDevice(pads, MidiEvent::MakeNoteOn(520u, 9u, 36u, 90u));
+	input.PushFromDevice(keys, MidiEvent::MakeNoteOff(600u, 0u, 60u));
+	input.PushFromDevice(pads, MidiEvent::MakeNoteOn(400u, 9u, 38u, 90u));
+
+	auto events = ReadBlock(input, 512u, 128u);
+
+	ASSERT_EQ(4u, events.size());
+	EXPECT_EQ(512u, events[0].sampleOffset);
+	EXPECT_EQ(38u, events[0].data1);
+	EXPECT_EQ(520u, events[1].sampleOffset);
+	EXPECT_EQ(560u, events[2].sampleOffset);
+	EXPECT_EQ(600u, events[3].sampleOffset);
+	EXPECT_TRUE(events[3].IsNoteOff());
+
+	EXPECT_TRUE(ReadBlock(input, 640u, 128u).empty());
+}
+
+TEST(LiveMidiInput, SharedEventsComeFirstUnplaced)
+{
+	LiveMidiInput input;
+	auto keys = input.ClaimSlot("Keys");
+
+	input.PushFromDevice(keys, MidiEvent::MakeNoteOn(16u, 0u, 60u, 100u));
+	input.Push(MidiEvent::MakeNoteOff(5000u, 0u, 48u), "");
+
+	auto events = ReadBlock(input, 0u, 64u);
+
+	ASSERT_EQ(2u, events.size());
+	EXPECT_EQ(48u, events[0].data1);
+	EXPECT_EQ(5000u, events[0].sampleOffset);
+	EXPECT_EQ(60u, events[1].data1);
+	EXPECT_EQ(16u, events[1].sampleOffset);
+}
+
+TEST(LiveMidiInput, ClaimSlotReusesNamesUntilFull)
+{
+	LiveMidiInput input;
+
+	EXPECT_EQ(LiveMidiInput::NoSlot, input.ClaimSlot(""));
+
+	auto keys = input.ClaimSlot("Keys");
+	EXPECT_EQ(keys, input.ClaimSlot("Keys"));
+
+	for (auto i = 1u; i < LiveMidiInput::MaxDevices; i++)
+		EXPECT_NE(LiveMidiInput::NoSlot, input.ClaimSlot("Device" + std::to_string(i)));
+
+	EXPECT_EQ(LiveMidiInput::NoSlot, input.ClaimSlot("OneTooMany"));
+	EXPECT_EQ(keys, input.ClaimSlot("Keys"));
+}
+
+TEST(LiveMidiInput, TracksHeldNotesPerDevice)
+{
+	LiveMidiInput input;
+	auto keys = input.ClaimSlot("Keys");
+
+	input.PushFromDevice(keys, MidiEvent::MakeNoteOn(0u, 0u, 60u, 100u));
+	input.PushFromDevice(keys, MidiEvent::MakeNoteOn(0u, 0u, 64u, 110u));
+	input.PushFromDevice(keys, MidiEvent::MakeNoteOff(0u, 0u, 60u));
+	input.Push(MidiEvent::MakeNoteOn(0u, 1u, 40u, 90u), "");
+
+	auto held = input.HeldNotes();
+
+	ASSERT_EQ(2u, held.size());
+	EXPECT_EQ("", held[0].first);
+	EXPECT_EQ(2u, held[0].second.Held.count());
+	EXPECT_EQ(90u, held[0].second.Velocity[midi::MidiNote::NoteSlot(1u, 40u)]);
+
+	EXPECT_EQ("Keys", held[1].first);
+	EXPECT_EQ(1u, held[1].second.Held.count());
+	EXPECT_TRUE(held[1].second.Held.test(midi::MidiNote::NoteSlot(0u, 64u)));
+	EXPECT_EQ(110u, held[1].second.Velocity[midi::MidiNote::NoteSlot(0u, 64u)]);
+
+	input.ResetHeldNotes();
+
+	for (const auto& [name, snapshot] : input.HeldNotes())
+		EXPECT_TRUE(snapshot.Held.none()) << name;
+}
@@ -0,0 +1,69 @@
+#include "gtest/gtest.h"
+#include "midi/MidiLatencyMonitor.h"
+
+using midi::MidiLatencyMonitor;
+
+namespace {
+
+// Leaves the shared monitor off and empty for other tests
+class ScopedMonitor
+{
+public:
+	ScopedMonitor()
+	{
+		MidiLatencyMonitor::Instance().Reset();
+	}
+
+	~ScopedMonitor()
+	{
+		MidiLatencyMonitor::Instance().SetEnabled(false);
+		MidiLatencyMonitor::Instance().Reset();
+	}
+
+	MidiLatencyMonitor& operator*() { return MidiLatencyMonitor::Instance(); }
+	MidiLatencyMonitor* operator->() { return &MidiLatencyMonitor::Instance(); }
+};
+
+}
+
+TEST(MidiLatencyMonitor, OffByDefault)
+{
+	ScopedMonitor monitor;
+	ASSERT_FALSE(monitor->IsEnabled());
+	ASSERT_EQ(0u, monitor->Report().Count);
+}
+
+TEST(MidiLatencyMonitor, ReportsPercentiles)
+{
+	ScopedMonitor monitor;
+
+	// 90 events at 100us, 9 at 2ms and one at 20ms
+	for (auto i = 0u; i < 90u; i++)
+		monitor->Record(100000u);
+	for (auto i = 0u; i < 9u; i++)
+		monitor->Record(2000000u);
+	monitor->Record(20000000u);
+
+	auto stats = monitor->Report();
+	ASSERT_EQ(100u, stats.Count);
+
+	// Within a bucket (12.5%) of the recorded values
+	EXPECT_GE(stats.P50Us, 100.0);
+	EXPECT_LE(stats.P50Us, 112.5);
+	EXPECT_GE(stats.P99Us, 2000.0);
+	EXPECT_LE(stats.P99Us, 2250.0);
+	EXPECT_DOUBLE_EQ(20000.0, stats.MaxUs);
+	EXPECT_DOUBLE_EQ((90.0 * 100.0 + 9.0 * 2000.0 + 20000.0) / 100.0, stats.MeanUs);
+}
+
+TEST(MidiLatencyMonitor, ResetClears)
+{
+	ScopedMonitor monitor;
+	monitor->Record(5000u);
+	monitor->Reset();
+
+	auto stats = monitor->Report();
+	ASSERT_EQ(0u, stats.Count);
+	ASSERT_EQ(0.0, stats.MaxUs);
+	ASSERT_NE(std::string::npos, MidiLatencyMonitor::FormatStats(stats).find("n=0"));
+}
@@ -113,6 +113,24 @@ TEST(MidiQueue, ClearResetsState) {
 	ASSERT_EQ(0u, q.DroppedCount());
 }
 
+TEST(MidiQueue, CarriesWrappedEvents) {
+	struct TimedEvent
+	{
+		MidiEvent Event;
+		std::int64_t Time;
+	};
+
+	MidiQueue<kCap, TimedEvent> q;
+	ASSERT_TRUE(q.Push({ NoteOn(12u, 64), 5000 }));
+
+	TimedEvent out{};
+	ASSERT_TRUE(q.Pop(out));
+	ASSERT_EQ(12u, out.Event.sampleOffset);
+	ASSERT_EQ(64u, out.Event.data1);
+	ASSERT_EQ(5000, out.Time);
+	ASSERT_TRUE(q.Empty());
+}
+
 TEST(MidiEvent, NoteOnAndNoteOffClassification) {
 	const auto on = MidiEvent::MakeNoteOn(0u, 3, 60, 100);
 	ASSERT_TRUE(on.IsNoteOn());
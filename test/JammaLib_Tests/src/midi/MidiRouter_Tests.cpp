@@ -0,0 +1,145 @@
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <vector>
+#include "actions/TriggerAction.h"
+#include "audio/AudioDevice.h"
+#include "base/ActionReceiver.h"
+#include "engine/Station.h"
+#include "engine/Trigger.h"
+#include "io/RigFile.h"
+#include "io/SerialTriggerProtocol.h"
+#include "io/UserConfig.h"
+#include "midi/MidiRouter.h"
+
+using actions::TriggerAction;
+using engine::Station;
+using engine::StationParams;
+using engine::Trigger;
+using midi::MidiRouter;
+
+namespace
+{
+	constexpr unsigned int SampleRate = 48000u;
+
+	class RecordingReceiver : public base::ActionReceiver
+	{
+	public:
+		actions::ActionResult OnAction(TriggerAction action) override
+		{
+			Actions.push_back(action);
+
+			return {
+				true,
+				"source-loop-take",
+				"target-loop-take",
+				actions::ACTIONRESULT_DEFAULT,
+				nullptr,
+				std::weak_ptr<base::GuiElement>()
+			};
+		}
+
+		const TriggerAction* Find(TriggerAction::TriggerActionType type) const
+		{
+			for (const auto& action : Actions)
+			{
+				if (type == action.ActionType)
+					return &action;
+			}
+
+			return nullptr;
+		}
+
+		std::vector<TriggerAction> Actions;
+	};
+
+	// A station with one trigger, activated by serial button 0 on "pedal",
+	// whose actions go to receiver
+	std::shared_ptr<Station> MakeSerialStation(const std::shared_ptr<RecordingReceiver>& receiver,
+		std::shared_ptr<Trigger>& trigger)
+	{
+		StationParams params;
+		params.Name = "serial";
+		params.Size = { 200, 200 };
+		audio::MergeMixBehaviourParams merge;
+		auto station = std::make_shared<Station>(params, Station::GetMixerParams(params.Size, merge));
+
+		auto rigTrigger = io::RigFile::Trigger();
+		rigTrigger.Name = "serial";
+		rigTrigger.TriggerPairs.push_back({ 0u, 0u, 1u, 1u, io::RigFile::TriggerPair::SOURCE_SERIAL, "pedal" });
+
+		trigger = Trigger::FromFile(engine::TriggerParams(), rigTrigger).value();
+		station->AddTrigger(trigger);
+		trigger->SetReceiver(receiver);
+
+		return station;
+	}
+
+	io::SerialTriggerEvent PedalEvent(const std::string& device, bool isPressed, std::int64_t arrivalMicros)
+	{
+		io::SerialTriggerEvent event;
+		event.Device = &device;
+		event.ButtonIndex = 0u;
+		event.IsPressed = isPressed;
+		event.ArrivalMicros = arrivalMicros;
+
+		return event;
+	}
+
+	// Presses the pedal at each arrival time in turn, pumping after each,
+	// and returns the REC_END the second press sends
+	TriggerAction RecordBetween(std::uint64_t anchorSample,
+		std::int64_t startMicros,
+		std::int64_t endMicros,
+		std::uint64_t clockSample)
+	{
+		static const std::string Device = "pedal";
+		const std::int64_t anchorMicros = 1000000;
+
+		auto receiver = std::make_shared<RecordingReceiver>();
+		std::shared_ptr<Trigger> trigger;
+		std::vector<std::shared_ptr<Station>> stations = { MakeSerialStation(receiver, trigger) };
+		io::UserConfig userConfig;
+		audio::AudioStreamParams audioParams;
+
+		// The next block starts at clockSample
+		trigger->OnTick(clockSample - 128u, 128u, std::nullopt, std::nullopt);
+
+		MidiRouter router;
+		for (auto arrivalMicros : { startMicros, endMicros })
+		{
+			router.PushSerialEvent(PedalEvent(Device, true, arrivalMicros), SampleRate, anchorSample, anchorMicros);
+			router.PushSerialEvent(PedalEvent(Device, false, arrivalMicros + 1000), SampleRate, anchorSample, anchorMicros);
+			router.PumpSerial(stations, clockSample, userConfig, audioParams);
+		}
+
+		EXPECT_NE(nullptr, receiver->Find(TriggerAction::TRIGGER_REC_START));
+		auto recEnd = receiver->Find(TriggerAction::TRIGGER_REC_END);
+		EXPECT_NE(nullptr, recEnd);
+
+		return recEnd ? *recEnd : TriggerAction();
+	}
+}
+
+TEST(MidiRouter, SerialPressAppliesAtItsArrivalSample)
+{
+	// 10 ms and 510 ms after the anchor at sample 100000
+	auto recEnd = RecordBetween(100000u, 1010000, 1510000, 124000u);
+
+	// Both presses land where they arrived, not where they were pumped
+	EXPECT_EQ(24000ul, recEnd.SampleCount);
+	EXPECT_EQ(480u, recEnd.BlockOffset);
+}
+
+TEST(MidiRouter, SerialSampleTimeWidensAcrossCounterWrap)
+{
+	// The queued sample time only keeps the low 32 bits, and the second
+	// press maps past the point where they wrap
+	const auto anchorSample = (std::uint64_t{ 1u } << 32) - 2000u;
+	auto recEnd = RecordBetween(anchorSample, 1010000, 1510000, anchorSample + 24000u);
+
+	EXPECT_EQ(24000ul, recEnd.SampleCount);
+	EXPECT_EQ(480u, recEnd.BlockOffset);
+}
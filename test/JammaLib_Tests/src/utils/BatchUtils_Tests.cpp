@@ -0,0 +1,54 @@
+#include "gtest/gtest.h"
+#include "utils/BatchUtils.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+TEST(BatchUtils, RunsEveryTaskOnce)
+{
+	std::vector<std::atomic<unsigned int>> runs(20u);
+
+	auto numThreads = utils::RunBatch(runs.size(), 4u, [&runs](std::size_t index) { runs[index]++; });
+
+	for (auto i = 0u; i < runs.size(); i++)
+		EXPECT_EQ(1u, runs[i].load()) << "task " << i;
+
+	EXPECT_EQ(4u, numThreads);
+}
+
+TEST(BatchUtils, SpreadsTasksOverWorkers)
+{
+	std::mutex threadsMutex;
+	std::set<std::thread::id> threads;
+
+	utils::RunBatch(8u, 4u, [&](std::size_t) {
+		{
+			std::scoped_lock lock(threadsMutex);
+			threads.insert(std::this_thread::get_id());
+		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	});
+
+	EXPECT_GT(threads.size(), 1u);
+	EXPECT_LE(threads.size(), 4u);
+}
+
+TEST(BatchUtils, UsesNoMoreThreadsThanTasks)
+{
+	EXPECT_EQ(3u, utils::RunBatch(3u, 8u, [](std::size_t) {}));
+
+	// An empty batch still counts the calling thread
+	auto numRuns = 0u;
+	EXPECT_EQ(1u, utils::RunBatch(0u, 4u, [&numRuns](std::size_t) { numRuns++; }));
+	EXPECT_EQ(0u, numRuns);
+}
+
+TEST(BatchUtils, FormatsThroughput)
+{
+	EXPECT_EQ("6.0 MB in 2.0s (3.0 MB/s)", utils::FormatThroughput(6u * 1024u * 1024u, 2.0));
+	EXPECT_EQ("1.0 MB in 0.0s (0.0 MB/s)", utils::FormatThroughput(1024u * 1024u, 0.0));
+}
@@ -0,0 +1,269 @@
+#include "gtest/gtest.h"
+#include "utils/Epoch.h"
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using utils::EpochDomain;
+using utils::EpochPtr;
+using utils::EpochReadGuard;
+
+namespace {
+
+constexpr std::uint64_t LiveMagic = 0x5EED5EED5EED5EEDull;
+constexpr std::uint64_t DeadMagic = 0xDEADDEADDEADDEADull;
+
+std::atomic<int> numLiveSnapshots{ 0 };
+
+// Snapshot whose contents are self-checking, so a reader can tell if it
+// was handed something already freed or only half built.
+struct Snapshot
+{
+	Snapshot(unsigned int seed, unsigned int numValues) :
+		Magic(LiveMagic),
+		Values(numValues),
+		Sum(0u)
+	{
+		for (auto i = 0u; i < numValues; i++)
+		{
+			Values[i] = seed + i;
+			Sum += Values[i];
+		}
+
+		numLiveSnapshots.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	~Snapshot()
+	{
+		Magic = DeadMagic;
+		numLiveSnapshots.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	bool IsValid() const
+	{
+		if (LiveMagic != Magic)
+			return false;
+
+		auto sum = 0u;
+		for (auto value : Values)
+			sum += value;
+
+		return sum == Sum;
+	}
+
+	volatile std::uint64_t Magic;
+	std::vector<unsigned int> Values;
+	unsigned int Sum;
+};
+
+void DrainRetired()
+{
+	EpochDomain::Instance().Reclaim();
+}
+
+}
+
+TEST(Epoch, PublishedValueIsVisibleToReaders)
+{
+	EpochPtr<const Snapshot> ptr;
+	ASSERT_EQ(nullptr, ptr.Load());
+
+	ptr.Publish(std::make_shared<const Snapshot>(3u, 4u));
+
+	EpochReadGuard guard;
+	auto snapshot = ptr.Load();
+
+	ASSERT_NE(nullptr, snapshot);
+	ASSERT_TRUE(snapshot->IsValid());
+	ASSERT_EQ(3u, snapshot->Values[0]);
+	ASSERT_EQ(snapshot, ptr.LoadShared().get());
+}
+
+TEST(Epoch, RetiredValueOutlivesOpenGuard)
+{
+	DrainRetired();
+
+	EpochPtr<const Snapshot> ptr;
+	ptr.Publish(std::make_shared<const Snapshot>(1u, 4u));
+	std::weak_ptr<const Snapshot> first = ptr.LoadShared();
+
+	{
+		EpochReadGuard guard;
+		auto snapshot = ptr.Load();
+
+		ptr.Publish(std::make_shared<const Snapshot>(2u, 4u));
+		EpochDomain::Instance().Reclaim();
+
+		ASSERT_FALSE(first.expired());
+		ASSERT_TRUE(snapshot->IsValid());
+	}
+
+	EpochDomain::Instance().Reclaim();
+	ASSERT_TRUE(first.expired());
+}
+
+TEST(Epoch, NestedGuardsKeepOuterEpoch)
+{
+	DrainRetired();
+
+	EpochPtr<const Snapshot> ptr;
+	ptr.Publish(std::make_shared<const Snapshot>(1u, 4u));
+	std::weak_ptr<const Snapshot> first = ptr.LoadShared();
+
+	{
+		EpochReadGuard outer;
+		auto snapshot = ptr.Load();
+
+		{
+			EpochReadGuard inner;
+		}
+
+		ptr.Publish(std::make_shared<const Snapshot>(2u, 4u));
+		EpochDomain::Instance().Reclaim();
+
+		ASSERT_FALSE(first.expired());
+		ASSERT_TRUE(snapshot->IsValid());
+	}
+
+	EpochDomain::Instance().Reclaim();
+	ASSERT_TRUE(first.expired());
+}
+
+TEST(Epoch, ReaderOnAnotherThreadBlocksReclaim)
+{
+	DrainRetired();
+
+	EpochPtr<const Snapshot> ptr;
+	ptr.Publish(std::make_shared<const Snapshot>(1u, 4u));
+	std::weak_ptr<const Snapshot> first = ptr.LoadShared();
+
+	std::atomic<bool> isReading(false);
+	std::atomic<bool> isDone(false);
+	std::atomic<bool> isValid(false);
+
+	std::thread reader([&]() {
+		EpochReadGuard guard;
+		auto snapshot = ptr.Load();
+		isReading.store(true);
+
+		while (!isDone.load())
+			std::this_thread::yield();
+
+		isValid.store(snapshot->IsValid());
+	});
+
+	while (!isReading.load())
+		std::this_thread::yield();
+
+	ptr.Publish(std::make_shared<const Snapshot>(2u, 4u));
+	EpochDomain::Instance().Reclaim();
+	ASSERT_FALSE(first.expired());
+
+	isDone.store(true);
+	reader.join();
+
+	EpochDomain::Instance().Reclaim();
+	ASSERT_TRUE(isValid.load());
+	ASSERT_TRUE(first.expired());
+}
+
+TEST(Epoch, SwapKeepsBothValuesAlive)
+{
+	EpochPtr<const Snapshot> ptrA;
+	EpochPtr<const Snapshot> ptrB;
+	ptrA.Publish(std::make_shared<const Snapshot>(1u, 4u));
+	ptrB.Publish(std::make_shared<const Snapshot>(2u, 4u));
+
+	ptrA.Swap(ptrB);
+	EpochDomain::Instance().Reclaim();
+
+	ASSERT_EQ(2u, ptrA.Load()->Values[0]);
+	ASSERT_EQ(1u, ptrB.Load()->Values[0]);
+
+	EpochPtr<const Snapshot> ptrC(std::move(ptrA));
+	ASSERT_EQ(nullptr, ptrA.Load());
+	ASSERT_EQ(2u, ptrC.Load()->Values[0]);
+}
+
+// Several publishers churn snapshots on shared and private EpochPtrs while
+// a simulated callback reads them block after block.
+TEST(Epoch, StressConcurrentPublishersAgainstCallback)
+{
+	const unsigned int numPublishers = 3u;
+	const unsigned int numPublishes = 3000u;
+	const unsigned int numValues = 64u;
+
+	DrainRetired();
+	auto liveBefore = numLiveSnapshots.load();
+
+	{
+		EpochPtr<const Snapshot> shared;
+		std::vector<std::unique_ptr<EpochPtr<const Snapshot>>> owned;
+		for (auto i = 0u; i < numPublishers; i++)
+			owned.push_back(std::make_unique<EpochPtr<const Snapshot>>());
+
+		shared.Publish(std::make_shared<const Snapshot>(0u, numValues));
+		for (auto& ptr : owned)
+			ptr->Publish(std::make_shared<const Snapshot>(0u, numValues));
+
+		std::atomic<bool> isQuitting(false);
+		std::atomic<unsigned int> numBlocks(0u);
+		std::atomic<unsigned int> numInvalid(0u);
+
+		std::thread callback([&]() {
+			while (!isQuitting.load(std::memory_order_acquire))
+			{
+				EpochReadGuard guard;
+
+				auto snapshot = shared.Load();
+				if (!snapshot->IsValid())
+					numInvalid.fetch_add(1u);
+
+				for (auto& ptr : owned)
+				{
+					auto ownedSnapshot = ptr->Load();
+					if (!ownedSnapshot->IsValid())
+						numInvalid.fetch_add(1u);
+				}
+
+				// Hold on past a few publishes before checking again
+				std::this_thread::yield();
+				if (!snapshot->IsValid())
+					numInvalid.fetch_add(1u);
+
+				numBlocks.fetch_add(1u, std::memory_order_relaxed);
+			}
+		});
+
+		std::vector<std::thread> publishers;
+		for (auto p = 0u; p < numPublishers; p++)
+		{
+			publishers.emplace_back([&, p]() {
+				for (auto i = 1u; i <= numPublishes; i++)
+				{
+					auto seed = (p * numPublishes) + i;
+					if (0u == (i % 2u))
+						shared.Publish(std::make_shared<const Snapshot>(seed, numValues));
+					else
+						owned[p]->Publish(std::make_shared<const Snapshot>(seed, numValues));
+				}
+			});
+		}
+
+		for (auto& publisher : publishers)
+			publisher.join();
+
+		isQuitting.store(true, std::memory_order_release);
+		callback.join();
+
+		ASSERT_GT(numBlocks.load(), 0u);
+		ASSERT_EQ(0u, numInvalid.load());
+
+		EpochDomain::Instance().Reclaim();
+		ASSERT_EQ(0u, EpochDomain::Instance().NumRetired());
+		ASSERT_EQ(liveBefore + static_cast<int>(numPublishers) + 1, numLiveSnapshots.load());
+	}
+
+	ASSERT_EQ(liveBefore, numLiveSnapshots.load());
+}
@@ -0,0 +1,71 @@
+#include "gtest/gtest.h"
+#include "utils/WakeSignal.h"
+#include <chrono>
+#include <thread>
+
+using utils::WakeSignal;
+
+TEST(WakeSignal, TimesOutWithoutNotify)
+{
+	WakeSignal signal;
+	ASSERT_FALSE(signal.Wait(std::chrono::milliseconds(1)));
+}
+
+TEST(WakeSignal, PendingNotifyReturnsAtOnce)
+{
+	WakeSignal signal;
+	signal.Notify();
+	signal.Notify();
+
+	auto start = std::chrono::steady_clock::now();
+	ASSERT_TRUE(signal.Wait(std::chrono::seconds(10)));
+	ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+
+	// Both notifies were taken by the one wait
+	ASSERT_FALSE(signal.Wait(std::chrono::milliseconds(1)));
+}
+
+TEST(WakeSignal, NotifyWakesSleepingWaiter)
+{
+	WakeSignal signal;
+
+	auto start = std::chrono::steady_clock::now();
+	std::thread notifier([&]() {
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		signal.Notify();
+	});
+
+	ASSERT_TRUE(signal.Wait(std::chrono::seconds(10)));
+	auto elapsed = std::chrono::steady_clock::now() - start;
+	notifier.join();
+
+	ASSERT_LT(elapsed, std::chrono::seconds(5));
+}
+
+TEST(WakeSignal, NoWakeIsLost)
+{
+	constexpr auto NumRounds = 2000u;
+
+	WakeSignal ping;
+	WakeSignal pong;
+	auto numWoken = 0u;
+
+	std::thread waiter([&]() {
+		for (auto i = 0u; i < NumRounds; i++)
+		{
+			if (ping.Wait(std::chrono::seconds(5)))
+				numWoken++;
+
+			pong.Notify();
+		}
+	});
+
+	for (auto i = 0u; i < NumRounds; i++)
+	{
+		ping.Notify();
+		pong.Wait(std::chrono::seconds(5));
+	}
+
+	waiter.join();
+	ASSERT_EQ(NumRounds, numWoken);
+}